@@ -256,8 +256,6 @@ public:
     bool begin_cpu_frame(std::uint32_t clear_rgba) noexcept;
     void draw_world(const matrix& cam, const Light& L, const vec4& light_dir) noexcept;
     void pin_draw_query_once() noexcept;
-private:
-    bool m_offline = false;
 
     struct offline_targets_t
     {
@@ -267,8 +265,29 @@ private:
         std::uint32_t z_pitch = 0;
         std::vector<std::uint32_t> color;
         std::vector<float> z;
-    } m_offline_targets;
+    };
 
+    // One frame of an offline batch: the world as it was when captured, drawn into its own targets
+    struct offline_frame
+    {
+        matrix vp{};
+        vec4   light_dir{};
+        std::vector<MeshRefPN> meshes;
+        std::vector<Transform> transforms;
+        std::vector<Material>  materials;
+        offline_targets_t targets;
+    };
+
+    // Frames rendered side by side by render_offline_frames, one per thread
+    [[nodiscard]] static constexpr std::size_t offline_batch_size() noexcept { return kTotalSlices; }
+
+    void capture_offline_frame(offline_frame& f, const matrix& cam, const vec4& light_dir) noexcept;
+    void render_offline_frames(offline_frame* frames, std::size_t count, std::uint32_t clear_rgba) noexcept;
+private:
+    bool m_offline = false;
+    offline_targets_t m_offline_targets;
+
+    static void ensure_targets(offline_targets_t& t, std::uint32_t w, std::uint32_t h) noexcept;
     void ensure_offline_targets(std::uint32_t w, std::uint32_t h) noexcept;
 public:
     struct draw_pinned_block
@@ -297,7 +316,7 @@ protected:
 
 private:
     void bind_targets_from_frame(const fox::cpu_frame& f) noexcept;
-    void clear_color_rgba(std::uint32_t rgba) const noexcept;
+    static void clear_color_rgba(const FramebufferRGBA8& fb, std::uint32_t rgba) noexcept;
     void refresh_render_cache() noexcept;
 
 private:
@@ -312,6 +331,7 @@ private:
         float  fh = 0.f;
         std::uint32_t W = 0;
         std::uint32_t H = 0;
+        std::uint32_t clear_rgba = 0;
     };
 
     struct worker_range
@@ -334,6 +354,10 @@ private:
     draw_job_shared m_job{};
     worker_range    m_ranges[kTotalSlices]{};
 
+    // Set while a batch of whole offline frames is handed out instead of row slices
+    offline_frame* m_batch = nullptr;
+    std::size_t    m_batch_count = 0;
+
     fecs::render_cache<MeshRefPN, Transform, Material> render_cache_{};
     std::uint64_t render_cache_version_{ std::numeric_limits<std::uint64_t>::max() };
 
@@ -346,6 +370,9 @@ private:
     void worker_loop(int worker_index) noexcept;
 
     void draw_world_slice(int y0, int y1) const noexcept;
+    void draw_blocks(const draw_job_shared& job, const FramebufferRGBA8& fb, const ZBufferF32& zb,
+                     const draw_pinned_block* blocks, std::size_t block_count, int y0, int y1) const noexcept;
+    void render_batch_share(int worker_index) const noexcept;
 };
 
 class optimized_renderer_rt : public optimized_renderer_core
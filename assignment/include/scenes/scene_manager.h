@@ -153,8 +153,6 @@ static inline void run_offload_scene(
 
     optimized_renderer_rt r(1024, 768, window_name);
 
-    const Light L = make_default_light();
-
     vec4 light_dir(0.f, 1.f, 1.f, 0.f);
     light_dir.normalise();
 
@@ -169,12 +167,23 @@ static inline void run_offload_scene(
     std::vector<std::vector<std::uint32_t>> recorded{};
     recorded.reserve((keep_frames_exact > 0) ? keep_frames_exact : 4096);
 
+    // The scene steps frame by frame; kept frames are captured and rasterized a batch at a time
+    std::vector<optimized_renderer_core::offline_frame> batch(optimized_renderer_core::offline_batch_size());
+    std::size_t batch_fill = 0;
+
+    const auto flush_batch = [&]()
+    {
+        r.render_offline_frames(batch.data(), batch_fill, 0xFF000000u);
+        for (std::size_t i = 0; i < batch_fill; ++i)
+            recorded.emplace_back(std::move(batch[i].targets.color));
+        batch_fill = 0;
+    };
+
     using clock = std::chrono::steady_clock;
     const auto record_t0 = clock::now();
 
     std::uint64_t sim_frames = 0;
     std::uint64_t kept_frames = 0;
-    std::uint32_t record_failed_begins = 0;
     bool recorded_done = false;
 
     while (!recorded_done)
@@ -184,12 +193,6 @@ static inline void run_offload_scene(
         if (r.windows.key_down(VK_ESCAPE))
             break;
 
-        if (!r.begin_cpu_frame(0xFF000000u))
-        {
-            ++record_failed_begins;
-            continue;
-        }
-
         const bool cycle_done = scene.tick_cycle_completed(&r.windows);
         const matrix camera = scene.camera_matrix();
 
@@ -198,20 +201,11 @@ static inline void run_offload_scene(
             light_dir = scene.current_light_dir();
         }
 
-        r.draw_world(camera, L, light_dir);
-
         ++sim_frames;
 
         if ((sim_frames % record_step) == 0)
         {
-            const std::size_t pitch_pixels = (std::size_t)r.framebuffer.pitch_pixels;
-            const std::size_t h            = (std::size_t)r.framebuffer.h;
-            const std::size_t pixels       = pitch_pixels * h;
-
-            recorded.emplace_back(pixels);
-            std::memcpy(recorded.back().data(),
-                        r.framebuffer.data,
-                        pixels * sizeof(std::uint32_t));
+            r.capture_offline_frame(batch[batch_fill++], camera, light_dir);
 
             ++kept_frames;
 
@@ -221,15 +215,21 @@ static inline void run_offload_scene(
 
         if (keep_frames_exact == 0 && cycle_done && sim_frames > 0)
             recorded_done = true;
+
+        if (batch_fill == batch.size())
+            flush_batch();
     }
 
+    if (batch_fill > 0)
+        flush_batch();
+
     const auto record_t1 = clock::now();
     const double record_ms  = std::chrono::duration<double, std::milli>(record_t1 - record_t0).count();
     const double sim_fps    = (record_ms > 0.0) ? (double)sim_frames * (1000.0 / record_ms) : 0.0;
     const double kept_fps   = (record_ms > 0.0) ? (double)kept_frames * (1000.0 / record_ms) : 0.0;
 
     std::printf(
-        "%s OFFLOAD_RECORD_OFFLINE_MS: %.3f | SIM_FRAMES: %llu | KEPT: %zu | STEP: %zu | SIM_FPS: %.2f | KEPT_FPS: %.2f | FAILED_BEGIN: %u\n",
+        "%s OFFLOAD_RECORD_OFFLINE_MS: %.3f | SIM_FRAMES: %llu | KEPT: %zu | STEP: %zu | SIM_FPS: %.2f | KEPT_FPS: %.2f | BATCH: %zu\n",
         tag,
         record_ms,
         (unsigned long long)sim_frames,
@@ -237,7 +237,7 @@ static inline void run_offload_scene(
         record_step,
         sim_fps,
         kept_fps,
-        (unsigned)record_failed_begins
+        batch.size()
     );
 
     if (recorded.empty())
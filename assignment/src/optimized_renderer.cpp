@@ -141,9 +141,16 @@ void optimized_renderer_core::worker_loop(int worker_index) noexcept
             seen_gen = m_job_gen;
         }
 
-        const worker_range r = m_ranges[worker_index];
-        if (r.y0 <= r.y1)
-            draw_world_slice(r.y0, r.y1);
+        if (m_batch)
+        {
+            render_batch_share(worker_index);
+        }
+        else
+        {
+            const worker_range r = m_ranges[worker_index];
+            if (r.y0 <= r.y1)
+                draw_world_slice(r.y0, r.y1);
+        }
 
         {
             std::lock_guard<std::mutex> lg(m_job_mtx);
@@ -194,25 +201,25 @@ void optimized_renderer_core::bind_targets_from_frame(const fox::cpu_frame& f) n
     zbuffer.data = f.z;
 }
 
-void optimized_renderer_core::clear_color_rgba(std::uint32_t rgba) const noexcept
+void optimized_renderer_core::clear_color_rgba(const FramebufferRGBA8& fb, std::uint32_t rgba) noexcept
 {
-    if (!framebuffer.data || framebuffer.h == 0 || framebuffer.pitch_bytes == 0 || framebuffer.pitch_pixels == 0) return;
+    if (!fb.data || fb.h == 0 || fb.pitch_bytes == 0 || fb.pitch_pixels == 0) return;
 
     if (rgba == 0)
     {
-        const std::size_t bytes = (std::size_t)framebuffer.pitch_bytes * (std::size_t)framebuffer.h;
-        std::memset(framebuffer.data, 0, bytes);
+        const std::size_t bytes = (std::size_t)fb.pitch_bytes * (std::size_t)fb.h;
+        std::memset(fb.data, 0, bytes);
         return;
     }
 
-    const std::uint32_t W = framebuffer.w;
-    const std::uint32_t H = framebuffer.h;
+    const std::uint32_t W = fb.w;
+    const std::uint32_t H = fb.h;
 
 #ifdef USE_SIMD
     const __m128i rgba4 = _mm_set1_epi32(static_cast<int>(rgba));
     for (std::uint32_t y = 0; y < H; ++y)
     {
-        std::uint32_t* row = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
+        std::uint32_t* row = fb.data + (std::size_t)y * (std::size_t)fb.pitch_pixels;
         std::uint32_t x = 0;
         const std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(row);
         if (addr & 0xF)
@@ -230,7 +237,7 @@ void optimized_renderer_core::clear_color_rgba(std::uint32_t rgba) const noexcep
 #else
     for (std::uint32_t y = 0; y < H; ++y)
     {
-        std::uint32_t* row = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
+        std::uint32_t* row = fb.data + (std::size_t)y * (std::size_t)fb.pitch_pixels;
         std::fill_n(row, W, rgba);
     }
 #endif
@@ -256,7 +263,7 @@ bool optimized_renderer_core::begin_cpu_frame(std::uint32_t clear_rgba) noexcept
         zbuffer.data  = m_offline_targets.z.data();
 
         if (clear_rgba != 0)
-            clear_color_rgba(clear_rgba);
+            clear_color_rgba(framebuffer, clear_rgba);
 
         if (zbuffer.data)
         {
@@ -274,7 +281,7 @@ bool optimized_renderer_core::begin_cpu_frame(std::uint32_t clear_rgba) noexcept
     bind_targets_from_frame(cur_frame);
 
     if (clear_rgba != 0)
-        clear_color_rgba(clear_rgba);
+        clear_color_rgba(framebuffer, clear_rgba);
 
     return true;
 }
@@ -317,24 +324,29 @@ void optimized_renderer_core::draw_world(const matrix& cam, const Light&, const
 
 void optimized_renderer_core::draw_world_slice(int y0, int y1) const noexcept
 {
-    const std::uint32_t W = m_job.W;
-    const std::uint32_t H = m_job.H;
-    (void)H;
+    draw_blocks(m_job, framebuffer, zbuffer, pinned_draw_blocks.data(), pinned_draw_blocks.size(), y0, y1);
+}
+
+void optimized_renderer_core::draw_blocks(const draw_job_shared& job, const FramebufferRGBA8& fb, const ZBufferF32& zb,
+                                          const draw_pinned_block* blocks, std::size_t block_count, int y0, int y1) const noexcept
+{
+    const std::uint32_t W = job.W;
 
-    const float fw = m_job.fw;
-    const float fh = m_job.fh;
+    const float fw = job.fw;
+    const float fh = job.fh;
 
-    const matrix vp = m_job.vp;
-    const vec4 light_dir_in = m_job.light_dir;
+    const matrix vp = job.vp;
+    const vec4 light_dir_in = job.light_dir;
 
-    const std::uint32_t pitch_pixels = framebuffer.pitch_pixels;
+    const std::uint32_t pitch_pixels = fb.pitch_pixels;
 
-    for (const auto& block : render_cache_.blocks())
+    for (std::size_t bi = 0; bi < block_count; ++bi)
     {
-        MeshRefPN* meshes       = std::get<0>(block.arrays);
-        Transform* transforms   = std::get<1>(block.arrays);
-        Material*  materials    = std::get<2>(block.arrays);
-        const std::size_t n     = block.n;
+        const draw_pinned_block& block = blocks[bi];
+        const MeshRefPN* meshes     = block.meshes;
+        const Transform* transforms = block.transforms;
+        const Material*  materials  = block.materials;
+        const std::size_t n         = block.n;
 
         for (std::size_t ei = 0; ei < n; ++ei)
         {
@@ -445,8 +457,8 @@ void optimized_renderer_core::draw_world_slice(int y0, int y1) const noexcept
 
                 for (int y = miny; y <= maxy; ++y)
                 {
-                    float* zptr = zbuffer.data + (std::size_t)y * (std::size_t)zbuffer.pitch + (std::size_t)minx;
-                    std::uint32_t* cptr = framebuffer.data + (std::size_t)y * (std::size_t)pitch_pixels + (std::size_t)minx;
+                    float* zptr = zb.data + (std::size_t)y * (std::size_t)zb.pitch + (std::size_t)minx;
+                    std::uint32_t* cptr = fb.data + (std::size_t)y * (std::size_t)pitch_pixels + (std::size_t)minx;
 
                     float w0 = w0_row;
                     float w1 = w1_row;
@@ -557,25 +569,102 @@ void optimized_renderer_core::pin_draw_query_once() noexcept
     pinned_draw_ready = true;
 }
 
-void optimized_renderer_core::ensure_offline_targets(std::uint32_t w, std::uint32_t h) noexcept
+void optimized_renderer_core::ensure_targets(offline_targets_t& t, std::uint32_t w, std::uint32_t h) noexcept
 {
     if (w == 0 || h == 0) return;
 
-    if (m_offline_targets.w == w && m_offline_targets.h == h &&
-        !m_offline_targets.color.empty() && !m_offline_targets.z.empty())
+    if (t.w == w && t.h == h && !t.color.empty() && !t.z.empty())
         return;
 
-    m_offline_targets.w = w;
-    m_offline_targets.h = h;
-    m_offline_targets.pitch_pixels = w;
-    m_offline_targets.pitch_bytes  = w * 4u;
-    m_offline_targets.z_pitch      = w;
+    t.w = w;
+    t.h = h;
+    t.pitch_pixels = w;
+    t.pitch_bytes  = w * 4u;
+    t.z_pitch      = w;
+
+    t.color.resize((std::size_t)w * (std::size_t)h);
+    t.z.resize((std::size_t)w * (std::size_t)h);
 
-    m_offline_targets.color.resize((std::size_t)w * (std::size_t)h);
-    m_offline_targets.z.resize((std::size_t)w * (std::size_t)h);
+    std::memset(t.color.data(), 0, t.color.size() * sizeof(std::uint32_t));
+    std::memset(t.z.data(),     0, t.z.size() * sizeof(float));
+}
+
+void optimized_renderer_core::ensure_offline_targets(std::uint32_t w, std::uint32_t h) noexcept
+{
+    ensure_targets(m_offline_targets, w, h);
+}
+
+void optimized_renderer_core::capture_offline_frame(offline_frame& f, const matrix& cam, const vec4& light_dir) noexcept
+{
+    refresh_render_cache();
+
+    f.vp = perspective * cam;
+    f.light_dir = light_dir;
+    f.meshes.clear();
+    f.transforms.clear();
+    f.materials.clear();
+    for (const draw_pinned_block& b : pinned_draw_blocks)
+    {
+        f.meshes.insert(f.meshes.end(), b.meshes, b.meshes + b.n);
+        f.transforms.insert(f.transforms.end(), b.transforms, b.transforms + b.n);
+        f.materials.insert(f.materials.end(), b.materials, b.materials + b.n);
+    }
+
+    ensure_targets(f.targets, m_offline_targets.w ? m_offline_targets.w : 1024u,
+                              m_offline_targets.h ? m_offline_targets.h : 768u);
+}
 
-    std::memset(m_offline_targets.color.data(), 0, m_offline_targets.color.size() * sizeof(std::uint32_t));
-    std::memset(m_offline_targets.z.data(),     0, m_offline_targets.z.size() * sizeof(float));
+void optimized_renderer_core::render_offline_frames(offline_frame* frames, std::size_t count, std::uint32_t clear_rgba) noexcept
+{
+    if (!frames || count == 0) return;
+
+    m_job.W = frames[0].targets.w;
+    m_job.H = frames[0].targets.h;
+    m_job.fw = static_cast<float>(m_job.W);
+    m_job.fh = static_cast<float>(m_job.H);
+    m_job.clear_rgba = clear_rgba;
+
+    // Whole frames per thread: one hand-off for the batch instead of one per frame
+    {
+        std::lock_guard<std::mutex> lg(m_job_mtx);
+        m_batch = frames;
+        m_batch_count = count;
+        m_done_count = 0;
+        ++m_job_gen;
+    }
+    m_job_cv.notify_all();
+
+    render_batch_share(kTotalSlices - 1);
+
+    {
+        std::unique_lock<std::mutex> lk(m_job_mtx);
+        m_done_cv.wait(lk, [&]() { return m_done_count == kWorkerCount; });
+        m_batch = nullptr;
+        m_batch_count = 0;
+    }
+}
+
+void optimized_renderer_core::render_batch_share(int worker_index) const noexcept
+{
+    for (std::size_t i = (std::size_t)worker_index; i < m_batch_count; i += kTotalSlices)
+    {
+        offline_frame& f = m_batch[i];
+        offline_targets_t& t = f.targets;
+
+        FramebufferRGBA8 fb{};
+        fb.bind(t.w, t.h, t.pitch_bytes, t.pitch_pixels, t.color.data());
+        const ZBufferF32 zb{ t.w, t.h, t.z_pitch, t.z.data() };
+
+        clear_color_rgba(fb, m_job.clear_rgba);
+        std::memset(zb.data, 0, (std::size_t)zb.pitch * (std::size_t)zb.h * sizeof(float));
+
+        draw_job_shared job = m_job;
+        job.vp = f.vp;
+        job.light_dir = f.light_dir;
+
+        const draw_pinned_block block{ f.meshes.data(), f.transforms.data(), f.materials.data(), f.meshes.size() };
+        draw_blocks(job, fb, zb, &block, 1, 0, (int)t.h - 1);
+    }
 }
 
 void optimized_renderer_core::refresh_render_cache() noexcept
@@ -0,0 +1,530 @@
+// Deterministic frame benchmark. Every scene runs headless for a fixed number of frames at each
+// resolution, with its camera scripted by frame index and its randomness drawn from one seed,
+// so two runs on the same machine differ only by the renderer. Results go to a JSON file:
+//
+//   fox_bench [--frames N] [--warmup N] [--seed N] [--res WxH]... [--scene NAME]... [--out PATH]
+
+#include "optimized/optimized_renderer.h"
+#include "optimized/job_system.h"
+#include "game/static_mesh.h"
+#include "texture_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct bench_resolution
+    {
+        std::uint32_t w = 0;
+        std::uint32_t h = 0;
+    };
+
+    struct bench_config
+    {
+        std::uint32_t frames = 600;
+        std::uint32_t warmup = 60;
+        std::uint32_t seed = 1234u;
+        std::vector<bench_resolution> resolutions{};
+        std::vector<std::string> scenes{};  // empty runs all of them
+        std::string out_path = "bench_results.json";
+    };
+
+    Light make_bench_light() noexcept
+    {
+        return {
+            vec4(0.f, 1.f, 1.f, 0.f),
+            colour(1.f, 1.f, 1.f),
+            colour(0.2f, 0.2f, 0.2f)
+        };
+    }
+
+    // One frame of a scene's script; frame counts from 0 over warmup and measured frames alike
+    struct bench_view
+    {
+        matrix camera{};
+        vec4 light_dir{ 0.f, 1.f, 1.f, 0.f };
+    };
+
+    class bench_scene
+    {
+    public:
+        virtual ~bench_scene() = default;
+
+        [[nodiscard]] virtual const char* name() const noexcept = 0;
+        // False when an asset the scene needs is missing; the scene is skipped
+        virtual bool build(optimized_renderer_core& r, std::mt19937& rng, texture_cache& tex) = 0;
+        virtual bench_view tick(std::uint32_t frame) noexcept = 0;
+        [[nodiscard]] virtual float far_plane() const noexcept { return 100.f; }
+    };
+
+    // Cube corridor with a dolly camera, as scene 1 of the assignment
+    class corridor_scene final : public bench_scene
+    {
+    public:
+        [[nodiscard]] const char* name() const noexcept override { return "scene1_corridor"; }
+
+        bool build(optimized_renderer_core& r, std::mt19937& rng, texture_cache&) override
+        {
+            constexpr unsigned int columns = 20;
+            std::uniform_int_distribution<int> axis(0, 3);
+            std::uniform_real_distribution<float> angle(0.f, 2.f * fox_math::pi_f);
+
+            const auto random_rotation = [&]()
+            {
+                const int a = axis(rng);
+                const float r_angle = angle(rng);
+                if (a == 0) return matrix::makeRotateX(r_angle);
+                if (a == 1) return matrix::makeRotateY(r_angle);
+                if (a == 2) return matrix::makeRotateZ(r_angle);
+                return matrix::makeIdentity();
+            };
+
+            cubes_.clear();
+            r.world.reserve<MeshRefPN, Transform, Material>(columns * 2u);
+            for (unsigned int i = 0; i < columns; ++i)
+            {
+                const float z = -3.f * (float)i;
+                for (const float x : { -2.f, 2.f })
+                {
+                    cube c{};
+                    c.base_t = matrix::makeTranslation(x, 0.f, z);
+                    c.base_r = random_rotation();
+                    c.e = spawn_instance(r.world, r.cube_asset, c.base_t * c.base_r, colour(0.20f, 0.85f, 0.25f), 0.75f, 0.75f);
+                    cubes_.push_back(c);
+                }
+            }
+            world_ = &r.world;
+            return true;
+        }
+
+        bench_view tick(std::uint32_t frame) noexcept override
+        {
+            // The two nearest cubes spin, the camera sweeps z in [-60, 8] at 0.1 per frame
+            static const matrix spin[2] = { matrix::makeRotateXYZ(0.1f, 0.1f, 0.f), matrix::makeRotateXYZ(0.f, 0.1f, 0.2f) };
+            for (std::size_t i = 0; i < 2 && i < cubes_.size(); ++i)
+            {
+                cubes_[i].base_r = cubes_[i].base_r * spin[i];
+                if (Transform* tr = world_->try_get_component<Transform>(cubes_[i].e))
+                    tr->world = cubes_[i].base_t * cubes_[i].base_r;
+            }
+
+            constexpr std::uint32_t period = 1360; // 680 steps down, 680 back
+            const std::uint32_t phase = frame % period;
+            const float zoffset = 8.f - 0.1f * (float)((phase < period / 2) ? phase : period - phase);
+            return { matrix::makeCameraDollyZ(zoffset), vec4(0.f, 1.f, 1.f, 0.f) };
+        }
+
+    private:
+        struct cube
+        {
+            fecs::entity e{};
+            matrix base_t{};
+            matrix base_r{};
+        };
+
+        std::vector<cube> cubes_{};
+        fecs::world* world_ = nullptr;
+    };
+
+    // Grid of tumbling cubes with a sphere sliding past, as scene 2 of the assignment
+    class grid_scene final : public bench_scene
+    {
+    public:
+        [[nodiscard]] const char* name() const noexcept override { return "scene2_grid"; }
+
+        bool build(optimized_renderer_core& r, std::mt19937& rng, texture_cache&) override
+        {
+            constexpr std::uint32_t grid_w = 8;
+            constexpr std::uint32_t grid_h = 6;
+            std::uniform_real_distribution<float> step(-0.1f, 0.1f);
+
+            if (!sphere_asset_.positions)
+                sphere_asset_ = build_asset_from_indexed_mesh(Mesh::makeSphere(1.f, 10, 20));
+
+            cubes_.clear();
+            r.world.reserve<MeshRefPN, Transform, Material>(grid_w * grid_h + 1u);
+            for (std::uint32_t gy = 0; gy < grid_h; ++gy)
+            {
+                for (std::uint32_t gx = 0; gx < grid_w; ++gx)
+                {
+                    const matrix t = matrix::makeTranslation(-7.f + (float)gx * 2.f, 5.f - (float)gy * 2.f, -8.f);
+                    cube c{};
+                    c.e = spawn_instance(r.world, r.cube_asset, t, colour(0.85f, 0.25f, 0.2f), 0.75f, 0.75f);
+                    const float rx = step(rng);
+                    const float ry = step(rng);
+                    const float rz = step(rng);
+                    c.step = matrix::makeRotateXYZ(rx, ry, rz);
+                    cubes_.push_back(c);
+                }
+            }
+
+            sphere_ = spawn_instance(r.world, sphere_asset_, matrix::makeTranslation(-6.f, 0.f, -6.f), colour(0.2f, 0.4f, 0.9f), 0.75f, 0.75f);
+            world_ = &r.world;
+            return true;
+        }
+
+        bench_view tick(std::uint32_t frame) noexcept override
+        {
+            for (const cube& c : cubes_)
+            {
+                if (Transform* tr = world_->try_get_component<Transform>(c.e))
+                    tr->world = tr->world * c.step;
+            }
+
+            constexpr std::uint32_t period = 240; // -6 to 6 and back at 0.1 per frame
+            const std::uint32_t phase = frame % period;
+            const float x = -6.f + 0.1f * (float)((phase < period / 2) ? phase : period - phase);
+            if (Transform* tr = world_->try_get_component<Transform>(sphere_))
+                tr->world = matrix::makeTranslation(x, 0.f, -6.f);
+
+            return { matrix::makeIdentity(), vec4(0.f, 1.f, 1.f, 0.f) };
+        }
+
+    private:
+        struct cube
+        {
+            fecs::entity e{};
+            matrix step{};
+        };
+
+        std::vector<cube> cubes_{};
+        fecs::entity sphere_{};
+        MeshAssetPN sphere_asset_{};
+        fecs::world* world_ = nullptr;
+    };
+
+    // Camera on a circle around the scene bounds, one turn over the whole run
+    bench_view orbit_view(const vec4& bmin, const vec4& bmax, float distance_scale, float height_scale, std::uint32_t frame, std::uint32_t frames) noexcept
+    {
+        const vec4 center((bmin.x + bmax.x) * 0.5f, (bmin.y + bmax.y) * 0.5f, (bmin.z + bmax.z) * 0.5f, 1.f);
+        const float dx = bmax.x - bmin.x, dy = bmax.y - bmin.y, dz = bmax.z - bmin.z;
+        const float radius = 0.5f * std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        const float a = 2.f * fox_math::pi_f * (float)frame / (float)(std::max)(frames, 1u);
+        const vec4 eye(center.x + std::cos(a) * radius * distance_scale,
+                       center.y + radius * height_scale,
+                       center.z + std::sin(a) * radius * distance_scale,
+                       1.f);
+        vec4 light(std::cos(a * 0.5f), 1.f, std::sin(a * 0.5f), 0.f);
+        light.normalise();
+        return { fox_math::look_at(eye, center, vec4(0.f, 1.f, 0.f, 0.f)), light };
+    }
+
+    // One assets/static model, placed count x count times on a jittered grid
+    class static_level_scene final : public bench_scene
+    {
+    public:
+        static_level_scene(const char* name, const char* path, std::uint32_t count, std::uint32_t frames)
+            : name_(name), path_(path), count_(count), frames_(frames) {}
+
+        [[nodiscard]] const char* name() const noexcept override { return name_; }
+
+        bool build(optimized_renderer_core& r, std::mt19937& rng, texture_cache& tex) override
+        {
+            if (!mesh_)
+            {
+                mesh_ = std::make_unique<static_mesh>();
+                if (!mesh_->load(path_, &tex))
+                {
+                    std::fprintf(stderr, "fox_bench: %s: cannot load %s\n", name_, path_);
+                    mesh_.reset();
+                    return false;
+                }
+            }
+
+            const vec4& mn = mesh_->bounds_min();
+            const vec4& mx = mesh_->bounds_max();
+            const float spacing = 1.25f * (std::max)(mx.x - mn.x, mx.z - mn.z);
+            std::uniform_real_distribution<float> jitter(-0.15f, 0.15f);
+            std::uniform_real_distribution<float> yaw(0.f, 2.f * fox_math::pi_f);
+
+            bmin_ = mn;
+            bmax_ = mx;
+            for (std::uint32_t gz = 0; gz < count_; ++gz)
+            {
+                for (std::uint32_t gx = 0; gx < count_; ++gx)
+                {
+                    const float x = ((float)gx - 0.5f * (float)(count_ - 1u) + jitter(rng)) * spacing;
+                    const float z = ((float)gz - 0.5f * (float)(count_ - 1u) + jitter(rng)) * spacing;
+                    const float y_rot = (count_ > 1u) ? yaw(rng) : 0.f;
+                    mesh_->build_instances(r.world, matrix::makeTranslation(x, 0.f, z) * matrix::makeRotateY(y_rot), colour(0.7f, 0.7f, 0.7f), 0.75f, 0.75f);
+
+                    bmin_.x = (std::min)(bmin_.x, x + mn.x - spacing * 0.5f);
+                    bmin_.z = (std::min)(bmin_.z, z + mn.z - spacing * 0.5f);
+                    bmax_.x = (std::max)(bmax_.x, x + mx.x + spacing * 0.5f);
+                    bmax_.z = (std::max)(bmax_.z, z + mx.z + spacing * 0.5f);
+                }
+            }
+
+            return true;
+        }
+
+        bench_view tick(std::uint32_t frame) noexcept override
+        {
+            return orbit_view(bmin_, bmax_, 0.9f, 0.35f, frame, frames_);
+        }
+
+        // Past the whole level so the orbit never clips it
+        [[nodiscard]] float far_plane() const noexcept override
+        {
+            const float dx = bmax_.x - bmin_.x, dy = bmax_.y - bmin_.y, dz = bmax_.z - bmin_.z;
+            return 2.f * std::sqrt(dx * dx + dy * dy + dz * dz) + 100.f;
+        }
+
+    private:
+        const char* name_ = "";
+        const char* path_ = "";
+        std::uint32_t count_ = 1;
+        std::uint32_t frames_ = 1;
+        std::unique_ptr<static_mesh> mesh_{};
+        vec4 bmin_{};
+        vec4 bmax_{};
+    };
+
+    struct sample_summary
+    {
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    // Nearest rank percentiles
+    sample_summary summarize(std::vector<double> v)
+    {
+        sample_summary s{};
+        if (v.empty()) return s;
+
+        std::sort(v.begin(), v.end());
+        const auto rank = [&](double p)
+        {
+            const std::size_t i = (std::size_t)std::ceil(p * (double)v.size());
+            return v[(std::min)(i > 0 ? i - 1 : 0, v.size() - 1)];
+        };
+
+        double sum = 0.0;
+        for (const double x : v) sum += x;
+        s.mean = sum / (double)v.size();
+        s.p50 = rank(0.50);
+        s.p95 = rank(0.95);
+        s.p99 = rank(0.99);
+        s.max = v.back();
+        return s;
+    }
+
+    struct run_result
+    {
+        std::string scene{};
+        bench_resolution res{};
+        std::uint32_t frames = 0;
+        sample_summary frame_ms{};
+        sample_summary pass_ms[optimized_renderer_core::kFramePassCount]{};
+        std::vector<double> worker_busy_ms{};   // mean per frame for every job_system slot and the shared entry
+        double triangles_submitted = 0.0;
+        double triangles_rasterized = 0.0;
+        double pixels_depth_tested = 0.0;
+        double pixels_shaded = 0.0;
+        double heap_allocations = 0.0;
+    };
+
+    bool run_scene(bench_scene& scene, const bench_config& cfg, const bench_resolution& res, texture_cache& tex, run_result& out)
+    {
+        optimized_renderer_core r(optimized_renderer_core::headless, res.w, res.h);
+
+        std::mt19937 rng(cfg.seed);
+        if (!scene.build(r, rng, tex))
+            return false;
+        // Every bench mesh is closed, so it is timed with back faces culled like the game's meshes
+        r.world.query<Material>().each([](Material* mats, std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                mats[i].cull = cull_mode::back;
+        });
+        r.perspective = matrix::makePerspective(90.f * fox_math::pi_f / 180.f, (float)res.w / (float)res.h, 0.1f, scene.far_plane());
+
+        const Light light = make_bench_light();
+        const std::uint32_t total = cfg.warmup + cfg.frames;
+
+        std::vector<double> frame_ms;
+        std::vector<double> pass_ms[optimized_renderer_core::kFramePassCount];
+        frame_ms.reserve(cfg.frames);
+        for (auto& v : pass_ms) v.reserve(cfg.frames);
+
+        out = {};
+        out.scene = scene.name();
+        out.res = res;
+
+        // Stats of a frame are published when the next one begins, so one extra begin closes the run
+        for (std::uint32_t frame = 0; frame <= total; ++frame)
+        {
+            if (!r.begin_cpu_frame(0xFF000000u))
+                continue;
+
+            const optimized_renderer_core::frame_stats& fs = r.last_frame_stats();
+            if (frame > cfg.warmup)
+            {
+                frame_ms.push_back(fs.frame_ms);
+                for (std::size_t p = 0; p < optimized_renderer_core::kFramePassCount; ++p)
+                    pass_ms[p].push_back(fs.pass_ms[p]);
+
+                if (out.worker_busy_ms.size() < fs.worker_busy_ms.size())
+                    out.worker_busy_ms.resize(fs.worker_busy_ms.size(), 0.0);
+                for (std::size_t w = 0; w < fs.worker_busy_ms.size(); ++w)
+                    out.worker_busy_ms[w] += fs.worker_busy_ms[w];
+
+                out.triangles_submitted += fs.draw.triangles_submitted;
+                out.triangles_rasterized += fs.draw.triangles_rasterized;
+                out.pixels_depth_tested += (double)fs.pixels_depth_tested;
+                out.pixels_shaded += (double)fs.pixels_shaded;
+                out.heap_allocations += (double)fs.heap_allocations;
+            }
+            if (frame == total)
+                break;
+
+            const bench_view view = scene.tick(frame);
+            r.draw_world(view.camera, light, view.light_dir);
+        }
+
+        out.frames = (std::uint32_t)frame_ms.size();
+        const double n = (std::max)(1.0, (double)out.frames);
+        for (double& w : out.worker_busy_ms) w /= n;
+        out.triangles_submitted /= n;
+        out.triangles_rasterized /= n;
+        out.pixels_depth_tested /= n;
+        out.pixels_shaded /= n;
+        out.heap_allocations /= n;
+
+        out.frame_ms = summarize(std::move(frame_ms));
+        for (std::size_t p = 0; p < optimized_renderer_core::kFramePassCount; ++p)
+            out.pass_ms[p] = summarize(std::move(pass_ms[p]));
+        return true;
+    }
+
+    void write_summary(std::FILE* f, const char* key, const sample_summary& s, const char* indent)
+    {
+        std::fprintf(f, "%s\"%s\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+                     indent, key, s.mean, s.p50, s.p95, s.p99, s.max);
+    }
+
+    bool write_json(const bench_config& cfg, const char* raster_isa, const std::vector<run_result>& runs)
+    {
+        std::FILE* f = std::fopen(cfg.out_path.c_str(), "w");
+        if (!f)
+        {
+            std::fprintf(stderr, "fox_bench: cannot write %s\n", cfg.out_path.c_str());
+            return false;
+        }
+
+        std::fprintf(f, "{\n");
+        std::fprintf(f, "  \"seed\": %u,\n  \"frames\": %u,\n  \"warmup\": %u,\n", cfg.seed, cfg.frames, cfg.warmup);
+        std::fprintf(f, "  \"worker_slots\": %u,\n  \"raster_isa\": \"%s\",\n", fox::job_system::instance().slot_count(), raster_isa);
+        std::fprintf(f, "  \"runs\": [\n");
+        for (std::size_t i = 0; i < runs.size(); ++i)
+        {
+            const run_result& run = runs[i];
+            std::fprintf(f, "    {\n");
+            std::fprintf(f, "      \"scene\": \"%s\",\n      \"width\": %u,\n      \"height\": %u,\n      \"frames\": %u,\n",
+                         run.scene.c_str(), run.res.w, run.res.h, run.frames);
+            write_summary(f, "frame_ms", run.frame_ms, "      ");
+            std::fprintf(f, ",\n      \"pass_ms\": {\n");
+            for (std::size_t p = 0; p < optimized_renderer_core::kFramePassCount; ++p)
+            {
+                write_summary(f, optimized_renderer_core::frame_pass_name((optimized_renderer_core::frame_pass)p), run.pass_ms[p], "        ");
+                std::fprintf(f, (p + 1 < optimized_renderer_core::kFramePassCount) ? ",\n" : "\n");
+            }
+            std::fprintf(f, "      },\n      \"worker_busy_ms\": [");
+            for (std::size_t w = 0; w < run.worker_busy_ms.size(); ++w)
+                std::fprintf(f, "%s%.4f", w ? ", " : "", run.worker_busy_ms[w]);
+            std::fprintf(f, "],\n");
+            std::fprintf(f, "      \"triangles_submitted\": %.1f,\n      \"triangles_rasterized\": %.1f,\n",
+                         run.triangles_submitted, run.triangles_rasterized);
+            std::fprintf(f, "      \"pixels_depth_tested\": %.1f,\n      \"pixels_shaded\": %.1f,\n      \"heap_allocations\": %.3f\n",
+                         run.pixels_depth_tested, run.pixels_shaded, run.heap_allocations);
+            std::fprintf(f, "    }%s\n", (i + 1 < runs.size()) ? "," : "");
+        }
+        std::fprintf(f, "  ]\n}\n");
+        std::fclose(f);
+        return true;
+    }
+
+    bool parse_args(int argc, char** argv, bench_config& cfg)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char* arg = argv[i];
+            const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            const auto take = [&]() { ++i; return val; };
+
+            if (!std::strcmp(arg, "--frames") && val) cfg.frames = (std::uint32_t)std::strtoul(take(), nullptr, 10);
+            else if (!std::strcmp(arg, "--warmup") && val) cfg.warmup = (std::uint32_t)std::strtoul(take(), nullptr, 10);
+            else if (!std::strcmp(arg, "--seed") && val) cfg.seed = (std::uint32_t)std::strtoul(take(), nullptr, 10);
+            else if (!std::strcmp(arg, "--out") && val) cfg.out_path = take();
+            else if (!std::strcmp(arg, "--scene") && val) cfg.scenes.emplace_back(take());
+            else if (!std::strcmp(arg, "--res") && val)
+            {
+                bench_resolution res{};
+                if (std::sscanf(take(), "%ux%u", &res.w, &res.h) != 2 || res.w == 0 || res.h == 0)
+                    return false;
+                cfg.resolutions.push_back(res);
+            }
+            else
+                return false;
+        }
+
+        cfg.frames = (std::max)(cfg.frames, 1u);
+        if (cfg.resolutions.empty())
+            cfg.resolutions = { { 1024, 768 }, { 1920, 1080 } };
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench_config cfg{};
+    if (!parse_args(argc, argv, cfg))
+    {
+        std::fprintf(stderr, "usage: fox_bench [--frames N] [--warmup N] [--seed N] [--res WxH]... [--scene NAME]... [--out PATH]\n");
+        return 2;
+    }
+
+    const std::uint32_t orbit_frames = cfg.warmup + cfg.frames;
+    std::vector<std::unique_ptr<bench_scene>> scenes;
+    scenes.push_back(std::make_unique<corridor_scene>());
+    scenes.push_back(std::make_unique<grid_scene>());
+    scenes.push_back(std::make_unique<static_level_scene>("inferno_world", "assets/static/Inferno_World_free.glb", 1u, orbit_frames));
+    scenes.push_back(std::make_unique<static_level_scene>("fir_forest_24x24", "assets/static/fir_001.glb", 24u, orbit_frames));
+    scenes.push_back(std::make_unique<static_level_scene>("house_town_12x12", "assets/static/house_002.glb", 12u, orbit_frames));
+
+    texture_cache tex{};
+    std::vector<run_result> runs;
+
+    for (const auto& scene : scenes)
+    {
+        if (!cfg.scenes.empty() && std::find(cfg.scenes.begin(), cfg.scenes.end(), scene->name()) == cfg.scenes.end())
+            continue;
+
+        for (const bench_resolution& res : cfg.resolutions)
+        {
+            run_result result{};
+            if (!run_scene(*scene, cfg, res, tex, result))
+                break;
+
+            std::printf("%-18s %4ux%-4u frame p50 %7.3f p95 %7.3f p99 %7.3f ms | raster p50 %7.3f ms\n",
+                        result.scene.c_str(), res.w, res.h,
+                        result.frame_ms.p50, result.frame_ms.p95, result.frame_ms.p99,
+                        result.pass_ms[(std::size_t)optimized_renderer_core::frame_pass::raster].p50);
+            runs.push_back(std::move(result));
+        }
+    }
+
+    return write_json(cfg, raster_isa_name(detect_raster_isa()), runs) ? 0 : 1;
+}
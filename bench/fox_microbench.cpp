@@ -0,0 +1,435 @@
+// Hot kernels on synthetic inputs, one line per case. Raster and effect cases go through a
+// headless renderer and read its frame stats; skinning, row upload and fecs iteration are timed
+// directly. Build once per FOX_SIMD_LEVEL to compare levels; the raster kernel ISA is swept at
+// runtime.
+//
+//   fox_microbench [--res WxH] [--frames N] [--skin PATH]
+
+#include "optimized/optimized_renderer.h"
+#include "optimized/row_copy.h"
+#include "game/dynamic_mesh.h"
+#include "texture_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct microbench_config
+    {
+        std::uint32_t w = 1024;
+        std::uint32_t h = 768;
+        std::uint32_t frames = 30;
+        std::string skin_path = "assets/dynamic/fox.glb";
+    };
+
+    const char* simd_level_name() noexcept
+    {
+#if !defined(USE_SIMD)
+        return "scalar";
+#elif defined(FOX_SIMD_LEVEL_AVX2)
+        return "AVX2";
+#elif defined(FOX_SIMD_LEVEL_AVX)
+        return "AVX";
+#else
+        return "SSE2";
+#endif
+    }
+
+    Light make_light(const vec4& dir) noexcept
+    {
+        return { dir, colour(1.f, 1.f, 1.f), colour(0.2f, 0.2f, 0.2f), colour(1.f, 1.f, 1.f) };
+    }
+
+    // Best of reps runs, in nanoseconds
+    template<class Fn>
+    double best_ns(int reps, Fn&& fn)
+    {
+        double best = 1e300;
+        for (int i = 0; i < reps; ++i)
+        {
+            const auto t0 = std::chrono::steady_clock::now();
+            fn();
+            const auto t1 = std::chrono::steady_clock::now();
+            best = (std::min)(best, (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+        }
+        return best;
+    }
+
+    // Frame stats averaged over a run, taken from the frame each begin_cpu_frame closes
+    struct frame_average
+    {
+        double pass_ms[optimized_renderer_core::kFramePassCount]{};
+        double triangles = 0.0;
+        double pixels_tested = 0.0;
+        std::uint32_t frames = 0;
+    };
+
+    template<class Draw>
+    frame_average run_frames(optimized_renderer_core& r, std::uint32_t frames, Draw&& draw)
+    {
+        constexpr std::uint32_t warmup = 3;
+        frame_average avg{};
+        for (std::uint32_t f = 0; f <= warmup + frames; ++f)
+        {
+            if (!r.begin_cpu_frame(0xFF000000u))
+                continue;
+
+            const optimized_renderer_core::frame_stats& fs = r.last_frame_stats();
+            if (f > warmup)
+            {
+                for (std::size_t p = 0; p < optimized_renderer_core::kFramePassCount; ++p)
+                    avg.pass_ms[p] += fs.pass_ms[p];
+                avg.triangles += fs.draw.triangles_submitted;
+                avg.pixels_tested += (double)fs.pixels_depth_tested;
+                ++avg.frames;
+            }
+            if (f < warmup + frames)
+                draw();
+        }
+
+        const double n = (std::max)(1.0, (double)avg.frames);
+        for (double& ms : avg.pass_ms) ms /= n;
+        avg.triangles /= n;
+        avg.pixels_tested /= n;
+        return avg;
+    }
+
+    double pass_ms(const frame_average& avg, optimized_renderer_core::frame_pass pass) noexcept
+    {
+        return avg.pass_ms[(std::size_t)pass];
+    }
+
+    // count right triangles with legs of leg_x by leg_y pixels, scattered over the view at depths
+    // in [1, 1.5] and wound to face the camera
+    MeshAssetPN make_triangle_field(std::uint32_t count, float leg_x, float leg_y, std::uint32_t w, std::uint32_t h, bool uvs)
+    {
+        std::mt19937 rng(7u);
+        std::uniform_real_distribution<float> sx(-1.f, 1.f);
+        std::uniform_real_distribution<float> depth(1.f, 1.5f);
+
+        const float aspect = (float)w / (float)h;
+        MeshAssetPN a{};
+        a.allocate_indexed(count, count * 3u, uvs);
+        for (std::uint32_t t = 0; t < count; ++t)
+        {
+            const float d = depth(rng);
+            const float px = 2.f * d / (float)h;      // one pixel at that depth, 90 degree vertical fov
+            const float x = sx(rng) * aspect * d;
+            const float y = sx(rng) * d;
+
+            const vec4 p[3] = {
+                vec4(x, y, -d, 1.f),
+                vec4(x + leg_x * px, y, -d, 1.f),
+                vec4(x, y + leg_y * px, -d, 1.f),
+            };
+            for (std::uint32_t k = 0; k < 3; ++k)
+            {
+                a.positions[t * 3u + k] = p[k];
+                a.normals[t * 3u + k] = vec4(0.f, 0.f, 1.f, 0.f);
+                a.indices[t * 3u + k] = t * 3u + k;
+                if (uvs)
+                {
+                    a.uvs[(t * 3u + k) * 2u + 0] = (k == 1) ? 1.f : 0.f;
+                    a.uvs[(t * 3u + k) * 2u + 1] = (k == 2) ? 1.f : 0.f;
+                }
+            }
+        }
+        return a;
+    }
+
+    void bench_raster(const microbench_config& cfg, texture_cache& tex)
+    {
+        struct tri_case
+        {
+            const char* name;
+            std::uint32_t count;
+            float leg_x, leg_y;
+        };
+        const tri_case cases[] = {
+            { "small 4px",     200000u,   4.f,   4.f },
+            { "large 256px",     2000u, 256.f, 256.f },
+            { "sliver 512x1",   20000u, 512.f,  1.5f },
+        };
+
+        // A 1024x1024 noise texture held both ways, to weigh the bc1 decode against the bandwidth it saves
+        constexpr std::uint32_t kTexSize = 1024;
+        std::vector<std::uint32_t> noise((std::size_t)kTexSize * kTexSize);
+        std::mt19937 rng(7);
+        for (std::uint32_t& t : noise)
+            t = 0xFF000000u | (rng() & 0x00FFFFFFu);
+        TextureRGBA8 tex_rgba8{};
+        tex_rgba8.build_mip_chain(noise.data(), kTexSize, kTexSize);
+        TextureRGBA8 tex_bc1{};
+        tex_bc1.build_mip_chain(noise.data(), kTexSize, kTexSize);
+        tex_bc1.compress_bc1();
+
+        struct tex_case
+        {
+            const char* name;
+            TextureRef ref;
+        };
+        const tex_case textures[] = {
+            { "flat",    TextureRef{} },
+            { "checker", make_texture_ref(*tex.checkerboard()) },
+            { "rgba8",   make_texture_ref(tex_rgba8) },
+            { "bc1",     make_texture_ref(tex_bc1) },
+        };
+
+        std::vector<raster_isa> isas{ raster_isa::baseline };
+        if (detect_raster_isa() != raster_isa::baseline)
+            isas.push_back(detect_raster_isa());
+
+        for (const tri_case& c : cases)
+        {
+            for (const tex_case& t : textures)
+            {
+                const bool textured = t.ref.valid();
+                const MeshAssetPN field = make_triangle_field(c.count, c.leg_x, c.leg_y, cfg.w, cfg.h, textured);
+                for (const raster_isa isa : isas)
+                {
+                    optimized_renderer_core r(optimized_renderer_core::headless, cfg.w, cfg.h);
+                    r.wide_raster = (isa != raster_isa::baseline);
+                    spawn_instance(r.world, field, matrix::makeIdentity(), colour(0.8f, 0.6f, 0.4f), 0.75f, 0.75f, t.ref);
+
+                    const Light light = make_light(vec4(0.f, 0.f, 1.f, 0.f));
+                    const frame_average avg = run_frames(r, cfg.frames, [&]()
+                    {
+                        r.draw_world(matrix::makeIdentity(), light, vec4(0.f, 0.f, 1.f, 0.f));
+                    });
+
+                    const double setup_ms = pass_ms(avg, optimized_renderer_core::frame_pass::transform);
+                    const double raster_ms = pass_ms(avg, optimized_renderer_core::frame_pass::raster);
+                    const double tris = (std::max)(avg.triangles, 1.0);
+                    std::printf("raster  %-13s %-8s %-8s setup %7.1f ns/tri | raster %8.1f ns/tri, %8.1f Mpix/s\n",
+                                c.name, t.name, raster_isa_name(isa),
+                                setup_ms * 1e6 / tris,
+                                raster_ms * 1e6 / tris,
+                                raster_ms > 0.0 ? avg.pixels_tested / (raster_ms * 1e3) : 0.0);
+                }
+            }
+        }
+    }
+
+    // The small triangle field held as float streams and quantized, for the geometry stage fetch
+    void bench_vertex_formats(const microbench_config& cfg)
+    {
+        for (const bool quantized : { false, true })
+        {
+            MeshAssetPN field = make_triangle_field(200000u, 4.f, 4.f, cfg.w, cfg.h, true);
+            if (quantized)
+                field.quantize();
+
+            optimized_renderer_core r(optimized_renderer_core::headless, cfg.w, cfg.h);
+            spawn_instance(r.world, field, matrix::makeIdentity(), colour(0.8f, 0.6f, 0.4f), 0.75f, 0.75f);
+
+            const Light light = make_light(vec4(0.f, 0.f, 1.f, 0.f));
+            const frame_average avg = run_frames(r, cfg.frames, [&]()
+            {
+                r.draw_world(matrix::makeIdentity(), light, vec4(0.f, 0.f, 1.f, 0.f));
+            });
+
+            const double tris = (std::max)(avg.triangles, 1.0);
+            std::printf("vertex  %-9s %6.1f MB | setup %7.1f ns/tri\n",
+                        quantized ? "quantized" : "float",
+                        (double)field.resident_bytes() / (1024.0 * 1024.0),
+                        pass_ms(avg, optimized_renderer_core::frame_pass::transform) * 1e6 / tris);
+        }
+    }
+
+    void bench_clear_and_effects(const microbench_config& cfg)
+    {
+        optimized_renderer_core r(optimized_renderer_core::headless, cfg.w, cfg.h);
+        const double pixels = (double)cfg.w * (double)cfg.h;
+        const Light light = make_light(vec4(0.f, 1.f, 1.f, 0.f));
+
+        // An empty world leaves every tile to the clear sweep, which counts as raster
+        {
+            const frame_average avg = run_frames(r, cfg.frames, [&]() { r.draw_world(matrix::makeIdentity(), light, light.omega_i); });
+            const double ms = pass_ms(avg, optimized_renderer_core::frame_pass::raster);
+            const double bytes = pixels * (double)(sizeof(std::uint32_t) + sizeof(float));
+            std::printf("clear   colour + depth          %7.3f ms | %7.2f GB/s, %8.1f Mpix/s\n",
+                        ms, ms > 0.0 ? bytes / (ms * 1e6) : 0.0, ms > 0.0 ? pixels / (ms * 1e3) : 0.0);
+        }
+
+        // Each effect reads and writes the frame once; neighbourhood taps come on top
+        const auto report = [&](const char* name, optimized_renderer_core::frame_pass pass, const frame_average& avg)
+        {
+            const double ms = pass_ms(avg, pass);
+            const double bytes = pixels * 2.0 * sizeof(std::uint32_t);
+            std::printf("effect  %-23s %7.3f ms | %7.2f GB/s, %8.1f Mpix/s\n",
+                        name, ms, ms > 0.0 ? bytes / (ms * 1e6) : 0.0, ms > 0.0 ? pixels / (ms * 1e3) : 0.0);
+        };
+
+        optimized_renderer_core::post_process_settings post{};
+        post.enabled = true;
+        report("post process", optimized_renderer_core::frame_pass::post, run_frames(r, cfg.frames, [&]()
+        {
+            r.draw_world(matrix::makeIdentity(), light, light.omega_i);
+            r.apply_post_process(post);
+        }));
+
+        optimized_renderer_core::rainy_effect_settings rain{};
+        rain.enabled = true;
+        report("rain", optimized_renderer_core::frame_pass::rain, run_frames(r, cfg.frames, [&]()
+        {
+            r.draw_world(matrix::makeIdentity(), light, light.omega_i);
+            r.apply_rainy_effect(rain, 1.f);
+        }));
+
+        optimized_renderer_core::advanced_effects_settings advanced{};
+        advanced.enabled = true;
+        report("advanced (defaults)", optimized_renderer_core::frame_pass::advanced, run_frames(r, cfg.frames, [&]()
+        {
+            r.draw_world(matrix::makeIdentity(), light, light.omega_i);
+            r.apply_advanced_effects(advanced, 1.f);
+        }));
+    }
+
+    void bench_skinning(const microbench_config& cfg)
+    {
+        dynamic_mesh mesh{};
+        if (!mesh.load(cfg.skin_path.c_str()))
+        {
+            std::printf("skin    %s not loaded, skipped\n", cfg.skin_path.c_str());
+            return;
+        }
+
+        dynamic_mesh_instance inst = mesh.create_instance();
+        mesh.tick_skinning(inst, 0.0);
+
+        std::size_t vertices = 0;
+        for (const auto& m : inst.mesh_data)
+            vertices += m.asset.vertex_count;
+
+        constexpr int ticks = 64;
+        double t = 0.0;
+        const double ns = best_ns(5, [&]()
+        {
+            for (int i = 0; i < ticks; ++i)
+                mesh.tick_skinning(inst, t += 1.0 / 60.0);
+        }) / ticks;
+
+        std::printf("skin    %-23s %7.1f us/tick | %7.2f ns/vertex, %8.1f Mvtx/s (%zu vertices)\n",
+                    cfg.skin_path.c_str(), ns * 1e-3,
+                    vertices ? ns / (double)vertices : 0.0,
+                    ns > 0.0 ? (double)vertices * 1e3 / ns : 0.0, vertices);
+    }
+
+    void bench_row_upload(const microbench_config& cfg)
+    {
+        const std::size_t pitch = (std::size_t)cfg.w * sizeof(std::uint32_t);
+        const std::size_t bytes = pitch * cfg.h;
+
+        auto* src = static_cast<std::uint8_t*>(::operator new(bytes, std::align_val_t{ 64 }));
+        auto* dst = static_cast<std::uint8_t*>(::operator new(bytes, std::align_val_t{ 64 }));
+        std::memset(src, 0x5a, bytes);
+        std::memset(dst, 0, bytes);
+
+        const double ns = best_ns(20, [&]()
+        {
+            for (std::uint32_t y = 0; y < cfg.h; ++y)
+                fox::copy_row(dst + y * pitch, src + y * pitch, pitch);
+        });
+        const double memcpy_ns = best_ns(20, [&]() { std::memcpy(dst, src, bytes); });
+
+        std::printf("upload  copy_row %4ux%-4u          %7.3f ms | %7.2f GB/s (memcpy %.2f GB/s)\n",
+                    cfg.w, cfg.h, ns * 1e-6, (double)bytes / ns, (double)bytes / memcpy_ns);
+
+        ::operator delete(src, std::align_val_t{ 64 });
+        ::operator delete(dst, std::align_val_t{ 64 });
+    }
+
+    void bench_fecs_iteration()
+    {
+        constexpr std::uint32_t count = 200000;
+
+        fecs::world w{};
+        w.register_component<Transform>();
+        w.register_component<Material>();
+        w.reserve<Transform, Material>(count);
+        for (std::uint32_t i = 0; i < count; ++i)
+            (void)w.create_entity_with<Transform, Material>(Transform{ matrix::makeTranslation((float)i, 0.f, 0.f) }, Material{});
+
+        volatile float sink = 0.f;
+        const auto report = [&](const char* name, double ns, double bytes_per_entity)
+        {
+            std::printf("fecs    %-23s %7.2f ns/entity | %7.2f GB/s\n",
+                        name, ns / count, (double)count * bytes_per_entity / ns);
+        };
+
+        report("each chunk Transform", best_ns(10, [&]()
+        {
+            float acc = 0.f;
+            w.query<const Transform>().each([&](const Transform* tr, std::size_t n)
+            {
+                for (std::size_t i = 0; i < n; ++i)
+                    acc += tr[i].world(0, 3);
+            });
+            sink = acc;
+        }), sizeof(Transform));
+
+        report("each_entity 2 columns", best_ns(10, [&]()
+        {
+            float acc = 0.f;
+            w.query<const Transform, const Material>().each_entity([&](fecs::entity, const Transform& tr, const Material& m)
+            {
+                acc += tr.world(0, 3) * m.ka;
+            });
+            sink = acc;
+        }), sizeof(Transform) + sizeof(Material));
+
+        (void)sink;
+    }
+
+    bool parse_args(int argc, char** argv, microbench_config& cfg)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char* arg = argv[i];
+            const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            if (!val)
+                return false;
+            ++i;
+
+            if (!std::strcmp(arg, "--res"))
+            {
+                if (std::sscanf(val, "%ux%u", &cfg.w, &cfg.h) != 2 || cfg.w == 0 || cfg.h == 0)
+                    return false;
+            }
+            else if (!std::strcmp(arg, "--frames")) cfg.frames = (std::max)(1u, (std::uint32_t)std::strtoul(val, nullptr, 10));
+            else if (!std::strcmp(arg, "--skin")) cfg.skin_path = val;
+            else return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    microbench_config cfg{};
+    if (!parse_args(argc, argv, cfg))
+    {
+        std::fprintf(stderr, "usage: fox_microbench [--res WxH] [--frames N] [--skin PATH]\n");
+        return 2;
+    }
+
+    std::printf("fox_microbench: FOX_SIMD_LEVEL %s, best raster ISA %s, %ux%u\n",
+                simd_level_name(), raster_isa_name(detect_raster_isa()), cfg.w, cfg.h);
+
+    texture_cache tex{};
+    bench_raster(cfg, tex);
+    bench_vertex_formats(cfg);
+    bench_clear_and_effects(cfg);
+    bench_skinning(cfg);
+    bench_row_upload(cfg);
+    bench_fecs_iteration();
+    return 0;
+}
@@ -20,6 +20,9 @@ public:
 	[[nodiscard]] bool OpenForRead (_In_ const std::string& path);
 	[[nodiscard]] bool OpenForWrite(_In_ const std::string& path);
 
+	// Opens the file read only and maps all of it; GetMappedData() stays valid until Close()
+	[[nodiscard]] bool MapForRead  (_In_ const std::string& path);
+
 	void Close();
 	[[nodiscard]] bool ReadBytes(_Out_writes_bytes_all_(size) void*  dest,
 							 _In_                         size_t size) const;
@@ -34,6 +37,7 @@ public:
 
 	[[nodiscard]] bool          IsOpen     () const;
 	[[nodiscard]] std::uint64_t GetFileSize() const;
+	[[nodiscard]] const std::uint8_t* GetMappedData() const;
 
 private:
 	class Impl;
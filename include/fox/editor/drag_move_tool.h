@@ -50,7 +50,6 @@ namespace fox::editor
         [[nodiscard]] static ray screen_to_world_ray(int mouse_x, int mouse_y, int viewport_w, int viewport_h,
                                                      const matrix& view, const matrix& proj,
                                                      const vec4& fallback_origin) noexcept;
-        [[nodiscard]] static bool ray_sphere_hit(const ray& r, const vec4& center, float radius, float& t_out) noexcept;
         [[nodiscard]] static bool ray_plane_hit(const ray& r, const vec4& plane_point,
             const vec4& plane_normal, vec4& out_hit) noexcept;
 
@@ -2,13 +2,16 @@
 
 #include "game/game_components.h"
 #include "game/render_queue.h"
+#include "game/world_streamer.h"
 #include "fox/scene_paths.h"
 #include "json_loader.h"
+#include "json_document.h"
 #include "optimized/optimized_renderer.h"
 
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <vector>
 
 namespace fox
 {
@@ -41,9 +44,17 @@ namespace fox
             std::function<void(scene_post_processing_settings&)> read_callback,
             std::function<void(const scene_post_processing_settings&)> write_callback);
 
+        // A path ending in .foxscene reads or writes the binary snapshot instead of JSON
         bool save_scene(const scene_save_desc& desc);
         bool load_scene(const scene_load_desc& desc);
 
+        // With streaming enabled, loaded objects are filed under the streamer's cells instead of
+        // spawned, and saves take in the ones streamed out
+        void set_streamer(world_streamer* streamer) noexcept { streamer_ = streamer; }
+
+        // True if the snapshot exists and was written no earlier than the JSON it mirrors
+        [[nodiscard]] static bool snapshot_up_to_date(const std::string& snapshot_path, const std::string& source_path);
+
         [[nodiscard]] const std::string& last_error() const noexcept { return last_error_; }
 
     private:
@@ -54,6 +65,7 @@ namespace fox
             std::string model{};
             bool is_dynamic = false;
             bool visible = true;
+            cull_mode cull = cull_mode::none;
             vec4 position{ 0.f, 0.f, 0.f, 1.f };
             vec4 rotation{ 0.f, 0.f, 0.f, 0.f };
             vec4 scale{ 1.f, 1.f, 1.f, 0.f };
@@ -63,21 +75,31 @@ namespace fox
         void set_error(const std::string& message);
         void clear_error();
         void clear_existing_editor_objects();
+        void collect_records(std::vector<scene_object_record>& out) const;
+        void spawn_records(const std::vector<scene_object_record>& records);
+        [[nodiscard]] static render_queue::static_mesh_desc to_static_desc(const scene_object_record& record);
+        [[nodiscard]] static render_queue::dynamic_mesh_desc to_dynamic_desc(const scene_object_record& record);
+        [[nodiscard]] static scene_object_record to_record(const render_queue::static_mesh_desc& desc);
+        [[nodiscard]] static scene_object_record to_record(const render_queue::dynamic_mesh_desc& desc);
+
+        bool save_snapshot(const scene_save_desc& desc, const std::vector<scene_object_record>& records);
+        bool load_snapshot(const scene_load_desc& desc);
 
         void write_globals(JsonLoader& scene, bool include_globals);
-        void read_globals(const JsonLoader& scene);
+        void read_globals(const JsonValue& scene);
         void write_post_processing(JsonLoader& globals);
-        void read_post_processing(const JsonLoader& globals);
+        void read_post_processing(const JsonValue& globals);
         static void write_colour(JsonLoader& node, const colour& value);
-        static void read_colour(const JsonLoader& node, colour& value);
+        static void read_colour(const JsonValue& node, colour& value);
         static void write_vec4_xy(JsonLoader& node, const vec4& value);
-        static void read_vec4_xy(const JsonLoader& node, vec4& value);
+        static void read_vec4_xy(const JsonValue& node, vec4& value);
 
-        bool parse_scene_object(const JsonLoader& node, scene_object_record& out) const;
-        std::uint64_t parse_u64(const JsonLoader& node, std::uint64_t fallback) const;
+        bool parse_scene_object(const JsonValue& node, scene_object_record& out) const;
+        std::uint64_t parse_u64(const JsonValue& node, std::uint64_t fallback) const;
 
         fecs::world& world_;
         render_queue& queue_;
+        world_streamer* streamer_ = nullptr;
         std::function<void(scene_post_processing_settings&)> read_post_processing_callback_{};
         std::function<void(const scene_post_processing_settings&)> write_post_processing_callback_{};
         std::string last_error_{};
@@ -6,4 +6,10 @@ namespace fox::scene_paths
     {
         return "scene.json";
     }
+
+    // Binary mirror of the default scene, written on every save and preferred at startup
+    constexpr const char* default_snapshot_path() noexcept
+    {
+        return "scene.foxscene";
+    }
 }
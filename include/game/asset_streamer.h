@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace fox
+{
+    // Small pool for blocking loads (imports, decodes) that must stay off the frame. Each submit
+    // hands back a future the owner polls once per frame; threads start with the first submit.
+    class asset_streamer
+    {
+    public:
+        explicit asset_streamer(std::uint32_t thread_count = 2) noexcept;
+        ~asset_streamer();
+
+        asset_streamer(const asset_streamer&)            = delete;
+        asset_streamer& operator=(const asset_streamer&) = delete;
+
+        template<class Fn>
+        [[nodiscard]] std::future<std::invoke_result_t<Fn>> submit(Fn&& fn)
+        {
+            using result_t = std::invoke_result_t<Fn>;
+            auto task = std::make_shared<std::packaged_task<result_t()>>(std::forward<Fn>(fn));
+            std::future<result_t> f = task->get_future();
+            push([task]() { (*task)(); });
+            return f;
+        }
+
+        // Queued or running jobs
+        [[nodiscard]] std::size_t in_flight() const noexcept;
+
+    private:
+        void push(std::function<void()> job);
+        void worker_loop() noexcept;
+
+        std::uint32_t                     thread_count_ = 2;
+        std::vector<std::thread>          threads_{};
+        std::deque<std::function<void()>> jobs_{};
+        std::size_t                       running_ = 0;
+        mutable std::mutex                mtx_{};
+        std::condition_variable           cv_{};
+        bool                              quit_ = false;
+    };
+}
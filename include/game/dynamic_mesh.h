@@ -9,6 +9,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -49,6 +50,12 @@ public:
 
     void tick_skinning(dynamic_mesh_instance& instance, double elapsed_seconds) const;
 
+    // Indexed reference combining the instance's skinned vertices with the shared indices and UVs
+    [[nodiscard]] MeshRefPN instance_mesh_ref(const dynamic_mesh_instance& instance, std::size_t mesh_index) const noexcept;
+
+    // Mesh local AABB of the instance's current pose
+    [[nodiscard]] Bounds instance_bounds(const dynamic_mesh_instance& instance, std::size_t mesh_index) const noexcept;
+
     [[nodiscard]] bool loaded() const noexcept { return loaded_; }
     [[nodiscard]] bool has_animation() const noexcept { return has_animation_; }
 
@@ -61,20 +68,55 @@ public:
 
     [[nodiscard]] bool sample_node_world(matrix& out) const noexcept;
 
-    [[nodiscard]] std::size_t animation_count() const noexcept { return scene_ ? (std::size_t)scene_->mNumAnimations : 0; }
+    [[nodiscard]] std::size_t animation_count() const noexcept { return clips_.size(); }
+
+    // Shared bind pose asset and skinning streams; each instance adds its own vertices
+    [[nodiscard]] std::size_t resident_bytes() const noexcept;
 
 private:
+    // 8 vertices per AVX2 batch; streams are padded to a whole batch
+    static constexpr std::uint32_t kSkinLanes = 8;
+    static constexpr std::uint32_t kSkinGrain = 1024;
+
+    // Bind pose vertex as the skinning loop reads it, eight to a batch: position and normal, then up
+    // to four influences as indices into the mesh's bone palette and weights summing to 255
+    struct skin_vertex
+    {
+        float px = 0.f, py = 0.f, pz = 0.f;
+        float nx = 0.f, ny = 0.f, nz = 1.f;
+        std::uint8_t bone[4]{};
+        std::uint8_t weight[4]{};
+    };
+    static_assert(sizeof(skin_vertex) == 32, "skin_vertex is one 8-float transpose row");
+
+    // Bones a mesh's vertices reference, so indices fit a byte. Unweighted vertices reference the
+    // trailing identity entry with weight 255 so every vertex goes through the same 4-influence blend.
+    static constexpr std::uint32_t kMaxMeshBones = 256;
+
+    struct skin_stream
+    {
+        std::vector<skin_vertex>   vertices{}; // padded to a whole batch
+        std::vector<std::uint32_t> palette{};  // mesh palette entry -> instance palette slot
+
+        std::uint32_t vertex_count = 0;
+    };
+
     struct mesh_data
     {
         MeshAssetPN asset{};
 
-        std::vector<aiVector3D> base_positions{};
-        std::vector<aiVector3D> base_normals{};
-        std::vector<float> base_uvs{};       // 2 floats per vertex (u,v) empty if no UVs
+        const TextureRGBA8* texture = nullptr; // refs are made at spawn, the cache may have trimmed it since
+        Bounds bounds{};                     // bind pose mesh local AABB
 
-        std::vector<triIndices> triangles{};
-        std::vector<vertex_weights> weights{};
-        TextureRef tex_ref{};                // texture for this sub-mesh
+        skin_stream skin{};
+    };
+
+    // Node hierarchy flattened depth first, parents always precede their children
+    struct skin_node
+    {
+        aiMatrix4x4   bind_local{};
+        std::int32_t  parent = -1;
+        std::int32_t  bone = -1;
     };
 
     struct mesh_instance
@@ -83,6 +125,7 @@ private:
         matrix      node_world{};
     };
 
+    // Only held while load runs; everything drawn or animated is copied out and the scene freed
     Assimp::Importer importer_{};
     const aiScene*   scene_ = nullptr;
 
@@ -104,7 +147,33 @@ private:
     std::unordered_map<std::string, std::uint32_t> bone_map_{};
     std::vector<aiMatrix4x4> bone_offsets_{};
 
+    // Clips resampled at load onto a fixed rate grid, so a pose is a blend of two frames swept across
+    // every track instead of a key search per channel. One track per animated node; a frame holds
+    // kTrackComponents rows of track_stride floats: translation xyz, rotation xyzw, scale xyz.
+    struct baked_clip
+    {
+        double duration = 0.0;        // ticks
+        double ticks_per_second = 25.0;
+        double frames_per_tick = 0.0; // frame_count - 1 frames span the duration
+        std::uint32_t frame_count = 0;
+        std::uint32_t track_stride = 0; // track count padded to a whole kSkinLanes batch
+        std::vector<std::int32_t> node_track{}; // per skin node, -1 keeps the bind pose
+        std::vector<float> samples{};
+    };
+
+    static constexpr double        kClipSampleHz = 60.0;
+    static constexpr std::uint32_t kTrackComponents = 10;
+
+    std::vector<skin_node> skin_nodes_{};
+    std::vector<baked_clip> clips_{};
+    std::uint32_t max_track_stride_ = 0;
+    std::uint32_t max_mesh_bones_ = 0;
+
     static matrix to_matrix(const aiMatrix4x4& m);
+    static TextureRef texture_ref(const mesh_data& data) noexcept
+    {
+        return data.texture ? make_texture_ref(*data.texture) : TextureRef{};
+    }
     static void update_bounds(vec4& min_v, vec4& max_v, const vec4& p);
 
     static void gather_instances(
@@ -117,6 +186,35 @@ private:
 
     static void add_weight(vertex_weights& vw, std::uint32_t bone, float weight);
 
+    // Palette rows hold one 3x4 element each for every bone plus the trailing identity slot
+    [[nodiscard]] std::uint32_t palette_stride() const noexcept { return (std::uint32_t)bone_offsets_.size() + 1u; }
+
+    void flatten_nodes(const aiNode* node, std::int32_t parent, std::vector<const aiNode*>& nodes);
+    void build_skin_stream(mesh_data& data, const std::vector<vertex_weights>& weights) const;
+    void bake_clip(const aiAnimation* anim, const std::vector<const aiNode*>& nodes, baked_clip& clip) const;
+    static void sample_clip(const baked_clip& clip, double anim_time, float* pose) noexcept;
+    void update_palette(dynamic_mesh_instance& instance, std::size_t anim_index, double anim_time) const;
+
+    static void skin_range(
+        const skin_stream& s,
+        const float* palette,
+        std::uint32_t stride,
+        MeshAssetPN& dst,
+        std::uint32_t begin,
+        std::uint32_t end) noexcept;
+
+#ifdef USE_SIMD
+    // AVX2 bodies in dynamic_mesh_avx2.cpp
+    static void sample_clip_avx2(const float* a, const float* b, float alpha, std::uint32_t stride, float* pose) noexcept;
+    static void skin_range_avx2(
+        const skin_stream& s,
+        const float* palette,
+        std::uint32_t stride,
+        MeshAssetPN& dst,
+        std::uint32_t begin,
+        std::uint32_t end) noexcept;
+#endif
+
     friend struct dynamic_mesh_instance;
 };
 
@@ -126,19 +224,36 @@ struct dynamic_mesh_instance
     // Current animation clip index
     std::size_t anim_index = 0;
 
-    // Per entity bone transforms
-    std::vector<aiMatrix4x4> bone_transforms{};
+    // Scratch node globals, the sampled clip pose and the SoA bone palette: 12 rows of
+    // palette_stride floats, row r holding element r of every bone's row-major 3x4 skin matrix.
+    // mesh_palette holds the same rows narrowed to the bones of the mesh being skinned.
+    std::vector<aiMatrix4x4> node_globals{};
+    std::vector<float>       track_pose{};
+    std::vector<float>       bone_palette{};
+    std::vector<float>       mesh_palette{};
 
-    // Per entity skinned mesh data
+    // Per entity skinned mesh data, written in place by tick_skinning
     struct mesh_instance_data
     {
-        std::vector<aiVector3D> skinned_positions{};
-        std::vector<aiVector3D> skinned_normals{};
-        MeshAssetPN asset{};  // Per entity render asset
+        MeshAssetPN asset{};  // Per entity unique vertices only, see dynamic_mesh::instance_mesh_ref
+        Bounds      bounds{}; // refreshed after every skin
     };
     std::vector<mesh_instance_data> mesh_data{};
 
+    // Clip and time render_queue last skinned mesh_data at, so a pose that holds is not skinned again
+    std::size_t skinned_index = 0;
+    double      skinned_time  = std::numeric_limits<double>::quiet_NaN();
+
     const dynamic_mesh* parent_mesh = nullptr;
+
+    [[nodiscard]] std::size_t resident_bytes() const noexcept
+    {
+        std::size_t bytes = node_globals.capacity() * sizeof(aiMatrix4x4)
+                          + (track_pose.capacity() + bone_palette.capacity() + mesh_palette.capacity()) * sizeof(float);
+        for (const mesh_instance_data& m : mesh_data)
+            bytes += m.asset.resident_bytes();
+        return bytes;
+    }
 };
 
 #endif // FOXRASTERIZER_DYNAMIC_MESH_H
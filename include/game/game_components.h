@@ -1,9 +1,11 @@
 #pragma once
 
 #include "fmath.h"
+#include "optimized/fecs.h"
 
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <string>
 
 class dynamic_mesh;
@@ -30,6 +32,11 @@ namespace fox
     struct animation_instance_component
     {
         dynamic_mesh_instance* instance = nullptr;
+
+        // Clip and quantized time step the entity's MeshRefPN shows, from its own instance or a
+        // pose render_queue shares between instances; see render_queue::tick_dynamic_animations
+        std::size_t  shown_clip = (std::numeric_limits<std::size_t>::max)();
+        std::int64_t shown_step = 0;
     };
 
     struct dynamic_anim_state
@@ -67,11 +74,21 @@ namespace fox
     };
     struct editor_tag {};
 
-    struct editor_local_component
+    // Transform hierarchy nodes, see transform_hierarchy.h. A node's world is its parent's world
+    // times local; one without transform_parent is a root and its world is local.
+    struct local_transform
     {
         matrix local{};
     };
 
+    struct transform_parent
+    {
+        fecs::entity parent{};
+    };
+
+    // Root that only carries its children, destroyed once the last of them is gone
+    struct transform_group {};
+
     struct editor_object_component
     {
         std::uint64_t object_id = 0;
@@ -7,10 +7,15 @@
 #include "dynamic_mesh.h"
 #include "level_builder_ui.h"
 #include "render_queue.h"
+#include "world_streamer.h"
 #include "fox/scene_io.h"
 #include "fox/editor/drag_move_tool.h"
+#include "optimized/input_log.h"
+#include "optimized/frame_recorder.h"
+#include "optimized/gif_writer.h"
 
 #include <chrono>
+#include <cstdio>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -25,6 +30,16 @@ namespace fox
         const char* title = "FoxGame";
         bool offline = false;
         std::uint32_t clear_rgba = 0;
+        bool low_latency = false;   // pace frames off a waitable swap chain, see gfx_dx11::pace_frame
+        bool world_streaming = false; // load the scene into world_streamer cells around the camera
+        bool compressed_textures = false; // hold textures as bc1 tiles, an eighth of the memory
+        bool quantized_meshes = false;    // hold static mesh vertices as quant_vertex, 16 bytes against 40
+        bool stats_csv = false;           // write frame_stats.csv from the first frame
+        const char* record_input = nullptr; // input_recorder log of the session's input and frame times
+        const char* replay_input = nullptr; // play a recorded log back instead of live input, ending with it
+        const char* offline_output = nullptr; // offline frames go to PREFIX_000000.tga on, see image_sequence_writer
+        const char* offline_gif = nullptr;    // and/or into one looping GIF, see gif_writer
+        std::uint32_t frame_limit = 0;        // frames to render before run returns, 0 for no limit
     };
 
     class game_world
@@ -37,9 +52,21 @@ namespace fox
     private:
         [[nodiscard]] bool is_mouse_safe_for_editing() const noexcept;
         void update_light_cycle(float dt) noexcept;
+        // Respawns the lanterns when their count or spread changed, then flickers them
+        void update_lanterns() noexcept;
         void update_free_camera(float dt) noexcept;
         void update_timing(std::chrono::steady_clock::time_point now) noexcept;
 
+        // frame_stats.csv in the working directory, truncated when recording starts
+        void set_stats_recording(bool enabled) noexcept;
+        void write_stats_row() noexcept;
+
+        // Carries the hard mem_budget of textures and meshes into the texture cache and streamer
+        // budgets and reports tags crossing their budgets
+        void update_memory_budgets() noexcept;
+        [[nodiscard]] std::size_t texture_budget() const noexcept;
+        [[nodiscard]] std::size_t mesh_budget() const noexcept;
+
         [[nodiscard]] scene_io::scene_post_processing_settings post_processing_settings() const noexcept;
         void apply_post_processing_settings(const scene_io::scene_post_processing_settings& settings) noexcept;
 
@@ -50,6 +77,10 @@ namespace fox
         vec4 light_dir_{ 0.f, 1.f, 1.f, 0.f };
 
         texture_cache tex_cache_{};
+        std::size_t texture_budget_bytes_ = 0;   // as set in the UI, before mem_tag::textures' hard budget
+        std::size_t streaming_budget_bytes_ = 0; // likewise against mem_tag::meshes
+        mem_budget_state memory_states_[kMemTagCount]{};
+        std::vector<texture_trim> texture_trims_{};
         std::unordered_map<std::string, std::unique_ptr<static_mesh>> static_mesh_cache_{};
         std::unordered_map<std::string, std::unique_ptr<dynamic_mesh>> dynamic_mesh_cache_{};
 
@@ -66,6 +97,10 @@ namespace fox
         float light_cycle_speed_ = 0.2f;
         bool light_color_override_ = false;
 
+        lantern_settings lanterns_{};
+        lantern_settings spawned_lanterns_{};
+        std::vector<fecs::entity> lantern_entities_{};
+
         float normalize_size_ = 10.f;
 
         std::chrono::steady_clock::time_point start_time_{};
@@ -77,12 +112,35 @@ namespace fox
         std::uint32_t fps_frames_ = 0u;
         bool initialized_ = false;
 
+        input_recorder input_recorder_{};
+        input_player input_player_{};
+        float replay_dt_s_ = 0.f;
+
+        // Where offline frames go, either or both; submit() forwards to whichever is open
+        struct offline_sink
+        {
+            image_sequence_writer frames{};
+            gif_writer            gif{};
+
+            [[nodiscard]] bool is_open() const noexcept { return frames.is_open() || gif.is_open(); }
+            void submit(const std::uint32_t* color, std::uint32_t pitch_pixels) noexcept
+            {
+                if (frames.is_open()) frames.submit(color, pitch_pixels);
+                if (gif.is_open())    gif.submit(color, pitch_pixels);
+            }
+        };
+        offline_sink offline_sink_{};
+
+        std::FILE* stats_csv_ = nullptr;
+        std::uint64_t stats_csv_frame_ = 0; // last frame_index written
+
         std::unique_ptr<render_queue> render_queue_{};
+        std::unique_ptr<world_streamer> world_streamer_{};
         std::unique_ptr<scene_io> scene_io_{};
 
         level_builder_ui level_editor_{};
         editor::drag_move_tool drag_move_tool_{};
-        Transform* camera_target_transform_ = nullptr;
+        const Transform* camera_target_transform_ = nullptr;
         int prev_mouse_x_ = 0;
         int prev_mouse_y_ = 0;
         bool has_prev_mouse_ = false;
@@ -2,6 +2,8 @@
 
 #include "game/game_components.h"
 #include "game/render_queue.h"
+#include "game/world_streamer.h"
+#include "optimized/memory_stats.h"
 #include "texture_cache.h"
 
 #include <cstddef>
@@ -25,12 +27,60 @@ namespace fox
         Light light{};
         vec4 camera_pos{ 0.f, 8.f, 18.f, 1.f };
         std::size_t cached_texture_count = 0;
+        std::size_t texture_resident_bytes = 0;
+        std::size_t streaming_asset_count = 0;
+        optimized_renderer_core::draw_stats draw_stats{};
+        optimized_renderer_core::frame_stats frame_stats{};
+        mem_tag_stats memory[kMemTagCount]{};
+        world_streaming_stats streaming{};
+        bool stats_csv_recording = false;  // a row of frame_stats per frame to frame_stats.csv
+        const char* raster_isa = "";
+        float render_scale = 1.0f;
+    };
+
+    // Point lights game_world scatters over the scene, each a PointLight entity
+    struct lantern_settings
+    {
+        int count = 0;
+        float spread = 40.f;      // radius of the spiral they sit on around the origin
+        float radius = 8.f;
+        float intensity = 1.5f;
+        float flicker = 0.3f;     // 0 holds them steady, which lets an idle frame skip redrawing
     };
 
     struct world_render_settings
     {
         bool textures_enabled = true;
         bool flip_v = true;
+        bool fused_post_effects = true;
+        bool hierarchical_z = true;
+        bool frustum_culling = true;
+        bool occlusion_culling = true;
+        bool cluster_culling = true;
+        bool sort_front_to_back = true;
+        bool wide_raster = true;
+        bool visibility_buffer = false;
+        bool depth_prepass = false;
+        bool mesh_lod = true;
+        bool point_lights = true;
+        lantern_settings lanterns{};
+        bool shadows = true;
+        float shadow_strength = 0.6f;
+        float shadow_distance = 96.f;
+        bool frame_pipelining = false;
+        bool incremental_redraw = true;
+        bool checkerboard = false;
+        bool depth16 = false;
+        optimized_renderer_core::debug_view debug_view = optimized_renderer_core::debug_view::none;
+        int texture_budget_mb = 0;  // 0 keeps every texture at full resolution
+        bool compressed_textures = false;  // textures loaded from now on are held as bc1
+        bool quantized_meshes = false;     // static meshes loaded from now on keep quantized vertices
+        bool dynamic_resolution = false;
+        float render_scale = 1.0f;
+        float target_frame_ms = 16.6f;
+        world_streaming_settings streaming{};
+        int streaming_budget_mb = 0;  // 0 for no mesh budget
+        int memory_budget_mb[kMemTagCount][2]{};  // soft and hard per mem_tag, 0 for none
         optimized_renderer_core::post_process_settings post_process{};
         optimized_renderer_core::rainy_effect_settings rainy_effect{};
         optimized_renderer_core::advanced_effects_settings advanced_effects{};
@@ -70,6 +120,7 @@ namespace fox
         [[nodiscard]] std::size_t object_count() const;
 
     private:
+        void draw_stats_view();
         void draw_create_view();
         void draw_edit_save_view();
         void refresh_asset_lists();
@@ -102,7 +153,6 @@ namespace fox
         std::vector<std::string> runtime_dynamic_assets_{};
         int runtime_static_asset_index_ = -1;
         int runtime_dynamic_asset_index_ = -1;
-        std::vector<render_queue::object_info> runtime_objects_{};
         bool runtime_imgui_wants_mouse_ = false;
 
         world_debug_state debug_state_{};
@@ -1,14 +1,19 @@
 #pragma once
 
+#include "game/asset_streamer.h"
 #include "game/game_components.h"
 #include "optimized/optimized_renderer.h"
 #include "texture_cache.h"
 #include "game/static_mesh.h"
 #include "game/dynamic_mesh.h"
+#include "game/spatial_index.h"
+#include "game/transform_hierarchy.h"
 
 #include <cstddef>
 #include <cstdint>
+#include <future>
 #include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -40,6 +45,7 @@ namespace fox
             colour colour_tint{ 0.45f, 0.5f, 0.55f };
             float ka = 0.75f;
             float kd = 0.75f;
+            cull_mode cull = cull_mode::none;
             object_id forced_id = 0;
         };
 
@@ -54,6 +60,7 @@ namespace fox
             colour colour_tint{ 0.35f, 0.45f, 0.85f };
             float ka = 0.75f;
             float kd = 0.75f;
+            cull_mode cull = cull_mode::none;
             bool anim_enabled = true;
             bool anim_paused = false;
             std::size_t anim_index = 0;
@@ -73,8 +80,14 @@ namespace fox
         static void register_components(fecs::world& world);
 
         object_id add_static_mesh(const static_mesh_desc& desc);
+        // Builds every object's instances straight in their final archetype through one
+        // fecs::world::create_entities call. Assets still streaming get placeholders as in
+        // add_static_mesh; out_ids[i] is 0 where descs[i] could not be spawned.
+        void add_static_meshes(std::span<const static_mesh_desc> descs, bool editor_tagged, std::vector<object_id>& out_ids);
         object_id add_dynamic_mesh(const dynamic_mesh_desc& desc);
         void remove(object_id id);
+        // Destroys the entities of every object in ids at once
+        void remove(std::span<const object_id> ids);
         [[nodiscard]] bool exists(object_id id) const;
 
         [[nodiscard]] Transform get_transform(object_id id) const;
@@ -82,10 +95,17 @@ namespace fox
         bool try_get_static(object_id id, static_mesh_component*& out);
         bool try_get_dynamic(object_id id, dynamic_mesh_component*& out);
         bool try_get_editor_object(object_id id, editor_object_component*& out);
-        void enumerate_objects(std::vector<object_info>& out);
+
+        // Every object sorted by id, kept in step with adds, removes and set_visible rather than
+        // gathered from the world; valid until the next of those
+        [[nodiscard]] const std::vector<object_info>& objects();
+        [[nodiscard]] std::size_t object_count() { return objects().size(); }
+        void enumerate_objects(std::vector<object_info>& out) { out = objects(); }
         bool try_get_pick_radius(object_id id, float& out_radius) const;
         void set_transform(object_id id, const vec4& pos, const vec4& rot, const vec4& scale);
         void set_visible(object_id id, bool visible);
+        [[nodiscard]] cull_mode get_cull(object_id id) const;
+        void set_cull(object_id id, cull_mode cull);
 
         void set_animation_enabled(object_id id, bool enabled);
         void set_animation_paused(object_id id, bool paused);
@@ -95,7 +115,40 @@ namespace fox
         void set_anim_time(object_id id, float anim_time);
         void reset_anim_time(object_id id);
         [[nodiscard]] dynamic_anim_state get_anim_state(object_id id) const;
-        void tick_dynamic_animations(float dt) noexcept;
+        // Skins every playing instance at a rate that falls with its size on screen as seen from eye.
+        // Instances landing on the same clip and quantized time share one skinned pose. A paused pose
+        // that holds is not skinned again, and while no pose changes nothing writes the render
+        // columns, which idle frame detection relies on.
+        void tick_dynamic_animations(float dt, const vec4& eye) noexcept;
+
+        // Once per frame: recomputes world matrices under moved roots and drops roots whose
+        // object is gone; set_transform applies its own move at once
+        void update_transforms() { hierarchy_.update(world_); sync_pick_index(); }
+        [[nodiscard]] const transform_hierarchy& hierarchy() const noexcept { return hierarchy_; }
+
+        // Pick sphere of every visible object keyed by object_id, kept current by
+        // update_transforms and set_transform; what editor picking ray casts against
+        [[nodiscard]] spatial_index& pick_index() noexcept { return pick_index_; }
+
+        // Imports meshes on background threads. An object added before its asset is ready shows a
+        // cube over its normalized bounds until poll_streaming swaps the real instances in.
+        void set_async_loading(bool enabled) noexcept { async_loading_ = enabled; }
+        [[nodiscard]] bool async_loading() const noexcept { return async_loading_; }
+
+        // Static meshes loaded from now on keep quantized vertices, see static_mesh::load
+        void set_quantized_meshes(bool enabled) noexcept { quantized_meshes_ = enabled; }
+        [[nodiscard]] bool quantized_meshes() const noexcept { return quantized_meshes_; }
+
+        // Once per frame on the main thread; never waits on a load
+        void poll_streaming();
+        [[nodiscard]] std::size_t pending_assets() const noexcept { return pending_static_.size() + pending_dynamic_.size(); }
+
+        // Cached meshes plus the skinned vertices of every animation instance
+        [[nodiscard]] std::size_t mesh_bytes() const;
+
+        // Frees every cached mesh no entity is built from, with the poses shared out of it, and
+        // returns the bytes freed. A frame in flight may still read their vertices; wait on it first.
+        std::size_t release_unused_meshes();
 
         [[nodiscard]] std::vector<fecs::entity> entities(object_id id) const;
         [[nodiscard]] object_id next_object_id() const noexcept { return next_object_id_; }
@@ -110,13 +163,45 @@ namespace fox
             const vec4& bounds_min,
             const vec4& bounds_max) const noexcept;
         static float clamp_scale_min(float v) noexcept;
+        bool normalized_pick_radius(const vec4& bmin, const vec4& bmax, const vec4& scale, float& out_radius) const noexcept;
+        [[nodiscard]] spatial_index::sphere make_pick_sphere(const vec4& pos, const vec4& scale, const vec4* bmin, const vec4* bmax) const noexcept;
+        void sync_pick_index();
 
         static_mesh* get_static_mesh(const std::string& path);
         dynamic_mesh* get_dynamic_mesh(const std::string& path);
+        [[nodiscard]] static_mesh* find_static_mesh(const std::string& path) const;
+        [[nodiscard]] dynamic_mesh* find_dynamic_mesh(const std::string& path) const;
+
+        // Starts the import unless the path is cached or already loading; false for an empty path
+        bool request_static_mesh(const std::string& path);
+        bool request_dynamic_mesh(const std::string& path);
+
+        template<class Desc>
+        object_id add_placeholder(const Desc& desc, bool is_dynamic);
+
+        // The object index: entities and object_info of every object by id, written by the add and
+        // remove paths. Entities destroyed behind the queue's back (scene clears) leave a dead entry
+        // that lookups pass over and objects() sweeps out once the world has changed; an object
+        // counts as gone once any of its entities is.
+        void index_object(object_id id, std::vector<fecs::entity> ents, object_info info);
+        void unindex_object(object_id id);
+        [[nodiscard]] bool all_alive(const std::vector<fecs::entity>& ents) const noexcept;
+        [[nodiscard]] const std::vector<fecs::entity>& object_entities(object_id id) const;
+        // Reads through the const world, so a lookup stamps no write tick; the non-const overload
+        // is for callers that modify the component
+        template<class Component>
+        [[nodiscard]] const Component* first_component(object_id id) const;
+        template<class Component>
+        [[nodiscard]] Component* first_component(object_id id);
+        // fn(entity, editor_object_component&, dynamic_mesh_component&) for each skinned entity of id
+        template<class Fn>
+        void each_dynamic_entity(object_id id, Fn&& fn);
 
         object_id resolve_id(object_id forced_id);
         static std::string make_default_name(const std::string& path, object_id id);
-        void apply_world_to_entities(object_id id, const matrix& base_world) const;
+        // Root of an object's entities, placed at its normalized base world
+        fecs::entity add_root(const matrix& base_world);
+        void apply_world_to_entities(object_id id, const matrix& base_world);
 
         fecs::world& world_;
         std::unordered_map<std::string, std::unique_ptr<static_mesh>>& static_cache_;
@@ -124,5 +209,65 @@ namespace fox
         texture_cache* tex_cache_ = nullptr;
         float normalize_size_ = 10.f;
         object_id next_object_id_ = 1;
+
+        // Objects waiting on an import, rebuilt from their desc with the placeholder's edits applied
+        struct pending_object
+        {
+            object_id id = 0;
+            bool is_dynamic = false;
+            static_mesh_desc static_desc{};
+            dynamic_mesh_desc dynamic_desc{};
+        };
+
+        bool async_loading_ = false;
+        bool quantized_meshes_ = false;
+        std::unordered_map<std::string, std::future<std::unique_ptr<static_mesh>>> pending_static_{};
+        std::unordered_map<std::string, std::future<std::unique_ptr<dynamic_mesh>>> pending_dynamic_{};
+        std::vector<pending_object> pending_objects_{};
+        MeshAssetPN placeholder_asset_{};
+        Bounds placeholder_bounds_{};
+        asset_streamer streamer_{};
+        transform_hierarchy hierarchy_{};
+
+        // Poses shared by two or more instances, kept across ticks so a group moving on to its next
+        // pose re-skins the same buffers; a pose held by one instance stays in its own buffers
+        struct pose_key
+        {
+            const dynamic_mesh* mesh = nullptr;
+            std::size_t clip = 0;
+            std::int64_t step = 0; // skin time in kPoseQuantumSeconds units
+            bool operator==(const pose_key&) const = default;
+        };
+        struct shared_pose
+        {
+            pose_key key{};
+            dynamic_mesh_instance instance{};
+            bool claimed = false;
+        };
+        struct pose_job
+        {
+            pose_key key{};
+            dynamic_mesh_instance* own = nullptr;
+            const dynamic_mesh_instance* shown = nullptr;
+            MeshRefPN* mesh_ref = nullptr;
+            Bounds* bounds = nullptr;
+        };
+        struct skin_task
+        {
+            pose_key key{};
+            dynamic_mesh_instance* target = nullptr;
+        };
+        std::vector<std::unique_ptr<shared_pose>> shared_poses_{};
+        std::vector<pose_job> pose_jobs_{};
+        std::vector<skin_task> skin_tasks_{};
+
+        static constexpr std::uint64_t kStalePickVersion = ~std::uint64_t{ 0 };
+        std::unordered_map<object_id, std::vector<fecs::entity>> object_entities_{};
+        std::vector<object_info> object_list_{}; // sorted by id
+        std::uint64_t object_list_version_ = kStalePickVersion;
+
+        spatial_index pick_index_{};
+        std::future<spatial_index::tree> pick_rebuild_{};
+        std::uint64_t pick_version_ = kStalePickVersion;
     };
 }
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "fmath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fox
+{
+    // Bounding volume hierarchy over keyed spheres, shared by editor picking and scene queries.
+    // Moving an item only refits the boxes above it; adding or removing one puts it on a short
+    // linear list until the next rebuild. A rebuild works from a snapshot, so build() can run on
+    // another thread and adopt() swap the result in while the index keeps changing.
+    class spatial_index
+    {
+    public:
+        using key_type = std::uint64_t;
+
+        struct sphere
+        {
+            vec4  center{ 0.f, 0.f, 0.f, 1.f };
+            float radius = 0.f;
+        };
+
+        struct snapshot
+        {
+            std::vector<std::uint32_t> slots{};
+            std::vector<sphere>        spheres{};
+            std::uint64_t              structure = 0;
+        };
+
+        struct tree
+        {
+            // Leaf when count > 0: slots[first, first + count); otherwise children first, first + 1
+            struct node
+            {
+                float         min[3]{};
+                std::uint32_t first = 0;
+                float         max[3]{};
+                std::uint32_t count = 0;
+            };
+
+            std::vector<node>          nodes{};
+            std::vector<std::uint32_t> slots{};
+            std::uint64_t              structure = 0;
+        };
+
+    public:
+        void set(key_type key, const sphere& s);
+        void erase(key_type key);
+        void clear() noexcept;
+
+        [[nodiscard]] bool contains(key_type key) const noexcept { return slot_of_.count(key) != 0; }
+        [[nodiscard]] std::size_t size() const noexcept { return slot_of_.size(); }
+        void keys(std::vector<key_type>& out) const;
+
+        // Items were added or removed since the tree was built
+        [[nodiscard]] bool wants_rebuild() const noexcept { return tree_.structure != structure_; }
+        [[nodiscard]] snapshot take_snapshot() const;
+        [[nodiscard]] static tree build(snapshot snap);
+        void adopt(tree t);
+        void rebuild() { adopt(build(take_snapshot())); }
+
+        // Node boxes after moves; the queries refit first when they have to
+        void refit();
+
+        // Every sphere the ray enters, fn(key, t) with the entry distance (exit when inside).
+        // dir need not be normalized, t is in units of it.
+        template<class Fn>
+        void raycast(const vec4& origin, const vec4& dir, Fn&& fn)
+        {
+            if (refit_pending_)
+                refit();
+
+            const float inv[3] = { safe_inverse(dir.x), safe_inverse(dir.y), safe_inverse(dir.z) };
+            const auto node_hit = [&](const tree::node& n) noexcept
+            {
+                float t0 = 0.f;
+                float t1 = INFINITY;
+                const float o[3] = { origin.x, origin.y, origin.z };
+                for (int a = 0; a < 3; ++a)
+                {
+                    float near_t = (n.min[a] - o[a]) * inv[a];
+                    float far_t = (n.max[a] - o[a]) * inv[a];
+                    if (near_t > far_t)
+                        std::swap(near_t, far_t);
+                    t0 = (std::max)(t0, near_t);
+                    t1 = (std::min)(t1, far_t);
+                }
+                return t0 <= t1;
+            };
+
+            const auto visit = [&](const std::uint32_t slot)
+            {
+                const item& it = items_[slot];
+                float t = 0.f;
+                if (it.live && ray_sphere(origin, dir, it.s, t))
+                    fn(it.key, t);
+            };
+            traverse(node_hit, visit);
+        }
+
+        // Every sphere not fully behind one of the planes (n.x, n.y, n.z, d), inside: n.p + d >= 0
+        template<class Fn>
+        void query_frustum(const vec4* planes, const std::size_t plane_count, Fn&& fn)
+        {
+            if (refit_pending_)
+                refit();
+
+            const auto node_hit = [&](const tree::node& n) noexcept
+            {
+                for (std::size_t i = 0; i < plane_count; ++i)
+                {
+                    const vec4& p = planes[i];
+                    const float x = p.x >= 0.f ? n.max[0] : n.min[0];
+                    const float y = p.y >= 0.f ? n.max[1] : n.min[1];
+                    const float z = p.z >= 0.f ? n.max[2] : n.min[2];
+                    if (p.x * x + p.y * y + p.z * z + p.w < 0.f)
+                        return false;
+                }
+                return true;
+            };
+
+            const auto visit = [&](const std::uint32_t slot)
+            {
+                const item& it = items_[slot];
+                if (!it.live)
+                    return;
+                for (std::size_t i = 0; i < plane_count; ++i)
+                {
+                    const vec4& p = planes[i];
+                    if (p.x * it.s.center.x + p.y * it.s.center.y + p.z * it.s.center.z + p.w < -it.s.radius)
+                        return;
+                }
+                fn(it.key);
+            };
+            traverse(node_hit, visit);
+        }
+
+    private:
+        struct item
+        {
+            key_type key = 0;
+            sphere   s{};
+            bool     live = false;
+            bool     in_tree = false;
+        };
+
+        static constexpr std::uint32_t kLeafItems = 4;
+        static constexpr int kMaxDepth = 64;
+
+        static float safe_inverse(float v) noexcept
+        {
+            return (std::fabs(v) > 1e-12f) ? 1.f / v : (v < 0.f ? -1e30f : 1e30f);
+        }
+
+        static bool ray_sphere(const vec4& o, const vec4& d, const sphere& s, float& t_out) noexcept
+        {
+            const float ox = o.x - s.center.x, oy = o.y - s.center.y, oz = o.z - s.center.z;
+            const float a = d.x * d.x + d.y * d.y + d.z * d.z;
+            const float b = 2.f * (ox * d.x + oy * d.y + oz * d.z);
+            const float c = ox * ox + oy * oy + oz * oz - s.radius * s.radius;
+
+            const float disc = b * b - 4.f * a * c;
+            if (disc < 0.f || a <= 0.f)
+                return false;
+
+            const float sq = std::sqrt(disc);
+            const float inv_2a = 1.f / (2.f * a);
+            float t0 = (-b - sq) * inv_2a;
+            float t1 = (-b + sq) * inv_2a;
+            if (t0 > t1)
+                std::swap(t0, t1);
+            if (t1 < 0.f)
+                return false;
+
+            t_out = (t0 >= 0.f) ? t0 : t1;
+            return true;
+        }
+
+        template<class NodeHit, class Visit>
+        void traverse(NodeHit&& node_hit, Visit&& visit) const
+        {
+            if (!tree_.nodes.empty())
+            {
+                std::uint32_t stack[kMaxDepth * 2];
+                int top = 0;
+                stack[top++] = 0;
+                while (top > 0)
+                {
+                    const tree::node& n = tree_.nodes[stack[--top]];
+                    if (n.min[0] > n.max[0] || !node_hit(n)) // emptied by erases
+                        continue;
+                    if (n.count > 0)
+                    {
+                        for (std::uint32_t i = 0; i < n.count; ++i)
+                            visit(tree_.slots[n.first + i]);
+                        continue;
+                    }
+                    stack[top++] = n.first;
+                    stack[top++] = n.first + 1;
+                }
+            }
+
+            for (const std::uint32_t slot : loose_)
+                visit(slot);
+        }
+
+        [[nodiscard]] std::uint32_t new_slot();
+
+    private:
+        std::vector<item> items_{};
+        std::unordered_map<key_type, std::uint32_t> slot_of_{};
+        std::vector<std::uint32_t> free_{};         // reusable now
+        std::vector<std::uint32_t> pending_free_{}; // erased while the tree still points at them
+        std::vector<std::uint32_t> loose_{};        // live, not in the tree yet
+        tree tree_{};
+        std::uint64_t structure_ = 0;
+        bool refit_pending_ = false;
+    };
+}
@@ -3,17 +3,23 @@
 
 #include "optimized/optimized_renderer.h"
 #include "texture_cache.h"
+#include "file_system.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 
 #include <cstddef>
+#include <string>
 #include <vector>
 
+// Imports a glb through Assimp and bakes the result next to it as <path>.foxmesh. Later loads map the
+// bake instead, so every MeshRefPN points straight into the file and nothing is parsed or rebuilt.
 class static_mesh
 {
 public:
-    bool load(const char* path, texture_cache* tex_cache = nullptr);
+    // quantize stores every level as a quant_stream, 16 bytes a vertex; a bake in the other layout
+    // is imported again and replaced
+    bool load(const char* path, texture_cache* tex_cache = nullptr, bool quantize = false);
     void build_instances(fecs::world& w, const matrix& base_world, const colour& col, float ka, float kd);
     void build_instances(
         fecs::world& w,
@@ -30,6 +36,25 @@ public:
         float kd,
         std::vector<fecs::entity>& out_entities,
         std::vector<matrix>& out_locals);
+    // One instanced entity per submesh, drawn at base_worlds[i] * node_world for every placement
+    void build_instanced(
+        fecs::world& w,
+        const std::vector<matrix>& base_worlds,
+        const colour& col,
+        float ka,
+        float kd,
+        std::vector<fecs::entity>& out_entities);
+
+    // What build_instances spawns each instance with, for callers that create the rows in bulk
+    struct instance_row
+    {
+        MeshRefPN ref{};
+        Bounds bounds{};
+        TextureRef tex{};
+        matrix world{};                     // base_world * local
+        matrix local{};                     // node world inside the asset
+    };
+    void gather_instance_rows(const matrix& base_world, std::vector<instance_row>& out) const;
 
     [[nodiscard]] bool loaded() const noexcept { return loaded_; }
     [[nodiscard]] const vec4& bounds_min() const noexcept { return bounds_min_; }
@@ -39,15 +64,33 @@ public:
     [[nodiscard]] std::size_t node_count() const noexcept { return node_count_; }
     [[nodiscard]] bool sample_node_world(matrix& out) const noexcept;
 
+    // Vertex and index streams of every mesh and its LODs, in the heap or the mapped bake
+    [[nodiscard]] std::size_t resident_bytes() const noexcept;
+
 private:
+    enum class texture_source : std::uint32_t { none, file, embedded };
+
     struct mesh_data
     {
-        MeshAssetPN asset{};
+        MeshAssetPN asset{};                // indexed, cache optimized; empty when loaded from a bake
+        std::vector<MeshAssetPN> lod_assets{};  // simplified levels, finest first
+        std::vector<MeshRefPN> lod_refs{};
+        MeshRefPN ref{};                    // asset plus its LOD chain, what entities are spawned with
+        const TextureRGBA8* texture = nullptr; // refs are made at spawn, the cache may have trimmed it since
+        Bounds bounds{};                    // mesh local AABB, and the clusters of ref
+        std::vector<mesh_cluster> clusters{}; // when imported; a baked load points bounds into the mapping
+
+        // Where texture came from, kept so the bake can resolve it again
+        texture_source tex_source = texture_source::none;
+        std::string tex_key{};              // file path, or cache key of an embedded image
+        const std::uint8_t* tex_data = nullptr; // compressed embedded image, in the scene or the mapping
+        std::size_t tex_size = 0;
+
+        // Load time staging, released once the asset is built
         std::vector<vec4> positions{};
         std::vector<vec4> normals{};
         std::vector<float> uvs{};           // 2 floats per vertex (u,v), empty if no UVs
         std::vector<triIndices> triangles{};
-        TextureRef tex_ref{};               // texture for this sub-mesh
     };
 
     struct mesh_instance
@@ -58,6 +101,7 @@ private:
 
     Assimp::Importer importer_{};
     const aiScene* scene_ = nullptr;
+    FileSystem baked_file_{};               // mapping the mesh arrays live in after a baked load
     std::vector<mesh_data> meshes_{};
     std::vector<mesh_instance> instances_{};
     vec4 bounds_min_{};
@@ -65,9 +109,18 @@ private:
     bool loaded_ = false;
     std::size_t node_count_ = 0;
 
+    bool load_baked(const std::string& baked_path, const char* source_path, texture_cache* tex_cache, bool quantize);
+    bool write_baked(const std::string& baked_path, const char* source_path) const;
+    void compute_bounds();
+
     static matrix to_matrix(const aiMatrix4x4& m);
+    void resolve_textures(texture_cache* tex_cache);
+    static TextureRef texture_ref(const mesh_data& data) noexcept;
     static void update_bounds(vec4& min_v, vec4& max_v, const vec4& p);
-    static void build_asset_from_buffers(mesh_data& data);
+    static void build_lods(mesh_data& data);
+    static void bind_clusters(mesh_data& data, const mesh_cluster* clusters, std::uint32_t count) noexcept;
+    static void quantize_levels(mesh_data& data);
+    static void build_asset_from_buffers(mesh_data& data, bool quantize);
     static void gather_instances(
         const aiNode* node,
         const aiMatrix4x4& parent,
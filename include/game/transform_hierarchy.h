@@ -0,0 +1,53 @@
+#pragma once
+
+#include "game/game_components.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace fox
+{
+    // Keeps Transform::world of every local_transform node in step with its parent. Nodes are
+    // held sorted by depth in parallel arrays, so one forward pass sees each parent before its
+    // children; only subtrees under a node marked since the last update are recomputed.
+    // The order is rebuilt when the world's structure changes, which is also when transform_group
+    // roots left without children are destroyed.
+    class transform_hierarchy
+    {
+    public:
+        static void register_components(fecs::world& world);
+
+        // Writes the node's local_transform and marks its subtree for the next update. Locals
+        // written straight to the component need mark_dirty to be seen.
+        void set_local(fecs::world& world, fecs::entity e, const matrix& local);
+        void mark_dirty(fecs::entity e);
+
+        void update(fecs::world& world);
+
+        // Nodes whose world matrix the last update rewrote, for caches derived from it
+        [[nodiscard]] std::span<const fecs::entity> changed() const noexcept { return changed_; }
+        [[nodiscard]] std::size_t node_count() const noexcept { return entity_.size(); }
+
+    private:
+        static constexpr std::uint32_t NO_PARENT = (std::numeric_limits<std::uint32_t>::max)();
+
+        void rebuild(fecs::world& world);
+        [[nodiscard]] std::uint32_t slot_of(fecs::entity e) const noexcept;
+
+    private:
+        // Depth order, parents first
+        std::vector<fecs::entity>  entity_{};
+        std::vector<std::uint32_t> parent_{}; // parent's slot or NO_PARENT
+        std::vector<matrix>        local_{};
+        std::vector<matrix>        world_{};
+        std::vector<std::uint8_t>  dirty_{};
+
+        std::vector<std::uint32_t> slot_by_index_{}; // entity index -> slot
+        std::vector<fecs::entity>  marked_{};        // marked since the last update
+        std::vector<fecs::entity>  changed_{};
+        std::uint64_t seen_version_ = (std::numeric_limits<std::uint64_t>::max)();
+    };
+}
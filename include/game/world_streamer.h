@@ -0,0 +1,123 @@
+#pragma once
+
+#include "game/render_queue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace fox
+{
+    struct world_streaming_settings
+    {
+        bool enabled = false;
+        float cell_size = 64.f;             // along x and z; a grid keeps its size until it is emptied
+        float load_radius = 160.f;          // from the eye to the nearest point of a cell
+        float unload_radius = 224.f;        // past load_radius, so a camera on a cell border does not thrash
+        std::size_t mesh_budget_bytes = 0;  // 0 for no limit; over it the farthest cells go first
+        std::uint32_t max_cell_loads = 2;   // per update, to spread the spawn cost over frames
+    };
+
+    struct world_streaming_stats
+    {
+        std::uint32_t cells = 0;
+        std::uint32_t loaded_cells = 0;
+        std::size_t resident_objects = 0;
+        std::size_t streamed_out_objects = 0;
+        std::uint64_t cell_loads = 0;
+        std::uint64_t cell_unloads = 0;
+        std::uint64_t budget_unloads = 0;  // of cell_unloads, the ones over the mesh budget
+        std::size_t released_bytes = 0;    // mesh memory freed since the level loaded
+    };
+
+    // Splits level objects into a grid of cells on the ground plane and keeps only the cells around
+    // the eye spawned. A cell loads through the render queue's async path, so its meshes import in
+    // the background behind placeholders; one that unloads keeps its objects as descs, edits and all,
+    // and meshes nothing else is built from are freed. Textures stay in texture_cache, whose budget
+    // trims them.
+    class world_streamer
+    {
+    public:
+        world_streamer(fecs::world& world, render_queue& queue);
+
+        [[nodiscard]] const world_streaming_settings& settings() const noexcept { return settings_; }
+        [[nodiscard]] bool enabled() const noexcept { return settings_.enabled; }
+        // Turning streaming on takes every scene object already spawned into the grid
+        void set_settings(const world_streaming_settings& settings);
+
+        // Run before meshes are freed, to wait out a frame that may still read them
+        void set_release_fence(std::function<void()> fence) { release_fence_ = std::move(fence); }
+
+        // Drops every cell without touching the world, as when a scene load clears the editor objects
+        void clear();
+
+        // Files an object under its cell for update to spawn; returns its id, assigned if forced_id is 0
+        render_queue::object_id add(const render_queue::static_mesh_desc& desc);
+        render_queue::object_id add(const render_queue::dynamic_mesh_desc& desc);
+
+        // Once per frame before render_queue::poll_streaming. While disabled, only loads what is left.
+        void update(const vec4& eye);
+
+        // Objects of the cells not spawned now, for saving a scene whole
+        void collect_unloaded(std::vector<render_queue::static_mesh_desc>& static_out,
+                              std::vector<render_queue::dynamic_mesh_desc>& dynamic_out) const;
+
+        [[nodiscard]] world_streaming_stats stats() const noexcept;
+
+    private:
+        using cell_key = std::uint64_t;
+
+        struct streamed_object
+        {
+            render_queue::object_id id = 0;
+            bool is_dynamic = false;
+            render_queue::static_mesh_desc static_desc{};
+            render_queue::dynamic_mesh_desc dynamic_desc{};
+
+            [[nodiscard]] const vec4& position() const noexcept { return is_dynamic ? dynamic_desc.position : static_desc.position; }
+        };
+
+        struct cell
+        {
+            std::int32_t ix = 0;
+            std::int32_t iz = 0;
+            bool loaded = false;
+            std::vector<streamed_object> objects{};
+        };
+
+        [[nodiscard]] cell_key key_of(const vec4& position) const noexcept;
+        [[nodiscard]] float distance_to(const cell& c, const vec4& eye) const noexcept;
+        cell& cell_at(cell_key key);
+        void begin_grid() noexcept;
+        render_queue::object_id add(streamed_object&& object);
+
+        void spawn(const std::vector<streamed_object>& objects);
+        void load_cell(cell& c);
+        // Refreshes the descs of every object in cells from the world, re-files the ones moved into
+        // another cell and destroys the rest; cells are all loaded
+        void unload_cells(const std::vector<cell*>& cells);
+        // Takes the current state of the live objects whose ids are keys, erasing the ids not found
+        void snapshot(std::unordered_map<render_queue::object_id, streamed_object*>& wanted) const;
+        void release_meshes();
+        void adopt_live_objects();
+
+        fecs::world& world_;
+        render_queue& queue_;
+        world_streaming_settings settings_{};
+        std::function<void()> release_fence_{};
+        std::unordered_map<cell_key, cell> cells_{};
+        float grid_size_ = 64.f;
+        // After going over the mesh budget, cells this far or farther stay out until the eye leaves
+        // budget_eye_cell_, so the cell that broke it does not load again the next frame
+        float budget_radius_ = (std::numeric_limits<float>::max)();
+        cell_key budget_eye_cell_ = 0;
+
+        std::uint64_t cell_loads_ = 0;
+        std::uint64_t cell_unloads_ = 0;
+        std::uint64_t budget_unloads_ = 0;
+        std::size_t released_bytes_ = 0;
+    };
+}
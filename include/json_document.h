@@ -0,0 +1,126 @@
+#ifndef DIRECTX12_JSON_DOCUMENT_H
+#define DIRECTX12_JSON_DOCUMENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Read only JSON parsed in one pass over a whole-file buffer. Keys and values are views into that
+// buffer (escapes are decoded in place), nodes come from block arenas, and numbers are only
+// converted when asked for. JsonLoader keeps its mutable tree API on top of this.
+
+class JsonValue;
+
+class JsonDocument
+{
+public:
+    enum class Kind : std::uint8_t { Null, Object, Array, String, Literal };
+
+    struct Node
+    {
+        std::string_view key{};
+        std::string_view text{};      // string contents or the raw literal token
+        const Node*      firstChild = nullptr;
+        const Node*      next       = nullptr;
+        std::uint32_t    childCount = 0;
+        Kind             kind       = Kind::Null;
+    };
+
+public:
+     JsonDocument() = default;
+    ~JsonDocument() = default;
+
+    JsonDocument(const JsonDocument&)            = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+
+    // Reads the whole file and parses it; false if it is missing or malformed
+    [[nodiscard]] bool Load(const std::string& filePath);
+
+    // Takes the buffer over, views stay valid for the document's lifetime
+    [[nodiscard]] bool Parse(std::string buffer);
+
+    [[nodiscard]] JsonValue Root() const noexcept;
+    [[nodiscard]] std::size_t NodeCount() const noexcept { return m_nodeCount; }
+
+    void Clear() noexcept;
+
+private:
+    static constexpr std::size_t kNodesPerBlock = 1024;
+    static constexpr int         kMaxDepth      = 256;
+
+    Node* AllocateNode();
+    [[nodiscard]] bool ParseValue(Node& node, int depth);
+    [[nodiscard]] bool ParseObject(Node& node, int depth);
+    [[nodiscard]] bool ParseArray(Node& node, int depth);
+    [[nodiscard]] bool ParseString(std::string_view& out);
+    [[nodiscard]] bool ParseLiteral(std::string_view& out);
+    void SkipWhitespace() noexcept;
+
+private:
+    std::string m_buffer{};
+    std::vector<std::unique_ptr<Node[]>> m_blocks{};
+    std::size_t m_blockUsed = kNodesPerBlock;
+    std::size_t m_nodeCount = 0;
+    const Node* m_root = nullptr;
+
+    // Parse cursor
+    char* m_cur = nullptr;
+    char* m_end = nullptr;
+};
+
+// Handle to a node of a JsonDocument; missing keys give an invalid value whose accessors return
+// their defaults, so lookups chain the way JsonLoader's do
+class JsonValue
+{
+public:
+    using Member = std::pair<std::string_view, JsonValue>;
+
+    class Iterator
+    {
+    public:
+        explicit Iterator(const JsonDocument::Node* node) noexcept : m_node(node) {}
+
+        Member operator*() const noexcept { return { m_node->key, JsonValue(m_node) }; }
+        Iterator& operator++() noexcept { m_node = m_node->next; return *this; }
+        bool operator==(const Iterator& o) const noexcept { return m_node == o.m_node; }
+        bool operator!=(const Iterator& o) const noexcept { return m_node != o.m_node; }
+
+    private:
+        const JsonDocument::Node* m_node = nullptr;
+    };
+
+public:
+    JsonValue() = default;
+    explicit JsonValue(const JsonDocument::Node* node) noexcept : m_node(node) {}
+
+    // Linear over the members, first match wins
+    [[nodiscard]] JsonValue operator[](std::string_view key) const noexcept;
+
+    [[nodiscard]] Iterator begin() const noexcept { return Iterator(m_node ? m_node->firstChild : nullptr); }
+    [[nodiscard]] Iterator end()   const noexcept { return Iterator(nullptr); }
+
+    [[nodiscard]] bool IsValid()  const noexcept { return m_node && m_node->kind != JsonDocument::Kind::Null; }
+    [[nodiscard]] bool IsObject() const noexcept { return m_node && m_node->kind == JsonDocument::Kind::Object; }
+    [[nodiscard]] bool IsArray()  const noexcept { return m_node && m_node->kind == JsonDocument::Kind::Array; }
+    [[nodiscard]] std::size_t Size() const noexcept { return m_node ? m_node->childCount : 0; }
+
+    [[nodiscard]] std::string_view GetView() const noexcept { return m_node ? m_node->text : std::string_view{}; }
+    [[nodiscard]] std::string      GetString() const { return std::string(GetView()); }
+
+    //~ Typed access with optional defaults, converted on every call
+    [[nodiscard]] float         AsFloat (float         defaultValue = 0.0f)  const noexcept;
+    [[nodiscard]] double        AsDouble(double        defaultValue = 0.0)   const noexcept;
+    [[nodiscard]] int           AsInt   (int           defaultValue = 0)     const noexcept;
+    [[nodiscard]] std::uint32_t AsUInt  (std::uint32_t defaultValue = 0)     const noexcept;
+    [[nodiscard]] std::uint64_t AsUInt64(std::uint64_t defaultValue = 0)     const noexcept;
+    [[nodiscard]] bool          AsBool  (bool          defaultValue = false) const noexcept;
+
+private:
+    const JsonDocument::Node* m_node = nullptr;
+};
+
+#endif //DIRECTX12_JSON_DOCUMENT_H
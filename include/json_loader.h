@@ -7,7 +7,10 @@
 #include <cstdint>
 
 #include "file_system.h"
+#include "json_document.h"
 
+// Mutable tree for building and saving JSON. Loading goes through JsonDocument and copies the
+// result in; read only paths that care about load time can use JsonDocument directly.
 class JsonLoader
 {
 public:
@@ -96,6 +99,7 @@ public:
     //~ Serialization helpers
     std::string ToFormattedString(int indent = 0) const;
     void        FromStream(std::istream& input);
+    void        FromDocument(const JsonValue& value);
 
     //~ Typed access with optional defaults
     [[nodiscard]] float AsFloat(float defaultValue = 0.0f)   const;
@@ -112,10 +116,6 @@ public:
 
 private:
     void        Serialize(std::ostream& output, int indent) const;
-    void        ParseObject(std::istream& input);
-    static void SkipWhitespace(std::istream& input);
-    static bool ConsumeChar(std::istream& input, char expected);
-    static std::string ReadQuotedString(std::istream& input);
     static std::string EscapeString(const std::string& s);
 
 private:
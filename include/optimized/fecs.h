@@ -16,6 +16,13 @@
 #include <functional>
 #include <type_traits>
 #include <cstring>
+#include <atomic>
+#include <memory>
+#include <tuple>
+#include <mutex>
+#include <thread>
+
+#include "memory_stats.h"
 
 namespace fecs
 {
@@ -257,12 +264,20 @@ namespace fecs
 
 #pragma region TABLE_STORAGE_SOA
 
+    // Rows of a table live in fixed size chunks: every column keeps chunk k's rows
+    // [k * chunk_rows, (k + 1) * chunk_rows) in one allocation, so growing never moves a row and
+    // a chunk is one contiguous block per component. chunk_shift is set by the owning table.
+    inline constexpr std::size_t CHUNK_BYTES    = 16u * 1024u;
+    inline constexpr std::size_t MAX_CHUNK_ROWS = 4096u;
+
     struct column
     {
         component_info info{};
-        std::byte* data{ nullptr };
+        std::vector<std::byte*> chunks{};
         std::size_t size{ 0 };
         std::size_t capacity{ 0 };
+        std::uint32_t chunk_shift{ 0u };    // log2 of the rows per chunk
+        std::uint64_t write_tick{ 0u };     // storage tick of the last write access, see table
 
         column() noexcept = default;
         ~column() noexcept { clear_and_free(); }
@@ -278,45 +293,49 @@ namespace fecs
             if (this == &other) return *this;
             clear_and_free();
 
-            info     = other.info;
-            data     = other.data;
-            size     = other.size;
-            capacity = other.capacity;
+            info        = other.info;
+            chunks      = std::move(other.chunks);
+            size        = other.size;
+            capacity    = other.capacity;
+            chunk_shift = other.chunk_shift;
+            write_tick  = other.write_tick;
 
-            other.data     = nullptr;
+            other.chunks.clear();
             other.size     = 0;
             other.capacity = 0u;
             return *this;
         }
 
-        [[nodiscard]] std::size_t stride() const noexcept { return info.size; }
-        [[nodiscard]] std::size_t align () const noexcept { return info.alignment; }
+        [[nodiscard]] std::size_t stride    () const noexcept { return info.size; }
+        [[nodiscard]] std::size_t align     () const noexcept { return info.alignment; }
+        [[nodiscard]] std::size_t chunk_rows() const noexcept { return std::size_t{ 1 } << chunk_shift; }
 
         [[nodiscard]] void* ptr_at(const std::size_t index) noexcept
         {
             assert(index < size && "Index out of bounds");
-            return data + index * info.size;
+            return ptr_at_unsafe(index);
         }
 
         [[nodiscard]] const void* ptr_at(const std::size_t index) const noexcept
         {
             assert(index < size && "Index out of bounds");
-            return data + index * info.size;
+            return ptr_at_unsafe(index);
         }
 
         [[nodiscard]] void* ptr_at_unsafe(const std::size_t index) const noexcept
         {
-            return data + index * info.size;
+            const std::size_t in_chunk = index & (chunk_rows() - 1u);
+            return chunks[index >> chunk_shift] + in_chunk * info.size;
         }
 
-        void clear() noexcept
+        [[nodiscard]] void* chunk_data(const std::size_t chunk) const noexcept
         {
-            if (not data)
-            {
-                size = 0u;
-                return;
-            }
+            assert(chunk < chunks.size() && "Chunk out of bounds");
+            return chunks[chunk];
+        }
 
+        void clear() noexcept
+        {
             assert(info.dtor && "Column Info does not have valid destructor");
             for (std::size_t i = 0; i < size; ++i)
                 info.dtor(ptr_at_unsafe(i));
@@ -324,29 +343,34 @@ namespace fecs
             size = 0;
         }
 
+        // The row was already destroyed; the last row is relocated into it through its move
+        // constructor, since a bytewise copy breaks types that point into themselves (SSO strings)
         void remove_swap_nodestroy(const std::size_t row) noexcept
         {
             assert(row < size && "Index out of bounds");
             if (const std::size_t last_index = size - 1u; row != last_index)
             {
-                std::memcpy(ptr_at_unsafe(row), ptr_at_unsafe(last_index), stride());
+                void* dst = ptr_at_unsafe(row);
+                void* src = ptr_at_unsafe(last_index);
+                assert(info.move_ctor && info.dtor);
+                info.move_ctor(dst, src);
+                info.dtor(src);
             }
             --size;
+            release_spare_chunk();
         }
 
+        // Adds chunks until new_capacity rows fit; existing rows stay where they are
         void reserve(const std::size_t new_capacity) noexcept
         {
-            if (new_capacity <= capacity) return;
-            grow_to(new_capacity);
+            while (capacity < new_capacity)
+                add_chunk();
         }
 
         void push_defaults() noexcept
         {
             if (size == capacity)
-            {
-                const std::size_t new_capacity = capacity == 0u ? 8u : capacity * 2u;
-                grow_to(new_capacity);
-            }
+                add_chunk();
 
             void* dst = ptr_at_unsafe(size);
             assert(info.default_ctor && "Component default constructor is null");
@@ -370,43 +394,48 @@ namespace fecs
             info.dtor(src);
 
             --size;
+            release_spare_chunk();
         }
 
     private:
-        void clear_and_free() noexcept
+        [[nodiscard]] std::size_t chunk_bytes() const noexcept { return chunk_rows() * stride(); }
+
+        void add_chunk() noexcept
         {
-            clear();
-            capacity = 0u;
+            chunks.push_back(static_cast<std::byte*>(
+                operator new(chunk_bytes(), std::align_val_t{ static_cast<std::size_t>(info.alignment) })
+            ));
+            capacity += chunk_rows();
+            fox::mem_track_alloc(fox::mem_tag::ecs, chunk_bytes());
+        }
 
-            if (not data) return;
+        // Keeps at most one empty chunk past the last row, so shrinking tables hand memory back
+        // without freeing and reallocating around a chunk boundary
+        void release_spare_chunk() noexcept
+        {
+            if (capacity - size < 2u * chunk_rows()) return;
 
-            operator delete(data, std::align_val_t{ static_cast<std::size_t>(info.alignment) });
-            data = nullptr;
+            operator delete(chunks.back(), std::align_val_t{ static_cast<std::size_t>(info.alignment) });
+            chunks.pop_back();
+            capacity -= chunk_rows();
+            fox::mem_track_free(fox::mem_tag::ecs, chunk_bytes());
         }
 
-        void grow_to(const std::size_t new_capacity)
+        void clear_and_free() noexcept
         {
-            const std::size_t bytes = new_capacity * stride();
-            auto* new_data = static_cast<std::byte*>(
-                operator new(bytes, std::align_val_t{ static_cast<std::size_t>(info.alignment) })
-            );
-
-            if (data)
+            if (chunks.empty())
             {
-                assert(info.move_ctor && info.dtor);
-                for (std::size_t i = 0; i < size; ++i)
-                {
-                    void* dst = new_data + i * stride();
-                    void* src = data     + i * stride();
-                    info.move_ctor(dst, src);
-                    info.dtor(src);
-                }
-
-                operator delete(data, std::align_val_t{ static_cast<std::size_t>(info.alignment) });
+                size = 0u;
+                capacity = 0u;
+                return;
             }
 
-            data     = new_data;
-            capacity = new_capacity;
+            clear();
+            for (std::byte* chunk : chunks)
+                operator delete(chunk, std::align_val_t{ static_cast<std::size_t>(info.alignment) });
+            fox::mem_track_free(fox::mem_tag::ecs, chunks.size() * chunk_bytes());
+            chunks.clear();
+            capacity = 0u;
         }
     };
 
@@ -414,10 +443,16 @@ namespace fecs
 
 #pragma region WORLD_STORAGE
 
+    // Change ticks come from the owning world_storage's clock. structure_tick moves whenever rows
+    // are added or removed, i.e. whenever cached chunk blocks or counts go stale (growth never
+    // moves rows, removal swaps the last row into the hole); a column's write_tick is stamped by write access (non-const query parameters and
+    // get_component). A stamp >= a tick taken with world::advance_tick() happened after it.
     struct table
     {
         table_id id{ INVALID_TABLE };
         archetype_key key{};
+        std::uint64_t structure_tick{ 0u };
+        std::uint64_t* clock_{ nullptr };
 
         std::vector<entity> entities{};
         std::vector<column> columns{};
@@ -425,6 +460,7 @@ namespace fecs
         std::vector<component_id>   lookup_keys_{};
         std::vector<std::uint32_t>  lookup_vals_{};
         std::uint32_t               lookup_mask_{ 0u };
+        std::uint32_t               chunk_shift_{ 0u };
 
         [[nodiscard]] std::size_t size() const noexcept { return entities.size(); }
         [[nodiscard]] bool has(const component_id cid) const noexcept { return key.contains(cid); }
@@ -445,6 +481,7 @@ namespace fecs
 
             entities.pop_back();
             for (auto& c : columns) c.remove_swap_nodestroy(row);
+            touch();
 
             return swapped_in_entity;
         }
@@ -471,6 +508,7 @@ namespace fecs
             return get_column(cid).ptr_at_unsafe(row);
         }
 
+        // Chunks are only ever added, so reserving never invalidates row pointers
         void reserve(const std::size_t val) noexcept
         {
             entities.reserve(val);
@@ -482,6 +520,7 @@ namespace fecs
             const std::size_t row = entities.size();
             entities.emplace_back(e);
             for (auto& c : columns) c.push_defaults();
+            touch();
             return row;
         }
 
@@ -500,6 +539,7 @@ namespace fecs
 
             entities.pop_back();
             for (auto& c : columns) c.remove_swap(row);
+            touch();
 
             return swapped_in_entity;
         }
@@ -511,13 +551,10 @@ namespace fecs
 
             for (auto& c : columns)
             {
-                if (c.size == c.capacity)
-                {
-                    const std::size_t new_capacity = c.capacity == 0u ? 8u : c.capacity * 2u;
-                    c.reserve(new_capacity);
-                }
+                c.reserve(c.size + 1u);
                 ++c.size;
             }
+            touch();
 
             return row;
         }
@@ -547,7 +584,36 @@ namespace fecs
             new (dst) T(src);
         }
 
-        void finalize_schema() noexcept { build_lookup(); }
+        void finalize_schema() noexcept
+        {
+            build_lookup();
+
+            // One chunk of every column together spans about CHUNK_BYTES
+            std::size_t row_bytes = sizeof(entity);
+            for (const auto& c : columns) row_bytes += c.stride();
+            const std::size_t rows = (std::min)((std::max)(CHUNK_BYTES / row_bytes, std::size_t{ 1 }), MAX_CHUNK_ROWS);
+
+            chunk_shift_ = 0u;
+            while ((std::size_t{ 2 } << chunk_shift_) <= rows) ++chunk_shift_;
+            for (auto& c : columns) c.chunk_shift = chunk_shift_;
+        }
+
+        [[nodiscard]] std::size_t chunk_rows () const noexcept { return std::size_t{ 1 } << chunk_shift_; }
+        [[nodiscard]] std::size_t chunk_count() const noexcept { return (size() + chunk_rows() - 1u) >> chunk_shift_; }
+
+        // Rows held by chunk k, the last one may be partly filled
+        [[nodiscard]] std::size_t chunk_size(const std::size_t k) const noexcept
+        {
+            return (std::min)(chunk_rows(), size() - (k << chunk_shift_));
+        }
+
+        void touch() noexcept { if (clock_) structure_tick = ++*clock_; }
+        void mark_written(column& c) const noexcept { c.write_tick = clock_ ? *clock_ : 0u; }
+
+        [[nodiscard]] std::uint64_t write_tick(const component_id cid) const noexcept
+        {
+            return get_column_fast(cid).write_tick;
+        }
 
         [[nodiscard]] std::uint32_t column_index_fast(const component_id cid) const noexcept
         {
@@ -564,42 +630,31 @@ namespace fecs
             return columns[static_cast<std::size_t>(column_index_fast(cid))];
         }
 
-        [[nodiscard]] void* column_ptr(const component_id cid) noexcept
+        [[nodiscard]] void* chunk_ptr(const component_id cid, const std::size_t k) noexcept
         {
-            return get_column_fast(cid).data;
+            return get_column_fast(cid).chunk_data(k);
         }
 
-        [[nodiscard]] const void* column_ptr(const component_id cid) const noexcept
+        [[nodiscard]] const void* chunk_ptr(const component_id cid, const std::size_t k) const noexcept
         {
-            return get_column_fast(cid).data;
+            return get_column_fast(cid).chunk_data(k);
         }
 
+        // Contiguous rows of chunk k for one component, chunk_size(k) of them
         template<typename T>
-        [[nodiscard]] T* get_array(const component_registry& reg) noexcept
+        [[nodiscard]] T* chunk_array(const component_registry& reg, const std::size_t k) noexcept
         {
             const component_id cid = reg.get_id<T>();
             assert(has(cid));
-            return static_cast<T*>(column_ptr(cid));
+            return static_cast<T*>(chunk_ptr(cid, k));
         }
 
         template<typename T>
-        [[nodiscard]] const T* get_array(const component_registry& reg) const noexcept
+        [[nodiscard]] const T* chunk_array(const component_registry& reg, const std::size_t k) const noexcept
         {
             const component_id cid = reg.get_id<T>();
             assert(has(cid));
-            return static_cast<const T*>(column_ptr(cid));
-        }
-
-        template<typename T>
-        [[nodiscard]] std::span<T> get_span(const component_registry& reg) noexcept
-        {
-            return { get_array<T>(reg), size() };
-        }
-
-        template<typename T>
-        [[nodiscard]] std::span<const T> get_span(const component_registry& reg) const noexcept
-        {
-            return { get_array<T>(reg), size() };
+            return static_cast<const T*>(chunk_ptr(cid, k));
         }
 
     private:
@@ -713,6 +768,9 @@ namespace fecs
         [[nodiscard]] std::size_t table_count() const noexcept { return tables_.size(); }
         [[nodiscard]] std::uint64_t schema_version() const noexcept { return schema_version_; }
 
+        [[nodiscard]] std::uint64_t tick() const noexcept { return tick_; }
+        std::uint64_t advance_tick() noexcept { return ++tick_; }
+
     private:
         [[nodiscard]] table_id create_table(const archetype_key& key) noexcept
         {
@@ -730,6 +788,8 @@ namespace fecs
             }
 
             t.finalize_schema();
+            t.clock_ = &tick_;
+            t.touch();
 
             key_tables_.emplace(t.key, id);
             tables_.emplace_back(std::move(t));
@@ -740,6 +800,7 @@ namespace fecs
 
     private:
         std::uint64_t schema_version_{ 0u };
+        std::uint64_t tick_{ 0u };
         component_registry& registry_;
         std::unordered_map<archetype_key, table_id, archetype_hash> key_tables_{};
         std::vector<table> tables_{};
@@ -754,6 +815,274 @@ namespace fecs
         [[nodiscard]] bool valid() const noexcept { return tid != INVALID_TABLE; }
     };
 
+    [[nodiscard]] inline bool contains_all_sorted(
+        const std::vector<component_id>& haystack,
+        const std::vector<component_id>& needles) noexcept
+    {
+        std::size_t i = 0, j = 0;
+        while (i < haystack.size() && j < needles.size())
+        {
+            if (haystack[i] == needles[j]) { ++i; ++j; }
+            else if (haystack[i] < needles[j]) ++i;
+            else return false;
+        }
+        return j == needles.size();
+    }
+
+    // Matching tables of one query signature, owned by the world and shared by every _query of it.
+    // Tables are only ever appended, so sync() just tests the ones added since it last ran.
+    struct query_state
+    {
+        std::vector<component_id> ids{};        // in the query's parameter order
+        std::vector<component_id> required{};   // sorted, unique
+        std::vector<table_id> matching{};
+        std::size_t scanned = 0;                // tables tested so far
+
+        // par_each scratch, kept so steady state runs allocate nothing
+        struct row_range
+        {
+            table_id tid{ INVALID_TABLE };
+            std::uint32_t chunk{ 0u };
+            std::uint32_t begin{ 0u };          // within the chunk
+            std::uint32_t count{ 0u };
+        };
+        std::vector<row_range> ranges{};
+
+        void sync(const world_storage& storage) noexcept
+        {
+            const std::size_t tc = storage.table_count();
+            for (; scanned < tc; ++scanned)
+            {
+                const table& t = storage.get_table(static_cast<table_id>(scanned));
+                if (t.key.component_ids.size() < required.size()) continue;
+                if (contains_all_sorted(t.key.component_ids, required))
+                    matching.push_back(static_cast<table_id>(scanned));
+            }
+        }
+    };
+
+    namespace detail
+    {
+        inline std::size_t next_query_slot() noexcept
+        {
+            static std::atomic<std::size_t> next{ 0u };
+            return next.fetch_add(1u, std::memory_order_relaxed);
+        }
+
+        // Dense per-signature index into world::query_states_
+        template<typename... Cs>
+        std::size_t query_slot() noexcept
+        {
+            static const std::size_t slot = next_query_slot();
+            return slot;
+        }
+    }
+
+#pragma region COMMAND_BUFFER
+
+    class world;
+
+    // Structural edits recorded for later, so systems running on workers can create, add, remove
+    // and destroy without touching the world. world::flush plays a batch back grouped by entity:
+    // each touched entity moves at most once, straight to its final archetype, moves into the
+    // same table are done together and the version goes up once per flush.
+    // Recording only reads the registry, so every component used must be registered beforehand.
+    class command_buffer
+    {
+    public:
+        // Entity created by this buffer: a target for later commands, resolve() after the flush
+        struct pending { std::uint32_t index{ INVALID_ID }; };
+
+        explicit command_buffer(world& w) noexcept;
+        ~command_buffer() noexcept
+        {
+            clear();
+            release_blocks();
+        }
+
+        command_buffer(const command_buffer&)            = delete;
+        command_buffer& operator=(const command_buffer&) = delete;
+
+        [[nodiscard]] pending create_entity()
+        {
+            created_.emplace_back();
+            return { static_cast<std::uint32_t>(created_.size() - 1u) };
+        }
+
+        void destroy_entity(const entity e) { record(target{ e.value, false }, op::destroy, INVALID_ID, nullptr); }
+        void destroy_entity(const pending p) { record(target{ p.index, true }, op::destroy, INVALID_ID, nullptr); }
+
+        // Same rules as world::add_component: adding a component the entity already has is a no-op
+        template<typename T> void add_component(const entity e) { add<T>(target{ e.value, false }, nullptr); }
+        template<typename T> void add_component(const pending p) { add<T>(target{ p.index, true }, nullptr); }
+        template<typename T> void add_component(const entity e, T value) { add<T>(target{ e.value, false }, &value); }
+        template<typename T> void add_component(const pending p, T value) { add<T>(target{ p.index, true }, &value); }
+
+        template<typename T> void remove_component(const entity e) { remove<T>(target{ e.value, false }); }
+        template<typename T> void remove_component(const pending p) { remove<T>(target{ p.index, true }); }
+
+        // Valid once the buffer has been flushed, until the next clear
+        [[nodiscard]] entity resolve(const pending p) const noexcept
+        {
+            assert(p.index < created_.size() && "resolve: pending entity from another buffer");
+            return created_[p.index];
+        }
+
+        [[nodiscard]] bool empty() const noexcept { return commands_.empty() && created_.empty(); }
+        [[nodiscard]] std::size_t command_count() const noexcept { return commands_.size(); }
+
+        // Drops everything recorded, destroying values that were never played back
+        void clear() noexcept
+        {
+            discard_commands();
+            created_.clear();
+        }
+
+    private:
+        friend class world;
+
+        enum class op : std::uint8_t { add, remove, destroy };
+
+        struct target
+        {
+            storage_id value{ INVALID_ENTITY }; // entity, or index into created_
+            bool       is_pending{ false };
+        };
+
+        struct command
+        {
+            target       to{};
+            component_id cid{ INVALID_ID };
+            op           kind{ op::add };
+            void*        value{ nullptr }; // moved from and destroyed at the flush
+        };
+
+        static constexpr std::size_t BLOCK_BYTES = 16u * 1024u;
+        static constexpr std::size_t BLOCK_ALIGN = 64u;
+
+        template<typename T>
+        void add(const target to, T* value)
+        {
+            static_assert(alignof(T) <= BLOCK_ALIGN, "command_buffer: component alignment too large");
+            void* stored = nullptr;
+            if (value) stored = ::new (allocate(sizeof(T), alignof(T))) T(std::move(*value));
+            record(to, op::add, registry_->get_id<T>(), stored);
+        }
+
+        template<typename T>
+        void remove(const target to) { record(to, op::remove, registry_->get_id<T>(), nullptr); }
+
+        void record(const target to, const op kind, const component_id cid, void* value)
+        {
+            assert((not to.is_pending || to.value < created_.size()) && "command_buffer: pending entity from another buffer");
+            commands_.push_back({ to, cid, kind, value });
+        }
+
+        // Values live in fixed blocks so they never move while recorded. Blocks are kept across
+        // clears, a buffer recording about as much every frame stops allocating after the first.
+        [[nodiscard]] void* allocate(const std::size_t size, const std::size_t align)
+        {
+            std::size_t offset = (block_used_ + align - 1u) & ~(align - 1u);
+            if (blocks_in_use_ == 0u || offset + size > BLOCK_BYTES)
+            {
+                assert(size <= BLOCK_BYTES && "command_buffer: component larger than a value block");
+                if (blocks_in_use_ == blocks_.size())
+                    blocks_.push_back(static_cast<std::byte*>(::operator new(BLOCK_BYTES, std::align_val_t{ BLOCK_ALIGN })));
+                ++blocks_in_use_;
+                offset = 0u;
+            }
+            block_used_ = offset + size;
+            return blocks_[blocks_in_use_ - 1u] + offset;
+        }
+
+        void rewind_blocks() noexcept
+        {
+            blocks_in_use_ = 0u;
+            block_used_ = 0u;
+        }
+
+        void release_blocks() noexcept
+        {
+            for (std::byte* b : blocks_) ::operator delete(b, std::align_val_t{ BLOCK_ALIGN });
+            blocks_.clear();
+            rewind_blocks();
+        }
+
+        // After a flush: destroys the values no command took, keeps created_ for resolve()
+        void discard_commands() noexcept
+        {
+            for (const command& c : commands_)
+            {
+                if (c.value) registry_->get_info(c.cid).dtor(c.value);
+            }
+            commands_.clear();
+            rewind_blocks();
+        }
+
+    private:
+        component_registry*  registry_{ nullptr };
+        std::vector<command> commands_{};
+        std::vector<entity>  created_{};
+        std::vector<std::byte*> blocks_{};
+        std::size_t blocks_in_use_{ 0u };
+        std::size_t block_used_{ 0u };
+    };
+
+    // One command_buffer per recording thread, handed out by local() so workers never share one.
+    // world::flush plays them all back as a single batch.
+    class command_buffers
+    {
+    public:
+        explicit command_buffers(world& w) noexcept : world_(&w) {}
+
+        command_buffers(const command_buffers&)            = delete;
+        command_buffers& operator=(const command_buffers&) = delete;
+
+        // The calling thread's buffer; a lock is only taken the first time a thread asks
+        [[nodiscard]] command_buffer& local()
+        {
+            struct cached { std::uint64_t serial; command_buffer* buffer; };
+            thread_local cached last{ 0u, nullptr };
+            if (last.serial == serial_) return *last.buffer;
+
+            std::lock_guard lock(mutex_);
+            const std::thread::id self = std::this_thread::get_id();
+            command_buffer* found = nullptr;
+            for (std::size_t i = 0; i < owners_.size(); ++i)
+            {
+                if (owners_[i] == self) { found = buffers_[i].get(); break; }
+            }
+            if (not found)
+            {
+                buffers_.push_back(std::make_unique<command_buffer>(*world_));
+                owners_.push_back(self);
+                found = buffers_.back().get();
+            }
+            last = { serial_, found };
+            return *found;
+        }
+
+        // Buffers in the order their threads first asked for one; not safe while threads record
+        [[nodiscard]] std::span<const std::unique_ptr<command_buffer>> buffers() const noexcept { return buffers_; }
+
+    private:
+        // Distinguishes this set from an earlier one at the same address in the thread caches
+        static std::uint64_t next_serial() noexcept
+        {
+            static std::atomic<std::uint64_t> next{ 1u };
+            return next.fetch_add(1u, std::memory_order_relaxed);
+        }
+
+    private:
+        world* world_{ nullptr };
+        std::uint64_t serial_{ next_serial() };
+        std::mutex mutex_{};
+        std::vector<std::unique_ptr<command_buffer>> buffers_{};
+        std::vector<std::thread::id> owners_{};
+    };
+
+#pragma endregion
+
     template<typename... Cs>
     class _query;
 
@@ -766,10 +1095,12 @@ namespace fecs
             empty_table_ = storage_.get_or_create_table(make_archetype_key({}));
         }
 
+        // Cheap to call every frame: the matching tables persist in the world, no allocation once
+        // the signature has been seen and no table scan unless an archetype was added since
         template<typename... Cs>
         [[nodiscard]] _query<Cs...> query() noexcept
         {
-            return _query<Cs...>(*this);
+            return _query<Cs...>(*this, query_state_for<Cs...>());
         }
 
         template<typename... Cs>
@@ -801,22 +1132,81 @@ namespace fecs
             return e;
         }
 
-        void destroy_entity(const entity e) noexcept
+        // Creates count entities straight into the Cs... archetype. The table is reserved once and
+        // each row is built in place, instead of migrating through a table per added component.
+        // init(i, e, Cs&...) fills the default constructed row of entity i.
+        template<typename... Cs, typename Fn>
+        void create_entities(const std::size_t count, std::vector<entity>& out, Fn&& init) noexcept
         {
-            if (not entities_.alive(e)) return;
+            if (count == 0) return;
 
-            bool removed = false;
+            const table_id tid = get_table_for_signature({ registry_.get_id<Cs>()... });
+            table& t = storage_.get_table(tid);
+            t.reserve(t.size() + count);
+            out.reserve(out.size() + count);
 
-            if (location& loc = locations_[e.index()]; loc.valid())
+            column* const cols[] = { &t.get_column_fast(registry_.get_id<Cs>())... };
+            for (std::size_t i = 0; i < count; ++i)
             {
-                remove_row_dense_and_fixup(e);
-                removed = true;
+                const entity e = entities_.create_entity();
+                ensure_location_capacity(e.index());
+
+                const std::size_t row = t.add_row(e);
+                locations_[e.index()] = { tid, static_cast<std::uint32_t>(row) };
+
+                [&]<std::size_t... I>(std::index_sequence<I...>)
+                {
+                    init(i, e, *static_cast<Cs*>(cols[I]->ptr_at_unsafe(row))...);
+                }(std::index_sequence_for<Cs...>{});
+                out.push_back(e);
             }
 
-            entities_.destroy_entity(e);
+            bump_version();
+        }
+
+        // One entity built straight in the Cs... archetype from values, in place of
+        // create_entity and an add_component (and a table move) per component
+        template<typename... Cs>
+        [[nodiscard]] entity create_entity_with(const Cs&... values) noexcept
+        {
+            const table_id tid = get_table_for_signature({ registry_.get_id<Cs>()... });
+            table& t = storage_.get_table(tid);
 
-            if (removed) bump_version();
-            else bump_version();
+            const entity e = entities_.create_entity();
+            ensure_location_capacity(e.index());
+
+            const std::size_t row = t.add_row_uninitialized(e);
+            locations_[e.index()] = { tid, static_cast<std::uint32_t>(row) };
+            (t.copy_construct_at<Cs>(row, registry_.get_id<Cs>(), values), ...);
+
+            bump_version();
+            return e;
+        }
+
+        // Bulk destroy_entity: dead handles are skipped, the version goes up once
+        void destroy_entities(const std::span<const entity> es) noexcept
+        {
+            bool any = false;
+            for (const entity e : es)
+            {
+                if (not entities_.alive(e)) continue;
+                if (locations_[e.index()].valid())
+                    remove_row_dense_and_fixup(e);
+                entities_.destroy_entity(e);
+                any = true;
+            }
+            if (any) bump_version();
+        }
+
+        void destroy_entity(const entity e) noexcept
+        {
+            if (not entities_.alive(e)) return;
+
+            if (locations_[e.index()].valid())
+                remove_row_dense_and_fixup(e);
+
+            entities_.destroy_entity(e);
+            bump_version();
         }
 
         [[nodiscard]] bool alive(const entity e) const noexcept { return entities_.alive(e); }
@@ -841,7 +1231,9 @@ namespace fecs
             table& t = storage_.get_table(loc.tid);
             assert(t.has(cid) && "get_component: entity archetype does not contain this component!");
 
-            return *static_cast<T*>(t.get_component_ptr(loc.row, cid));
+            column& c = t.get_column_fast(cid);
+            t.mark_written(c);
+            return *static_cast<T*>(c.ptr_at_unsafe(loc.row));
         }
 
         template<typename T>
@@ -872,7 +1264,11 @@ namespace fecs
             if (not loc.valid()) return nullptr;
 
             table& t = storage_.get_table(loc.tid);
-            return t.has(cid) ? static_cast<T*>(t.get_component_ptr(loc.row, cid)) : nullptr;
+            if (not t.has(cid)) return nullptr;
+
+            column& c = t.get_column_fast(cid);
+            t.mark_written(c);
+            return static_cast<T*>(c.ptr_at_unsafe(loc.row));
         }
 
         template<typename T>
@@ -920,14 +1316,88 @@ namespace fecs
             bump_version();
         }
 
+        // Plays recorded structural edits back, see command_buffer. Call it between parallel
+        // phases, with nothing else using the world.
+        void flush(command_buffer& commands) noexcept
+        {
+            command_buffer* const one[] = { &commands };
+            play_back(one);
+        }
+
+        void flush(const command_buffers& commands) noexcept
+        {
+            std::vector<command_buffer*> all{};
+            all.reserve(commands.buffers().size());
+            for (const auto& b : commands.buffers()) all.push_back(b.get());
+            play_back(all);
+        }
+
         [[nodiscard]] component_registry& registry() noexcept { return registry_; }
         [[nodiscard]] world_storage&      storage () noexcept { return storage_;  }
         [[nodiscard]] entity_manager&     entities() noexcept { return entities_; }
         [[nodiscard]] std::uint64_t       version () const noexcept { return version_; }
 
+        // Change clock shared by every table, see table
+        [[nodiscard]] std::uint64_t tick() const noexcept { return storage_.tick(); }
+        std::uint64_t advance_tick() noexcept { return storage_.advance_tick(); }
+
+        // Some table holding one of Cs changed rows, or wrote one of those columns, at or after tick
+        template<typename... Cs>
+        [[nodiscard]] bool written_since(const std::uint64_t tick) const noexcept
+        {
+            const component_id ids[] = { registry_.get_id<Cs>()... };
+            return written_since_ids(ids, INVALID_ID, tick);
+        }
+
+        // The same over the tables not holding Skip, to watch one kind of row apart from another
+        template<typename Skip, typename... Cs>
+        [[nodiscard]] bool written_since_without(const std::uint64_t tick) const noexcept
+        {
+            const component_id ids[] = { registry_.get_id<Cs>()... };
+            return written_since_ids(ids, registry_.get_id<Skip>(), tick);
+        }
+
     private:
         void bump_version() noexcept { ++version_; }
 
+        [[nodiscard]] bool written_since_ids(const std::span<const component_id> ids, const component_id skip, const std::uint64_t tick) const noexcept
+        {
+            const std::size_t tc = storage_.table_count();
+            for (std::size_t i = 0; i < tc; ++i)
+            {
+                const table& t = storage_.get_table(static_cast<table_id>(i));
+                if (skip != INVALID_ID && t.has(skip)) continue;
+                bool holds = false;
+                for (const component_id cid : ids)
+                {
+                    if (not t.has(cid)) continue;
+                    if (t.write_tick(cid) >= tick) return true;
+                    holds = true;
+                }
+                if (holds && t.structure_tick >= tick) return true;
+            }
+            return false;
+        }
+
+        template<typename... Cs>
+        [[nodiscard]] query_state& query_state_for() noexcept
+        {
+            const std::size_t slot = detail::query_slot<Cs...>();
+            if (slot >= query_states_.size())
+                query_states_.resize(slot + 1u);
+
+            std::unique_ptr<query_state>& state = query_states_[slot];
+            if (!state) [[unlikely]]
+            {
+                state = std::make_unique<query_state>();
+                state->ids = { registry_.get_id<Cs>()... };
+                state->required = state->ids;
+                std::ranges::sort(state->required);
+                state->required.erase(std::ranges::unique(state->required).begin(), state->required.end());
+            }
+            return *state;
+        }
+
         template<typename T>
         void add_component(const entity e, const T* opt_value) noexcept
         {
@@ -953,6 +1423,212 @@ namespace fecs
             bump_version();
         }
 
+        // One entity's share of a flush: its commands in steps [first, last), the table it ends in
+        // and the values it still has to take, assigns [first_assign, last_assign)
+        struct flush_plan
+        {
+            entity        e{};
+            table_id      tid{ INVALID_TABLE };
+            std::uint32_t first{ 0u }, last{ 0u };
+            std::uint32_t first_assign{ 0u }, last_assign{ 0u };
+            bool          destroy{ false };
+        };
+
+        struct flush_step
+        {
+            entity                   e{};
+            command_buffer::command* c{ nullptr };
+        };
+
+        // Component set by an add that takes effect; a null value default constructs
+        struct flush_assign
+        {
+            component_id cid{ INVALID_ID };
+            command_buffer::command* c{ nullptr };
+        };
+
+        void play_back(const std::span<command_buffer* const> buffers) noexcept
+        {
+            // Created entities get their handles first so every command has a concrete target
+            std::size_t total = 0;
+            for (command_buffer* cb : buffers)
+            {
+                for (entity& e : cb->created_)
+                {
+                    e = entities_.create_entity();
+                    ensure_location_capacity(e.index());
+                    locations_[e.index()] = {};
+                }
+                total += cb->commands_.size();
+            }
+
+            std::vector<flush_step> steps{};
+            steps.reserve(total);
+            for (command_buffer* cb : buffers)
+            {
+                for (command_buffer::command& c : cb->commands_)
+                {
+                    const entity e = c.to.is_pending ? cb->created_[c.to.value] : entity(c.to.value);
+                    steps.push_back({ e, &c });
+                }
+            }
+            // Stable, so one entity's commands keep the order they were recorded in
+            std::ranges::stable_sort(steps, {}, [](const flush_step& st) { return st.e.value; });
+
+            std::vector<flush_plan> plans{};
+            std::vector<flush_assign> assigns{};
+            std::vector<component_id> ids{};
+            for (std::size_t i = 0; i < steps.size();)
+            {
+                const entity e = steps[i].e;
+                std::size_t j = i + 1u;
+                while (j < steps.size() && steps[j].e.value == e.value) ++j;
+
+                if (entities_.alive(e))
+                    plans.push_back(plan_entity(e, steps, i, j, ids, assigns));
+                i = j;
+            }
+
+            // Moves into one table back to back, with the table grown once for all of them
+            std::ranges::stable_sort(plans, {}, &flush_plan::tid);
+            for (std::size_t i = 0; i < plans.size();)
+            {
+                std::size_t j = i + 1u;
+                while (j < plans.size() && plans[j].tid == plans[i].tid) ++j;
+                if (plans[i].tid != INVALID_TABLE)
+                {
+                    table& t = storage_.get_table(plans[i].tid);
+                    t.reserve(t.size() + (j - i));
+                }
+                i = j;
+            }
+
+            for (const flush_plan& p : plans)
+                apply_plan(p, assigns);
+
+            // Created entities nothing was recorded for still exist, with no components
+            for (command_buffer* cb : buffers)
+            {
+                for (const entity e : cb->created_)
+                {
+                    if (not entities_.alive(e) || locations_[e.index()].valid()) continue;
+                    table& t = storage_.get_table(empty_table_);
+                    locations_[e.index()] = { empty_table_, static_cast<std::uint32_t>(t.add_row(e)) };
+                }
+                cb->discard_commands();
+            }
+
+            bump_version();
+        }
+
+        // Folds an entity's commands into its final signature; a destroy anywhere wins
+        [[nodiscard]] flush_plan plan_entity(const entity e, const std::vector<flush_step>& steps,
+            const std::size_t first, const std::size_t last,
+            std::vector<component_id>& ids, std::vector<flush_assign>& assigns) noexcept
+        {
+            flush_plan p{ e, INVALID_TABLE, static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(last) };
+            p.first_assign = static_cast<std::uint32_t>(assigns.size());
+
+            const location loc = locations_[e.index()];
+            ids.clear();
+            if (loc.valid()) ids = storage_.get_table(loc.tid).key.component_ids;
+
+            for (std::size_t k = first; k < last; ++k)
+            {
+                command_buffer::command& c = *steps[k].c;
+                if (c.kind == command_buffer::op::destroy)
+                {
+                    p.destroy = true;
+                    assigns.resize(p.first_assign);
+                    p.last_assign = p.first_assign;
+                    return p;
+                }
+
+                const auto it = std::ranges::lower_bound(ids, c.cid);
+                const bool present = it != ids.end() && *it == c.cid;
+                if (c.kind == command_buffer::op::add && not present)
+                {
+                    ids.insert(it, c.cid);
+                    assigns.push_back({ c.cid, &c });
+                }
+                else if (c.kind == command_buffer::op::remove && present)
+                {
+                    ids.erase(it);
+                    const auto from = assigns.begin() + p.first_assign;
+                    assigns.erase(std::remove_if(from, assigns.end(),
+                        [&](const flush_assign& a) { return a.cid == c.cid; }), assigns.end());
+                }
+            }
+
+            p.last_assign = static_cast<std::uint32_t>(assigns.size());
+            p.tid = get_table_for_signature(ids);
+            return p;
+        }
+
+        void apply_plan(const flush_plan& p, const std::vector<flush_assign>& assigns) noexcept
+        {
+            location& loc = locations_[p.e.index()];
+            if (p.destroy)
+            {
+                if (loc.valid()) remove_row_dense_and_fixup(p.e);
+                entities_.destroy_entity(p.e);
+                return;
+            }
+
+            const std::span<const flush_assign> mine(assigns.data() + p.first_assign, p.last_assign - p.first_assign);
+            const auto assign_for = [&](const component_id cid) -> command_buffer::command*
+            {
+                for (const flush_assign& a : mine)
+                {
+                    if (a.cid == cid) return a.c;
+                }
+                return nullptr;
+            };
+            const auto construct = [](column& col, void* dst, command_buffer::command* c) noexcept
+            {
+                if (c && c->value)
+                {
+                    col.info.move_ctor(dst, c->value);
+                    col.info.dtor(c->value);
+                    c->value = nullptr;
+                }
+                else col.info.default_ctor(dst);
+            };
+
+            const table_id old_tid = loc.valid() ? loc.tid : INVALID_TABLE;
+            if (old_tid != p.tid)
+            {
+                std::uint32_t row = 0u;
+                if (old_tid != INVALID_TABLE) row = relocate_entity(p.e, p.tid);
+                else
+                {
+                    row = static_cast<std::uint32_t>(storage_.get_table(p.tid).add_row_uninitialized(p.e));
+                    loc = { p.tid, row };
+                }
+
+                const table* old_table = old_tid != INVALID_TABLE ? &storage_.get_table(old_tid) : nullptr;
+                for (column& col : storage_.get_table(p.tid).columns)
+                {
+                    if (old_table && old_table->has(col.info.id)) continue;
+                    construct(col, col.ptr_at_unsafe(row), assign_for(col.info.id));
+                }
+            }
+
+            // Removed and added again in the same batch: the old value came along, replace it
+            if (old_tid == INVALID_TABLE) return;
+            const table& old_table = storage_.get_table(old_tid);
+            table& t = storage_.get_table(p.tid);
+            for (const flush_assign& a : mine)
+            {
+                if (not old_table.has(a.cid)) continue;
+                column& col = t.get_column_fast(a.cid);
+                void* dst = col.ptr_at_unsafe(loc.row);
+                col.info.dtor(dst);
+                construct(col, dst, a.c);
+                t.mark_written(col);
+            }
+        }
+
         static void intersect_sorted_ids(
             const std::vector<component_id>& a,
             const std::vector<component_id>& b,
@@ -968,9 +1644,18 @@ namespace fecs
         }
 
         [[nodiscard]] std::uint32_t migrate_entity_to_table(const entity e, const table_id new_tid) noexcept
+        {
+            const std::uint32_t new_row = relocate_entity(e, new_tid);
+            bump_version();
+            return new_row;
+        }
+
+        // Moves the shared components over and destroys the dropped ones; components only the new
+        // table has are left for the caller to construct
+        [[nodiscard]] std::uint32_t relocate_entity(const entity e, const table_id new_tid) noexcept
         {
             location& loc = locations_[e.index()];
-            assert(loc.valid() && "migrate_entity_to_table: invalid location");
+            assert(loc.valid() && "relocate_entity: invalid location");
 
             const table_id old_tid = loc.tid;
             const std::uint32_t old_row = loc.row;
@@ -1018,7 +1703,6 @@ namespace fecs
 
             loc.tid = new_tid;
             loc.row = new_row;
-            bump_version();
 
             return new_row;
         }
@@ -1045,8 +1729,6 @@ namespace fecs
 
             loc.tid = INVALID_TABLE;
             loc.row = 0u;
-
-            bump_version();
         }
 
         [[nodiscard]] table_id get_table_for_signature(std::vector<component_id> ids) noexcept
@@ -1061,15 +1743,54 @@ namespace fecs
         world_storage storage_;
         table_id empty_table_{ INVALID_TABLE };
         std::vector<location> locations_{};
+        std::vector<std::unique_ptr<query_state>> query_states_{};
         std::uint64_t version_{ 0u };
     };
 
+    inline command_buffer::command_buffer(world& w) noexcept
+        : registry_(&w.registry())
+    {
+    }
+
+#pragma region ACCESS
+
+    // Compile time component access of a query: const T is a read, plain T a write
+    template<typename... Cs>
+    struct access
+    {
+        template<typename T>
+        static constexpr bool uses = (std::is_same_v<std::remove_const_t<Cs>, std::remove_const_t<T>> || ...);
+
+        template<typename T>
+        static constexpr bool writes = ((!std::is_const_v<Cs> && std::is_same_v<Cs, std::remove_const_t<T>>) || ...);
+
+        template<typename T>
+        static constexpr std::size_t count = (std::size_t{ std::is_same_v<std::remove_const_t<Cs>, std::remove_const_t<T>> } + ... + 0u);
+
+        // No component listed twice, so no row is reached through two pointers
+        static constexpr bool distinct = ((count<Cs> == 1u) && ...);
+
+        // Either side writes a component the other uses, so the two must not run at once
+        template<typename... Ds>
+        static constexpr bool conflicts_with(access<Ds...>) noexcept
+        {
+            return ((writes<Ds> || (!std::is_const_v<Ds> && uses<Ds>)) || ...);
+        }
+    };
+
+    template<typename A, typename B>
+    inline constexpr bool access_conflict_v = A::conflicts_with(B{});
+
+#pragma endregion
+
 #pragma region QUERY_EACH
 
     template<typename... Cs>
     class _query
     {
     public:
+        using access_type = access<Cs...>;
+
         struct pinned_block
         {
             std::tuple<Cs*...> arrays{};
@@ -1078,129 +1799,182 @@ namespace fecs
 
         [[nodiscard]] std::vector<pinned_block> pin()
         {
-            refresh_if_needed();
-
             std::vector<pinned_block> out;
-            out.reserve(matching_.size());
+            pin(out);
+            return out;
+        }
+
+        // Same, into a vector the caller keeps between frames so pinning does not allocate
+        void pin(std::vector<pinned_block>& out)
+        {
+            state_->sync(world_->storage());
 
-            for (const table_id tid : matching_)
+            out.clear();
+            out.reserve(state_->matching.size());
+
+            for (const table_id tid : state_->matching)
             {
                 table& t = world_->storage().get_table(tid);
-                const std::size_t n = t.size();
-                if (n == 0) continue;
-
-                pinned_block b{};
-                b.arrays = std::tuple{ t.template get_array<Cs>(world_->registry())... };
-                b.n = n;
+                if (t.size() == 0) continue;
 
-                out.emplace_back(b);
+                mark_writes(t);
+                for (std::size_t k = 0; k < t.chunk_count(); ++k)
+                {
+                    pinned_block b{};
+                    b.arrays = arrays_of(t, k);
+                    b.n = t.chunk_size(k);
+                    out.emplace_back(b);
+                }
             }
-
-            return out;
         }
 
-        explicit _query(world& w) noexcept
+        _query(world& w, query_state& state) noexcept
             : world_(&w)
+            , state_(&state)
         {
-            required_.reserve(sizeof...(Cs));
-            (required_.push_back(world_->registry().get_id<Cs>()), ...);
-
-            std::ranges::sort(required_);
-            required_.erase(std::ranges::unique(required_).begin(), required_.end());
         }
 
+        // fn(arrays..., n) once per chunk of contiguous rows. Tables created by fn are picked up by
+        // the next call, not this one.
         template<typename Fn>
         void each(Fn&& fn)
         {
-            refresh_if_needed();
+            state_->sync(world_->storage());
 
-            for (const table_id tid : matching_)
+            const std::size_t mc = state_->matching.size();
+            for (std::size_t m = 0; m < mc; ++m)
             {
-                table& t = world_->storage().get_table(tid);
-                const std::size_t n = t.size();
-                if (n == 0) continue;
+                table& t = world_->storage().get_table(state_->matching[m]);
+                if (t.size() == 0) continue;
 
-                std::invoke(std::forward<Fn>(fn), t.template get_array<Cs>(world_->registry())..., n);
+                mark_writes(t);
+                for (std::size_t k = 0; k < t.chunk_count(); ++k)
+                {
+                    const std::size_t n = t.chunk_size(k);
+                    std::apply([&](Cs*... arrays) { std::invoke(fn, arrays..., n); }, arrays_of(t, k));
+                }
             }
         }
 
         template<typename Fn>
         void each_entity(Fn&& fn)
         {
-            refresh_if_needed();
+            state_->sync(world_->storage());
 
-            for (const table_id tid : matching_)
+            const std::size_t mc = state_->matching.size();
+            for (std::size_t m = 0; m < mc; ++m)
             {
-                table& t = world_->storage().get_table(tid);
-                const std::size_t n = t.size();
-                if (n == 0) continue;
-
-                auto arrays = std::tuple{ t.template get_array<Cs>(world_->registry())... };
+                table& t = world_->storage().get_table(state_->matching[m]);
+                if (t.size() == 0) continue;
 
-                for (std::size_t i = 0; i < n; ++i)
+                mark_writes(t);
+                for (std::size_t k = 0; k < t.chunk_count(); ++k)
                 {
-                    std::apply([&](auto*... ptrs)
+                    const std::size_t base = k * t.chunk_rows();
+                    const std::size_t n = t.chunk_size(k);
+                    auto arrays = arrays_of(t, k);
+
+                    for (std::size_t i = 0; i < n; ++i)
                     {
-                        std::invoke(fn, t.entities[i], (ptrs[i])...);
-                    }, arrays);
+                        std::apply([&](auto*... ptrs)
+                        {
+                            std::invoke(fn, t.entities[base + i], (ptrs[i])...);
+                        }, arrays);
+                    }
                 }
             }
         }
 
-        [[nodiscard]] std::size_t match_count()
+        // Splits every storage chunk of the matching tables into row ranges of at most chunk_rows
+        // and runs fn(arrays..., n) on them across pool, anything with parallel_for(count, grain, fn(b, e))
+        // such as fox::job_system. fn may only touch the rows it is given and must not add or
+        // remove components; const Cs are promised read only, see access<Cs...>. Not reentrant
+        // for the same signature, the ranges live in the shared query_state.
+        template<typename Pool, typename Fn>
+        void par_each(Pool& pool, const std::size_t chunk_rows, Fn&& fn)
         {
-            refresh_if_needed();
-            return matching_.size();
-        }
+            static_assert(access_type::distinct, "par_each: a component listed twice hands its rows to a range under two pointers");
+            state_->sync(world_->storage());
 
-    private:
-        void refresh_if_needed()
-        {
-            const std::uint64_t v = world_->version();
-            if (v == cached_version_) return;
+            const std::size_t chunk = chunk_rows ? chunk_rows : 1u;
+            auto& ranges = state_->ranges;
+            ranges.clear();
+            for (const table_id tid : state_->matching)
+            {
+                table& t = world_->storage().get_table(tid);
+                if (t.size() == 0) continue;
 
-            matching_.clear();
+                mark_writes(t);
+                for (std::size_t k = 0; k < t.chunk_count(); ++k)
+                {
+                    const std::size_t n = t.chunk_size(k);
+                    for (std::size_t begin = 0; begin < n; begin += chunk)
+                    {
+                        ranges.push_back({ tid, static_cast<std::uint32_t>(k), static_cast<std::uint32_t>(begin),
+                                           static_cast<std::uint32_t>((std::min)(chunk, n - begin)) });
+                    }
+                }
+            }
 
-            const std::size_t tc = world_->storage().table_count();
-            matching_.reserve(tc);
+            const auto run_range = [&](const query_state::row_range& r)
+            {
+                table& t = world_->storage().get_table(r.tid);
+                std::apply([&](Cs*... arrays) { std::invoke(fn, (arrays + r.begin)..., static_cast<std::size_t>(r.count)); }, arrays_of(t, r.chunk));
+            };
 
-            for (table_id tid = 0; tid < tc; ++tid)
+            if (ranges.size() == 1)
             {
-                const table& t = world_->storage().get_table(tid);
+                run_range(ranges.front());
+                return;
+            }
 
-                if (t.key.component_ids.size() < required_.size()) continue;
+            pool.parallel_for(static_cast<std::uint32_t>(ranges.size()), 1u, [&](std::uint32_t b, std::uint32_t e)
+            {
+                for (std::uint32_t i = b; i < e; ++i)
+                    run_range(ranges[i]);
+            });
+        }
 
-                if (contains_all_sorted(t.key.component_ids, required_))
-                    matching_.push_back(tid);
-            }
+        [[nodiscard]] std::size_t match_count()
+        {
+            state_->sync(world_->storage());
+            return state_->matching.size();
+        }
 
-            cached_version_ = v;
+    private:
+        // Chunk k's rows, looked up by the ids resolved once per signature, no registry hashing
+        [[nodiscard]] std::tuple<Cs*...> arrays_of(table& t, const std::size_t k) const noexcept
+        {
+            return arrays_of(t, k, std::index_sequence_for<Cs...>{});
         }
 
-        [[nodiscard]] static bool contains_all_sorted(
-            const std::vector<component_id>& haystack,
-            const std::vector<component_id>& needles) noexcept
+        template<std::size_t... I>
+        [[nodiscard]] std::tuple<Cs*...> arrays_of(table& t, const std::size_t k, std::index_sequence<I...>) const noexcept
         {
-            std::size_t i = 0, j = 0;
-            while (i < haystack.size() && j < needles.size())
-            {
-                if (haystack[i] == needles[j]) { ++i; ++j; }
-                else if (haystack[i] < needles[j]) ++i;
-                else return false;
-            }
-            return j == needles.size();
+            return std::tuple<Cs*...>{ static_cast<Cs*>(t.chunk_ptr(state_->ids[I], k))... };
+        }
+
+        // Stamps the columns handed out for writing, the non-const Cs
+        void mark_writes(table& t) const noexcept
+        {
+            mark_writes(t, std::index_sequence_for<Cs...>{});
+        }
+
+        template<std::size_t... I>
+        void mark_writes(table& t, std::index_sequence<I...>) const noexcept
+        {
+            ((std::is_const_v<Cs> ? void() : t.mark_written(t.get_column_fast(state_->ids[I]))), ...);
         }
 
     private:
         world* world_{ nullptr };
-
-        std::vector<component_id> required_{};
-        std::vector<table_id> matching_{};
-        std::uint64_t cached_version_{ std::numeric_limits<std::uint64_t>::max() };
+        query_state* state_{ nullptr };
     };
 
 #pragma region RENDER_CACHE
 
+    // One block per storage chunk of every table holding Cs. Only the matching tables' structure ticks are looked at,
+    // so changes to unrelated archetypes leave the blocks (and version()) alone.
     template<typename... Cs>
     class render_cache
     {
@@ -1209,6 +1983,7 @@ namespace fecs
         {
             std::tuple<Cs*...> arrays{};
             std::size_t n = 0;
+            table_id tid{ INVALID_TABLE };  // for what else the rows hold
         };
 
         void refresh(world& w)
@@ -1216,19 +1991,49 @@ namespace fecs
             if (!initialized_)
                 init(w);
 
-            const std::uint64_t v = w.version();
-            if (v == cached_version_) return;
+            bool changed = false;
+
+            const std::size_t tc = w.storage().table_count();
+            for (; scanned_ < tc; ++scanned_)
+            {
+                const table& t = w.storage().get_table(static_cast<table_id>(scanned_));
+                if (t.key.component_ids.size() < required_.size()) continue;
+                if (contains_all_sorted(t.key.component_ids, required_))
+                {
+                    matching_.push_back({ static_cast<table_id>(scanned_), t.structure_tick });
+                    changed = true;
+                }
+            }
+
+            for (matched_table& m : matching_)
+            {
+                const std::uint64_t tick = w.storage().get_table(m.tid).structure_tick;
+                if (tick != m.seen_tick)
+                {
+                    m.seen_tick = tick;
+                    changed = true;
+                }
+            }
+
+            if (!changed && version_ != 0u) return;
 
-            build_matching(w);
             rebuild_blocks(w);
-            cached_version_ = v;
+            ++version_;
         }
 
         [[nodiscard]] const std::vector<block>& blocks() const noexcept { return blocks_; }
         [[nodiscard]] bool empty() const noexcept { return blocks_.empty(); }
-        [[nodiscard]] std::uint64_t version() const noexcept { return cached_version_; }
+
+        // Bumped each time the blocks are rebuilt; 0 before the first refresh
+        [[nodiscard]] std::uint64_t version() const noexcept { return version_; }
 
     private:
+        struct matched_table
+        {
+            table_id tid{ INVALID_TABLE };
+            std::uint64_t seen_tick{ 0u };
+        };
+
         void init(world& w)
         {
             required_.reserve(sizeof...(Cs));
@@ -1238,60 +2043,32 @@ namespace fecs
             initialized_ = true;
         }
 
-        void build_matching(world& w)
-        {
-            matching_.clear();
-
-            const std::size_t tc = w.storage().table_count();
-            matching_.reserve(tc);
-
-            for (table_id tid = 0; tid < tc; ++tid)
-            {
-                const table& t = w.storage().get_table(tid);
-                if (t.key.component_ids.size() < required_.size()) continue;
-                if (contains_all_sorted(t.key.component_ids, required_))
-                    matching_.push_back(tid);
-            }
-        }
-
         void rebuild_blocks(world& w)
         {
             blocks_.clear();
             blocks_.reserve(matching_.size());
 
-            for (const table_id tid : matching_)
+            for (const matched_table& m : matching_)
             {
-                table& t = w.storage().get_table(tid);
-                const std::size_t n = t.size();
-                if (n == 0) continue;
-
-                block b{};
-                b.arrays = std::tuple{ t.template get_array<Cs>(w.registry())... };
-                b.n = n;
-                blocks_.emplace_back(b);
-            }
-        }
-
-        [[nodiscard]] static bool contains_all_sorted(
-            const std::vector<component_id>& haystack,
-            const std::vector<component_id>& needles) noexcept
-        {
-            std::size_t i = 0, j = 0;
-            while (i < haystack.size() && j < needles.size())
-            {
-                if (haystack[i] == needles[j]) { ++i; ++j; }
-                else if (haystack[i] < needles[j]) ++i;
-                else return false;
+                table& t = w.storage().get_table(m.tid);
+                for (std::size_t k = 0; k < t.chunk_count(); ++k)
+                {
+                    block b{};
+                    b.arrays = std::tuple{ t.template chunk_array<Cs>(w.registry(), k)... };
+                    b.n = t.chunk_size(k);
+                    b.tid = m.tid;
+                    blocks_.emplace_back(b);
+                }
             }
-            return j == needles.size();
         }
 
     private:
         bool initialized_{ false };
         std::vector<component_id> required_{};
-        std::vector<table_id> matching_{};
+        std::vector<matched_table> matching_{};
+        std::size_t scanned_{ 0u };
         std::vector<block> blocks_{};
-        std::uint64_t cached_version_{ std::numeric_limits<std::uint64_t>::max() };
+        std::uint64_t version_{ 0u };
     };
 
 #pragma endregion
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace fox
+{
+    // Linear scratch memory for one thread: allocations bump an offset and are given back all at
+    // once, by rewinding to a mark or by reset(). A frame that outgrows the current block spills
+    // into another; the next reset folds them into one block of the combined size, so a frame
+    // that asks for about as much as the last one runs without touching the heap.
+    class frame_arena
+    {
+    public:
+        static constexpr std::size_t kAlign         = 64;
+        static constexpr std::size_t kMinBlockBytes = 64u * 1024u;
+
+        struct marker
+        {
+            std::size_t block = 0;
+            std::size_t used  = 0;
+        };
+
+        frame_arena() = default;
+        ~frame_arena() { release(); }
+
+        frame_arena(const frame_arena&)            = delete;
+        frame_arena& operator=(const frame_arena&) = delete;
+
+        // Uninitialised storage for count values, never destroyed
+        template<class T>
+        [[nodiscard]] T* allocate(std::size_t count)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "frame_arena: values are never destroyed");
+            return static_cast<T*>(allocate_bytes(count * sizeof(T), alignof(T)));
+        }
+
+        [[nodiscard]] void* allocate_bytes(std::size_t size, std::size_t align);
+
+        [[nodiscard]] marker mark() const noexcept { return { m_current, m_used }; }
+        void rewind(const marker& m) noexcept;
+
+        // Everything handed out since the last reset goes back
+        void reset();
+
+        [[nodiscard]] std::uint64_t heap_allocations() const noexcept { return m_heap_allocations; }
+        [[nodiscard]] std::size_t capacity() const noexcept;
+
+    private:
+        struct block
+        {
+            std::byte*  data = nullptr;
+            std::size_t size = 0;
+        };
+
+        void release() noexcept;
+
+        std::vector<block> m_blocks{};
+        std::size_t m_current = 0; // block being filled
+        std::size_t m_used    = 0; // bytes taken from it
+        bool m_spilled = false;    // went past the first block since the last reset
+        std::uint64_t m_heap_allocations = 0;
+    };
+
+    // One frame_arena per job_system slot, so workers take scratch without locking; threads with
+    // no slot share one more arena behind a lock. reset() must not overlap any scratch_scope.
+    class frame_arenas
+    {
+    public:
+        frame_arenas();
+
+        frame_arenas(const frame_arenas&)            = delete;
+        frame_arenas& operator=(const frame_arenas&) = delete;
+
+        void reset();
+
+        // Blocks allocated over the arenas' lifetime; flat while frames keep their size
+        [[nodiscard]] std::uint64_t heap_allocations() const noexcept;
+        [[nodiscard]] std::size_t capacity() const noexcept;
+
+    private:
+        friend class scratch_scope;
+
+        std::uint32_t m_slot_count = 0;
+        std::unique_ptr<frame_arena[]> m_arenas{}; // slot arenas, then the shared one
+        std::recursive_mutex m_shared_mtx{};
+    };
+
+    // Scratch from the calling thread's arena, given back when the scope ends. Scopes nest like
+    // the stack, which holds for tasks too: a thread waiting on a parallel_for only runs other
+    // tasks to completion before it resumes.
+    class scratch_scope
+    {
+    public:
+        explicit scratch_scope(frame_arenas& arenas);
+        ~scratch_scope() { m_arena->rewind(m_mark); }
+
+        scratch_scope(const scratch_scope&)            = delete;
+        scratch_scope& operator=(const scratch_scope&) = delete;
+
+        template<class T>
+        [[nodiscard]] T* allocate(std::size_t count) { return m_arena->allocate<T>(count); }
+
+    private:
+        std::unique_lock<std::recursive_mutex> m_lock{};
+        frame_arena* m_arena = nullptr;
+        frame_arena::marker m_mark{};
+    };
+}
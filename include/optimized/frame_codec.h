@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lossless RGBA8 frame coding for captures: per tile XOR against the previous frame, with
+// unchanged tiles reduced to a single byte, then an LZ4 style byte compressor over the result.
+
+namespace fox
+{
+    // Worst case output of lz_compress for n input bytes
+    [[nodiscard]] constexpr std::size_t lz_compress_bound(std::size_t n) noexcept
+    {
+        return n + n / 255u + 16u;
+    }
+
+    // LZ4 block layout (token, literals, 16 bit offset, match length), greedy single hash probe.
+    // dst must hold lz_compress_bound(n) bytes; returns the bytes written.
+    [[nodiscard]] std::size_t lz_compress(const std::uint8_t* src, std::size_t n, std::uint8_t* dst) noexcept;
+
+    // Expands exactly dst_n bytes; false on malformed or truncated input
+    [[nodiscard]] bool lz_decompress(const std::uint8_t* src, std::size_t n, std::uint8_t* dst, std::size_t dst_n) noexcept;
+
+    inline constexpr std::uint32_t kFrameCodecTile = 32;
+
+    // Codes `cur` against `prev` (nullptr for a key frame) into out, replacing its contents.
+    // Both frames are w x h with pitch_pixels elements per row. Returns the size of the
+    // uncompressed delta stream, which decode_frame needs back.
+    std::uint32_t encode_frame(const std::uint32_t* cur, const std::uint32_t* prev,
+                               std::uint32_t w, std::uint32_t h, std::uint32_t pitch_pixels,
+                               std::vector<std::uint8_t>& scratch, std::vector<std::uint8_t>& out);
+
+    // Inverse of encode_frame; dst may not alias prev
+    [[nodiscard]] bool decode_frame(const std::uint8_t* packed, std::size_t packed_bytes, std::uint32_t raw_bytes,
+                                    const std::uint32_t* prev, std::uint32_t* dst,
+                                    std::uint32_t w, std::uint32_t h, std::uint32_t pitch_pixels,
+                                    std::vector<std::uint8_t>& scratch);
+}
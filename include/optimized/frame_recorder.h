@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace fox
+{
+    // Streams a capture to disk. submit() copies the frame into a short queue and returns; a writer
+    // thread codes it against the previous frame (frame_codec.h) and appends it to the file. When
+    // the queue is full submit() waits for the writer, so memory stays bounded however long it runs.
+    class frame_recorder
+    {
+    public:
+        frame_recorder();
+        ~frame_recorder();
+
+        frame_recorder(const frame_recorder&)            = delete;
+        frame_recorder& operator=(const frame_recorder&) = delete;
+
+        [[nodiscard]] bool open(const char* path, std::uint32_t w, std::uint32_t h) noexcept;
+        void submit(const std::uint32_t* color, std::uint32_t pitch_pixels) noexcept;
+
+        // Writes out whatever is still queued and closes the file; false when a write failed
+        bool close() noexcept;
+
+        [[nodiscard]] bool is_open() const noexcept;
+        [[nodiscard]] std::uint32_t frame_count() const noexcept; // submitted since the last open
+        // A write failed since the last open. The writer logs it once and stops; later submits drop
+        // their frame, and the file keeps every frame before the failure.
+        [[nodiscard]] bool failed() const noexcept;
+
+    private:
+        class impl;
+        std::unique_ptr<impl> p_;
+    };
+
+    // Writes frames as <prefix>_000000.tga, <prefix>_000001.tga, ... from a writer thread, with the
+    // same queueing as frame_recorder; what offline batch renders hand to an encoder
+    class image_sequence_writer
+    {
+    public:
+        image_sequence_writer();
+        ~image_sequence_writer();
+
+        image_sequence_writer(const image_sequence_writer&)            = delete;
+        image_sequence_writer& operator=(const image_sequence_writer&) = delete;
+
+        [[nodiscard]] bool open(const char* prefix, std::uint32_t w, std::uint32_t h) noexcept;
+        void submit(const std::uint32_t* color, std::uint32_t pitch_pixels) noexcept;
+
+        // Writes out whatever is still queued; returns how many frames failed to reach disk
+        std::uint32_t close() noexcept;
+
+        [[nodiscard]] bool is_open() const noexcept;
+        [[nodiscard]] std::uint32_t frame_count() const noexcept; // submitted since the last open
+        // Frames whose file could not be created or written since the last open. Each frame is its
+        // own file, so the writer logs the first failure and carries on with the rest.
+        [[nodiscard]] std::uint32_t failed_count() const noexcept;
+
+    private:
+        class impl;
+        std::unique_ptr<impl> p_;
+    };
+
+    // Plays a capture back out of a memory mapped file. A decode thread stays a few frames ahead of
+    // the last one acquired; jumping anywhere else restarts decoding at the nearest key frame.
+    class frame_player
+    {
+    public:
+        frame_player();
+        ~frame_player();
+
+        frame_player(const frame_player&)            = delete;
+        frame_player& operator=(const frame_player&) = delete;
+
+        [[nodiscard]] bool open(const char* path) noexcept;
+        void close() noexcept;
+
+        [[nodiscard]] bool is_open() const noexcept;
+        [[nodiscard]] std::uint32_t frame_count() const noexcept;
+        [[nodiscard]] std::uint32_t width() const noexcept;
+        [[nodiscard]] std::uint32_t height() const noexcept;
+
+        // Decoded frame with width() pixels per row, valid until the next acquire or close.
+        // Single consumer; blocks until the frame is decoded.
+        [[nodiscard]] const std::uint32_t* acquire(std::uint32_t index) noexcept;
+
+    private:
+        class impl;
+        std::unique_ptr<impl> p_;
+    };
+}
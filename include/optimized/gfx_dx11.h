@@ -32,6 +32,7 @@ namespace fox
     [[nodiscard]] static inline std::uint8_t rgba8_b(std::uint32_t rgba) noexcept { return static_cast<std::uint8_t>((rgba >> 16) & 0xFFu); }
     [[nodiscard]] static inline std::uint8_t rgba8_a(std::uint32_t rgba) noexcept { return static_cast<std::uint8_t>((rgba >> 24) & 0xFFu); }
 
+    // Color and depth come back holding whatever the slot last had; the renderer clears them
     struct cpu_frame
     {
         std::uint32_t w = 0;
@@ -46,12 +47,25 @@ namespace fox
         std::uint32_t slot = 0;
         std::uint32_t generation = 0;
 
+        // color is mapped upload memory: write it once, never read it back
+        bool write_combined = false;
+
         [[nodiscard]] bool valid() const noexcept
         {
             return color && z && w && h;
         }
     };
 
+    // Input sampled (pace_frame returning) to Present returning, for frames presented from a slot
+    struct present_latency_stats
+    {
+        double        last_ms = 0.0;
+        double        avg_ms  = 0.0;          // moving average over roughly the last 16 frames
+        double        peak_ms = 0.0;          // worst frame in the last second
+        std::uint64_t frames  = 0;
+        std::uint64_t failed_acquires = 0;    // try_begin_frame calls that found no free slot
+    };
+
     struct playback_state
     {
         bool          recording = false;
@@ -80,8 +94,18 @@ namespace fox
         cpu_frame begin_frame() noexcept;        // blocking acquire
         cpu_frame try_begin_frame() noexcept;    // non-blocking acquire
 
+        // Low latency mode: CPU work starts when the swap chain can take a frame, just before the
+        // vblank that shows it. pace_frame blocks until then and should come before input is read;
+        // it returns at once in the default mode.
+        [[nodiscard]] bool low_latency() const noexcept;
+        void pace_frame() noexcept;
+        [[nodiscard]] present_latency_stats latency_stats() const noexcept;
+
         void present(const cpu_frame& frame) noexcept;
 
+        // Shows the last presented frame again under a fresh UI pass, for frames with nothing new
+        void present_again() noexcept;
+
         // Wait until any in flight work is drained
         void flush() noexcept;
         void clear_backbuffer_rgba8(std::uint32_t rgba) noexcept;
@@ -90,9 +114,11 @@ namespace fox
         [[nodiscard]] std::uint32_t height() const noexcept;
         [[nodiscard]] std::uint32_t pending_frames() const noexcept;
 
-        void record_begin() noexcept;
+        // Captures stream to disk (default captures/capture.fxr) and play back from the same file.
+        // Safe from any thread; record_end returns false when the capture lost frames to a failed write.
+        void record_begin(const char* path = nullptr) noexcept;
         void record_submit(const cpu_frame& frame) noexcept;
-        void record_end() noexcept;
+        bool record_end() noexcept;
 
         [[nodiscard]] std::uint32_t record_frame_count() const noexcept;
         void playback_start(bool loop) noexcept;
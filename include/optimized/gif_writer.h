@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace fox
+{
+    struct gif_settings
+    {
+        std::uint32_t delay_cs = 4;  // per frame, in the hundredths of a second GIF counts in
+        bool          dither   = true; // Floyd-Steinberg against the frame's palette
+        std::uint32_t encoders = 0;  // worker threads, 0 for half the hardware threads
+    };
+
+    // Streams frames into a looping GIF. Every frame gets its own 256 colour palette, so frames
+    // quantize, dither and LZW code on encoder threads independently of each other; a writer thread
+    // appends them to the file in submit order. submit() copies the frame and returns, waiting only
+    // while a few frames per encoder are queued or coded but not yet written, so memory stays bounded
+    // however long the sequence runs. Takes the same submit(color, pitch_pixels) as frame_recorder.
+    class gif_writer
+    {
+    public:
+        gif_writer();
+        ~gif_writer();
+
+        gif_writer(const gif_writer&)            = delete;
+        gif_writer& operator=(const gif_writer&) = delete;
+
+        [[nodiscard]] bool open(const char* path, std::uint32_t w, std::uint32_t h, const gif_settings& settings = {}) noexcept;
+        void submit(const std::uint32_t* color, std::uint32_t pitch_pixels) noexcept;
+
+        // Writes out every frame still queued and closes the file
+        void close() noexcept;
+
+        [[nodiscard]] bool is_open() const noexcept;
+        [[nodiscard]] std::uint32_t frame_count() const noexcept; // submitted since the last open
+        [[nodiscard]] bool failed() const noexcept;               // a write failed since the last open
+
+    private:
+        class impl;
+        std::unique_ptr<impl> p_;
+    };
+
+    // Converts a capture gfx_dx11 recorded (frame_player reads it) to a GIF, every step-th frame.
+    // False when either file fails to open, the capture holds no frames or a write fails.
+    [[nodiscard]] bool export_capture_gif(const char* capture_path, const char* gif_path,
+                                          const gif_settings& settings = {}, std::uint32_t step = 1) noexcept;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "optimized/types.h"
+
+namespace fox
+{
+    // Writes what platform_window held after each poll_messages, with that frame's delta time, so a
+    // session can be played back frame for frame. Frames store only the fields that changed since
+    // the one before, keys as the list of keys that toggled; a frame of a held key costs five bytes.
+    class input_recorder
+    {
+    public:
+        input_recorder();
+        ~input_recorder();
+
+        input_recorder(const input_recorder&)            = delete;
+        input_recorder& operator=(const input_recorder&) = delete;
+
+        [[nodiscard]] bool open(const char* path) noexcept;
+        void record(const input_state& state, float dt) noexcept;
+
+        // Writes out whatever is still buffered and closes the file
+        void close() noexcept;
+
+        [[nodiscard]] bool is_open() const noexcept;
+        [[nodiscard]] std::uint32_t frame_count() const noexcept; // recorded since the last open
+
+    private:
+        class impl;
+        std::unique_ptr<impl> p_;
+    };
+
+    // Reads an input_recorder log back a frame at a time
+    class input_player
+    {
+    public:
+        input_player();
+        ~input_player();
+
+        input_player(const input_player&)            = delete;
+        input_player& operator=(const input_player&) = delete;
+
+        [[nodiscard]] bool open(const char* path) noexcept;
+        void close() noexcept;
+
+        // The next frame's input and delta time; false once the log runs out or turns out truncated
+        [[nodiscard]] bool next(input_state& state, float& dt) noexcept;
+
+        [[nodiscard]] bool is_open() const noexcept;
+        [[nodiscard]] std::uint32_t frame_count() const noexcept; // played since the last open
+
+    private:
+        class impl;
+        std::unique_ptr<impl> p_;
+    };
+}
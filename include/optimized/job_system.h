@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fox
+{
+    // Work-stealing scheduler. Every thread owns a Chase-Lev deque: the owner pushes and pops
+    // at the bottom, idle threads steal from the top. The calling thread always takes part in
+    // the work it submits, so parallel_for never blocks on a sleeping pool. Up to
+    // kMaxExternalThreads outside threads (main, render) can submit at the same time.
+    class job_system final
+    {
+    public:
+        using range_fn = void(*)(void* ctx, std::uint32_t begin, std::uint32_t end);
+
+        static constexpr std::uint32_t kMaxExternalThreads = 4;
+
+        static job_system& instance() noexcept;
+
+        job_system(const job_system&) = delete;
+        job_system& operator=(const job_system&) = delete;
+
+        // Threads that execute tasks, including the submitting thread
+        [[nodiscard]] std::uint32_t thread_count() const noexcept { return m_thread_count; }
+
+        // Per thread state can be indexed by slot: workers and the first kMaxExternalThreads
+        // outside threads get one in [0, slot_count()), any other thread -1
+        [[nodiscard]] std::uint32_t slot_count() const noexcept { return m_deque_count; }
+        [[nodiscard]] int current_slot() noexcept { return acquire_local_index(); }
+
+        // Splits [0, count) into ranges of at most `grain` items and runs fn(begin, end) on them.
+        // Returns once every range has finished; safe to call from inside a task.
+        template<class Fn>
+        void parallel_for(std::uint32_t count, std::uint32_t grain, Fn&& fn) noexcept
+        {
+            using fn_t = std::remove_reference_t<Fn>;
+            run(count, grain,
+                [](void* ctx, std::uint32_t begin, std::uint32_t end)
+                {
+                    (*static_cast<fn_t*>(ctx))(begin, end);
+                },
+                const_cast<void*>(static_cast<const void*>(&fn)));
+        }
+
+    private:
+        job_system() noexcept;
+        ~job_system();
+
+        struct task
+        {
+            range_fn                    fn = nullptr;
+            void*                       ctx = nullptr;
+            std::uint32_t               begin = 0;
+            std::uint32_t               end = 0;
+            std::atomic<std::uint32_t>* remaining = nullptr;
+        };
+
+        class work_deque
+        {
+        public:
+            static constexpr std::int64_t kCapacity = 4096;
+
+            bool push(task* t) noexcept;
+            task* pop() noexcept;
+            task* steal() noexcept;
+
+        private:
+            alignas(64) std::atomic<std::int64_t> m_top{ 0 };
+            alignas(64) std::atomic<std::int64_t> m_bottom{ 0 };
+            std::atomic<task*> m_buffer[kCapacity]{};
+        };
+
+        // Task storage for the run calls in flight on one slot's thread, nested calls above the outer
+        // ones; only its owner pushes and pops
+        struct task_stack
+        {
+            static constexpr std::uint32_t kCapacity = 1024;
+
+            task          tasks[kCapacity]{};
+            std::uint32_t top = 0;
+        };
+
+        void run(std::uint32_t count, std::uint32_t grain, range_fn fn, void* ctx) noexcept;
+        void worker_loop(std::uint32_t index) noexcept;
+
+        [[nodiscard]] int acquire_local_index() noexcept;
+        [[nodiscard]] task* find_task(std::uint32_t self) noexcept;
+        static void execute(task* t) noexcept;
+
+        std::uint32_t                 m_thread_count = 1;
+        std::uint32_t                 m_deque_count  = 1; // external slots first, then workers
+        std::unique_ptr<work_deque[]> m_deques{};
+        std::unique_ptr<task_stack[]> m_task_stacks{}; // one per deque
+        std::vector<std::thread>      m_threads{};
+
+        std::atomic<bool>          m_shutdown{ false };
+        std::atomic<std::uint32_t> m_external_claimed{ 0 };
+        std::atomic<std::uint32_t> m_work_epoch{ 0 };
+    };
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fox
+{
+    // Subsystems whose heap memory is counted, each where it allocates and frees
+    enum class mem_tag : std::uint8_t
+    {
+        meshes,   // MeshAssetPN streams of static meshes, LODs and dynamic mesh bind poses
+        skinned,  // per instance skinned vertices of dynamic_mesh_instance
+        textures, // texture_cache texels
+        ecs,      // fecs column chunks
+        gfx,      // gfx_dx11 swap slot colour and depth buffers
+        capture,  // frame_recorder and image_sequence_writer queues, frame_player read-ahead
+        count
+    };
+
+    inline constexpr std::size_t kMemTagCount = (std::size_t)mem_tag::count;
+
+    // 0 turns either limit off. Going over soft is only reported; past hard the owner of the memory
+    // is expected to give some back (game_world trims textures and streamed cells).
+    struct mem_budget
+    {
+        std::size_t soft_bytes = 0;
+        std::size_t hard_bytes = 0;
+    };
+
+    enum class mem_budget_state : std::uint8_t { ok, soft, hard };
+
+    struct mem_tag_stats
+    {
+        std::uint64_t live_bytes = 0;
+        std::uint64_t peak_bytes = 0;
+        std::uint64_t allocations = 0; // since startup
+        mem_budget budget{};
+        mem_budget_state state = mem_budget_state::ok;
+    };
+
+    [[nodiscard]] const char* mem_tag_name(mem_tag tag) noexcept;
+
+    // Relaxed atomics, callable from any thread; loads and encoders allocate off the main thread
+    void mem_track_alloc(mem_tag tag, std::size_t bytes) noexcept;
+    void mem_track_free(mem_tag tag, std::size_t bytes) noexcept;
+
+    [[nodiscard]] std::uint64_t mem_live_bytes(mem_tag tag) noexcept;
+    [[nodiscard]] mem_tag_stats mem_stats(mem_tag tag) noexcept;
+
+    void set_mem_budget(mem_tag tag, const mem_budget& budget) noexcept;
+    [[nodiscard]] mem_budget get_mem_budget(mem_tag tag) noexcept;
+    [[nodiscard]] mem_budget_state mem_budget_check(mem_tag tag) noexcept;
+}
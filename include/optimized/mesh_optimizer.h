@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Load time index reordering for indexed meshes
+
+// Run of consecutive triangles, culled as a whole before any of them is set up. Mesh local.
+struct mesh_cluster
+{
+    float         centre[3];
+    float         radius;
+    // Unit average face normal (counter-clockwise winding). Every triangle faces away from an eye where
+    // dot(centre - eye, axis) >= cone_cutoff * |centre - eye| + radius; a cutoff of 1 never passes.
+    float         axis[3];
+    float         cone_cutoff;
+    std::uint32_t tri_begin;
+    std::uint32_t tri_count;
+};
+
+// Reorders triangles for a small LRU post-transform cache (Forsyth's linear-speed heuristic).
+// The triangle set is preserved, winding of each triangle is kept.
+void optimize_vertex_cache(std::uint32_t* indices, std::uint32_t tri_count, std::uint32_t vertex_count) noexcept;
+
+// Regroups triangles into clusters of up to max_tris, each grown over shared vertices from the first
+// triangle left in the current order, preferring those facing the way the cluster does. Winding is
+// kept. Returns the clusters in the new triangle order, covering every triangle once.
+[[nodiscard]] std::vector<mesh_cluster> build_mesh_clusters(
+    std::uint32_t* indices,
+    std::uint32_t tri_count,
+    const float* positions,
+    std::size_t position_stride,
+    std::uint32_t vertex_count,
+    std::uint32_t max_tris);
+
+// Renumbers vertices in first-use order so the vertex stage reads memory linearly.
+// Rewrites indices and returns remap[old] = new; unreferenced vertices are moved to the end.
+[[nodiscard]] std::vector<std::uint32_t> optimize_vertex_fetch(std::uint32_t* indices, std::uint32_t tri_count, std::uint32_t vertex_count);
+
+// Applies a remap from optimize_vertex_fetch to one per-vertex attribute array of `stride` elements
+template<class T>
+void remap_vertex_attribute(T* data, std::uint32_t vertex_count, std::uint32_t stride, const std::vector<std::uint32_t>& remap)
+{
+    std::vector<T> tmp(data, data + (std::size_t)vertex_count * stride);
+    for (std::uint32_t v = 0; v < vertex_count; ++v)
+    {
+        for (std::uint32_t k = 0; k < stride; ++k)
+            data[(std::size_t)remap[v] * stride + k] = tmp[(std::size_t)v * stride + k];
+    }
+}
+
+// Quadric error edge collapse (Garland-Heckbert). Vertices collapse onto a neighbour, so the result
+// indexes the input vertex arrays. Vertices on open or seam edges stay put, keeping splits crack free.
+// Writes the surviving triangles to out_indices and returns their count. Stops at target_tri_count or
+// before a collapse whose error exceeds max_error (object space distance); out_error gets the largest taken.
+[[nodiscard]] std::uint32_t simplify_mesh(
+    std::vector<std::uint32_t>& out_indices,
+    const std::uint32_t* indices,
+    std::uint32_t tri_count,
+    const float* positions,
+    std::size_t position_stride,
+    std::uint32_t vertex_count,
+    std::uint32_t target_tri_count,
+    float max_error,
+    float* out_error = nullptr);
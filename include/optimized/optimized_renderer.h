@@ -4,17 +4,27 @@
 #include "gfx_dx11.h"
 #include "platform_windows.h"
 #include "fecs.h"
+#include "job_system.h"
+#include "frame_arena.h"
 #include "mesh.h"
 #include "light.h"
+#include "texture_cache.h"
+#include "raster_kernels.h"
+#include "mesh_optimizer.h"
+#include "memory_stats.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
+#include <span>
+#include <memory>
 #include <cstddef>
 #include <utility>
 #include <limits>
 #include <cmath>
 #include <cstring>
 
+#include <chrono>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -49,21 +59,158 @@ struct FramebufferRGBA8
     }
 };
 
+enum class depth_format : std::uint8_t
+{
+    f32,     // float per pixel, the frame's own depth plane
+    unorm16, // round(z * 65535) in a renderer owned plane, half the bytes to clear and test
+};
+
+[[nodiscard]] inline std::uint16_t depth16_encode(float z) noexcept
+{
+    return (std::uint16_t)((std::min)((std::max)(z, 0.f), 1.f) * 65535.f + 0.5f);
+}
+
+[[nodiscard]] inline float depth16_decode(std::uint16_t q) noexcept
+{
+    return (float)q * (1.f / 65535.f);
+}
+
+// Larger is closer. Exactly one of data / data16 is set, matching format; pitch is in elements
 struct ZBufferF32
 {
-    std::uint32_t w     = 0;
-    std::uint32_t h     = 0;
-    std::uint32_t pitch = 0;
-    float*        data  = nullptr;
+    std::uint32_t  w      = 0;
+    std::uint32_t  h      = 0;
+    std::uint32_t  pitch  = 0;
+    float*         data   = nullptr;
+    std::uint16_t* data16 = nullptr;
+    depth_format   format = depth_format::f32;
+
+    [[nodiscard]] bool valid() const noexcept { return (data || data16) && w != 0 && h != 0; }
+
+    [[nodiscard]] float at(std::uint32_t x, std::uint32_t y) const noexcept
+    {
+        const std::size_t i = (std::size_t)y * (std::size_t)pitch + (std::size_t)x;
+        return data16 ? depth16_decode(data16[i]) : data[i];
+    }
+};
+
+// Bytes of the vertex, uv and index streams of a mesh, triangle soup unless indexed
+[[nodiscard]] inline std::size_t mesh_stream_bytes(std::uint32_t verts, std::uint32_t tris, bool uvs, bool indexed) noexcept
+{
+    std::size_t bytes = sizeof(vec4) * 2u * (std::size_t)verts;
+    if (uvs)     bytes += sizeof(float) * 2u * (std::size_t)verts;
+    if (indexed) bytes += sizeof(std::uint32_t) * 3u * (std::size_t)tris;
+    return bytes;
+}
+
+// Quantized vertex, 16 bytes; pos[3] is 1 so (q, 1) goes straight through a dequantizing clip matrix
+struct quant_vertex
+{
+    std::uint16_t pos[4];   // unorm16 over the mesh bounds
+    std::int16_t  oct[2];   // normal, octahedral snorm16
+    std::uint16_t uv[2];    // unorm16 over the mesh's UV range
 };
+static_assert(sizeof(quant_vertex) == 16, "quant_vertex is one SSE load");
+
+// Header of a quantized vertex stream; vertex_count quant_vertex follow it on the next cache line
+struct alignas(64) quant_stream
+{
+    vec4          pos_offset{};   // position = pos_offset + q * pos_scale
+    vec4          pos_scale{};
+    float         uv_offset[2]{};
+    float         uv_scale[2]{};
+    std::uint32_t vertex_count = 0;
+
+    [[nodiscard]] const quant_vertex* vertices() const noexcept { return reinterpret_cast<const quant_vertex*>(this + 1); }
+    [[nodiscard]] quant_vertex* vertices() noexcept { return reinterpret_cast<quant_vertex*>(this + 1); }
+};
+static_assert(sizeof(quant_stream) == 64, "quant_stream header grew past one cache line");
+
+[[nodiscard]] inline std::size_t quant_stream_bytes(std::uint32_t verts) noexcept
+{
+    return sizeof(quant_stream) + sizeof(quant_vertex) * (std::size_t)verts;
+}
+
+[[nodiscard]] inline std::int16_t snorm16_encode(float v) noexcept
+{
+    return (std::int16_t)std::lround((std::min)((std::max)(v, -1.f), 1.f) * 32767.f);
+}
+
+// Unit normal folded onto the octahedron |x| + |y| + |z| = 1, the lower half mirrored over the diagonals
+inline void oct_encode(const vec4& n, std::int16_t out[2]) noexcept
+{
+    const float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    float x = l1 > 0.f ? n.x / l1 : 0.f;
+    float y = l1 > 0.f ? n.y / l1 : 0.f;
+    if (l1 > 0.f && n.z < 0.f)
+    {
+        const float fx = (1.f - std::fabs(y)) * (x >= 0.f ? 1.f : -1.f);
+        const float fy = (1.f - std::fabs(x)) * (y >= 0.f ? 1.f : -1.f);
+        x = fx;
+        y = fy;
+    }
+    out[0] = snorm16_encode(x);
+    out[1] = snorm16_encode(y);
+}
+
+[[nodiscard]] inline vec4 oct_decode(const std::int16_t q[2]) noexcept
+{
+    float x = (float)q[0] * (1.f / 32767.f);
+    float y = (float)q[1] * (1.f / 32767.f);
+    const float z = 1.f - std::fabs(x) - std::fabs(y);
+    const float t = (std::max)(-z, 0.f);
+    x += x >= 0.f ? -t : t;
+    y += y >= 0.f ? -t : t;
+    vec4 n(x, y, z, 0.f);
+    n.normalise();
+    return n;
+}
+
+// Object space from the raw (q, 1) of a quant_vertex
+[[nodiscard]] inline matrix quant_position_matrix(const quant_stream& q) noexcept
+{
+    matrix m{};
+    for (unsigned int k = 0; k < 3; ++k)
+    {
+        m(k, k) = q.pos_scale[k];
+        m(k, 3) = q.pos_offset[k];
+    }
+    return m;
+}
+
+[[nodiscard]] inline vec4 quant_raw_position(const quant_vertex& v) noexcept
+{
+    return vec4((float)v.pos[0], (float)v.pos[1], (float)v.pos[2], 1.f);
+}
+
+[[nodiscard]] inline vec4 quant_position(const quant_stream& q, std::uint32_t i) noexcept
+{
+    const quant_vertex& v = q.vertices()[i];
+    return vec4(q.pos_offset.x + (float)v.pos[0] * q.pos_scale.x,
+                q.pos_offset.y + (float)v.pos[1] * q.pos_scale.y,
+                q.pos_offset.z + (float)v.pos[2] * q.pos_scale.z,
+                1.f);
+}
+
+inline void quant_uv(const quant_stream& q, std::size_t i, float& u, float& v) noexcept
+{
+    const quant_vertex& qv = q.vertices()[i];
+    u = q.uv_offset[0] + (float)qv.uv[0] * q.uv_scale[0];
+    v = q.uv_offset[1] + (float)qv.uv[1] * q.uv_scale[1];
+}
 
 struct MeshAssetPN
 {
-    vec4*         positions = nullptr;
-    vec4*         normals   = nullptr;
-    float*        uvs       = nullptr; // 2 floats per vertex (u,v), 6 per triangle
-    std::uint32_t tri_count = 0;
-    bool          has_uvs   = false;
+    vec4*          positions    = nullptr;
+    vec4*          normals      = nullptr;
+    float*         uvs          = nullptr; // 2 floats per vertex (u,v)
+    std::uint32_t* indices      = nullptr; // 3 per triangle, null for triangle soup
+    quant_stream*  quant        = nullptr; // set by quantize, which frees the three float streams
+    std::uint32_t  tri_count    = 0;
+    std::uint32_t  vertex_count = 0;
+    bool           has_uvs      = false;
+    fox::mem_tag   tag          = fox::mem_tag::meshes;
+    std::size_t    tracked_bytes = 0; // counted against tag, every stream allocated
 
     static constexpr std::size_t ALIGN_BYTES = 64;
 
@@ -80,155 +227,556 @@ struct MeshAssetPN
             positions = o.positions;
             normals = o.normals;
             uvs = o.uvs;
+            indices = o.indices;
+            quant = o.quant;
             tri_count = o.tri_count;
+            vertex_count = o.vertex_count;
             has_uvs = o.has_uvs;
+            tag = o.tag;
+            tracked_bytes = o.tracked_bytes;
             o.positions = nullptr;
             o.normals = nullptr;
             o.uvs = nullptr;
+            o.indices = nullptr;
+            o.quant = nullptr;
             o.tri_count = 0;
+            o.vertex_count = 0;
             o.has_uvs = false;
+            o.tracked_bytes = 0;
         }
         return *this;
     }
 
     void destroy() noexcept
     {
+        fox::mem_track_free(tag, tracked_bytes);
+        tracked_bytes = 0;
         if (positions) _aligned_free(positions);
         if (normals)   _aligned_free(normals);
         if (uvs)       _aligned_free(uvs);
+        if (indices)   _aligned_free(indices);
+        if (quant)     _aligned_free(quant);
         positions = nullptr;
         normals = nullptr;
         uvs = nullptr;
+        indices = nullptr;
+        quant = nullptr;
         tri_count = 0;
+        vertex_count = 0;
         has_uvs = false;
     }
 
     ~MeshAssetPN() noexcept { destroy(); }
 
+    [[nodiscard]] std::size_t resident_bytes() const noexcept
+    {
+        if (quant)
+            return quant_stream_bytes(vertex_count) + sizeof(std::uint32_t) * 3u * (std::size_t)tri_count;
+        return positions ? mesh_stream_bytes(vertex_count, tri_count, uvs != nullptr, indices != nullptr) : 0u;
+    }
+
+    // Swaps the float streams for one quant_stream; indexed meshes only
+    void quantize() noexcept
+    {
+        if (quant || !positions || !normals || !indices || vertex_count == 0)
+            return;
+
+        quant = static_cast<quant_stream*>(alloc_stream(quant_stream_bytes(vertex_count)));
+        std::memset((void*)quant, 0, sizeof(quant_stream));
+        quant->vertex_count = vertex_count;
+
+        vec4 lo = positions[0];
+        vec4 hi = positions[0];
+        float uv_lo[2] = { 0.f, 0.f };
+        float uv_hi[2] = { 0.f, 0.f };
+        if (uvs)
+        {
+            uv_lo[0] = uv_hi[0] = uvs[0];
+            uv_lo[1] = uv_hi[1] = uvs[1];
+        }
+        for (std::uint32_t v = 1; v < vertex_count; ++v)
+        {
+            for (unsigned int k = 0; k < 3; ++k)
+            {
+                lo[k] = (std::min)(lo[k], positions[v][k]);
+                hi[k] = (std::max)(hi[k], positions[v][k]);
+            }
+            if (uvs)
+            {
+                for (unsigned int k = 0; k < 2; ++k)
+                {
+                    uv_lo[k] = (std::min)(uv_lo[k], uvs[v * 2u + k]);
+                    uv_hi[k] = (std::max)(uv_hi[k], uvs[v * 2u + k]);
+                }
+            }
+        }
+
+        // A flat axis keeps scale 0, every vertex on it decoding to the offset exactly
+        float pos_inv[3]{}, uv_inv[2]{};
+        for (unsigned int k = 0; k < 3; ++k)
+        {
+            const float extent = hi[k] - lo[k];
+            quant->pos_offset[k] = lo[k];
+            quant->pos_scale[k] = extent / 65535.f;
+            pos_inv[k] = extent > 0.f ? 65535.f / extent : 0.f;
+        }
+        quant->pos_offset[3] = 1.f;
+        for (unsigned int k = 0; k < 2; ++k)
+        {
+            const float extent = uv_hi[k] - uv_lo[k];
+            quant->uv_offset[k] = uv_lo[k];
+            quant->uv_scale[k] = extent / 65535.f;
+            uv_inv[k] = extent > 0.f ? 65535.f / extent : 0.f;
+        }
+
+        const auto unorm16 = [](float v) noexcept
+        {
+            return (std::uint16_t)(std::min)((std::max)(v + 0.5f, 0.f), 65535.f);
+        };
+        quant_vertex* out = quant->vertices();
+        for (std::uint32_t v = 0; v < vertex_count; ++v)
+        {
+            quant_vertex& q = out[v];
+            for (unsigned int k = 0; k < 3; ++k)
+                q.pos[k] = unorm16((positions[v][k] - lo[k]) * pos_inv[k]);
+            q.pos[3] = 1u;
+            oct_encode(normals[v], q.oct);
+            q.uv[0] = uvs ? unorm16((uvs[v * 2u + 0] - uv_lo[0]) * uv_inv[0]) : 0u;
+            q.uv[1] = uvs ? unorm16((uvs[v * 2u + 1] - uv_lo[1]) * uv_inv[1]) : 0u;
+        }
+
+        const std::size_t float_bytes = sizeof(vec4) * 2u * (std::size_t)vertex_count
+                                      + (uvs ? sizeof(float) * 2u * (std::size_t)vertex_count : 0u);
+        fox::mem_track_free(tag, float_bytes);
+        tracked_bytes -= float_bytes;
+        _aligned_free(positions);
+        _aligned_free(normals);
+        if (uvs) _aligned_free(uvs);
+        positions = nullptr;
+        normals = nullptr;
+        uvs = nullptr;
+    }
+
     void allocate(std::uint32_t count, bool alloc_uvs = false) noexcept
     {
-        destroy();
+        allocate_vertices(count * 3u, alloc_uvs);
+        tri_count = count;
+    }
+
+    void allocate_indexed(std::uint32_t count, std::uint32_t verts, bool alloc_uvs = false) noexcept
+    {
+        allocate_vertices(verts, alloc_uvs);
         tri_count = count;
+        indices = static_cast<std::uint32_t*>(alloc_stream(sizeof(std::uint32_t) * (std::size_t)count * 3u));
+    }
+
+    // Vertex arrays only, for per instance buffers that borrow indices and UVs from a shared asset
+    void allocate_vertices(std::uint32_t verts, bool alloc_uvs = false, fox::mem_tag as = fox::mem_tag::meshes) noexcept
+    {
+        destroy();
+        tag = as;
+        vertex_count = verts;
         has_uvs = alloc_uvs;
-        const std::size_t verts = (std::size_t)count * 3u;
-        positions = static_cast<vec4*>(_aligned_malloc(sizeof(vec4) * verts, ALIGN_BYTES));
-        normals   = static_cast<vec4*>(_aligned_malloc(sizeof(vec4) * verts, ALIGN_BYTES));
+        positions = static_cast<vec4*>(alloc_stream(sizeof(vec4) * (std::size_t)verts));
+        normals   = static_cast<vec4*>(alloc_stream(sizeof(vec4) * (std::size_t)verts));
         if (alloc_uvs)
         {
-            uvs = static_cast<float*>(_aligned_malloc(sizeof(float) * verts * 2u, ALIGN_BYTES));
-            std::memset(uvs, 0, sizeof(float) * verts * 2u);
+            uvs = static_cast<float*>(alloc_stream(sizeof(float) * (std::size_t)verts * 2u));
+            std::memset(uvs, 0, sizeof(float) * (std::size_t)verts * 2u);
+        }
+    }
+
+private:
+    [[nodiscard]] void* alloc_stream(std::size_t bytes) noexcept
+    {
+        void* p = _aligned_malloc(bytes, ALIGN_BYTES);
+        if (p)
+        {
+            tracked_bytes += bytes;
+            fox::mem_track_alloc(tag, bytes);
         }
+        return p;
     }
 };
 
 struct alignas(64) MeshRefPN
 {
-    const vec4*   positions = nullptr;
-    const vec4*   normals   = nullptr;
-    const float*  uvs       = nullptr; // 2 floats per vertex, null if no UVs
-    std::uint32_t tri_count = 0;
-    bool          has_uvs   = false;
+    const vec4*          positions    = nullptr;
+    const vec4*          normals      = nullptr;
+    const float*         uvs          = nullptr; // 2 floats per vertex, null if no UVs
+    const std::uint32_t* indices      = nullptr; // 3 per triangle, null for triangle soup
+    std::uint32_t        tri_count    = 0;
+    std::uint32_t        vertex_count = 0;
+    bool                 has_uvs      = false;
+    std::uint8_t         lod_count    = 0;
+    float                lod_radius_px = 0.f;       // this level is drawn once the bounding sphere projects smaller
+    const MeshRefPN*     lods         = nullptr;    // coarser levels, finest first, sharing the entity's bounds
+    const quant_stream*  quant        = nullptr;    // replaces positions, normals and uvs; indexed only
+};
+static_assert(sizeof(MeshRefPN) == 64, "MeshRefPN grew past one cache line");
+
+// What one level of the ref points at, its LODs not included
+[[nodiscard]] inline std::size_t mesh_ref_bytes(const MeshRefPN& ref) noexcept
+{
+    if (ref.quant)
+        return quant_stream_bytes(ref.vertex_count) + sizeof(std::uint32_t) * 3u * (std::size_t)ref.tri_count;
+    return ref.positions ? mesh_stream_bytes(ref.vertex_count, ref.tri_count, ref.uvs != nullptr, ref.indices != nullptr) : 0u;
+}
+
+[[nodiscard]] inline bool mesh_ref_has_vertices(const MeshRefPN& ref) noexcept
+{
+    return ref.quant || (ref.positions && ref.normals);
+}
+
+// Object space position of vertex i whichever layout the ref has, for paths off the per frame ones
+[[nodiscard]] inline vec4 mesh_ref_position(const MeshRefPN& ref, std::uint32_t i) noexcept
+{
+    return ref.quant ? quant_position(*ref.quant, i) : ref.positions[i];
+}
+
+// Mesh local AABB, plus optional clusters over the finest level for sphere and cone tests
+struct alignas(64) Bounds
+{
+    vec4 local_min{};
+    vec4 local_max{};
+    const mesh_cluster*  clusters        = nullptr; // in triangle order
+    const std::uint32_t* cluster_indices = nullptr; // the MeshRefPN::indices they were built over
+    std::uint32_t        cluster_count   = 0;
 };
+static_assert(sizeof(Bounds) == 64, "Bounds grew past one cache line");
 
 struct alignas(64) Transform
 {
     matrix world{};
 };
 
+// Instanced draw: replaces Transform, drawing the mesh once per entry
+struct alignas(64) InstanceTransforms
+{
+    std::vector<Transform> worlds{};
+};
+
+// Which screen winding setup drops; front faces are counter-clockwise in NDC, nothing by default
+enum class cull_mode : std::uint8_t
+{
+    none,
+    back,
+    front,
+};
+
 struct alignas(64) Material
 {
-    colour col{};
-    float  ka = 0.75f;
-    float  kd = 0.75f;
+    colour    col{};
+    float     ka = 0.75f;
+    float     kd = 0.75f;
+    cull_mode cull = cull_mode::none;
+};
+
+// Point light on its own entity, falling off smoothly to nothing at radius
+struct alignas(64) PointLight
+{
+    vec4   position{};                  // world space
+    colour col{ 1.f, 0.8f, 0.55f };
+    float  radius    = 6.f;
+    float  intensity = 1.f;
+};
+
+// Entities whose mesh or transform changes every frame; their shadows go to a per frame overlay
+struct DynamicCaster
+{
 };
 
-// Texture reference component - points to cached CPU texture data
+// Texture reference component - points to cached CPU texture data (tiled mip chain)
 struct alignas(64) TextureRef
 {
-    const std::uint32_t* pixels = nullptr;
+    const std::uint32_t* pixels      = nullptr;
+    const std::uint32_t* mip_offsets = nullptr; // per level, in texels from pixels
     std::uint32_t tex_w = 0;
     std::uint32_t tex_h = 0;
+    std::uint32_t mip_count = 0;
+    std::uint32_t log2_w = 0; // only meaningful when pow2
+    std::uint32_t log2_h = 0;
+    bool          pow2 = false;
+    texture_format format = texture_format::rgba8; // bc1 tiles decode per sample, see bc1_decode_texel
+
+    [[nodiscard]] bool valid() const noexcept { return pixels && mip_offsets && tex_w > 0 && tex_h > 0 && mip_count > 0; }
+
+    // Level for a pixel covering rho2 squared level 0 texels, floor(log2(sqrt(rho2)))
+    [[nodiscard]] std::uint32_t mip_for_footprint(float rho2) const noexcept
+    {
+        if (mip_count <= 1 || !(rho2 > 1.f)) return 0;
+        const std::uint32_t level = (std::uint32_t)std::ilogb(rho2) >> 1;
+        return (std::min)(level, mip_count - 1);
+    }
+
+    [[nodiscard]] std::uint32_t sample_nearest(float u, float v, std::uint32_t level = 0) const noexcept
+    {
+        if (format == texture_format::bc1)
+            return pow2 ? sample_nearest_as<true, true>(u, v, level) : sample_nearest_as<false, true>(u, v, level);
+        return pow2 ? sample_nearest_as<true, false>(u, v, level) : sample_nearest_as<false, false>(u, v, level);
+    }
+
+    // sample_nearest with pow2 and the bc1 format known up front, for kernels specialised on them
+    template<bool kPow2, bool kBc1>
+    [[nodiscard]] std::uint32_t sample_nearest_as(float u, float v, std::uint32_t level) const noexcept
+    {
+        const std::uint32_t w = mip_extent(tex_w, level);
+        const std::uint32_t h = mip_extent(tex_h, level);
 
-    [[nodiscard]] bool valid() const noexcept { return pixels && tex_w > 0 && tex_h > 0; }
+        if constexpr (kPow2)
+        {
+            // Two's complement masking wraps negative coordinates too, tiles per row is a shift
+            const std::uint32_t tx = (std::uint32_t)(std::int32_t)std::floor(u * (float)w) & (w - 1u);
+            const std::uint32_t ty = (std::uint32_t)(std::int32_t)std::floor(v * (float)h) & (h - 1u);
+            const std::uint32_t lw = log2_w > level ? log2_w - level : 0u;
+            const std::uint32_t row_shift = lw > 2u ? lw - 2u : 0u;
+            return fetch_as<kBc1>(mip_offsets[level] + ((((std::size_t)(ty >> 2) << row_shift) + (tx >> 2)) << 4) + ((ty & 3u) << 2) + (tx & 3u));
+        }
+        else
+        {
+            u = u - std::floor(u);
+            v = v - std::floor(v);
+            if (u < 0.f) u += 1.f;
+            if (v < 0.f) v += 1.f;
+            std::uint32_t tx = static_cast<std::uint32_t>(u * (float)w);
+            std::uint32_t ty = static_cast<std::uint32_t>(v * (float)h);
+            if (tx >= w) tx -= w;
+            if (ty >= h) ty -= h;
+            return fetch_as<kBc1>(mip_offsets[level] + tiled_texel_index(tx, ty, (w + kTextureTile - 1) / kTextureTile));
+        }
+    }
 
-    [[nodiscard]] std::uint32_t sample_nearest(float u, float v) const noexcept
+    // Texel at a tiled index into the chain
+    [[nodiscard]] std::uint32_t fetch(std::size_t t) const noexcept
     {
-        u = u - std::floor(u);
-        v = v - std::floor(v);
-        if (u < 0.f) u += 1.f;
-        if (v < 0.f) v += 1.f;
-        const std::uint32_t tx = static_cast<std::uint32_t>(u * (float)tex_w) % tex_w;
-        const std::uint32_t ty = static_cast<std::uint32_t>(v * (float)tex_h) % tex_h;
-        return pixels[(std::size_t)ty * (std::size_t)tex_w + (std::size_t)tx];
+        return format == texture_format::bc1 ? fetch_as<true>(t) : fetch_as<false>(t);
+    }
+
+    template<bool kBc1>
+    [[nodiscard]] std::uint32_t fetch_as(std::size_t t) const noexcept
+    {
+        if constexpr (kBc1)
+            return bc1_decode_texel(pixels + ((t >> 4) << 1), (std::uint32_t)t & 15u);
+        else
+            return pixels[t];
     }
 };
 
+static inline TextureRef make_texture_ref(const TextureRGBA8& t) noexcept
+{
+    TextureRef r{};
+    if (!t.valid()) return r;
+    r.pixels      = t.pixels;
+    r.mip_offsets = t.mip_offsets;
+    r.tex_w       = t.width;
+    r.tex_h       = t.height;
+    r.mip_count   = t.mip_count;
+    r.pow2        = t.pow2;
+    r.format      = t.format;
+    if (t.pow2)
+    {
+        r.log2_w = log2_pow2(t.width);
+        r.log2_h = log2_pow2(t.height);
+    }
+    return r;
+}
+
+// Remakes every TextureRef component still pointing at texels texture_cache::trim_to_budget replaced
+static inline void retarget_texture_refs(fecs::world& w, const std::vector<texture_trim>& trims)
+{
+    if (trims.empty())
+        return;
+
+    std::vector<texture_trim> sorted(trims);
+    std::sort(sorted.begin(), sorted.end(), [](const texture_trim& a, const texture_trim& b)
+    {
+        return a.old_pixels < b.old_pixels;
+    });
+
+    w.query<TextureRef>().each([&sorted](TextureRef* refs, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (!refs[i].pixels)
+                continue;
+            const auto it = std::lower_bound(sorted.begin(), sorted.end(), refs[i].pixels,
+                [](const texture_trim& t, const std::uint32_t* p) { return t.old_pixels < p; });
+            if (it != sorted.end() && it->old_pixels == refs[i].pixels)
+                refs[i] = make_texture_ref(*it->texture);
+        }
+    });
+}
+
 static inline MeshAssetPN build_asset_from_indexed_mesh(const Mesh& m) noexcept
 {
     MeshAssetPN a{};
     const std::uint32_t tri_count = (std::uint32_t)m.triangles.size();
-    a.allocate(tri_count, false);
+    const std::uint32_t vertex_count = (std::uint32_t)m.vertices.size();
+    a.allocate_indexed(tri_count, vertex_count, false);
+
+    for (std::uint32_t v = 0; v < vertex_count; ++v)
+    {
+        a.positions[v] = m.vertices[v].p;
+        a.normals[v]   = m.vertices[v].normal;
+        a.positions[v][3] = 1.f;
+        a.normals[v][3]   = 0.f;
+    }
 
     for (std::uint32_t t = 0; t < tri_count; ++t)
     {
         const triIndices& ind = m.triangles[t];
+        a.indices[t * 3u + 0] = ind.v0;
+        a.indices[t * 3u + 1] = ind.v1;
+        a.indices[t * 3u + 2] = ind.v2;
+    }
+
+    return a;
+}
+
+static inline Bounds compute_local_bounds(const vec4* positions, std::uint32_t count) noexcept
+{
+    Bounds b{};
+    if (!positions || count == 0) return b;
 
-        const Vertex& A = m.vertices[ind.v0];
-        const Vertex& B = m.vertices[ind.v1];
-        const Vertex& C = m.vertices[ind.v2];
+    b.local_min = positions[0];
+    b.local_max = positions[0];
+    for (std::uint32_t i = 1; i < count; ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            b.local_min[k] = (std::min)(b.local_min[k], positions[i][k]);
+            b.local_max[k] = (std::max)(b.local_max[k], positions[i][k]);
+        }
+    }
+    b.local_min[3] = 1.f;
+    b.local_max[3] = 1.f;
+    return b;
+}
 
-        const std::size_t base = (std::size_t)t * 3u;
+static inline Bounds compute_local_bounds(const MeshAssetPN& asset) noexcept
+{
+    // The quantization range is the AABB the stream was built over
+    if (asset.quant)
+    {
+        Bounds b{};
+        b.local_min = asset.quant->pos_offset;
+        b.local_max = asset.quant->pos_offset + asset.quant->pos_scale * 65535.f;
+        b.local_min[3] = 1.f;
+        b.local_max[3] = 1.f;
+        return b;
+    }
+    return compute_local_bounds(asset.positions, asset.vertex_count);
+}
 
-        a.positions[base + 0] = A.p;
-        a.positions[base + 1] = B.p;
-        a.positions[base + 2] = C.p;
+static inline MeshRefPN make_mesh_ref(const MeshAssetPN& asset) noexcept
+{
+    MeshRefPN r{};
+    r.positions    = asset.positions;
+    r.normals      = asset.normals;
+    r.uvs          = asset.uvs;
+    r.indices      = asset.indices;
+    r.quant        = asset.quant;
+    r.tri_count    = asset.tri_count;
+    r.vertex_count = asset.vertex_count;
+    r.has_uvs      = asset.has_uvs;
+    return r;
+}
 
-        a.normals[base + 0] = A.normal;
-        a.normals[base + 1] = B.normal;
-        a.normals[base + 2] = C.normal;
+static inline fecs::entity spawn_instance(
+    fecs::world& w,
+    const MeshRefPN& r,
+    const Bounds& bounds,
+    const matrix& world_mtx,
+    const colour& col,
+    float ka,
+    float kd,
+    const TextureRef& tex = {}) noexcept
+{
+    Transform tr{ world_mtx };
+    Material  mat{};
+    mat.col = col;
+    mat.ka  = ka;
+    mat.kd  = kd;
 
-        a.positions[base + 0][3] = 1.f;
-        a.positions[base + 1][3] = 1.f;
-        a.positions[base + 2][3] = 1.f;
+    return w.create_entity_with<MeshRefPN, Transform, Material, TextureRef, Bounds>(r, tr, mat, tex, bounds);
+}
 
-        a.normals[base + 0][3] = 0.f;
-        a.normals[base + 1][3] = 0.f;
-        a.normals[base + 2][3] = 0.f;
-    }
+// spawn_instance for a batch sharing one material, reserving the archetype and bumping the version once
+static inline void spawn_instances(
+    fecs::world& w,
+    std::span<const MeshRefPN> refs,
+    std::span<const Bounds> bounds,
+    std::span<const matrix> worlds,
+    std::span<const TextureRef> texs,
+    const colour& col,
+    float ka,
+    float kd,
+    std::vector<fecs::entity>& out) noexcept
+{
+    assert(bounds.size() == refs.size() && worlds.size() == refs.size());
+    assert(texs.empty() || texs.size() == refs.size());
 
-    return a;
+    w.create_entities<MeshRefPN, Transform, Material, TextureRef, Bounds>(refs.size(), out,
+        [&](std::size_t i, fecs::entity, MeshRefPN& r, Transform& tr, Material& mat, TextureRef& tex, Bounds& b)
+        {
+            r = refs[i];
+            tr.world = worlds[i];
+            mat.col = col;
+            mat.ka  = ka;
+            mat.kd  = kd;
+            if (!texs.empty()) tex = texs[i];
+            b = bounds[i];
+        });
 }
 
 static inline fecs::entity spawn_instance(
     fecs::world& w,
     const MeshAssetPN& asset,
+    const Bounds& bounds,
     const matrix& world_mtx,
     const colour& col,
     float ka,
     float kd,
     const TextureRef& tex = {}) noexcept
 {
-    fecs::entity e = w.create_entity();
+    return spawn_instance(w, make_mesh_ref(asset), bounds, world_mtx, col, ka, kd, tex);
+}
 
-    MeshRefPN r{};
-    r.positions = asset.positions;
-    r.normals   = asset.normals;
-    r.uvs       = asset.uvs;
-    r.tri_count = asset.tri_count;
-    r.has_uvs   = asset.has_uvs;
+// One entity drawing the mesh at every worlds[i]; bounds are local and shared by all instances
+static inline fecs::entity spawn_instanced(
+    fecs::world& w,
+    const MeshRefPN& mesh,
+    const Bounds& bounds,
+    const matrix* worlds,
+    std::size_t count,
+    const colour& col,
+    float ka,
+    float kd,
+    const TextureRef& tex = {}) noexcept
+{
+    InstanceTransforms inst{};
+    inst.worlds.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+        inst.worlds[i].world = worlds[i];
 
-    Transform tr{ world_mtx };
-    Material  mat{};
+    Material mat{};
     mat.col = col;
     mat.ka  = ka;
     mat.kd  = kd;
 
-    w.add_component<MeshRefPN>(e, r);
-    w.add_component<Transform>(e, tr);
-    w.add_component<Material>(e, mat);
-    w.add_component<TextureRef>(e, tex);
+    return w.create_entity_with<MeshRefPN, InstanceTransforms, Material, TextureRef, Bounds>(mesh, inst, mat, tex, bounds);
+}
 
-    return e;
+static inline fecs::entity spawn_instance(
+    fecs::world& w,
+    const MeshAssetPN& asset,
+    const matrix& world_mtx,
+    const colour& col,
+    float ka,
+    float kd,
+    const TextureRef& tex = {}) noexcept
+{
+    return spawn_instance(w, asset, compute_local_bounds(asset), world_mtx, col, ka, kd, tex);
 }
 
 struct SVtx
@@ -239,10 +787,10 @@ struct SVtx
     float  u, v; // texture coordinates
 };
 
+// n_ws is the world space normal, already normalised
 static inline SVtx make_svtx(
     const vec4& hp,
-    const matrix& world,
-    const vec4& nrm_os,
+    const vec4& n_ws,
     float fw,
     float fh,
     const colour& c,
@@ -287,8 +835,7 @@ static inline SVtx make_svtx(
     o.y = fh - o.y;
 #endif
 
-    o.n = world * nrm_os;
-    o.n.normalise();
+    o.n = n_ws;
     o.c = c;
     o.u = tex_u;
     o.v = tex_v;
@@ -298,9 +845,31 @@ static inline SVtx make_svtx(
 class optimized_renderer_core
 {
 public:
-    optimized_renderer_core(std::uint32_t w = 1024, std::uint32_t h = 768, const char* name = "FoxRasterizer");
+    optimized_renderer_core(std::uint32_t w = 1024, std::uint32_t h = 768, const char* name = "FoxRasterizer", bool low_latency = false);
+
+    // No window and no device: always renders offline, at w x h until set_offline_resolution
+    struct headless_t { explicit headless_t() = default; };
+    static constexpr headless_t headless{};
+    optimized_renderer_core(headless_t, std::uint32_t w, std::uint32_t h);
+
     ~optimized_renderer_core();
     void set_offline_rendering(bool v) noexcept;
+    void set_offline_resolution(std::uint32_t w, std::uint32_t h) noexcept;
+    [[nodiscard]] bool is_headless() const noexcept { return m_headless; }
+    [[nodiscard]] std::uint32_t offline_width() const noexcept { return m_offline_w; }
+    [[nodiscard]] std::uint32_t offline_height() const noexcept { return m_offline_h; }
+
+    // Hands the finished offline frame to a writer with submit(color, pitch_pixels)
+    template<class Sink>
+    void write_offline_frame(Sink& sink) noexcept
+    {
+        run_deferred();
+        if (framebuffer.data)
+            sink.submit(framebuffer.data, framebuffer.pitch_pixels);
+        framebuffer = {};
+        zbuffer = {};
+    }
+
     struct post_process_settings
     {
         bool  enabled = true;
@@ -358,6 +927,12 @@ public:
     void apply_post_process(const post_process_settings& settings) noexcept;
     void apply_rainy_effect(const rainy_effect_settings& settings, float time_s) noexcept;
     void apply_advanced_effects(const advanced_effects_settings& settings, float time_s) noexcept;
+
+    // Runs all three effect stacks; fused_post_effects sweeps them together per row block
+    void apply_post_effects(const post_process_settings& post,
+                            const rainy_effect_settings& rain,
+                            const advanced_effects_settings& advanced,
+                            float time_s) noexcept;
     optimized_renderer_core(const optimized_renderer_core&) = delete;
     optimized_renderer_core& operator=(const optimized_renderer_core&) = delete;
 
@@ -365,11 +940,155 @@ public:
     void draw_world(const matrix& cam, const Light& L, const vec4& light_dir) noexcept;
     void pin_draw_query_once() noexcept;
 
-    bool textures_enabled = true;
-    bool flip_v           = true;
+    // One extra camera drawn into targets the caller owns, e.g. a minimap or a split screen pane
+    struct render_view
+    {
+        matrix           cam{};
+        matrix           proj{};
+        FramebufferRGBA8 framebuffer{};
+        ZBufferF32       zbuffer{};
+    };
+    static constexpr std::size_t kMaxViews = 8;
+
+    // Draws up to kMaxViews views from one culled entity list; call between frames
+    void draw_world_views(const render_view* views, std::size_t count, const vec4& light_dir, std::uint32_t clear_rgba) noexcept;
+
+    bool textures_enabled   = true;
+    bool flip_v             = true;
+    bool fused_post_effects = true;
+    bool hierarchical_z     = true; // coarse 8x8 depth rejection ahead of per pixel tests
+    bool frustum_culling    = true; // per entity AABB test before any vertex is transformed
+    bool sort_front_to_back = true; // submit entities nearest first so depth rejects more pixels
+    bool wide_raster        = true; // use the widest raster kernel the CPU supports
+    bool visibility_buffer  = false; // raster depth and triangle ids first, then shade each visible pixel once
+    // Per tile depth prepass, then shading with an equal depth test; off under visibility ids and overdraw
+    bool depth_prepass      = false;
+    bool mesh_lod           = true; // draw coarser mesh levels as objects shrink on screen
+    bool occlusion_culling  = true; // skip entities hidden behind the largest ones on screen
+    bool cluster_culling    = true; // sphere and normal cone test per mesh cluster ahead of its triangles
+
+    // PointLight entities, binned per tile and added per pixel over the shaded colour
+    bool point_lights       = true;
+    static constexpr std::uint32_t kMaxLights     = 1024; // per frame, the first ones found
+    static constexpr std::uint32_t kMaxTileLights = 32;   // shaded in any one tile, nearest bins first
+
+    // Sun shadows: a cached map around the eye plus a per frame overlay for DynamicCaster entities
+    bool  shadows               = true;
+    float shadow_distance       = 96.f;  // half the side of the cached map, in world units
+    float shadow_update_degrees = 1.f;
+    float shadow_strength       = 0.6f;  // of its shade a fully shadowed pixel loses
+    float shadow_bias           = 0.05f; // world units toward the sun, on top of a texel and a half
+    static constexpr int kShadowMapSize     = 1024;
+    static constexpr int kShadowOverlaySize = 256;
+    static constexpr int kShadowBands       = 16;   // row bands the maps raster in, one task each
+    depth_format depth_mode = depth_format::f32;
+
+    // Heat maps in place of the shaded frame; post effects are skipped while one is on
+    enum class debug_view : std::uint8_t
+    {
+        none,
+        overdraw,
+        tile_cost,
+        triangle_density,
+        light_count,
+        count
+    };
+    static constexpr std::size_t kDebugViewCount = (std::size_t)debug_view::count;
+    static constexpr std::uint32_t kOverdrawHeatMax = 8; // depth tests that map to full red
+    [[nodiscard]] static const char* debug_view_name(debug_view view) noexcept;
+    debug_view debug_mode = debug_view::none;
+
+    // Raster, post process and present on a render thread while the caller updates the next frame
+    bool frame_pipelining = false;
+
+    // Returns once the pipelined frame, if any, has been handed to the canvas
+    void wait_frame_in_flight() noexcept;
+
+    // True when a frame begun now would match the last one drawn; show it with present_last_frame
+    [[nodiscard]] bool frame_unchanged(std::uint32_t clear_rgba, const matrix& cam, const vec4& light_dir) const noexcept;
+    void present_last_frame() noexcept;
+
+    // Redraw only the tiles whose binned triangles changed since the last frame
+    bool incremental_redraw = false;
+
+    // Shade every other pixel per frame and reproject or interpolate the rest
+    bool checkerboard = false;
+
+    // Render below the frame size and upscale on present; dynamic_resolution tracks target_frame_ms
+    bool  dynamic_resolution = false;
+    float render_scale       = 1.f;
+    float min_render_scale   = 0.5f;
+    float target_frame_ms    = 16.6f;
+
+    [[nodiscard]] float current_render_scale() const noexcept { return m_render_scale; }
+
+    [[nodiscard]] raster_isa best_raster_isa() const noexcept { return m_best_raster_isa; }
+
+    struct draw_stats
+    {
+        std::uint32_t entities_total  = 0;
+        std::uint32_t entities_culled = 0;
+        std::uint32_t entities_occluded = 0;    // inside the frustum but behind the occluders
+        std::uint32_t triangles_submitted = 0;
+        std::uint32_t triangles_culled = 0;     // of culled entities, plus those setup rejected
+        std::uint32_t clusters_tested = 0;      // a cluster split over two geometry batches counts twice
+        std::uint32_t clusters_culled = 0;      // outside the frustum or facing away, triangles and all
+        std::uint32_t triangles_rasterized = 0; // set up and binned
+        std::uint32_t tiles_reused = 0;         // kept from the last frame by incremental_redraw
+        std::uint32_t pixels_reprojected = 0;   // of those checkerboard left unshaded, taken from the last frame
+        std::uint32_t pixels_interpolated = 0;  // and those rebuilt from their neighbours
+        std::uint32_t lights_visible = 0;       // point lights in front of the camera and on screen
+        std::uint32_t light_tile_refs = 0;      // of those, summed over the tiles each was binned to
+        std::uint32_t shadow_casters = 0;       // in the cached map when it was last drawn
+        std::uint32_t shadow_dynamic_casters = 0;
+        bool shadow_map_redrawn = false;        // the cached map was drawn again this frame
+    };
+
+    enum class frame_pass : std::uint8_t
+    {
+        transform,    // culling, vertex transform and triangle setup
+        raster,
+        post,         // with fused_post_effects the fused sweep counts here
+        rain,
+        advanced,
+        present_wait, // waiting on the frame in flight, the canvas ring and the present
+        count
+    };
+    static constexpr std::size_t kFramePassCount = (std::size_t)frame_pass::count;
+    [[nodiscard]] static const char* frame_pass_name(frame_pass pass) noexcept;
+
+    // Always on, merged from per worker counters when the next frame begins
+    struct frame_stats
+    {
+        std::uint64_t frame_index = 0;
+        double frame_ms = 0.0; // begin_cpu_frame to begin_cpu_frame
+        double pass_ms[kFramePassCount]{};
+        std::vector<double> worker_busy_ms{};
+        draw_stats draw{};
+        std::uint64_t pixels_depth_tested = 0;
+        std::uint64_t pixels_shaded = 0;
+        std::uint64_t heap_allocations = 0; // frame arena blocks, see frame_heap_allocations
+        double tile_cost_max_ms = 0.0;      // slowest raster tile, only timed under debug_view::tile_cost
+        fox::present_latency_stats latency{};
+        std::uint64_t memory_bytes[fox::kMemTagCount]{}; // live bytes per mem_tag as the frame finished
+    };
+
+    [[nodiscard]] const frame_stats& last_frame_stats() const noexcept { return m_frame_stats; }
+
+    // Counters from the most recent draw_world
+    [[nodiscard]] const draw_stats& last_draw_stats() const noexcept { return m_draw_stats; }
+
+    // Blocks the scratch arenas took from the heap for the last finished frame, 0 in steady state
+    [[nodiscard]] std::uint64_t frame_heap_allocations() const noexcept { return m_frame_heap_allocations; }
+    [[nodiscard]] std::size_t frame_arena_bytes() const noexcept { return m_frame_arenas.capacity(); }
 
 private:
     bool m_offline = false;
+    bool m_headless = false;
+    std::uint32_t m_offline_w = 1024u;
+    std::uint32_t m_offline_h = 768u;
+
+    void init_world() noexcept;
 
     struct offline_targets_t
     {
@@ -382,6 +1101,49 @@ private:
     } m_offline_targets;
 
     void ensure_offline_targets(std::uint32_t w, std::uint32_t h) noexcept;
+
+    // Internal target below the frame size, pitched for the full frame
+    offline_targets_t m_scaled_targets;
+    float m_render_scale  = 1.f;
+    bool  m_scaled_active = false;
+    std::chrono::steady_clock::time_point m_frame_start{};
+    std::vector<std::uint32_t> m_upscale_x{}; // per frame column: source x << 8 | weight of x + 1
+
+    void bind_scaled_targets(float scale) noexcept;
+
+    // Incremental redraw: the kept raster and per tile triangle signatures
+    offline_targets_t m_retained_targets;
+    mutable std::vector<std::uint64_t> m_tile_sig{}; // this frame's, written by the worker rastering the tile
+    std::vector<std::uint64_t> m_retained_sig{};
+    std::uint64_t m_retained_key = 0;
+    bool m_retained_valid = false;
+    bool m_incremental    = false; // this frame draws over the kept raster
+    bool m_reuse_tiles    = false; // and may keep tiles whose signature matches
+
+    void bind_retained_targets() noexcept;
+    void stage_retained_frame() noexcept;
+    [[nodiscard]] std::uint64_t tile_signature(std::uint32_t tile) const noexcept;
+
+    // What the last frame drawn was drawn from, for frame_unchanged
+    struct frame_key
+    {
+        matrix cam{};
+        vec4   light_dir{};
+        std::uint64_t world_version = 0;
+        std::uint64_t settings = 0; // frame_settings_hash
+        std::uint64_t tick = 0;     // world tick taken as it was drawn
+        std::uint32_t clear_rgba = 0;
+        bool valid = false;
+    } m_last_frame{};
+
+    [[nodiscard]] std::uint64_t frame_settings_hash() const noexcept;
+    // Whether a frame with these inputs would draw what k was drawn from
+    [[nodiscard]] bool frame_inputs_match(const frame_key& k, std::uint32_t clear_rgba, const matrix& cam, const vec4& light_dir) const noexcept;
+
+    // 16 bit depth plane swapped in for the bound float one when depth_mode asks for it
+    std::vector<std::uint16_t> m_depth16{};
+    void bind_depth_format() noexcept;
+    [[nodiscard]] bool post_effects_read_frame() const noexcept;
 public:
     struct draw_pinned_block
     {
@@ -389,6 +1151,7 @@ public:
         Transform*   transforms   = nullptr;
         Material*    materials    = nullptr;
         TextureRef*  textures     = nullptr;
+        Bounds*      bounds       = nullptr;
         std::size_t  n            = 0;
     };
 
@@ -412,148 +1175,504 @@ public:
 protected:
     fox::cpu_frame cur_frame{};
 
-private:
-    enum class job_type : std::uint8_t
-    {
-        draw,
-        post_process,
-        rainy_effect,
-        advanced_effects
-    };
+    // Writes the internal target into cur_frame and updates the dynamic scale
+    void resolve_frame() noexcept;
+
+    // Tile raster and effects that draw_world and apply_post_effects left for the frame's present
+    void run_deferred() noexcept;
+
+    // Finishes and presents cur_frame, inline or on the render thread one frame behind
+    void present_frame() noexcept;
+    void submit_frame_async() noexcept;
 
-    job_type m_job_type = job_type::draw;
+private:
     void bind_targets_from_frame(const fox::cpu_frame& f) noexcept;
-    void clear_color_rgba(std::uint32_t rgba) const noexcept;
+    void raster_tiles() noexcept;
+    void render_thread_loop() noexcept;
+    void begin_tile_clears(std::uint32_t rgba) noexcept;
+    void clear_tile(std::uint32_t tile, bool stream) const noexcept;
+    void clear_untouched_tiles() noexcept;
     void refresh_render_cache() noexcept;
 
 private:
-    static constexpr int kWorkerCount = 8;  // TODO: Tune it
-    static constexpr int kTotalSlices = kWorkerCount + 1;
+    static constexpr int kGeometryBatches = 32;
+    static constexpr int kTileSize        = 64;
+    static constexpr int kRowsPerTask     = 8;
+    static constexpr int kVerticesPerTask = 2048;
+    static constexpr int kXformsPerTask   = 256;
+    static constexpr int kHiZBlock        = 8;
+    static constexpr int kOcclusionW      = 256;
+    static constexpr int kOcclusionH      = 128;
+    static constexpr int kOcclusionBands  = 8;
+    static constexpr std::uint32_t kMaxOccluders      = 32;
+    static constexpr std::uint32_t kOccluderTriBudget = 32768;
+    static constexpr float kOccluderMinRadius = 0.1f; // of the frame height, for a bounding sphere to occlude
+    static constexpr float kMinRenderScale = 0.25f;
+    static constexpr float kCheckerDepthTolerance = 0.02f; // of view depth, for a reprojected pixel to match
+
+    // Visibility buffer ids pack the geometry batch above the triangle index within it
+    static constexpr std::uint32_t kVisBatchShift = 27;
+    static constexpr std::uint32_t kVisIndexMask  = (1u << kVisBatchShift) - 1u;
+    static constexpr std::uint32_t kNoVisId       = 0xFFFFFFFFu;
+    static_assert(kGeometryBatches <= (1 << (32 - kVisBatchShift)), "batch does not fit the visibility id");
 
     struct draw_job_shared
     {
         matrix vp{};
         vec4   light_dir{};
+        // World space frustum planes as SoA lanes (a, b, c, d); lanes 6 and 7 repeat the far plane
+        alignas(16) float planes[4][8]{};
+        float  plane_inv_len[8]{}; // of each plane's (a, b, c), for sphere tests
+        vec4   eye{};              // world space
         float  fw = 0.f;
         float  fh = 0.f;
         std::uint32_t W = 0;
         std::uint32_t H = 0;
         bool textures_on = true;
         bool flip_v_on   = false;
+        bool hiz_on      = true;
+        bool cull_on     = true;
+        bool sort_on     = true;
+        bool vis_on      = false;
+        bool prepass_on  = false;
+        bool lod_on      = true;
+        bool occlusion_on = true;
+        bool cluster_on   = true;
+        float lod_px_scale = 0.f; // pixels per unit of world radius at clip w = 1
+        float shadow_strength = 0.f; // 0 while neither shadow map holds a caster
+        raster_isa isa = raster_isa::baseline; // also picks the AVX2 stages in optimized_renderer_avx2.cpp
+        raster_kernel_set raster{};
         post_process_settings post_settings{};
         rainy_effect_settings rain_settings{};
         advanced_effects_settings advanced_settings{};
         float time_s = 0.f;
     };
 
-    struct worker_range
+    // Entity flattened out of the render cache for the geometry stage
+    struct geo_entity
     {
-        int y0 = 0;
-        int y1 = 0;
+        const MeshRefPN*  mesh      = nullptr;
+        const Transform*  transform = nullptr;
+        const Material*   material  = nullptr;
+        const TextureRef* texture   = nullptr;
+        const Bounds*     bounds    = nullptr;
+        const MeshRefPN*  hull      = nullptr; // coarsest level, what the occlusion pass rasterises
+        std::size_t       tri_begin = 0; // prefix of tri_count over m_geo_entities
+        std::size_t       vtx_begin = 0; // prefix of vertex_count over indexed entities, soup adds 0
+        std::uint32_t     vtx_count = 0;
+        float             view_depth = 0.f; // clip w of the bounds centre
+        std::uint16_t     depth_key  = 0;   // view_depth quantised over the frame's depth range
+        std::uint32_t     debug_rgba = 0;   // triangle density heat, only under that debug view
     };
 
-    std::thread m_workers[kWorkerCount]{};
-
-    std::mutex              m_job_mtx{};
-    std::condition_variable m_job_cv{};
-    std::condition_variable m_done_cv{};
-
-    std::atomic<bool> m_shutdown{ false };
-
-    std::uint64_t m_job_gen = 0;
-    int           m_done_count = 0;
+    // Indexed vertex transformed once per instance per frame, shared by every triangle using it
+    struct post_vtx
+    {
+        vec4  hp{};     // clip space, for the w and frustum rejects
+        vec4  n{};      // normalised world normal
+        float x, y, z;  // screen position and depth, only valid when hp.w > 0
+    };
 
     draw_job_shared m_job{};
-    worker_range    m_ranges[kTotalSlices]{};
-
-    fecs::render_cache<MeshRefPN, Transform, Material, TextureRef> render_cache_{};
-    std::uint64_t render_cache_version_{ std::numeric_limits<std::uint64_t>::max() };
-
-private:
-    void init_persistent_workers() noexcept;
-    void shutdown_persistent_workers() noexcept;
 
-    void compute_slice_ranges(std::uint32_t H) noexcept;
+    std::vector<geo_entity> m_geo_entities{};
+    std::vector<geo_entity> m_geo_sort_scratch{};
+    std::size_t             m_geo_tri_total = 0;
+    std::size_t             m_geo_vtx_total = 0;
+    std::vector<post_vtx>   m_post_vtx{};
 
-    void worker_loop(int worker_index) noexcept;
+    // Per geo entity: clip matrix and object to world normal matrix
+    struct geo_xforms
+    {
+        static constexpr std::uint8_t kMirrored    = 1u; // negative determinant, winding flips
+        static constexpr std::uint8_t kRenormalize = 2u;
+
+        std::vector<matrix>       clip{};
+        std::vector<matrix>       normal{};
+        std::vector<std::uint8_t> flags{};
+    } m_geo_xforms{};
+    std::vector<setup_tri>  m_setup_tris[kGeometryBatches]{};
+    struct cluster_counts
+    {
+        std::uint32_t tested = 0;
+        std::uint32_t culled = 0;
+    };
+    cluster_counts m_batch_clusters[kGeometryBatches]{}; // summed into m_draw_stats once setup is done
 
-    void draw_world_slice(int y0, int y1) const noexcept;
-    void post_process_slice(int y0, int y1) const noexcept;
-    void rainy_effect_slice(int y0, int y1) const noexcept;
-    void advanced_effects_slice(int y0, int y1) const noexcept;
-};
+    // Per geometry batch, per screen tile: indices into m_setup_tris[batch]
+    std::vector<std::vector<std::uint32_t>> m_tile_bins[kGeometryBatches]{};
+    int m_tiles_x = 0;
+    int m_tiles_y = 0;
 
-class optimized_renderer_rt : public optimized_renderer_core
-{
-public:
-    using optimized_renderer_core::optimized_renderer_core;
+    // View space point lights and per tile indices into m_lights
+    struct view_light
+    {
+        float x, y, z;      // the camera looks down -z
+        float radius;
+        float r, g, b;      // colour times intensity
+        float inv_radius2;
+    };
+    std::vector<view_light> m_lights{};
+    std::vector<std::vector<std::uint16_t>> m_tile_lights{};
+    mutable std::vector<std::uint8_t> m_tile_light_count{}; // shaded per tile, written by the worker rastering it
+    static_assert(kMaxLights <= 65536u && kMaxTileLights <= 255u, "light indices or counts outgrew their types");
+
+    // Lazy clears: tiles clear on first raster, clear_untouched_tiles does the rest
+    mutable std::vector<std::uint8_t> m_tile_cleared{};
+    std::uint32_t m_clear_rgba = 0;
+    bool m_frame_cleared = false;
+
+    // Farthest stored depth per 8x8 block, conservative while draw_world runs
+    mutable std::vector<float> m_hiz_zmin{};
+    int m_hiz_bw = 0;
+    int m_hiz_bh = 0;
+
+    // Occlusion: the largest entities' coarsest levels, rastered conservatively at kOcclusionW x kOcclusionH
+    struct occluder_ref
+    {
+        std::uint32_t    entity = 0;
+        const MeshRefPN* mesh = nullptr;
+        float            radius_px = 0.f;
+        std::size_t      tri_begin = 0;
+    };
+    struct occluder_tri
+    {
+        float ea[3], eb[3], ec[3]; // edge functions, positive inside
+        float et[3];               // how far each falls from a pixel centre to its worst corner
+        float za, zb, zc;          // depth plane
+        float zslack;              // the same for the depth plane
+        float zmin;
+        int minx, maxx, miny, maxy; // pixels the triangle can cover entirely; empty when dropped
+    };
+    std::vector<occluder_ref> m_occluders{};
+    std::vector<occluder_tri> m_occluder_tris{};
+    std::vector<float>        m_occlusion_depth{};
+    std::vector<std::uint8_t> m_geo_hidden{};
 
-    inline void present() noexcept
+    // Shadow map in the sun's frame, depth growing toward the sun so 0 is clear
+    struct shadow_map
+    {
+        matrix from_world{};
+        matrix from_view{};
+        std::vector<float> depth{};
+        int size = 0;
+        float z0 = 0.f, z1 = 0.f;   // depth range in the sun's frame, world units
+        float bias = 0.f;           // in the map's depth units
+        std::uint32_t casters = 0;  // 0 leaves the map unused
+    };
+    struct shadow_caster
+    {
+        const MeshRefPN* mesh  = nullptr;
+        const matrix*    world = nullptr;
+        std::size_t      tri_begin = 0;
+    };
+    shadow_map m_shadow_static{};
+    shadow_map m_shadow_dynamic{};
+    matrix m_shadow_light{};            // world to the sun's frame: x and y across it, z toward it
+    vec4 m_shadow_dir{};                // sun direction and eye the cached map was drawn for
+    vec4 m_shadow_eye{};
+    std::uint64_t m_shadow_tick = 0;    // world tick the cached map was drawn at, 0 to draw it again
+    std::uint64_t m_shadow_settings = 0;
+    std::uint64_t m_shadow_static_version = 0;  // bumped by each redraw of the cached map
+    std::uint64_t m_shadow_dynamic_hash = 0;    // of the overlay's texels and placement
+    // Screen tiles the overlay's shadows may fall on, now and last frame, as x0, y0, x1, y1
+    int m_shadow_dynamic_rect[4]{ 0, 0, -1, -1 };
+    int m_shadow_dynamic_rect_prev[4]{ 0, 0, -1, -1 };
+    std::vector<shadow_caster> m_shadow_casters{};
+    std::vector<occluder_tri>  m_shadow_tris{};
+
+    // Bloom and depth of field sources at half and quarter size, packed RGBA8
+    struct blur_chain
     {
-        if (cur_frame.valid())
+        struct level
         {
-            canvas.present(cur_frame);
-            cur_frame = {};
-            framebuffer = {};
-            zbuffer = {};
-        }
+            std::uint32_t w = 0;
+            std::uint32_t h = 0;
+            std::vector<std::uint32_t> rgba{};
+            std::vector<std::uint32_t> taps_x{}; // per frame column: level x << 8 | weight of x + 1
+            std::vector<std::uint32_t> taps_y{}; // per frame row, the same
+
+            void resize(std::uint32_t lw, std::uint32_t lh, std::uint32_t frame_w, std::uint32_t frame_h);
+        };
+
+        level half{};
+        level quarter{};
+        std::vector<std::uint32_t> bloom{};   // quarter size
+        std::vector<std::uint32_t> dof{};     // quarter size
+        std::vector<std::uint32_t> scratch{}; // between the separable passes
+    } m_blur_chain{};
+
+    // Rain streak phase and jitter per frame column, from prepare_rain_columns
+    std::vector<float> m_rain_phase{};
+    std::vector<float> m_rain_jitter{};
+
+    // Per pixel visibility id, same pitch as the zbuffer; each tile clears and resolves its own rect
+    mutable std::vector<std::uint32_t> m_vis_ids{};
+    FramebufferRGBA8 m_vis_target{};
+
+    // draw_world_views' jobs, one per view while it builds their shared entity list, else empty
+    std::span<const draw_job_shared> m_geo_views{};
+
+    // Per frame state draw_world_views swaps out for its own and back, so both keep their capacity
+    struct view_scratch
+    {
+        draw_job_shared job{};
+        draw_stats stats{};
+        std::vector<geo_entity> geo_entities{};
+        std::size_t geo_tri_total = 0;
+        std::size_t geo_vtx_total = 0;
+        std::vector<post_vtx> post{};
+        geo_xforms xforms{};
+        std::vector<std::uint8_t> geo_hidden{};
+        std::vector<setup_tri> setup_tris[kGeometryBatches]{};
+        cluster_counts batch_clusters[kGeometryBatches]{};
+        std::vector<std::vector<std::uint32_t>> tile_bins[kGeometryBatches]{};
+        int tiles_x = 0;
+        int tiles_y = 0;
+        std::vector<view_light> lights{};
+        std::vector<std::vector<std::uint16_t>> tile_lights{};
+        std::vector<std::uint8_t> tile_light_count{};
+        std::vector<std::uint8_t> tile_cleared{};
+        std::vector<float> hiz_zmin{};
+        int hiz_bw = 0;
+        int hiz_bh = 0;
+        std::vector<std::uint32_t> vis_ids{};
+        FramebufferRGBA8 vis_target{};
+        matrix shadow_from_view[2]{};
+        int shadow_dynamic_rect[4]{ 0, 0, -1, -1 };
+        int shadow_dynamic_rect_prev[4]{ 0, 0, -1, -1 };
+    } m_view_scratch{};
+
+    // Checkerboard: each frame's rebuilt colour and depth, ahead of effects, for the next to reproject
+    struct checker_history
+    {
+        std::uint32_t w = 0, h = 0;
+        std::vector<std::uint32_t> colour{};
+        std::vector<float> depth{};
+        matrix vp{};
+        std::uint64_t frame = 0;  // m_checker_frame it was drawn in
+        std::uint32_t parity = 0; // shaded pixels had (x + y) & 1 equal to it
+    };
+    checker_history m_checker_history[2]{};
+    std::uint32_t m_checker_write  = 0;     // history the frame being built fills
+    std::uint64_t m_checker_frame  = 0;     // frames begun
+    std::uint32_t m_checker_parity = 0;
+    bool   m_checker_on     = false;        // the frame being built shades half and reconstructs
+    bool   m_checker_was_on = false;
+    bool   m_checker_repeat = false;        // and repeats the previous frame's inputs
+    frame_key m_checker_prev_key{};         // m_last_frame as the frame being built began
+    matrix m_checker_view_to_world{};
+
+    // First x from x0 on row y that the frame shades, every other one past it under checkerboard
+    [[nodiscard]] int first_shaded_x(int x0, int y) const noexcept
+    {
+        return m_checker_on ? x0 + ((x0 + y + (int)m_checker_parity) & 1) : x0;
     }
-};
+    [[nodiscard]] int shaded_x_step() const noexcept { return m_checker_on ? 2 : 1; }
+    void reconstruct_checkerboard() noexcept;
 
-class optimized_renderer_offline : public optimized_renderer_core
-{
-public:
-    using optimized_renderer_core::optimized_renderer_core;
+    draw_stats m_draw_stats{};
 
-    inline void start_recording() noexcept
-    {
-        canvas.record_begin();
-    }
+    // Debug view of the frame being built, fixed when it begins
+    debug_view m_debug_view = debug_view::none;
+    mutable std::vector<std::uint64_t> m_tile_cost_ns{}; // per tile, written by the worker rastering it
+    std::uint64_t m_tile_cost_max_ns = 0;
 
-    inline void stop_recording() noexcept
+    // Frame stats in the making, merged at begin_cpu_frame
+    struct alignas(64) worker_counters
     {
-        canvas.record_end();
-    }
+        std::atomic<std::uint64_t> busy_ns{ 0 };
+        std::atomic<std::uint64_t> pixels_tested{ 0 };
+        std::atomic<std::uint64_t> pixels_shaded{ 0 };
+    };
 
-    inline std::uint32_t recorded_frame_count() const noexcept
+    std::uint32_t m_worker_slots = fox::job_system::instance().slot_count();
+    std::unique_ptr<worker_counters[]> m_worker_counters = std::make_unique<worker_counters[]>(m_worker_slots + 1u);
+    std::uint64_t m_pass_ns[kFramePassCount]{};
+    std::chrono::steady_clock::time_point m_stats_frame_start{};
+    bool m_stats_frame_open = false;
+    frame_stats m_frame_stats{};
+
+    // Per worker scratch for the frame's jobs, handed back at begin_cpu_frame
+    mutable fox::frame_arenas m_frame_arenas{};
+    std::uint64_t m_frame_heap_allocations = 0;
+    std::uint64_t m_arena_allocs_seen = 0;
+
+    // Frame pipelining: TextureRef copies replace component pointers until finish_frame
+    std::vector<TextureRef> m_frame_textures{};
+    bool  m_raster_pending = false;
+    bool  m_post_pending   = false;
+    float m_post_time_s    = 0.f;
+    post_process_settings     m_post_deferred{};
+    rainy_effect_settings     m_rain_deferred{};
+    advanced_effects_settings m_advanced_deferred{};
+
+    std::thread             m_render_thread{};
+    std::mutex              m_render_mtx{};
+    std::condition_variable m_render_cv{};
+    bool m_render_busy = false;
+    bool m_render_quit = false;
+
+    raster_isa m_best_raster_isa = raster_isa::baseline;
+
+    fecs::render_cache<MeshRefPN, Transform, Material, TextureRef, Bounds> render_cache_{};
+    std::uint64_t render_cache_version_{ std::numeric_limits<std::uint64_t>::max() };
+    fecs::render_cache<MeshRefPN, InstanceTransforms, Material, TextureRef, Bounds> instanced_cache_{};
+
+private:
+    // The calling thread's entry; threads without a job_system slot share the last one
+    [[nodiscard]] worker_counters& local_counters() const noexcept
     {
-        return canvas.record_frame_count();
+        const int slot = fox::job_system::instance().current_slot();
+        return m_worker_counters[(slot >= 0 && (std::uint32_t)slot < m_worker_slots) ? (std::uint32_t)slot : m_worker_slots];
     }
 
-    inline void record_frame_only() noexcept
+    // parallel_for that books the time of every range to the worker running it
+    template<class Fn>
+    void run_parallel(std::uint32_t count, std::uint32_t grain, const Fn& fn) noexcept
     {
-        if (cur_frame.valid())
+        fox::job_system::instance().parallel_for(count, grain, [&](std::uint32_t b, std::uint32_t e)
         {
-            canvas.record_submit(cur_frame);
-            cur_frame = {};
-            framebuffer = {};
-            zbuffer = {};
-        }
+            const auto t0 = std::chrono::steady_clock::now();
+            fn(b, e);
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+            local_counters().busy_ns.fetch_add((std::uint64_t)ns, std::memory_order_relaxed);
+        });
     }
 
-    inline void playback_start(bool loop = true) noexcept
+    template<class Fn>
+    void for_each_row_block(std::uint32_t H, const Fn& fn) noexcept
     {
-        canvas.playback_start(loop);
+        run_parallel(H, kRowsPerTask, [&](std::uint32_t b, std::uint32_t e)
+        {
+            fn((int)b, (int)e - 1);
+        });
     }
 
-    inline void playback_stop() noexcept
+    // Adds the scope's wall time to one pass of the frame being built
+    class pass_timer
     {
-        canvas.playback_stop();
-    }
+    public:
+        pass_timer(optimized_renderer_core& r, frame_pass pass) noexcept
+            : m_ns(r.m_pass_ns[(std::size_t)pass]), m_start(std::chrono::steady_clock::now()) {}
+        ~pass_timer() { finish(); }
 
-    inline void playback_rewind() noexcept
-    {
-        canvas.playback_rewind();
-    }
+        // Ends the scope early, for a pass followed by another in the same function
+        void finish() noexcept
+        {
+            if (!m_running) return;
+            m_running = false;
+            m_ns += (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+        }
 
-    inline bool playback_present_next() noexcept
+        pass_timer(const pass_timer&) = delete;
+        pass_timer& operator=(const pass_timer&) = delete;
+
+    private:
+        std::uint64_t& m_ns;
+        std::chrono::steady_clock::time_point m_start;
+        bool m_running = true;
+    };
+
+    void finish_frame_stats() noexcept;
+
+    void extract_frustum_planes() noexcept;
+    [[nodiscard]] bool entity_outside_frustum(const draw_job_shared& job, const Bounds& b, const matrix& world) const noexcept;
+    [[nodiscard]] bool entity_outside_frustum(const Bounds& b, const matrix& world) const noexcept { return entity_outside_frustum(m_job, b, world); }
+    [[nodiscard]] bool sphere_outside_frustum(const vec4& centre, float radius) const noexcept;
+    [[nodiscard]] float view_depth_of(const draw_job_shared& job, const Bounds& b, const matrix& world) const noexcept;
+    [[nodiscard]] float view_depth_of(const Bounds& b, const matrix& world) const noexcept { return view_depth_of(m_job, b, world); }
+    [[nodiscard]] float screen_radius_px(const draw_job_shared& job, const Bounds& b, const matrix& world) const noexcept;
+    [[nodiscard]] float screen_radius_px(const Bounds& b, const matrix& world) const noexcept { return screen_radius_px(m_job, b, world); }
+    [[nodiscard]] const MeshRefPN& select_lod(const draw_job_shared& job, const MeshRefPN& mesh, const Bounds& b, const matrix& world) const noexcept;
+    [[nodiscard]] const MeshRefPN& select_lod(const MeshRefPN& mesh, const Bounds& b, const matrix& world) const noexcept { return select_lod(m_job, mesh, b, world); }
+    // The level an entity is drawn at, or null when every view culls it
+    [[nodiscard]] const MeshRefPN* place_entity(const MeshRefPN& mesh, const Bounds& b, const matrix& world) const noexcept;
+    [[nodiscard]] std::uint32_t triangle_density_rgba(const MeshRefPN& mesh, const Bounds& b, const matrix& world) const noexcept;
+    // draw_world's stages, shared with draw_world_views
+    void configure_raster_job(const matrix& cam, const vec4& light_dir) noexcept;
+    void prepare_raster_targets() noexcept;
+    void run_geometry_stage() noexcept;
+    void swap_view_scratch() noexcept;
+    void build_geometry_entities() noexcept;
+    void cull_occluded_entities() noexcept;
+    void setup_occluder(const occluder_ref& occ) noexcept;
+    void raster_occluders(int y0, int y1) noexcept;
+    // Shared by the occlusion and shadow passes; conservative keeps only fully covered pixels
+    static void setup_depth_tri(occluder_tri& ot, const float x[3], const float y[3], const float z[3],
+                                bool conservative, int w, int h) noexcept;
+    // Clears rows y0 to y1 of a w wide target, then keeps the nearest depth of tris over them
+    static void raster_depth_tris(const std::vector<occluder_tri>& tris, float* depth, int w, int y0, int y1, raster_isa isa) noexcept;
+    [[nodiscard]] bool entity_occluded(const Bounds& b, const matrix& world) const noexcept;
+    void build_geometry_xforms(std::size_t begin, std::size_t end) noexcept;
+    void transform_vertices(std::size_t v_begin, std::size_t v_end) noexcept;
+    void geometry_batch(int batch) noexcept;
+    void draw_world_tile(std::uint32_t tile) const noexcept;
+    void overdraw_heat_tile(int x0, int y0, int x1, int y1) const noexcept;
+    void apply_tile_cost_view() noexcept;
+    void bin_point_lights(const matrix& cam) noexcept;
+    void shade_tile_lights(std::uint32_t tile, int x0, int y0, int x1, int y1) const noexcept;
+    void apply_light_count_view() noexcept;
+    void update_shadows(const matrix& cam, const vec4& light_dir) noexcept;
+    void set_shadow_view(const matrix& cam) noexcept;
+    // Rasters the static or dynamic casters into map; returns how many were drawn
+    std::uint32_t draw_shadow_map(shadow_map& map, bool dynamic, const float box[4]) noexcept;
+    [[nodiscard]] bool dynamic_shadow_box(float box[4]) noexcept;
+    // Screen tiles a box of the sun's frame from z0 to z1 covers, all of them once it nears the eye
+    void shadow_screen_rect(const float box[4], float z0, float z1, const matrix& cam, int rect[4]) const noexcept;
+    void shade_tile_shadows(int x0, int y0, int x1, int y1) const noexcept;
+    [[nodiscard]] raster_pixel_counts raster_setup_tri(const setup_tri& st, raster_pass pass, int x0, int y0, int x1, int y1) const noexcept;
+    [[nodiscard]] float hiz_block_farthest(int x0, int y0, int x1, int y1) const noexcept;
+    [[nodiscard]] std::uint32_t resolve_visibility_tile(int x0, int y0, int x1, int y1) const noexcept;
+    void post_process_slice(int y0, int y1) const noexcept;
+    void prepare_rain_columns(const rainy_effect_settings& settings, float time_s) noexcept;
+    void rainy_effect_slice(int y0, int y1) const noexcept;
+    void advanced_effects_slice(int y0, int y1) const noexcept;
+    void build_blur_chain(const advanced_effects_settings& settings) noexcept;
+    void blur_quarter(std::vector<std::uint32_t>& img) noexcept;
+
+    // One advanced effects row as advanced_effects_slice prepared it
+    struct effects_row
     {
-        return canvas.playback_present_next();
-    }
+        const advanced_effects_settings& settings;
+        std::uint32_t* row;
+        const std::uint32_t* row_copy;
+        const float* zrow;
+        const std::uint32_t* bloom_row;
+        const std::uint32_t* half_row;
+        const std::uint32_t* quarter_row;
+        const std::uint32_t* mirror_row;
+        float fog_inv_range, dof_inv_range, mb, fx_scale, god_dy;
+        std::uint32_t grain_row;
+        std::uint32_t W;
+        bool bloom_on, dof_on;
+    };
+
+#ifdef USE_SIMD
+    // AVX2 bodies in optimized_renderer_avx2.cpp, used when m_job.isa is avx2
+    [[nodiscard]] std::size_t clip_matrices_avx2(std::size_t begin, std::size_t end) noexcept;
+    [[nodiscard]] std::size_t decode_quant_vertices_avx2(const quant_vertex* qv, std::size_t from, std::size_t to,
+                                                         const matrix& pq, const matrix& nm) noexcept;
+    static void depth_tri_row_avx2(const occluder_tri& ot, float* row, float r0, float r1, float r2, float rz) noexcept;
+    [[nodiscard]] std::uint32_t rain_row_avx2(const rainy_effect_settings& settings, std::uint32_t* row, const float* zrow,
+                                              float row_phase, float inv_length, std::uint32_t W) const noexcept;
+    [[nodiscard]] std::uint32_t advanced_effects_row_avx2(const effects_row& er) const noexcept;
+#endif
+};
+
+class optimized_renderer_rt : public optimized_renderer_core
+{
+public:
+    using optimized_renderer_core::optimized_renderer_core;
 
-    inline fox::playback_state playback_state() const noexcept
+    inline void present() noexcept
     {
-        return canvas.get_playback_state();
+        if (!cur_frame.valid()) return;
+
+        if (frame_pipelining)
+            submit_frame_async();
+        else
+            present_frame();
     }
 };
 
@@ -25,6 +25,9 @@ namespace fox
 
         void poll_messages();
 
+        // Sleeps until input arrives or timeout_ms passes; poll_messages still does the pumping
+        void wait_messages(std::uint32_t timeout_ms) const noexcept;
+
         void* native_hwnd() const noexcept;
 
         std::uint32_t width()  const noexcept;
@@ -48,6 +51,18 @@ namespace fox
         mouse_button_state mouse_state(mouse_button b) const noexcept;
         bool mouse_pressed(mouse_button b) const noexcept;
 
+        // Under relative mouse every poll_messages puts the cursor back at the client centre and
+        // keeps how far it had moved from there
+        void set_relative_mouse(bool enabled) noexcept;
+        int mouse_dx() const noexcept;
+        int mouse_dy() const noexcept;
+
+        // Input replay. While held, window messages and the cursor leave the input alone and
+        // set_input is what the getters above return.
+        [[nodiscard]] input_state input() const noexcept;
+        void set_input(const input_state& state) noexcept;
+        void hold_input(bool held) noexcept;
+
     private:
         class pimpl;
         std::unique_ptr<pimpl> p_;
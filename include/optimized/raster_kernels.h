@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+
+struct TextureRef;
+struct FramebufferRGBA8;
+struct ZBufferF32;
+enum class depth_format : std::uint8_t;
+
+// Fixed state a raster kernel is specialised on, so its pixel loop branches on none of it. Shading
+// is per triangle, picked at setup from its texture; the depth format is per frame. Culling is done
+// by then and nothing blends, so neither needs a permutation.
+struct raster_state
+{
+    bool textured = false;
+    bool mipped   = false; // the rest only matter when textured
+    bool pow2     = false;
+    bool bc1      = false;
+
+    [[nodiscard]] constexpr std::uint8_t index() const noexcept
+    {
+        return textured ? (std::uint8_t)(1u | (mipped ? 2u : 0u) | (pow2 ? 4u : 0u) | (bc1 ? 8u : 0u)) : 0u;
+    }
+
+    [[nodiscard]] static constexpr raster_state from_index(std::uint32_t i) noexcept
+    {
+        return (i & 1u) ? raster_state{ true, (i & 2u) != 0, (i & 4u) != 0, (i & 8u) != 0 } : raster_state{};
+    }
+};
+
+inline constexpr std::uint32_t kRasterStates = 16;
+
+// What a kernel writes for the pixels it covers. shade and ids store nearer depth along with the
+// colour or the triangle id; depth stores nothing else, for the depth pre-pass; equal then shades
+// the pixels whose stored depth that triangle matches and leaves depth as the pre-pass left it.
+enum class raster_pass : std::uint8_t
+{
+    shade,
+    ids,
+    depth,
+    equal,
+};
+
+// State a triangle with this texture draws with, flat for nullptr
+[[nodiscard]] raster_state raster_state_for(const TextureRef* tex) noexcept;
+
+// Post-transform triangle, set up once per frame and consumed by every raster tile
+struct setup_tri
+{
+    float e0_a, e0_b, e0_c;
+    float e1_a, e1_b, e1_c;
+    float e2_a, e2_b, e2_c;
+    float inv_area;
+
+    float z0, z1, z2;
+    float dzdx, dzdy;
+    float zmax; // closest vertex depth, for coarse depth rejection
+
+    // Perspective correct UV terms, only valid when tex != nullptr
+    float invw0, invw1, invw2;
+    float uow0, uow1, uow2;
+    float vow0, vow1, vow2;
+    float d_invw_dx, d_invw_dy;
+    float d_uow_dx, d_uow_dy;
+    float d_vow_dx, d_vow_dy;
+
+    int minx, maxx, miny, maxy;
+
+    // 16.8 fixed point edges for 8x8 block classification, only valid when fixed_edges is set.
+    // Evaluated at pixel centres they give the float edge value scaled by 2^16.
+    std::int64_t fx_a[3], fx_b[3], fx_c[3];
+    bool         fixed_edges;
+
+    float              intensity;
+    std::uint32_t      flat_rgba;
+    const TextureRef*  tex;
+    std::uint32_t      id;    // geometry batch and index in it, written by the visibility buffer pass
+    std::uint8_t       state; // raster_state::index, the kernel permutation it draws with
+};
+
+// Pixels a kernel call depth tested (inside the triangle) and how many of them passed and were stored
+struct raster_pixel_counts
+{
+    std::uint32_t tested = 0;
+    std::uint32_t passed = 0;
+
+    raster_pixel_counts& operator+=(const raster_pixel_counts& o) noexcept
+    {
+        tested += o.tested;
+        passed += o.passed;
+        return *this;
+    }
+};
+
+// Depth test, shade and store every covered pixel of st inside the inclusive rect
+using raster_rect_fn = raster_pixel_counts(*)(
+    const setup_tri& st,
+    const FramebufferRGBA8& fb,
+    const ZBufferF32& zb,
+    int minx, int miny, int maxx, int maxy) noexcept;
+
+// partial tests every pixel against the edges, covered assumes the whole rect is inside the triangle;
+// both are indexed by setup_tri::state. The ids variants only write depth and st.id (through fb) for
+// the visibility buffer, which shades nothing, so they have no state of their own. The depth and
+// equal variants are indexed by state too, so a triangle reaches the same depth in both passes.
+struct raster_kernel_set
+{
+    raster_rect_fn partial[kRasterStates]{};
+    raster_rect_fn covered[kRasterStates]{};
+    raster_rect_fn ids_partial = nullptr;
+    raster_rect_fn ids_covered = nullptr;
+    raster_rect_fn depth_partial[kRasterStates]{};
+    raster_rect_fn depth_covered[kRasterStates]{};
+    raster_rect_fn equal_partial[kRasterStates]{};
+    raster_rect_fn equal_covered[kRasterStates]{};
+};
+
+enum class raster_isa : std::uint8_t
+{
+    baseline, // SSE when built with USE_SIMD, scalar otherwise
+    avx2,
+};
+
+// 4-wide flat path, scalar textured path; runs on any target the build allows
+void fill_raster_kernels_baseline(raster_kernel_set& set, depth_format depth) noexcept;
+
+// Debug overdraw: add one to the fb pixel per depth test and keep depth as usual, no shading
+raster_pixel_counts raster_rect_overdraw(const setup_tri& st, const FramebufferRGBA8& fb, const ZBufferF32& zb,
+                          int minx, int miny, int maxx, int maxy) noexcept;
+raster_pixel_counts raster_covered_overdraw(const setup_tri& st, const FramebufferRGBA8& fb, const ZBufferF32& zb,
+                             int minx, int miny, int maxx, int maxy) noexcept;
+
+#ifdef USE_SIMD
+// 8-wide depth/shade/store for flat and textured triangles, lives in its own AVX2 translation unit
+void fill_raster_kernels_avx2(raster_kernel_set& set, depth_format depth) noexcept;
+#endif
+
+// Colour st would shade at pixel centre (px, py), for resolving the visibility buffer
+[[nodiscard]] std::uint32_t shade_setup_pixel(const setup_tri& st, float px, float py) noexcept;
+
+// Widest kernel the CPU and OS support, resolved once through CPUID
+[[nodiscard]] raster_isa detect_raster_isa() noexcept;
+// Every permutation for a frame drawn at isa into a depth plane of this format
+[[nodiscard]] raster_kernel_set raster_kernels_for(raster_isa isa, depth_format depth) noexcept;
+[[nodiscard]] const char* raster_isa_name(raster_isa isa) noexcept;
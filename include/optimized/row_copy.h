@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef USE_SIMD
+#include <immintrin.h>
+#endif
+
+namespace fox
+{
+    // One row of a framebuffer upload. Rows of 512 bytes and up stream past the cache, since the
+    // destination is a mapped texture nothing on the CPU reads back; src must be 32 byte aligned.
+    inline void copy_row(std::uint8_t* dst, const std::uint8_t* src, std::size_t bytes) noexcept
+    {
+#ifdef USE_SIMD
+        std::size_t i = 0;
+        const bool use_nt = bytes >= 512;
+        if (use_nt)
+        {
+            const std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(dst);
+            const std::size_t align = (32u - (addr & 31u)) & 31u;
+            for (; i < align && i < bytes; ++i) dst[i] = src[i];
+            for (; i + 32 <= bytes; i += 32)
+            {
+                const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i));
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i), v);
+            }
+            for (; i < bytes; ++i) dst[i] = src[i];
+            _mm_sfence();
+            return;
+        }
+
+        for (; i + 32 <= bytes; i += 32)
+        {
+            const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(dst + i), v);
+        }
+        for (; i < bytes; ++i) dst[i] = src[i];
+#else
+        std::memcpy(dst, src, bytes);
+#endif
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace fox
+{
+    enum class thread_role : std::uint8_t
+    {
+        worker,  // job_system workers
+        present  // gfx_dx11 present thread
+    };
+
+    enum class thread_priority : std::uint8_t
+    {
+        normal,
+        above_normal,
+        highest,
+        time_critical
+    };
+
+    // Where each kind of thread runs and how urgently. Set before the first job_system or gfx_dx11
+    // use; threads pick it up as they start.
+    struct thread_layout
+    {
+        bool workers_one_per_core   = true;  // each worker on its own logical processor, SMT siblings last
+        bool workers_on_performance = false; // workers only on the fastest efficiency class of a hybrid part
+
+        thread_priority worker_priority  = thread_priority::normal;
+        thread_priority present_priority = thread_priority::highest;
+    };
+
+    // One logical processor as Windows CPU sets report it
+    struct cpu_core
+    {
+        std::uint32_t cpu_set_id       = 0;
+        std::uint16_t group            = 0;
+        std::uint8_t  logical_index    = 0;
+        std::uint8_t  core_index       = 0;
+        std::uint8_t  efficiency_class = 0; // higher is faster
+    };
+
+    // Logical processors grouped by efficiency class. Each pool lists one logical processor of every
+    // physical core before any SMT sibling, so the first threads placed get a core to themselves.
+    class thread_topology final
+    {
+    public:
+        static thread_topology& instance() noexcept;
+
+        thread_topology(const thread_topology&) = delete;
+        thread_topology& operator=(const thread_topology&) = delete;
+
+        [[nodiscard]] const std::vector<cpu_core>& cores() const noexcept { return m_cores; }
+        [[nodiscard]] bool hybrid() const noexcept { return m_hybrid; }
+        [[nodiscard]] std::uint32_t performance_core_count() const noexcept { return (std::uint32_t)m_performance.size(); }
+
+        [[nodiscard]] const thread_layout& layout() const noexcept { return m_layout; }
+        void set_layout(const thread_layout& layout) noexcept { m_layout = layout; }
+
+        // Sets selected CPU sets and priority for the index-th thread of a role. Selected CPU sets
+        // are soft affinity, so a busy core delays a thread rather than stranding it. Without CPU
+        // set support only the priority changes.
+        void apply(std::thread& t, thread_role role, std::uint32_t index) const noexcept;
+        void apply_current(thread_role role, std::uint32_t index) const noexcept;
+
+    private:
+        thread_topology() noexcept;
+
+        void apply_native(void* handle, thread_role role, std::uint32_t index) const noexcept;
+
+        std::vector<cpu_core>      m_cores{};
+        std::vector<std::uint32_t> m_all{};         // CPU set ids, performance cores first, SMT siblings last
+        std::vector<std::uint32_t> m_performance{}; // the same order, top efficiency class only
+        bool          m_hybrid = false;
+        thread_layout m_layout{};
+    };
+}
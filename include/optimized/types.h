@@ -68,6 +68,18 @@ namespace fox
 		pressed  = 2,
 	};
 
+	// Everything platform_window reads from input as of one poll_messages, what input logs hold
+	struct input_state
+	{
+		std::uint64_t keys[4]{};		// bit per virtual key
+		std::int32_t  mouse_x = 0;
+		std::int32_t  mouse_y = 0;
+		std::int32_t  wheel   = 0;
+		std::int32_t  mouse_dx = 0;		// cursor travel under relative mouse
+		std::int32_t  mouse_dy = 0;
+		mouse_button_state buttons[3]{};
+	};
+
 	// Icon configuration
 	struct window_icons
 	{
@@ -100,6 +112,8 @@ namespace fox
 		std::uint32_t width = 1280;
 		std::uint32_t height = 1080;
 		std::uint32_t ring_size = 16;
+		bool          zero_copy = false; // hand out mapped upload memory instead of system memory frames
+		bool          low_latency = false; // frame latency waitable swap chain, presents on vblank
 	};
 } // namespace fox
 
@@ -1,18 +1,93 @@
 #ifndef FOXRASTERIZER_TEXTURE_CACHE_H
 #define FOXRASTERIZER_TEXTURE_CACHE_H
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+// Texels are stored as 4x4 tiles, one 64 byte cache line each, with the tiles row-major per level
+static constexpr std::uint32_t kTextureTile   = 4;
+static constexpr std::uint32_t kMaxMipLevels  = 16;
+
+[[nodiscard]] inline std::uint32_t mip_extent(std::uint32_t extent, std::uint32_t level) noexcept
+{
+    return (std::max)(extent >> level, 1u);
+}
+
+[[nodiscard]] inline bool is_pow2(std::uint32_t v) noexcept
+{
+    return v != 0 && (v & (v - 1)) == 0;
+}
+
+[[nodiscard]] inline std::uint32_t log2_pow2(std::uint32_t v) noexcept
+{
+    std::uint32_t l = 0;
+    while ((1u << l) < v) ++l;
+    return l;
+}
+
+[[nodiscard]] inline std::size_t tiled_texel_index(std::uint32_t x, std::uint32_t y, std::uint32_t tiles_x) noexcept
+{
+    return ((std::size_t)(y >> 2) * tiles_x + (x >> 2)) * 16u + ((y & 3u) << 2) + (x & 3u);
+}
+
+// How a chain's tiles are held. bc1 packs each 4x4 tile into two words, the RGB565 endpoints
+// then 2 bit palette indices in tile order, for an eighth of the memory; alpha reads as opaque.
+enum class texture_format : std::uint8_t
+{
+    rgba8,
+    bc1
+};
+
+// Texel in_tile (0..15, as tiled_texel_index orders a tile) of a bc1 tile. Blocks are always in
+// four colour mode, the two thirds palette entries rounded down.
+[[nodiscard]] inline std::uint32_t bc1_decode_texel(const std::uint32_t* block, std::uint32_t in_tile) noexcept
+{
+    const std::uint32_t ends = block[0];
+    const std::uint32_t sel  = (block[1] >> (in_tile * 2u)) & 3u;
+    const auto expand = [](std::uint32_t c) noexcept
+    {
+        const std::uint32_t r = (c >> 11) & 31u, g = (c >> 5) & 63u, b = c & 31u;
+        return ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) | (((b << 3) | (b >> 2)) << 16);
+    };
+    const std::uint32_t c0 = expand(ends & 0xFFFFu);
+    const std::uint32_t c1 = expand(ends >> 16);
+    if (sel < 2u)
+        return 0xFF000000u | (sel ? c1 : c0);
+
+    const std::uint32_t w0 = (sel == 2u) ? 2u : 1u;
+    std::uint32_t out = 0xFF000000u;
+    for (std::uint32_t shift = 0; shift < 24; shift += 8)
+    {
+        const std::uint32_t v = ((c0 >> shift) & 0xFFu) * w0 + ((c1 >> shift) & 0xFFu) * (3u - w0);
+        out |= ((v * 21846u) >> 16) << shift;
+    }
+    return out;
+}
+
+// Words of a chain holding texels tiled texels
+[[nodiscard]] inline std::size_t chain_words(texture_format format, std::size_t texels) noexcept
+{
+    return format == texture_format::bc1 ? texels / 8u : texels;
+}
+
 struct TextureRGBA8
 {
-    std::uint32_t* pixels = nullptr;
+    std::uint32_t* pixels = nullptr; // whole tiled mip chain, level 0 first; see texture_format
     std::uint32_t  width  = 0;
     std::uint32_t  height = 0;
     bool           owned  = false;
+    std::uint32_t  mip_count = 0;
+    std::uint32_t  mip_offsets[kMaxMipLevels]{}; // in texels from pixels; a bc1 tile at texel t is at word t / 8
+    bool           pow2 = false;                 // both extents are powers of two, samplers mask instead of wrap
+    std::size_t    texel_count = 0;              // whole chain
+    texture_format format = texture_format::rgba8;
 
     TextureRGBA8() = default;
     ~TextureRGBA8() noexcept { destroy(); }
@@ -21,9 +96,11 @@ struct TextureRGBA8
     TextureRGBA8& operator=(const TextureRGBA8&) = delete;
 
     TextureRGBA8(TextureRGBA8&& o) noexcept
-        : pixels(o.pixels), width(o.width), height(o.height), owned(o.owned)
+        : pixels(o.pixels), width(o.width), height(o.height), owned(o.owned), mip_count(o.mip_count), pow2(o.pow2)
+        , texel_count(o.texel_count), format(o.format)
     {
-        o.pixels = nullptr; o.width = 0; o.height = 0; o.owned = false;
+        std::copy(o.mip_offsets, o.mip_offsets + kMaxMipLevels, mip_offsets);
+        o.pixels = nullptr; o.width = 0; o.height = 0; o.owned = false; o.mip_count = 0; o.texel_count = 0;
     }
 
     TextureRGBA8& operator=(TextureRGBA8&& o) noexcept
@@ -31,8 +108,11 @@ struct TextureRGBA8
         if (this != &o)
         {
             destroy();
-            pixels = o.pixels; width = o.width; height = o.height; owned = o.owned;
-            o.pixels = nullptr; o.width = 0; o.height = 0; o.owned = false;
+            pixels = o.pixels; width = o.width; height = o.height; owned = o.owned; mip_count = o.mip_count; pow2 = o.pow2;
+            texel_count = o.texel_count;
+            format = o.format;
+            std::copy(o.mip_offsets, o.mip_offsets + kMaxMipLevels, mip_offsets);
+            o.pixels = nullptr; o.width = 0; o.height = 0; o.owned = false; o.mip_count = 0; o.texel_count = 0;
         }
         return *this;
     }
@@ -40,10 +120,31 @@ struct TextureRGBA8
     void destroy() noexcept
     {
         if (owned && pixels) delete[] pixels;
-        pixels = nullptr; width = 0; height = 0; owned = false;
+        pixels = nullptr; width = 0; height = 0; owned = false; mip_count = 0; pow2 = false; texel_count = 0;
+        format = texture_format::rgba8;
     }
 
-    [[nodiscard]] bool valid() const noexcept { return pixels && width > 0 && height > 0; }
+    // Box filters rgba (row-major, w * h) down to 1x1 and stores every level tiled
+    void build_mip_chain(const std::uint32_t* rgba, std::uint32_t w, std::uint32_t h);
+
+    // Takes ownership of an already tiled chain for a w x h level 0, laid out as build_mip_chain does
+    void adopt_mip_chain(std::uint32_t* chain, std::uint32_t w, std::uint32_t h,
+                         texture_format chain_format = texture_format::rgba8) noexcept;
+
+    // Re-encodes an owned rgba8 chain as bc1 tile by tile; false if it is not one
+    bool compress_bc1();
+
+    [[nodiscard]] std::size_t resident_bytes() const noexcept { return chain_words(format, texel_count) * sizeof(std::uint32_t); }
+
+    // Moves level 1 and below into a new allocation and makes level 1 the top. Returns the old
+    // allocation for the caller to free once nothing samples it, nullptr if there is one level left.
+    [[nodiscard]] std::uint32_t* drop_top_mip();
+
+    // Offsets of each level for a w x h level 0; returns the chain's texel count
+    static std::size_t mip_layout(std::uint32_t w, std::uint32_t h,
+                                  std::uint32_t (&offsets)[kMaxMipLevels], std::uint32_t& levels) noexcept;
+
+    [[nodiscard]] bool valid() const noexcept { return pixels && width > 0 && height > 0 && mip_count > 0; }
 
     [[nodiscard]] std::uint32_t sample_nearest(float u, float v) const noexcept
     {
@@ -54,10 +155,32 @@ struct TextureRGBA8
 
         const std::uint32_t tx = static_cast<std::uint32_t>(u * (float)width ) % width;
         const std::uint32_t ty = static_cast<std::uint32_t>(v * (float)height) % height;
-        return pixels[(std::size_t)ty * (std::size_t)width + (std::size_t)tx];
+        const std::size_t t = tiled_texel_index(tx, ty, (width + kTextureTile - 1) / kTextureTile);
+        if (format == texture_format::bc1)
+            return bc1_decode_texel(pixels + ((t >> 4) << 1), (std::uint32_t)t & 15u);
+        return pixels[t];
     }
 };
 
+// One texture of a texture_cache::load_batch
+struct texture_request
+{
+    std::string key{};              // file path, or cache key of the image in data
+    const void* data = nullptr;     // compressed image in memory, null to read the file at key
+    std::size_t size = 0;
+    const TextureRGBA8* result = nullptr;
+};
+
+// A texture texture_cache::trim_to_budget shrank; refs made from old_pixels must be remade from texture
+struct texture_trim
+{
+    const std::uint32_t* old_pixels = nullptr;
+    const TextureRGBA8* texture = nullptr;
+};
+
+// Decodes through WIC, or straight from the disk cache of decoded mip chains keyed by a hash of the
+// compressed bytes. Entries live until the cache does; over the memory budget the least recently
+// requested ones lose their top mips instead, so pointers handed out stay valid.
 class texture_cache
 {
 public:
@@ -72,14 +195,62 @@ public:
                                      const void* data,
                                      std::size_t size);
 
+    // Decodes the requests in parallel on the job system, filling in each result
+    void load_batch(texture_request* requests, std::size_t count);
+
     const TextureRGBA8* get(const std::string& key) const;
     const TextureRGBA8* checkerboard() const noexcept { return &checkerboard_; }
-    [[nodiscard]] std::size_t size() const noexcept { return cache_.size(); }
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return cache_.size();
+    }
+
+    // Directory for decoded chains, set before the first load; empty turns the disk cache off
+    void set_disk_cache_dir(const std::string& dir);
+
+    // Format textures decoded from now on are held in; ones already cached keep theirs
+    void set_residency_format(texture_format format) noexcept;
+    [[nodiscard]] texture_format residency_format() const noexcept;
+
+    // Bytes of decoded texels to hold, 0 for no limit
+    void set_memory_budget(std::size_t bytes) noexcept;
+    [[nodiscard]] std::size_t memory_budget() const noexcept;
+    [[nodiscard]] std::size_t resident_bytes() const noexcept;
+    [[nodiscard]] bool over_budget() const noexcept;
+
+    // Drops top mips, least recently requested textures first, until the budget is met or every
+    // texture is down to kMinTrimExtent. Each texture shrunk is appended to out once.
+    std::size_t trim_to_budget(std::vector<texture_trim>& out);
+
+    // Frees the texels trimmed away; only once no TextureRef made before the trim is sampled
+    void release_retired() noexcept;
+
+    static constexpr std::uint32_t kMinTrimExtent = 32;
 
 private:
+    struct entry
+    {
+        std::unique_ptr<TextureRGBA8> tex{};
+        mutable std::uint64_t last_use = 0;
+    };
+
+    const TextureRGBA8* decode(const std::string& key, const void* data, std::size_t size);
+    const TextureRGBA8* insert(const std::string& key, std::unique_ptr<TextureRGBA8> tex);
+    [[nodiscard]] bool read_disk_cache(std::uint64_t hash, texture_format format, TextureRGBA8& out) const;
+    void write_disk_cache(std::uint64_t hash, const TextureRGBA8& tex) const;
+    [[nodiscard]] std::string disk_cache_path(std::uint64_t hash) const;
     void generate_checkerboard() noexcept;
 
-    std::unordered_map<std::string, std::unique_ptr<TextureRGBA8>> cache_;
+    // Loads may come from streaming threads; decodes run unlocked and the first to finish wins
+    mutable std::mutex mtx_;
+    std::unordered_map<std::string, entry> cache_;
+    mutable std::uint64_t use_clock_ = 0;
+    std::size_t resident_bytes_ = 0;
+    std::size_t budget_bytes_ = 0;
+    texture_format format_ = texture_format::rgba8;
+    std::string disk_dir_ = "cache/textures/";
+    std::vector<std::unique_ptr<std::uint32_t[]>> retired_;
     TextureRGBA8 checkerboard_;
 };
 
@@ -1,9 +1,51 @@
 #include "game/game_world.h"
+#include "optimized/gif_writer.h"
 
-int main()
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv)
 {
-    fox::game_world gw({ 1024, 768, "FoxGame", false, 0 });
-    //fox::game_world gw({ 1920, 1080, "FoxGame", false, 0 });
+    fox::game_world_config config{ 1024, 768, "FoxGame", false, 0 };
+    //fox::game_world_config config{ 1920, 1080, "FoxGame", false, 0 };
+
+    // --replay-input LOG --offline --stats reruns a recorded session without presenting and writes
+    // the same frame_stats.csv each time, for comparing builds on identical input. --offline-out
+    // also writes every frame as PREFIX_000000.tga on, for an encoder to turn into a video, and
+    // --offline-gif into a GIF.
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--record-input") && val) { config.record_input = val; ++i; }
+        else if (!std::strcmp(arg, "--replay-input") && val) { config.replay_input = val; ++i; }
+        else if (!std::strcmp(arg, "--offline")) config.offline = true;
+        else if (!std::strcmp(arg, "--offline-out") && val) { config.offline = true; config.offline_output = val; ++i; }
+        else if (!std::strcmp(arg, "--offline-gif") && val) { config.offline = true; config.offline_gif = val; ++i; }
+        else if (!std::strcmp(arg, "--export-gif") && val && i + 2 < argc)
+        {
+            // Converts a gfx_dx11 capture and exits without opening the game
+            const char* gif = argv[i + 2];
+            if (!fox::export_capture_gif(val, gif))
+            {
+                std::fprintf(stderr, "cannot convert %s to %s\n", val, gif);
+                return 1;
+            }
+            return 0;
+        }
+        else if (!std::strcmp(arg, "--frames") && val) { config.frame_limit = (std::uint32_t)std::strtoul(val, nullptr, 10); ++i; }
+        else if (!std::strcmp(arg, "--stats")) config.stats_csv = true;
+        else
+        {
+            std::fprintf(stderr, "usage: rasterizer [--record-input LOG | --replay-input LOG] [--offline] [--offline-out PREFIX] [--offline-gif GIF] [--frames N] [--stats]\n"
+                                 "       rasterizer --export-gif CAPTURE GIF\n");
+            return 2;
+        }
+    }
+
+    fox::game_world gw(config);
     gw.init();
     gw.run();
     return 0;
@@ -0,0 +1,70 @@
+#include "game/asset_streamer.h"
+
+#include <algorithm>
+
+namespace fox
+{
+    asset_streamer::asset_streamer(std::uint32_t thread_count) noexcept
+        : thread_count_((std::max)(thread_count, 1u))
+    {
+    }
+
+    asset_streamer::~asset_streamer()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            quit_ = true;
+        }
+        cv_.notify_all();
+
+        // Jobs still queued are dropped; their futures report broken_promise
+        for (std::thread& t : threads_)
+            if (t.joinable())
+                t.join();
+    }
+
+    std::size_t asset_streamer::in_flight() const noexcept
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return jobs_.size() + running_;
+    }
+
+    void asset_streamer::push(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            jobs_.push_back(std::move(job));
+
+            if (threads_.empty())
+            {
+                threads_.reserve(thread_count_);
+                for (std::uint32_t i = 0; i < thread_count_; ++i)
+                    threads_.emplace_back([this]() { worker_loop(); });
+            }
+        }
+        cv_.notify_one();
+    }
+
+    void asset_streamer::worker_loop() noexcept
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lk(mtx_);
+                cv_.wait(lk, [this]() { return quit_ || !jobs_.empty(); });
+                if (quit_)
+                    return;
+
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+                ++running_;
+            }
+
+            job();
+
+            std::lock_guard<std::mutex> lk(mtx_);
+            --running_;
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "game/dynamic_mesh.h"
+#include "optimized/job_system.h"
 
 #include <assimp/anim.h>
 #include <assimp/material.h>
@@ -12,6 +13,15 @@
 
 namespace
 {
+#ifdef USE_SIMD
+    // CPUID is read once, the skinning calls run per batch on every worker
+    raster_isa skin_isa() noexcept
+    {
+        static const raster_isa isa = detect_raster_isa();
+        return isa;
+    }
+#endif
+
     aiNodeAnim* find_node_anim(const aiAnimation* animation, const aiString& node_name)
     {
         if (!animation) return nullptr;
@@ -65,51 +75,29 @@ namespace
         return out.Normalize();
     }
 
-    aiMatrix4x4 make_node_transform(const aiNodeAnim* channel, double anim_time)
+    // T * R * S of one track of a sampled pose, the rotation already unit length
+    inline aiMatrix4x4 track_local(const float* pose, std::uint32_t stride, std::uint32_t k) noexcept
     {
-        if (!channel) return aiMatrix4x4();
-
-        const aiVector3D scale = interpolate_vec3(anim_time, channel->mScalingKeys, channel->mNumScalingKeys);
-        const aiQuaternion rot = interpolate_quat(anim_time, channel->mRotationKeys, channel->mNumRotationKeys);
-        const aiVector3D pos   = interpolate_vec3(anim_time, channel->mPositionKeys, channel->mNumPositionKeys);
-
-        aiMatrix4x4 S; aiMatrix4x4::Scaling(scale, S);
-        aiMatrix4x4 R = aiMatrix4x4(rot.GetMatrix());
-        aiMatrix4x4 T; aiMatrix4x4::Translation(pos, T);
-
-        return T * R * S;
+        const float tx = pose[0 * stride + k], ty = pose[1 * stride + k], tz = pose[2 * stride + k];
+        const float qx = pose[3 * stride + k], qy = pose[4 * stride + k], qz = pose[5 * stride + k], qw = pose[6 * stride + k];
+        const float sx = pose[7 * stride + k], sy = pose[8 * stride + k], sz = pose[9 * stride + k];
+
+        aiMatrix4x4 m;
+        m.a1 = (1.f - 2.f * (qy * qy + qz * qz)) * sx; m.a2 = 2.f * (qx * qy - qz * qw) * sy; m.a3 = 2.f * (qx * qz + qy * qw) * sz; m.a4 = tx;
+        m.b1 = 2.f * (qx * qy + qz * qw) * sx; m.b2 = (1.f - 2.f * (qx * qx + qz * qz)) * sy; m.b3 = 2.f * (qy * qz - qx * qw) * sz; m.b4 = ty;
+        m.c1 = 2.f * (qx * qz - qy * qw) * sx; m.c2 = 2.f * (qy * qz + qx * qw) * sy; m.c3 = (1.f - 2.f * (qx * qx + qy * qy)) * sz; m.c4 = tz;
+        return m;
     }
 
-    void read_node_hierarchy_with_global_inverse(
-        double anim_time,
-        const aiNode* node,
-        const aiMatrix4x4& parent_transform,
-        const aiAnimation* animation,
-        const std::unordered_map<std::string, std::uint32_t>& bone_map,
-        const std::vector<aiMatrix4x4>& bone_offsets,
-        std::vector<aiMatrix4x4>& out_bone_final,
-        const aiMatrix4x4& global_inverse)
+    // Scatters the top three rows of m into element rows of a SoA palette
+    inline void write_palette(float* palette, std::uint32_t stride, std::uint32_t bone, const aiMatrix4x4& m) noexcept
     {
-        if (!node) return;
-
-        aiMatrix4x4 node_local = node->mTransformation;
-        if (const aiNodeAnim* ch = find_node_anim(animation, node->mName))
-            node_local = make_node_transform(ch, anim_time);
-
-        const aiMatrix4x4 global = parent_transform * node_local;
-
-        auto it = bone_map.find(node->mName.C_Str());
-        if (it != bone_map.end())
-        {
-            const std::uint32_t bi = it->second;
-            if (bi < out_bone_final.size())
-                out_bone_final[bi] = global_inverse * global * bone_offsets[bi];
-        }
-
-        for (unsigned int i = 0; i < node->mNumChildren; ++i)
-            read_node_hierarchy_with_global_inverse(anim_time, node->mChildren[i], global,
-                                                    animation, bone_map, bone_offsets, out_bone_final,
-                                                    global_inverse);
+        palette[ 0 * stride + bone] = m.a1; palette[ 1 * stride + bone] = m.a2;
+        palette[ 2 * stride + bone] = m.a3; palette[ 3 * stride + bone] = m.a4;
+        palette[ 4 * stride + bone] = m.b1; palette[ 5 * stride + bone] = m.b2;
+        palette[ 6 * stride + bone] = m.b3; palette[ 7 * stride + bone] = m.b4;
+        palette[ 8 * stride + bone] = m.c1; palette[ 9 * stride + bone] = m.c2;
+        palette[10 * stride + bone] = m.c3; palette[11 * stride + bone] = m.c4;
     }
 }
 
@@ -196,6 +184,100 @@ void dynamic_mesh::add_weight(vertex_weights& vw, std::uint32_t bone, float weig
     }
 }
 
+void dynamic_mesh::flatten_nodes(const aiNode* node, std::int32_t parent, std::vector<const aiNode*>& nodes)
+{
+    if (!node) return;
+
+    const std::int32_t self = (std::int32_t)skin_nodes_.size();
+
+    skin_node sn{};
+    sn.bind_local = node->mTransformation;
+    sn.parent = parent;
+    auto it = bone_map_.find(node->mName.C_Str());
+    if (it != bone_map_.end())
+        sn.bone = (std::int32_t)it->second;
+    skin_nodes_.push_back(sn);
+    nodes.push_back(node);
+
+    for (unsigned int i = 0; i < node->mNumChildren; ++i)
+        flatten_nodes(node->mChildren[i], self, nodes);
+}
+
+void dynamic_mesh::build_skin_stream(mesh_data& data, const std::vector<vertex_weights>& weights) const
+{
+    skin_stream& s = data.skin;
+
+    const std::uint32_t count = data.asset.vertex_count;
+    const std::uint32_t padded = (count + kSkinLanes - 1u) / kSkinLanes * kSkinLanes;
+
+    // Mesh palette in order of first use; the identity slot goes last once the count is known
+    constexpr std::uint32_t kUnmapped = 0xFFFFFFFFu;
+    std::vector<std::uint32_t> local(bone_offsets_.size(), kUnmapped);
+    s.palette.clear();
+    for (const vertex_weights& vw : weights)
+    {
+        for (std::uint32_t j = 0; j < vw.count; ++j)
+        {
+            std::uint32_t& slot = local[vw.bone[j]];
+            if (slot == kUnmapped && s.palette.size() + 1u < kMaxMeshBones)
+            {
+                slot = (std::uint32_t)s.palette.size();
+                s.palette.push_back(vw.bone[j]);
+            }
+        }
+    }
+    const std::uint8_t identity = (std::uint8_t)s.palette.size();
+    s.palette.push_back((std::uint32_t)bone_offsets_.size());
+
+    skin_vertex unweighted{};
+    unweighted.bone[0] = unweighted.bone[1] = unweighted.bone[2] = unweighted.bone[3] = identity;
+    unweighted.weight[0] = 255;
+
+    s.vertex_count = count;
+    s.vertices.assign(padded, unweighted);
+
+    std::uint32_t dropped = 0;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        skin_vertex& v = s.vertices[i];
+        const vec4& p = data.asset.positions[i];
+        const vec4& n = data.asset.normals[i];
+        v.px = p[0]; v.py = p[1]; v.pz = p[2];
+        v.nx = n[0]; v.ny = n[1]; v.nz = n[2];
+
+        // Influences past the palette fall back to the identity, then weights are rounded so the
+        // largest takes up what rounding left over
+        float w[4]{};
+        std::uint8_t b[4]{ identity, identity, identity, identity };
+        float sum = 0.f;
+        const vertex_weights& vw = weights[i];
+        for (std::uint32_t j = 0; j < vw.count; ++j)
+        {
+            const std::uint32_t slot = local[vw.bone[j]];
+            if (slot == kUnmapped) { ++dropped; continue; }
+            b[j] = (std::uint8_t)slot;
+            w[j] = vw.weight[j];
+            sum += w[j];
+        }
+        if (sum <= 0.f)
+            continue;
+
+        int total = 0;
+        std::uint32_t largest = 0;
+        for (std::uint32_t j = 0; j < 4; ++j)
+        {
+            v.bone[j] = b[j];
+            v.weight[j] = (std::uint8_t)std::lround(w[j] / sum * 255.f);
+            total += v.weight[j];
+            if (w[j] > w[largest]) largest = j;
+        }
+        v.weight[largest] = (std::uint8_t)(v.weight[largest] + 255 - total);
+    }
+
+    if (dropped > 0)
+        std::printf("dynamic_mesh: %u influences past the %u bone mesh palette fall back to the bind pose\n", dropped, kMaxMeshBones - 1u);
+}
+
 bool dynamic_mesh::load(const char* path, texture_cache* tex_cache)
 {
     meshes_.clear();
@@ -204,6 +286,9 @@ bool dynamic_mesh::load(const char* path, texture_cache* tex_cache)
     bone_offsets_.clear();
     mesh_node_inverse_.clear();
     mesh_node_inverse_set_.clear();
+    skin_nodes_.clear();
+    clips_.clear();
+    max_track_stride_ = 0;
 
     node_count_ = 0;
     loaded_ = false;
@@ -264,6 +349,13 @@ bool dynamic_mesh::load(const char* path, texture_cache* tex_cache)
     mesh_node_inverse_.resize(scene_->mNumMeshes);
     mesh_node_inverse_set_.assign(scene_->mNumMeshes, false);
 
+    // Textures are gathered here and decoded together once every sub-mesh is read
+    std::vector<texture_request> tex_requests{};
+    std::vector<std::size_t> tex_owners{};
+
+    // Influences stay here until every mesh has added its bones and the palettes can be built
+    std::vector<std::vector<vertex_weights>> mesh_weights(scene_->mNumMeshes);
+
     for (unsigned int mi = 0; mi < scene_->mNumMeshes; ++mi)
     {
         const aiMesh* mesh_src = scene_->mMeshes[mi];
@@ -274,46 +366,45 @@ bool dynamic_mesh::load(const char* path, texture_cache* tex_cache)
         const std::size_t vertex_count = mesh_src->mNumVertices;
         const std::size_t face_count   = mesh_src->mNumFaces;
 
-        data.base_positions.reserve(vertex_count);
-        data.base_normals.reserve(vertex_count);
-        data.weights.resize(vertex_count);
-        data.triangles.reserve(face_count);
-
         const bool has_normals = mesh_src->HasNormals();
         const bool has_uvs = mesh_src->HasTextureCoords(0);
 
-        if (has_uvs)
-            data.base_uvs.reserve(vertex_count * 2u);
+        std::uint32_t tri_count = 0;
+        for (std::size_t fi = 0; fi < face_count; ++fi)
+            tri_count += (mesh_src->mFaces[fi].mNumIndices == 3) ? 1u : 0u;
+
+        // Indexed: unique vertices once, triangles reference them
+        data.asset.allocate_indexed(tri_count, static_cast<std::uint32_t>(vertex_count), has_uvs);
 
         for (std::size_t vi = 0; vi < vertex_count; ++vi)
         {
-            const aiVector3D& pos = mesh_src->mVertices[vi];
-            aiVector3D nrm(0.f, 0.f, 1.f);
-            if (has_normals) nrm = mesh_src->mNormals[vi];
-
-            data.base_positions.push_back(pos);
-            data.base_normals.push_back(nrm);
+            const aiVector3D& p = mesh_src->mVertices[vi];
+            const aiVector3D n = has_normals ? mesh_src->mNormals[vi] : aiVector3D(0.f, 0.f, 1.f);
+            data.asset.positions[vi] = vec4(p.x, p.y, p.z, 1.f);
+            data.asset.normals[vi]   = vec4(n.x, n.y, n.z, 0.f);
 
             if (has_uvs)
             {
                 const aiVector3D& uv = mesh_src->mTextureCoords[0][vi];
-                data.base_uvs.push_back(uv.x);
-                data.base_uvs.push_back(uv.y);
+                data.asset.uvs[vi * 2u + 0] = uv.x;
+                data.asset.uvs[vi * 2u + 1] = uv.y;
             }
         }
 
+        std::uint32_t* idx = data.asset.indices;
         for (std::size_t fi = 0; fi < face_count; ++fi)
         {
             const aiFace& face = mesh_src->mFaces[fi];
             if (face.mNumIndices != 3) continue;
 
-            data.triangles.emplace_back(
-                (std::uint32_t)face.mIndices[0],
-                (std::uint32_t)face.mIndices[1],
-                (std::uint32_t)face.mIndices[2]
-            );
+            *idx++ = (std::uint32_t)face.mIndices[0];
+            *idx++ = (std::uint32_t)face.mIndices[1];
+            *idx++ = (std::uint32_t)face.mIndices[2];
         }
 
+        std::vector<vertex_weights>& weights = mesh_weights[mi];
+        weights.resize(vertex_count);
+
         if (mesh_src->HasBones())
         {
             for (unsigned int bi = 0; bi < mesh_src->mNumBones; ++bi)
@@ -340,54 +431,15 @@ bool dynamic_mesh::load(const char* path, texture_cache* tex_cache)
                 for (unsigned int wi = 0; wi < bone->mNumWeights; ++wi)
                 {
                     const aiVertexWeight& w = bone->mWeights[wi];
-                    if (w.mVertexId >= data.weights.size()) continue;
-                    add_weight(data.weights[w.mVertexId], bone_index, w.mWeight);
+                    if (w.mVertexId >= weights.size()) continue;
+                    add_weight(weights[w.mVertexId], bone_index, w.mWeight);
                 }
             }
         }
 
-        for (auto& vw : data.weights)
-        {
-            float sum = 0.f;
-            for (std::uint32_t i = 0; i < vw.count; ++i) sum += vw.weight[i];
-            if (sum > 0.f)
-                for (std::uint32_t i = 0; i < vw.count; ++i) vw.weight[i] /= sum;
-        }
-
-        data.asset.allocate(static_cast<std::uint32_t>(data.triangles.size()), has_uvs);
-        for (std::size_t t = 0; t < data.triangles.size(); ++t)
-        {
-            const triIndices& tri = data.triangles[t];
-            const std::size_t base = t * 3u;
-
-            const aiVector3D& p0 = data.base_positions[tri.v0];
-            const aiVector3D& p1 = data.base_positions[tri.v1];
-            const aiVector3D& p2 = data.base_positions[tri.v2];
-
-            const aiVector3D& n0 = data.base_normals[tri.v0];
-            const aiVector3D& n1 = data.base_normals[tri.v1];
-            const aiVector3D& n2 = data.base_normals[tri.v2];
-
-            data.asset.positions[base + 0] = vec4(p0.x, p0.y, p0.z, 1.f);
-            data.asset.positions[base + 1] = vec4(p1.x, p1.y, p1.z, 1.f);
-            data.asset.positions[base + 2] = vec4(p2.x, p2.y, p2.z, 1.f);
-
-            data.asset.normals[base + 0] = vec4(n0.x, n0.y, n0.z, 0.f);
-            data.asset.normals[base + 1] = vec4(n1.x, n1.y, n1.z, 0.f);
-            data.asset.normals[base + 2] = vec4(n2.x, n2.y, n2.z, 0.f);
+        data.bounds = compute_local_bounds(data.asset);
 
-            if (has_uvs)
-            {
-                data.asset.uvs[(base + 0) * 2 + 0] = data.base_uvs[tri.v0 * 2 + 0];
-                data.asset.uvs[(base + 0) * 2 + 1] = data.base_uvs[tri.v0 * 2 + 1];
-                data.asset.uvs[(base + 1) * 2 + 0] = data.base_uvs[tri.v1 * 2 + 0];
-                data.asset.uvs[(base + 1) * 2 + 1] = data.base_uvs[tri.v1 * 2 + 1];
-                data.asset.uvs[(base + 2) * 2 + 0] = data.base_uvs[tri.v2 * 2 + 0];
-                data.asset.uvs[(base + 2) * 2 + 1] = data.base_uvs[tri.v2 * 2 + 1];
-            }
-        }
-
-        // Load texture from material
+        // Texture from material
         if (tex_cache && mesh_src->mMaterialIndex < scene_->mNumMaterials)
         {
             const aiMaterial* mat = scene_->mMaterials[mesh_src->mMaterialIndex];
@@ -395,14 +447,15 @@ bool dynamic_mesh::load(const char* path, texture_cache* tex_cache)
             if (mat->GetTexture(aiTextureType_DIFFUSE, 0, &tex_path) == AI_SUCCESS)
             {
                 const aiTexture* embedded = scene_->GetEmbeddedTexture(tex_path.C_Str());
-                const TextureRGBA8* loaded = nullptr;
+                texture_request req{};
 
                 if (embedded)
                 {
                     if (embedded->mHeight == 0)
                     {
-                        std::string key = std::string(path) + "::" + tex_path.C_Str();
-                        loaded = tex_cache->load_memory(key, embedded->pcData, embedded->mWidth);
+                        req.key = std::string(path) + "::" + tex_path.C_Str();
+                        req.data = embedded->pcData;
+                        req.size = embedded->mWidth;
                     }
                 }
                 else
@@ -413,25 +466,52 @@ bool dynamic_mesh::load(const char* path, texture_cache* tex_cache)
                         dir = dir.substr(0, slash + 1);
                     else
                         dir.clear();
-                    loaded = tex_cache->load_file(dir + tex_path.C_Str());
+                    req.key = dir + tex_path.C_Str();
                 }
 
-                if (loaded && loaded->valid())
+                if (!req.key.empty())
                 {
-                    data.tex_ref.pixels = loaded->pixels;
-                    data.tex_ref.tex_w = loaded->width;
-                    data.tex_ref.tex_h = loaded->height;
+                    tex_requests.push_back(std::move(req));
+                    tex_owners.push_back(mi);
                 }
             }
+        }
+    }
 
-            if (!data.tex_ref.valid() && has_uvs)
-            {
-                const TextureRGBA8* checker = tex_cache->checkerboard();
-                data.tex_ref.pixels = checker->pixels;
-                data.tex_ref.tex_w = checker->width;
-                data.tex_ref.tex_h = checker->height;
-            }
+    if (tex_cache)
+    {
+        tex_cache->load_batch(tex_requests.data(), tex_requests.size());
+        for (std::size_t i = 0; i < tex_requests.size(); ++i)
+        {
+            if (tex_requests[i].result && tex_requests[i].result->valid())
+                meshes_[tex_owners[i]].texture = tex_requests[i].result;
         }
+
+        // checkerboard for meshes with UVs but no loaded texture
+        for (mesh_data& data : meshes_)
+        {
+            if (!data.texture && data.asset.has_uvs)
+                data.texture = tex_cache->checkerboard();
+        }
+    }
+
+    // Bone indices are final now, so the identity palette slot index is known
+    for (std::size_t mi = 0; mi < meshes_.size(); ++mi)
+    {
+        if (meshes_[mi].asset.vertex_count == 0) continue;
+        build_skin_stream(meshes_[mi], mesh_weights[mi]);
+        max_mesh_bones_ = (std::max)(max_mesh_bones_, (std::uint32_t)meshes_[mi].skin.palette.size());
+    }
+
+    std::vector<const aiNode*> nodes{};
+    if (scene_->mRootNode)
+        flatten_nodes(scene_->mRootNode, -1, nodes);
+
+    clips_.resize(anim_count);
+    for (unsigned int ai = 0; ai < anim_count; ++ai)
+    {
+        bake_clip(scene_->mAnimations[ai], nodes, clips_[ai]);
+        max_track_stride_ = (std::max)(max_track_stride_, clips_[ai].track_stride);
     }
 
     if (scene_->mRootNode)
@@ -455,14 +535,11 @@ bool dynamic_mesh::load(const char* path, texture_cache* tex_cache)
         if (inst.mesh_index >= meshes_.size()) continue;
         const auto& data = meshes_[inst.mesh_index];
 
-        for (const auto& p : data.base_positions)
-        {
-            const vec4 wp = inst.node_world * vec4(p.x, p.y, p.z, 1.f);
-            update_bounds(bounds_min_, bounds_max_, wp);
-        }
+        for (std::uint32_t vi = 0; vi < data.asset.vertex_count; ++vi)
+            update_bounds(bounds_min_, bounds_max_, inst.node_world * data.asset.positions[vi]);
     }
 
-    has_animation_ = scene_->HasAnimations() && !bone_offsets_.empty();
+    has_animation_ = !clips_.empty() && !bone_offsets_.empty();
 
     loaded_ = !instances_.empty();
 
@@ -491,6 +568,9 @@ bool dynamic_mesh::load(const char* path, texture_cache* tex_cache)
         scene_->mRootNode->mTransformation.d4
     );
 
+    importer_.FreeScene();
+    scene_ = nullptr;
+
     return loaded_;
 }
 
@@ -525,30 +605,29 @@ void dynamic_mesh::build_instances(
 {
     if (!loaded_) return;
 
-    {
-        std::vector<fecs::component_id> ids{
-            w.registry().get_id<MeshRefPN>(),
-            w.registry().get_id<Transform>(),
-            w.registry().get_id<Material>(),
-            w.registry().get_id<TextureRef>()
-        };
-        const fecs::table_id tid = w.storage().get_or_create_table(fecs::make_archetype_key(std::move(ids)));
-        fecs::table& table = w.storage().get_table(tid);
-        table.reserve(table.size() + instances_.size());
-    }
+    std::vector<MeshRefPN>  refs;
+    std::vector<Bounds>     bounds;
+    std::vector<matrix>     worlds;
+    std::vector<TextureRef> texs;
+    refs.reserve(instances_.size());
+    bounds.reserve(instances_.size());
+    worlds.reserve(instances_.size());
+    texs.reserve(instances_.size());
 
-    out_entities.reserve(out_entities.size() + instances_.size());
     out_locals.reserve(out_locals.size() + instances_.size());
     for (const auto& inst : instances_)
     {
         if (inst.mesh_index >= meshes_.size()) continue;
 
-        const matrix world = base_world * inst.node_world;
-        const fecs::entity e = spawn_instance(w, meshes_[inst.mesh_index].asset, world, col, ka, kd,
-                                               meshes_[inst.mesh_index].tex_ref);
-        out_entities.push_back(e);
+        const auto& m = meshes_[inst.mesh_index];
+        refs.push_back(make_mesh_ref(m.asset));
+        bounds.push_back(m.bounds);
+        worlds.push_back(base_world * inst.node_world);
+        texs.push_back(texture_ref(m));
         out_locals.push_back(inst.node_world);
     }
+
+    spawn_instances(w, refs, bounds, worlds, texs, col, ka, kd, out_entities);
 }
 
 dynamic_mesh_instance dynamic_mesh::create_instance() const
@@ -556,7 +635,15 @@ dynamic_mesh_instance dynamic_mesh::create_instance() const
     dynamic_mesh_instance inst{};
     inst.parent_mesh = this;
     inst.anim_index = 0;
-    inst.bone_transforms.resize(bone_offsets_.size());
+    inst.node_globals.resize(skin_nodes_.size());
+    inst.track_pose.assign((std::size_t)kTrackComponents * max_track_stride_, 0.f);
+    inst.mesh_palette.assign(12u * (std::size_t)max_mesh_bones_, 0.f);
+
+    // Bones outside the hierarchy keep the identity, as does the trailing unweighted slot
+    const std::uint32_t stride = palette_stride();
+    inst.bone_palette.assign(12u * stride, 0.f);
+    for (std::uint32_t b = 0; b < stride; ++b)
+        write_palette(inst.bone_palette.data(), stride, b, aiMatrix4x4());
 
     // Allocate per entity mesh data
     inst.mesh_data.resize(meshes_.size());
@@ -565,146 +652,277 @@ dynamic_mesh_instance dynamic_mesh::create_instance() const
         const auto& src = meshes_[mi];
         auto& dst = inst.mesh_data[mi];
 
-        dst.skinned_positions.resize(src.base_positions.size());
-        dst.skinned_normals.resize(src.base_normals.size());
+        if (src.asset.vertex_count == 0) continue;
 
-        const bool has_uvs = !src.base_uvs.empty();
-        dst.asset.allocate((std::uint32_t)src.triangles.size(), has_uvs);
+        // Indices and UVs never change per instance and are borrowed from the shared asset
+        dst.asset.allocate_vertices(src.asset.vertex_count, false, fox::mem_tag::skinned);
+        std::copy_n(src.asset.positions, src.asset.vertex_count, dst.asset.positions);
+        std::copy_n(src.asset.normals, src.asset.vertex_count, dst.asset.normals);
+        dst.bounds = src.bounds;
+    }
 
-        // Initialize with base mesh data
-        for (std::size_t t = 0; t < src.triangles.size(); ++t)
-        {
-            const triIndices& tri = src.triangles[t];
-            const std::size_t base = t * 3u;
+    return inst;
+}
+
+void dynamic_mesh::bake_clip(const aiAnimation* anim, const std::vector<const aiNode*>& nodes, baked_clip& clip) const
+{
+    clip = {};
+    clip.node_track.assign(skin_nodes_.size(), -1);
+    if (!anim) return;
+
+    // Channel names are resolved here once; nodes without a channel keep their bind pose
+    std::vector<const aiNodeAnim*> channels;
+    for (std::size_t n = 0; n < skin_nodes_.size(); ++n)
+    {
+        const aiNodeAnim* channel = find_node_anim(anim, nodes[n]->mName);
+        if (!channel) continue;
+        clip.node_track[n] = (std::int32_t)channels.size();
+        channels.push_back(channel);
+    }
 
-            const aiVector3D& p0 = src.base_positions[tri.v0];
-            const aiVector3D& p1 = src.base_positions[tri.v1];
-            const aiVector3D& p2 = src.base_positions[tri.v2];
+    clip.duration = (std::max)(anim->mDuration, 0.0);
+    clip.ticks_per_second = (anim->mTicksPerSecond != 0.0) ? anim->mTicksPerSecond : 25.0;
 
-            const aiVector3D& n0 = src.base_normals[tri.v0];
-            const aiVector3D& n1 = src.base_normals[tri.v1];
-            const aiVector3D& n2 = src.base_normals[tri.v2];
+    const std::uint32_t tracks = (std::uint32_t)channels.size();
+    clip.track_stride = (tracks + kSkinLanes - 1u) / kSkinLanes * kSkinLanes;
 
-            dst.asset.positions[base + 0] = vec4(p0.x, p0.y, p0.z, 1.f);
-            dst.asset.positions[base + 1] = vec4(p1.x, p1.y, p1.z, 1.f);
-            dst.asset.positions[base + 2] = vec4(p2.x, p2.y, p2.z, 1.f);
+    const double seconds = clip.duration / clip.ticks_per_second;
+    clip.frame_count = (std::uint32_t)std::ceil(seconds * kClipSampleHz) + 1u;
+    clip.frames_per_tick = (clip.duration > 0.0) ? (double)(clip.frame_count - 1u) / clip.duration : 0.0;
 
-            dst.asset.normals[base + 0] = vec4(n0.x, n0.y, n0.z, 0.f);
-            dst.asset.normals[base + 1] = vec4(n1.x, n1.y, n1.z, 0.f);
-            dst.asset.normals[base + 2] = vec4(n2.x, n2.y, n2.z, 0.f);
+    // Padding tracks hold the identity so the sweep never normalises a zero rotation
+    const std::size_t frame_floats = (std::size_t)kTrackComponents * clip.track_stride;
+    clip.samples.assign(frame_floats * clip.frame_count, 0.f);
+    for (std::uint32_t f = 0; f < clip.frame_count; ++f)
+    {
+        float* frame = clip.samples.data() + f * frame_floats;
+        const double t = (clip.frames_per_tick > 0.0) ? (std::min)((double)f / clip.frames_per_tick, clip.duration) : 0.0;
 
-            if (has_uvs)
+        for (std::uint32_t k = 0; k < clip.track_stride; ++k)
+        {
+            aiVector3D pos(0.f, 0.f, 0.f), scale(1.f, 1.f, 1.f);
+            aiQuaternion rot(1.f, 0.f, 0.f, 0.f);
+            if (k < tracks)
             {
-                dst.asset.uvs[(base + 0) * 2 + 0] = src.base_uvs[tri.v0 * 2 + 0];
-                dst.asset.uvs[(base + 0) * 2 + 1] = src.base_uvs[tri.v0 * 2 + 1];
-                dst.asset.uvs[(base + 1) * 2 + 0] = src.base_uvs[tri.v1 * 2 + 0];
-                dst.asset.uvs[(base + 1) * 2 + 1] = src.base_uvs[tri.v1 * 2 + 1];
-                dst.asset.uvs[(base + 2) * 2 + 0] = src.base_uvs[tri.v2 * 2 + 0];
-                dst.asset.uvs[(base + 2) * 2 + 1] = src.base_uvs[tri.v2 * 2 + 1];
+                const aiNodeAnim* ch = channels[k];
+                pos   = interpolate_vec3(t, ch->mPositionKeys, ch->mNumPositionKeys);
+                rot   = interpolate_quat(t, ch->mRotationKeys, ch->mNumRotationKeys);
+                scale = interpolate_vec3(t, ch->mScalingKeys, ch->mNumScalingKeys);
             }
+
+            // Keep each rotation in the hemisphere of the frame before so a plain blend takes the short arc
+            if (f > 0)
+            {
+                const float* prev = frame - frame_floats;
+                const float dot = prev[3 * clip.track_stride + k] * rot.x + prev[4 * clip.track_stride + k] * rot.y
+                                + prev[5 * clip.track_stride + k] * rot.z + prev[6 * clip.track_stride + k] * rot.w;
+                if (dot < 0.f)
+                    rot = aiQuaternion(-rot.w, -rot.x, -rot.y, -rot.z);
+            }
+
+            const float values[kTrackComponents]{ pos.x, pos.y, pos.z, rot.x, rot.y, rot.z, rot.w, scale.x, scale.y, scale.z };
+            for (std::uint32_t c = 0; c < kTrackComponents; ++c)
+                frame[c * clip.track_stride + k] = values[c];
         }
     }
-
-    return inst;
 }
 
-void dynamic_mesh::tick_skinning(dynamic_mesh_instance& instance, double elapsed_seconds) const
+void dynamic_mesh::sample_clip(const baked_clip& clip, double anim_time, float* pose) noexcept
 {
-    if (!has_animation_ || !scene_ || !scene_->HasAnimations())
+    const std::uint32_t stride = clip.track_stride;
+    if (stride == 0 || clip.frame_count == 0) return;
+
+    const double x = (std::max)(anim_time * clip.frames_per_tick, 0.0);
+    const std::uint32_t last = clip.frame_count - 1u;
+    const std::uint32_t f0 = (std::min)((std::uint32_t)x, last);
+    const std::uint32_t f1 = (std::min)(f0 + 1u, last);
+    const float alpha = (float)(x - (double)f0);
+
+    const std::size_t frame_floats = (std::size_t)kTrackComponents * stride;
+    const float* a = clip.samples.data() + f0 * frame_floats;
+    const float* b = clip.samples.data() + f1 * frame_floats;
+
+#ifdef USE_SIMD
+    if (skin_isa() == raster_isa::avx2)
+    {
+        sample_clip_avx2(a, b, alpha, stride, pose);
         return;
+    }
+#endif
+    for (std::uint32_t i = 0; i < kTrackComponents * stride; ++i)
+        pose[i] = a[i] + (b[i] - a[i]) * alpha;
+
+    float* qx = pose + 3 * stride;
+    float* qy = pose + 4 * stride;
+    float* qz = pose + 5 * stride;
+    float* qw = pose + 6 * stride;
+    for (std::uint32_t k = 0; k < stride; ++k)
+    {
+        const float len2 = qx[k] * qx[k] + qy[k] * qy[k] + qz[k] * qz[k] + qw[k] * qw[k];
+        const float inv = 1.f / std::sqrt((std::max)(len2, 1e-20f));
+        qx[k] *= inv; qy[k] *= inv; qz[k] *= inv; qw[k] *= inv;
+    }
+}
 
-    const std::size_t anim_count = scene_->mNumAnimations;
-    if (anim_count == 0) return;
+void dynamic_mesh::update_palette(dynamic_mesh_instance& instance, std::size_t anim_index, double anim_time) const
+{
+    const std::uint32_t stride = palette_stride();
+    if (instance.bone_palette.size() != 12u * stride)
+    {
+        instance.bone_palette.assign(12u * stride, 0.f);
+        for (std::uint32_t b = 0; b < stride; ++b)
+            write_palette(instance.bone_palette.data(), stride, b, aiMatrix4x4());
+    }
+    instance.node_globals.resize(skin_nodes_.size());
+    instance.track_pose.resize((std::size_t)kTrackComponents * max_track_stride_);
 
-    const std::size_t idx = (instance.anim_index < anim_count) ? instance.anim_index : 0;
-    const aiAnimation* anim = scene_->mAnimations[static_cast<unsigned int>(idx)];
-    if (!anim) return;
+    const baked_clip& clip = clips_[anim_index];
+    float* pose = instance.track_pose.data();
+    sample_clip(clip, anim_time, pose);
 
-    const double tps = (anim->mTicksPerSecond != 0.0) ? anim->mTicksPerSecond : 25.0;
-    const double time_in_ticks = elapsed_seconds * tps;
-    const double anim_time = std::fmod(time_in_ticks, anim->mDuration);
-
-    if (instance.bone_transforms.size() != bone_offsets_.size())
-        instance.bone_transforms.resize(bone_offsets_.size());
-
-    read_node_hierarchy_with_global_inverse(
-        anim_time,
-        scene_->mRootNode,
-        aiMatrix4x4(),
-        anim,
-        bone_map_,
-        bone_offsets_,
-        instance.bone_transforms,
-        global_inverse_
-    );
+    float* palette = instance.bone_palette.data();
 
-    for (std::size_t mi = 0; mi < meshes_.size(); ++mi)
+    for (std::size_t n = 0; n < skin_nodes_.size(); ++n)
     {
-        const auto& src = meshes_[mi];
-        if (mi >= instance.mesh_data.size()) continue;
-        auto& dst = instance.mesh_data[mi];
+        const skin_node& sn = skin_nodes_[n];
+        const std::int32_t track = clip.node_track[n];
+        const aiMatrix4x4 local = (track >= 0) ? track_local(pose, clip.track_stride, (std::uint32_t)track) : sn.bind_local;
 
-        if (src.base_positions.size() != src.weights.size())
-            continue;
+        aiMatrix4x4& global = instance.node_globals[n];
+        global = (sn.parent >= 0) ? instance.node_globals[(std::size_t)sn.parent] * local : local;
 
-        dst.skinned_positions.resize(src.base_positions.size());
-        dst.skinned_normals.resize(src.base_normals.size());
+        if (sn.bone >= 0)
+            write_palette(palette, stride, (std::uint32_t)sn.bone, global_inverse_ * global * bone_offsets_[(std::size_t)sn.bone]);
+    }
+}
 
-        for (std::size_t i = 0; i < src.base_positions.size(); ++i)
+void dynamic_mesh::skin_range(
+    const skin_stream& s,
+    const float* palette,
+    std::uint32_t stride,
+    MeshAssetPN& dst,
+    std::uint32_t begin,
+    std::uint32_t end) noexcept
+{
+#ifdef USE_SIMD
+    if (skin_isa() == raster_isa::avx2)
+    {
+        skin_range_avx2(s, palette, stride, dst, begin, end);
+        return;
+    }
+#endif
+
+    vec4* out_pos = dst.positions;
+    vec4* out_nrm = dst.normals;
+    for (std::uint32_t i = begin; i < end; ++i)
+    {
+        const skin_vertex& v = s.vertices[i];
+
+        float m[12]{};
+        for (int j = 0; j < 4; ++j)
         {
-            const auto& vw = src.weights[i];
+            if (v.weight[j] == 0) continue;
+            const float w = (float)v.weight[j] * (1.f / 255.f);
+            const std::uint32_t b = v.bone[j];
+            for (std::uint32_t e = 0; e < 12; ++e)
+                m[e] += palette[e * stride + b] * w;
+        }
 
-            if (vw.count == 0)
-            {
-                dst.skinned_positions[i] = src.base_positions[i];
-                dst.skinned_normals[i]   = src.base_normals[i];
-                continue;
-            }
+        const float px = v.px, py = v.py, pz = v.pz;
+        const float nx = v.nx, ny = v.ny, nz = v.nz;
 
-            aiVector3D pos(0.f, 0.f, 0.f);
-            aiVector3D nrm(0.f, 0.f, 0.f);
+        const float ox = m[0] * px + m[1] * py + m[2]  * pz + m[3];
+        const float oy = m[4] * px + m[5] * py + m[6]  * pz + m[7];
+        const float oz = m[8] * px + m[9] * py + m[10] * pz + m[11];
 
-            for (std::uint32_t j = 0; j < vw.count; ++j)
-            {
-                const std::uint32_t bi = vw.bone[j];
-                if (bi >= instance.bone_transforms.size()) continue;
+        float tx = m[0] * nx + m[1] * ny + m[2]  * nz;
+        float ty = m[4] * nx + m[5] * ny + m[6]  * nz;
+        float tz = m[8] * nx + m[9] * ny + m[10] * nz;
+        const float len2 = tx * tx + ty * ty + tz * tz;
+        if (len2 > 0.f)
+        {
+            const float inv = 1.f / std::sqrt(len2);
+            tx *= inv; ty *= inv; tz *= inv;
+        }
 
-                const float w = vw.weight[j];
+        out_pos[i] = vec4(ox, oy, oz, 1.f);
+        out_nrm[i] = vec4(tx, ty, tz, 0.f);
+    }
+}
 
-                const aiMatrix4x4& skinM = instance.bone_transforms[bi];
-                pos += (skinM * src.base_positions[i]) * w;
+void dynamic_mesh::tick_skinning(dynamic_mesh_instance& instance, double elapsed_seconds) const
+{
+    if (!has_animation_)
+        return;
 
-                const aiMatrix3x3 N(skinM);
-                nrm += (N * src.base_normals[i]) * w;
-            }
+    const std::size_t anim_count = clips_.size();
+    if (anim_count == 0) return;
 
-            nrm.Normalize();
-            dst.skinned_positions[i] = pos;
-            dst.skinned_normals[i]   = nrm;
-        }
+    const std::size_t idx = (instance.anim_index < anim_count) ? instance.anim_index : 0;
+    const baked_clip& clip = clips_[idx];
+    if (clip.node_track.empty()) return;
 
-        for (std::size_t t = 0; t < src.triangles.size(); ++t)
-        {
-            const triIndices& tri = src.triangles[t];
-            const std::size_t base = t * 3u;
+    double anim_time = 0.0;
+    if (clip.duration > 0.0)
+    {
+        anim_time = std::fmod(elapsed_seconds * clip.ticks_per_second, clip.duration);
+        if (anim_time < 0.0)
+            anim_time += clip.duration;
+    }
 
-            const aiVector3D& p0 = dst.skinned_positions[tri.v0];
-            const aiVector3D& p1 = dst.skinned_positions[tri.v1];
-            const aiVector3D& p2 = dst.skinned_positions[tri.v2];
+    update_palette(instance, idx, anim_time);
 
-            const aiVector3D& n0 = dst.skinned_normals[tri.v0];
-            const aiVector3D& n1 = dst.skinned_normals[tri.v1];
-            const aiVector3D& n2 = dst.skinned_normals[tri.v2];
+    const float* palette = instance.bone_palette.data();
+    const std::uint32_t stride = palette_stride();
+    instance.mesh_palette.resize(12u * (std::size_t)max_mesh_bones_);
 
-            dst.asset.positions[base + 0] = vec4(p0.x, p0.y, p0.z, 1.f);
-            dst.asset.positions[base + 1] = vec4(p1.x, p1.y, p1.z, 1.f);
-            dst.asset.positions[base + 2] = vec4(p2.x, p2.y, p2.z, 1.f);
+    for (std::size_t mi = 0; mi < meshes_.size(); ++mi)
+    {
+        const auto& src = meshes_[mi];
+        if (mi >= instance.mesh_data.size()) continue;
+        auto& dst = instance.mesh_data[mi];
 
-            dst.asset.normals[base + 0] = vec4(n0.x, n0.y, n0.z, 0.f);
-            dst.asset.normals[base + 1] = vec4(n1.x, n1.y, n1.z, 0.f);
-            dst.asset.normals[base + 2] = vec4(n2.x, n2.y, n2.z, 0.f);
-        }
+        if (src.skin.vertex_count == 0 || !dst.asset.positions)
+            continue;
+
+        // Narrow the palette to this mesh's bones so the byte indices address it directly
+        const std::uint32_t mesh_stride = (std::uint32_t)src.skin.palette.size();
+        float* mesh_palette = instance.mesh_palette.data();
+        for (std::uint32_t e = 0; e < 12; ++e)
+            for (std::uint32_t l = 0; l < mesh_stride; ++l)
+                mesh_palette[e * mesh_stride + l] = palette[e * stride + src.skin.palette[l]];
+
+        // Vertex ranges are independent; this nests inside the per-instance fan-out in render_queue
+        fox::job_system::instance().parallel_for(src.skin.vertex_count, kSkinGrain,
+            [&](std::uint32_t begin, std::uint32_t end)
+            {
+                skin_range(src.skin, mesh_palette, mesh_stride, dst.asset, begin, end);
+            });
+
+        dst.bounds = compute_local_bounds(dst.asset);
+    }
+}
+
+MeshRefPN dynamic_mesh::instance_mesh_ref(const dynamic_mesh_instance& instance, std::size_t mesh_index) const noexcept
+{
+    if (mesh_index >= meshes_.size()) return {};
+
+    MeshRefPN r = make_mesh_ref(meshes_[mesh_index].asset);
+    if (mesh_index < instance.mesh_data.size() && instance.mesh_data[mesh_index].asset.positions)
+    {
+        r.positions = instance.mesh_data[mesh_index].asset.positions;
+        r.normals   = instance.mesh_data[mesh_index].asset.normals;
     }
+    return r;
+}
+
+Bounds dynamic_mesh::instance_bounds(const dynamic_mesh_instance& instance, std::size_t mesh_index) const noexcept
+{
+    if (mesh_index < instance.mesh_data.size() && instance.mesh_data[mesh_index].asset.positions)
+        return instance.mesh_data[mesh_index].bounds;
+    if (mesh_index < meshes_.size())
+        return meshes_[mesh_index].bounds;
+    return {};
 }
 
 bool dynamic_mesh::sample_node_world(matrix& out) const noexcept
@@ -713,3 +931,18 @@ bool dynamic_mesh::sample_node_world(matrix& out) const noexcept
     out = instances_[0].node_world;
     return true;
 }
+
+std::size_t dynamic_mesh::resident_bytes() const noexcept
+{
+    const auto vec_bytes = [](const auto& v) noexcept { return v.capacity() * sizeof(v[0]); };
+
+    std::size_t bytes = 0;
+    for (const mesh_data& data : meshes_)
+    {
+        bytes += data.asset.resident_bytes();
+        bytes += vec_bytes(data.skin.vertices) + vec_bytes(data.skin.palette);
+    }
+    for (const baked_clip& clip : clips_)
+        bytes += vec_bytes(clip.node_track) + vec_bytes(clip.samples);
+    return bytes;
+}
@@ -0,0 +1,135 @@
+#include "game/dynamic_mesh.h"
+
+#include <algorithm>
+
+// Built with AVX2 code generation regardless of FOX_SIMD_LEVEL, only reached when CPUID reports AVX2
+#ifdef USE_SIMD
+#include <immintrin.h>
+
+void dynamic_mesh::sample_clip_avx2(const float* a, const float* b, float alpha, std::uint32_t stride, float* pose) noexcept
+{
+    const __m256 va = _mm256_set1_ps(alpha);
+    for (std::uint32_t k = 0; k < stride; k += kSkinLanes)
+    {
+        __m256 v[kTrackComponents];
+        for (std::uint32_t c = 0; c < kTrackComponents; ++c)
+        {
+            const __m256 fa = _mm256_loadu_ps(a + c * stride + k);
+            const __m256 fb = _mm256_loadu_ps(b + c * stride + k);
+            v[c] = _mm256_fmadd_ps(_mm256_sub_ps(fb, fa), va, fa);
+        }
+
+        __m256 len2 = _mm256_mul_ps(v[3], v[3]);
+        len2 = _mm256_fmadd_ps(v[4], v[4], len2);
+        len2 = _mm256_fmadd_ps(v[5], v[5], len2);
+        len2 = _mm256_fmadd_ps(v[6], v[6], len2);
+        const __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(_mm256_max_ps(len2, _mm256_set1_ps(1e-20f))));
+        for (std::uint32_t c = 3; c < 7; ++c)
+            v[c] = _mm256_mul_ps(v[c], inv);
+
+        for (std::uint32_t c = 0; c < kTrackComponents; ++c)
+            _mm256_storeu_ps(pose + c * stride + k, v[c]);
+    }
+}
+
+void dynamic_mesh::skin_range_avx2(
+    const skin_stream& s,
+    const float* palette,
+    std::uint32_t stride,
+    MeshAssetPN& dst,
+    std::uint32_t begin,
+    std::uint32_t end) noexcept
+{
+    vec4* out_pos = dst.positions;
+    vec4* out_nrm = dst.normals;
+
+    // begin is batch aligned and the stream is padded, so whole batches can always be loaded
+    alignas(32) float rp[3][kSkinLanes];
+    alignas(32) float rn[3][kSkinLanes];
+
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256  inv_255 = _mm256_set1_ps(1.f / 255.f);
+
+    for (std::uint32_t i = begin; i < end; i += kSkinLanes)
+    {
+        // Eight 32 byte records transposed into one register per field
+        const float* src = (const float*)(s.vertices.data() + i);
+        __m256 r0 = _mm256_loadu_ps(src + 0),  r1 = _mm256_loadu_ps(src + 8);
+        __m256 r2 = _mm256_loadu_ps(src + 16), r3 = _mm256_loadu_ps(src + 24);
+        __m256 r4 = _mm256_loadu_ps(src + 32), r5 = _mm256_loadu_ps(src + 40);
+        __m256 r6 = _mm256_loadu_ps(src + 48), r7 = _mm256_loadu_ps(src + 56);
+        {
+            const __m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1);
+            const __m256 t2 = _mm256_unpacklo_ps(r2, r3), t3 = _mm256_unpackhi_ps(r2, r3);
+            const __m256 t4 = _mm256_unpacklo_ps(r4, r5), t5 = _mm256_unpackhi_ps(r4, r5);
+            const __m256 t6 = _mm256_unpacklo_ps(r6, r7), t7 = _mm256_unpackhi_ps(r6, r7);
+            const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+            const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+            const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+            r0 = _mm256_permute2f128_ps(s0, s4, 0x20); r1 = _mm256_permute2f128_ps(s1, s5, 0x20);
+            r2 = _mm256_permute2f128_ps(s2, s6, 0x20); r3 = _mm256_permute2f128_ps(s3, s7, 0x20);
+            r4 = _mm256_permute2f128_ps(s0, s4, 0x31); r5 = _mm256_permute2f128_ps(s1, s5, 0x31);
+            r6 = _mm256_permute2f128_ps(s2, s6, 0x31); r7 = _mm256_permute2f128_ps(s3, s7, 0x31);
+        }
+
+        const __m256i bones = _mm256_castps_si256(r6);
+        const __m256i wbytes = _mm256_castps_si256(r7);
+        const __m256i b0 = _mm256_and_si256(bones, byte_mask);
+        const __m256i b1 = _mm256_and_si256(_mm256_srli_epi32(bones, 8), byte_mask);
+        const __m256i b2 = _mm256_and_si256(_mm256_srli_epi32(bones, 16), byte_mask);
+        const __m256i b3 = _mm256_srli_epi32(bones, 24);
+        const __m256 w0 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(wbytes, byte_mask)), inv_255);
+        const __m256 w1 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(wbytes, 8), byte_mask)), inv_255);
+        const __m256 w2 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(wbytes, 16), byte_mask)), inv_255);
+        const __m256 w3 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(wbytes, 24)), inv_255);
+
+        // Blend the four influences into one 3x4 matrix per lane
+        __m256 m[12];
+        for (std::uint32_t e = 0; e < 12; ++e)
+        {
+            const float* row = palette + e * stride;
+            __m256 acc = _mm256_mul_ps(_mm256_i32gather_ps(row, b0, 4), w0);
+            acc = _mm256_fmadd_ps(_mm256_i32gather_ps(row, b1, 4), w1, acc);
+            acc = _mm256_fmadd_ps(_mm256_i32gather_ps(row, b2, 4), w2, acc);
+            acc = _mm256_fmadd_ps(_mm256_i32gather_ps(row, b3, 4), w3, acc);
+            m[e] = acc;
+        }
+
+        const __m256 px = r0, py = r1, pz = r2;
+        const __m256 nx = r3, ny = r4, nz = r5;
+
+        for (int r = 0; r < 3; ++r)
+        {
+            const __m256* mr = m + r * 4;
+            __m256 p = _mm256_fmadd_ps(mr[0], px, mr[3]);
+            p = _mm256_fmadd_ps(mr[1], py, p);
+            p = _mm256_fmadd_ps(mr[2], pz, p);
+            _mm256_store_ps(rp[r], p);
+
+            __m256 n = _mm256_mul_ps(mr[0], nx);
+            n = _mm256_fmadd_ps(mr[1], ny, n);
+            n = _mm256_fmadd_ps(mr[2], nz, n);
+            _mm256_store_ps(rn[r], n);
+        }
+
+        const __m256 tnx = _mm256_load_ps(rn[0]);
+        const __m256 tny = _mm256_load_ps(rn[1]);
+        const __m256 tnz = _mm256_load_ps(rn[2]);
+        __m256 len2 = _mm256_mul_ps(tnx, tnx);
+        len2 = _mm256_fmadd_ps(tny, tny, len2);
+        len2 = _mm256_fmadd_ps(tnz, tnz, len2);
+        const __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(_mm256_max_ps(len2, _mm256_set1_ps(1e-20f))));
+        _mm256_store_ps(rn[0], _mm256_mul_ps(tnx, inv));
+        _mm256_store_ps(rn[1], _mm256_mul_ps(tny, inv));
+        _mm256_store_ps(rn[2], _mm256_mul_ps(tnz, inv));
+
+        const std::uint32_t lanes = (std::min)(kSkinLanes, end - i);
+        for (std::uint32_t l = 0; l < lanes; ++l)
+        {
+            out_pos[i + l] = vec4(rp[0][l], rp[1][l], rp[2][l], 1.f);
+            out_nrm[i + l] = vec4(rn[0][l], rn[1][l], rn[2][l], 0.f);
+        }
+    }
+}
+#endif
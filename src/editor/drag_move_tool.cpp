@@ -4,13 +4,11 @@
 #include <algorithm>
 #include <cmath>
 #include <limits>
-#include <vector>
 
 namespace fox::editor
 {
     namespace
     {
-        constexpr float kPickRadiusBase = 0.75f;
         constexpr float kRayEpsilon = 1e-5f;
         constexpr float kRotateSpeedRadPerPixel = 0.01f;
 
@@ -158,50 +156,30 @@ namespace fox::editor
             ctx.proj,
             ctx.camera_pos);
 
-        std::vector<render_queue::object_info> objects;
-        ctx.rq->enumerate_objects(objects);
-
         float best_t = std::numeric_limits<float>::max();
         render_queue::object_id best_id = 0;
         float selected_t = std::numeric_limits<float>::max();
         render_queue::object_id selected_hit = 0;
 
-        for (const render_queue::object_info& info : objects)
+        // Only objects whose pick sphere the ray enters come back, hidden ones are not indexed
+        ctx.rq->pick_index().raycast(mouse_ray.origin, mouse_ray.dir, [&](const render_queue::object_id id, const float t)
         {
-            if (!info.visible)
-                continue;
-
-            editor_object_component* obj = nullptr;
-            if (!ctx.rq->try_get_editor_object(info.id, obj) || !obj)
-                continue;
-
-            float radius = kPickRadiusBase;
-            if (!ctx.rq->try_get_pick_radius(info.id, radius))
-            {
-                const float max_scale = (std::max)({ std::fabs(obj->scale.x), std::fabs(obj->scale.y), std::fabs(obj->scale.z), 0.1f });
-                radius = kPickRadiusBase * max_scale;
-            }
-
-            float t = 0.f;
-            if (!ray_sphere_hit(mouse_ray, obj->position, radius, t))
-                continue;
-
-            if (info.id == selected_object_id_)
+            if (id == selected_object_id_)
             {
                 if (t < selected_t)
                 {
                     selected_t = t;
-                    selected_hit = info.id;
+                    selected_hit = id;
                 }
-                continue;
+                return;
             }
 
             if (t < best_t)
             {
                 best_t = t;
-                best_id = info.id;
+                best_id = id;
             }
-        }
+        });
 
         dragged_object_id_ = (selected_hit != 0) ? selected_hit : best_id;
         if (dragged_object_id_ == 0)
@@ -316,31 +294,6 @@ namespace fox::editor
         return out;
     }
 
-    bool drag_move_tool::ray_sphere_hit(const ray& r, const vec4& center, float radius, float& t_out) noexcept
-    {
-        const vec4 oc = r.origin - center;
-        const float a = vec4::dot(r.dir, r.dir);
-        const float b = 2.f * vec4::dot(oc, r.dir);
-        const float c = vec4::dot(oc, oc) - radius * radius;
-
-        const float discriminant = b * b - 4.f * a * c;
-        if (discriminant < 0.f)
-            return false;
-
-        const float sqrt_d = std::sqrt(discriminant);
-        const float inv_2a = 1.f / (2.f * a);
-        float t0 = (-b - sqrt_d) * inv_2a;
-        float t1 = (-b + sqrt_d) * inv_2a;
-        if (t0 > t1)
-            std::swap(t0, t1);
-
-        if (t1 < 0.f)
-            return false;
-
-        t_out = (t0 >= 0.f) ? t0 : t1;
-        return true;
-    }
-
     bool drag_move_tool::ray_plane_hit(const ray& r, const vec4& plane_point, const vec4& plane_normal, vec4& out_hit) noexcept
     {
         const float denom = vec4::dot(plane_normal, r.dir);
@@ -11,6 +11,7 @@ public:
 
 	[[nodiscard]] bool OpenForRead (_In_ const std::string& path);
 	[[nodiscard]] bool OpenForWrite(_In_ const std::string& path);
+	[[nodiscard]] bool MapForRead  (_In_ const std::string& path);
 
 	void Close();
 	[[nodiscard]] bool ReadBytes(_Out_writes_bytes_all_(size) void*  dest,
@@ -26,10 +27,13 @@ public:
 
 	[[nodiscard]] bool          IsOpen	   () const;
 	[[nodiscard]] std::uint64_t GetFileSize() const;
+	[[nodiscard]] const std::uint8_t* GetMappedData() const;
 
 private:
-	HANDLE m_fileHandle{ INVALID_HANDLE_VALUE };
-	bool   m_bReadMode{ false };
+	HANDLE      m_fileHandle{ INVALID_HANDLE_VALUE };
+	HANDLE      m_mapping{ nullptr };
+	const void* m_view{ nullptr };
+	bool        m_bReadMode{ false };
 };
 
 #pragma endregion
@@ -57,6 +61,12 @@ bool FileSystem::OpenForWrite(const std::string& path)
 	return m_impl->OpenForWrite(path);
 }
 
+_Use_decl_annotations_
+bool FileSystem::MapForRead(const std::string& path)
+{
+	return m_impl->MapForRead(path);
+}
+
 void FileSystem::Close()
 {
 	if (!m_impl) return;
@@ -117,6 +127,11 @@ bool FileSystem::IsOpen() const
 	return m_impl->IsOpen();
 }
 
+const std::uint8_t* FileSystem::GetMappedData() const
+{
+	return m_impl->GetMappedData();
+}
+
 #pragma endregion
 
 #pragma region Impl_Implementation
@@ -162,8 +177,43 @@ bool FileSystem::Impl::OpenForWrite(const std::string& path)
 	return m_fileHandle != INVALID_HANDLE_VALUE;
 }
 
+_Use_decl_annotations_
+bool FileSystem::Impl::MapForRead(const std::string& path)
+{
+	Close();
+	if (!OpenForRead(path)) return false;
+
+	// An empty file cannot be mapped
+	if (GetFileSize() == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMapping(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping)
+		m_view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (!m_view)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
 void FileSystem::Impl::Close()
 {
+	if (m_view)
+	{
+		UnmapViewOfFile(m_view);
+		m_view = nullptr;
+	}
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+	}
 	if (m_fileHandle != INVALID_HANDLE_VALUE)
 	{
 		CloseHandle(m_fileHandle);
@@ -250,4 +300,9 @@ bool FileSystem::Impl::IsOpen() const
 	return m_fileHandle != INVALID_HANDLE_VALUE;
 }
 
+const std::uint8_t* FileSystem::Impl::GetMappedData() const
+{
+	return static_cast<const std::uint8_t*>(m_view);
+}
+
 #pragma endregion
\ No newline at end of file
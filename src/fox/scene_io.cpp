@@ -1,7 +1,12 @@
 #include "fox/scene_io.h"
+#include "file_system.h"
 
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -9,6 +14,69 @@
 namespace
 {
     constexpr int k_scene_version = 1;
+
+    const char* cull_mode_name(const cull_mode mode)
+    {
+        switch (mode)
+        {
+        case cull_mode::back: return "back";
+        case cull_mode::front: return "front";
+        default: return "none";
+        }
+    }
+
+    cull_mode parse_cull_mode(const std::string_view value, const cull_mode fallback)
+    {
+        if (value == "none")
+            return cull_mode::none;
+        if (value == "back")
+            return cull_mode::back;
+        if (value == "front")
+            return cull_mode::front;
+        return fallback;
+    }
+
+    // .foxscene snapshot: header | snapshot_object[object_count] | string bytes | post processing
+    // settings as they sit in memory. Everything is flat, so a load is one read and a walk.
+    constexpr std::uint32_t k_snapshot_magic = 0x4E435346u; // "FSCN"
+    constexpr std::uint32_t k_snapshot_version = 1;
+
+    struct snapshot_header
+    {
+        std::uint32_t magic = 0;
+        std::uint32_t version = 0;
+        std::uint32_t object_count = 0;
+        std::uint32_t string_bytes = 0;
+        std::uint32_t globals_size = 0;     // 0 when saved without globals
+        std::uint32_t reserved = 0;
+    };
+
+    struct snapshot_object
+    {
+        std::uint64_t id = 0;
+        std::uint32_t name_offset = 0;      // into the string bytes
+        std::uint32_t name_size = 0;
+        std::uint32_t model_offset = 0;
+        std::uint32_t model_size = 0;
+        float position[3]{};
+        float rotation[3]{};
+        float scale[3]{};
+        std::uint32_t anim_index = 0;
+        float playback_speed = 1.0f;
+        float time_offset = 0.0f;
+        float anim_time = 0.0f;
+        std::uint8_t is_dynamic = 0;
+        std::uint8_t visible = 1;
+        std::uint8_t cull = 0;
+        std::uint8_t anim_enabled = 1;
+        std::uint8_t anim_paused = 0;
+        std::uint8_t pad[3]{};
+    };
+
+    bool is_snapshot_path(const std::string& path)
+    {
+        return std::filesystem::path(path).extension() == ".foxscene";
+    }
 }
 
 namespace fox
@@ -37,57 +105,11 @@ namespace fox
             return false;
         }
 
-        std::unordered_map<std::uint64_t, scene_object_record> records;
-        world_.query<editor_object_component>().each_entity([&](fecs::entity, editor_object_component& obj)
-        {
-            if (obj.object_id == 0)
-                return;
-            if (records.find(obj.object_id) != records.end())
-                return;
-
-            scene_object_record record{};
-            record.id = obj.object_id;
-            record.name = obj.name;
-            record.model = obj.model;
-            record.is_dynamic = obj.is_dynamic;
-            record.position = obj.position;
-            record.rotation = obj.rotation;
-            record.scale = obj.scale;
-            record.anim.enabled = obj.anim_enabled;
-            record.anim.paused = obj.anim_paused;
-            record.anim.index = obj.anim_index;
-            record.anim.playback_speed = obj.playback_speed;
-            record.anim.time_offset = obj.time_offset;
-            record.anim.anim_time = obj.anim_time;
-            records.emplace(record.id, std::move(record));
-        });
-
-        world_.query<editor_object_component, static_mesh_component>().each_entity([&](fecs::entity, editor_object_component& obj, static_mesh_component& mesh)
-        {
-            auto it = records.find(obj.object_id);
-            if (it == records.end())
-                return;
-            it->second.visible = mesh.visible;
-        });
-
-        world_.query<editor_object_component, dynamic_mesh_component>().each_entity([&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& mesh)
-        {
-            auto it = records.find(obj.object_id);
-            if (it == records.end())
-                return;
-            it->second.visible = mesh.visible;
-            it->second.anim = mesh.anim;
-        });
-
         std::vector<scene_object_record> ordered;
-        ordered.reserve(records.size());
-        for (const auto& entry : records)
-            ordered.push_back(entry.second);
+        collect_records(ordered);
 
-        std::sort(ordered.begin(), ordered.end(), [](const scene_object_record& a, const scene_object_record& b)
-        {
-            return a.id < b.id;
-        });
+        if (is_snapshot_path(desc.path))
+            return save_snapshot(desc, ordered);
 
         JsonLoader root;
         JsonLoader& scene = root["scene"];
@@ -104,6 +126,7 @@ namespace fox
             node["type"] = record.is_dynamic ? "dynamic_mesh" : "static_mesh";
             node["asset"] = record.model;
             node["visible"] = record.visible;
+            node["cull"] = cull_mode_name(record.cull);
 
             JsonLoader& transform = node["transform"];
             JsonLoader& pos = transform["position"];
@@ -149,15 +172,17 @@ namespace fox
             return false;
         }
 
-        JsonLoader root;
-        root.Load(desc.path);
-        if (!root.IsValid())
+        if (is_snapshot_path(desc.path))
+            return load_snapshot(desc);
+
+        JsonDocument document;
+        if (!document.Load(desc.path))
         {
             set_error("scene_io: failed to load scene json");
             return false;
         }
 
-        const JsonLoader& scene = root["scene"];
+        const JsonValue scene = document.Root()["scene"];
         if (!scene.IsValid())
         {
             set_error("scene_io: missing root 'scene' node");
@@ -174,71 +199,402 @@ namespace fox
         if (desc.clear_existing)
             clear_existing_editor_objects();
 
-        const JsonLoader& objects = scene["objects"];
-        if (objects.IsValid())
+        std::vector<scene_object_record> records;
+        records.reserve(scene["objects"].Size());
+        for (const auto& item : scene["objects"])
         {
-            std::uint64_t max_id = queue_.next_object_id();
-        for (const auto& item : objects)
+            scene_object_record record{};
+            if (item.second.IsValid() && parse_scene_object(item.second, record))
+                records.push_back(std::move(record));
+        }
+        spawn_records(records);
+
+        read_globals(scene);
+
+        return true;
+    }
+
+    void scene_io::collect_records(std::vector<scene_object_record>& out) const
+    {
+        std::unordered_map<std::uint64_t, scene_object_record> records;
+        world_.query<editor_object_component>().each_entity([&](fecs::entity, editor_object_component& obj)
         {
-            const JsonLoader& node = item.second;
-            if (!node.IsValid())
-                continue;
+            if (obj.object_id == 0)
+                return;
+            if (records.find(obj.object_id) != records.end())
+                return;
 
             scene_object_record record{};
-            if (!parse_scene_object(node, record))
-                continue;
+            record.id = obj.object_id;
+            record.name = obj.name;
+            record.model = obj.model;
+            record.is_dynamic = obj.is_dynamic;
+            record.position = obj.position;
+            record.rotation = obj.rotation;
+            record.scale = obj.scale;
+            record.anim.enabled = obj.anim_enabled;
+            record.anim.paused = obj.anim_paused;
+            record.anim.index = obj.anim_index;
+            record.anim.playback_speed = obj.playback_speed;
+            record.anim.time_offset = obj.time_offset;
+            record.anim.anim_time = obj.anim_time;
+            records.emplace(record.id, std::move(record));
+        });
 
-            render_queue::object_id spawned = 0;
-            if (record.is_dynamic)
+        world_.query<editor_object_component, static_mesh_component>().each_entity([&](fecs::entity, editor_object_component& obj, static_mesh_component& mesh)
+        {
+            auto it = records.find(obj.object_id);
+            if (it == records.end())
+                return;
+            it->second.visible = mesh.visible;
+        });
+
+        world_.query<editor_object_component, Material>().each_entity([&](fecs::entity, editor_object_component& obj, Material& mat)
+        {
+            auto it = records.find(obj.object_id);
+            if (it == records.end())
+                return;
+            it->second.cull = mat.cull;
+        });
+
+        world_.query<editor_object_component, dynamic_mesh_component>().each_entity([&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& mesh)
+        {
+            auto it = records.find(obj.object_id);
+            if (it == records.end())
+                return;
+            it->second.visible = mesh.visible;
+            it->second.anim = mesh.anim;
+        });
+
+        // Cells streamed out have no entities to read; their descs hold the last state they had
+        if (streamer_)
+        {
+            std::vector<render_queue::static_mesh_desc> static_descs;
+            std::vector<render_queue::dynamic_mesh_desc> dynamic_descs;
+            streamer_->collect_unloaded(static_descs, dynamic_descs);
+            for (const render_queue::static_mesh_desc& desc : static_descs)
+                records.try_emplace(desc.forced_id, to_record(desc));
+            for (const render_queue::dynamic_mesh_desc& desc : dynamic_descs)
+                records.try_emplace(desc.forced_id, to_record(desc));
+        }
+
+        out.clear();
+        out.reserve(records.size());
+        for (const auto& entry : records)
+            out.push_back(entry.second);
+
+        std::sort(out.begin(), out.end(), [](const scene_object_record& a, const scene_object_record& b)
+        {
+            return a.id < b.id;
+        });
+    }
+
+    void scene_io::spawn_records(const std::vector<scene_object_record>& records)
+    {
+        if (records.empty())
+            return;
+
+        // The streamer spawns them as the camera nears their cells and keeps next_object_id past them
+        if (streamer_ && streamer_->enabled())
+        {
+            for (const scene_object_record& record : records)
             {
-                render_queue::dynamic_mesh_desc rq_desc{};
-                rq_desc.path = record.model;
-                rq_desc.position = record.position;
-                rq_desc.rotation = record.rotation;
-                rq_desc.scale = record.scale;
-                rq_desc.visible = record.visible;
-                rq_desc.name = record.name;
-                rq_desc.anim_enabled = record.anim.enabled;
-                rq_desc.anim_paused = record.anim.paused;
-                rq_desc.anim_index = record.anim.index;
-                rq_desc.playback_speed = record.anim.playback_speed;
-                rq_desc.time_offset = record.anim.time_offset;
-                rq_desc.anim_time = record.anim.anim_time;
-                rq_desc.forced_id = record.id;
-                spawned = queue_.add_dynamic_mesh(rq_desc);
+                if (record.is_dynamic) streamer_->add(to_dynamic_desc(record));
+                else                   streamer_->add(to_static_desc(record));
             }
-            else
+            return;
+        }
+
+        std::uint64_t max_id = queue_.next_object_id();
+        const auto track = [&max_id](const render_queue::object_id id)
+        {
+            if (id > max_id)
+                max_id = id;
+        };
+
+        // Dynamic meshes carry per entity skinning state and still spawn one by one; static ones
+        // go through the queue's bulk path in a single batch. Tags are recorded and added in one
+        // flush, so each dynamic entity changes archetype once instead of once per spawn.
+        fecs::command_buffer tags(world_);
+        std::vector<render_queue::static_mesh_desc> static_descs;
+        static_descs.reserve(records.size());
+        for (const scene_object_record& record : records)
+        {
+            if (!record.is_dynamic)
             {
-                render_queue::static_mesh_desc rq_desc{};
-                rq_desc.path = record.model;
-                rq_desc.position = record.position;
-                rq_desc.rotation = record.rotation;
-                rq_desc.scale = record.scale;
-                rq_desc.visible = record.visible;
-                rq_desc.name = record.name;
-                rq_desc.forced_id = record.id;
-                spawned = queue_.add_static_mesh(rq_desc);
+                static_descs.push_back(to_static_desc(record));
+                continue;
             }
 
+            const render_queue::dynamic_mesh_desc rq_desc = to_dynamic_desc(record);
+            const render_queue::object_id spawned = queue_.add_dynamic_mesh(rq_desc);
             if (spawned == 0)
                 continue;
 
             for (const auto e : queue_.entities(spawned))
-                world_.add_component<editor_tag>(e);
+                tags.add_component<editor_tag>(e);
+            track(spawned);
+        }
+        world_.flush(tags);
+
+        std::vector<render_queue::object_id> spawned;
+        queue_.add_static_meshes(static_descs, true, spawned);
+        for (const render_queue::object_id id : spawned)
+            track(id);
+
+        if (max_id >= queue_.next_object_id())
+            queue_.set_next_object_id(max_id + 1);
+    }
+
+    render_queue::static_mesh_desc scene_io::to_static_desc(const scene_object_record& record)
+    {
+        render_queue::static_mesh_desc rq_desc{};
+        rq_desc.path = record.model;
+        rq_desc.position = record.position;
+        rq_desc.rotation = record.rotation;
+        rq_desc.scale = record.scale;
+        rq_desc.visible = record.visible;
+        rq_desc.name = record.name;
+        rq_desc.cull = record.cull;
+        rq_desc.forced_id = record.id;
+        return rq_desc;
+    }
+
+    render_queue::dynamic_mesh_desc scene_io::to_dynamic_desc(const scene_object_record& record)
+    {
+        render_queue::dynamic_mesh_desc rq_desc{};
+        rq_desc.path = record.model;
+        rq_desc.position = record.position;
+        rq_desc.rotation = record.rotation;
+        rq_desc.scale = record.scale;
+        rq_desc.visible = record.visible;
+        rq_desc.name = record.name;
+        rq_desc.cull = record.cull;
+        rq_desc.anim_enabled = record.anim.enabled;
+        rq_desc.anim_paused = record.anim.paused;
+        rq_desc.anim_index = record.anim.index;
+        rq_desc.playback_speed = record.anim.playback_speed;
+        rq_desc.time_offset = record.anim.time_offset;
+        rq_desc.anim_time = record.anim.anim_time;
+        rq_desc.forced_id = record.id;
+        return rq_desc;
+    }
+
+    scene_io::scene_object_record scene_io::to_record(const render_queue::static_mesh_desc& desc)
+    {
+        scene_object_record record{};
+        record.id = desc.forced_id;
+        record.name = desc.name;
+        record.model = desc.path;
+        record.visible = desc.visible;
+        record.cull = desc.cull;
+        record.position = desc.position;
+        record.rotation = desc.rotation;
+        record.scale = desc.scale;
+        return record;
+    }
+
+    scene_io::scene_object_record scene_io::to_record(const render_queue::dynamic_mesh_desc& desc)
+    {
+        scene_object_record record{};
+        record.id = desc.forced_id;
+        record.name = desc.name;
+        record.model = desc.path;
+        record.is_dynamic = true;
+        record.visible = desc.visible;
+        record.cull = desc.cull;
+        record.position = desc.position;
+        record.rotation = desc.rotation;
+        record.scale = desc.scale;
+        record.anim.enabled = desc.anim_enabled;
+        record.anim.paused = desc.anim_paused;
+        record.anim.index = desc.anim_index;
+        record.anim.playback_speed = desc.playback_speed;
+        record.anim.time_offset = desc.time_offset;
+        record.anim.anim_time = desc.anim_time;
+        return record;
+    }
+
+    bool scene_io::save_snapshot(const scene_save_desc& desc, const std::vector<scene_object_record>& records)
+    {
+        static_assert(std::is_trivially_copyable_v<scene_post_processing_settings>);
+
+        std::string strings;
+        std::vector<snapshot_object> objects(records.size());
+        const auto add_string = [&strings](const std::string& value, std::uint32_t& offset, std::uint32_t& size)
+        {
+            offset = (std::uint32_t)strings.size();
+            size = (std::uint32_t)value.size();
+            strings += value;
+        };
+
+        for (std::size_t i = 0; i < records.size(); ++i)
+        {
+            const scene_object_record& record = records[i];
+            snapshot_object& o = objects[i];
+            o.id = record.id;
+            add_string(record.name, o.name_offset, o.name_size);
+            add_string(record.model, o.model_offset, o.model_size);
+            for (unsigned int c = 0; c < 3; ++c)
+            {
+                o.position[c] = record.position[c];
+                o.rotation[c] = record.rotation[c];
+                o.scale[c] = record.scale[c];
+            }
+            o.anim_index = (std::uint32_t)record.anim.index;
+            o.playback_speed = record.anim.playback_speed;
+            o.time_offset = record.anim.time_offset;
+            o.anim_time = record.anim.anim_time;
+            o.is_dynamic = record.is_dynamic ? 1 : 0;
+            o.visible = record.visible ? 1 : 0;
+            o.cull = (std::uint8_t)record.cull;
+            o.anim_enabled = record.anim.enabled ? 1 : 0;
+            o.anim_paused = record.anim.paused ? 1 : 0;
+        }
+
+        scene_post_processing_settings settings{};
+        const bool with_globals = desc.include_globals && read_post_processing_callback_;
+        if (with_globals)
+            read_post_processing_callback_(settings);
 
-            if (spawned > max_id)
-                max_id = spawned;
+        snapshot_header header{};
+        header.magic = k_snapshot_magic;
+        header.version = k_snapshot_version;
+        header.object_count = (std::uint32_t)objects.size();
+        header.string_bytes = (std::uint32_t)strings.size();
+        header.globals_size = with_globals ? (std::uint32_t)sizeof(settings) : 0u;
+
+        const std::size_t objects_bytes = objects.size() * sizeof(snapshot_object);
+        std::vector<std::uint8_t> out(sizeof(header) + objects_bytes + strings.size() + header.globals_size);
+        std::uint8_t* p = out.data();
+        std::memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+        if (objects_bytes)
+            std::memcpy(p, objects.data(), objects_bytes);
+        p += objects_bytes;
+        if (!strings.empty())
+            std::memcpy(p, strings.data(), strings.size());
+        p += strings.size();
+        if (with_globals)
+            std::memcpy(p, &settings, sizeof(settings));
+
+        FileSystem file{};
+        if (!file.OpenForWrite(desc.path) || !file.WriteBytes(out.data(), out.size()))
+        {
+            set_error("scene_io: failed to write scene snapshot");
+            return false;
         }
+        return true;
+    }
 
-            if (max_id >= queue_.next_object_id())
-                queue_.set_next_object_id(max_id + 1);
+    bool scene_io::load_snapshot(const scene_load_desc& desc)
+    {
+        std::vector<std::uint8_t> data;
+        {
+            FileSystem file{};
+            if (!file.OpenForRead(desc.path))
+            {
+                set_error("scene_io: failed to open scene snapshot");
+                return false;
+            }
+            data.resize((std::size_t)file.GetFileSize());
+            if (data.empty() || !file.ReadBytes(data.data(), data.size()))
+            {
+                set_error("scene_io: failed to read scene snapshot");
+                return false;
+            }
         }
 
-        read_globals(scene);
+        snapshot_header header{};
+        if (data.size() < sizeof(header))
+        {
+            set_error("scene_io: scene snapshot is truncated");
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        // Settings are stored raw, so a snapshot from a build with another layout is refused
+        if (header.magic != k_snapshot_magic || header.version != k_snapshot_version
+            || (header.globals_size != 0 && header.globals_size != sizeof(scene_post_processing_settings)))
+        {
+            set_error("scene_io: unsupported scene snapshot version");
+            return false;
+        }
+
+        const std::uint64_t objects_bytes = (std::uint64_t)header.object_count * sizeof(snapshot_object);
+        const std::uint64_t expected = sizeof(header) + objects_bytes + header.string_bytes + header.globals_size;
+        if (expected != data.size())
+        {
+            set_error("scene_io: scene snapshot is truncated");
+            return false;
+        }
+
+        const std::uint8_t* objects = data.data() + sizeof(header);
+        const char* strings = reinterpret_cast<const char*>(objects + objects_bytes);
+        const auto view = [&](std::uint32_t offset, std::uint32_t size, std::string& out)
+        {
+            if (offset > header.string_bytes || size > header.string_bytes - offset)
+                return false;
+            out.assign(strings + offset, size);
+            return true;
+        };
+
+        std::vector<scene_object_record> records;
+        records.reserve(header.object_count);
+        for (std::uint32_t i = 0; i < header.object_count; ++i)
+        {
+            snapshot_object o{};
+            std::memcpy(&o, objects + (std::size_t)i * sizeof(snapshot_object), sizeof(o));
+
+            scene_object_record record{};
+            if (!view(o.name_offset, o.name_size, record.name) || !view(o.model_offset, o.model_size, record.model))
+            {
+                set_error("scene_io: scene snapshot has a bad string reference");
+                return false;
+            }
+            if (record.model.empty())
+                continue;
+
+            record.id = o.id;
+            record.is_dynamic = o.is_dynamic != 0;
+            record.visible = o.visible != 0;
+            record.cull = (o.cull <= (std::uint8_t)cull_mode::front) ? (cull_mode)o.cull : cull_mode::none;
+            record.position = vec4(o.position[0], o.position[1], o.position[2], 1.f);
+            record.rotation = vec4(o.rotation[0], o.rotation[1], o.rotation[2], 0.f);
+            record.scale = vec4(o.scale[0], o.scale[1], o.scale[2], 0.f);
+            record.anim.enabled = o.anim_enabled != 0;
+            record.anim.paused = o.anim_paused != 0;
+            record.anim.index = (std::size_t)o.anim_index;
+            record.anim.playback_speed = o.playback_speed;
+            record.anim.time_offset = o.time_offset;
+            record.anim.anim_time = o.anim_time;
+            records.push_back(std::move(record));
+        }
+
+        if (desc.clear_existing)
+            clear_existing_editor_objects();
+        spawn_records(records);
+
+        if (header.globals_size != 0 && write_post_processing_callback_)
+        {
+            scene_post_processing_settings settings{};
+            std::memcpy(&settings, strings + header.string_bytes, sizeof(settings));
+            write_post_processing_callback_(settings);
+        }
 
         return true;
     }
 
+    bool scene_io::snapshot_up_to_date(const std::string& snapshot_path, const std::string& source_path)
+    {
+        std::error_code ec;
+        const auto snapshot_time = std::filesystem::last_write_time(snapshot_path, ec);
+        if (ec)
+            return false;
+        const auto source_time = std::filesystem::last_write_time(source_path, ec);
+        return ec || snapshot_time >= source_time;
+    }
+
     void scene_io::write_globals(JsonLoader& scene, const bool include_globals)
     {
         if (!include_globals)
@@ -248,9 +604,9 @@ namespace fox
         write_post_processing(globals);
     }
 
-    void scene_io::read_globals(const JsonLoader& scene)
+    void scene_io::read_globals(const JsonValue& scene)
     {
-        const JsonLoader& globals = scene["globals"];
+        const JsonValue globals = scene["globals"];
         if (!globals.IsValid())
             return;
 
@@ -316,7 +672,7 @@ namespace fox
         write_vec4_xy(advanced["god_rays_screen_pos"], settings.advanced_effects.god_rays_screen_pos);
     }
 
-    void scene_io::read_post_processing(const JsonLoader& globals)
+    void scene_io::read_post_processing(const JsonValue& globals)
     {
         if (!write_post_processing_callback_)
             return;
@@ -325,14 +681,14 @@ namespace fox
         if (read_post_processing_callback_)
             read_post_processing_callback_(settings);
 
-        const JsonLoader& post = globals["post_processing"];
+        const JsonValue post = globals["post_processing"];
         if (!post.IsValid())
         {
             write_post_processing_callback_(settings);
             return;
         }
 
-        const JsonLoader& basic = post["post_process"];
+        const JsonValue basic = post["post_process"];
         settings.post_process.enabled = basic["enabled"].AsBool(settings.post_process.enabled);
         settings.post_process.exposure_enabled = basic["exposure_enabled"].AsBool(settings.post_process.exposure_enabled);
         settings.post_process.exposure = basic["exposure"].AsFloat(settings.post_process.exposure);
@@ -344,7 +700,7 @@ namespace fox
         settings.post_process.vignette_strength = basic["vignette_strength"].AsFloat(settings.post_process.vignette_strength);
         settings.post_process.vignette_power = basic["vignette_power"].AsFloat(settings.post_process.vignette_power);
 
-        const JsonLoader& rainy = post["rainy_effect"];
+        const JsonValue rainy = post["rainy_effect"];
         settings.rainy_effect.enabled = rainy["enabled"].AsBool(settings.rainy_effect.enabled);
         settings.rainy_effect.intensity = rainy["intensity"].AsFloat(settings.rainy_effect.intensity);
         settings.rainy_effect.streak_density = rainy["streak_density"].AsFloat(settings.rainy_effect.streak_density);
@@ -357,7 +713,7 @@ namespace fox
         settings.rainy_effect.darken = rainy["darken"].AsFloat(settings.rainy_effect.darken);
         read_colour(rainy["tint"], settings.rainy_effect.tint);
 
-        const JsonLoader& advanced = post["advanced_effects"];
+        const JsonValue advanced = post["advanced_effects"];
         settings.advanced_effects.enabled = advanced["enabled"].AsBool(settings.advanced_effects.enabled);
         settings.advanced_effects.bloom_enabled = advanced["bloom_enabled"].AsBool(settings.advanced_effects.bloom_enabled);
         settings.advanced_effects.bloom_threshold = advanced["bloom_threshold"].AsFloat(settings.advanced_effects.bloom_threshold);
@@ -390,7 +746,7 @@ namespace fox
         node["b"] = static_cast<double>(value.b);
     }
 
-    void scene_io::read_colour(const JsonLoader& node, colour& value)
+    void scene_io::read_colour(const JsonValue& node, colour& value)
     {
         value.r = node["r"].AsFloat(value.r);
         value.g = node["g"].AsFloat(value.g);
@@ -403,7 +759,7 @@ namespace fox
         node["y"] = static_cast<double>(value.y);
     }
 
-    void scene_io::read_vec4_xy(const JsonLoader& node, vec4& value)
+    void scene_io::read_vec4_xy(const JsonValue& node, vec4& value)
     {
         value.x = node["x"].AsFloat(value.x);
         value.y = node["y"].AsFloat(value.y);
@@ -422,38 +778,41 @@ namespace fox
 
     void scene_io::clear_existing_editor_objects()
     {
-        std::vector<fecs::entity> to_destroy;
+        if (streamer_)
+            streamer_->clear();
+
+        fecs::command_buffer to_destroy(world_);
         world_.query<editor_tag>().each_entity([&](fecs::entity e, editor_tag&)
         {
-            to_destroy.push_back(e);
+            to_destroy.destroy_entity(e);
         });
-
-        for (const auto e : to_destroy)
-            world_.destroy_entity(e);
+        world_.flush(to_destroy);
     }
 
-    bool scene_io::parse_scene_object(const JsonLoader& node, scene_object_record& out) const
+    bool scene_io::parse_scene_object(const JsonValue& node, scene_object_record& out) const
     {
         out.id = parse_u64(node["id"], 0);
-        out.name = node["name"].GetValue();
-        out.model = node["asset"].GetValue();
+        out.name = node["name"].GetString();
+        out.model = node["asset"].GetString();
         out.visible = node["visible"].AsBool(true);
+        // Scenes written before per object culling have no "cull" and keep drawing both sides
+        out.cull = parse_cull_mode(node["cull"].GetView(), cull_mode::none);
         if (out.model.empty())
             return false;
 
-        const std::string type = node["type"].GetValue();
+        const std::string_view type = node["type"].GetView();
         out.is_dynamic = (type == "dynamic_mesh" || type == "dynamic");
 
-        const JsonLoader& transform = node["transform"];
-        const JsonLoader& pos = transform["position"];
-        const JsonLoader& rot = transform["rotation"];
-        const JsonLoader& scale = transform["scale"];
+        const JsonValue transform = node["transform"];
+        const JsonValue pos = transform["position"];
+        const JsonValue rot = transform["rotation"];
+        const JsonValue scale = transform["scale"];
 
         out.position = vec4(pos["x"].AsFloat(0.f), pos["y"].AsFloat(0.f), pos["z"].AsFloat(0.f), 1.f);
         out.rotation = vec4(rot["x"].AsFloat(0.f), rot["y"].AsFloat(0.f), rot["z"].AsFloat(0.f), 0.f);
         out.scale = vec4(scale["x"].AsFloat(1.f), scale["y"].AsFloat(1.f), scale["z"].AsFloat(1.f), 0.f);
 
-        const JsonLoader& dynamic = node["dynamic"];
+        const JsonValue dynamic = node["dynamic"];
         out.anim.enabled = dynamic["anim_enabled"].AsBool(true);
         out.anim.paused = dynamic["anim_paused"].AsBool(false);
         out.anim.index = static_cast<std::size_t>(dynamic["anim_index"].AsUInt(0));
@@ -464,18 +823,8 @@ namespace fox
         return true;
     }
 
-    std::uint64_t scene_io::parse_u64(const JsonLoader& node, std::uint64_t fallback) const
+    std::uint64_t scene_io::parse_u64(const JsonValue& node, std::uint64_t fallback) const
     {
-        if (!node.IsValid())
-            return fallback;
-
-        try
-        {
-            return static_cast<std::uint64_t>(std::stoull(node.GetValue()));
-        }
-        catch (...)
-        {
-            return fallback;
-        }
+        return node.AsUInt64(fallback);
     }
 }
@@ -0,0 +1,133 @@
+#include "optimized/frame_arena.h"
+#include "optimized/job_system.h"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+namespace fox
+{
+    namespace
+    {
+        inline std::byte* allocate_block(std::size_t size)
+        {
+            return static_cast<std::byte*>(::operator new(size, std::align_val_t{ frame_arena::kAlign }));
+        }
+
+        inline std::size_t align_up(std::size_t v, std::size_t align) noexcept
+        {
+            return (v + align - 1u) & ~(align - 1u);
+        }
+    }
+
+    void* frame_arena::allocate_bytes(std::size_t size, std::size_t align)
+    {
+        assert(align <= kAlign && (align & (align - 1u)) == 0 && "frame_arena: bad alignment");
+
+        if (!m_blocks.empty())
+        {
+            const std::size_t offset = align_up(m_used, align);
+            if (offset + size <= m_blocks[m_current].size)
+            {
+                m_used = offset + size;
+                return m_blocks[m_current].data + offset;
+            }
+        }
+
+        // Next block kept from an earlier spill, or a new one after the current
+        const std::size_t next = m_blocks.empty() ? 0u : m_current + 1u;
+        if (next >= m_blocks.size() || m_blocks[next].size < size)
+        {
+            const std::size_t prev = m_blocks.empty() ? 0u : m_blocks[m_current].size;
+            const std::size_t bytes = align_up((std::max)({ kMinBlockBytes, size, prev }), kAlign);
+            m_blocks.insert(m_blocks.begin() + (std::ptrdiff_t)next, block{ allocate_block(bytes), bytes });
+            ++m_heap_allocations;
+        }
+
+        m_current = next;
+        m_used = size;
+        m_spilled |= (m_current > 0u);
+        return m_blocks[m_current].data;
+    }
+
+    void frame_arena::rewind(const marker& m) noexcept
+    {
+        m_current = m.block;
+        m_used = m.used;
+    }
+
+    void frame_arena::reset()
+    {
+        if (m_spilled)
+        {
+            const std::size_t total = capacity();
+            release();
+            m_blocks.push_back({ allocate_block(total), total });
+            ++m_heap_allocations;
+        }
+
+        m_current = 0;
+        m_used = 0;
+        m_spilled = false;
+    }
+
+    std::size_t frame_arena::capacity() const noexcept
+    {
+        std::size_t total = 0;
+        for (const block& b : m_blocks)
+            total += b.size;
+        return total;
+    }
+
+    void frame_arena::release() noexcept
+    {
+        for (const block& b : m_blocks)
+            ::operator delete(b.data, std::align_val_t{ kAlign });
+        m_blocks.clear();
+        m_current = 0;
+        m_used = 0;
+    }
+
+    frame_arenas::frame_arenas()
+        : m_slot_count(job_system::instance().slot_count())
+        , m_arenas(std::make_unique<frame_arena[]>(m_slot_count + 1u))
+    {
+    }
+
+    void frame_arenas::reset()
+    {
+        for (std::uint32_t i = 0; i <= m_slot_count; ++i)
+            m_arenas[i].reset();
+    }
+
+    std::uint64_t frame_arenas::heap_allocations() const noexcept
+    {
+        std::uint64_t total = 0;
+        for (std::uint32_t i = 0; i <= m_slot_count; ++i)
+            total += m_arenas[i].heap_allocations();
+        return total;
+    }
+
+    std::size_t frame_arenas::capacity() const noexcept
+    {
+        std::size_t total = 0;
+        for (std::uint32_t i = 0; i <= m_slot_count; ++i)
+            total += m_arenas[i].capacity();
+        return total;
+    }
+
+    scratch_scope::scratch_scope(frame_arenas& arenas)
+    {
+        const int slot = job_system::instance().current_slot();
+        if (slot >= 0 && (std::uint32_t)slot < arenas.m_slot_count)
+        {
+            m_arena = &arenas.m_arenas[slot];
+        }
+        else
+        {
+            m_lock = std::unique_lock<std::recursive_mutex>(arenas.m_shared_mtx);
+            m_arena = &arenas.m_arenas[arenas.m_slot_count];
+        }
+        m_mark = m_arena->mark();
+    }
+}
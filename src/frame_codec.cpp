@@ -0,0 +1,262 @@
+#include "optimized/frame_codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr std::size_t kMinMatch   = 4;
+    constexpr std::size_t kLastLiterals = 5;  // the stream always ends on a literal run
+    constexpr std::size_t kMatchLimit = 12;   // no match starts this close to the end
+    constexpr std::size_t kMaxOffset  = 65535;
+    constexpr int kHashBits = 14;
+
+    enum : std::uint8_t { kTileSame = 0, kTileDelta = 1 };
+
+    inline std::uint32_t read32(const std::uint8_t* p) noexcept
+    {
+        std::uint32_t v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+
+    inline std::uint32_t hash4(std::uint32_t v) noexcept
+    {
+        return (v * 2654435761u) >> (32 - kHashBits);
+    }
+
+    inline std::uint8_t* write_length(std::uint8_t* op, std::size_t len) noexcept
+    {
+        for (; len >= 255; len -= 255)
+            *op++ = 255;
+        *op++ = (std::uint8_t)len;
+        return op;
+    }
+
+    inline std::uint8_t* write_sequence(std::uint8_t* op, const std::uint8_t* lit, std::size_t lit_len,
+                                        std::size_t offset, std::size_t match_len) noexcept
+    {
+        std::uint8_t* token = op++;
+        *token = (std::uint8_t)((std::min)(lit_len, (std::size_t)15) << 4);
+        if (lit_len >= 15)
+            op = write_length(op, lit_len - 15);
+        std::memcpy(op, lit, lit_len);
+        op += lit_len;
+
+        if (match_len == 0)
+            return op;
+
+        *op++ = (std::uint8_t)(offset & 0xFFu);
+        *op++ = (std::uint8_t)(offset >> 8);
+        const std::size_t m = match_len - kMinMatch;
+        *token |= (std::uint8_t)(std::min)(m, (std::size_t)15);
+        if (m >= 15)
+            op = write_length(op, m - 15);
+        return op;
+    }
+
+    inline bool read_length(const std::uint8_t* src, std::size_t n, std::size_t& ip, std::size_t& len) noexcept
+    {
+        std::uint8_t b = 0;
+        do
+        {
+            if (ip >= n) return false;
+            b = src[ip++];
+            len += b;
+        } while (b == 255);
+        return true;
+    }
+}
+
+namespace fox
+{
+    std::size_t lz_compress(const std::uint8_t* src, std::size_t n, std::uint8_t* dst) noexcept
+    {
+        std::uint8_t* op = dst;
+        std::size_t anchor = 0;
+
+        if (n > kMatchLimit)
+        {
+            std::vector<std::uint32_t> table((std::size_t)1 << kHashBits, 0xFFFFFFFFu);
+            const std::size_t match_end = n - kLastLiterals;
+            std::size_t ip = 0;
+
+            while (ip + kMatchLimit <= n)
+            {
+                const std::uint32_t v = read32(src + ip);
+                const std::uint32_t h = hash4(v);
+                const std::uint32_t ref = table[h];
+                table[h] = (std::uint32_t)ip;
+
+                if (ref == 0xFFFFFFFFu || ip - ref > kMaxOffset || read32(src + ref) != v)
+                {
+                    // Incompressible stretches are skipped through faster the longer they run
+                    ip += 1 + ((ip - anchor) >> 6);
+                    continue;
+                }
+
+                std::size_t len = kMinMatch;
+                while (ip + len < match_end && src[ref + len] == src[ip + len])
+                    ++len;
+
+                op = write_sequence(op, src + anchor, ip - anchor, ip - ref, len);
+                ip += len;
+                anchor = ip;
+            }
+        }
+
+        op = write_sequence(op, src + anchor, n - anchor, 0, 0);
+        return (std::size_t)(op - dst);
+    }
+
+    bool lz_decompress(const std::uint8_t* src, std::size_t n, std::uint8_t* dst, std::size_t dst_n) noexcept
+    {
+        std::size_t ip = 0;
+        std::size_t op = 0;
+
+        while (ip < n)
+        {
+            const std::uint8_t token = src[ip++];
+
+            std::size_t lit = token >> 4;
+            if (lit == 15 && !read_length(src, n, ip, lit)) return false;
+            if (lit > n - ip || lit > dst_n - op) return false;
+            std::memcpy(dst + op, src + ip, lit);
+            ip += lit;
+            op += lit;
+
+            if (ip == n)
+                break;
+
+            if (n - ip < 2) return false;
+            const std::size_t offset = (std::size_t)src[ip] | ((std::size_t)src[ip + 1] << 8);
+            ip += 2;
+            if (offset == 0 || offset > op) return false;
+
+            std::size_t len = token & 15u;
+            if (len == 15 && !read_length(src, n, ip, len)) return false;
+            len += kMinMatch;
+            if (len > dst_n - op) return false;
+
+            // Overlapping matches replicate the last `offset` bytes, so copy forwards
+            std::uint8_t* d = dst + op;
+            const std::uint8_t* s = d - offset;
+            if (offset >= len)
+                std::memcpy(d, s, len);
+            else
+                for (std::size_t i = 0; i < len; ++i)
+                    d[i] = s[i];
+            op += len;
+        }
+
+        return op == dst_n;
+    }
+
+    std::uint32_t encode_frame(const std::uint32_t* cur, const std::uint32_t* prev,
+                               std::uint32_t w, std::uint32_t h, std::uint32_t pitch_pixels,
+                               std::vector<std::uint8_t>& scratch, std::vector<std::uint8_t>& out)
+    {
+        const std::uint32_t tx_count = (w + kFrameCodecTile - 1) / kFrameCodecTile;
+        const std::uint32_t ty_count = (h + kFrameCodecTile - 1) / kFrameCodecTile;
+        const std::size_t tiles = (std::size_t)tx_count * ty_count;
+
+        scratch.resize(tiles + (std::size_t)w * h * 4u);
+        std::uint8_t* modes = scratch.data();
+        std::uint8_t* body = modes + tiles;
+
+        for (std::uint32_t ty = 0; ty < ty_count; ++ty)
+        {
+            const std::uint32_t y0 = ty * kFrameCodecTile;
+            const std::uint32_t y1 = (std::min)(y0 + kFrameCodecTile, h);
+
+            for (std::uint32_t tx = 0; tx < tx_count; ++tx)
+            {
+                const std::uint32_t x0 = tx * kFrameCodecTile;
+                const std::uint32_t tw = (std::min)(x0 + kFrameCodecTile, w) - x0;
+                const std::size_t row_bytes = (std::size_t)tw * 4u;
+
+                bool same = prev != nullptr;
+                for (std::uint32_t y = y0; same && y < y1; ++y)
+                {
+                    const std::size_t o = (std::size_t)y * pitch_pixels + x0;
+                    same = std::memcmp(cur + o, prev + o, row_bytes) == 0;
+                }
+
+                *modes++ = same ? kTileSame : kTileDelta;
+                if (same) continue;
+
+                for (std::uint32_t y = y0; y < y1; ++y)
+                {
+                    const std::size_t o = (std::size_t)y * pitch_pixels + x0;
+                    std::uint32_t row[kFrameCodecTile];
+                    for (std::uint32_t x = 0; x < tw; ++x)
+                        row[x] = prev ? (cur[o + x] ^ prev[o + x]) : cur[o + x];
+                    std::memcpy(body, row, row_bytes);
+                    body += row_bytes;
+                }
+            }
+        }
+
+        const std::size_t raw = (std::size_t)(body - scratch.data());
+        out.resize(lz_compress_bound(raw));
+        out.resize(lz_compress(scratch.data(), raw, out.data()));
+        return (std::uint32_t)raw;
+    }
+
+    bool decode_frame(const std::uint8_t* packed, std::size_t packed_bytes, std::uint32_t raw_bytes,
+                      const std::uint32_t* prev, std::uint32_t* dst,
+                      std::uint32_t w, std::uint32_t h, std::uint32_t pitch_pixels,
+                      std::vector<std::uint8_t>& scratch)
+    {
+        const std::uint32_t tx_count = (w + kFrameCodecTile - 1) / kFrameCodecTile;
+        const std::uint32_t ty_count = (h + kFrameCodecTile - 1) / kFrameCodecTile;
+        const std::size_t tiles = (std::size_t)tx_count * ty_count;
+
+        if (raw_bytes < tiles) return false;
+        scratch.resize(raw_bytes);
+        if (!lz_decompress(packed, packed_bytes, scratch.data(), raw_bytes)) return false;
+
+        const std::uint8_t* modes = scratch.data();
+        const std::uint8_t* body = modes + tiles;
+        const std::uint8_t* end = scratch.data() + raw_bytes;
+
+        for (std::uint32_t ty = 0; ty < ty_count; ++ty)
+        {
+            const std::uint32_t y0 = ty * kFrameCodecTile;
+            const std::uint32_t y1 = (std::min)(y0 + kFrameCodecTile, h);
+
+            for (std::uint32_t tx = 0; tx < tx_count; ++tx)
+            {
+                const std::uint32_t x0 = tx * kFrameCodecTile;
+                const std::uint32_t tw = (std::min)(x0 + kFrameCodecTile, w) - x0;
+                const std::size_t row_bytes = (std::size_t)tw * 4u;
+                const std::uint8_t mode = *modes++;
+
+                if (mode == kTileSame)
+                {
+                    if (!prev) return false;
+                    for (std::uint32_t y = y0; y < y1; ++y)
+                    {
+                        const std::size_t o = (std::size_t)y * pitch_pixels + x0;
+                        std::memcpy(dst + o, prev + o, row_bytes);
+                    }
+                    continue;
+                }
+
+                if (mode != kTileDelta || (std::size_t)(end - body) < row_bytes * (y1 - y0)) return false;
+
+                for (std::uint32_t y = y0; y < y1; ++y)
+                {
+                    const std::size_t o = (std::size_t)y * pitch_pixels + x0;
+                    std::uint32_t row[kFrameCodecTile];
+                    std::memcpy(row, body, row_bytes);
+                    body += row_bytes;
+                    for (std::uint32_t x = 0; x < tw; ++x)
+                        dst[o + x] = prev ? (row[x] ^ prev[o + x]) : row[x];
+                }
+            }
+        }
+
+        return body == end;
+    }
+}
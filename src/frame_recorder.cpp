@@ -0,0 +1,588 @@
+#include "optimized/frame_recorder.h"
+#include "optimized/frame_codec.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <windows.h>
+
+#include "file_system.h"
+#include "optimized/memory_stats.h"
+
+namespace
+{
+    constexpr std::uint32_t kMagic       = 0x43525846u; // "FXRC"
+    constexpr std::uint32_t kVersion     = 1;
+    constexpr std::uint32_t kKeyInterval = 60;  // frames between key frames, bounds a seek
+    constexpr std::size_t   kQueueDepth  = 4;   // frames the writer may fall behind by
+    constexpr std::uint32_t kReadAhead   = 4;   // decoded frames kept by the player
+    constexpr std::uint32_t kKeyFrame    = 1u;
+
+    struct file_header
+    {
+        std::uint32_t magic = kMagic;
+        std::uint32_t version = kVersion;
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        std::uint32_t key_interval = kKeyInterval;
+        std::uint32_t reserved = 0;
+    };
+
+    // Precedes every frame's packed bytes; a truncated tail (crash mid capture) is ignored on open
+    struct frame_header
+    {
+        std::uint32_t packed_bytes = 0;
+        std::uint32_t raw_bytes = 0;
+        std::uint32_t flags = 0;
+    };
+}
+
+#pragma region frame_queue
+
+namespace
+{
+    // Bounded hand off of frame copies from the submitting thread to a writer thread. push() waits
+    // while kQueueDepth frames are pending; buffers cycle through a pool instead of reallocating.
+    class frame_queue
+    {
+    public:
+        void reset() noexcept
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            closing_ = false;
+            pushed_ = 0;
+        }
+
+        void push(const std::uint32_t* color, std::uint32_t pitch_pixels, std::uint32_t w, std::uint32_t h) noexcept
+        {
+            std::vector<std::uint32_t> buf;
+            {
+                std::unique_lock<std::mutex> lk(mtx_);
+                cv_space_.wait(lk, [&] { return queue_.size() < kQueueDepth; });
+                if (!pool_.empty())
+                {
+                    buf = std::move(pool_.back());
+                    pool_.pop_back();
+                }
+            }
+
+            const std::size_t had = buf.capacity();
+            buf.resize((std::size_t)w * h);
+            const std::size_t grown = (buf.capacity() - had) * sizeof(std::uint32_t);
+            fox::mem_track_alloc(fox::mem_tag::capture, grown);
+            for (std::uint32_t y = 0; y < h; ++y)
+                std::memcpy(buf.data() + (std::size_t)y * w, color + (std::size_t)y * pitch_pixels, (std::size_t)w * 4u);
+
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                tracked_bytes_ += grown;
+                queue_.push_back(std::move(buf));
+                ++pushed_;
+            }
+            cv_work_.notify_one();
+        }
+
+        // False once closed and drained
+        [[nodiscard]] bool pop(std::vector<std::uint32_t>& frame) noexcept
+        {
+            {
+                std::unique_lock<std::mutex> lk(mtx_);
+                cv_work_.wait(lk, [&] { return closing_ || !queue_.empty(); });
+                if (queue_.empty())
+                    return false;
+                frame = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            cv_space_.notify_one();
+            return true;
+        }
+
+        void recycle(std::vector<std::uint32_t>&& frame) noexcept
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            pool_.push_back(std::move(frame));
+        }
+
+        void close() noexcept
+        {
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                closing_ = true;
+            }
+            cv_work_.notify_all();
+        }
+
+        // Once the writer has exited: every buffer push grew is in the pool or went with the writer
+        void release_pool() noexcept
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            pool_.clear();
+            pool_.shrink_to_fit();
+            fox::mem_track_free(fox::mem_tag::capture, tracked_bytes_);
+            tracked_bytes_ = 0;
+        }
+
+        [[nodiscard]] std::uint32_t pushed() const noexcept
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            return pushed_;
+        }
+
+    private:
+        mutable std::mutex mtx_;
+        std::condition_variable cv_work_;
+        std::condition_variable cv_space_;
+        std::deque<std::vector<std::uint32_t>> queue_;
+        std::vector<std::vector<std::uint32_t>> pool_;
+        bool closing_ = false;
+        std::uint32_t pushed_ = 0;
+        std::size_t tracked_bytes_ = 0; // frame buffers allocated, counted under mem_tag::capture
+    };
+}
+
+#pragma endregion
+
+#pragma region frame_recorder
+
+class fox::frame_recorder::impl
+{
+public:
+    FileSystem file;
+    std::thread writer;
+    frame_queue queue;
+    std::uint32_t w = 0, h = 0;
+    std::string path;
+    std::atomic<bool> failed{ false };
+
+    void writer_loop() noexcept
+    {
+        std::vector<std::uint32_t> prev, frame;
+        std::vector<std::uint8_t> scratch, packed;
+
+        for (std::uint32_t index = 0; queue.pop(frame); ++index)
+        {
+            // After a failed write the file ends at the last whole frame; what is still queued drains unwritten
+            if (failed.load(std::memory_order_relaxed))
+            {
+                queue.recycle(std::move(frame));
+                continue;
+            }
+
+            const bool key = prev.empty() || index % kKeyInterval == 0;
+            const std::uint32_t raw = fox::encode_frame(frame.data(), key ? nullptr : prev.data(), w, h, w, scratch, packed);
+
+            frame_header fh{};
+            fh.packed_bytes = (std::uint32_t)packed.size();
+            fh.raw_bytes = raw;
+            fh.flags = key ? kKeyFrame : 0u;
+
+            if (!file.WriteBytes(&fh, sizeof(fh)) || !file.WriteBytes(packed.data(), packed.size()))
+            {
+                std::fprintf(stderr, "frame_recorder: writing %s failed at frame %u, recording stopped\n", path.c_str(), index);
+                failed.store(true, std::memory_order_relaxed);
+            }
+
+            prev.swap(frame);
+            queue.recycle(std::move(frame));
+        }
+    }
+};
+
+fox::frame_recorder::frame_recorder() : p_(std::make_unique<impl>()) {}
+fox::frame_recorder::~frame_recorder() { close(); }
+
+bool fox::frame_recorder::open(const char* path, std::uint32_t w, std::uint32_t h) noexcept
+{
+    close();
+    auto& s = *p_;
+    s.queue.reset();
+    s.failed.store(false, std::memory_order_relaxed);
+    if (!path || !w || !h) return false;
+
+    if (!s.file.OpenForWrite(path)) return false;
+
+    file_header hdr{};
+    hdr.width = w;
+    hdr.height = h;
+    if (!s.file.WriteBytes(&hdr, sizeof(hdr)))
+    {
+        s.file.Close();
+        return false;
+    }
+
+    s.w = w;
+    s.h = h;
+    s.path = path;
+    s.writer = std::thread([&s] { s.writer_loop(); });
+    return true;
+}
+
+void fox::frame_recorder::submit(const std::uint32_t* color, std::uint32_t pitch_pixels) noexcept
+{
+    auto& s = *p_;
+    if (!color || !s.writer.joinable() || s.failed.load(std::memory_order_relaxed)) return;
+    s.queue.push(color, pitch_pixels, s.w, s.h);
+}
+
+bool fox::frame_recorder::close() noexcept
+{
+    if (!p_) return true;
+    auto& s = *p_;
+    if (!s.writer.joinable()) return !s.failed.load(std::memory_order_relaxed);
+
+    s.queue.close();
+    s.writer.join();
+    s.file.Close();
+    s.queue.release_pool();
+    return !s.failed.load(std::memory_order_relaxed);
+}
+
+bool fox::frame_recorder::is_open() const noexcept { return p_ && p_->writer.joinable(); }
+bool fox::frame_recorder::failed() const noexcept { return p_ && p_->failed.load(std::memory_order_relaxed); }
+std::uint32_t fox::frame_recorder::frame_count() const noexcept { return p_ ? p_->queue.pushed() : 0u; }
+
+#pragma endregion
+
+#pragma region image_sequence_writer
+
+class fox::image_sequence_writer::impl
+{
+public:
+    std::string prefix;
+    std::thread writer;
+    frame_queue queue;
+    std::uint32_t w = 0, h = 0;
+    std::atomic<std::uint32_t> failed{ 0u };
+
+    void writer_loop() noexcept
+    {
+        std::vector<std::uint32_t> frame;
+        std::vector<std::uint8_t> bytes;
+        char name[32];
+
+        for (std::uint32_t index = 0; queue.pop(frame); ++index)
+        {
+            // Uncompressed 32 bit TGA, top left origin, BGRA
+            bytes.resize(18u + (std::size_t)w * h * 4u);
+            std::uint8_t* hdr = bytes.data();
+            std::memset(hdr, 0, 18);
+            hdr[2]  = 2;
+            hdr[12] = (std::uint8_t)(w & 0xFFu);
+            hdr[13] = (std::uint8_t)(w >> 8);
+            hdr[14] = (std::uint8_t)(h & 0xFFu);
+            hdr[15] = (std::uint8_t)(h >> 8);
+            hdr[16] = 32;
+            hdr[17] = 0x28;
+
+            std::uint32_t* px = reinterpret_cast<std::uint32_t*>(bytes.data() + 18);
+            for (std::size_t i = 0, n = (std::size_t)w * h; i < n; ++i)
+            {
+                const std::uint32_t c = frame[i];
+                std::uint32_t bgra = (c & 0xFF00FF00u) | ((c >> 16) & 0xFFu) | ((c & 0xFFu) << 16);
+                std::memcpy(px + i, &bgra, 4);
+            }
+
+            std::snprintf(name, sizeof(name), "_%06u.tga", index);
+            FileSystem file;
+            if (!file.OpenForWrite(prefix + name) || !file.WriteBytes(bytes.data(), bytes.size()))
+            {
+                if (failed.fetch_add(1u, std::memory_order_relaxed) == 0u)
+                    std::fprintf(stderr, "image_sequence_writer: writing %s%s failed\n", prefix.c_str(), name);
+            }
+
+            queue.recycle(std::move(frame));
+        }
+    }
+};
+
+fox::image_sequence_writer::image_sequence_writer() : p_(std::make_unique<impl>()) {}
+fox::image_sequence_writer::~image_sequence_writer() { close(); }
+
+bool fox::image_sequence_writer::open(const char* prefix, std::uint32_t w, std::uint32_t h) noexcept
+{
+    close();
+    auto& s = *p_;
+    s.queue.reset();
+    s.failed.store(0u, std::memory_order_relaxed);
+    if (!prefix || !*prefix || !w || !h || w > 0xFFFFu || h > 0xFFFFu) return false;
+
+    s.prefix = prefix;
+    s.w = w;
+    s.h = h;
+    s.writer = std::thread([&s] { s.writer_loop(); });
+    return true;
+}
+
+void fox::image_sequence_writer::submit(const std::uint32_t* color, std::uint32_t pitch_pixels) noexcept
+{
+    auto& s = *p_;
+    if (!color || !s.writer.joinable()) return;
+    s.queue.push(color, pitch_pixels, s.w, s.h);
+}
+
+std::uint32_t fox::image_sequence_writer::close() noexcept
+{
+    if (!p_) return 0u;
+    auto& s = *p_;
+    if (!s.writer.joinable()) return s.failed.load(std::memory_order_relaxed);
+
+    s.queue.close();
+    s.writer.join();
+    s.queue.release_pool();
+    return s.failed.load(std::memory_order_relaxed);
+}
+
+bool fox::image_sequence_writer::is_open() const noexcept { return p_ && p_->writer.joinable(); }
+std::uint32_t fox::image_sequence_writer::frame_count() const noexcept { return p_ ? p_->queue.pushed() : 0u; }
+std::uint32_t fox::image_sequence_writer::failed_count() const noexcept { return p_ ? p_->failed.load(std::memory_order_relaxed) : 0u; }
+
+#pragma endregion
+
+#pragma region frame_player
+
+class fox::frame_player::impl
+{
+public:
+    FileSystem file;
+    const std::uint8_t* view = nullptr;
+
+    struct frame_entry
+    {
+        std::uint64_t offset = 0; // of the packed bytes
+        std::uint32_t packed_bytes = 0;
+        std::uint32_t raw_bytes = 0;
+        bool          key = false;
+    };
+
+    file_header hdr{};
+    std::vector<frame_entry> frames;
+
+    // Frame i decodes into ring[i % kReadAhead], next to frame i - 1 it is coded against
+    std::vector<std::uint32_t> ring[kReadAhead];
+    std::int64_t ring_frame[kReadAhead]{};
+
+    std::thread decoder;
+    std::mutex mtx;
+    std::condition_variable cv_decode;
+    std::condition_variable cv_ready;
+    bool stop = false;
+
+    std::uint32_t next = 0;      // frame the decoder works on next
+    std::uint32_t want = 0;      // frame last asked for, read-ahead runs from here
+    std::uint32_t seek_gen = 0;  // bumped when decoding restarts elsewhere
+
+    bool map(const char* path) noexcept
+    {
+        if (!file.MapForRead(path)) return false;
+        const std::uint64_t end = file.GetFileSize();
+        if (end < sizeof(file_header)) return false;
+        view = file.GetMappedData();
+
+        std::memcpy(&hdr, view, sizeof(hdr));
+        if (hdr.magic != kMagic || hdr.version != kVersion || !hdr.width || !hdr.height) return false;
+
+        std::uint64_t off = sizeof(file_header);
+        while (end - off >= sizeof(frame_header))
+        {
+            frame_header fh{};
+            std::memcpy(&fh, view + off, sizeof(fh));
+            off += sizeof(fh);
+            if (fh.packed_bytes > end - off) break;
+
+            frame_entry e{};
+            e.offset = off;
+            e.packed_bytes = fh.packed_bytes;
+            e.raw_bytes = fh.raw_bytes;
+            e.key = (fh.flags & kKeyFrame) != 0;
+            if (frames.empty() && !e.key) return false;
+            frames.push_back(e);
+            off += fh.packed_bytes;
+        }
+        return !frames.empty();
+    }
+
+    void unmap() noexcept
+    {
+        file.Close();
+        view = nullptr;
+        frames.clear();
+    }
+
+    [[nodiscard]] std::uint32_t key_at_or_before(std::uint32_t index) const noexcept
+    {
+        while (index > 0 && !frames[index].key)
+            --index;
+        return index;
+    }
+
+    [[nodiscard]] bool holds_locked(std::uint32_t index) const noexcept
+    {
+        return ring_frame[index % kReadAhead] == (std::int64_t)index;
+    }
+
+    // Fault the packed bytes of the frames after `index` in while the current one decodes
+    void prefetch_after(std::uint32_t index) const noexcept
+    {
+        WIN32_MEMORY_RANGE_ENTRY ranges[kReadAhead];
+        ULONG_PTR count = 0;
+        for (std::uint32_t i = index + 1; i < (std::uint32_t)frames.size() && i <= index + kReadAhead; ++i)
+        {
+            ranges[count].VirtualAddress = (PVOID)(view + frames[i].offset);
+            ranges[count].NumberOfBytes = frames[i].packed_bytes;
+            ++count;
+        }
+        if (count)
+            PrefetchVirtualMemory(GetCurrentProcess(), count, ranges, 0);
+    }
+
+    void decoder_loop() noexcept
+    {
+        std::vector<std::uint8_t> scratch;
+
+        for (;;)
+        {
+            std::uint32_t index = 0;
+            std::uint32_t gen = 0;
+            const std::uint32_t* prev = nullptr;
+            std::uint32_t* dst = nullptr;
+
+            {
+                std::unique_lock<std::mutex> lk(mtx);
+                cv_decode.wait(lk, [&] {
+                    return stop || (next < (std::uint32_t)frames.size() && next < want + kReadAhead);
+                });
+                if (stop) return;
+
+                index = next;
+                gen = seek_gen;
+                if (!frames[index].key)
+                {
+                    const std::uint32_t p = (index - 1) % kReadAhead;
+                    if (ring_frame[p] != (std::int64_t)index - 1)
+                    {
+                        next = key_at_or_before(index);
+                        continue;
+                    }
+                    prev = ring[p].data();
+                }
+                ring_frame[index % kReadAhead] = -1;
+                dst = ring[index % kReadAhead].data();
+            }
+
+            prefetch_after(index);
+
+            const frame_entry& e = frames[index];
+            if (!decode_frame(view + e.offset, e.packed_bytes, e.raw_bytes, prev, dst,
+                              hdr.width, hdr.height, hdr.width, scratch))
+            {
+                // Keep playing past a damaged frame rather than stalling the consumer
+                std::fill_n(dst, (std::size_t)hdr.width * hdr.height, 0u);
+            }
+
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                if (gen != seek_gen) continue;
+                ring_frame[index % kReadAhead] = index;
+                next = index + 1;
+            }
+            cv_ready.notify_all();
+        }
+    }
+};
+
+fox::frame_player::frame_player() : p_(std::make_unique<impl>()) {}
+fox::frame_player::~frame_player() { close(); }
+
+bool fox::frame_player::open(const char* path) noexcept
+{
+    close();
+    if (!path) return false;
+
+    auto& s = *p_;
+    if (!s.map(path))
+    {
+        s.unmap();
+        return false;
+    }
+
+    for (std::uint32_t i = 0; i < kReadAhead; ++i)
+    {
+        s.ring[i].assign((std::size_t)s.hdr.width * s.hdr.height, 0u);
+        fox::mem_track_alloc(fox::mem_tag::capture, s.ring[i].capacity() * sizeof(std::uint32_t));
+        s.ring_frame[i] = -1;
+    }
+    s.next = 0;
+    s.want = 0;
+    s.seek_gen = 0;
+    s.stop = false;
+    s.decoder = std::thread([&s] { s.decoder_loop(); });
+    return true;
+}
+
+void fox::frame_player::close() noexcept
+{
+    if (!p_) return;
+    auto& s = *p_;
+
+    if (s.decoder.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lk(s.mtx);
+            s.stop = true;
+        }
+        s.cv_decode.notify_all();
+        s.cv_ready.notify_all();
+        s.decoder.join();
+    }
+
+    s.unmap();
+    for (auto& r : s.ring)
+    {
+        fox::mem_track_free(fox::mem_tag::capture, r.capacity() * sizeof(std::uint32_t));
+        r.clear();
+        r.shrink_to_fit();
+    }
+}
+
+bool fox::frame_player::is_open() const noexcept { return p_ && p_->view != nullptr; }
+std::uint32_t fox::frame_player::frame_count() const noexcept { return p_ ? (std::uint32_t)p_->frames.size() : 0u; }
+std::uint32_t fox::frame_player::width() const noexcept  { return p_ && p_->view ? p_->hdr.width : 0u; }
+std::uint32_t fox::frame_player::height() const noexcept { return p_ && p_->view ? p_->hdr.height : 0u; }
+
+const std::uint32_t* fox::frame_player::acquire(std::uint32_t index) noexcept
+{
+    if (!is_open()) return nullptr;
+    auto& s = *p_;
+
+    std::unique_lock<std::mutex> lk(s.mtx);
+    if (index >= (std::uint32_t)s.frames.size()) return nullptr;
+
+    if (!s.holds_locked(index))
+    {
+        // Decoding on from where the decoder is only pays off when no key frame lies in between
+        const std::uint32_t key = s.key_at_or_before(index);
+        if (index < s.next || key > s.next)
+        {
+            for (auto& f : s.ring_frame) f = -1;
+            s.next = key;
+            ++s.seek_gen;
+        }
+    }
+
+    s.want = index;
+    s.cv_decode.notify_one();
+    s.cv_ready.wait(lk, [&] { return s.stop || s.holds_locked(index); });
+    if (s.stop) return nullptr;
+
+    return s.ring[index % kReadAhead].data();
+}
+
+#pragma endregion
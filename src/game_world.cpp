@@ -6,6 +6,11 @@
 
 namespace
 {
+    // Longest sleep between idle frames; the UI still repaints at this rate with no input
+    constexpr std::uint32_t kIdleFrameMs = 16;
+    // Lights flickered per job_system task
+    constexpr std::size_t kLanternsPerTask = 256;
+
     inline static Light make_default_light() noexcept
     {
         return {
@@ -31,7 +36,7 @@ namespace fox
 {
     game_world::game_world(const game_world_config& config)
         : config_(config)
-        , renderer_(config.w, config.h, config.title)
+        , renderer_(config.w, config.h, config.title, config.low_latency)
     {}
 
     void game_world::init()
@@ -40,15 +45,39 @@ namespace fox
             return;
 
         renderer_.set_offline_rendering(config_.offline);
+        if (config_.offline)
+        {
+            renderer_.set_offline_resolution(config_.w, config_.h);
+            const std::uint32_t w = renderer_.offline_width();
+            const std::uint32_t h = renderer_.offline_height();
+            if (config_.offline_output && !offline_sink_.frames.open(config_.offline_output, w, h))
+                std::printf("Cannot write offline frames to %s; rendering without output.\n", config_.offline_output);
+            if (config_.offline_gif && !offline_sink_.gif.open(config_.offline_gif, w, h))
+                std::printf("Cannot write offline frames to %s; rendering without output.\n", config_.offline_gif);
+        }
+        // Editing mostly touches a few objects at a time, so most tiles carry over between frames
+        renderer_.incremental_redraw = true;
 
         default_light_ = make_default_light();
         light_dir_.normalise();
 
+        tex_cache_.set_residency_format(config_.compressed_textures ? texture_format::bc1 : texture_format::rgba8);
+
         fecs::world& world = renderer_.world;
         render_queue::register_components(world);
 
         render_queue_ = std::make_unique<render_queue>(world, static_mesh_cache_, dynamic_mesh_cache_, &tex_cache_, normalize_size_);
+        // A replay loads synchronously, so meshes turn up on the same frame every run
+        render_queue_->set_async_loading(!config_.replay_input);
+        render_queue_->set_quantized_meshes(config_.quantized_meshes);
+        world_streamer_ = std::make_unique<world_streamer>(world, *render_queue_);
+        world_streaming_settings streaming{};
+        streaming.enabled = config_.world_streaming;
+        world_streamer_->set_settings(streaming);
+        // A pipelined frame may still be reading the vertices of a mesh the streamer frees
+        world_streamer_->set_release_fence([this]() { renderer_.wait_frame_in_flight(); });
         scene_io_ = std::make_unique<scene_io>(world, *render_queue_);
+        scene_io_->set_streamer(world_streamer_.get());
         scene_io_->set_post_processing_callbacks(
             [this](scene_io::scene_post_processing_settings& settings)
             {
@@ -59,8 +88,13 @@ namespace fox
                 apply_post_processing_settings(settings);
             });
 
-        const scene_load_desc startup_scene_desc{ scene_paths::default_scene_path(), true };
-        if (!scene_io_->load_scene(startup_scene_desc))
+        // The snapshot skips all text parsing; a hand edited JSON newer than it wins
+        bool loaded_scene = false;
+        if (scene_io::snapshot_up_to_date(scene_paths::default_snapshot_path(), scene_paths::default_scene_path()))
+            loaded_scene = scene_io_->load_scene(scene_load_desc{ scene_paths::default_snapshot_path(), true });
+        if (!loaded_scene)
+            loaded_scene = scene_io_->load_scene(scene_load_desc{ scene_paths::default_scene_path(), true });
+        if (!loaded_scene)
         {
             std::printf("%s not found or invalid; starting with empty scene.\n", scene_paths::default_scene_path());
         }
@@ -73,7 +107,11 @@ namespace fox
                 return;
             scene_save_desc desc{};
             desc.path = scene_paths::default_scene_path();
-            scene_io_->save_scene(desc);
+            if (scene_io_->save_scene(desc))
+            {
+                desc.path = scene_paths::default_snapshot_path();
+                scene_io_->save_scene(desc);
+            }
         });
 
         renderer_.pin_draw_query_once();
@@ -107,6 +145,16 @@ namespace fox
                 state.light = default_light_;
                 state.camera_pos = camera_pos_;
                 state.cached_texture_count = tex_cache_.size();
+                state.texture_resident_bytes = tex_cache_.resident_bytes();
+                state.streaming_asset_count = render_queue_ ? render_queue_->pending_assets() : 0;
+                state.draw_stats = renderer_.last_draw_stats();
+                state.frame_stats = renderer_.last_frame_stats();
+                for (std::size_t t = 0; t < kMemTagCount; ++t)
+                    state.memory[t] = mem_stats((mem_tag)t);
+                state.streaming = world_streamer_ ? world_streamer_->stats() : world_streaming_stats{};
+                state.stats_csv_recording = stats_csv_ != nullptr;
+                state.raster_isa = raster_isa_name(renderer_.best_raster_isa());
+                state.render_scale = renderer_.current_render_scale();
             },
             [this](const world_debug_state& state)
             {
@@ -119,11 +167,12 @@ namespace fox
                 default_light_ = state.light;
                 camera_pos_ = state.camera_pos;
                 camera_.set_position(camera_pos_);
+                set_stats_recording(state.stats_csv_recording);
             },
             [this]()
             {
                 camera_target_transform_ = nullptr;
-                renderer_.world.query<Transform, camera_target>().each_entity([&](fecs::entity, Transform& tr, camera_target&)
+                renderer_.world.query<const Transform, const camera_target>().each_entity([&](fecs::entity, const Transform& tr, const camera_target&)
                 {
                     if (!camera_target_transform_)
                         camera_target_transform_ = &tr;
@@ -141,6 +190,43 @@ namespace fox
             {
                 state.textures_enabled = renderer_.textures_enabled;
                 state.flip_v = renderer_.flip_v;
+                state.fused_post_effects = renderer_.fused_post_effects;
+                state.hierarchical_z = renderer_.hierarchical_z;
+                state.frustum_culling = renderer_.frustum_culling;
+                state.occlusion_culling = renderer_.occlusion_culling;
+                state.cluster_culling = renderer_.cluster_culling;
+                state.sort_front_to_back = renderer_.sort_front_to_back;
+                state.wide_raster = renderer_.wide_raster;
+                state.visibility_buffer = renderer_.visibility_buffer;
+                state.depth_prepass = renderer_.depth_prepass;
+                state.mesh_lod = renderer_.mesh_lod;
+                state.point_lights = renderer_.point_lights;
+                state.lanterns = lanterns_;
+                state.shadows = renderer_.shadows;
+                state.shadow_strength = renderer_.shadow_strength;
+                state.shadow_distance = renderer_.shadow_distance;
+                state.quantized_meshes = render_queue_ && render_queue_->quantized_meshes();
+                state.frame_pipelining = renderer_.frame_pipelining;
+                state.incremental_redraw = renderer_.incremental_redraw;
+                state.checkerboard = renderer_.checkerboard;
+                state.depth16 = renderer_.depth_mode == depth_format::unorm16;
+                state.debug_view = renderer_.debug_mode;
+                state.texture_budget_mb = (int)(texture_budget_bytes_ >> 20);
+                state.compressed_textures = tex_cache_.residency_format() == texture_format::bc1;
+                state.dynamic_resolution = renderer_.dynamic_resolution;
+                state.render_scale = renderer_.render_scale;
+                state.target_frame_ms = renderer_.target_frame_ms;
+                if (world_streamer_)
+                {
+                    state.streaming = world_streamer_->settings();
+                    state.streaming_budget_mb = (int)(streaming_budget_bytes_ >> 20);
+                }
+                for (std::size_t t = 0; t < kMemTagCount; ++t)
+                {
+                    const mem_budget b = get_mem_budget((mem_tag)t);
+                    state.memory_budget_mb[t][0] = (int)(b.soft_bytes >> 20);
+                    state.memory_budget_mb[t][1] = (int)(b.hard_bytes >> 20);
+                }
                 const scene_io::scene_post_processing_settings post = post_processing_settings();
                 state.post_process = post.post_process;
                 state.rainy_effect = post.rainy_effect;
@@ -150,6 +236,48 @@ namespace fox
             {
                 renderer_.textures_enabled = state.textures_enabled;
                 renderer_.flip_v = state.flip_v;
+                renderer_.fused_post_effects = state.fused_post_effects;
+                renderer_.hierarchical_z = state.hierarchical_z;
+                renderer_.frustum_culling = state.frustum_culling;
+                renderer_.occlusion_culling = state.occlusion_culling;
+                renderer_.cluster_culling = state.cluster_culling;
+                renderer_.sort_front_to_back = state.sort_front_to_back;
+                renderer_.wide_raster = state.wide_raster;
+                renderer_.visibility_buffer = state.visibility_buffer;
+                renderer_.depth_prepass = state.depth_prepass;
+                renderer_.mesh_lod = state.mesh_lod;
+                renderer_.point_lights = state.point_lights;
+                lanterns_ = state.lanterns;
+                renderer_.shadows = state.shadows;
+                renderer_.shadow_strength = state.shadow_strength;
+                renderer_.shadow_distance = state.shadow_distance;
+                if (render_queue_)
+                    render_queue_->set_quantized_meshes(state.quantized_meshes);
+                renderer_.frame_pipelining = state.frame_pipelining;
+                renderer_.incremental_redraw = state.incremental_redraw;
+                renderer_.checkerboard = state.checkerboard;
+                renderer_.depth_mode = state.depth16 ? depth_format::unorm16 : depth_format::f32;
+                renderer_.debug_mode = state.debug_view;
+                for (std::size_t t = 0; t < kMemTagCount; ++t)
+                {
+                    mem_budget b{};
+                    b.soft_bytes = (std::size_t)(std::max)(state.memory_budget_mb[t][0], 0) << 20;
+                    b.hard_bytes = (std::size_t)(std::max)(state.memory_budget_mb[t][1], 0) << 20;
+                    set_mem_budget((mem_tag)t, b);
+                }
+                texture_budget_bytes_ = (std::size_t)(std::max)(state.texture_budget_mb, 0) << 20;
+                tex_cache_.set_memory_budget(texture_budget());
+                tex_cache_.set_residency_format(state.compressed_textures ? texture_format::bc1 : texture_format::rgba8);
+                renderer_.dynamic_resolution = state.dynamic_resolution;
+                renderer_.render_scale = state.render_scale;
+                renderer_.target_frame_ms = state.target_frame_ms;
+                if (world_streamer_)
+                {
+                    world_streaming_settings streaming = state.streaming;
+                    streaming_budget_bytes_ = (std::size_t)(std::max)(state.streaming_budget_mb, 0) << 20;
+                    streaming.mesh_budget_bytes = mesh_budget();
+                    world_streamer_->set_settings(streaming);
+                }
 
                 scene_io::scene_post_processing_settings post{};
                 post.post_process = state.post_process;
@@ -162,6 +290,18 @@ namespace fox
 
         std::printf("Controls: WASD/QE move, Hold SHIFT faster, SPACE toggles FPS mouse look when enabled.\n");
 
+        if (config_.replay_input)
+        {
+            if (input_player_.open(config_.replay_input))
+                renderer_.windows.hold_input(true);
+            else
+                std::printf("Could not open input log %s, running on live input.\n", config_.replay_input);
+        }
+        if (config_.record_input && !input_player_.is_open() && !input_recorder_.open(config_.record_input))
+            std::printf("Could not create input log %s.\n", config_.record_input);
+        if (config_.stats_csv)
+            set_stats_recording(true);
+
         start_time_ = std::chrono::steady_clock::now();
         last_time_ = start_time_;
         initialized_ = true;
@@ -174,11 +314,22 @@ namespace fox
 
         char  title_buf[256]{};
         float last_fps_shown = -1.f;
+        std::uint32_t frames_drawn = 0;
 
-        while (true)
+        while (!config_.frame_limit || frames_drawn < config_.frame_limit)
         {
+            // Low latency mode blocks here until the display wants a frame, so input is read late
+            renderer_.canvas.pace_frame();
             renderer_.windows.poll_messages();
 
+            if (input_player_.is_open())
+            {
+                input_state replayed{};
+                if (!input_player_.next(replayed, replay_dt_s_))
+                    break;
+                renderer_.windows.set_input(replayed);
+            }
+
             if (renderer_.windows.key_down(VK_ESCAPE))
                 break;
 
@@ -187,6 +338,8 @@ namespace fox
 
             const auto now = std::chrono::steady_clock::now();
             update_timing(now);
+            if (input_recorder_.is_open())
+                input_recorder_.record(renderer_.windows.input(), delta_time_s_);
 
             if (fps_ != last_fps_shown)
             {
@@ -202,12 +355,19 @@ namespace fox
                 last_fps_shown = fps_;
             }
 
+            update_memory_budgets();
+            if (world_streamer_)
+                world_streamer_->update(camera_.position());
             if (render_queue_)
-                render_queue_->tick_dynamic_animations(delta_time_s_);
+            {
+                render_queue_->poll_streaming();
+                render_queue_->tick_dynamic_animations(delta_time_s_, camera_.position());
+                render_queue_->update_transforms();
+            }
 
             matrix focus_world = matrix::makeIdentity();
             camera_target_transform_ = nullptr;
-            renderer_.world.query<Transform, camera_target>().each_entity([&](fecs::entity, Transform& tr, camera_target&)
+            renderer_.world.query<const Transform, const camera_target>().each_entity([&](fecs::entity, const Transform& tr, const camera_target&)
             {
                 if (!camera_target_transform_)
                     camera_target_transform_ = &tr;
@@ -257,19 +417,172 @@ namespace fox
             editor_ctx.window = &renderer_.windows;
             editor_ctx.rq = render_queue_.get();
             drag_move_tool_.tick(editor_ctx);
+            update_light_cycle(delta_time_s_);
+            update_lanterns();
+
+            // Nothing on screen would change: show the last frame again under a fresh UI pass and
+            // sleep until input arrives or a frame's time has passed
+            if (renderer_.frame_unchanged(config_.clear_rgba, camera_.view_matrix(), light_dir_))
+            {
+                renderer_.present_last_frame();
+                if (!input_player_.is_open())
+                    renderer_.windows.wait_messages(kIdleFrameMs);
+                continue;
+            }
 
             if (!renderer_.begin_cpu_frame(config_.clear_rgba))
                 continue;
+            write_stats_row();
+
+            // The last frame has retired, so nothing samples the texels a trim replaces
+            if (tex_cache_.over_budget())
+            {
+                texture_trims_.clear();
+                tex_cache_.trim_to_budget(texture_trims_);
+                retarget_texture_refs(renderer_.world, texture_trims_);
+                tex_cache_.release_retired();
+            }
 
-            update_light_cycle(delta_time_s_);
             renderer_.draw_world(camera_.view_matrix(), default_light_, light_dir_);
-            renderer_.apply_post_process(renderer_.post_process);
-            renderer_.apply_rainy_effect(renderer_.rainy_effect, elapsed_time_s_);
-            renderer_.apply_advanced_effects(renderer_.advanced_effects, elapsed_time_s_);
-            renderer_.present();
+            renderer_.apply_post_effects(renderer_.post_process, renderer_.rainy_effect, renderer_.advanced_effects, elapsed_time_s_);
+            if (offline_sink_.is_open())
+                renderer_.write_offline_frame(offline_sink_);
+            else
+                renderer_.present();
+            ++frames_drawn;
         }
 
+        renderer_.wait_frame_in_flight();
         renderer_.canvas.flush();
+        if (offline_sink_.frames.is_open())
+        {
+            const std::uint32_t submitted = offline_sink_.frames.frame_count();
+            const std::uint32_t failed = offline_sink_.frames.close();
+            std::printf("Wrote %u offline frames to %s.\n", submitted - failed, config_.offline_output);
+            if (failed)
+                std::printf("%u offline frames failed to write.\n", failed);
+        }
+        if (offline_sink_.gif.is_open())
+        {
+            offline_sink_.gif.close();
+            if (offline_sink_.gif.failed())
+                std::printf("Writing %s failed.\n", config_.offline_gif);
+            else
+                std::printf("Wrote %u offline frames to %s.\n", offline_sink_.gif.frame_count(), config_.offline_gif);
+        }
+        set_stats_recording(false);
+        input_recorder_.close();
+        if (input_player_.is_open())
+        {
+            std::printf("Replayed %u frames.\n", input_player_.frame_count());
+            input_player_.close();
+            renderer_.windows.hold_input(false);
+        }
+    }
+
+    void game_world::set_stats_recording(bool enabled) noexcept
+    {
+        if (enabled == (stats_csv_ != nullptr))
+            return;
+
+        if (!enabled)
+        {
+            std::fclose(stats_csv_);
+            stats_csv_ = nullptr;
+            return;
+        }
+
+        stats_csv_ = std::fopen("frame_stats.csv", "w");
+        if (!stats_csv_)
+            return;
+
+        std::fputs("frame,frame_ms", stats_csv_);
+        for (std::size_t p = 0; p < optimized_renderer_core::kFramePassCount; ++p)
+            std::fprintf(stats_csv_, ",%s_ms", optimized_renderer_core::frame_pass_name((optimized_renderer_core::frame_pass)p));
+        std::fputs(",worker_busy_ms,tris_submitted,tris_culled,tris_rasterized,pixels_tested,pixels_shaded,heap_allocations,present_latency_ms", stats_csv_);
+        for (std::size_t t = 0; t < kMemTagCount; ++t)
+            std::fprintf(stats_csv_, ",%s_mb", mem_tag_name((mem_tag)t));
+        std::fputc('\n', stats_csv_);
+        stats_csv_frame_ = renderer_.last_frame_stats().frame_index;
+    }
+
+    void game_world::write_stats_row() noexcept
+    {
+        const optimized_renderer_core::frame_stats& fs = renderer_.last_frame_stats();
+        if (!stats_csv_ || fs.frame_index == stats_csv_frame_)
+            return;
+        stats_csv_frame_ = fs.frame_index;
+
+        // Busy time summed over the workers, so one column whatever the thread count
+        double busy = 0.0;
+        for (const double ms : fs.worker_busy_ms)
+            busy += ms;
+
+        std::fprintf(stats_csv_, "%llu,%.3f", (unsigned long long)fs.frame_index, fs.frame_ms);
+        for (std::size_t p = 0; p < optimized_renderer_core::kFramePassCount; ++p)
+            std::fprintf(stats_csv_, ",%.3f", fs.pass_ms[p]);
+        std::fprintf(stats_csv_, ",%.3f,%u,%u,%u,%llu,%llu,%llu,%.3f",
+                     busy,
+                     fs.draw.triangles_submitted,
+                     fs.draw.triangles_culled,
+                     fs.draw.triangles_rasterized,
+                     (unsigned long long)fs.pixels_depth_tested,
+                     (unsigned long long)fs.pixels_shaded,
+                     (unsigned long long)fs.heap_allocations,
+                     fs.latency.last_ms);
+        for (std::size_t t = 0; t < kMemTagCount; ++t)
+            std::fprintf(stats_csv_, ",%.2f", (double)fs.memory_bytes[t] / (1024.0 * 1024.0));
+        std::fputc('\n', stats_csv_);
+    }
+
+    namespace
+    {
+        // The tighter of two budgets where 0 means none
+        [[nodiscard]] constexpr std::size_t tighter_budget(std::size_t a, std::size_t b) noexcept
+        {
+            return a == 0 ? b : b == 0 ? a : (std::min)(a, b);
+        }
+    }
+
+    std::size_t game_world::texture_budget() const noexcept
+    {
+        return tighter_budget(texture_budget_bytes_, get_mem_budget(mem_tag::textures).hard_bytes);
+    }
+
+    std::size_t game_world::mesh_budget() const noexcept
+    {
+        return tighter_budget(streaming_budget_bytes_, get_mem_budget(mem_tag::meshes).hard_bytes);
+    }
+
+    void game_world::update_memory_budgets() noexcept
+    {
+        // A hard budget holds the two subsystems that can give memory back to it: the texture cache
+        // drops top mips and the streamer unloads the farthest cells (with world streaming on)
+        if (tex_cache_.memory_budget() != texture_budget())
+            tex_cache_.set_memory_budget(texture_budget());
+        if (world_streamer_ && world_streamer_->settings().mesh_budget_bytes != mesh_budget())
+        {
+            world_streaming_settings streaming = world_streamer_->settings();
+            streaming.mesh_budget_bytes = mesh_budget();
+            world_streamer_->set_settings(streaming);
+        }
+
+        // Everything else is only reported, once as it crosses into each state
+        for (std::size_t t = 0; t < kMemTagCount; ++t)
+        {
+            const mem_budget_state state = mem_budget_check((mem_tag)t);
+            if (state == memory_states_[t])
+                continue;
+            if (state > memory_states_[t])
+            {
+                const mem_budget b = get_mem_budget((mem_tag)t);
+                std::printf("Memory: %s at %.1f MB is over its %s budget of %.1f MB\n", mem_tag_name((mem_tag)t),
+                            (double)mem_live_bytes((mem_tag)t) / (1024.0 * 1024.0),
+                            state == mem_budget_state::hard ? "hard" : "soft",
+                            (double)(state == mem_budget_state::hard ? b.hard_bytes : b.soft_bytes) / (1024.0 * 1024.0));
+            }
+            memory_states_[t] = state;
+        }
     }
 
     bool game_world::is_mouse_safe_for_editing() const noexcept
@@ -294,6 +607,56 @@ namespace fox
             vec4(0.f, 1.f, 0.f, 0.f));
     }
 
+    void game_world::update_lanterns() noexcept
+    {
+        fecs::world& world = renderer_.world;
+        if (lanterns_.count != spawned_lanterns_.count || lanterns_.spread != spawned_lanterns_.spread)
+        {
+            world.destroy_entities(lantern_entities_);
+            lantern_entities_.clear();
+
+            // A golden angle spiral spreads any count evenly; every fifth one sits low and red, as
+            // lava glow would
+            const std::size_t count = (std::size_t)(std::max)(lanterns_.count, 0);
+            const float golden = fox_math::pi_f * (3.f - std::sqrt(5.f));
+            world.create_entities<PointLight>(count, lantern_entities_, [&](std::size_t i, fecs::entity, PointLight& light)
+            {
+                const float r = lanterns_.spread * std::sqrt(((float)i + 0.5f) / (float)count);
+                const float a = golden * (float)i;
+                const bool lava = i % 5 == 4;
+                light.position = vec4(r * std::cos(a), lava ? 0.5f : 2.5f, r * std::sin(a), 1.f);
+                light.col = lava ? colour(1.f, 0.3f, 0.08f) : colour(1.f, 0.75f, 0.45f);
+            });
+            spawned_lanterns_ = lanterns_;
+            spawned_lanterns_.radius = -1.f;  // the new lights still need their radius and intensity
+        }
+        if (lantern_entities_.empty())
+            return;
+
+        // Each light beats two sines against each other, phased by where it stands so neighbours do
+        // not pulse together. Writing every frame keeps frame_unchanged false, so a steady light is
+        // only written on a change.
+        const bool steady = lanterns_.flicker <= 0.f;
+        if (steady && lanterns_.radius == spawned_lanterns_.radius && lanterns_.intensity == spawned_lanterns_.intensity &&
+            spawned_lanterns_.flicker <= 0.f)
+            return;
+        spawned_lanterns_.radius = lanterns_.radius;
+        spawned_lanterns_.intensity = lanterns_.intensity;
+        spawned_lanterns_.flicker = lanterns_.flicker;
+
+        const float t = elapsed_time_s_;
+        world.query<PointLight>().par_each(job_system::instance(), kLanternsPerTask, [&](PointLight* lights, std::size_t n)
+        {
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                const vec4& p = lights[k].position;
+                const float beat = 0.5f + 0.5f * std::sin(t * 7.3f + p.x * 1.7f) * std::sin(t * 3.1f + p.z * 0.9f);
+                lights[k].radius = lanterns_.radius;
+                lights[k].intensity = lanterns_.intensity * (1.f - lanterns_.flicker * beat);
+            }
+        });
+    }
+
     void game_world::update_free_camera(float dt) noexcept
     {
         fox::platform_window& wnd = renderer_.windows;
@@ -312,6 +675,8 @@ namespace fox
             free_camera_enabled_ = !free_camera_enabled_;
         free_cam_toggle_was_down_ = toggle_free;
 
+        // The window recentres the cursor as it polls, so the travel is part of what input logs hold
+        wnd.set_relative_mouse(free_camera_enabled_ && fps_mouse_enabled_);
         if (!free_camera_enabled_)
             return;
 
@@ -320,25 +685,8 @@ namespace fox
 
         if (fps_mouse_enabled_)
         {
-            POINT cursor{};
-            if (GetCursorPos(&cursor))
-            {
-                HWND hwnd = static_cast<HWND>(wnd.native_hwnd());
-                if (hwnd)
-                {
-                    ScreenToClient(hwnd, &cursor);
-                    RECT rect{};
-                    GetClientRect(hwnd, &rect);
-                    const int cx = (rect.right - rect.left) / 2;
-                    const int cy = (rect.bottom - rect.top) / 2;
-                    mouse_dx = static_cast<float>(cursor.x - cx) * camera_mouse_sensitivity_;
-                    mouse_dy = static_cast<float>(cursor.y - cy) * camera_mouse_sensitivity_;
-
-                    POINT center{ cx, cy };
-                    ClientToScreen(hwnd, &center);
-                    SetCursorPos(center.x, center.y);
-                }
-            }
+            mouse_dx = static_cast<float>(wnd.mouse_dx()) * camera_mouse_sensitivity_;
+            mouse_dy = static_cast<float>(wnd.mouse_dy()) * camera_mouse_sensitivity_;
         }
 
         camera_.set_position(camera_pos_);
@@ -364,8 +712,17 @@ namespace fox
 
     void game_world::update_timing(std::chrono::steady_clock::time_point now) noexcept
     {
-        delta_time_s_ = std::chrono::duration<float>(now - last_time_).count();
-        elapsed_time_s_ = std::chrono::duration<float>(now - start_time_).count();
+        // A replay runs on the recorded frame times however long its frames take now
+        if (input_player_.is_open())
+        {
+            delta_time_s_ = replay_dt_s_;
+            elapsed_time_s_ += replay_dt_s_;
+        }
+        else
+        {
+            delta_time_s_ = std::chrono::duration<float>(now - last_time_).count();
+            elapsed_time_s_ = std::chrono::duration<float>(now - start_time_).count();
+        }
         last_time_ = now;
 
         fps_accum_s_ += static_cast<double>(delta_time_s_);
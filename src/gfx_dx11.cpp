@@ -13,17 +13,19 @@
 #include <cstdlib>
 #include <cstring>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <string>
 #include <thread>
 #include <vector>
 #include <cstdio>
 
+#include "optimized/frame_recorder.h"
 #include "optimized/imgui_hook.h"
-
-#ifdef USE_SIMD
-#include <immintrin.h>
-#endif
+#include "optimized/memory_stats.h"
+#include "optimized/row_copy.h"
+#include "optimized/thread_topology.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -36,35 +38,6 @@ namespace
         OutputDebugStringA(b);
     }
 
-#ifdef USE_SIMD
-    static inline void copy_row_simd(std::uint8_t* dst, const std::uint8_t* src, std::size_t bytes) noexcept
-    {
-        std::size_t i = 0;
-        const bool use_nt = bytes >= 512;
-        if (use_nt)
-        {
-            const std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(dst);
-            const std::size_t align = (32u - (addr & 31u)) & 31u;
-            for (; i < align && i < bytes; ++i) dst[i] = src[i];
-            for (; i + 32 <= bytes; i += 32)
-            {
-                const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i));
-                _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + i), v);
-            }
-            for (; i < bytes; ++i) dst[i] = src[i];
-            _mm_sfence();
-            return;
-        }
-
-        for (; i + 32 <= bytes; i += 32)
-        {
-            const __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i));
-            _mm256_store_si256(reinterpret_cast<__m256i*>(dst + i), v);
-        }
-        for (; i < bytes; ++i) dst[i] = src[i];
-    }
-#endif
-
     static inline std::uint32_t align_up_u32(std::uint32_t v, std::uint32_t a) noexcept
     {
         return (v + (a - 1u)) & ~(a - 1u);
@@ -107,36 +80,59 @@ public:
     ComPtr<ID3D11PixelShader>  ps;
     ComPtr<ID3D11SamplerState> samp;
 
+    // Low latency: the swap chain keeps one frame queued and signals latency_waitable when it can
+    // take the next, which pace_frame waits on before the frame's input is read
+    bool   low_latency = false;
+    HANDLE latency_waitable = nullptr;
+
     std::uint32_t ring_size = 0;
     std::vector<ComPtr<ID3D11Texture2D>>          ring_tex;
     std::vector<ComPtr<ID3D11ShaderResourceView>> ring_srv;
 
     std::uint32_t gpu_pitch_bytes = 0;
 
+    // Zero copy present: every slot also owns a dynamic texture that stays mapped while the slot
+    // is on the CPU side, so frames are rasterized straight into upload memory. The present thread
+    // unmaps it to draw and maps it again with discard before the slot is handed out again.
+    bool zero_copy = false;
+    std::vector<ComPtr<ID3D11Texture2D>>          map_tex;
+    std::vector<ComPtr<ID3D11ShaderResourceView>> map_srv;
+
+    // present_again draws the last frame shown once more. Ring textures keep their frame until the
+    // slot presents again, but a mapped slot is discarded as it goes back to the CPU, so zero copy
+    // frames are copied to keep_tex first. Present thread only.
+    ComPtr<ID3D11Texture2D>          keep_tex;
+    ComPtr<ID3D11ShaderResourceView> keep_srv;
+    ID3D11ShaderResourceView*        last_srv = nullptr;
+
     struct slot_t
     {
-        std::vector<std::uint32_t> color;
+        std::vector<std::uint32_t> color; // system memory frame, uploaded on present
         std::uint32_t color_pitch_bytes  = 0;
         std::uint32_t color_pitch_pixels = 0;
 
+        std::uint32_t* mapped = nullptr; // pData of map_tex while mapped
+        std::uint32_t  mapped_pitch_bytes = 0;
+        bool           via_copy = true;      // the frame handed out lives in color
+
         float*        z = nullptr;
         std::uint32_t  z_pitch = 0;
+        std::size_t    tracked_bytes = 0; // colour and depth counted under mem_tag::gfx
 
         std::uint32_t generation = 1;
+        std::uint64_t input_qpc = 0; // input sample of the frame handed out, for latency stats
 
-        enum class state_t : std::uint8_t { free, acquired, queued, presenting, clearing } state = state_t::free;
+        // Released slots go straight back to free; the renderer clears each tile as it first
+        // touches it, so nothing here spends bandwidth on a clear that would be overwritten
+        enum class state_t : std::uint8_t { free, acquired, queued, presenting } state = state_t::free;
     };
 
     std::vector<slot_t> slots;
 
     std::thread present_worker;
 
-    static constexpr int CLEAR_WORKERS = 2;
-    std::thread clear_workers[CLEAR_WORKERS];
-
     std::mutex mtx;
     std::condition_variable cv_present;
-    std::condition_variable cv_clear;
     std::condition_variable cv_free;
     std::condition_variable cv_flush;
 
@@ -149,7 +145,7 @@ public:
     bool latest_rec_valid = false;
     std::uint32_t latest_rec_index = 0;
 
-    std::deque<std::uint32_t> clear_q;
+    bool repeat_requested = false;
 
     struct bb_clear_cmd { std::uint32_t rgba = 0; };
     std::deque<bb_clear_cmd> bb_q;
@@ -162,14 +158,25 @@ public:
     std::uint64_t qpc_last_fail_log = 0;
     std::uint64_t qpc_f = 0;
 
+    std::uint64_t pace_qpc = 0;         // main thread, last time pace_frame returned
+    present_latency_stats latency{};    // mtx
+    std::uint64_t latency_window_qpc = 0;
+    double        latency_window_peak = 0.0;
+
     bool recording = false;
     bool playing   = false;
     bool looping   = false;
     std::uint32_t play_cursor = 0;
 
-    std::uint32_t rec_pitch_bytes  = 0;
-    std::uint32_t rec_pitch_pixels = 0;
-    std::vector<std::vector<std::uint32_t>> rec_frames;
+    // Captures stream to record_path; playback maps the same file. The present thread holds its
+    // own reference to the player while it uploads a frame.
+    static constexpr const char* kDefaultRecordPath = "captures/capture.fxr";
+    std::string record_path = kDefaultRecordPath;
+    frame_recorder recorder;
+    // Held around every open, submit and close of recorder, taken before mtx. submit may wait on
+    // the writer thread, which mtx must not, as the present thread needs it meanwhile.
+    std::mutex record_mtx;
+    std::shared_ptr<frame_player> player;
 
     std::uint64_t ui_last_qpc = 0;
     std::uint64_t ui_qpc_freq = 0;
@@ -220,13 +227,32 @@ public:
         desc.BufferCount = 3;
         desc.SwapEffect  = DXGI_SWAP_EFFECT_FLIP_DISCARD;
         desc.Scaling     = DXGI_SCALING_STRETCH;
+        desc.Flags       = low_latency ? DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT : 0u;
 
-        const HRESULT hr = factory2->CreateSwapChainForHwnd(
+        HRESULT hr = factory2->CreateSwapChainForHwnd(
             dev.Get(), hwnd, &desc, nullptr, nullptr, sc1.GetAddressOf());
 
+        // Waitable swap chains need DXGI 1.3; older systems get the default mode
+        if (FAILED(hr) && low_latency)
+        {
+            DebugFail("CreateSwapChainForHwnd(waitable)", hr);
+            low_latency = false;
+            desc.Flags = 0;
+            hr = factory2->CreateSwapChainForHwnd(
+                dev.Get(), hwnd, &desc, nullptr, nullptr, sc1.GetAddressOf());
+        }
+
         if (FAILED(hr)) { DebugFail("CreateSwapChainForHwnd", hr); std::abort(); }
 
         sc1.As(&sc3);
+
+        if (low_latency)
+        {
+            ComPtr<IDXGISwapChain2> sc2;
+            sc1.As(&sc2);
+            sc2->SetMaximumFrameLatency(1);
+            latency_waitable = sc2->GetFrameLatencyWaitableObject();
+        }
     }
 
     void create_rtvs()
@@ -358,10 +384,125 @@ public:
 
             s.generation = 1;
             s.state = slot_t::state_t::free;
+            track_slot(s);
+        }
+
+        if (!zero_copy) return;
+
+        D3D11_TEXTURE2D_DESC kd = td;
+        kd.Usage          = D3D11_USAGE_DEFAULT;
+        kd.CPUAccessFlags = 0;
+        hr = dev->CreateTexture2D(&kd, nullptr, keep_tex.GetAddressOf());
+        if (FAILED(hr)) { DebugFail("CreateTexture2D(keep)", hr); std::abort(); }
+        hr = dev->CreateShaderResourceView(keep_tex.Get(), nullptr, keep_srv.GetAddressOf());
+        if (FAILED(hr)) { DebugFail("CreateSRV(keep)", hr); std::abort(); }
+
+        map_tex.resize(ring_size);
+        map_srv.resize(ring_size);
+        for (std::uint32_t i = 0; i < ring_size; ++i)
+        {
+            HRESULT hr2 = dev->CreateTexture2D(&td, nullptr, map_tex[i].GetAddressOf());
+            if (FAILED(hr2)) { DebugFail("CreateTexture2D(map)", hr2); std::abort(); }
+            hr2 = dev->CreateShaderResourceView(map_tex[i].Get(), nullptr, map_srv[i].GetAddressOf());
+            if (FAILED(hr2)) { DebugFail("CreateSRV(map)", hr2); std::abort(); }
+
+            // Mapped slots never touch their system memory copy unless they fall back to it
+            map_slot(i);
+            if (slots[i].mapped)
+            {
+                slots[i].color.clear();
+                slots[i].color.shrink_to_fit();
+                track_slot(slots[i]);
+            }
+        }
+    }
+
+    // Keeps mem_tag::gfx in step with the system memory a slot holds
+    void track_slot(slot_t& s) const noexcept
+    {
+        const std::size_t bytes = s.color.capacity() * sizeof(std::uint32_t)
+                                + (s.z ? (std::size_t)s.z_pitch * h * sizeof(float) : 0u);
+        if (bytes > s.tracked_bytes)
+            fox::mem_track_alloc(fox::mem_tag::gfx, bytes - s.tracked_bytes);
+        else
+            fox::mem_track_free(fox::mem_tag::gfx, s.tracked_bytes - bytes);
+        s.tracked_bytes = bytes;
+    }
+
+    // Context calls, present thread (or before it starts) only
+    void map_slot(std::uint32_t slot) noexcept
+    {
+        auto& s = slots[slot];
+        s.mapped = nullptr;
+
+        D3D11_MAPPED_SUBRESOURCE map{};
+        const HRESULT hr = ctx->Map(map_tex[slot].Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
+        if (FAILED(hr) || (map.RowPitch & 3u))
+        {
+            if (SUCCEEDED(hr)) ctx->Unmap(map_tex[slot].Get(), 0);
+            DebugFail("Map(map_tex)", hr);
+
+            // Stay on the copy path from here on
+            if (s.color.empty())
+            {
+                s.color.assign((std::size_t)s.color_pitch_pixels * (std::size_t)h, 0u);
+                track_slot(s);
+            }
+            return;
         }
 
-        rec_pitch_bytes  = gpu_pitch_bytes;
-        rec_pitch_pixels = pitch_pixels;
+        s.mapped = static_cast<std::uint32_t*>(map.pData);
+        s.mapped_pitch_bytes = (std::uint32_t)map.RowPitch;
+    }
+
+    void unmap_slot(std::uint32_t slot) noexcept
+    {
+        auto& s = slots[slot];
+        if (!s.mapped) return;
+        ctx->Unmap(map_tex[slot].Get(), 0);
+        s.mapped = nullptr;
+    }
+
+    // Recording reads frames back, which write combined memory is very slow at
+    [[nodiscard]] bool slot_hands_out_mapped(const slot_t& s) const noexcept
+    {
+        return s.mapped && !recording;
+    }
+
+    cpu_frame frame_from_slot_locked(std::uint32_t i) noexcept
+    {
+        auto& s = slots[i];
+        s.state = slot_t::state_t::acquired;
+
+        s.via_copy = !slot_hands_out_mapped(s);
+        if (s.via_copy && s.color.empty())
+        {
+            s.color.assign((std::size_t)s.color_pitch_pixels * (std::size_t)h, 0u);
+            track_slot(s);
+        }
+
+        cpu_frame f{};
+        f.w = w;
+        f.h = h;
+        if (s.via_copy)
+        {
+            f.color_pitch_bytes  = s.color_pitch_bytes;
+            f.color_pitch_pixels = s.color_pitch_pixels;
+            f.color = s.color.data();
+        }
+        else
+        {
+            f.color_pitch_bytes  = s.mapped_pitch_bytes;
+            f.color_pitch_pixels = s.mapped_pitch_bytes / 4u;
+            f.color = s.mapped;
+            f.write_combined = true;
+        }
+        f.z_pitch = s.z_pitch;
+        f.z = s.z;
+        f.slot = i;
+        f.generation = s.generation;
+        s.input_qpc = low_latency && pace_qpc ? pace_qpc : qpc_now();
+        return f;
     }
 
     void bind_backbuffer() noexcept
@@ -401,11 +542,7 @@ public:
 
         for (std::uint32_t y = 0; y < h; ++y)
         {
-#ifdef USE_SIMD
-            copy_row_simd(dst, src, copy_bytes);
-#else
-            std::memcpy(dst, src, copy_bytes);
-#endif
+            fox::copy_row(dst, src, copy_bytes);
             src += src_pitch_bytes;
             dst += (std::uint32_t)map.RowPitch;
         }
@@ -422,12 +559,16 @@ public:
     }
 
     void present_tex_slot_now(std::uint32_t slot) noexcept
+    {
+        present_srv_now(ring_srv[slot].Get());
+    }
+
+    void present_srv_now(ID3D11ShaderResourceView* srv) noexcept
     {
         set_pipeline();
         bind_backbuffer();
         ctx->RSSetViewports(1, &vp);
 
-        ID3D11ShaderResourceView* srv = ring_srv[slot].Get();
         ctx->PSSetShaderResources(0, 1, &srv);
         ctx->Draw(3, 0);
 
@@ -444,43 +585,37 @@ public:
         imgui_hook::instance().begin_frame(dt);
         imgui_hook::instance().render();
 
-        sc1->Present(0, DXGI_PRESENT_DO_NOT_WAIT);
-    }
-
-    void clear_slot_cpu(std::uint32_t slot) noexcept
-    {
-        auto& s = slots[slot];
-        if (!s.color.empty()) std::memset(s.color.data(), 0, s.color.size() * sizeof(std::uint32_t));
-        if (s.z)
-        {
-            const std::size_t zcount = (std::size_t)s.z_pitch * (std::size_t)h;
-            std::memset(s.z, 0, zcount * sizeof(float));
-        }
+        // The waitable object already paced the CPU, so this waits for the vblank at most
+        if (low_latency)
+            sc1->Present(1, 0);
+        else
+            sc1->Present(0, DXGI_PRESENT_DO_NOT_WAIT);
     }
 
-    void copy_frame_to_recording(const cpu_frame& f) noexcept
+    void record_latency(std::uint64_t input_qpc) noexcept
     {
-        if (!f.valid()) return;
-        if (rec_pitch_bytes == 0 || rec_pitch_pixels == 0) return;
-
-        std::vector<std::uint32_t> dst;
-        dst.resize((std::size_t)rec_pitch_pixels * (std::size_t)h);
-
-        const std::uint8_t* src = reinterpret_cast<const std::uint8_t*>(f.color);
-        std::uint8_t* out = reinterpret_cast<std::uint8_t*>(dst.data());
+        const std::uint64_t now = qpc_now();
+        const double ms = double(now - input_qpc) * 1000.0 / double(qpc_f);
 
-        const std::uint32_t copy_bytes = (std::min)(f.color_pitch_bytes, rec_pitch_bytes);
+        std::lock_guard<std::mutex> lk(mtx);
+        latency.last_ms = ms;
+        latency.avg_ms = latency.frames ? latency.avg_ms + (ms - latency.avg_ms) * (1.0 / 16.0) : ms;
+        ++latency.frames;
 
-        for (std::uint32_t y = 0; y < h; ++y)
+        latency_window_peak = (std::max)(latency_window_peak, ms);
+        if (!latency_window_qpc || now - latency_window_qpc >= qpc_f)
         {
-            std::memcpy(out, src, copy_bytes);
-            if (rec_pitch_bytes > copy_bytes)
-                std::memset(out + copy_bytes, 0, (std::size_t)(rec_pitch_bytes - copy_bytes));
-            src += f.color_pitch_bytes;
-            out += rec_pitch_bytes;
+            latency.peak_ms = latency_window_peak;
+            latency_window_peak = 0.0;
+            latency_window_qpc = now;
         }
+    }
 
-        rec_frames.emplace_back(std::move(dst));
+    [[nodiscard]] std::uint32_t record_frames_locked() const noexcept
+    {
+        if (!recording && player)
+            return player->frame_count();
+        return recorder.frame_count();
     }
 
     void log_try_fail_if_needed_locked() noexcept
@@ -493,7 +628,7 @@ public:
         if (dt < 0.5) return;
         qpc_last_fail_log = now;
 
-        std::uint32_t free_n = 0, acq_n = 0, queued_n = 0, pres_n = 0, clr_n = 0;
+        std::uint32_t free_n = 0, acq_n = 0, queued_n = 0, pres_n = 0;
         for (auto& s : slots)
         {
             switch (s.state)
@@ -502,43 +637,15 @@ public:
                 case slot_t::state_t::acquired:   ++acq_n; break;
                 case slot_t::state_t::queued:     ++queued_n; break;
                 case slot_t::state_t::presenting: ++pres_n; break;
-                case slot_t::state_t::clearing:   ++clr_n; break;
             }
         }
     }
 
-    void clear_loop_worker() noexcept
+    void release_slot_locked(slot_t& s) noexcept
     {
-        for (;;)
-        {
-            std::uint32_t slot = 0xFFFFFFFFu;
-
-            {
-                std::unique_lock<std::mutex> lk(mtx);
-                cv_clear.wait(lk, [&] { return shutting_down || !clear_q.empty(); });
-
-                if (shutting_down && clear_q.empty())
-                    return;
-
-                slot = clear_q.front();
-                clear_q.pop_front();
-            }
-
-            if (slot < slots.size())
-            {
-                clear_slot_cpu(slot);
-
-                {
-                    std::lock_guard<std::mutex> lk(mtx);
-                    auto& s = slots[slot];
-                    if (s.state == slot_t::state_t::clearing)
-                    {
-                        s.state = slot_t::state_t::free;
-                        cv_free.notify_one();
-                    }
-                }
-            }
-        }
+        s.state = slot_t::state_t::free;
+        ++s.generation;
+        cv_free.notify_one();
     }
 
     void drop_latest_slot_if_queued_locked() noexcept
@@ -555,12 +662,7 @@ public:
 
         auto& os = slots[old_slot];
         if (os.state == slot_t::state_t::queued && os.generation == old_gen)
-        {
-            os.state = slot_t::state_t::clearing;
-            ++os.generation;
-            clear_q.push_back(old_slot);
-            cv_clear.notify_one();
-        }
+            release_slot_locked(os);
     }
 
     void present_loop() noexcept
@@ -576,12 +678,15 @@ public:
             bool do_rec = false;
             std::uint32_t rec_idx = 0;
 
+            bool do_repeat = false;
+
             {
                 std::unique_lock<std::mutex> lk(mtx);
                 cv_present.wait(lk, [&] {
                     return shutting_down
                         || latest_slot_valid
                         || latest_rec_valid
+                        || repeat_requested
                         || !bb_q.empty()
                         || (flush_marker_requested != 0);
                 });
@@ -600,7 +705,7 @@ public:
 
                 if (flush_marker_requested != 0)
                 {
-                    bool busy = latest_slot_valid || latest_rec_valid || !clear_q.empty();
+                    bool busy = latest_slot_valid || latest_rec_valid;
                     if (!busy)
                     {
                         for (auto& s : slots)
@@ -621,6 +726,10 @@ public:
                     }
                 }
 
+                // A new frame replaces the repeat it would have drawn over anyway
+                if (latest_rec_valid || latest_slot_valid)
+                    repeat_requested = false;
+
                 if (latest_rec_valid)
                 {
                     do_rec = true;
@@ -645,11 +754,7 @@ public:
                         else
                         {
                             if (s.state == slot_t::state_t::queued || s.state == slot_t::state_t::presenting)
-                            {
-                                s.state = slot_t::state_t::clearing;
-                                clear_q.push_back(slot);
-                                cv_clear.notify_one();
-                            }
+                                release_slot_locked(s);
                             do_slot = false;
                             slot = 0xFFFFFFFFu;
                         }
@@ -660,37 +765,60 @@ public:
                         slot = 0xFFFFFFFFu;
                     }
                 }
+                else if (repeat_requested)
+                {
+                    repeat_requested = false;
+                    do_repeat = true;
+                }
                 else
                 {
                     continue;
                 }
             }
 
-            if (do_rec)
+            if (do_repeat)
             {
-                const std::uint8_t* src = nullptr;
-                std::uint32_t src_pitch = 0;
+                if (last_srv)
+                    present_srv_now(last_srv);
+                continue;
+            }
 
+            if (do_rec)
+            {
+                std::shared_ptr<frame_player> pl;
                 {
                     std::lock_guard<std::mutex> lk(mtx);
-                    if (rec_idx < rec_frames.size())
-                    {
-                        src = reinterpret_cast<const std::uint8_t*>(rec_frames[rec_idx].data());
-                        src_pitch = rec_pitch_bytes;
-                    }
+                    pl = player;
                 }
 
-                if (src && src_pitch)
+                // Decoding runs ahead on the player's thread, this only waits when it fell behind
+                const std::uint32_t* src = (pl && pl->width() == w && pl->height() == h) ? pl->acquire(rec_idx) : nullptr;
+                if (src)
                 {
                     upload_slot = (upload_slot + 1u) % (ring_size ? ring_size : 1u);
-                    upload_bytes_to_tex(upload_slot, src, src_pitch);
+                    upload_bytes_to_tex(upload_slot, reinterpret_cast<const std::uint8_t*>(src), w * 4u);
                     present_tex_slot_now(upload_slot);
+                    last_srv = ring_srv[upload_slot].Get();
                 }
             }
             else if (do_slot && slot != 0xFFFFFFFFu)
             {
-                upload_slot_to_tex(slot);
-                present_tex_slot_now(slot);
+                const std::uint64_t input_qpc = slots[slot].input_qpc;
+                if (slots[slot].via_copy)
+                {
+                    upload_slot_to_tex(slot);
+                    present_tex_slot_now(slot);
+                    last_srv = ring_srv[slot].Get();
+                }
+                else
+                {
+                    unmap_slot(slot);
+                    present_srv_now(map_srv[slot].Get());
+                    ctx->CopyResource(keep_tex.Get(), map_tex[slot].Get());
+                    last_srv = keep_srv.Get();
+                    map_slot(slot);
+                }
+                record_latency(input_qpc);
 
                 {
                     std::lock_guard<std::mutex> lk(mtx);
@@ -698,12 +826,7 @@ public:
                     {
                         auto& s = slots[slot];
                         if (s.state == slot_t::state_t::presenting)
-                        {
-                            s.state = slot_t::state_t::clearing;
-                            ++s.generation;
-                            clear_q.push_back(slot);
-                            cv_clear.notify_one();
-                        }
+                            release_slot_locked(s);
                     }
                 }
             }
@@ -714,10 +837,8 @@ public:
     {
         shutting_down = false;
 
-        for (int i = 0; i < CLEAR_WORKERS; ++i)
-            clear_workers[i] = std::thread([this] { clear_loop_worker(); });
-
         present_worker = std::thread([this] { present_loop(); });
+        fox::thread_topology::instance().apply(present_worker, fox::thread_role::present, 0);
     }
 
     void stop_threads()
@@ -728,15 +849,10 @@ public:
         }
 
         cv_present.notify_all();
-        cv_clear.notify_all();
         cv_free.notify_all();
         cv_flush.notify_all();
 
         if (present_worker.joinable()) present_worker.join();
-
-        for (int i = 0; i < CLEAR_WORKERS; ++i)
-            if (clear_workers[i].joinable())
-                clear_workers[i].join();
     }
 
     bool has_free_slot_nolock() const noexcept
@@ -759,23 +875,8 @@ public:
 
         for (std::uint32_t i = 0; i < (std::uint32_t)slots.size(); ++i)
         {
-            auto& s = slots[i];
-            if (s.state == slot_t::state_t::free)
-            {
-                s.state = slot_t::state_t::acquired;
-
-                cpu_frame f{};
-                f.w = w;
-                f.h = h;
-                f.color_pitch_bytes  = s.color_pitch_bytes;
-                f.color_pitch_pixels = s.color_pitch_pixels;
-                f.color = s.color.data();
-                f.z_pitch = s.z_pitch;
-                f.z = s.z;
-                f.slot = i;
-                f.generation = s.generation;
-                return f;
-            }
+            if (slots[i].state == slot_t::state_t::free)
+                return frame_from_slot_locked(i);
         }
 
         return cpu_frame{};
@@ -790,28 +891,24 @@ public:
 
         for (std::uint32_t i = 0; i < (std::uint32_t)slots.size(); ++i)
         {
-            auto& s = slots[i];
-            if (s.state == slot_t::state_t::free)
-            {
-                s.state = slot_t::state_t::acquired;
-
-                cpu_frame f{};
-                f.w = w;
-                f.h = h;
-                f.color_pitch_bytes  = s.color_pitch_bytes;
-                f.color_pitch_pixels = s.color_pitch_pixels;
-                f.color = s.color.data();
-                f.z_pitch = s.z_pitch;
-                f.z = s.z;
-                f.slot = i;
-                f.generation = s.generation;
-                return f;
-            }
+            if (slots[i].state == slot_t::state_t::free)
+                return frame_from_slot_locked(i);
         }
 
+        try_fail_count.fetch_add(1, std::memory_order_relaxed);
         return cpu_frame{};
     }
 
+    void pace_frame() noexcept
+    {
+        if (!latency_waitable) return;
+
+        // Bounded, so a frame that never reached Present can't hold the loop for good
+        constexpr DWORD kPaceTimeoutMs = 100;
+        WaitForSingleObjectEx(latency_waitable, kPaceTimeoutMs, TRUE);
+        pace_qpc = qpc_now();
+    }
+
     void enqueue_present_latest(std::uint32_t slot, std::uint32_t gen) noexcept
     {
         std::lock_guard<std::mutex> lk(mtx);
@@ -834,12 +931,7 @@ public:
             {
                 auto& os = slots[old_slot];
                 if (os.state == slot_t::state_t::queued && os.generation == old_gen)
-                {
-                    os.state = slot_t::state_t::clearing;
-                    ++os.generation;
-                    clear_q.push_back(old_slot);
-                    cv_clear.notify_one();
-                }
+                    release_slot_locked(os);
             }
         }
 
@@ -852,12 +944,10 @@ public:
         cv_present.notify_one();
     }
 
-    void enqueue_recorded_latest(std::uint32_t rec_index) noexcept
+    void enqueue_recorded_latest_locked(std::uint32_t rec_index) noexcept
     {
-        std::lock_guard<std::mutex> lk(mtx);
-
         if (shutting_down) return;
-        if (rec_index >= rec_frames.size()) return;
+        if (rec_index >= record_frames_locked()) return;
 
         latest_rec_valid = true;
         latest_rec_index = rec_index;
@@ -867,6 +957,14 @@ public:
         cv_present.notify_one();
     }
 
+    void enqueue_present_again() noexcept
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (shutting_down) return;
+        repeat_requested = true;
+        cv_present.notify_one();
+    }
+
     void enqueue_backbuffer_clear(std::uint32_t rgba) noexcept
     {
         std::lock_guard<std::mutex> lk(mtx);
@@ -892,40 +990,42 @@ public:
         });
     }
 
-    void mark_slot_clearing_and_enqueue(std::uint32_t slot) noexcept
+    void release_slot_index_locked(std::uint32_t slot) noexcept
     {
         if (slot >= slots.size()) return;
         auto& s = slots[slot];
-        if (s.state == slot_t::state_t::clearing) return;
         if (s.state == slot_t::state_t::acquired || s.state == slot_t::state_t::queued || s.state == slot_t::state_t::presenting)
-        {
-            s.state = slot_t::state_t::clearing;
-            ++s.generation;
-            clear_q.push_back(slot);
-            cv_clear.notify_one();
-        }
+            release_slot_locked(s);
     }
 
     void record_begin_locked() noexcept
     {
-        rec_frames.clear();
-        rec_frames.shrink_to_fit();
-        recording = true;
+        player.reset();
+        recording = recorder.open(record_path.c_str(), w, h);
         playing = false;
         looping = false;
         play_cursor = 0;
         latest_rec_valid = false;
     }
 
-    void record_end_locked() noexcept
+    bool record_end_locked() noexcept
     {
+        const bool ok = recorder.close();
         recording = false;
         play_cursor = 0;
+        return ok;
     }
 
     void playback_start_locked(bool loop) noexcept
     {
-        if (rec_frames.empty())
+        if (!player && !recording)
+        {
+            auto pl = std::make_shared<frame_player>();
+            if (pl->open(record_path.c_str()))
+                player = std::move(pl);
+        }
+
+        if (recording || !player || player->frame_count() == 0)
         {
             playing = false;
             looping = false;
@@ -948,10 +1048,11 @@ public:
 
     bool playback_present_next_nolock() noexcept
     {
-        if (rec_frames.empty())
+        const std::uint32_t frame_count = record_frames_locked();
+        if (frame_count == 0)
             return false;
 
-        if (play_cursor >= (std::uint32_t)rec_frames.size())
+        if (play_cursor >= frame_count)
         {
             if (!looping)
             {
@@ -962,7 +1063,7 @@ public:
         }
 
         const std::uint32_t idx = play_cursor++;
-        enqueue_recorded_latest(idx);
+        enqueue_recorded_latest_locked(idx);
         return true;
     }
 
@@ -972,14 +1073,24 @@ public:
 
         imgui_hook::instance().shutdown();
 
+        for (std::uint32_t i = 0; i < (std::uint32_t)slots.size(); ++i)
+            if (zero_copy) unmap_slot(i);
+
         for (auto& s : slots)
         {
             if (s.z) { _aligned_free(s.z); s.z = nullptr; }
             s.color.clear();
             s.color.shrink_to_fit();
+            track_slot(s);
         }
 
         slots.clear();
+        last_srv = nullptr;
+        keep_srv.Reset();
+        keep_tex.Reset();
+        map_srv.clear();
+        map_tex.clear();
+        zero_copy = false;
         ring_srv.clear();
         ring_tex.clear();
         rtvs.clear();
@@ -988,6 +1099,10 @@ public:
         ps.Reset();
         vs.Reset();
 
+        if (latency_waitable) { CloseHandle(latency_waitable); latency_waitable = nullptr; }
+        low_latency = false;
+        pace_qpc = 0;
+
         sc3.Reset();
         sc1.Reset();
         factory2.Reset();
@@ -1004,7 +1119,6 @@ public:
             std::lock_guard<std::mutex> lk(mtx);
             latest_slot_valid = false;
             latest_rec_valid = false;
-            clear_q.clear();
             bb_q.clear();
             flush_marker_requested = 0;
             flush_marker_done = 0;
@@ -1015,10 +1129,18 @@ public:
             playing = false;
             looping = false;
             play_cursor = 0;
-            rec_pitch_bytes = 0;
-            rec_pitch_pixels = 0;
-            rec_frames.clear();
+
+            latency = {};
+            latency_window_qpc = 0;
+            latency_window_peak = 0.0;
+        }
+        try_fail_count.store(0, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> rk(record_mtx);
+            (void)recorder.close();
         }
+        player.reset();
 
         ui_last_qpc = 0;
         ui_qpc_freq = 0;
@@ -1041,6 +1163,8 @@ namespace fox
         s.hwnd = (HWND)params.hwnd;
         s.w = params.width;
         s.h = params.height;
+        s.low_latency = params.low_latency;
+        s.qpc_f = qpc_freq();
 
         s.create_device();
         s.create_swapchain();
@@ -1049,11 +1173,9 @@ namespace fox
         s.compile_shaders();
         s.set_pipeline();
 
+        s.zero_copy = params.zero_copy;
         s.create_ring(params.ring_size);
 
-        for (std::uint32_t i = 0; i < s.ring_size; ++i)
-            s.clear_slot_cpu(i);
-
         imgui_hook::instance().init((void*)params.hwnd, s.dev.Get(), s.ctx.Get());
 
         s.start_threads();
@@ -1081,6 +1203,26 @@ namespace fox
         return p_->acquire_slot_try();
     }
 
+    bool gfx_dx11::low_latency() const noexcept
+    {
+        return p_ && p_->low_latency;
+    }
+
+    void gfx_dx11::pace_frame() noexcept
+    {
+        if (!p_) return;
+        p_->pace_frame();
+    }
+
+    present_latency_stats gfx_dx11::latency_stats() const noexcept
+    {
+        if (!p_) return {};
+        std::lock_guard<std::mutex> lk(p_->mtx);
+        present_latency_stats st = p_->latency;
+        st.failed_acquires = p_->try_fail_count.load(std::memory_order_relaxed);
+        return st;
+    }
+
     void gfx_dx11::present(const cpu_frame& frame) noexcept
     {
         if (!p_) return;
@@ -1088,6 +1230,12 @@ namespace fox
         p_->enqueue_present_latest(frame.slot, frame.generation);
     }
 
+    void gfx_dx11::present_again() noexcept
+    {
+        if (!p_) return;
+        p_->enqueue_present_again();
+    }
+
     void gfx_dx11::flush() noexcept
     {
         if (!p_) return;
@@ -1108,24 +1256,32 @@ namespace fox
 
         std::uint32_t pending = 0;
         pending += (std::uint32_t)p_->bb_q.size();
-        pending += (std::uint32_t)p_->clear_q.size();
         if (p_->latest_slot_valid) ++pending;
         if (p_->latest_rec_valid) ++pending;
 
         for (auto& s : p_->slots)
         {
             if (s.state == pimpl::slot_t::state_t::queued ||
-                s.state == pimpl::slot_t::state_t::presenting ||
-                s.state == pimpl::slot_t::state_t::clearing)
+                s.state == pimpl::slot_t::state_t::presenting)
                 ++pending;
         }
         return pending;
     }
 
-    void gfx_dx11::record_begin() noexcept
+    void gfx_dx11::record_begin(const char* path) noexcept
     {
         if (!p_) return;
+        {
+            std::lock_guard<std::mutex> lk(p_->mtx);
+            p_->playback_stop_locked();
+        }
+
+        // The capture file is rewritten in place, so the present thread must have let go of the player
+        p_->flush_blocking();
+
+        std::lock_guard<std::mutex> rk(p_->record_mtx);
         std::lock_guard<std::mutex> lk(p_->mtx);
+        p_->record_path = (path && *path) ? path : pimpl::kDefaultRecordPath;
         p_->record_begin_locked();
     }
 
@@ -1134,30 +1290,37 @@ namespace fox
         if (!p_) return;
         if (!frame.valid()) return;
 
+        {
+            // record_end cannot close the recorder under this submit
+            std::lock_guard<std::mutex> rk(p_->record_mtx);
+            {
+                std::lock_guard<std::mutex> lk(p_->mtx);
+                if (!p_->recording) return;
+            }
+            p_->recorder.submit(frame.color, frame.color_pitch_pixels);
+        }
+
         {
             std::lock_guard<std::mutex> lk(p_->mtx);
-            if (!p_->recording) return;
-            p_->copy_frame_to_recording(frame);
-            p_->mark_slot_clearing_and_enqueue(frame.slot);
+            p_->release_slot_index_locked(frame.slot);
         }
 
         p_->cv_present.notify_one();
-        p_->cv_clear.notify_all();
-        p_->cv_free.notify_one();
     }
 
-    void gfx_dx11::record_end() noexcept
+    bool gfx_dx11::record_end() noexcept
     {
-        if (!p_) return;
+        if (!p_) return true;
+        std::lock_guard<std::mutex> rk(p_->record_mtx);
         std::lock_guard<std::mutex> lk(p_->mtx);
-        p_->record_end_locked();
+        return p_->record_end_locked();
     }
 
     std::uint32_t gfx_dx11::record_frame_count() const noexcept
     {
         if (!p_) return 0;
         std::lock_guard<std::mutex> lk(p_->mtx);
-        return (std::uint32_t)p_->rec_frames.size();
+        return p_->record_frames_locked();
     }
 
     void gfx_dx11::playback_start(bool loop) noexcept
@@ -1208,7 +1371,7 @@ namespace fox
         st.recording = p_->recording;
         st.playing   = p_->playing;
         st.looping   = p_->looping;
-        st.frame_count = (std::uint32_t)p_->rec_frames.size();
+        st.frame_count = p_->record_frames_locked();
         st.cursor = p_->play_cursor;
         return st;
     }
@@ -0,0 +1,531 @@
+#include "optimized/gif_writer.h"
+#include "optimized/frame_recorder.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "file_system.h"
+
+namespace
+{
+    constexpr std::size_t   kFramesPerEncoder = 2;  // queued or coded ahead of the writer, per encoder
+    constexpr std::uint32_t kMaxEncoders      = 8;
+    constexpr std::uint32_t kPaletteSize      = 256;
+    constexpr std::uint32_t kBins             = 1u << 15; // 5 bits per channel
+    constexpr std::uint32_t kMinCodeSize      = 8;
+    constexpr std::uint32_t kClearCode        = 1u << kMinCodeSize;
+    constexpr std::uint32_t kEndCode          = kClearCode + 1u;
+    constexpr std::uint32_t kMaxCode          = 4095;
+    constexpr int           kHashBits         = 13;       // twice the codes, so probes stay short
+    constexpr std::uint32_t kNoKey            = 0xFFFFFFFFu;
+
+    [[nodiscard]] inline std::uint32_t bin_of(int r, int g, int b) noexcept
+    {
+        return ((std::uint32_t)r >> 3) << 10 | ((std::uint32_t)g >> 3) << 5 | ((std::uint32_t)b >> 3);
+    }
+
+    inline void put_u16(std::vector<std::uint8_t>& out, std::uint32_t v)
+    {
+        out.push_back((std::uint8_t)(v & 0xFFu));
+        out.push_back((std::uint8_t)(v >> 8));
+    }
+
+    // One encoder thread's scratch. Frames are quantized by median cut over a 5:5:5 histogram, mapped
+    // through a per bin nearest colour table filled as bins are first met, and LZW coded.
+    class frame_encoder
+    {
+    public:
+        // Codes a w x h frame, red in the low byte, as a graphic control extension, an image
+        // descriptor with its local colour table and the image data
+        void encode(const std::uint32_t* px, std::uint32_t w, std::uint32_t h, const fox::gif_settings& settings,
+                    std::vector<std::uint8_t>& out)
+        {
+            const std::size_t n = (std::size_t)w * h;
+            build_palette(px, n);
+            indices_.resize(n);
+            if (settings.dither)
+                map_dithered(px, w, h);
+            else
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    const std::uint32_t c = px[i];
+                    indices_[i] = nearest(bin_of((int)(c & 0xFFu), (int)((c >> 8) & 0xFFu), (int)((c >> 16) & 0xFFu)));
+                }
+
+            out.clear();
+            const std::uint8_t gce[4] = { 0x21, 0xF9, 0x04, 0x04 }; // disposal: leave the frame in place
+            out.insert(out.end(), gce, gce + 4);
+            put_u16(out, settings.delay_cs);
+            out.push_back(0);
+            out.push_back(0);
+
+            out.push_back(0x2C);
+            put_u16(out, 0);
+            put_u16(out, 0);
+            put_u16(out, w);
+            put_u16(out, h);
+            out.push_back(0x87); // local colour table of 2^(7 + 1) entries
+            for (std::uint32_t i = 0; i < kPaletteSize; ++i)
+                out.insert(out.end(), palette_[i], palette_[i] + 3);
+
+            lzw(out);
+        }
+
+    private:
+        struct box
+        {
+            std::uint32_t begin = 0, end = 0; // range of used_
+            int axis = 0;                     // channel of the widest extent, 0 red
+            int extent = 0;
+        };
+
+        [[nodiscard]] static int channel(std::uint32_t bin, int axis) noexcept
+        {
+            return (int)((bin >> (10 - axis * 5)) & 31u);
+        }
+
+        void measure(box& b) const noexcept
+        {
+            int lo[3] = { 31, 31, 31 }, hi[3] = { 0, 0, 0 };
+            for (std::uint32_t i = b.begin; i < b.end; ++i)
+                for (int a = 0; a < 3; ++a)
+                {
+                    lo[a] = (std::min)(lo[a], channel(used_[i], a));
+                    hi[a] = (std::max)(hi[a], channel(used_[i], a));
+                }
+            b.axis = 0;
+            for (int a = 1; a < 3; ++a)
+                if (hi[a] - lo[a] > hi[b.axis] - lo[b.axis])
+                    b.axis = a;
+            b.extent = hi[b.axis] - lo[b.axis];
+        }
+
+        void build_palette(const std::uint32_t* px, std::size_t n)
+        {
+            count_.assign(kBins, 0u);
+            sum_.assign((std::size_t)kBins * 3u, 0u);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                const std::uint32_t c = px[i];
+                const std::uint32_t r = c & 0xFFu, g = (c >> 8) & 0xFFu, b = (c >> 16) & 0xFFu;
+                const std::uint32_t bin = bin_of((int)r, (int)g, (int)b);
+                ++count_[bin];
+                sum_[bin * 3u + 0] += r;
+                sum_[bin * 3u + 1] += g;
+                sum_[bin * 3u + 2] += b;
+            }
+            used_.clear();
+            for (std::uint32_t bin = 0; bin < kBins; ++bin)
+                if (count_[bin])
+                    used_.push_back(bin);
+
+            // Split the box of the widest extent at its population median until the palette is full
+            boxes_.clear();
+            boxes_.push_back(box{ 0, (std::uint32_t)used_.size() });
+            measure(boxes_[0]);
+            while (boxes_.size() < kPaletteSize)
+            {
+                std::size_t pick = boxes_.size();
+                for (std::size_t i = 0; i < boxes_.size(); ++i)
+                    if (boxes_[i].end - boxes_[i].begin >= 2 && (pick == boxes_.size() || boxes_[i].extent > boxes_[pick].extent))
+                        pick = i;
+                if (pick == boxes_.size()) break;
+
+                box b = boxes_[pick];
+                std::sort(used_.begin() + b.begin, used_.begin() + b.end,
+                          [&](std::uint32_t l, std::uint32_t r) { return channel(l, b.axis) < channel(r, b.axis); });
+                std::uint64_t total = 0;
+                for (std::uint32_t i = b.begin; i < b.end; ++i)
+                    total += count_[used_[i]];
+                std::uint64_t run = 0;
+                std::uint32_t mid = b.begin;
+                while (mid < b.end && run * 2u < total)
+                    run += count_[used_[mid++]];
+                mid = std::clamp(mid, b.begin + 1u, b.end - 1u);
+
+                box lo{ b.begin, mid }, hi{ mid, b.end };
+                measure(lo);
+                measure(hi);
+                boxes_[pick] = lo;
+                boxes_.push_back(hi);
+            }
+
+            std::memset(palette_, 0, sizeof(palette_));
+            palette_count_ = (std::uint32_t)boxes_.size();
+            for (std::uint32_t p = 0; p < palette_count_; ++p)
+            {
+                std::uint64_t c = 0, s[3]{};
+                for (std::uint32_t i = boxes_[p].begin; i < boxes_[p].end; ++i)
+                {
+                    const std::uint32_t bin = used_[i];
+                    c += count_[bin];
+                    for (int a = 0; a < 3; ++a)
+                        s[a] += sum_[bin * 3u + (std::uint32_t)a];
+                }
+                for (int a = 0; a < 3; ++a)
+                    palette_[p][a] = c ? (std::uint8_t)((s[a] + c / 2u) / c) : 0u;
+            }
+            palette_count_ = (std::max)(palette_count_, 1u);
+            lut_.assign(kBins, -1);
+        }
+
+        [[nodiscard]] std::uint8_t nearest(std::uint32_t bin) noexcept
+        {
+            if (lut_[bin] >= 0) return (std::uint8_t)lut_[bin];
+
+            const int r = (channel(bin, 0) << 3) | 4;
+            const int g = (channel(bin, 1) << 3) | 4;
+            const int b = (channel(bin, 2) << 3) | 4;
+            std::uint32_t best = 0;
+            int best_d = 0x7FFFFFFF;
+            for (std::uint32_t p = 0; p < palette_count_; ++p)
+            {
+                const int dr = r - palette_[p][0], dg = g - palette_[p][1], db = b - palette_[p][2];
+                const int d = dr * dr + dg * dg + db * db;
+                if (d < best_d)
+                {
+                    best_d = d;
+                    best = p;
+                }
+            }
+            lut_[bin] = (std::int16_t)best;
+            return (std::uint8_t)best;
+        }
+
+        // Floyd-Steinberg, errors kept in sixteenths over two rows padded by a pixel each side
+        void map_dithered(const std::uint32_t* px, std::uint32_t w, std::uint32_t h)
+        {
+            const std::size_t row = ((std::size_t)w + 2u) * 3u;
+            err_.assign(row * 2u, 0);
+            for (std::uint32_t y = 0; y < h; ++y)
+            {
+                int* cur = err_.data() + (y & 1u) * row;
+                int* nxt = err_.data() + ((y + 1u) & 1u) * row;
+                std::fill(nxt, nxt + row, 0);
+
+                for (std::uint32_t x = 0; x < w; ++x)
+                {
+                    const std::uint32_t c = px[(std::size_t)y * w + x];
+                    int v[3];
+                    for (int a = 0; a < 3; ++a)
+                        v[a] = std::clamp((int)((c >> (a * 8)) & 0xFFu) + cur[(x + 1u) * 3u + (std::uint32_t)a] / 16, 0, 255);
+
+                    const std::uint8_t idx = nearest(bin_of(v[0], v[1], v[2]));
+                    indices_[(std::size_t)y * w + x] = idx;
+                    for (int a = 0; a < 3; ++a)
+                    {
+                        const int e = v[a] - palette_[idx][a];
+                        cur[(x + 2u) * 3u + (std::uint32_t)a] += e * 7;
+                        nxt[(x + 0u) * 3u + (std::uint32_t)a] += e * 3;
+                        nxt[(x + 1u) * 3u + (std::uint32_t)a] += e * 5;
+                        nxt[(x + 2u) * 3u + (std::uint32_t)a] += e;
+                    }
+                }
+            }
+        }
+
+        void reset_codes() noexcept
+        {
+            std::fill(hash_key_.begin(), hash_key_.end(), kNoKey);
+        }
+
+        // Variable width LZW from 9 to 12 bits, a clear code once the table fills, in 255 byte sub-blocks
+        void lzw(std::vector<std::uint8_t>& out)
+        {
+            hash_key_.resize(1u << kHashBits);
+            hash_code_.resize(1u << kHashBits);
+            reset_codes();
+            packed_.clear();
+
+            std::uint32_t acc = 0;
+            int bits = 0;
+            const auto put = [&](std::uint32_t code, std::uint32_t size)
+            {
+                acc |= code << bits;
+                bits += (int)size;
+                while (bits >= 8)
+                {
+                    packed_.push_back((std::uint8_t)(acc & 0xFFu));
+                    acc >>= 8;
+                    bits -= 8;
+                }
+            };
+
+            std::uint32_t size = kMinCodeSize + 1u;
+            std::uint32_t last_code = kEndCode;
+            put(kClearCode, size);
+
+            std::uint32_t prefix = indices_.empty() ? 0u : indices_[0];
+            for (std::size_t i = 1; i < indices_.size(); ++i)
+            {
+                const std::uint32_t key = (prefix << 8) | indices_[i];
+                std::uint32_t slot = (key * 2654435761u) >> (32 - kHashBits);
+                while (hash_key_[slot] != kNoKey && hash_key_[slot] != key)
+                    slot = (slot + 1u) & ((1u << kHashBits) - 1u);
+                if (hash_key_[slot] == key)
+                {
+                    prefix = hash_code_[slot];
+                    continue;
+                }
+
+                put(prefix, size);
+                hash_key_[slot] = key;
+                hash_code_[slot] = (std::uint16_t)++last_code;
+                if (last_code >= (1u << size))
+                    ++size;
+                if (last_code == kMaxCode)
+                {
+                    put(kClearCode, size);
+                    reset_codes();
+                    size = kMinCodeSize + 1u;
+                    last_code = kEndCode;
+                }
+                prefix = indices_[i];
+            }
+            put(prefix, size);
+            put(kEndCode, size);
+            if (bits > 0)
+                packed_.push_back((std::uint8_t)(acc & 0xFFu));
+
+            out.push_back((std::uint8_t)kMinCodeSize);
+            for (std::size_t at = 0; at < packed_.size(); at += 255u)
+            {
+                const std::size_t len = (std::min)(packed_.size() - at, (std::size_t)255u);
+                out.push_back((std::uint8_t)len);
+                out.insert(out.end(), packed_.begin() + (std::ptrdiff_t)at, packed_.begin() + (std::ptrdiff_t)(at + len));
+            }
+            out.push_back(0);
+        }
+
+        std::vector<std::uint32_t> count_{};
+        std::vector<std::uint32_t> sum_{};  // r, g, b per bin
+        std::vector<std::uint32_t> used_{}; // bins with a count, sorted within each box as it splits
+        std::vector<box> boxes_{};
+        std::vector<std::int16_t> lut_{};   // palette index per bin, -1 until first looked up
+        std::uint8_t  palette_[kPaletteSize][3]{};
+        std::uint32_t palette_count_ = 1;
+
+        std::vector<std::uint8_t> indices_{};
+        std::vector<int> err_{};
+        std::vector<std::uint32_t> hash_key_{};
+        std::vector<std::uint16_t> hash_code_{};
+        std::vector<std::uint8_t> packed_{};
+    };
+}
+
+class fox::gif_writer::impl
+{
+public:
+    struct job
+    {
+        std::vector<std::uint32_t> pixels;
+        std::vector<std::uint8_t> bytes;
+        bool coded = false;
+    };
+
+    FileSystem file;
+    gif_settings settings{};
+    std::uint32_t w = 0, h = 0;
+    std::vector<std::thread> encoders;
+    std::thread writer;
+
+    std::mutex mtx;
+    std::condition_variable cv_code;  // encoders: a frame to code, or closing
+    std::condition_variable cv_write; // writer: the oldest frame is coded, or closing
+    std::condition_variable cv_space; // submit: room for another frame
+    std::deque<job*> to_code;                  // oldest first
+    std::deque<std::unique_ptr<job>> in_order; // every frame not yet written, oldest first
+    std::vector<std::unique_ptr<job>> pool;    // written frames, buffers kept for reuse
+    std::size_t capacity = 0;
+    std::uint32_t submitted = 0;
+    bool closing = false;
+    bool write_failed = false;
+
+    void encoder_loop() noexcept
+    {
+        frame_encoder enc;
+        for (;;)
+        {
+            job* j = nullptr;
+            {
+                std::unique_lock<std::mutex> lk(mtx);
+                cv_code.wait(lk, [&] { return closing || !to_code.empty(); });
+                if (to_code.empty())
+                    return;
+                j = to_code.front();
+                to_code.pop_front();
+            }
+
+            enc.encode(j->pixels.data(), w, h, settings, j->bytes);
+
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                j->coded = true;
+            }
+            cv_write.notify_one();
+        }
+    }
+
+    void writer_loop() noexcept
+    {
+        bool failed = false;
+        for (;;)
+        {
+            std::unique_ptr<job> j;
+            {
+                std::unique_lock<std::mutex> lk(mtx);
+                cv_write.wait(lk, [&] { return (!in_order.empty() && in_order.front()->coded) || (closing && in_order.empty()); });
+                if (in_order.empty())
+                    break;
+                j = std::move(in_order.front());
+                in_order.pop_front();
+            }
+
+            failed = failed || !file.WriteBytes(j->bytes.data(), j->bytes.size());
+
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                j->coded = false;
+                pool.push_back(std::move(j));
+            }
+            cv_space.notify_one();
+        }
+
+        const std::uint8_t trailer = 0x3B;
+        failed = failed || !file.WriteBytes(&trailer, 1);
+        std::lock_guard<std::mutex> lk(mtx);
+        write_failed = failed;
+    }
+};
+
+fox::gif_writer::gif_writer() : p_(std::make_unique<impl>()) {}
+fox::gif_writer::~gif_writer() { close(); }
+
+bool fox::gif_writer::open(const char* path, std::uint32_t w, std::uint32_t h, const gif_settings& settings) noexcept
+{
+    close();
+    auto& s = *p_;
+    s.submitted = 0;
+    s.write_failed = false;
+    if (!path || !w || !h || w > 0xFFFFu || h > 0xFFFFu) return false;
+
+    if (!s.file.OpenForWrite(path)) return false;
+
+    // Header, a logical screen with no global colour table, and the loop forever extension
+    std::vector<std::uint8_t> hdr{ 'G', 'I', 'F', '8', '9', 'a' };
+    put_u16(hdr, w);
+    put_u16(hdr, h);
+    hdr.insert(hdr.end(), { 0x70, 0x00, 0x00 });
+    hdr.insert(hdr.end(), { 0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0', 0x03, 0x01, 0x00, 0x00, 0x00 });
+    if (!s.file.WriteBytes(hdr.data(), hdr.size()))
+    {
+        s.file.Close();
+        return false;
+    }
+
+    std::uint32_t n = settings.encoders;
+    if (n == 0)
+        n = (std::max)(1u, std::thread::hardware_concurrency() / 2u);
+    n = (std::min)(n, kMaxEncoders);
+
+    s.settings = settings;
+    s.w = w;
+    s.h = h;
+    s.closing = false;
+    s.capacity = (std::size_t)n * kFramesPerEncoder;
+    for (std::uint32_t i = 0; i < n; ++i)
+        s.encoders.emplace_back([&s] { s.encoder_loop(); });
+    s.writer = std::thread([&s] { s.writer_loop(); });
+    return true;
+}
+
+void fox::gif_writer::submit(const std::uint32_t* color, std::uint32_t pitch_pixels) noexcept
+{
+    auto& s = *p_;
+    if (!color || !s.writer.joinable()) return;
+
+    std::unique_ptr<impl::job> j;
+    {
+        std::unique_lock<std::mutex> lk(s.mtx);
+        s.cv_space.wait(lk, [&] { return s.in_order.size() < s.capacity; });
+        if (!s.pool.empty())
+        {
+            j = std::move(s.pool.back());
+            s.pool.pop_back();
+        }
+    }
+    if (!j)
+        j = std::make_unique<impl::job>();
+
+    j->pixels.resize((std::size_t)s.w * s.h);
+    for (std::uint32_t y = 0; y < s.h; ++y)
+        std::memcpy(j->pixels.data() + (std::size_t)y * s.w, color + (std::size_t)y * pitch_pixels, (std::size_t)s.w * 4u);
+
+    {
+        std::lock_guard<std::mutex> lk(s.mtx);
+        s.to_code.push_back(j.get());
+        s.in_order.push_back(std::move(j));
+        ++s.submitted;
+    }
+    s.cv_code.notify_one();
+}
+
+void fox::gif_writer::close() noexcept
+{
+    if (!p_) return;
+    auto& s = *p_;
+    if (!s.writer.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lk(s.mtx);
+        s.closing = true;
+    }
+    s.cv_code.notify_all();
+    for (std::thread& t : s.encoders)
+        t.join();
+    s.encoders.clear();
+
+    s.cv_write.notify_all();
+    s.writer.join();
+    s.file.Close();
+    s.pool.clear();
+    s.pool.shrink_to_fit();
+}
+
+bool fox::gif_writer::is_open() const noexcept { return p_ && p_->writer.joinable(); }
+
+std::uint32_t fox::gif_writer::frame_count() const noexcept
+{
+    if (!p_) return 0;
+    std::lock_guard<std::mutex> lk(p_->mtx);
+    return p_->submitted;
+}
+
+bool fox::gif_writer::failed() const noexcept
+{
+    if (!p_) return false;
+    std::lock_guard<std::mutex> lk(p_->mtx);
+    return p_->write_failed;
+}
+
+bool fox::export_capture_gif(const char* capture_path, const char* gif_path, const gif_settings& settings, std::uint32_t step) noexcept
+{
+    frame_player player;
+    if (!player.open(capture_path) || player.frame_count() == 0) return false;
+
+    gif_writer gif;
+    if (!gif.open(gif_path, player.width(), player.height(), settings)) return false;
+
+    // The player decodes ahead on its own thread while the encoders work through earlier frames
+    step = (std::max)(step, 1u);
+    for (std::uint32_t i = 0; i < player.frame_count(); i += step)
+        gif.submit(player.acquire(i), player.width());
+
+    gif.close();
+    return !gif.failed();
+}
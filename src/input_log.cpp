@@ -0,0 +1,265 @@
+#include "optimized/input_log.h"
+
+#include <bit>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "file_system.h"
+
+namespace
+{
+    constexpr std::uint32_t kMagic      = 0x4E495846u; // "FXIN"
+    constexpr std::uint32_t kVersion    = 1;
+    constexpr std::size_t   kFlushBytes = 64u * 1024u;
+    constexpr std::uint32_t kMaxToggles = 32;          // past this a frame stores the whole key mask
+
+    // Which fields follow a frame's mask byte and delta time, in this order
+    constexpr std::uint8_t kKeyToggles = 1u << 0;      // count byte, then that many virtual keys
+    constexpr std::uint8_t kKeyMask    = 1u << 1;      // all 256 key bits
+    constexpr std::uint8_t kMousePos   = 1u << 2;
+    constexpr std::uint8_t kWheel      = 1u << 3;
+    constexpr std::uint8_t kMouseDelta = 1u << 4;
+    constexpr std::uint8_t kButtons    = 1u << 5;      // two bits per button
+    constexpr std::uint8_t kKnownMask  = (1u << 6) - 1u;
+
+    struct file_header
+    {
+        std::uint32_t magic = kMagic;
+        std::uint32_t version = kVersion;
+        std::uint32_t reserved[2]{};
+    };
+
+    template <class T>
+    inline void put(std::vector<std::uint8_t>& out, const T& v)
+    {
+        const std::size_t at = out.size();
+        out.resize(at + sizeof(T));
+        std::memcpy(out.data() + at, &v, sizeof(T));
+    }
+
+    [[nodiscard]] inline std::uint8_t pack_buttons(const fox::mouse_button_state (&b)[3]) noexcept
+    {
+        return (std::uint8_t)((std::uint32_t)b[0] | (std::uint32_t)b[1] << 2 | (std::uint32_t)b[2] << 4);
+    }
+
+    // Bounds checked reads over the mapped log
+    struct byte_reader
+    {
+        const std::uint8_t* at = nullptr;
+        const std::uint8_t* end = nullptr;
+
+        template <class T>
+        [[nodiscard]] bool get(T& v) noexcept
+        {
+            if ((std::size_t)(end - at) < sizeof(T)) return false;
+            std::memcpy(&v, at, sizeof(T));
+            at += sizeof(T);
+            return true;
+        }
+    };
+}
+
+#pragma region input_recorder
+
+namespace fox
+{
+    class input_recorder::impl
+    {
+    public:
+        FileSystem file;
+        std::vector<std::uint8_t> buffer;
+        input_state last{};
+        std::uint32_t frames = 0;
+        bool open = false;
+
+        void flush() noexcept
+        {
+            if (!buffer.empty() && file.IsOpen())
+                (void)file.WriteBytes(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+
+        void put_keys(const input_state& s, std::uint32_t toggles)
+        {
+            if (toggles > kMaxToggles)
+            {
+                for (std::uint32_t w = 0; w < 4; ++w)
+                    put(buffer, s.keys[w]);
+                return;
+            }
+            put(buffer, (std::uint8_t)toggles);
+            for (std::uint32_t w = 0; w < 4; ++w)
+                for (std::uint64_t diff = s.keys[w] ^ last.keys[w]; diff; diff &= diff - 1u)
+                    put(buffer, (std::uint8_t)(w * 64u + (std::uint32_t)std::countr_zero(diff)));
+        }
+    };
+
+    input_recorder::input_recorder() : p_(std::make_unique<impl>()) {}
+    input_recorder::~input_recorder() { close(); }
+
+    bool input_recorder::open(const char* path) noexcept
+    {
+        close();
+        if (!path || !p_->file.OpenForWrite(path)) return false;
+
+        const file_header hdr{};
+        if (!p_->file.WriteBytes(&hdr, sizeof(hdr)))
+        {
+            p_->file.Close();
+            return false;
+        }
+        p_->buffer.reserve(kFlushBytes + 256u);
+        p_->last = {};
+        p_->frames = 0;
+        p_->open = true;
+        return true;
+    }
+
+    void input_recorder::record(const input_state& s, float dt) noexcept
+    {
+        if (!p_->open) return;
+        impl& r = *p_;
+
+        std::uint32_t toggles = 0;
+        for (std::uint32_t w = 0; w < 4; ++w)
+            toggles += (std::uint32_t)std::popcount(s.keys[w] ^ r.last.keys[w]);
+
+        std::uint8_t mask = 0;
+        if (toggles)                                                           mask |= toggles > kMaxToggles ? kKeyMask : kKeyToggles;
+        if (s.mouse_x != r.last.mouse_x || s.mouse_y != r.last.mouse_y)        mask |= kMousePos;
+        if (s.wheel != r.last.wheel)                                           mask |= kWheel;
+        if (s.mouse_dx != r.last.mouse_dx || s.mouse_dy != r.last.mouse_dy)    mask |= kMouseDelta;
+        if (pack_buttons(s.buttons) != pack_buttons(r.last.buttons))           mask |= kButtons;
+
+        put(r.buffer, mask);
+        put(r.buffer, dt);
+        if (mask & (kKeyToggles | kKeyMask)) r.put_keys(s, toggles);
+        if (mask & kMousePos)   { put(r.buffer, s.mouse_x);  put(r.buffer, s.mouse_y); }
+        if (mask & kWheel)        put(r.buffer, s.wheel);
+        if (mask & kMouseDelta) { put(r.buffer, s.mouse_dx); put(r.buffer, s.mouse_dy); }
+        if (mask & kButtons)      put(r.buffer, pack_buttons(s.buttons));
+
+        r.last = s;
+        ++r.frames;
+        if (r.buffer.size() >= kFlushBytes)
+            r.flush();
+    }
+
+    void input_recorder::close() noexcept
+    {
+        if (!p_ || !p_->open) return;
+        p_->flush();
+        p_->file.Close();
+        p_->open = false;
+    }
+
+    bool input_recorder::is_open() const noexcept { return p_->open; }
+    std::uint32_t input_recorder::frame_count() const noexcept { return p_->frames; }
+}
+
+#pragma endregion
+
+#pragma region input_player
+
+namespace fox
+{
+    class input_player::impl
+    {
+    public:
+        FileSystem file;
+        byte_reader in{};
+        input_state state{};
+        std::uint32_t frames = 0;
+        bool open = false;
+
+        [[nodiscard]] bool read_frame(float& dt) noexcept
+        {
+            std::uint8_t mask = 0;
+            if (!in.get(mask) || (mask & ~kKnownMask) || !in.get(dt)) return false;
+
+            input_state s = state;
+            if (mask & kKeyToggles)
+            {
+                std::uint8_t n = 0;
+                if (!in.get(n)) return false;
+                for (std::uint8_t i = 0; i < n; ++i)
+                {
+                    std::uint8_t k = 0;
+                    if (!in.get(k)) return false;
+                    s.keys[k >> 6] ^= 1ull << (k & 63u);
+                }
+            }
+            if (mask & kKeyMask)
+                for (std::uint32_t w = 0; w < 4; ++w)
+                    if (!in.get(s.keys[w])) return false;
+            if ((mask & kMousePos) && !(in.get(s.mouse_x) && in.get(s.mouse_y))) return false;
+            if ((mask & kWheel) && !in.get(s.wheel)) return false;
+            if ((mask & kMouseDelta) && !(in.get(s.mouse_dx) && in.get(s.mouse_dy))) return false;
+            if (mask & kButtons)
+            {
+                std::uint8_t b = 0;
+                if (!in.get(b)) return false;
+                for (std::uint32_t i = 0; i < 3; ++i)
+                {
+                    const std::uint32_t v = (b >> (i * 2u)) & 3u;
+                    if (v > (std::uint32_t)mouse_button_state::pressed) return false;
+                    s.buttons[i] = (mouse_button_state)v;
+                }
+            }
+            state = s;
+            return true;
+        }
+    };
+
+    input_player::input_player() : p_(std::make_unique<impl>()) {}
+    input_player::~input_player() { close(); }
+
+    bool input_player::open(const char* path) noexcept
+    {
+        close();
+        if (!path || !p_->file.MapForRead(path)) return false;
+
+        const std::uint8_t* data = p_->file.GetMappedData();
+        const std::uint64_t size = p_->file.GetFileSize();
+        file_header hdr{};
+        if (!data || size < sizeof(hdr))
+        {
+            p_->file.Close();
+            return false;
+        }
+        std::memcpy(&hdr, data, sizeof(hdr));
+        if (hdr.magic != kMagic || hdr.version != kVersion)
+        {
+            p_->file.Close();
+            return false;
+        }
+
+        p_->in = { data + sizeof(hdr), data + size };
+        p_->state = {};
+        p_->frames = 0;
+        p_->open = true;
+        return true;
+    }
+
+    void input_player::close() noexcept
+    {
+        if (!p_ || !p_->open) return;
+        p_->file.Close();
+        p_->in = {};
+        p_->open = false;
+    }
+
+    bool input_player::next(input_state& state, float& dt) noexcept
+    {
+        if (!p_->open || !p_->read_frame(dt)) return false;
+        state = p_->state;
+        ++p_->frames;
+        return true;
+    }
+
+    bool input_player::is_open() const noexcept { return p_->open; }
+    std::uint32_t input_player::frame_count() const noexcept { return p_->frames; }
+}
+
+#pragma endregion
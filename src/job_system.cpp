@@ -0,0 +1,250 @@
+#include "optimized/job_system.h"
+#include "optimized/thread_topology.h"
+
+#include <algorithm>
+
+#ifdef USE_SIMD
+#include <immintrin.h>
+#endif
+
+namespace fox
+{
+    namespace
+    {
+        constexpr int kSpinsBeforeSleep = 256;
+
+        // Deque slot of the current thread, -1 for outside threads past kMaxExternalThreads
+        thread_local int t_local_index = -1;
+        thread_local bool t_local_resolved = false;
+
+        inline void cpu_relax() noexcept
+        {
+#ifdef USE_SIMD
+            _mm_pause();
+#else
+            std::this_thread::yield();
+#endif
+        }
+    }
+
+    bool job_system::work_deque::push(task* t) noexcept
+    {
+        const std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+        const std::int64_t top = m_top.load(std::memory_order_acquire);
+        if (b - top >= kCapacity)
+            return false;
+
+        m_buffer[b & (kCapacity - 1)].store(t, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    job_system::task* job_system::work_deque::pop() noexcept
+    {
+        const std::int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > b)
+        {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        task* t = m_buffer[b & (kCapacity - 1)].load(std::memory_order_relaxed);
+        if (top == b)
+        {
+            // Last item, race against thieves for it
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                t = nullptr;
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return t;
+    }
+
+    job_system::task* job_system::work_deque::steal() noexcept
+    {
+        std::int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = m_bottom.load(std::memory_order_acquire);
+        if (top >= b)
+            return nullptr;
+
+        task* t = m_buffer[top & (kCapacity - 1)].load(std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return t;
+    }
+
+    job_system& job_system::instance() noexcept
+    {
+        static job_system g;
+        return g;
+    }
+
+    job_system::job_system() noexcept
+    {
+        const unsigned hw = std::thread::hardware_concurrency();
+        m_thread_count = (std::max)(1u, hw);
+        m_deque_count = kMaxExternalThreads + m_thread_count - 1;
+        m_deques = std::make_unique<work_deque[]>(m_deque_count);
+        m_task_stacks = std::make_unique<task_stack[]>(m_deque_count);
+
+        // Outside threads claim slots 0..kMaxExternalThreads-1 as they first submit, workers take the rest
+        // Each worker is placed as thread_topology lays workers out, in the order they start
+        const thread_topology& topo = thread_topology::instance();
+        m_threads.reserve(m_thread_count - 1);
+        for (std::uint32_t i = kMaxExternalThreads; i < m_deque_count; ++i)
+        {
+            m_threads.emplace_back([this, i]() { worker_loop(i); });
+            topo.apply(m_threads.back(), thread_role::worker, i - kMaxExternalThreads);
+        }
+    }
+
+    job_system::~job_system()
+    {
+        m_shutdown.store(true, std::memory_order_release);
+        m_work_epoch.fetch_add(1, std::memory_order_release);
+        m_work_epoch.notify_all();
+
+        for (auto& t : m_threads)
+        {
+            if (t.joinable())
+                t.join();
+        }
+    }
+
+    int job_system::acquire_local_index() noexcept
+    {
+        if (!t_local_resolved)
+        {
+            const std::uint32_t slot = m_external_claimed.fetch_add(1, std::memory_order_acq_rel);
+            if (slot < kMaxExternalThreads)
+                t_local_index = (int)slot;
+            t_local_resolved = true;
+        }
+        return t_local_index;
+    }
+
+    void job_system::execute(task* t) noexcept
+    {
+        t->fn(t->ctx, t->begin, t->end);
+        t->remaining->fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    job_system::task* job_system::find_task(std::uint32_t self) noexcept
+    {
+        if (task* t = m_deques[self].pop())
+            return t;
+
+        for (std::uint32_t i = 1; i < m_deque_count; ++i)
+        {
+            const std::uint32_t victim = (self + i) % m_deque_count;
+            if (task* t = m_deques[victim].steal())
+                return t;
+        }
+        return nullptr;
+    }
+
+    void job_system::run(std::uint32_t count, std::uint32_t grain, range_fn fn, void* ctx) noexcept
+    {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+
+        const int local = acquire_local_index();
+        const std::uint32_t task_count = (count + grain - 1) / grain;
+
+        if (local < 0 || task_count == 1 || m_thread_count == 1)
+        {
+            for (std::uint32_t b = 0; b < count; b += grain)
+                fn(ctx, b, (std::min)(b + grain, count));
+            return;
+        }
+
+        // Tasks come off the slot's stack and go back once the batch is done; a batch too large for
+        // what is left of it takes a heap block instead
+        task_stack& stack = m_task_stacks[(std::size_t)local];
+        const std::uint32_t stack_base = stack.top;
+        std::vector<task> overflow{};
+        task* tasks = nullptr;
+        if (task_count <= task_stack::kCapacity - stack_base)
+        {
+            tasks = stack.tasks + stack_base;
+            stack.top = stack_base + task_count;
+        }
+        else
+        {
+            overflow.resize(task_count);
+            tasks = overflow.data();
+        }
+        std::atomic<std::uint32_t> remaining{ task_count };
+
+        work_deque& dq = m_deques[(std::size_t)local];
+        std::uint32_t pushed = 0;
+        for (std::uint32_t i = 0; i < task_count; ++i)
+        {
+            task& t = tasks[i];
+            t.fn = fn;
+            t.ctx = ctx;
+            t.begin = i * grain;
+            t.end = (std::min)(t.begin + grain, count);
+            t.remaining = &remaining;
+
+            if (dq.push(&t))
+                ++pushed;
+            else
+                execute(&t);
+
+            if (pushed == 1 || (pushed & 31u) == 0)
+            {
+                m_work_epoch.fetch_add(1, std::memory_order_release);
+                m_work_epoch.notify_all();
+            }
+        }
+
+        m_work_epoch.fetch_add(1, std::memory_order_release);
+        m_work_epoch.notify_all();
+
+        // Help until our batch is done, running whatever is reachable in the meantime
+        while (remaining.load(std::memory_order_acquire) != 0)
+        {
+            if (task* t = find_task((std::uint32_t)local))
+                execute(t);
+            else
+                cpu_relax();
+        }
+        stack.top = stack_base;
+    }
+
+    void job_system::worker_loop(std::uint32_t index) noexcept
+    {
+        t_local_index = (int)index;
+        t_local_resolved = true;
+
+        int idle_spins = 0;
+        for (;;)
+        {
+            const std::uint32_t epoch = m_work_epoch.load(std::memory_order_acquire);
+            if (m_shutdown.load(std::memory_order_acquire))
+                return;
+
+            if (task* t = find_task(index))
+            {
+                execute(t);
+                idle_spins = 0;
+                continue;
+            }
+
+            if (++idle_spins < kSpinsBeforeSleep)
+            {
+                cpu_relax();
+                continue;
+            }
+
+            idle_spins = 0;
+            m_work_epoch.wait(epoch, std::memory_order_acquire);
+        }
+    }
+}
@@ -0,0 +1,440 @@
+#include "json_document.h"
+#include "file_system.h"
+
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <system_error>
+
+namespace
+{
+    inline bool IsJsonSpace(char c) noexcept
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // from_chars takes neither leading whitespace nor '+', which values written by hand may have
+    inline std::string_view TrimNumber(std::string_view s) noexcept
+    {
+        while (!s.empty() && IsJsonSpace(s.front()))
+            s.remove_prefix(1);
+        if (!s.empty() && s.front() == '+')
+            s.remove_prefix(1);
+        return s;
+    }
+
+    template<typename T>
+    inline bool ParseNumber(std::string_view s, T& out) noexcept
+    {
+        s = TrimNumber(s);
+        if (s.empty())
+            return false;
+        const auto result = std::from_chars(s.data(), s.data() + s.size(), out);
+        return result.ec == std::errc{};
+    }
+
+    inline bool EqualsNoCase(std::string_view a, const char* b) noexcept
+    {
+        const std::size_t n = std::strlen(b);
+        if (a.size() != n)
+            return false;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (std::tolower(static_cast<unsigned char>(a[i])) != b[i])
+                return false;
+        }
+        return true;
+    }
+
+    // Appends code point cp as UTF-8 at out, which never overtakes the escape being read
+    inline char* WriteUtf8(char* out, std::uint32_t cp) noexcept
+    {
+        if (cp < 0x80)
+        {
+            *out++ = static_cast<char>(cp);
+        }
+        else if (cp < 0x800)
+        {
+            *out++ = static_cast<char>(0xC0 | (cp >> 6));
+            *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+            *out++ = static_cast<char>(0xE0 | (cp >> 12));
+            *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            *out++ = static_cast<char>(0xF0 | (cp >> 18));
+            *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        return out;
+    }
+
+    // Four hex digits of a \u escape at p
+    inline bool ParseHex4(const char* p, const char* end, std::uint32_t& out) noexcept
+    {
+        if (end - p < 4)
+            return false;
+        const auto result = std::from_chars(p, p + 4, out, 16);
+        return result.ec == std::errc{} && result.ptr == p + 4;
+    }
+}
+
+#pragma region JsonDocument
+
+bool JsonDocument::Load(const std::string& filePath)
+{
+    Clear();
+
+    FileSystem file{};
+    if (!file.OpenForRead(filePath))
+        return false;
+
+    const std::uint64_t fileSize = file.GetFileSize();
+    if (fileSize == 0ULL)
+        return false;
+
+    std::string content(fileSize, '\0');
+    if (!file.ReadBytes(content.data(), fileSize))
+        return false;
+    file.Close();
+
+    return Parse(std::move(content));
+}
+
+bool JsonDocument::Parse(std::string buffer)
+{
+    Clear();
+    m_buffer = std::move(buffer);
+    m_cur = m_buffer.data();
+    m_end = m_cur + m_buffer.size();
+
+    Node* root = AllocateNode();
+    SkipWhitespace();
+    if (!ParseValue(*root, 0))
+    {
+        Clear();
+        return false;
+    }
+
+    // Only whitespace may follow the root value
+    SkipWhitespace();
+    if (m_cur != m_end)
+    {
+        Clear();
+        return false;
+    }
+
+    m_root = root;
+    return true;
+}
+
+JsonValue JsonDocument::Root() const noexcept
+{
+    return JsonValue(m_root);
+}
+
+void JsonDocument::Clear() noexcept
+{
+    m_buffer.clear();
+    m_blocks.clear();
+    m_blockUsed = kNodesPerBlock;
+    m_nodeCount = 0;
+    m_root = nullptr;
+    m_cur = nullptr;
+    m_end = nullptr;
+}
+
+JsonDocument::Node* JsonDocument::AllocateNode()
+{
+    if (m_blockUsed == kNodesPerBlock)
+    {
+        m_blocks.emplace_back(std::make_unique<Node[]>(kNodesPerBlock));
+        m_blockUsed = 0;
+    }
+    ++m_nodeCount;
+    return &m_blocks.back()[m_blockUsed++];
+}
+
+void JsonDocument::SkipWhitespace() noexcept
+{
+    while (m_cur < m_end && IsJsonSpace(*m_cur))
+        ++m_cur;
+}
+
+bool JsonDocument::ParseValue(Node& node, int depth)
+{
+    if (m_cur >= m_end || depth > kMaxDepth)
+        return false;
+
+    switch (*m_cur)
+    {
+    case '{':
+        node.kind = Kind::Object;
+        return ParseObject(node, depth);
+    case '[':
+        node.kind = Kind::Array;
+        return ParseArray(node, depth);
+    case '"':
+        node.kind = Kind::String;
+        return ParseString(node.text);
+    default:
+        node.kind = Kind::Literal;
+        if (!ParseLiteral(node.text))
+            return false;
+        if (node.text == "null")
+            node.kind = Kind::Null;
+        return true;
+    }
+}
+
+bool JsonDocument::ParseObject(Node& node, int depth)
+{
+    ++m_cur; // '{'
+    Node* last = nullptr;
+
+    SkipWhitespace();
+    if (m_cur < m_end && *m_cur == '}')
+    {
+        ++m_cur;
+        return true;
+    }
+
+    while (m_cur < m_end)
+    {
+        Node* child = AllocateNode();
+        if (*m_cur != '"' || !ParseString(child->key))
+            return false;
+
+        SkipWhitespace();
+        if (m_cur >= m_end || *m_cur != ':')
+            return false;
+        ++m_cur;
+
+        SkipWhitespace();
+        if (!ParseValue(*child, depth + 1))
+            return false;
+
+        if (last)
+            last->next = child;
+        else
+            node.firstChild = child;
+        last = child;
+        ++node.childCount;
+
+        SkipWhitespace();
+        if (m_cur >= m_end)
+            return false;
+        if (*m_cur == '}')
+        {
+            ++m_cur;
+            return true;
+        }
+        if (*m_cur != ',')
+            return false;
+        ++m_cur;
+        SkipWhitespace();
+
+        // A trailing comma before the brace is accepted, as the stream parser always did
+        if (m_cur < m_end && *m_cur == '}')
+        {
+            ++m_cur;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JsonDocument::ParseArray(Node& node, int depth)
+{
+    ++m_cur; // '['
+    Node* last = nullptr;
+
+    SkipWhitespace();
+    if (m_cur < m_end && *m_cur == ']')
+    {
+        ++m_cur;
+        return true;
+    }
+
+    while (m_cur < m_end)
+    {
+        Node* child = AllocateNode();
+        if (!ParseValue(*child, depth + 1))
+            return false;
+
+        if (last)
+            last->next = child;
+        else
+            node.firstChild = child;
+        last = child;
+        ++node.childCount;
+
+        SkipWhitespace();
+        if (m_cur >= m_end)
+            return false;
+        if (*m_cur == ']')
+        {
+            ++m_cur;
+            return true;
+        }
+        if (*m_cur != ',')
+            return false;
+        ++m_cur;
+        SkipWhitespace();
+
+        // Trailing comma, same as objects
+        if (m_cur < m_end && *m_cur == ']')
+        {
+            ++m_cur;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JsonDocument::ParseString(std::string_view& out)
+{
+    ++m_cur; // opening quote
+    char* const begin = m_cur;
+
+    // Fast path: no escapes, the view is the buffer as is
+    char* p = begin;
+    while (p < m_end && *p != '"' && *p != '\\')
+        ++p;
+    if (p >= m_end)
+        return false;
+
+    // Escapes only ever shrink, so they are decoded in place behind the read cursor
+    char* write = p;
+    while (p < m_end && *p != '"')
+    {
+        if (*p != '\\')
+        {
+            *write++ = *p++;
+            continue;
+        }
+
+        if (++p >= m_end)
+            return false;
+        switch (*p++)
+        {
+        case '"':  *write++ = '"';  break;
+        case '\\': *write++ = '\\'; break;
+        case '/':  *write++ = '/';  break;
+        case 'b':  *write++ = '\b'; break;
+        case 'f':  *write++ = '\f'; break;
+        case 'n':  *write++ = '\n'; break;
+        case 'r':  *write++ = '\r'; break;
+        case 't':  *write++ = '\t'; break;
+        case 'u':
+        {
+            std::uint32_t cp = 0;
+            if (!ParseHex4(p, m_end, cp))
+                return false;
+            p += 4;
+
+            // A high surrogate followed by an escaped low one is a single code point past the BMP
+            std::uint32_t low = 0;
+            if (cp >= 0xD800 && cp < 0xDC00 && m_end - p >= 6 && p[0] == '\\' && p[1] == 'u' &&
+                ParseHex4(p + 2, m_end, low) && low >= 0xDC00 && low < 0xE000)
+            {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                p += 6;
+            }
+            write = WriteUtf8(write, cp);
+            break;
+        }
+        default:
+            // Unknown escape, keep as-is
+            *write++ = p[-1];
+            break;
+        }
+    }
+    if (p >= m_end)
+        return false;
+
+    out = std::string_view(begin, static_cast<std::size_t>(write - begin));
+    m_cur = p + 1;
+    return true;
+}
+
+bool JsonDocument::ParseLiteral(std::string_view& out)
+{
+    char* const begin = m_cur;
+    while (m_cur < m_end && !IsJsonSpace(*m_cur) && *m_cur != ',' && *m_cur != '}' && *m_cur != ']')
+        ++m_cur;
+
+    if (m_cur == begin)
+        return false;
+    out = std::string_view(begin, static_cast<std::size_t>(m_cur - begin));
+    return true;
+}
+
+#pragma endregion
+
+#pragma region JsonValue
+
+JsonValue JsonValue::operator[](std::string_view key) const noexcept
+{
+    if (!m_node || m_node->kind != JsonDocument::Kind::Object)
+        return {};
+
+    for (const JsonDocument::Node* child = m_node->firstChild; child; child = child->next)
+    {
+        if (child->key == key)
+            return JsonValue(child);
+    }
+    return {};
+}
+
+float JsonValue::AsFloat(float defaultValue) const noexcept
+{
+    float value = 0.0f;
+    return IsValid() && ParseNumber(m_node->text, value) ? value : defaultValue;
+}
+
+double JsonValue::AsDouble(double defaultValue) const noexcept
+{
+    double value = 0.0;
+    return IsValid() && ParseNumber(m_node->text, value) ? value : defaultValue;
+}
+
+int JsonValue::AsInt(int defaultValue) const noexcept
+{
+    int value = 0;
+    return IsValid() && ParseNumber(m_node->text, value) ? value : defaultValue;
+}
+
+std::uint32_t JsonValue::AsUInt(std::uint32_t defaultValue) const noexcept
+{
+    // Negative values wrap, as the stoi based JsonLoader::AsUInt did
+    long long value = 0;
+    return IsValid() && ParseNumber(m_node->text, value) ? static_cast<std::uint32_t>(value) : defaultValue;
+}
+
+std::uint64_t JsonValue::AsUInt64(std::uint64_t defaultValue) const noexcept
+{
+    std::uint64_t value = 0;
+    return IsValid() && ParseNumber(m_node->text, value) ? value : defaultValue;
+}
+
+bool JsonValue::AsBool(bool defaultValue) const noexcept
+{
+    if (!IsValid())
+        return defaultValue;
+
+    const std::string_view val = m_node->text;
+    if (EqualsNoCase(val, "true") || val == "1")
+        return true;
+    if (EqualsNoCase(val, "false") || val == "0")
+        return false;
+
+    return defaultValue;
+}
+
+#pragma endregion
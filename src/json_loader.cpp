@@ -4,6 +4,7 @@
 #include <cctype>
 #include <sstream>
 #include <iostream>
+#include <iterator>
 
 namespace
 {
@@ -18,29 +19,9 @@ void JsonLoader::Load(const std::string& filePath)
 {
     Clear();
 
-    if (!m_fileSystem.OpenForRead(filePath))
-    {
-        return;
-    }
-
-    const std::uint64_t fileSize = m_fileSystem.GetFileSize();
-    if (fileSize == 0ULL)
-    {
-        m_fileSystem.Close();
-        return;
-    }
-
-    std::string content(fileSize, '\0');
-    if (!m_fileSystem.ReadBytes(content.data(), fileSize))
-    {
-        m_fileSystem.Close();
-        return;
-    }
-
-    m_fileSystem.Close();
-
-    std::istringstream iss(content);
-    FromStream(iss);
+    JsonDocument document;
+    if (document.Load(filePath))
+        FromDocument(document.Root());
 }
 
 void JsonLoader::Save(const std::string& filepath)
@@ -100,30 +81,33 @@ void JsonLoader::FromStream(std::istream& input)
 {
     Clear();
 
-    SkipWhitespace(input);
+    std::string content{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+    JsonDocument document;
+    if (document.Parse(std::move(content)))
+        FromDocument(document.Root());
+}
 
-    if (input.peek() == '{')
-    {
-        ParseObject(input);
-    }
-    else if (input.peek() == '"')
-    {
-        m_value = ReadQuotedString(input);
-    }
-    else
+void JsonLoader::FromDocument(const JsonValue& value)
+{
+    Clear();
+
+    if (value.IsObject() || value.IsArray())
     {
-        std::string token;
-        while (input.good())
+        // Array elements come in keyed by index, as objects of this tree are written
+        std::size_t index = 0;
+        m_children.reserve(value.Size());
+        for (const auto& [key, child] : value)
         {
-            char c = static_cast<char>(input.peek());
-            if (std::isspace(static_cast<unsigned char>(c)) || c == ',' || c == '}' || c == EOF)
-                break;
-
-            input.get(c);
-            token.push_back(c);
+            const std::string name = value.IsArray() ? std::to_string(index) : std::string(key);
+            ++index;
+            // First of duplicate keys wins, as in JsonValue lookups
+            if (const auto [it, inserted] = m_children.try_emplace(name); inserted)
+                it->second.FromDocument(child);
         }
-        m_value = token;
+        return;
     }
+
+    m_value = value.GetString();
 }
 
 float JsonLoader::AsFloat(float defaultValue) const
@@ -229,76 +213,6 @@ void JsonLoader::Serialize(std::ostream& output, int indent) const
     }
 }
 
-void JsonLoader::SkipWhitespace(std::istream& input)
-{
-    while (input.good() && std::isspace(static_cast<unsigned char>(input.peek())))
-    {
-        input.get();
-    }
-}
-
-bool JsonLoader::ConsumeChar(std::istream& input, char expected)
-{
-    if (!input.good())
-        return false;
-
-    const int c = input.get();
-    if (c != expected)
-    {
-        return false;
-    }
-    return true;
-}
-
-std::string JsonLoader::ReadQuotedString(std::istream& input)
-{
-    SkipWhitespace(input);
-
-    if (!ConsumeChar(input, '"'))
-    {
-        return {};
-    }
-
-    std::string result;
-    while (input.good())
-    {
-        char c = static_cast<char>(input.get());
-        if (c == '"')
-        {
-            break;
-        }
-
-        if (c == '\\')
-        {
-            if (!input.good())
-                break;
-
-            char esc = static_cast<char>(input.get());
-            switch (esc)
-            {
-            case '"':  result.push_back('"');  break;
-            case '\\': result.push_back('\\'); break;
-            case '/':  result.push_back('/');  break;
-            case 'b':  result.push_back('\b'); break;
-            case 'f':  result.push_back('\f'); break;
-            case 'n':  result.push_back('\n'); break;
-            case 'r':  result.push_back('\r'); break;
-            case 't':  result.push_back('\t'); break;
-            default:
-                // Unknown escape, keep as-is
-                result.push_back(esc);
-                break;
-            }
-        }
-        else
-        {
-            result.push_back(c);
-        }
-    }
-
-    return result;
-}
-
 std::string JsonLoader::EscapeString(const std::string& s)
 {
     std::string escaped;
@@ -323,81 +237,3 @@ std::string JsonLoader::EscapeString(const std::string& s)
 
     return escaped;
 }
-
-void JsonLoader::ParseObject(std::istream& input)
-{
-    SkipWhitespace(input);
-
-    if (!ConsumeChar(input, '{'))
-        return;
-
-    while (true)
-    {
-        SkipWhitespace(input);
-
-        if (input.peek() == '}')
-        {
-            input.get();
-            break;
-        }
-
-        std::string key = ReadQuotedString(input);
-        if (key.empty() && !input.good())
-        {
-            return;
-        }
-
-        SkipWhitespace(input);
-        if (!ConsumeChar(input, ':'))
-        {
-            return;
-        }
-
-        SkipWhitespace(input);
-
-        JsonLoader child;
-
-        if (input.peek() == '{')
-        {
-            child.ParseObject(input);
-        }
-        else if (input.peek() == '"')
-        {
-            child.m_value = ReadQuotedString(input);
-        }
-        else
-        {
-            std::string token;
-            while (input.good())
-            {
-                char c = static_cast<char>(input.peek());
-                if (std::isspace(static_cast<unsigned char>(c)) ||
-                    c == ',' || c == '}' || c == EOF)
-                    break;
-
-                input.get(c);
-                token.push_back(c);
-            }
-            child.m_value = token;
-        }
-
-        m_children.emplace(std::move(key), std::move(child));
-
-        SkipWhitespace(input);
-        const int next = input.peek();
-        if (next == ',')
-        {
-            input.get();
-            continue;
-        }
-        else if (next == '}')
-        {
-            continue;
-        }
-        else
-        {
-            input.good();
-            break;
-        }
-    }
-}
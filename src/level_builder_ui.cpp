@@ -181,7 +181,111 @@ namespace fox
             ImGui::Text("Textures");
             ImGui::Checkbox("Render Textures", &render_state_.textures_enabled);
             ImGui::Checkbox("Flip V", &render_state_.flip_v);
-            ImGui::Text("Cached textures: %zu", debug_state_.cached_texture_count);
+            ImGui::Text("Cached textures: %zu (%.1f MB)", debug_state_.cached_texture_count,
+                        (double)debug_state_.texture_resident_bytes / (1024.0 * 1024.0));
+            ImGui::SliderInt("Texture Budget (MB)", &render_state_.texture_budget_mb, 0, 2048);
+            ImGui::Checkbox("Compress New Textures (BC1)", &render_state_.compressed_textures);
+            if (debug_state_.streaming_asset_count > 0)
+                ImGui::Text("Streaming assets: %zu", debug_state_.streaming_asset_count);
+            ImGui::Separator();
+            ImGui::Text("World Streaming");
+            ImGui::Checkbox("Stream Cells", &render_state_.streaming.enabled);
+            ImGui::SliderFloat("Cell Size", &render_state_.streaming.cell_size, 8.0f, 512.0f, "%.0f");
+            ImGui::SliderFloat("Load Radius", &render_state_.streaming.load_radius, 0.0f, 2048.0f, "%.0f");
+            ImGui::SliderFloat("Unload Radius", &render_state_.streaming.unload_radius, 0.0f, 2048.0f, "%.0f");
+            ImGui::SliderInt("Mesh Budget (MB)", &render_state_.streaming_budget_mb, 0, 4096);
+            {
+                const world_streaming_stats& ws = debug_state_.streaming;
+                ImGui::Text("Cells: %u loaded of %u, objects %zu in, %zu out", ws.loaded_cells, ws.cells,
+                            ws.resident_objects, ws.streamed_out_objects);
+                ImGui::Text("Cell loads %llu, unloads %llu (%llu over budget), freed %.1f MB",
+                            (unsigned long long)ws.cell_loads, (unsigned long long)ws.cell_unloads,
+                            (unsigned long long)ws.budget_unloads, (double)ws.released_bytes / (1024.0 * 1024.0));
+            }
+            ImGui::Separator();
+            ImGui::Text("Memory Budgets (soft, hard MB; 0 for none)");
+            for (std::size_t t = 0; t < kMemTagCount; ++t)
+                ImGui::SliderInt2(mem_tag_name((mem_tag)t), render_state_.memory_budget_mb[t], 0, 8192);
+            ImGui::Separator();
+            ImGui::Text("Raster");
+            ImGui::Checkbox("Hierarchical Z", &render_state_.hierarchical_z);
+            ImGui::Checkbox("Frustum Culling", &render_state_.frustum_culling);
+            ImGui::Checkbox("Occlusion Culling", &render_state_.occlusion_culling);
+            ImGui::Checkbox("Cluster Culling", &render_state_.cluster_culling);
+            ImGui::Checkbox("Front To Back", &render_state_.sort_front_to_back);
+            ImGui::Checkbox("Wide Raster", &render_state_.wide_raster);
+            ImGui::SameLine();
+            ImGui::Text("(%s)", debug_state_.raster_isa);
+            ImGui::Checkbox("Visibility Buffer", &render_state_.visibility_buffer);
+            ImGui::Checkbox("Depth Pre-Pass", &render_state_.depth_prepass);
+            ImGui::Checkbox("Mesh LOD", &render_state_.mesh_lod);
+            ImGui::Checkbox("Quantize New Meshes", &render_state_.quantized_meshes);
+            ImGui::Checkbox("Sun Shadows", &render_state_.shadows);
+            if (render_state_.shadows)
+            {
+                ImGui::SliderFloat("Shadow Strength", &render_state_.shadow_strength, 0.0f, 1.0f, "%.2f");
+                ImGui::SliderFloat("Shadow Distance", &render_state_.shadow_distance, 8.0f, 512.0f, "%.0f");
+            }
+            ImGui::Checkbox("Point Lights", &render_state_.point_lights);
+            if (render_state_.point_lights)
+            {
+                ImGui::SliderInt("Lanterns", &render_state_.lanterns.count, 0, (int)optimized_renderer_core::kMaxLights);
+                ImGui::SliderFloat("Lantern Spread", &render_state_.lanterns.spread, 1.0f, 400.0f, "%.0f");
+                ImGui::SliderFloat("Lantern Radius", &render_state_.lanterns.radius, 0.5f, 64.0f, "%.1f");
+                ImGui::SliderFloat("Lantern Intensity", &render_state_.lanterns.intensity, 0.0f, 8.0f, "%.2f");
+                ImGui::SliderFloat("Lantern Flicker", &render_state_.lanterns.flicker, 0.0f, 1.0f, "%.2f");
+            }
+            ImGui::Checkbox("16-bit Depth", &render_state_.depth16);
+            ImGui::Checkbox("Frame Pipelining", &render_state_.frame_pipelining);
+            ImGui::Checkbox("Incremental Redraw", &render_state_.incremental_redraw);
+            ImGui::Checkbox("Checkerboard", &render_state_.checkerboard);
+
+            using debug_view = optimized_renderer_core::debug_view;
+            const char* view_names[optimized_renderer_core::kDebugViewCount]{};
+            for (std::size_t i = 0; i < optimized_renderer_core::kDebugViewCount; ++i)
+                view_names[i] = optimized_renderer_core::debug_view_name((debug_view)i);
+            int view = (int)render_state_.debug_view;
+            if (ImGui::Combo("Debug View", &view, view_names, (int)optimized_renderer_core::kDebugViewCount))
+                render_state_.debug_view = (debug_view)view;
+            switch (render_state_.debug_view)
+            {
+            case debug_view::overdraw:
+                ImGui::Text("Depth tests per pixel: blue 1 .. red %u+", optimized_renderer_core::kOverdrawHeatMax);
+                break;
+            case debug_view::tile_cost:
+                ImGui::Text("Slowest tile: %.3f ms (red)", debug_state_.frame_stats.tile_cost_max_ms);
+                break;
+            case debug_view::triangle_density:
+                ImGui::Text("Triangles per pixel: blue 1/256 .. red 1+");
+                break;
+            default:
+                break;
+            }
+            ImGui::Separator();
+            ImGui::Text("Resolution");
+            ImGui::Checkbox("Dynamic Resolution", &render_state_.dynamic_resolution);
+            if (render_state_.dynamic_resolution)
+                ImGui::SliderFloat("Target ms", &render_state_.target_frame_ms, 4.0f, 50.0f, "%.1f");
+            else
+                ImGui::SliderFloat("Render Scale", &render_state_.render_scale, 0.25f, 1.0f, "%.2f");
+            ImGui::Text("Current scale: %.2f", debug_state_.render_scale);
+            ImGui::Text("Entities: %u (culled %u, occluded %u)", debug_state_.draw_stats.entities_total,
+                debug_state_.draw_stats.entities_culled, debug_state_.draw_stats.entities_occluded);
+            ImGui::Text("Clusters: %u tested, %u culled", debug_state_.draw_stats.clusters_tested,
+                debug_state_.draw_stats.clusters_culled);
+            ImGui::Text("Triangles submitted: %u", debug_state_.draw_stats.triangles_submitted);
+            if (render_state_.incremental_redraw)
+                ImGui::Text("Tiles reused: %u", debug_state_.draw_stats.tiles_reused);
+            if (render_state_.checkerboard)
+                ImGui::Text("Checkerboard: %u reprojected, %u interpolated", debug_state_.draw_stats.pixels_reprojected,
+                            debug_state_.draw_stats.pixels_interpolated);
+            if (render_state_.shadows)
+                ImGui::Text("Shadow casters: %u cached%s, %u dynamic", debug_state_.draw_stats.shadow_casters,
+                            debug_state_.draw_stats.shadow_map_redrawn ? " (redrawn)" : "",
+                            debug_state_.draw_stats.shadow_dynamic_casters);
+            if (render_state_.point_lights)
+                ImGui::Text("Lights visible: %u in %u tile lists", debug_state_.draw_stats.lights_visible,
+                            debug_state_.draw_stats.light_tile_refs);
 
             world_callbacks_.write_debug_state(debug_state_);
             if (world_callbacks_.write_render_settings)
@@ -202,6 +306,7 @@ namespace fox
                     ImGui::Separator();
                     ImGui::Text("Post Processing");
                     ImGui::Checkbox("Enable Post FX", &render_state_.post_process.enabled);
+                    ImGui::Checkbox("Fused Post FX Sweep", &render_state_.fused_post_effects);
                     ImGui::Checkbox("Exposure Pass", &render_state_.post_process.exposure_enabled);
                     ImGui::SliderFloat("Exposure", &render_state_.post_process.exposure, 0.1f, 4.0f, "%.2f");
                     ImGui::Checkbox("Contrast Pass", &render_state_.post_process.contrast_enabled);
@@ -266,11 +371,64 @@ namespace fox
     void level_builder_ui::draw_runtime_ui()
     {
         runtime_imgui_wants_mouse_ = ImGui::GetIO().WantCaptureMouse;
+        draw_stats_view();
+        ImGui::Separator();
         draw_create_view();
         ImGui::Separator();
         draw_edit_save_view();
     }
 
+    void level_builder_ui::draw_stats_view()
+    {
+        if (!world_callbacks_.read_debug_state)
+            return;
+        world_callbacks_.read_debug_state(debug_state_);
+
+        constexpr double mb = 1.0 / (1024.0 * 1024.0);
+        const optimized_renderer_core::frame_stats& fs = debug_state_.frame_stats;
+
+        ImGui::Text("Frame Stats");
+        ImGui::Text("Frame %llu: %.2f ms", (unsigned long long)fs.frame_index, fs.frame_ms);
+        for (std::size_t p = 0; p < optimized_renderer_core::kFramePassCount; ++p)
+        {
+            ImGui::Text("  %-12s %6.2f ms", optimized_renderer_core::frame_pass_name((optimized_renderer_core::frame_pass)p), fs.pass_ms[p]);
+        }
+
+        // The last entry is the shared one for threads outside the job system
+        for (std::size_t w = 0; w < fs.worker_busy_ms.size(); ++w)
+        {
+            const double busy = fs.worker_busy_ms[w];
+            if (busy <= 0.0)
+                continue;
+            const double idle = (std::max)(0.0, fs.frame_ms - busy);
+            if (w + 1 < fs.worker_busy_ms.size())
+                ImGui::Text("  worker %zu: busy %.2f ms, idle %.2f ms", w, busy, idle);
+            else
+                ImGui::Text("  other: busy %.2f ms", busy);
+        }
+
+        const optimized_renderer_core::draw_stats& ds = fs.draw;
+        ImGui::Text("Triangles: %u submitted, %u culled, %u rasterized", ds.triangles_submitted, ds.triangles_culled, ds.triangles_rasterized);
+        ImGui::Text("Pixels: %llu depth tested, %llu shaded",
+                    (unsigned long long)fs.pixels_depth_tested, (unsigned long long)fs.pixels_shaded);
+        ImGui::Text("Memory");
+        for (std::size_t t = 0; t < kMemTagCount; ++t)
+        {
+            const mem_tag_stats& m = debug_state_.memory[t];
+            const char* over = m.state == mem_budget_state::hard ? ", over hard budget"
+                             : m.state == mem_budget_state::soft ? ", over soft budget" : "";
+            ImGui::Text("  %-9s %8.1f MB (peak %.1f MB, %llu allocations%s)", mem_tag_name((mem_tag)t),
+                        (double)m.live_bytes * mb, (double)m.peak_bytes * mb, (unsigned long long)m.allocations, over);
+        }
+        ImGui::Text("Frame heap allocations: %llu", (unsigned long long)fs.heap_allocations);
+        if (fs.latency.frames)
+            ImGui::Text("Input to present: %.2f ms (avg %.2f, peak %.2f)", fs.latency.last_ms, fs.latency.avg_ms, fs.latency.peak_ms);
+        ImGui::Text("Failed frame acquires: %llu", (unsigned long long)fs.latency.failed_acquires);
+
+        if (ImGui::Checkbox("Record Stats CSV", &debug_state_.stats_csv_recording) && world_callbacks_.write_debug_state)
+            world_callbacks_.write_debug_state(debug_state_);
+    }
+
     void level_builder_ui::draw_create_view()
     {
         ImGui::Text("Create Object");
@@ -369,21 +527,20 @@ namespace fox
 
     void level_builder_ui::draw_edit_save_view()
     {
-        runtime_objects_.clear();
-        if (render_queue_)
-            render_queue_->enumerate_objects(runtime_objects_);
+        static const std::vector<render_queue::object_info> kNoObjects;
+        const std::vector<render_queue::object_info>& runtime_objects = render_queue_ ? render_queue_->objects() : kNoObjects;
 
-        const auto selected_it = std::ranges::find_if(runtime_objects_, [&](const render_queue::object_info& v)
+        const auto selected_it = std::ranges::find_if(runtime_objects, [&](const render_queue::object_info& v)
         {
             return v.id == selected_runtime_object_id_;
         });
-        if (selected_it == runtime_objects_.end())
+        if (selected_it == runtime_objects.end())
             selected_runtime_object_id_ = 0;
 
         ImGui::Text("Edit / Save");
         ImGui::Text("Scene Objects");
         ImGui::BeginChild("scene_object_list", ImVec2(0, 200), true);
-        for (const auto& obj : runtime_objects_)
+        for (const auto& obj : runtime_objects)
         {
             std::string label = obj.name.empty() ? ("Object " + std::to_string(obj.id)) : obj.name;
             label += obj.is_dynamic ? " (Dynamic)" : " (Static)";
@@ -411,12 +568,12 @@ namespace fox
         ImGui::InputFloat("Rotate Snap (deg)", &runtime_rotate_snap_deg_);
         ImGui::InputFloat("Scale Snap", &runtime_scale_snap_);
 
-        const auto selected_edit_it = std::ranges::find_if(runtime_objects_, [&](const render_queue::object_info& v)
+        const auto selected_edit_it = std::ranges::find_if(runtime_objects, [&](const render_queue::object_info& v)
         {
             return v.id == selected_runtime_object_id_;
         });
 
-        if (selected_edit_it == runtime_objects_.end())
+        if (selected_edit_it == runtime_objects.end())
         {
             ImGui::TextDisabled("Select an object to edit transforms.");
         }
@@ -450,6 +607,12 @@ namespace fox
                 render_queue_->set_transform(selected->object_id, selected->position, selected->rotation, selected->scale);
             }
 
+            // Back for closed, consistently wound meshes; none draws both sides
+            static const char* const cull_names[] = { "None", "Back", "Front" };
+            int cull = (int)render_queue_->get_cull(selected->object_id);
+            if (ImGui::Combo("Cull", &cull, cull_names, (int)std::size(cull_names)))
+                render_queue_->set_cull(selected->object_id, (cull_mode)cull);
+
             bool is_dynamic = false;
             dynamic_mesh_component* dyn = nullptr;
             if (render_queue_)
@@ -510,11 +673,6 @@ namespace fox
 
     std::size_t level_builder_ui::object_count() const
     {
-        if (!render_queue_)
-            return 0;
-
-        std::vector<render_queue::object_info> objects;
-        render_queue_->enumerate_objects(objects);
-        return objects.size();
+        return render_queue_ ? render_queue_->object_count() : 0;
     }
 } // namespace fox
@@ -0,0 +1,97 @@
+#include "optimized/memory_stats.h"
+
+#include <atomic>
+
+namespace
+{
+    // One cache line per tag, so threads counting different subsystems do not share lines
+    struct alignas(64) tag_counters
+    {
+        std::atomic<std::uint64_t> live{ 0 };
+        std::atomic<std::uint64_t> peak{ 0 };
+        std::atomic<std::uint64_t> allocations{ 0 };
+        std::atomic<std::size_t>   soft{ 0 };
+        std::atomic<std::size_t>   hard{ 0 };
+    };
+
+    tag_counters g_tags[fox::kMemTagCount];
+
+    constexpr const char* kTagNames[fox::kMemTagCount] = {
+        "meshes", "skinned", "textures", "ecs", "gfx", "capture"
+    };
+
+    [[nodiscard]] inline tag_counters& counters(fox::mem_tag tag) noexcept
+    {
+        return g_tags[(std::size_t)tag % fox::kMemTagCount];
+    }
+
+    [[nodiscard]] fox::mem_budget_state state_of(std::uint64_t live, std::size_t soft, std::size_t hard) noexcept
+    {
+        if (hard && live > hard) return fox::mem_budget_state::hard;
+        if (soft && live > soft) return fox::mem_budget_state::soft;
+        return fox::mem_budget_state::ok;
+    }
+}
+
+namespace fox
+{
+    const char* mem_tag_name(mem_tag tag) noexcept
+    {
+        return (std::size_t)tag < kMemTagCount ? kTagNames[(std::size_t)tag] : "unknown";
+    }
+
+    void mem_track_alloc(mem_tag tag, std::size_t bytes) noexcept
+    {
+        if (!bytes) return;
+        tag_counters& c = counters(tag);
+        const std::uint64_t live = c.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        c.allocations.fetch_add(1, std::memory_order_relaxed);
+
+        std::uint64_t peak = c.peak.load(std::memory_order_relaxed);
+        while (live > peak && !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+
+    void mem_track_free(mem_tag tag, std::size_t bytes) noexcept
+    {
+        if (!bytes) return;
+        counters(tag).live.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    std::uint64_t mem_live_bytes(mem_tag tag) noexcept
+    {
+        return counters(tag).live.load(std::memory_order_relaxed);
+    }
+
+    mem_tag_stats mem_stats(mem_tag tag) noexcept
+    {
+        const tag_counters& c = counters(tag);
+        mem_tag_stats s{};
+        s.live_bytes = c.live.load(std::memory_order_relaxed);
+        s.peak_bytes = c.peak.load(std::memory_order_relaxed);
+        s.allocations = c.allocations.load(std::memory_order_relaxed);
+        s.budget.soft_bytes = c.soft.load(std::memory_order_relaxed);
+        s.budget.hard_bytes = c.hard.load(std::memory_order_relaxed);
+        s.state = state_of(s.live_bytes, s.budget.soft_bytes, s.budget.hard_bytes);
+        return s;
+    }
+
+    void set_mem_budget(mem_tag tag, const mem_budget& budget) noexcept
+    {
+        tag_counters& c = counters(tag);
+        c.soft.store(budget.soft_bytes, std::memory_order_relaxed);
+        c.hard.store(budget.hard_bytes, std::memory_order_relaxed);
+    }
+
+    mem_budget get_mem_budget(mem_tag tag) noexcept
+    {
+        const tag_counters& c = counters(tag);
+        return { c.soft.load(std::memory_order_relaxed), c.hard.load(std::memory_order_relaxed) };
+    }
+
+    mem_budget_state mem_budget_check(mem_tag tag) noexcept
+    {
+        const tag_counters& c = counters(tag);
+        return state_of(c.live.load(std::memory_order_relaxed),
+                        c.soft.load(std::memory_order_relaxed), c.hard.load(std::memory_order_relaxed));
+    }
+}
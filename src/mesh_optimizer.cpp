@@ -0,0 +1,652 @@
+#include "optimized/mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+namespace
+{
+    constexpr int kCacheSize = 32;
+    constexpr int kMaxValence = 64;
+
+    constexpr float kLastTriScore = 0.75f;
+    constexpr float kCacheDecayPower = 1.5f;
+    constexpr float kValenceBoostScale = 2.0f;
+    constexpr float kValenceBoostPower = 0.5f;
+
+    struct score_table
+    {
+        float cache[kCacheSize]{};
+        float valence[kMaxValence]{};
+
+        score_table() noexcept
+        {
+            for (int i = 0; i < kCacheSize; ++i)
+            {
+                if (i < 3)
+                {
+                    // The last triangle's corners score the same, so their order doesn't matter
+                    cache[i] = kLastTriScore;
+                }
+                else
+                {
+                    const float scaler = 1.f / (float)(kCacheSize - 3);
+                    cache[i] = std::pow(1.f - (float)(i - 3) * scaler, kCacheDecayPower);
+                }
+            }
+            for (int i = 0; i < kMaxValence; ++i)
+                valence[i] = (i == 0) ? 0.f : kValenceBoostScale * std::pow((float)i, -kValenceBoostPower);
+        }
+
+        [[nodiscard]] float score(int cache_pos, std::uint32_t remaining) const noexcept
+        {
+            if (remaining == 0) return -1.f;
+            float s = (cache_pos >= 0) ? cache[cache_pos] : 0.f;
+            s += valence[(std::min)(remaining, (std::uint32_t)kMaxValence - 1u)];
+            return s;
+        }
+    };
+
+    // Collapses that tilt a remaining triangle by more than ~75 degrees would fold the surface
+    constexpr double kMinNormalCos2 = 0.25 * 0.25;
+
+    // Sum of squared distances to a set of planes, symmetric 4x4 stored as its upper triangle
+    struct quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+        double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+        double a22 = 0.0, a23 = 0.0;
+        double a33 = 0.0;
+
+        void add_plane(double a, double b, double c, double d) noexcept
+        {
+            a00 += a * a; a01 += a * b; a02 += a * c; a03 += a * d;
+            a11 += b * b; a12 += b * c; a13 += b * d;
+            a22 += c * c; a23 += c * d;
+            a33 += d * d;
+        }
+
+        quadric& operator+=(const quadric& o) noexcept
+        {
+            a00 += o.a00; a01 += o.a01; a02 += o.a02; a03 += o.a03;
+            a11 += o.a11; a12 += o.a12; a13 += o.a13;
+            a22 += o.a22; a23 += o.a23;
+            a33 += o.a33;
+            return *this;
+        }
+
+        [[nodiscard]] double error(const float* p) const noexcept
+        {
+            const double x = p[0], y = p[1], z = p[2];
+            const double e =
+                a00 * x * x + 2.0 * (a01 * x * y + a02 * x * z + a03 * x) +
+                a11 * y * y + 2.0 * (a12 * y * z + a13 * y) +
+                a22 * z * z + 2.0 * a23 * z +
+                a33;
+            return (std::max)(e, 0.0);
+        }
+    };
+
+    // Candidate move of `from` onto `to`, stale once either vertex changes
+    struct collapse
+    {
+        double        cost = 0.0;
+        std::uint32_t from = 0;
+        std::uint32_t to = 0;
+        std::uint32_t from_stamp = 0;
+        std::uint32_t to_stamp = 0;
+
+        bool operator>(const collapse& o) const noexcept { return cost > o.cost; }
+    };
+
+    inline void tri_normal(const float* a, const float* b, const float* c, double n[3]) noexcept
+    {
+        const double e1[3] = { (double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2] };
+        const double e2[3] = { (double)c[0] - a[0], (double)c[1] - a[1], (double)c[2] - a[2] };
+        n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+}
+
+void optimize_vertex_cache(std::uint32_t* indices, std::uint32_t tri_count, std::uint32_t vertex_count) noexcept
+{
+    if (!indices || tri_count < 2 || vertex_count == 0) return;
+
+    static const score_table table{};
+    const std::size_t index_count = (std::size_t)tri_count * 3u;
+
+    // Vertex -> triangle adjacency, CSR
+    std::vector<std::uint32_t> adj_offset(vertex_count + 1u, 0u);
+    for (std::size_t i = 0; i < index_count; ++i)
+        ++adj_offset[indices[i] + 1u];
+    for (std::uint32_t v = 0; v < vertex_count; ++v)
+        adj_offset[v + 1u] += adj_offset[v];
+
+    std::vector<std::uint32_t> adj(index_count);
+    {
+        std::vector<std::uint32_t> cursor(adj_offset.begin(), adj_offset.end() - 1);
+        for (std::size_t i = 0; i < index_count; ++i)
+            adj[cursor[indices[i]]++] = (std::uint32_t)(i / 3u);
+    }
+
+    std::vector<std::uint32_t> remaining(vertex_count);
+    for (std::uint32_t v = 0; v < vertex_count; ++v)
+        remaining[v] = adj_offset[v + 1u] - adj_offset[v];
+
+    std::vector<int>   cache_pos(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (std::uint32_t v = 0; v < vertex_count; ++v)
+        vertex_score[v] = table.score(-1, remaining[v]);
+
+    std::vector<float> tri_score(tri_count);
+    for (std::uint32_t t = 0; t < tri_count; ++t)
+        tri_score[t] = vertex_score[indices[t * 3u + 0]] + vertex_score[indices[t * 3u + 1]] + vertex_score[indices[t * 3u + 2]];
+
+    std::vector<std::uint8_t> emitted(tri_count, 0u);
+    std::vector<std::uint32_t> out(index_count);
+
+    std::uint32_t cache[kCacheSize + 3];
+    int cache_count = 0;
+
+    std::uint32_t scan_cursor = 0;
+    std::uint32_t best = 0;
+    float best_score = tri_score[0];
+    for (std::uint32_t t = 1; t < tri_count; ++t)
+    {
+        if (tri_score[t] > best_score) { best_score = tri_score[t]; best = t; }
+    }
+
+    for (std::uint32_t emit = 0; emit < tri_count; ++emit)
+    {
+        if (best_score < 0.f)
+        {
+            // Nothing adjacent to the cache is left, restart from the next unused triangle
+            while (scan_cursor < tri_count && emitted[scan_cursor]) ++scan_cursor;
+            best = scan_cursor;
+        }
+
+        emitted[best] = 1u;
+        const std::uint32_t* tri = indices + (std::size_t)best * 3u;
+        out[(std::size_t)emit * 3u + 0] = tri[0];
+        out[(std::size_t)emit * 3u + 1] = tri[1];
+        out[(std::size_t)emit * 3u + 2] = tri[2];
+
+        // Push the triangle's corners to the front of the LRU, dropping duplicates
+        std::uint32_t next[kCacheSize + 3];
+        int next_count = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            const std::uint32_t v = tri[k];
+            if (k == 0 || v != next[0])
+            {
+                if (k < 2 || v != next[next_count - 1])
+                    next[next_count++] = v;
+            }
+
+            // Retire this triangle from the vertex's adjacency list
+            const std::uint32_t begin = adj_offset[v];
+            const std::uint32_t end = begin + remaining[v];
+            for (std::uint32_t a = begin; a < end; ++a)
+            {
+                if (adj[a] == best)
+                {
+                    std::swap(adj[a], adj[end - 1u]);
+                    break;
+                }
+            }
+            --remaining[v];
+        }
+        for (int c = 0; c < cache_count; ++c)
+        {
+            const std::uint32_t v = cache[c];
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                next[next_count++] = v;
+        }
+
+        for (int c = 0; c < next_count; ++c)
+            cache_pos[next[c]] = (c < kCacheSize) ? c : -1;
+
+        // Rescore vertices that moved in the cache and the triangles they still touch
+        best_score = -1.f;
+        for (int c = 0; c < next_count; ++c)
+        {
+            const std::uint32_t v = next[c];
+            vertex_score[v] = table.score(cache_pos[v], remaining[v]);
+
+            const std::uint32_t begin = adj_offset[v];
+            const std::uint32_t end = begin + remaining[v];
+            for (std::uint32_t a = begin; a < end; ++a)
+            {
+                const std::uint32_t t = adj[a];
+                const std::uint32_t* ti = indices + (std::size_t)t * 3u;
+                tri_score[t] = vertex_score[ti[0]] + vertex_score[ti[1]] + vertex_score[ti[2]];
+                if (tri_score[t] > best_score)
+                {
+                    best_score = tri_score[t];
+                    best = t;
+                }
+            }
+        }
+
+        cache_count = (std::min)(next_count, kCacheSize);
+        std::copy(next, next + cache_count, cache);
+    }
+
+    std::copy(out.begin(), out.end(), indices);
+}
+
+std::vector<mesh_cluster> build_mesh_clusters(
+    std::uint32_t* indices,
+    std::uint32_t tri_count,
+    const float* positions,
+    std::size_t position_stride,
+    std::uint32_t vertex_count,
+    std::uint32_t max_tris)
+{
+    std::vector<mesh_cluster> clusters{};
+    if (!indices || !positions || tri_count == 0 || vertex_count == 0 || max_tris == 0) return clusters;
+
+    const std::size_t index_count = (std::size_t)tri_count * 3u;
+    const auto pos = [&](std::uint32_t v) noexcept { return positions + (std::size_t)v * position_stride; };
+
+    // Vertex -> triangle adjacency, CSR
+    std::vector<std::uint32_t> adj_offset(vertex_count + 1u, 0u);
+    for (std::size_t i = 0; i < index_count; ++i)
+        ++adj_offset[indices[i] + 1u];
+    for (std::uint32_t v = 0; v < vertex_count; ++v)
+        adj_offset[v + 1u] += adj_offset[v];
+
+    std::vector<std::uint32_t> adj(index_count);
+    {
+        std::vector<std::uint32_t> cursor(adj_offset.begin(), adj_offset.end() - 1);
+        for (std::size_t i = 0; i < index_count; ++i)
+            adj[cursor[indices[i]]++] = (std::uint32_t)(i / 3u);
+    }
+
+    // Unit face normals, zero for degenerate triangles, which never face anything
+    std::vector<float> face(index_count, 0.f);
+    for (std::uint32_t t = 0; t < tri_count; ++t)
+    {
+        const std::uint32_t* tri = indices + (std::size_t)t * 3u;
+        double n[3];
+        tri_normal(pos(tri[0]), pos(tri[1]), pos(tri[2]), n);
+        const double len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len <= 0.0) continue;
+        for (int k = 0; k < 3; ++k)
+            face[(std::size_t)t * 3u + k] = (float)(n[k] / len);
+    }
+
+    // Stamps are the cluster number plus one: which cluster a vertex is in, or a triangle is a candidate of
+    std::vector<std::uint8_t> emitted(tri_count, 0u);
+    std::vector<std::uint32_t> vertex_stamp(vertex_count, 0u);
+    std::vector<std::uint32_t> tri_stamp(tri_count, 0u);
+    std::vector<std::uint32_t> out(index_count);
+    std::vector<std::uint32_t> members{};
+    std::vector<std::uint32_t> candidates{};
+    std::vector<std::uint32_t> corners{};
+
+    std::uint32_t emit = 0;
+    std::uint32_t seed = 0;
+    while (emit < tri_count)
+    {
+        const std::uint32_t stamp = (std::uint32_t)clusters.size() + 1u;
+        members.clear();
+        candidates.clear();
+        corners.clear();
+        float sum[3] = { 0.f, 0.f, 0.f };
+
+        const auto add = [&](std::uint32_t t)
+        {
+            emitted[t] = 1u;
+            members.push_back(t);
+            for (int k = 0; k < 3; ++k)
+                sum[k] += face[(std::size_t)t * 3u + k];
+
+            for (int k = 0; k < 3; ++k)
+            {
+                const std::uint32_t v = indices[(std::size_t)t * 3u + k];
+                if (vertex_stamp[v] == stamp) continue;
+                vertex_stamp[v] = stamp;
+                corners.push_back(v);
+                for (std::uint32_t a = adj_offset[v]; a < adj_offset[v + 1u]; ++a)
+                {
+                    const std::uint32_t u = adj[a];
+                    if (emitted[u] || tri_stamp[u] == stamp) continue;
+                    tri_stamp[u] = stamp;
+                    candidates.push_back(u);
+                }
+            }
+        };
+
+        while (emitted[seed]) ++seed;
+        add(seed);
+
+        while (members.size() < max_tris)
+        {
+            const float sum_len = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+            const float inv_len = sum_len > 0.f ? 1.f / sum_len : 0.f;
+
+            // Most corners already in the cluster first, then the one facing closest to its axis
+            std::uint32_t best = tri_count;
+            float best_score = -1e30f;
+            std::size_t kept = 0;
+            for (const std::uint32_t c : candidates)
+            {
+                if (emitted[c]) continue;
+                candidates[kept++] = c;
+
+                int shared = 0;
+                for (int k = 0; k < 3; ++k)
+                    shared += vertex_stamp[indices[(std::size_t)c * 3u + k]] == stamp ? 1 : 0;
+                const float* n = &face[(std::size_t)c * 3u];
+                const float score = (float)shared + 0.5f * (n[0] * sum[0] + n[1] * sum[1] + n[2] * sum[2]) * inv_len;
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best = c;
+                }
+            }
+            candidates.resize(kept);
+
+            // No neighbour left: the next triangle in order carries on, so islands such as foliage
+            // cards share clusters instead of getting one each
+            if (best == tri_count)
+            {
+                while (seed < tri_count && emitted[seed]) ++seed;
+                if (seed == tri_count) break;
+                best = seed;
+            }
+            add(best);
+        }
+
+        mesh_cluster cl{};
+        cl.tri_begin = emit;
+        cl.tri_count = (std::uint32_t)members.size();
+        for (const std::uint32_t t : members)
+        {
+            std::copy(indices + (std::size_t)t * 3u, indices + (std::size_t)t * 3u + 3u, out.begin() + (std::ptrdiff_t)emit * 3);
+            ++emit;
+        }
+
+        // Sphere about the centre of the corners' box
+        float lo[3] = { pos(corners[0])[0], pos(corners[0])[1], pos(corners[0])[2] };
+        float hi[3] = { lo[0], lo[1], lo[2] };
+        for (const std::uint32_t v : corners)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                lo[k] = (std::min)(lo[k], pos(v)[k]);
+                hi[k] = (std::max)(hi[k], pos(v)[k]);
+            }
+        }
+        for (int k = 0; k < 3; ++k)
+            cl.centre[k] = (lo[k] + hi[k]) * 0.5f;
+        float radius2 = 0.f;
+        for (const std::uint32_t v : corners)
+        {
+            const float dx = pos(v)[0] - cl.centre[0], dy = pos(v)[1] - cl.centre[1], dz = pos(v)[2] - cl.centre[2];
+            radius2 = (std::max)(radius2, dx * dx + dy * dy + dz * dz);
+        }
+        cl.radius = std::sqrt(radius2);
+
+        // Cone about the average normal; one of 90 degrees or wider is back facing from nowhere
+        const float sum_len = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+        cl.cone_cutoff = 1.f;
+        if (sum_len > 0.f)
+        {
+            float min_dot = 1.f;
+            for (int k = 0; k < 3; ++k)
+                cl.axis[k] = sum[k] / sum_len;
+            for (const std::uint32_t t : members)
+            {
+                const float* n = &face[(std::size_t)t * 3u];
+                if (n[0] == 0.f && n[1] == 0.f && n[2] == 0.f) continue;
+                min_dot = (std::min)(min_dot, n[0] * cl.axis[0] + n[1] * cl.axis[1] + n[2] * cl.axis[2]);
+            }
+            if (min_dot > 0.f)
+                cl.cone_cutoff = std::sqrt((std::max)(1.f - min_dot * min_dot, 0.f));
+        }
+        clusters.push_back(cl);
+    }
+
+    std::copy(out.begin(), out.end(), indices);
+    return clusters;
+}
+
+std::vector<std::uint32_t> optimize_vertex_fetch(std::uint32_t* indices, std::uint32_t tri_count, std::uint32_t vertex_count)
+{
+    constexpr std::uint32_t kUnset = 0xFFFFFFFFu;
+
+    std::vector<std::uint32_t> remap(vertex_count, kUnset);
+    std::uint32_t next = 0;
+
+    const std::size_t index_count = (std::size_t)tri_count * 3u;
+    for (std::size_t i = 0; i < index_count; ++i)
+    {
+        std::uint32_t& r = remap[indices[i]];
+        if (r == kUnset)
+            r = next++;
+        indices[i] = r;
+    }
+
+    for (std::uint32_t v = 0; v < vertex_count; ++v)
+    {
+        if (remap[v] == kUnset)
+            remap[v] = next++;
+    }
+    return remap;
+}
+
+std::uint32_t simplify_mesh(
+    std::vector<std::uint32_t>& out_indices,
+    const std::uint32_t* indices,
+    std::uint32_t tri_count,
+    const float* positions,
+    std::size_t position_stride,
+    std::uint32_t vertex_count,
+    std::uint32_t target_tri_count,
+    float max_error,
+    float* out_error)
+{
+    if (out_error) *out_error = 0.f;
+    if (!indices) { out_indices.clear(); return 0; }
+
+    out_indices.assign(indices, indices + (std::size_t)tri_count * 3u);
+    if (!positions || vertex_count == 0 || tri_count <= target_tri_count) return tri_count;
+
+    std::uint32_t* tris = out_indices.data();
+    const auto pos = [&](std::uint32_t v) { return positions + (std::size_t)v * position_stride; };
+
+    // Edges not shared by exactly two triangles are borders or attribute seams; their vertices are locked
+    std::vector<std::uint8_t> locked(vertex_count, 0u);
+    {
+        std::unordered_map<std::uint64_t, std::uint32_t> edge_uses{};
+        edge_uses.reserve((std::size_t)tri_count * 3u);
+        for (std::uint32_t t = 0; t < tri_count; ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                const std::uint32_t a = tris[t * 3u + k];
+                const std::uint32_t b = tris[t * 3u + (k + 1) % 3];
+                const std::uint64_t key = ((std::uint64_t)(std::min)(a, b) << 32) | (std::max)(a, b);
+                ++edge_uses[key];
+            }
+        }
+        for (const auto& [key, uses] : edge_uses)
+        {
+            if (uses == 2u) continue;
+            locked[(std::uint32_t)(key >> 32)] = 1u;
+            locked[(std::uint32_t)key] = 1u;
+        }
+    }
+
+    std::vector<quadric> quadrics(vertex_count);
+    std::vector<std::vector<std::uint32_t>> vertex_tris(vertex_count);
+    std::vector<std::uint8_t> dead(tri_count, 0u);
+    std::uint32_t live = 0;
+
+    for (std::uint32_t t = 0; t < tri_count; ++t)
+    {
+        const std::uint32_t* ti = tris + (std::size_t)t * 3u;
+        if (ti[0] == ti[1] || ti[1] == ti[2] || ti[0] == ti[2])
+        {
+            dead[t] = 1u;
+            continue;
+        }
+        ++live;
+
+        double n[3];
+        tri_normal(pos(ti[0]), pos(ti[1]), pos(ti[2]), n);
+        const double len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (int k = 0; k < 3; ++k)
+            vertex_tris[ti[k]].push_back(t);
+        if (len <= 0.0) continue;
+
+        n[0] /= len; n[1] /= len; n[2] /= len;
+        const float* p = pos(ti[0]);
+        const double d = -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]);
+        for (int k = 0; k < 3; ++k)
+            quadrics[ti[k]].add_plane(n[0], n[1], n[2], d);
+    }
+
+    std::vector<std::uint32_t> stamp(vertex_count, 0u);
+    std::priority_queue<collapse, std::vector<collapse>, std::greater<>> heap{};
+    const auto push = [&](std::uint32_t from, std::uint32_t to)
+    {
+        if (locked[from]) return;
+        heap.push({ quadrics[from].error(pos(to)), from, to, stamp[from], stamp[to] });
+    };
+
+    // Every interior edge appears once in each direction across its two triangles
+    for (std::uint32_t t = 0; t < tri_count; ++t)
+    {
+        if (dead[t]) continue;
+        for (int k = 0; k < 3; ++k)
+            push(tris[t * 3u + k], tris[t * 3u + (k + 1) % 3]);
+    }
+
+    const double max_cost = (double)max_error * (double)max_error;
+    double worst = 0.0;
+    std::vector<std::uint32_t> ring_from{}, ring_to{};
+
+    const auto gather_ring = [&](std::uint32_t v, std::vector<std::uint32_t>& ring)
+    {
+        ring.clear();
+        for (const std::uint32_t t : vertex_tris[v])
+        {
+            if (dead[t]) continue;
+            for (int k = 0; k < 3; ++k)
+            {
+                if (tris[t * 3u + k] != v)
+                    ring.push_back(tris[t * 3u + k]);
+            }
+        }
+        std::sort(ring.begin(), ring.end());
+        ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+    };
+
+    while (live > target_tri_count && !heap.empty())
+    {
+        const collapse c = heap.top();
+        heap.pop();
+        if (stamp[c.from] != c.from_stamp || stamp[c.to] != c.to_stamp) continue;
+        if (c.cost > max_cost) break;
+
+        // The edge must still exist and moving `from` must not turn any remaining triangle over
+        bool shared = false;
+        bool flips = false;
+        for (const std::uint32_t t : vertex_tris[c.from])
+        {
+            if (dead[t]) continue;
+            const std::uint32_t* ti = tris + (std::size_t)t * 3u;
+            if (ti[0] == c.to || ti[1] == c.to || ti[2] == c.to)
+            {
+                shared = true;
+                continue;
+            }
+
+            const float* p[3];
+            const float* q[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                p[k] = pos(ti[k]);
+                q[k] = (ti[k] == c.from) ? pos(c.to) : p[k];
+            }
+            double n0[3], n1[3];
+            tri_normal(p[0], p[1], p[2], n0);
+            tri_normal(q[0], q[1], q[2], n1);
+            const double dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+            const double len2 = (n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]) * (n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]);
+            if (dot <= 0.0 || dot * dot < kMinNormalCos2 * len2)
+            {
+                flips = true;
+                break;
+            }
+        }
+        if (!shared || flips) continue;
+
+        // Link condition: an interior edge has exactly the two opposite corners in common
+        gather_ring(c.from, ring_from);
+        gather_ring(c.to, ring_to);
+        std::size_t common = 0;
+        for (std::size_t i = 0, j = 0; i < ring_from.size() && j < ring_to.size();)
+        {
+            if (ring_from[i] == ring_to[j]) { ++common; ++i; ++j; }
+            else if (ring_from[i] < ring_to[j]) ++i;
+            else ++j;
+        }
+        if (common != 2u) continue;
+
+        for (const std::uint32_t t : vertex_tris[c.from])
+        {
+            if (dead[t]) continue;
+            std::uint32_t* ti = tris + (std::size_t)t * 3u;
+            if (ti[0] == c.to || ti[1] == c.to || ti[2] == c.to)
+            {
+                dead[t] = 1u;
+                --live;
+                continue;
+            }
+            for (int k = 0; k < 3; ++k)
+            {
+                if (ti[k] == c.from)
+                    ti[k] = c.to;
+            }
+            vertex_tris[c.to].push_back(t);
+        }
+        vertex_tris[c.from] = {};
+        quadrics[c.to] += quadrics[c.from];
+        ++stamp[c.from];
+        ++stamp[c.to];
+        worst = (std::max)(worst, c.cost);
+
+        auto& around = vertex_tris[c.to];
+        around.erase(std::remove_if(around.begin(), around.end(), [&](std::uint32_t t) { return dead[t] != 0u; }), around.end());
+        for (const std::uint32_t t : around)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                const std::uint32_t n = tris[t * 3u + k];
+                if (n == c.to) continue;
+                push(c.to, n);
+                push(n, c.to);
+            }
+        }
+    }
+
+    std::size_t out = 0;
+    for (std::uint32_t t = 0; t < tri_count; ++t)
+    {
+        if (dead[t]) continue;
+        for (int k = 0; k < 3; ++k)
+            tris[out + k] = tris[t * 3u + k];
+        out += 3u;
+    }
+    out_indices.resize(out);
+
+    if (out_error) *out_error = (float)std::sqrt(worst);
+    return (std::uint32_t)(out / 3u);
+}
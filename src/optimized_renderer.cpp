@@ -1,9 +1,12 @@
 #include "optimized/optimized_renderer.h"
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <limits>
 #include <cmath>
 #include <cstring>
+#include <type_traits>
 
 #ifdef USE_SIMD
 #include <immintrin.h>
@@ -35,11 +38,241 @@ static inline bool tri_outside_frustum_simd(const vec4& hp0, const vec4& hp1, co
 }
 #endif
 
+// Stable LSD radix sort on a 16 bit key, two 8 bit passes through scratch
+template<class T, class KeyFn>
+static void radix_sort_u16(std::vector<T>& items, std::vector<T>& scratch, KeyFn key) noexcept
+{
+    if (items.size() < 2) return;
+    scratch.resize(items.size());
+
+    for (int shift = 0; shift < 16; shift += 8)
+    {
+        std::uint32_t offsets[257]{};
+        for (const T& it : items)
+            ++offsets[((key(it) >> shift) & 0xFFu) + 1u];
+        for (int i = 0; i < 256; ++i)
+            offsets[i + 1] += offsets[i];
+
+        for (const T& it : items)
+            scratch[offsets[(key(it) >> shift) & 0xFFu]++] = it;
+        items.swap(scratch);
+    }
+}
+
+// Writes the normal matrix of world into n and its 3x3 determinant into det; true when the
+// normals it maps still need normalising
+static inline bool normal_matrix_of(const matrix& w, matrix& n, float& det) noexcept
+{
+    float len2[3]{};
+    for (int c = 0; c < 3; ++c)
+        len2[c] = w(0, c) * w(0, c) + w(1, c) * w(1, c) + w(2, c) * w(2, c);
+    const auto col_dot = [&](int a, int b) { return w(0, a) * w(0, b) + w(1, a) * w(1, b) + w(2, a) * w(2, b); };
+
+    float cof[3][3];
+    cof[0][0] = w(1, 1) * w(2, 2) - w(1, 2) * w(2, 1);
+    cof[0][1] = w(1, 2) * w(2, 0) - w(1, 0) * w(2, 2);
+    cof[0][2] = w(1, 0) * w(2, 1) - w(1, 1) * w(2, 0);
+    cof[1][0] = w(0, 2) * w(2, 1) - w(0, 1) * w(2, 2);
+    cof[1][1] = w(0, 0) * w(2, 2) - w(0, 2) * w(2, 0);
+    cof[1][2] = w(0, 1) * w(2, 0) - w(0, 0) * w(2, 1);
+    cof[2][0] = w(0, 1) * w(1, 2) - w(0, 2) * w(1, 1);
+    cof[2][1] = w(0, 2) * w(1, 0) - w(0, 0) * w(1, 2);
+    cof[2][2] = w(0, 0) * w(1, 1) - w(0, 1) * w(1, 0);
+    det = w(0, 0) * cof[0][0] + w(0, 1) * cof[0][1] + w(0, 2) * cof[0][2];
+
+    n = matrix{};
+
+    // Orthogonal columns of equal length: a rotation times a uniform scale
+    const float tol = 1e-4f * len2[0];
+    if (len2[0] > 1e-20f &&
+        std::fabs(len2[1] - len2[0]) <= tol && std::fabs(len2[2] - len2[0]) <= tol &&
+        std::fabs(col_dot(0, 1)) <= tol && std::fabs(col_dot(0, 2)) <= tol && std::fabs(col_dot(1, 2)) <= tol)
+    {
+        const float inv_s = 1.f / std::sqrt(len2[0]);
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                n(r, c) = w(r, c) * inv_s;
+        return false;
+    }
+
+    // Cofactors are the inverse transpose scaled by the determinant; keep the sign so mirrored
+    // worlds do not turn normals inside out
+    const float sign = (det < 0.f) ? -1.f : 1.f;
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c)
+            n(r, c) = (det != 0.f) ? cof[r][c] * sign : w(r, c);
+    return true;
+}
+
+// Inverse of a rotation and translation, all a view matrix here holds
+static inline matrix rigid_inverse(const matrix& m) noexcept
+{
+    matrix r = matrix::makeIdentity();
+    for (unsigned i = 0; i < 3; ++i)
+        for (unsigned j = 0; j < 3; ++j)
+            r(i, j) = m(j, i);
+    for (unsigned i = 0; i < 3; ++i)
+        r(i, 3) = -(r(i, 0) * m(0, 3) + r(i, 1) * m(1, 3) + r(i, 2) * m(2, 3));
+    return r;
+}
+
+// The sun's frame for a unit direction toward it: x and y across the light, z along it
+static inline matrix shadow_light_frame(const vec4& dir) noexcept
+{
+    const vec4 up = (std::fabs(dir.y) < 0.99f) ? vec4(0.f, 1.f, 0.f, 0.f) : vec4(0.f, 0.f, 1.f, 0.f);
+    vec4 x = vec4::cross(up, dir);
+    x.normalise();
+    const vec4 y = vec4::cross(dir, x);
+
+    matrix m = matrix::makeIdentity();
+    m(0, 0) = x.x;   m(0, 1) = x.y;   m(0, 2) = x.z;
+    m(1, 0) = y.x;   m(1, 1) = y.y;   m(1, 2) = y.z;
+    m(2, 0) = dir.x; m(2, 1) = dir.y; m(2, 2) = dir.z;
+    return m;
+}
+
+// World to texel x, y and depth 0 to 1 of a size texel map over box (x0, x1, y0, y1) and z0 to z1
+// of the sun's frame
+static inline matrix shadow_texel_matrix(const matrix& light, const float box[4], float z0, float z1, int size) noexcept
+{
+    const float sx = (float)size / (box[1] - box[0]);
+    const float sy = (float)size / (box[3] - box[2]);
+    const float sz = 1.f / (z1 - z0);
+
+    matrix s = matrix::makeIdentity();
+    s(0, 0) = sx; s(0, 3) = -box[0] * sx;
+    s(1, 1) = sy; s(1, 3) = -box[2] * sy;
+    s(2, 2) = sz; s(2, 3) = -z0 * sz;
+    return s * light;
+}
+
+// Fraction of a 4x4 texel footprint around texel position (u, v) that lies no nearer the sun than
+// ref. A footprint off the map is lit: nothing was drawn there.
+static inline float shadow_pcf4x4(const float* depth, int size, float u, float v, float ref) noexcept
+{
+    const int x0 = (int)std::floor(u - 1.5f);
+    const int y0 = (int)std::floor(v - 1.5f);
+    if (x0 < 0 || y0 < 0 || x0 + 3 >= size || y0 + 3 >= size) return 1.f;
+
+    const float* row = depth + (std::size_t)y0 * (std::size_t)size + (std::size_t)x0;
+#ifdef USE_SIMD
+    // One compare per row, every SIMD level has it
+    const __m128 r = _mm_set1_ps(ref);
+    int shadowed = 0;
+    for (int y = 0; y < 4; ++y, row += size)
+        shadowed += std::popcount((unsigned)_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(row), r)));
+#else
+    int shadowed = 0;
+    for (int y = 0; y < 4; ++y, row += size)
+        for (int x = 0; x < 4; ++x)
+            shadowed += row[x] > ref;
+#endif
+    return 1.f - (float)shadowed * (1.f / 16.f);
+}
+
 static inline float edge_fn(float ax, float ay, float bx, float by, float px, float py) noexcept
 {
     return (px - ax) * (by - ay) - (py - ay) * (bx - ax);
 }
 
+// 16.8 fixed point screen positions for block classification. Past the guard band a snapped
+// coordinate no longer fits a float mantissa exactly, so those triangles keep float edges only.
+static constexpr int   kSubpixelBits   = 8;
+static constexpr float kSubpixelScale  = (float)(1 << kSubpixelBits);
+static constexpr float kFixedGuardBand = 32767.f;
+
+enum class block_coverage : std::uint8_t
+{
+    empty,
+    partial,
+    full,
+};
+
+static inline bool in_fixed_guard_band(float x, float y) noexcept
+{
+    return std::fabs(x) < kFixedGuardBand && std::fabs(y) < kFixedGuardBand;
+}
+
+static inline void snap_to_subpixel(float& x, float& y, std::int64_t& fx, std::int64_t& fy) noexcept
+{
+    fx = (std::int64_t)std::lrint(x * kSubpixelScale);
+    fy = (std::int64_t)std::lrint(y * kSubpixelScale);
+    x = (float)fx / kSubpixelScale;
+    y = (float)fy / kSubpixelScale;
+}
+
+// Same edge layout as the float setup; false when the snapped winding disagrees with the float one
+static inline bool setup_fixed_edges(setup_tri& st, const std::int64_t fx[3], const std::int64_t fy[3], float sign) noexcept
+{
+    static constexpr int kEdgeVerts[3][2] = { { 1, 2 }, { 2, 0 }, { 0, 1 } };
+    const std::int64_t s = (sign < 0.f) ? -1 : 1;
+    for (int e = 0; e < 3; ++e)
+    {
+        const int a = kEdgeVerts[e][0];
+        const int b = kEdgeVerts[e][1];
+        st.fx_a[e] = (fy[b] - fy[a]) * s;
+        st.fx_b[e] = (fx[a] - fx[b]) * s;
+        st.fx_c[e] = (fx[b] * fy[a] - fy[b] * fx[a]) * s;
+    }
+    return st.fx_a[0] * fx[0] + st.fx_b[0] * fy[0] + st.fx_c[0] > 0;
+}
+
+// Tests each edge at the rect corners where it is largest and smallest
+static inline block_coverage classify_block(const setup_tri& st, int x0, int y0, int x1, int y1) noexcept
+{
+    constexpr std::int64_t half = std::int64_t(1) << (kSubpixelBits - 1);
+    const std::int64_t px0 = ((std::int64_t)x0 << kSubpixelBits) + half;
+    const std::int64_t py0 = ((std::int64_t)y0 << kSubpixelBits) + half;
+    const std::int64_t px1 = ((std::int64_t)x1 << kSubpixelBits) + half;
+    const std::int64_t py1 = ((std::int64_t)y1 << kSubpixelBits) + half;
+
+    bool covered = true;
+    for (int e = 0; e < 3; ++e)
+    {
+        const std::int64_t a = st.fx_a[e];
+        const std::int64_t b = st.fx_b[e];
+        const std::int64_t hi = a * (a >= 0 ? px1 : px0) + b * (b >= 0 ? py1 : py0) + st.fx_c[e];
+        if (hi < 0) return block_coverage::empty;
+
+        const std::int64_t lo = a * (a >= 0 ? px0 : px1) + b * (b >= 0 ? py0 : py1) + st.fx_c[e];
+        covered = covered && lo >= 0;
+    }
+    return covered ? block_coverage::full : block_coverage::partial;
+}
+
+// Fills count elements of rows rows; streaming stores keep the fill out of the cache
+template<class T>
+static inline void fill_rows(T* row, std::size_t pitch, std::uint32_t count, std::uint32_t rows, T v, bool stream) noexcept
+{
+#ifdef USE_SIMD
+    if (stream)
+    {
+        static_assert(sizeof(T) == 2 || sizeof(T) == 4, "fill_rows streams 16 or 32 bit elements");
+        std::uint32_t bits = 0;
+        std::memcpy(&bits, &v, sizeof(T));
+        const __m128i v16 = (sizeof(T) == 2) ? _mm_set1_epi16((short)bits) : _mm_set1_epi32((int)bits);
+        constexpr std::uint32_t lanes = 16u / (std::uint32_t)sizeof(T);
+
+        for (std::uint32_t y = 0; y < rows; ++y, row += pitch)
+        {
+            const std::uint32_t misalign = (std::uint32_t)(reinterpret_cast<std::uintptr_t>(row) & 15u);
+            const std::uint32_t head = (std::min)(misalign ? (16u - misalign) / (std::uint32_t)sizeof(T) : 0u, count);
+            std::uint32_t x = 0;
+            for (; x < head; ++x) row[x] = v;
+            for (; x + lanes <= count; x += lanes)
+                _mm_stream_si128(reinterpret_cast<__m128i*>(row + x), v16);
+            for (; x < count; ++x) row[x] = v;
+        }
+        _mm_sfence();
+        return;
+    }
+#else
+    (void)stream;
+#endif
+    for (std::uint32_t y = 0; y < rows; ++y, row += pitch)
+        std::fill_n(row, count, v);
+}
+
 static inline float clamp01(float v) noexcept
 {
     return (v < 0.f) ? 0.f : (v > 1.f ? 1.f : v);
@@ -50,9 +283,21 @@ static inline float fract(float v) noexcept
     return v - std::floor(v);
 }
 
-static inline float hash11(float x) noexcept
+// Integer avalanche hash (lowbias32), in place of sine noise so effects can run it per lane
+static inline std::uint32_t hash_u32(std::uint32_t v) noexcept
+{
+    v ^= v >> 16;
+    v *= 0x7FEB352Du;
+    v ^= v >> 15;
+    v *= 0x846CA68Bu;
+    v ^= v >> 16;
+    return v;
+}
+
+// hash_u32 mapped to [0, 1)
+static inline float hash_unit(std::uint32_t v) noexcept
 {
-    return fract(std::sin(x * 12.9898f) * 43758.5453f);
+    return (float)(hash_u32(v) >> 8) * (1.f / 16777216.f);
 }
 
 static inline std::uint32_t pack_rgba8_from_colour(const colour& c) noexcept
@@ -68,19 +313,6 @@ static inline std::uint32_t pack_rgba8_from_colour(const colour& c) noexcept
            (std::uint32_t(r) <<  0);
 }
 
-static inline std::uint32_t modulate_texture(std::uint32_t tex_rgba, float intensity) noexcept
-{
-    const float r_f = (float)((tex_rgba >>  0) & 0xFFu) * intensity;
-    const float g_f = (float)((tex_rgba >>  8) & 0xFFu) * intensity;
-    const float b_f = (float)((tex_rgba >> 16) & 0xFFu) * intensity;
-
-    const std::uint8_t r = (std::uint8_t)(std::min)(r_f, 255.f);
-    const std::uint8_t g = (std::uint8_t)(std::min)(g_f, 255.f);
-    const std::uint8_t b = (std::uint8_t)(std::min)(b_f, 255.f);
-
-    return (255u << 24) | (std::uint32_t(b) << 16) | (std::uint32_t(g) << 8) | std::uint32_t(r);
-}
-
 static inline void unpack_rgba8(std::uint32_t rgba, float& r, float& g, float& b) noexcept
 {
     r = ((rgba >> 0) & 0xFFu) / 255.f;
@@ -96,7 +328,99 @@ static inline std::uint32_t pack_rgba8_from_rgb(float r, float g, float b) noexc
     return (0xFFu << 24) | (std::uint32_t(bb) << 16) | (std::uint32_t(gg) << 8) | std::uint32_t(rr);
 }
 
-optimized_renderer_core::optimized_renderer_core(std::uint32_t w, std::uint32_t h, const char* name)
+// Blue through cyan, green and yellow to red as t goes from 0 to 1
+static inline std::uint32_t heat_rgba(float t) noexcept
+{
+    const float s = clamp01(t) * 4.f;
+    const int band = (std::min)((int)s, 3);
+    const float f = s - (float)band;
+    switch (band)
+    {
+    case 0:  return pack_rgba8_from_rgb(0.f, f, 1.f);
+    case 1:  return pack_rgba8_from_rgb(0.f, 1.f, 1.f - f);
+    case 2:  return pack_rgba8_from_rgb(f, 1.f, 0.f);
+    default: return pack_rgba8_from_rgb(1.f, 1.f - f, 0.f);
+    }
+}
+
+static inline bool post_process_active(const optimized_renderer_core::post_process_settings& s) noexcept
+{
+    return s.enabled && (s.exposure_enabled || s.contrast_enabled || s.saturation_enabled || s.vignette_enabled);
+}
+
+static inline bool rainy_effect_active(const optimized_renderer_core::rainy_effect_settings& s) noexcept
+{
+    return s.enabled && s.intensity > 0.f && s.streak_probability > 0.f;
+}
+
+static inline bool advanced_effects_active(const optimized_renderer_core::advanced_effects_settings& s) noexcept
+{
+    return s.enabled && (s.bloom_enabled || s.film_grain_enabled || s.motion_blur_enabled || s.fog_enabled ||
+                         s.ssr_enabled || s.depth_of_field_enabled || s.god_rays_enabled);
+}
+
+static inline bool advanced_effects_need_depth(const optimized_renderer_core::advanced_effects_settings& s) noexcept
+{
+    return s.fog_enabled || s.depth_of_field_enabled || s.ssr_enabled;
+}
+
+// Bloom and depth of field sample the blur chain, which is built from the whole finished frame
+static inline bool advanced_effects_need_chain(const optimized_renderer_core::advanced_effects_settings& s) noexcept
+{
+    return s.bloom_enabled || s.depth_of_field_enabled;
+}
+
+// Film grain and rain streaks change every frame even over a still raster
+static inline bool effects_move_with_time(const optimized_renderer_core::rainy_effect_settings& rain,
+                                          const optimized_renderer_core::advanced_effects_settings& advanced) noexcept
+{
+    return rainy_effect_active(rain) ||
+           (advanced_effects_active(advanced) && advanced.film_grain_enabled && advanced.film_grain_strength > 0.f);
+}
+
+// Folds the bits of one value into a running 64 bit signature
+template<class T>
+static inline void mix_hash(std::uint64_t& h, T v) noexcept
+{
+    static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(std::uint64_t), "mix_hash takes one scalar");
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &v, sizeof(T));
+    h = (h ^ bits) * 0xFF51AFD7ED558CCDull;
+    h ^= h >> 32;
+}
+
+static constexpr std::uint64_t kSignatureSeed = 0x9E3779B97F4A7C15ull;
+
+// Everything the raster reads from a set up triangle: edges, depth, UV terms and bounds (the fixed
+// point edges follow from the float ones), the shade, and the texture by identity
+static inline std::uint64_t setup_tri_hash(const setup_tri& st) noexcept
+{
+    constexpr std::size_t kWords = offsetof(setup_tri, fx_a) / sizeof(std::uint64_t);
+    static_assert(offsetof(setup_tri, fx_a) % sizeof(std::uint64_t) == 0, "setup_tri prefix is not whole words");
+
+    std::uint64_t h = kSignatureSeed;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&st);
+    for (std::size_t i = 0; i < kWords; ++i)
+    {
+        std::uint64_t w;
+        std::memcpy(&w, bytes + i * sizeof(std::uint64_t), sizeof(w));
+        mix_hash(h, w);
+    }
+    mix_hash(h, st.fixed_edges);
+    mix_hash(h, st.intensity);
+    mix_hash(h, st.flat_rgba);
+    mix_hash(h, st.state);
+    if (st.tex)
+    {
+        mix_hash(h, st.tex->pixels);
+        mix_hash(h, st.tex->mip_offsets);
+        mix_hash(h, ((std::uint64_t)st.tex->tex_w << 32) | st.tex->tex_h);
+        mix_hash(h, st.tex->mip_count);
+    }
+    return h;
+}
+
+optimized_renderer_core::optimized_renderer_core(std::uint32_t w, std::uint32_t h, const char* name, bool low_latency)
 {
     fox::create_window_params wp{};
     wp.width = w;
@@ -109,231 +433,200 @@ optimized_renderer_core::optimized_renderer_core(std::uint32_t w, std::uint32_t
     dx.height = h;
     dx.hwnd = windows.native_hwnd();
     dx.ring_size = 3; // TODO: Tune it later
+    dx.zero_copy = true;
+    dx.low_latency = low_latency;
     canvas.create(dx);
 
+    m_offline_w = w;
+    m_offline_h = h;
     perspective = matrix::makePerspective(90.f * fox_math::pi_f / 180.f, (float)w / (float)h, 0.1f, 100.f);
+    init_world();
+}
+
+optimized_renderer_core::optimized_renderer_core(headless_t, std::uint32_t w, std::uint32_t h)
+{
+    // Every canvas call is a no-op once it has nothing behind it
+    canvas.destroy();
+
+    m_headless = true;
+    m_offline = true;
+    m_offline_w = (std::max)(w, 1u);
+    m_offline_h = (std::max)(h, 1u);
+    perspective = matrix::makePerspective(90.f * fox_math::pi_f / 180.f, (float)m_offline_w / (float)m_offline_h, 0.1f, 100.f);
+    init_world();
+}
 
+void optimized_renderer_core::init_world() noexcept
+{
     world.register_component<MeshRefPN>();
     world.register_component<Transform>();
     world.register_component<Material>();
     world.register_component<TextureRef>();
+    world.register_component<Bounds>();
+    world.register_component<InstanceTransforms>();
+    world.register_component<PointLight>();
+    world.register_component<DynamicCaster>();
 
-    cube_asset = build_asset_from_indexed_mesh(Mesh::makeCube(1.f));
+    m_best_raster_isa = detect_raster_isa();
 
-    init_persistent_workers();
+    cube_asset = build_asset_from_indexed_mesh(Mesh::makeCube(1.f));
 }
 
 optimized_renderer_core::~optimized_renderer_core()
 {
-    shutdown_persistent_workers();
+    if (m_render_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_render_mtx);
+            m_render_quit = true;
+        }
+        m_render_cv.notify_all();
+        m_render_thread.join();
+    }
     canvas.flush();
 }
 
 void optimized_renderer_core::set_offline_rendering(bool v) noexcept
 {
-    m_offline = v;
+    m_offline = v || m_headless;
 
     if (m_offline)
-    {
-        ensure_offline_targets(framebuffer.w ? framebuffer.w : 1024u,
-                               framebuffer.h ? framebuffer.h : 768u);
-    }
+        ensure_offline_targets(m_offline_w, m_offline_h);
 }
 
-void optimized_renderer_core::apply_post_process(const post_process_settings& settings) noexcept
+void optimized_renderer_core::set_offline_resolution(std::uint32_t w, std::uint32_t h) noexcept
 {
-    if (!settings.enabled) return;
-    if (!framebuffer.data || framebuffer.w == 0 || framebuffer.h == 0) return;
-    if (!settings.exposure_enabled && !settings.contrast_enabled &&
-        !settings.saturation_enabled && !settings.vignette_enabled)
-        return;
-
-    compute_slice_ranges(framebuffer.h);
+    m_offline_w = (std::max)(w, 1u);
+    m_offline_h = (std::max)(h, 1u);
 
-    {
-        std::lock_guard<std::mutex> lg(m_job_mtx);
-        m_job.W = framebuffer.w;
-        m_job.H = framebuffer.h;
-        m_job.fw = settings.exposure;
-        m_job.fh = settings.vignette_power;
-        m_job.post_settings = settings;
-        m_job_type = job_type::post_process;
-        m_done_count = 0;
-        ++m_job_gen;
-    }
-    m_job_cv.notify_all();
-
-    const worker_range main_r = m_ranges[kTotalSlices - 1];
-    if (main_r.y0 <= main_r.y1)
-        post_process_slice(main_r.y0, main_r.y1);
+    if (m_offline)
+        ensure_offline_targets(m_offline_w, m_offline_h);
+}
 
-    {
-        std::unique_lock<std::mutex> lk(m_job_mtx);
-        m_done_cv.wait(lk, [&]() { return m_done_count == kWorkerCount; });
-    }
+void optimized_renderer_core::apply_post_process(const post_process_settings& settings) noexcept
+{
+    if (m_raster_pending) raster_tiles();
+    clear_untouched_tiles();
+    if (m_debug_view != debug_view::none) return;
+    if (!post_process_active(settings)) return;
+    if (!framebuffer.data || framebuffer.w == 0 || framebuffer.h == 0) return;
+    stage_retained_frame();
+
+    m_job.W = framebuffer.w;
+    m_job.H = framebuffer.h;
+    m_job.fw = settings.exposure;
+    m_job.fh = settings.vignette_power;
+    m_job.post_settings = settings;
+    pass_timer timer(*this, frame_pass::post);
+    for_each_row_block(framebuffer.h, [this](int y0, int y1) { post_process_slice(y0, y1); });
 }
 
 void optimized_renderer_core::apply_rainy_effect(const rainy_effect_settings& settings, float time_s) noexcept
 {
-    if (!settings.enabled) return;
+    if (m_raster_pending) raster_tiles();
+    clear_untouched_tiles();
+    if (m_debug_view != debug_view::none) return;
+    if (!rainy_effect_active(settings)) return;
     if (!framebuffer.data || framebuffer.w == 0 || framebuffer.h == 0) return;
-    if (!zbuffer.data || zbuffer.w == 0 || zbuffer.h == 0) return;
-    if (settings.intensity <= 0.f || settings.streak_probability <= 0.f) return;
-
-    compute_slice_ranges(framebuffer.h);
-
-    {
-        std::lock_guard<std::mutex> lg(m_job_mtx);
-        m_job.W = framebuffer.w;
-        m_job.H = framebuffer.h;
-        m_job.rain_settings = settings;
-        m_job.time_s = time_s;
-        m_job_type = job_type::rainy_effect;
-        m_done_count = 0;
-        ++m_job_gen;
-    }
-    m_job_cv.notify_all();
-
-    const worker_range main_r = m_ranges[kTotalSlices - 1];
-    if (main_r.y0 <= main_r.y1)
-        rainy_effect_slice(main_r.y0, main_r.y1);
-
-    {
-        std::unique_lock<std::mutex> lk(m_job_mtx);
-        m_done_cv.wait(lk, [&]() { return m_done_count == kWorkerCount; });
-    }
+    if (!zbuffer.valid()) return;
+    stage_retained_frame();
+
+    m_job.W = framebuffer.w;
+    m_job.H = framebuffer.h;
+    m_job.rain_settings = settings;
+    m_job.time_s = time_s;
+    pass_timer timer(*this, frame_pass::rain);
+    prepare_rain_columns(settings, time_s);
+    for_each_row_block(framebuffer.h, [this](int y0, int y1) { rainy_effect_slice(y0, y1); });
 }
 
 void optimized_renderer_core::apply_advanced_effects(const advanced_effects_settings& settings, float time_s) noexcept
 {
-    if (!settings.enabled) return;
+    if (m_raster_pending) raster_tiles();
+    clear_untouched_tiles();
+    if (m_debug_view != debug_view::none) return;
+    if (!advanced_effects_active(settings)) return;
     if (!framebuffer.data || framebuffer.w == 0 || framebuffer.h == 0) return;
 
-    const bool any_enabled = settings.bloom_enabled || settings.film_grain_enabled ||
-                             settings.motion_blur_enabled || settings.fog_enabled ||
-                             settings.ssr_enabled || settings.depth_of_field_enabled ||
-                             settings.god_rays_enabled;
-    if (!any_enabled) return;
-
-    if ((settings.fog_enabled || settings.depth_of_field_enabled || settings.ssr_enabled) &&
-        (!zbuffer.data || zbuffer.w == 0 || zbuffer.h == 0))
+    if (advanced_effects_need_depth(settings) &&
+        !zbuffer.valid())
         return;
-
-    compute_slice_ranges(framebuffer.h);
-
-    {
-        std::lock_guard<std::mutex> lg(m_job_mtx);
-        m_job.W = framebuffer.w;
-        m_job.H = framebuffer.h;
-        m_job.advanced_settings = settings;
-        m_job.time_s = time_s;
-        m_job_type = job_type::advanced_effects;
-        m_done_count = 0;
-        ++m_job_gen;
-    }
-    m_job_cv.notify_all();
-
-    const worker_range main_r = m_ranges[kTotalSlices - 1];
-    if (main_r.y0 <= main_r.y1)
-        advanced_effects_slice(main_r.y0, main_r.y1);
-
-    {
-        std::unique_lock<std::mutex> lk(m_job_mtx);
-        m_done_cv.wait(lk, [&]() { return m_done_count == kWorkerCount; });
-    }
-}
-
-void optimized_renderer_core::init_persistent_workers() noexcept
-{
-    for (int i = 0; i < kWorkerCount; ++i)
-        m_workers[i] = std::thread([this, i]() { worker_loop(i); });
+    stage_retained_frame();
+
+    m_job.W = framebuffer.w;
+    m_job.H = framebuffer.h;
+    m_job.advanced_settings = settings;
+    m_job.time_s = time_s;
+    pass_timer timer(*this, frame_pass::advanced);
+    if (advanced_effects_need_chain(settings))
+        build_blur_chain(settings);
+    for_each_row_block(framebuffer.h, [this](int y0, int y1) { advanced_effects_slice(y0, y1); });
 }
 
-void optimized_renderer_core::shutdown_persistent_workers() noexcept
+void optimized_renderer_core::apply_post_effects(
+    const post_process_settings& post,
+    const rainy_effect_settings& rain,
+    const advanced_effects_settings& advanced,
+    float time_s) noexcept
 {
-    m_shutdown.store(true, std::memory_order_release);
-    {
-        std::lock_guard<std::mutex> lg(m_job_mtx);
-        ++m_job_gen;
-    }
-    m_job_cv.notify_all();
-
-    for (int i = 0; i < kWorkerCount; ++i)
+    // Effects read the finished raster, so with it deferred they go along to the present
+    if (m_raster_pending)
     {
-        if (m_workers[i].joinable())
-            m_workers[i].join();
+        m_post_deferred = post;
+        m_rain_deferred = rain;
+        m_advanced_deferred = advanced;
+        m_post_time_s = time_s;
+        m_post_pending = true;
+        return;
     }
-}
-
-void optimized_renderer_core::worker_loop(int worker_index) noexcept
-{
-    std::uint64_t seen_gen = 0;
-    job_type local_type = job_type::draw;
+    clear_untouched_tiles();
+    if (m_debug_view != debug_view::none) return;
 
-    for (;;)
+    if (!fused_post_effects)
     {
-        {
-            std::unique_lock<std::mutex> lk(m_job_mtx);
-            m_job_cv.wait(lk, [&]() {
-                return m_shutdown.load(std::memory_order_acquire) || (m_job_gen != seen_gen);
-            });
-
-            if (m_shutdown.load(std::memory_order_acquire))
-                return;
-
-            seen_gen = m_job_gen;
-            local_type = m_job_type;
-        }
-
-        const worker_range r = m_ranges[worker_index];
-        if (r.y0 <= r.y1)
-        {
-            if (local_type == job_type::draw)
-                draw_world_slice(r.y0, r.y1);
-            else if (local_type == job_type::post_process)
-                post_process_slice(r.y0, r.y1);
-            else if (local_type == job_type::rainy_effect)
-                rainy_effect_slice(r.y0, r.y1);
-            else
-                advanced_effects_slice(r.y0, r.y1);
-        }
-
-        {
-            std::lock_guard<std::mutex> lg(m_job_mtx);
-            ++m_done_count;
-            if (m_done_count == kWorkerCount)
-                m_done_cv.notify_one();
-        }
+        apply_post_process(post);
+        apply_rainy_effect(rain, time_s);
+        apply_advanced_effects(advanced, time_s);
+        return;
     }
-}
 
-void optimized_renderer_core::compute_slice_ranges(std::uint32_t H) noexcept
-{
-    const int total = kTotalSlices;
-    const int h = (int)H;
+    if (!framebuffer.data || framebuffer.w == 0 || framebuffer.h == 0) return;
 
-    const int base = h / total;
-    const int rem  = h % total;
+    const bool has_depth = zbuffer.valid();
+    const bool do_post = post_process_active(post);
+    const bool do_rain = rainy_effect_active(rain) && has_depth;
+    const bool do_advanced = advanced_effects_active(advanced) && (has_depth || !advanced_effects_need_depth(advanced));
 
-    constexpr int kRowAlign = 4;
-    int y = 0;
-    for (int s = 0; s < total; ++s)
+    // SSR samples the mirrored row, which must already be finished, and the blur chain is built from
+    // the whole frame, so either keeps its own sweep
+    const bool fuse_advanced = do_advanced && !advanced.ssr_enabled && !advanced_effects_need_chain(advanced);
+    if (!do_post && !do_rain && !fuse_advanced)
     {
-        const int slice_h = base + (s < rem ? 1 : 0);
-        const int y0 = y;
-        int y1 = y + slice_h - 1;
-        if (s == total - 1)
-        {
-            y1 = h - 1;
-        }
-        else
-        {
-            const int aligned_end = ((y1 + 1 + (kRowAlign - 1)) / kRowAlign) * kRowAlign - 1;
-            if (aligned_end < h - 1) y1 = aligned_end;
-        }
-        m_ranges[s] = worker_range{ y0, y1 };
-        y = y1 + 1;
+        if (do_advanced) apply_advanced_effects(advanced, time_s);
+        return;
     }
+    stage_retained_frame();
+
+    m_job.W = framebuffer.w;
+    m_job.H = framebuffer.h;
+    m_job.post_settings = post;
+    m_job.rain_settings = rain;
+    m_job.advanced_settings = advanced;
+    m_job.time_s = time_s;
+
+    pass_timer timer(*this, frame_pass::post);
+    if (do_rain)
+        prepare_rain_columns(rain, time_s);
+    for_each_row_block(framebuffer.h, [&](int y0, int y1)
+    {
+        if (do_post)       post_process_slice(y0, y1);
+        if (do_rain)       rainy_effect_slice(y0, y1);
+        if (fuse_advanced) advanced_effects_slice(y0, y1);
+    });
+    timer.finish();
+
+    if (do_advanced && !fuse_advanced)
+        apply_advanced_effects(advanced, time_s);
 }
 
 void optimized_renderer_core::bind_targets_from_frame(const fox::cpu_frame& f) noexcept
@@ -345,55 +638,94 @@ void optimized_renderer_core::bind_targets_from_frame(const fox::cpu_frame& f) n
     zbuffer.h = f.h;
     zbuffer.pitch = f.z_pitch;
     zbuffer.data = f.z;
+    zbuffer.data16 = nullptr;
+    zbuffer.format = depth_format::f32;
 }
 
-void optimized_renderer_core::clear_color_rgba(std::uint32_t rgba) const noexcept
+void optimized_renderer_core::begin_tile_clears(std::uint32_t rgba) noexcept
 {
-    if (!framebuffer.data || framebuffer.h == 0 || framebuffer.pitch_bytes == 0 || framebuffer.pitch_pixels == 0) return;
+    m_tiles_x = ((int)framebuffer.w + kTileSize - 1) / kTileSize;
+    m_tiles_y = ((int)framebuffer.h + kTileSize - 1) / kTileSize;
+    m_tile_cleared.assign((std::size_t)m_tiles_x * (std::size_t)m_tiles_y, 0u);
+    m_frame_cleared = false;
+
+    // The overdraw view counts depth tests up from opaque black in the colour plane
+    m_debug_view = debug_mode;
+    m_clear_rgba = (m_debug_view == debug_view::overdraw) ? 0xFF000000u : rgba;
+    if (m_debug_view == debug_view::tile_cost)
+        m_tile_cost_ns.assign(m_tile_cleared.size(), 0u);
+    m_tile_cost_max_ns = 0;
+
+    // The kept raster is only trusted again once this frame's tiles have all been through it
+    m_reuse_tiles = m_incremental && m_retained_valid;
+    m_retained_valid = false;
+    if (m_incremental)
+        m_tile_sig.resize(m_tile_cleared.size());
+
+    // Checkerboard is settled by draw_world; the pattern flips every frame begun
+    m_checker_prev_key = m_last_frame;
+    m_checker_was_on = m_checker_on;
+    m_checker_on = false;
+    m_checker_repeat = false;
+    ++m_checker_frame;
+    m_checker_parity = (std::uint32_t)(m_checker_frame & 1u);
+
+    m_last_frame.clear_rgba = rgba;
+    m_last_frame.valid = false;
+}
 
-    if (rgba == 0)
-    {
-        const std::size_t bytes = (std::size_t)framebuffer.pitch_bytes * (std::size_t)framebuffer.h;
-        std::memset(framebuffer.data, 0, bytes);
-        return;
-    }
+void optimized_renderer_core::clear_tile(std::uint32_t tile, bool stream) const noexcept
+{
+    const std::uint32_t x0 = (tile % (std::uint32_t)m_tiles_x) * (std::uint32_t)kTileSize;
+    const std::uint32_t y0 = (tile / (std::uint32_t)m_tiles_x) * (std::uint32_t)kTileSize;
+    const std::uint32_t cw = (std::min)(x0 + (std::uint32_t)kTileSize, framebuffer.w) - x0;
+    const std::uint32_t ch = (std::min)(y0 + (std::uint32_t)kTileSize, framebuffer.h) - y0;
 
-    const std::uint32_t W = framebuffer.w;
-    const std::uint32_t H = framebuffer.h;
+    fill_rows(framebuffer.data + (std::size_t)y0 * framebuffer.pitch_pixels + x0, framebuffer.pitch_pixels, cw, ch, m_clear_rgba, stream);
 
-#ifdef USE_SIMD
-    const __m128i rgba4 = _mm_set1_epi32(static_cast<int>(rgba));
-    for (std::uint32_t y = 0; y < H; ++y)
-    {
-        std::uint32_t* row = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
-        std::uint32_t x = 0;
-        const std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(row);
-        if (addr & 0xF)
-        {
-            const std::uint32_t align = (16u - (addr & 0xFu)) >> 2;
-            const std::uint32_t pre = (std::min)(align, W);
-            for (; x < pre; ++x) row[x] = rgba;
-        }
-        for (; x + 4 <= W; x += 4)
-            _mm_stream_si128(reinterpret_cast<__m128i*>(row + x), rgba4);
-        for (; x < W; ++x)
-            row[x] = rgba;
-    }
-    _mm_sfence();
-#else
-    for (std::uint32_t y = 0; y < H; ++y)
+    const std::size_t z0 = (std::size_t)y0 * zbuffer.pitch + x0;
+    if (zbuffer.data16)
+        fill_rows(zbuffer.data16 + z0, zbuffer.pitch, cw, ch, (std::uint16_t)0u, stream);
+    else if (zbuffer.data)
+        fill_rows(zbuffer.data + z0, zbuffer.pitch, cw, ch, 0.f, stream);
+
+    m_tile_cleared[tile] = 1u;
+}
+
+void optimized_renderer_core::clear_untouched_tiles() noexcept
+{
+    if (m_frame_cleared || !framebuffer.data || !zbuffer.valid()) return;
+
+    pass_timer timer(*this, frame_pass::raster);
+    run_parallel((std::uint32_t)m_tile_cleared.size(), 4, [this](std::uint32_t b, std::uint32_t e)
     {
-        std::uint32_t* row = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
-        std::fill_n(row, W, rgba);
-    }
-#endif
+        for (std::uint32_t t = b; t < e; ++t)
+            if (!m_tile_cleared[t])
+                clear_tile(t, true);
+    });
+    m_frame_cleared = true;
 }
 
 bool optimized_renderer_core::begin_cpu_frame(std::uint32_t clear_rgba) noexcept
 {
+    // Targets, bins and settings below all belong to the frame in flight until it is presented
+    {
+        pass_timer wait(*this, frame_pass::present_wait);
+        wait_frame_in_flight();
+    }
+    m_raster_pending = false;
+    m_post_pending = false;
+
+    // Nothing holds scratch between frames; a fold after a larger frame counts against that frame
+    m_frame_arenas.reset();
+    const std::uint64_t arena_allocs = m_frame_arenas.heap_allocations();
+    m_frame_heap_allocations = arena_allocs - m_arena_allocs_seen;
+    m_arena_allocs_seen = arena_allocs;
+    finish_frame_stats();
+
     if (m_offline)
     {
-        ensure_offline_targets(1024u, 768u);
+        ensure_offline_targets(m_offline_w, m_offline_h);
 
         framebuffer.bind(
             m_offline_targets.w,
@@ -408,89 +740,1498 @@ bool optimized_renderer_core::begin_cpu_frame(std::uint32_t clear_rgba) noexcept
         zbuffer.pitch = m_offline_targets.z_pitch;
         zbuffer.data  = m_offline_targets.z.data();
 
-        if (clear_rgba != 0)
-            clear_color_rgba(clear_rgba);
-
-        if (zbuffer.data)
-        {
-            const std::size_t bytes = (std::size_t)zbuffer.pitch * (std::size_t)zbuffer.h * sizeof(float);
-            std::memset(zbuffer.data, 0, bytes);
-        }
+        m_incremental = false;
+        m_retained_valid = false;
+        bind_depth_format();
+        begin_tile_clears(clear_rgba);
+        m_stats_frame_open = true;
 
         return true;
     }
 
-    cur_frame = canvas.try_begin_frame();
+    // Paced frames wait for the slot the present thread is about to free instead of retrying
+    {
+        pass_timer wait(*this, frame_pass::present_wait);
+        cur_frame = canvas.low_latency() ? canvas.begin_frame() : canvas.try_begin_frame();
+    }
     if (!cur_frame.valid())
         return false;
 
     bind_targets_from_frame(cur_frame);
-
-    if (clear_rgba != 0)
-        clear_color_rgba(clear_rgba);
+    m_frame_start = std::chrono::steady_clock::now();
+
+    if (!dynamic_resolution)
+        m_render_scale = std::clamp(render_scale, kMinRenderScale, 1.f);
+    // Effects read pixels back, which mapped upload memory is very slow at, so they run on the
+    // internal target and the frame gets written once by the resolve
+    m_incremental = incremental_redraw && !checkerboard && m_render_scale >= 1.f && debug_mode == debug_view::none;
+    if (!m_incremental)
+        m_retained_valid = false;
+    m_scaled_active = m_incremental || m_render_scale < 1.f || (cur_frame.write_combined && post_effects_read_frame());
+    if (m_incremental)
+        bind_retained_targets();
+    else if (m_scaled_active)
+        bind_scaled_targets(m_render_scale);
+    bind_depth_format();
+
+    // Nothing is cleared yet: tiles clear as the raster first reaches them, the rest in one pass
+    begin_tile_clears(clear_rgba);
+    m_stats_frame_open = true;
 
     return true;
 }
 
-void optimized_renderer_core::draw_world(const matrix& cam, const Light&, const vec4& light_dir_in) noexcept
+const char* optimized_renderer_core::debug_view_name(debug_view view) noexcept
 {
-    if (!framebuffer.data || !zbuffer.data) return;
-
-    refresh_render_cache();
-    if (!pinned_draw_ready || pinned_draw_blocks.empty()) return;
+    switch (view)
+    {
+    case debug_view::none:             return "None";
+    case debug_view::overdraw:         return "Overdraw";
+    case debug_view::tile_cost:        return "Tile Cost";
+    case debug_view::triangle_density: return "Triangle Density";
+    case debug_view::light_count:      return "Light Count";
+    default: break;
+    }
+    return "";
+}
 
-    const std::uint32_t W = framebuffer.w;
-    const std::uint32_t H = framebuffer.h;
+const char* optimized_renderer_core::frame_pass_name(frame_pass pass) noexcept
+{
+    switch (pass)
+    {
+    case frame_pass::transform:    return "transform";
+    case frame_pass::raster:       return "raster";
+    case frame_pass::post:         return "post";
+    case frame_pass::rain:         return "rain";
+    case frame_pass::advanced:     return "advanced";
+    case frame_pass::present_wait: return "present_wait";
+    default: break;
+    }
+    return "";
+}
 
-    compute_slice_ranges(H);
+void optimized_renderer_core::finish_frame_stats() noexcept
+{
+    const auto now = std::chrono::steady_clock::now();
+    const bool publish = m_stats_frame_open;
+    frame_stats& fs = m_frame_stats;
 
+    if (publish)
     {
-        std::lock_guard<std::mutex> lg(m_job_mtx);
-        m_job.W = W;
-        m_job.H = H;
-        m_job.fw = static_cast<float>(W);
-        m_job.fh = static_cast<float>(H);
-        m_job.textures_on = textures_enabled;
-        m_job.flip_v_on   = flip_v;
-        m_job.vp = perspective * cam;
-        m_job.light_dir = light_dir_in;
-        m_job_type = job_type::draw;
-        m_done_count = 0;
-        ++m_job_gen;
+        ++fs.frame_index;
+        fs.frame_ms = std::chrono::duration<double, std::milli>(now - m_stats_frame_start).count();
+        fs.draw = m_draw_stats;
+        fs.heap_allocations = m_frame_heap_allocations;
+        fs.tile_cost_max_ms = (double)m_tile_cost_max_ns * 1e-6;
+        fs.latency = canvas.latency_stats();
+        for (std::size_t t = 0; t < fox::kMemTagCount; ++t)
+            fs.memory_bytes[t] = fox::mem_live_bytes((fox::mem_tag)t);
+        fs.pixels_depth_tested = 0;
+        fs.pixels_shaded = 0;
+        fs.worker_busy_ms.resize((std::size_t)m_worker_slots + 1u);
     }
-    m_job_cv.notify_all();
 
-    const worker_range main_r = m_ranges[kTotalSlices - 1];
-    if (main_r.y0 <= main_r.y1)
-        draw_world_slice(main_r.y0, main_r.y1);
+    for (std::size_t p = 0; p < kFramePassCount; ++p)
+    {
+        if (publish) fs.pass_ms[p] = (double)m_pass_ns[p] * 1e-6;
+        m_pass_ns[p] = 0;
+    }
 
+    for (std::uint32_t i = 0; i <= m_worker_slots; ++i)
     {
-        std::unique_lock<std::mutex> lk(m_job_mtx);
-        m_done_cv.wait(lk, [&]() { return m_done_count == kWorkerCount; });
+        worker_counters& c = m_worker_counters[i];
+        const std::uint64_t busy   = c.busy_ns.exchange(0, std::memory_order_relaxed);
+        const std::uint64_t tested = c.pixels_tested.exchange(0, std::memory_order_relaxed);
+        const std::uint64_t shaded = c.pixels_shaded.exchange(0, std::memory_order_relaxed);
+        if (!publish) continue;
+
+        fs.worker_busy_ms[i] = (double)busy * 1e-6;
+        fs.pixels_depth_tested += tested;
+        fs.pixels_shaded += shaded;
     }
+
+    m_stats_frame_start = now;
+    m_stats_frame_open = false;
 }
 
-void optimized_renderer_core::post_process_slice(int y0, int y1) const noexcept
+bool optimized_renderer_core::post_effects_read_frame() const noexcept
 {
-    if (!framebuffer.data || framebuffer.w == 0 || framebuffer.h == 0) return;
+    return post_process_active(post_process) || rainy_effect_active(rainy_effect) || advanced_effects_active(advanced_effects);
+}
 
-    const post_process_settings settings = m_job.post_settings;
-    if (!settings.enabled)
-        return;
-    if (!settings.exposure_enabled && !settings.contrast_enabled &&
-        !settings.saturation_enabled && !settings.vignette_enabled)
-        return;
+void optimized_renderer_core::bind_depth_format() noexcept
+{
+    zbuffer.format = depth_mode;
+    zbuffer.data16 = nullptr;
+    if (depth_mode != depth_format::unorm16) return;
 
-    const float inv_w = 1.f / static_cast<float>(framebuffer.w);
-    const float inv_h = 1.f / static_cast<float>(framebuffer.h);
-    const float half_w = 0.5f * static_cast<float>(framebuffer.w);
-    const float half_h = 0.5f * static_cast<float>(framebuffer.h);
+    const std::size_t count = (std::size_t)zbuffer.pitch * (std::size_t)zbuffer.h;
+    if (m_depth16.size() < count)
+        m_depth16.resize(count);
 
-    const std::uint32_t W = framebuffer.w;
+    zbuffer.data   = nullptr;
+    zbuffer.data16 = m_depth16.data();
+}
 
-    for (int y = y0; y <= y1; ++y)
+void optimized_renderer_core::bind_scaled_targets(float scale) noexcept
+{
+    offline_targets_t& t = m_scaled_targets;
+    if (t.pitch_pixels != cur_frame.w || t.color.size() < (std::size_t)cur_frame.w * cur_frame.h)
     {
-        std::uint32_t* row = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
+        t.pitch_pixels = cur_frame.w;
+        t.pitch_bytes  = cur_frame.w * 4u;
+        t.z_pitch      = cur_frame.w;
+        t.color.resize((std::size_t)cur_frame.w * (std::size_t)cur_frame.h);
+        t.z.resize((std::size_t)cur_frame.w * (std::size_t)cur_frame.h);
+    }
+
+    t.w = (std::max)(1u, (std::uint32_t)((float)cur_frame.w * scale + 0.5f));
+    t.h = (std::max)(1u, (std::uint32_t)((float)cur_frame.h * scale + 0.5f));
+
+    framebuffer.bind(t.w, t.h, t.pitch_bytes, t.pitch_pixels, t.color.data());
+    zbuffer.w     = t.w;
+    zbuffer.h     = t.h;
+    zbuffer.pitch = t.z_pitch;
+    zbuffer.data  = t.z.data();
+    if (depth_mode == depth_format::f32)
+        std::memset(zbuffer.data, 0, (std::size_t)zbuffer.pitch * (std::size_t)zbuffer.h * sizeof(float));
+}
+
+void optimized_renderer_core::bind_retained_targets() noexcept
+{
+    offline_targets_t& t = m_retained_targets;
+    if (t.w != cur_frame.w || t.h != cur_frame.h)
+    {
+        t.w = cur_frame.w;
+        t.h = cur_frame.h;
+        t.pitch_pixels = cur_frame.w;
+        t.pitch_bytes  = cur_frame.w * 4u;
+        t.z_pitch      = cur_frame.w;
+        t.color.assign((std::size_t)t.w * (std::size_t)t.h, 0u);
+        t.z.assign((std::size_t)t.w * (std::size_t)t.h, 0.f);
+        m_retained_valid = false;
+    }
+
+    // No clear: tiles the raster keeps already hold last frame's pixels and depth
+    framebuffer.bind(t.w, t.h, t.pitch_bytes, t.pitch_pixels, t.color.data());
+    zbuffer.w     = t.w;
+    zbuffer.h     = t.h;
+    zbuffer.pitch = t.z_pitch;
+    zbuffer.data  = t.z.data();
+}
+
+void optimized_renderer_core::stage_retained_frame() noexcept
+{
+    if (!m_incremental || framebuffer.data != m_retained_targets.color.data()) return;
+
+    // Effects write in place, so they get a copy of the kept raster; depth is only read
+    offline_targets_t& t = m_scaled_targets;
+    if (t.pitch_pixels != framebuffer.pitch_pixels || t.color.size() < (std::size_t)framebuffer.pitch_pixels * framebuffer.h)
+    {
+        t.pitch_pixels = framebuffer.pitch_pixels;
+        t.pitch_bytes  = framebuffer.pitch_bytes;
+        t.z_pitch      = framebuffer.pitch_pixels;
+        t.color.resize((std::size_t)t.pitch_pixels * (std::size_t)framebuffer.h);
+        t.z.resize((std::size_t)t.pitch_pixels * (std::size_t)framebuffer.h);
+    }
+    t.w = framebuffer.w;
+    t.h = framebuffer.h;
+
+    const std::uint32_t* src = framebuffer.data;
+    const std::size_t pitch = framebuffer.pitch_pixels;
+    for_each_row_block(t.h, [&](int y0, int y1)
+    {
+        std::memcpy(t.color.data() + (std::size_t)y0 * pitch, src + (std::size_t)y0 * pitch,
+                    (std::size_t)(y1 - y0 + 1) * pitch * 4u);
+    });
+    framebuffer.bind(t.w, t.h, t.pitch_bytes, t.pitch_pixels, t.color.data());
+}
+
+namespace
+{
+    // a + (b - a) * t / 256 on all four channels, two at a time in 16 bit lanes
+    inline std::uint32_t lerp_rgba8(std::uint32_t a, std::uint32_t b, std::uint32_t t) noexcept
+    {
+        const std::uint32_t s  = 256u - t;
+        const std::uint32_t rb = (((a & 0x00FF00FFu) * s + (b & 0x00FF00FFu) * t) >> 8) & 0x00FF00FFu;
+        const std::uint32_t ga = (((a >> 8) & 0x00FF00FFu) * s + ((b >> 8) & 0x00FF00FFu) * t) & 0xFF00FF00u;
+        return rb | ga;
+    }
+
+    // Sample position for pixel d of an n texel axis scaled by ratio, as i << 8 | weight of i + 1.
+    // Pixel centres map onto each other; samples past the last texel clamp to it.
+    inline std::uint32_t bilinear_tap(std::uint32_t d, float ratio, std::uint32_t n) noexcept
+    {
+        const float f = (std::max)(((float)d + 0.5f) * ratio - 0.5f, 0.f);
+        const std::uint32_t i = (std::min)((std::uint32_t)f, n - 1u);
+        const std::uint32_t t = (i + 1u < n) ? (std::min)((std::uint32_t)((f - (float)i) * 256.f + 0.5f), 255u) : 0u;
+        return (i << 8) | t;
+    }
+
+    inline std::uint32_t sample_rgba8(const std::uint32_t* img, std::uint32_t pitch, std::uint32_t ex, std::uint32_t ey) noexcept
+    {
+        const std::uint32_t sx = ex >> 8, tx = ex & 0xFFu;
+        const std::uint32_t sy = ey >> 8, ty = ey & 0xFFu;
+        const std::uint32_t nx = sx + (tx != 0u ? 1u : 0u);
+        const std::uint32_t* r0 = img + (std::size_t)sy * pitch;
+        const std::uint32_t* r1 = (ty != 0u) ? r0 + pitch : r0;
+        return lerp_rgba8(lerp_rgba8(r0[sx], r0[nx], tx), lerp_rgba8(r1[sx], r1[nx], tx), ty);
+    }
+
+    // Rounded mean of four pixels, two channels per add
+    inline std::uint32_t average4_rgba8(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d) noexcept
+    {
+        constexpr std::uint32_t m = 0x00FF00FFu;
+        const std::uint32_t rb = (((a & m) + (b & m) + (c & m) + (d & m) + 0x00020002u) >> 2) & m;
+        const std::uint32_t ga = ((((a >> 8) & m) + ((b >> 8) & m) + ((c >> 8) & m) + ((d >> 8) & m) + 0x00020002u) >> 2) & m;
+        return rb | (ga << 8);
+    }
+
+    // 1 4 6 4 1 binomial, a sigma of one texel; the weights sum to 16, which fits 16 bit lanes
+    inline std::uint32_t blur5_rgba8(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d, std::uint32_t e) noexcept
+    {
+        constexpr std::uint32_t m = 0x00FF00FFu;
+        const auto lanes = [](std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d, std::uint32_t e) noexcept
+        {
+            return ((a + e + ((b + d) << 2) + c * 6u + 0x00080008u) >> 4) & m;
+        };
+        return lanes(a & m, b & m, c & m, d & m, e & m) |
+               (lanes((a >> 8) & m, (b >> 8) & m, (c >> 8) & m, (d >> 8) & m, (e >> 8) & m) << 8);
+    }
+
+#ifdef USE_SIMD
+    // blur5_rgba8 on four pixels, each channel in its own 16 bit lane
+    inline __m128i blur5_epi8(__m128i a, __m128i b, __m128i c, __m128i d, __m128i e) noexcept
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16(8);
+        const auto half = [&](__m128i a16, __m128i b16, __m128i c16, __m128i d16, __m128i e16) noexcept
+        {
+            __m128i sum = _mm_add_epi16(a16, e16);
+            sum = _mm_add_epi16(sum, _mm_slli_epi16(_mm_add_epi16(b16, d16), 2));
+            sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_slli_epi16(c16, 2), _mm_slli_epi16(c16, 1)));
+            return _mm_srli_epi16(_mm_add_epi16(sum, round), 4);
+        };
+        const __m128i lo = half(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero),
+                                _mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(e, zero));
+        const __m128i hi = half(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero),
+                                _mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(e, zero));
+        return _mm_packus_epi16(lo, hi);
+    }
+#endif
+
+    // Rows [y0, y1] of dst (dw wide) from 2x2 blocks of src, odd edges repeating the last texel
+    void downsample2(std::uint32_t* dst, std::uint32_t dw, const std::uint32_t* src, std::uint32_t src_pitch,
+                     std::uint32_t sw, std::uint32_t sh, int y0, int y1) noexcept
+    {
+        for (int y = y0; y <= y1; ++y)
+        {
+            const std::uint32_t* s0 = src + (std::size_t)(std::min)(2u * (std::uint32_t)y, sh - 1u) * src_pitch;
+            const std::uint32_t* s1 = src + (std::size_t)(std::min)(2u * (std::uint32_t)y + 1u, sh - 1u) * src_pitch;
+            std::uint32_t* out = dst + (std::size_t)y * dw;
+            for (std::uint32_t x = 0; x < dw; ++x)
+            {
+                const std::uint32_t x0 = (std::min)(2u * x, sw - 1u);
+                const std::uint32_t x1 = (std::min)(2u * x + 1u, sw - 1u);
+                out[x] = average4_rgba8(s0[x0], s0[x1], s1[x0], s1[x1]);
+            }
+        }
+    }
+
+    // Horizontal blur5 over rows [y0, y1] of a w wide image, edges clamped
+    void blur5_rows(std::uint32_t* dst, const std::uint32_t* src, std::uint32_t w, int y0, int y1) noexcept
+    {
+        const int last = (int)w - 1;
+        for (int y = y0; y <= y1; ++y)
+        {
+            const std::uint32_t* s = src + (std::size_t)y * w;
+            std::uint32_t* d = dst + (std::size_t)y * w;
+            const auto at = [&](int x) noexcept { return s[std::clamp(x, 0, last)]; };
+
+            int x = 0;
+#ifdef USE_SIMD
+            for (; x < 2 && x <= last; ++x)
+                d[x] = blur5_rgba8(at(x - 2), at(x - 1), s[x], at(x + 1), at(x + 2));
+            for (; x + 5 <= last; x += 4)
+            {
+                const __m128i r = blur5_epi8(_mm_loadu_si128((const __m128i*)(s + x - 2)),
+                                             _mm_loadu_si128((const __m128i*)(s + x - 1)),
+                                             _mm_loadu_si128((const __m128i*)(s + x)),
+                                             _mm_loadu_si128((const __m128i*)(s + x + 1)),
+                                             _mm_loadu_si128((const __m128i*)(s + x + 2)));
+                _mm_storeu_si128((__m128i*)(d + x), r);
+            }
+#endif
+            for (; x <= last; ++x)
+                d[x] = blur5_rgba8(at(x - 2), at(x - 1), s[x], at(x + 1), at(x + 2));
+        }
+    }
+
+    // Vertical blur5 over rows [y0, y1] of a w x h image, edges clamped
+    void blur5_cols(std::uint32_t* dst, const std::uint32_t* src, std::uint32_t w, std::uint32_t h, int y0, int y1) noexcept
+    {
+        for (int y = y0; y <= y1; ++y)
+        {
+            const std::uint32_t* r[5];
+            for (int k = 0; k < 5; ++k)
+                r[k] = src + (std::size_t)std::clamp(y + k - 2, 0, (int)h - 1) * w;
+            std::uint32_t* d = dst + (std::size_t)y * w;
+
+            std::uint32_t x = 0;
+#ifdef USE_SIMD
+            for (; x + 4 <= w; x += 4)
+            {
+                const __m128i v = blur5_epi8(_mm_loadu_si128((const __m128i*)(r[0] + x)),
+                                             _mm_loadu_si128((const __m128i*)(r[1] + x)),
+                                             _mm_loadu_si128((const __m128i*)(r[2] + x)),
+                                             _mm_loadu_si128((const __m128i*)(r[3] + x)),
+                                             _mm_loadu_si128((const __m128i*)(r[4] + x)));
+                _mm_storeu_si128((__m128i*)(d + x), v);
+            }
+#endif
+            for (; x < w; ++x)
+                d[x] = blur5_rgba8(r[0][x], r[1][x], r[2][x], r[3][x], r[4][x]);
+        }
+    }
+}
+
+void optimized_renderer_core::blur_chain::level::resize(std::uint32_t lw, std::uint32_t lh, std::uint32_t frame_w, std::uint32_t frame_h)
+{
+    if (w == lw && h == lh && taps_x.size() == frame_w && taps_y.size() == frame_h) return;
+
+    w = lw;
+    h = lh;
+    rgba.resize((std::size_t)w * (std::size_t)h);
+    taps_x.resize(frame_w);
+    taps_y.resize(frame_h);
+    for (std::uint32_t x = 0; x < frame_w; ++x)
+        taps_x[x] = bilinear_tap(x, (float)w / (float)frame_w, w);
+    for (std::uint32_t y = 0; y < frame_h; ++y)
+        taps_y[y] = bilinear_tap(y, (float)h / (float)frame_h, h);
+}
+
+void optimized_renderer_core::resolve_frame() noexcept
+{
+    const bool staged = m_scaled_active && framebuffer.data && cur_frame.valid();
+    if (staged && framebuffer.w == cur_frame.w && framebuffer.h == cur_frame.h)
+    {
+        // Full size staging for effects that read back, one streaming write per pixel
+        const std::uint32_t src_pitch = framebuffer.pitch_pixels;
+        const std::uint32_t dst_pitch = cur_frame.color_pitch_pixels;
+        for_each_row_block(cur_frame.h, [&](int y0, int y1)
+        {
+            for (int y = y0; y <= y1; ++y)
+                std::memcpy(cur_frame.color + (std::size_t)y * dst_pitch,
+                            framebuffer.data + (std::size_t)y * src_pitch, (std::size_t)cur_frame.w * 4u);
+        });
+    }
+    else if (staged)
+    {
+        const std::uint32_t sw = framebuffer.w;
+        const std::uint32_t sh = framebuffer.h;
+        const std::uint32_t dw = cur_frame.w;
+        const std::uint32_t src_pitch = framebuffer.pitch_pixels;
+        const std::uint32_t dst_pitch = cur_frame.color_pitch_pixels;
+        const std::uint32_t* src = framebuffer.data;
+        std::uint32_t* dst = cur_frame.color;
+
+        const float rx = (float)sw / (float)dw;
+        const float ry = (float)sh / (float)cur_frame.h;
+        m_upscale_x.resize(dw);
+        for (std::uint32_t x = 0; x < dw; ++x)
+            m_upscale_x[x] = bilinear_tap(x, rx, sw);
+
+        for_each_row_block(cur_frame.h, [&](int y0, int y1)
+        {
+            for (int y = y0; y <= y1; ++y)
+            {
+                const std::uint32_t ey = bilinear_tap((std::uint32_t)y, ry, sh);
+                const std::uint32_t sy = ey >> 8;
+                const std::uint32_t ty = ey & 0xFFu;
+                const std::uint32_t* r0 = src + (std::size_t)sy * src_pitch;
+                const std::uint32_t* r1 = (ty != 0u) ? r0 + src_pitch : r0;
+                std::uint32_t* out = dst + (std::size_t)y * dst_pitch;
+
+                for (std::uint32_t x = 0; x < dw; ++x)
+                {
+                    const std::uint32_t ex = m_upscale_x[x];
+                    const std::uint32_t sx = ex >> 8;
+                    const std::uint32_t tx = ex & 0xFFu;
+                    const std::uint32_t nx = sx + (tx != 0u ? 1u : 0u);
+                    const std::uint32_t top = lerp_rgba8(r0[sx], r0[nx], tx);
+                    const std::uint32_t bot = lerp_rgba8(r1[sx], r1[nx], tx);
+                    out[x] = lerp_rgba8(top, bot, ty);
+                }
+            }
+        });
+    }
+
+    if (!dynamic_resolution) return;
+
+    // Cost goes with pixel count, so the scale moves by the square root of the time ratio;
+    // a dead band and smoothing keep it from chasing per frame noise
+    const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_frame_start).count();
+    const float target = (std::max)(target_frame_ms, 1.f);
+    if (ms <= 0.f || (ms > target * 0.9f && ms < target * 1.05f)) return;
+
+    const float ideal = m_render_scale * std::sqrt(target / ms);
+    const float lo = std::clamp(min_render_scale, kMinRenderScale, 1.f);
+    m_render_scale = std::clamp(m_render_scale + (ideal - m_render_scale) * 0.25f, lo, 1.f);
+}
+
+void optimized_renderer_core::draw_world(const matrix& cam, const Light&, const vec4& light_dir_in) noexcept
+{
+    if (!framebuffer.data || !zbuffer.valid()) return;
+
+    pass_timer timer(*this, frame_pass::transform);
+
+    // Read ahead of m_last_frame moving on to this frame
+    m_checker_on = checkerboard && m_debug_view == debug_view::none;
+    m_checker_repeat = m_checker_on && m_checker_was_on && m_checker_prev_key.valid &&
+                       frame_inputs_match(m_checker_prev_key, m_last_frame.clear_rgba, cam, light_dir_in);
+
+    // Writes from here on stamp the new tick, so frame_unchanged sees everything after this read
+    m_last_frame.cam = cam;
+    m_last_frame.light_dir = light_dir_in;
+    m_last_frame.world_version = world.version();
+    m_last_frame.settings = frame_settings_hash();
+    m_last_frame.tick = world.advance_tick();
+    m_last_frame.valid = true;
+
+    refresh_render_cache();
+    if (!pinned_draw_ready || (pinned_draw_blocks.empty() && instanced_cache_.empty())) return;
+
+    configure_raster_job(cam, light_dir_in);
+    m_checker_view_to_world = rigid_inverse(cam);
+
+    // Transform and set up every triangle once, then raster the shared buffer per screen tile
+    build_geometry_entities();
+    if (m_geo_tri_total == 0) return;
+
+    const bool defer_raster = frame_pipelining && cur_frame.valid();
+    if (defer_raster)
+    {
+        m_frame_textures.resize(m_geo_entities.size());
+        for (std::size_t i = 0; i < m_geo_entities.size(); ++i)
+        {
+            m_frame_textures[i] = *m_geo_entities[i].texture;
+            m_geo_entities[i].texture = &m_frame_textures[i];
+        }
+    }
+
+    const std::size_t tile_count = (std::size_t)m_tiles_x * (std::size_t)m_tiles_y;
+    for (auto& bins : m_tile_bins)
+        bins.resize(tile_count);
+    bin_point_lights(cam);
+    update_shadows(cam, light_dir_in);
+
+    prepare_raster_targets();
+    run_geometry_stage();
+    timer.finish();
+
+    // Setup triangles hold everything the tiles read, so the world is free from here on
+    if (defer_raster)
+        m_raster_pending = true;
+    else
+        raster_tiles();
+}
+
+void optimized_renderer_core::configure_raster_job(const matrix& cam, const vec4& light_dir) noexcept
+{
+    const std::uint32_t W = framebuffer.w;
+    const std::uint32_t H = framebuffer.h;
+
+    m_job.W = W;
+    m_job.H = H;
+    m_job.fw = static_cast<float>(W);
+    m_job.fh = static_cast<float>(H);
+    m_job.textures_on = textures_enabled;
+    m_job.flip_v_on   = flip_v;
+    m_job.hiz_on      = hierarchical_z;
+    m_job.cull_on     = frustum_culling;
+    m_job.sort_on     = sort_front_to_back;
+    m_job.vis_on      = (visibility_buffer || m_checker_on) && m_debug_view != debug_view::overdraw;
+    m_job.prepass_on  = depth_prepass && !m_job.vis_on && m_debug_view != debug_view::overdraw;
+    m_job.lod_on      = mesh_lod;
+    m_job.occlusion_on = occlusion_culling;
+    m_job.cluster_on  = cluster_culling;
+    m_job.isa         = wide_raster ? m_best_raster_isa : raster_isa::baseline;
+    m_job.raster      = raster_kernels_for(m_job.isa, zbuffer.format);
+    if (m_debug_view == debug_view::overdraw)
+    {
+        std::fill(std::begin(m_job.raster.partial), std::end(m_job.raster.partial), &raster_rect_overdraw);
+        std::fill(std::begin(m_job.raster.covered), std::end(m_job.raster.covered), &raster_covered_overdraw);
+    }
+    m_job.vp = perspective * cam;
+    m_job.lod_px_scale = std::fabs(perspective(1, 1)) * 0.5f * m_job.fh;
+    m_job.light_dir = light_dir;
+    const matrix view_to_world = rigid_inverse(cam);
+    m_job.eye = vec4(view_to_world(0, 3), view_to_world(1, 3), view_to_world(2, 3), 1.f);
+    extract_frustum_planes();
+}
+
+void optimized_renderer_core::prepare_raster_targets() noexcept
+{
+    // Zero is never farther than a stored depth, so a reset Hi-Z rejects nothing until refreshed
+    if (m_job.hiz_on)
+    {
+        m_hiz_bw = ((int)m_job.W + kHiZBlock - 1) / kHiZBlock;
+        m_hiz_bh = ((int)m_job.H + kHiZBlock - 1) / kHiZBlock;
+        m_hiz_zmin.assign((std::size_t)m_hiz_bw * (std::size_t)m_hiz_bh, 0.f);
+    }
+
+    if (m_job.vis_on)
+    {
+        m_vis_ids.resize((std::size_t)zbuffer.pitch * (std::size_t)m_job.H);
+        m_vis_target.w            = m_job.W;
+        m_vis_target.h            = m_job.H;
+        m_vis_target.pitch_pixels = zbuffer.pitch;
+        m_vis_target.pitch_bytes  = zbuffer.pitch * 4u;
+        m_vis_target.data         = m_vis_ids.data();
+    }
+}
+
+void optimized_renderer_core::run_geometry_stage() noexcept
+{
+    const std::size_t geo_count = m_geo_entities.size();
+    m_geo_xforms.clip.resize(geo_count);
+    m_geo_xforms.normal.resize(geo_count);
+    m_geo_xforms.flags.resize(geo_count);
+    run_parallel((std::uint32_t)geo_count, kXformsPerTask, [this](std::uint32_t b, std::uint32_t e)
+    {
+        build_geometry_xforms(b, e);
+    });
+
+    // Indexed meshes: transform each vertex once, triangles then read the post-transform cache
+    if (m_geo_vtx_total > 0)
+    {
+        m_post_vtx.resize(m_geo_vtx_total);
+        run_parallel((std::uint32_t)m_geo_vtx_total, kVerticesPerTask, [this](std::uint32_t b, std::uint32_t e)
+        {
+            transform_vertices(b, e);
+        });
+    }
+
+    run_parallel(kGeometryBatches, 1, [this](std::uint32_t b, std::uint32_t e)
+    {
+        for (std::uint32_t i = b; i < e; ++i)
+            geometry_batch((int)i);
+    });
+
+    std::size_t rasterized = 0;
+    for (const auto& tris : m_setup_tris)
+        rasterized += tris.size();
+    for (const cluster_counts& c : m_batch_clusters)
+    {
+        m_draw_stats.clusters_tested += c.tested;
+        m_draw_stats.clusters_culled += c.culled;
+    }
+    m_draw_stats.triangles_rasterized = (std::uint32_t)rasterized;
+    m_draw_stats.triangles_culled += m_draw_stats.triangles_submitted - (std::uint32_t)rasterized;
+}
+
+void optimized_renderer_core::raster_tiles() noexcept
+{
+    m_raster_pending = false;
+
+    pass_timer timer(*this, frame_pass::raster);
+    const std::uint32_t tile_count = (std::uint32_t)m_tiles_x * (std::uint32_t)m_tiles_y;
+
+    // A kept tile must also have been drawn over the same clear, size, depth format and kernels
+    std::uint64_t key = kSignatureSeed;
+    if (m_incremental)
+    {
+        mix_hash(key, ((std::uint64_t)m_job.W << 32) | m_job.H);
+        mix_hash(key, m_clear_rgba);
+        mix_hash(key, zbuffer.format);
+        mix_hash(key, m_job.vis_on);
+        mix_hash(key, m_job.prepass_on);
+        mix_hash(key, m_job.raster.partial[0]);
+        mix_hash(key, m_job.shadow_strength);
+        m_reuse_tiles = m_reuse_tiles && key == m_retained_key && m_retained_sig.size() == tile_count;
+    }
+
+    run_parallel(tile_count, 1, [this](std::uint32_t b, std::uint32_t e)
+    {
+        for (std::uint32_t t = b; t < e; ++t)
+            draw_world_tile(t);
+    });
+
+    // Every tile either drew or was streamed full of the clear
+    m_frame_cleared = true;
+    if (m_checker_on)
+        reconstruct_checkerboard();
+
+    if (m_incremental)
+    {
+        std::uint32_t reused = 0;
+        if (m_reuse_tiles)
+            for (std::uint32_t t = 0; t < tile_count; ++t)
+                reused += (m_tile_sig[t] == m_retained_sig[t]) ? 1u : 0u;
+        m_draw_stats.tiles_reused = reused;
+
+        m_retained_sig.swap(m_tile_sig);
+        m_retained_key = key;
+        m_retained_valid = true;
+    }
+
+    if (m_debug_view == debug_view::tile_cost)
+        apply_tile_cost_view();
+    else if (m_debug_view == debug_view::light_count)
+        apply_light_count_view();
+}
+
+void optimized_renderer_core::draw_world_views(const render_view* views, std::size_t count, const vec4& light_dir, std::uint32_t clear_rgba) noexcept
+{
+    if (!views || count == 0 || m_raster_pending) return;
+    wait_frame_in_flight();
+
+    refresh_render_cache();
+    if (!pinned_draw_ready || (pinned_draw_blocks.empty() && instanced_cache_.empty())) return;
+
+    // Everything else a view writes lives in m_view_scratch until the frame's state is swapped back
+    const FramebufferRGBA8 saved_framebuffer = framebuffer;
+    const ZBufferF32       saved_zbuffer     = zbuffer;
+    const matrix           saved_perspective = perspective;
+    const std::uint32_t    saved_clear       = m_clear_rgba;
+    const debug_view       saved_debug       = m_debug_view;
+    const bool             saved_incremental = m_incremental;
+    const bool             saved_reuse       = m_reuse_tiles;
+    const bool             saved_checker     = m_checker_on;
+    swap_view_scratch();
+
+    m_debug_view  = debug_view::none;
+    m_incremental = false;
+    m_reuse_tiles = false;
+    m_checker_on  = false;
+    m_clear_rgba  = clear_rgba;
+
+    std::array<draw_job_shared, kMaxViews> jobs{};
+    std::array<std::size_t, kMaxViews> drawn{};
+    std::size_t n = 0;
+    for (std::size_t v = 0; v < (std::min)(count, kMaxViews); ++v)
+    {
+        const render_view& view = views[v];
+        if (!view.framebuffer.data || !view.zbuffer.valid()) continue;
+
+        framebuffer = view.framebuffer;
+        zbuffer     = view.zbuffer;
+        perspective = view.proj;
+        configure_raster_job(view.cam, light_dir);
+        jobs[n] = m_job;
+        drawn[n++] = v;
+    }
+
+    if (n > 0)
+    {
+        // One entity list for every view; the first view's job orders it
+        m_job = jobs[0];
+        m_geo_views = std::span<const draw_job_shared>(jobs.data(), n);
+        build_geometry_entities();
+        m_geo_views = {};
+
+        // The frame's maps when it drew them, else drawn once here around the first view
+        if (m_shadow_tick == 0)
+            update_shadows(views[drawn[0]].cam, light_dir);
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const render_view& view = views[drawn[i]];
+            framebuffer = view.framebuffer;
+            zbuffer     = view.zbuffer;
+            perspective = view.proj;
+            m_job       = jobs[i];
+            set_shadow_view(view.cam);
+
+            m_tiles_x = ((int)framebuffer.w + kTileSize - 1) / kTileSize;
+            m_tiles_y = ((int)framebuffer.h + kTileSize - 1) / kTileSize;
+            const std::size_t tile_count = (std::size_t)m_tiles_x * (std::size_t)m_tiles_y;
+            m_tile_cleared.assign(tile_count, 0u);
+
+            // The geometry stage runs even over an empty list, it is what empties the previous view's bins
+            for (auto& bins : m_tile_bins)
+                bins.resize(tile_count);
+            bin_point_lights(view.cam);
+            prepare_raster_targets();
+            run_geometry_stage();
+
+            run_parallel((std::uint32_t)tile_count, 1, [this](std::uint32_t b, std::uint32_t e)
+            {
+                for (std::uint32_t t = b; t < e; ++t)
+                    draw_world_tile(t);
+            });
+        }
+    }
+
+    framebuffer   = saved_framebuffer;
+    zbuffer       = saved_zbuffer;
+    perspective   = saved_perspective;
+    m_clear_rgba  = saved_clear;
+    m_debug_view  = saved_debug;
+    m_incremental = saved_incremental;
+    m_reuse_tiles = saved_reuse;
+    m_checker_on  = saved_checker;
+    swap_view_scratch();
+}
+
+void optimized_renderer_core::swap_view_scratch() noexcept
+{
+    view_scratch& s = m_view_scratch;
+    std::swap(m_job, s.job);
+    std::swap(m_draw_stats, s.stats);
+    m_geo_entities.swap(s.geo_entities);
+    std::swap(m_geo_tri_total, s.geo_tri_total);
+    std::swap(m_geo_vtx_total, s.geo_vtx_total);
+    m_post_vtx.swap(s.post);
+    std::swap(m_geo_xforms, s.xforms);
+    m_geo_hidden.swap(s.geo_hidden);
+    std::swap(m_setup_tris, s.setup_tris);
+    std::swap(m_batch_clusters, s.batch_clusters);
+    std::swap(m_tile_bins, s.tile_bins);
+    std::swap(m_tiles_x, s.tiles_x);
+    std::swap(m_tiles_y, s.tiles_y);
+    m_lights.swap(s.lights);
+    m_tile_lights.swap(s.tile_lights);
+    m_tile_light_count.swap(s.tile_light_count);
+    m_tile_cleared.swap(s.tile_cleared);
+    m_hiz_zmin.swap(s.hiz_zmin);
+    std::swap(m_hiz_bw, s.hiz_bw);
+    std::swap(m_hiz_bh, s.hiz_bh);
+    m_vis_ids.swap(s.vis_ids);
+    std::swap(m_vis_target, s.vis_target);
+    std::swap(m_shadow_static.from_view, s.shadow_from_view[0]);
+    std::swap(m_shadow_dynamic.from_view, s.shadow_from_view[1]);
+    std::swap(m_shadow_dynamic_rect, s.shadow_dynamic_rect);
+    std::swap(m_shadow_dynamic_rect_prev, s.shadow_dynamic_rect_prev);
+}
+
+void optimized_renderer_core::reconstruct_checkerboard() noexcept
+{
+    const std::uint32_t W = framebuffer.w;
+    const std::uint32_t H = framebuffer.h;
+    checker_history& out = m_checker_history[m_checker_write];
+    const checker_history& in = m_checker_history[m_checker_write ^ 1u];
+    out.colour.resize((std::size_t)W * (std::size_t)H);
+    out.depth.resize((std::size_t)W * (std::size_t)H);
+
+    // Stored depth d is 1 - ndc z, so view depth is D / (C + 1 - d), and the view space point is
+    // depth times the ray through the pixel; the last view takes it on to that frame's clip space
+    const float pc = perspective(2, 2) + 1.f;
+    const float pd = perspective(2, 3);
+    const bool history = in.frame + 1u == m_checker_frame && in.w > 0 && in.h > 0;
+    const bool same_size = in.w == W && in.h == H;
+    const matrix reproject = in.vp * m_checker_view_to_world;
+    const float hw = (float)in.w;
+    const float hh = (float)in.h;
+
+    std::atomic<std::uint32_t> reprojected{ 0 }, interpolated{ 0 };
+    for_each_row_block(H, [&](int y0, int y1)
+    {
+        std::uint32_t kept = 0, rebuilt = 0;
+        for (int y = y0; y <= y1; ++y)
+        {
+            std::uint32_t* crow = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
+            const float ry = (1.f - ((float)y + 0.5f) * 2.f / m_job.fh) / perspective(1, 1);
+
+            // Unshaded pixels only read shaded ones, which nothing here writes
+            for (int x = (y + (int)m_checker_parity + 1) & 1; x < (int)W; x += 2)
+            {
+                const float d = zbuffer.at((std::uint32_t)x, (std::uint32_t)y);
+                if (d <= 0.f) continue;
+
+                if (history)
+                {
+                    const float depth = pd / (pc - d);
+                    const float rx = (((float)x + 0.5f) * 2.f / m_job.fw - 1.f) / perspective(0, 0);
+                    const vec4 c = reproject * vec4(rx * depth, ry * depth, -depth, 1.f);
+                    if (c.w > 0.f)
+                    {
+                        const float sx = (c.x / c.w + 1.f) * 0.5f * hw;
+                        const float sy = hh - (c.y / c.w + 1.f) * 0.5f * hh;
+                        int ix = (int)std::floor(sx);
+                        const int iy = (int)std::floor(sy);
+
+                        // Of the two pixels nearest along x, the one the last frame shaded, so a
+                        // colour is never carried over from further back than that
+                        if (same_size && (((ix + iy) & 1) != (int)in.parity))
+                            ix += ((sx - (float)ix >= 0.5f && ix + 1 < (int)in.w) || ix <= 0) ? 1 : -1;
+
+                        if (ix >= 0 && iy >= 0 && ix < (int)in.w && iy < (int)in.h)
+                        {
+                            const std::size_t hi = (std::size_t)iy * in.w + (std::size_t)ix;
+                            const float hd = in.depth[hi];
+                            if (hd > 0.f && std::fabs(pd / (pc - hd) - c.w) <= kCheckerDepthTolerance * c.w)
+                            {
+                                crow[x] = in.colour[hi];
+                                ++kept;
+                                continue;
+                            }
+                        }
+                    }
+                }
+
+                // Disoccluded: the neighbour pair whose depths differ least, so an edge is not blurred across
+                std::uint32_t pick[2]{};
+                float gap[2]{ -1.f, -1.f };
+                const int nx[2][2] = { { x - 1, x + 1 }, { x, x } };
+                const int ny[2][2] = { { y, y }, { y - 1, y + 1 } };
+                for (int axis = 0; axis < 2; ++axis)
+                {
+                    std::uint32_t c[2];
+                    float nd[2];
+                    int n = 0;
+                    for (int k = 0; k < 2; ++k)
+                    {
+                        const int qx = nx[axis][k];
+                        const int qy = ny[axis][k];
+                        if (qx < 0 || qy < 0 || qx >= (int)W || qy >= (int)H) continue;
+                        nd[n] = zbuffer.at((std::uint32_t)qx, (std::uint32_t)qy);
+                        c[n++] = framebuffer.data[(std::size_t)qy * (std::size_t)framebuffer.pitch_pixels + (std::size_t)qx];
+                    }
+                    if (n == 2)
+                    {
+                        pick[axis] = lerp_rgba8(c[0], c[1], 128u);
+                        gap[axis]  = std::fabs(nd[0] - nd[1]);
+                    }
+                    else if (n == 1)
+                    {
+                        pick[axis] = c[0];
+                        gap[axis]  = std::fabs(nd[0] - d);
+                    }
+                }
+                if (gap[0] >= 0.f || gap[1] >= 0.f)
+                {
+                    crow[x] = (gap[1] < 0.f || (gap[0] >= 0.f && gap[0] <= gap[1])) ? pick[0] : pick[1];
+                    ++rebuilt;
+                }
+            }
+
+            std::memcpy(out.colour.data() + (std::size_t)y * W, crow, (std::size_t)W * 4u);
+            float* drow = out.depth.data() + (std::size_t)y * W;
+            for (std::uint32_t x = 0; x < W; ++x)
+                drow[x] = zbuffer.at(x, (std::uint32_t)y);
+        }
+        reprojected.fetch_add(kept, std::memory_order_relaxed);
+        interpolated.fetch_add(rebuilt, std::memory_order_relaxed);
+    });
+
+    out.w = W;
+    out.h = H;
+    out.vp = m_job.vp;
+    out.frame = m_checker_frame;
+    out.parity = m_checker_parity;
+    m_checker_write ^= 1u;
+
+    m_draw_stats.pixels_reprojected = reprojected.load(std::memory_order_relaxed);
+    m_draw_stats.pixels_interpolated = interpolated.load(std::memory_order_relaxed);
+}
+
+void optimized_renderer_core::apply_tile_cost_view() noexcept
+{
+    for (const std::uint64_t ns : m_tile_cost_ns)
+        m_tile_cost_max_ns = (std::max)(m_tile_cost_max_ns, ns);
+    if (m_tile_cost_max_ns == 0) return;
+
+    // Over the shaded frame so the props stay recognisable under the tint
+    const float inv_max = 1.f / (float)m_tile_cost_max_ns;
+    run_parallel((std::uint32_t)m_tile_cost_ns.size(), 4, [&](std::uint32_t b, std::uint32_t e)
+    {
+        for (std::uint32_t t = b; t < e; ++t)
+        {
+            const std::uint32_t heat = heat_rgba((float)m_tile_cost_ns[t] * inv_max);
+            const std::uint32_t x0 = (t % (std::uint32_t)m_tiles_x) * (std::uint32_t)kTileSize;
+            const std::uint32_t y0 = (t / (std::uint32_t)m_tiles_x) * (std::uint32_t)kTileSize;
+            const std::uint32_t x1 = (std::min)(x0 + (std::uint32_t)kTileSize, framebuffer.w);
+            const std::uint32_t y1 = (std::min)(y0 + (std::uint32_t)kTileSize, framebuffer.h);
+
+            for (std::uint32_t y = y0; y < y1; ++y)
+            {
+                std::uint32_t* row = framebuffer.data + (std::size_t)y * framebuffer.pitch_pixels;
+                for (std::uint32_t x = x0; x < x1; ++x)
+                    row[x] = lerp_rgba8(row[x], heat, 160u);
+            }
+        }
+    });
+}
+
+void optimized_renderer_core::bin_point_lights(const matrix& cam) noexcept
+{
+    m_lights.clear();
+    const std::size_t tile_count = (std::size_t)m_tiles_x * (std::size_t)m_tiles_y;
+    m_tile_lights.resize(tile_count);
+    for (auto& list : m_tile_lights)
+        list.clear();
+    m_tile_light_count.assign(tile_count, 0u);
+    if (!point_lights || m_debug_view == debug_view::overdraw) return;
+
+    // View depth runs from near_d to far_d; x and y project as s * v / depth
+    const float near_d = perspective(2, 3) / perspective(2, 2);
+    const float far_d  = perspective(2, 3) / (perspective(2, 2) + 1.f);
+    const float sx = perspective(0, 0);
+    const float sy = perspective(1, 1);
+    const float hw = 0.5f * m_job.fw;
+    const float hh = 0.5f * m_job.fh;
+
+    std::uint32_t refs = 0;
+    world.query<const PointLight>().each([&](const PointLight* lights, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n && m_lights.size() < kMaxLights; ++i)
+        {
+            const PointLight& pl = lights[i];
+            const float r = pl.radius;
+            if (r <= 0.f || pl.intensity <= 0.f) continue;
+
+            const vec4 v = cam * vec4(pl.position.x, pl.position.y, pl.position.z, 1.f);
+            const float depth = -v.z;
+            if (depth + r <= near_d || depth - r >= far_d) continue;
+
+            // Screen box of the light's view space AABB, each side projected at whichever end of its
+            // depth range pushes it out farther. A light reaching the near plane may cover anything.
+            int tx0 = 0, ty0 = 0, tx1 = m_tiles_x - 1, ty1 = m_tiles_y - 1;
+            if (depth - r > near_d)
+            {
+                const float dn = depth - r;
+                const float df = depth + r;
+                const auto lo = [&](float c, float s) noexcept { const float e = c - r; return s * e / (e < 0.f ? dn : df); };
+                const auto hi = [&](float c, float s) noexcept { const float e = c + r; return s * e / (e > 0.f ? dn : df); };
+
+                const float px0 = (lo(v.x, sx) + 1.f) * hw;
+                const float px1 = (hi(v.x, sx) + 1.f) * hw;
+                const float py0 = (1.f - hi(v.y, sy)) * hh;
+                const float py1 = (1.f - lo(v.y, sy)) * hh;
+                if (px1 < 0.f || py1 < 0.f || px0 >= m_job.fw || py0 >= m_job.fh) continue;
+
+                tx0 = (int)(std::max)(px0, 0.f) / kTileSize;
+                ty0 = (int)(std::max)(py0, 0.f) / kTileSize;
+                tx1 = (std::min)((int)px1 / kTileSize, m_tiles_x - 1);
+                ty1 = (std::min)((int)py1 / kTileSize, m_tiles_y - 1);
+            }
+
+            const std::uint16_t index = (std::uint16_t)m_lights.size();
+            view_light vl{};
+            vl.x = v.x;
+            vl.y = v.y;
+            vl.z = v.z;
+            vl.radius = r;
+            vl.r = pl.col.r * pl.intensity;
+            vl.g = pl.col.g * pl.intensity;
+            vl.b = pl.col.b * pl.intensity;
+            vl.inv_radius2 = 1.f / (r * r);
+            m_lights.push_back(vl);
+
+            for (int ty = ty0; ty <= ty1; ++ty)
+                for (int tx = tx0; tx <= tx1; ++tx)
+                    m_tile_lights[(std::size_t)ty * (std::size_t)m_tiles_x + (std::size_t)tx].push_back(index);
+            refs += (std::uint32_t)((tx1 - tx0 + 1) * (ty1 - ty0 + 1));
+        }
+    });
+
+    m_draw_stats.lights_visible = (std::uint32_t)m_lights.size();
+    m_draw_stats.light_tile_refs = refs;
+}
+
+void optimized_renderer_core::apply_light_count_view() noexcept
+{
+    // Against the cap rather than the busiest tile, so one frame reads against the next
+    const float scale = 1.f / (float)kMaxTileLights;
+    run_parallel((std::uint32_t)m_tile_light_count.size(), 4, [&](std::uint32_t b, std::uint32_t e)
+    {
+        for (std::uint32_t t = b; t < e; ++t)
+        {
+            if (m_tile_light_count[t] == 0) continue;
+
+            const std::uint32_t heat = heat_rgba((float)m_tile_light_count[t] * scale);
+            const std::uint32_t x0 = (t % (std::uint32_t)m_tiles_x) * (std::uint32_t)kTileSize;
+            const std::uint32_t y0 = (t / (std::uint32_t)m_tiles_x) * (std::uint32_t)kTileSize;
+            const std::uint32_t x1 = (std::min)(x0 + (std::uint32_t)kTileSize, framebuffer.w);
+            const std::uint32_t y1 = (std::min)(y0 + (std::uint32_t)kTileSize, framebuffer.h);
+
+            for (std::uint32_t y = y0; y < y1; ++y)
+            {
+                std::uint32_t* row = framebuffer.data + (std::size_t)y * framebuffer.pitch_pixels;
+                for (std::uint32_t x = x0; x < x1; ++x)
+                    row[x] = lerp_rgba8(row[x], heat, 160u);
+            }
+        }
+    });
+}
+
+void optimized_renderer_core::update_shadows(const matrix& cam, const vec4& light_dir) noexcept
+{
+    std::copy(std::begin(m_shadow_dynamic_rect), std::end(m_shadow_dynamic_rect), m_shadow_dynamic_rect_prev);
+    m_shadow_dynamic_rect[0] = m_shadow_dynamic_rect[1] = 0;
+    m_shadow_dynamic_rect[2] = m_shadow_dynamic_rect[3] = -1;
+    m_shadow_dynamic.casters = 0;
+    m_job.shadow_strength = 0.f;
+
+    vec4 dir(light_dir.x, light_dir.y, light_dir.z, 0.f);
+    const float len = dir.length();
+    if (!shadows || m_debug_view == debug_view::overdraw || len <= 1e-4f)
+    {
+        m_shadow_static.casters = 0;
+        m_shadow_tick = 0;
+        return;
+    }
+    dir *= 1.f / len;
+
+    const matrix view_to_world = rigid_inverse(cam);
+    const vec4 eye(view_to_world(0, 3), view_to_world(1, 3), view_to_world(2, 3), 1.f);
+
+    // The cached map: drawn for a sun direction and eye that both hold still a while. Dynamic
+    // casters write their own columns, so animating them leaves this alone.
+    std::uint64_t settings = kSignatureSeed;
+    mix_hash(settings, shadow_distance);
+    mix_hash(settings, shadow_bias);
+    mix_hash(settings, m_job.lod_on);
+    const vec4 walked = eye - m_shadow_eye;
+    const bool redraw = m_shadow_tick == 0 || settings != m_shadow_settings ||
+                        vec4::dot(dir, m_shadow_dir) < std::cos(shadow_update_degrees * fox_math::pi_f / 180.f) ||
+                        walked.length() > shadow_distance * 0.25f ||
+                        world.written_since_without<DynamicCaster, MeshRefPN, Transform, Bounds, InstanceTransforms>(m_shadow_tick);
+    if (redraw)
+    {
+        m_shadow_dir = dir;
+        m_shadow_eye = eye;
+        m_shadow_settings = settings;
+        m_shadow_light = shadow_light_frame(dir);
+
+        // On whole texels, so a map drawn again after walking does not crawl the shadows' edges
+        const float texel = 2.f * shadow_distance / (float)kShadowMapSize;
+        const vec4 centre = m_shadow_light * eye;
+        const float cx = std::floor(centre.x / texel) * texel;
+        const float cy = std::floor(centre.y / texel) * texel;
+        const float box[4] = { cx - shadow_distance, cx + shadow_distance, cy - shadow_distance, cy + shadow_distance };
+
+        m_shadow_static.size = kShadowMapSize;
+        draw_shadow_map(m_shadow_static, false, box);
+        m_shadow_tick = m_last_frame.tick;
+        ++m_shadow_static_version;
+        m_draw_stats.shadow_map_redrawn = true;
+    }
+    m_draw_stats.shadow_casters = m_shadow_static.casters;
+
+    float box[4];
+    if (dynamic_shadow_box(box))
+    {
+        m_shadow_dynamic.size = kShadowOverlaySize;
+        m_draw_stats.shadow_dynamic_casters = draw_shadow_map(m_shadow_dynamic, true, box);
+    }
+    if (m_shadow_dynamic.casters)
+    {
+        // Tiles under the overlay redraw when its texels or placement change, and once more after
+        // its shadows leave them
+        std::uint64_t h = kSignatureSeed;
+        for (const float d : m_shadow_dynamic.depth)
+            mix_hash(h, d);
+        for (unsigned r = 0; r < 3; ++r)
+            for (unsigned c = 0; c < 4; ++c)
+                mix_hash(h, m_shadow_dynamic.from_world(r, c));
+        m_shadow_dynamic_hash = h;
+
+        // Shadows fall from the casters' tops down to the lowest caster of the cached map
+        const float floor_z = m_shadow_static.casters ? (std::min)(m_shadow_static.z0, m_shadow_dynamic.z0)
+                                                      : m_shadow_dynamic.z0 - shadow_distance;
+        shadow_screen_rect(box, floor_z, m_shadow_dynamic.z1, cam, m_shadow_dynamic_rect);
+    }
+
+    set_shadow_view(cam);
+}
+
+void optimized_renderer_core::set_shadow_view(const matrix& cam) noexcept
+{
+    m_job.shadow_strength = 0.f;
+    if (!shadows) return;
+
+    const matrix view_to_world = rigid_inverse(cam);
+    for (shadow_map* map : { &m_shadow_static, &m_shadow_dynamic })
+        if (map->casters)
+            map->from_view = map->from_world * view_to_world;
+    if (m_shadow_static.casters || m_shadow_dynamic.casters)
+        m_job.shadow_strength = std::clamp(shadow_strength, 0.f, 1.f);
+}
+
+bool optimized_renderer_core::dynamic_shadow_box(float box[4]) noexcept
+{
+    const fecs::component_id dynamic_id = world.registry().get_id<DynamicCaster>();
+    float lo[2] = { (std::numeric_limits<float>::max)(), (std::numeric_limits<float>::max)() };
+    float hi[2] = { (std::numeric_limits<float>::lowest)(), (std::numeric_limits<float>::lowest)() };
+    bool any = false;
+
+    for (const auto& block : render_cache_.blocks())
+    {
+        if (!world.storage().get_table(block.tid).has(dynamic_id)) continue;
+
+        const MeshRefPN* meshes     = std::get<0>(block.arrays);
+        const Transform* transforms = std::get<1>(block.arrays);
+        const Bounds*    bounds     = std::get<4>(block.arrays);
+        for (std::size_t ei = 0; ei < block.n; ++ei)
+        {
+            if (!mesh_ref_has_vertices(meshes[ei]) || meshes[ei].tri_count == 0) continue;
+
+            const matrix to_light = m_shadow_light * transforms[ei].world;
+            const Bounds& b = bounds[ei];
+            for (int c = 0; c < 8; ++c)
+            {
+                const vec4 p = to_light * vec4((c & 1) ? b.local_max[0] : b.local_min[0],
+                                               (c & 2) ? b.local_max[1] : b.local_min[1],
+                                               (c & 4) ? b.local_max[2] : b.local_min[2], 1.f);
+                lo[0] = (std::min)(lo[0], p.x); hi[0] = (std::max)(hi[0], p.x);
+                lo[1] = (std::min)(lo[1], p.y); hi[1] = (std::max)(hi[1], p.y);
+            }
+            any = true;
+        }
+    }
+    if (!any) return false;
+
+    // Square, with a PCF footprint of margin so the casters' edges still read inside
+    const float half = 0.5f * (std::max)({ hi[0] - lo[0], hi[1] - lo[1], 0.01f }) * (1.f + 8.f / (float)kShadowOverlaySize);
+    const float cx = 0.5f * (lo[0] + hi[0]);
+    const float cy = 0.5f * (lo[1] + hi[1]);
+    box[0] = cx - half;
+    box[1] = cx + half;
+    box[2] = cy - half;
+    box[3] = cy + half;
+    return true;
+}
+
+std::uint32_t optimized_renderer_core::draw_shadow_map(shadow_map& map, bool dynamic, const float box[4]) noexcept
+{
+    static_assert(kShadowMapSize % kShadowBands == 0 && kShadowOverlaySize % kShadowBands == 0, "shadow bands must split the maps evenly");
+
+    map.casters = 0;
+    m_shadow_casters.clear();
+    const fecs::component_id dynamic_id = world.registry().get_id<DynamicCaster>();
+    const float texels_per_unit = (float)map.size / (box[1] - box[0]);
+    float z0 = (std::numeric_limits<float>::max)();
+    float z1 = (std::numeric_limits<float>::lowest)();
+
+    // Casters whose bounds reach over the box in x and y; z takes whatever they span
+    const auto consider = [&](const MeshRefPN& mesh, const Bounds& b, const matrix& world_m)
+    {
+        if (!mesh_ref_has_vertices(mesh) || mesh.tri_count == 0) return;
+
+        const matrix to_light = m_shadow_light * world_m;
+        float lo[3] = { (std::numeric_limits<float>::max)(), (std::numeric_limits<float>::max)(), (std::numeric_limits<float>::max)() };
+        float hi[3] = { (std::numeric_limits<float>::lowest)(), (std::numeric_limits<float>::lowest)(), (std::numeric_limits<float>::lowest)() };
+        for (int c = 0; c < 8; ++c)
+        {
+            const vec4 p = to_light * vec4((c & 1) ? b.local_max[0] : b.local_min[0],
+                                           (c & 2) ? b.local_max[1] : b.local_min[1],
+                                           (c & 4) ? b.local_max[2] : b.local_min[2], 1.f);
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                lo[k] = (std::min)(lo[k], p[k]);
+                hi[k] = (std::max)(hi[k], p[k]);
+            }
+        }
+        if (hi[0] < box[0] || lo[0] > box[1] || hi[1] < box[2] || lo[1] > box[3]) return;
+        z0 = (std::min)(z0, lo[2]);
+        z1 = (std::max)(z1, hi[2]);
+
+        // The coarsest level still finer than the map can show, as select_lod does on screen
+        const MeshRefPN* pick = &mesh;
+        if (m_job.lod_on && mesh.lod_count)
+        {
+            const float dx = hi[0] - lo[0], dy = hi[1] - lo[1], dz = hi[2] - lo[2];
+            const float radius_texels = 0.5f * std::sqrt(dx * dx + dy * dy + dz * dz) * texels_per_unit;
+            for (std::uint8_t i = 0; i < mesh.lod_count && radius_texels < mesh.lods[i].lod_radius_px; ++i)
+                pick = &mesh.lods[i];
+        }
+        m_shadow_casters.push_back({ pick, &world_m, 0 });
+    };
+
+    for (const auto& block : render_cache_.blocks())
+    {
+        if (world.storage().get_table(block.tid).has(dynamic_id) != dynamic) continue;
+
+        const MeshRefPN* meshes     = std::get<0>(block.arrays);
+        const Transform* transforms = std::get<1>(block.arrays);
+        const Bounds*    bounds     = std::get<4>(block.arrays);
+        for (std::size_t ei = 0; ei < block.n; ++ei)
+            consider(meshes[ei], bounds[ei], transforms[ei].world);
+    }
+    for (const auto& block : instanced_cache_.blocks())
+    {
+        if (world.storage().get_table(block.tid).has(dynamic_id) != dynamic) continue;
+
+        const MeshRefPN*          meshes    = std::get<0>(block.arrays);
+        const InstanceTransforms* instances = std::get<1>(block.arrays);
+        const Bounds*             bounds    = std::get<4>(block.arrays);
+        for (std::size_t ei = 0; ei < block.n; ++ei)
+            for (const Transform& tr : instances[ei].worlds)
+                consider(meshes[ei], bounds[ei], tr.world);
+    }
+    if (m_shadow_casters.empty()) return 0;
+
+    // A little slack either way so the nearest and farthest casters stay off the range's ends
+    const float pad = (z1 - z0) * 0.01f + 0.01f;
+    map.z0 = z0 - pad;
+    map.z1 = z1 + pad;
+    map.from_world = shadow_texel_matrix(m_shadow_light, box, map.z0, map.z1, map.size);
+    map.bias = (shadow_bias + 1.5f / texels_per_unit) / (map.z1 - map.z0);
+
+    std::size_t tris = 0;
+    for (shadow_caster& c : m_shadow_casters)
+    {
+        c.tri_begin = tris;
+        tris += c.mesh->tri_count;
+    }
+    m_shadow_tris.resize(tris);
+
+    // The same setup and raster as the occluders, sampled at texel centres, both windings drawn
+    run_parallel((std::uint32_t)m_shadow_casters.size(), kXformsPerTask, [&](std::uint32_t b, std::uint32_t e)
+    {
+        for (std::uint32_t i = b; i < e; ++i)
+        {
+            const shadow_caster& c = m_shadow_casters[i];
+            const MeshRefPN& mesh = *c.mesh;
+            const matrix world_texel = map.from_world * *c.world;
+            const matrix to_texel = mesh.quant ? world_texel * quant_position_matrix(*mesh.quant) : world_texel;
+
+            for (std::uint32_t t = 0; t < mesh.tri_count; ++t)
+            {
+                float x[3], y[3], z[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    const std::uint32_t v = mesh.indices ? mesh.indices[t * 3u + (std::uint32_t)k] : t * 3u + (std::uint32_t)k;
+                    const vec4 tp = to_texel * (mesh.quant ? quant_raw_position(mesh.quant->vertices()[v]) : mesh.positions[v]);
+                    x[k] = tp[0];
+                    y[k] = tp[1];
+                    z[k] = tp[2];
+                }
+                setup_depth_tri(m_shadow_tris[c.tri_begin + t], x, y, z, false, map.size, map.size);
+            }
+        }
+    });
+
+    map.depth.resize((std::size_t)map.size * (std::size_t)map.size);
+    const int rows = map.size / kShadowBands;
+    run_parallel((std::uint32_t)kShadowBands, 1, [&](std::uint32_t b, std::uint32_t e)
+    {
+        raster_depth_tris(m_shadow_tris, map.depth.data(), map.size, (int)b * rows, (int)e * rows - 1, m_job.isa);
+    });
+
+    map.casters = (std::uint32_t)m_shadow_casters.size();
+    return map.casters;
+}
+
+void optimized_renderer_core::shadow_screen_rect(const float box[4], float z0, float z1, const matrix& cam, int rect[4]) const noexcept
+{
+    rect[0] = 0;
+    rect[1] = 0;
+    rect[2] = m_tiles_x - 1;
+    rect[3] = m_tiles_y - 1;
+
+    const matrix to_clip = perspective * cam * rigid_inverse(m_shadow_light);
+    float minx = (std::numeric_limits<float>::max)(), maxx = (std::numeric_limits<float>::lowest)();
+    float miny = minx, maxy = maxx;
+    for (int c = 0; c < 8; ++c)
+    {
+        const vec4 hp = to_clip * vec4(box[c & 1], box[2 + ((c >> 1) & 1)], (c & 4) ? z1 : z0, 1.f);
+        if (hp[3] <= 1e-4f) return;
+        const float inv_w = 1.f / hp[3];
+        const float x = (hp[0] * inv_w + 1.f) * 0.5f * m_job.fw;
+        const float y = (1.f - hp[1] * inv_w) * 0.5f * m_job.fh;
+        minx = (std::min)(minx, x); maxx = (std::max)(maxx, x);
+        miny = (std::min)(miny, y); maxy = (std::max)(maxy, y);
+    }
+
+    if (maxx < 0.f || maxy < 0.f || minx >= m_job.fw || miny >= m_job.fh)
+    {
+        rect[2] = rect[3] = -1;
+        return;
+    }
+    rect[0] = (int)(std::max)(minx, 0.f) / kTileSize;
+    rect[1] = (int)(std::max)(miny, 0.f) / kTileSize;
+    rect[2] = (std::min)((int)maxx / kTileSize, m_tiles_x - 1);
+    rect[3] = (std::min)((int)maxy / kTileSize, m_tiles_y - 1);
+}
+
+void optimized_renderer_core::run_deferred() noexcept
+{
+    if (m_raster_pending)
+        raster_tiles();
+    clear_untouched_tiles();
+
+    if (m_post_pending)
+    {
+        m_post_pending = false;
+        apply_post_effects(m_post_deferred, m_rain_deferred, m_advanced_deferred, m_post_time_s);
+    }
+}
+
+void optimized_renderer_core::present_frame() noexcept
+{
+    run_deferred();
+    resolve_frame();
+    {
+        pass_timer wait(*this, frame_pass::present_wait);
+        canvas.present(cur_frame);
+    }
+    cur_frame = {};
+    framebuffer = {};
+    zbuffer = {};
+}
+
+void optimized_renderer_core::submit_frame_async() noexcept
+{
+    if (!m_render_thread.joinable())
+        m_render_thread = std::thread([this]() { render_thread_loop(); });
+
+    std::unique_lock<std::mutex> lk(m_render_mtx);
+    m_render_cv.wait(lk, [this]() { return !m_render_busy; });
+    m_render_busy = true;
+    lk.unlock();
+    m_render_cv.notify_all();
+}
+
+void optimized_renderer_core::wait_frame_in_flight() noexcept
+{
+    std::unique_lock<std::mutex> lk(m_render_mtx);
+    m_render_cv.wait(lk, [this]() { return !m_render_busy; });
+}
+
+bool optimized_renderer_core::frame_unchanged(std::uint32_t clear_rgba, const matrix& cam, const vec4& light_dir) const noexcept
+{
+    const frame_key& k = m_last_frame;
+    if (!k.valid || m_offline) return false;
+
+    // A checkerboard frame still holds pixels of the frame before until one repeats its inputs
+    if (m_checker_on && !m_checker_repeat) return false;
+    return frame_inputs_match(k, clear_rgba, cam, light_dir);
+}
+
+bool optimized_renderer_core::frame_inputs_match(const frame_key& k, std::uint32_t clear_rgba, const matrix& cam, const vec4& light_dir) const noexcept
+{
+    // Tile costs are timed afresh every frame
+    if (debug_mode == debug_view::tile_cost || effects_move_with_time(rainy_effect, advanced_effects)) return false;
+    if (k.clear_rgba != clear_rgba || k.world_version != world.version()) return false;
+    if (std::memcmp(&k.cam, &cam, sizeof(matrix)) != 0 || std::memcmp(&k.light_dir, &light_dir, sizeof(vec4)) != 0) return false;
+    if (k.settings != frame_settings_hash()) return false;
+
+    return !world.written_since<MeshRefPN, Transform, Material, TextureRef, Bounds, InstanceTransforms, PointLight>(k.tick);
+}
+
+void optimized_renderer_core::present_last_frame() noexcept
+{
+    wait_frame_in_flight();
+    if (!m_offline)
+        canvas.present_again();
+}
+
+std::uint64_t optimized_renderer_core::frame_settings_hash() const noexcept
+{
+    std::uint64_t h = kSignatureSeed;
+    mix_hash(h, ((std::uint64_t)canvas.width() << 32) | canvas.height());
+    for (unsigned r = 0; r < 4; ++r)
+        for (unsigned c = 0; c < 4; ++c)
+            mix_hash(h, perspective(r, c));
+
+    mix_hash(h, textures_enabled);
+    mix_hash(h, flip_v);
+    mix_hash(h, frustum_culling);
+    mix_hash(h, occlusion_culling);
+    mix_hash(h, cluster_culling);
+    mix_hash(h, sort_front_to_back);
+    mix_hash(h, wide_raster);
+    mix_hash(h, visibility_buffer);
+    mix_hash(h, depth_prepass);
+    mix_hash(h, checkerboard);
+    mix_hash(h, mesh_lod);
+    mix_hash(h, point_lights);
+    mix_hash(h, shadows);
+    mix_hash(h, shadow_distance);
+    mix_hash(h, shadow_update_degrees);
+    mix_hash(h, shadow_strength);
+    mix_hash(h, shadow_bias);
+    mix_hash(h, depth_mode);
+    mix_hash(h, debug_mode);
+    mix_hash(h, dynamic_resolution);
+    mix_hash(h, render_scale);
+
+    const post_process_settings& pp = post_process;
+    mix_hash(h, pp.enabled);
+    mix_hash(h, pp.exposure_enabled);
+    mix_hash(h, pp.exposure);
+    mix_hash(h, pp.contrast_enabled);
+    mix_hash(h, pp.contrast);
+    mix_hash(h, pp.saturation_enabled);
+    mix_hash(h, pp.saturation);
+    mix_hash(h, pp.vignette_enabled);
+    mix_hash(h, pp.vignette_strength);
+    mix_hash(h, pp.vignette_power);
+
+    // Rain is left out: while it is on it moves with time, and frame_unchanged gives up before this
+
+    const advanced_effects_settings& ae = advanced_effects;
+    mix_hash(h, ae.enabled);
+    mix_hash(h, ae.bloom_enabled);
+    mix_hash(h, ae.bloom_threshold);
+    mix_hash(h, ae.bloom_intensity);
+    mix_hash(h, ae.film_grain_enabled);
+    mix_hash(h, ae.film_grain_strength);
+    mix_hash(h, ae.motion_blur_enabled);
+    mix_hash(h, ae.motion_blur_strength);
+    mix_hash(h, ae.fog_enabled);
+    mix_hash(h, ae.fog_colour.r);
+    mix_hash(h, ae.fog_colour.g);
+    mix_hash(h, ae.fog_colour.b);
+    mix_hash(h, ae.fog_start);
+    mix_hash(h, ae.fog_end);
+    mix_hash(h, ae.ssr_enabled);
+    mix_hash(h, ae.ssr_strength);
+    mix_hash(h, ae.depth_of_field_enabled);
+    mix_hash(h, ae.dof_focus);
+    mix_hash(h, ae.dof_range);
+    mix_hash(h, ae.god_rays_enabled);
+    mix_hash(h, ae.god_rays_strength);
+    mix_hash(h, ae.god_rays_screen_pos.x);
+    mix_hash(h, ae.god_rays_screen_pos.y);
+    return h;
+}
+
+void optimized_renderer_core::render_thread_loop() noexcept
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lk(m_render_mtx);
+            m_render_cv.wait(lk, [this]() { return m_render_busy || m_render_quit; });
+            if (!m_render_busy)
+                return;
+        }
+
+        present_frame();
+
+        {
+            std::lock_guard<std::mutex> lk(m_render_mtx);
+            m_render_busy = false;
+        }
+        m_render_cv.notify_all();
+    }
+}
+
+void optimized_renderer_core::post_process_slice(int y0, int y1) const noexcept
+{
+    if (!framebuffer.data || framebuffer.w == 0 || framebuffer.h == 0) return;
+
+    const post_process_settings settings = m_job.post_settings;
+    if (!settings.enabled)
+        return;
+    if (!settings.exposure_enabled && !settings.contrast_enabled &&
+        !settings.saturation_enabled && !settings.vignette_enabled)
+        return;
+
+    const float inv_w = 1.f / static_cast<float>(framebuffer.w);
+    const float inv_h = 1.f / static_cast<float>(framebuffer.h);
+    const float half_w = 0.5f * static_cast<float>(framebuffer.w);
+    const float half_h = 0.5f * static_cast<float>(framebuffer.h);
+
+    const std::uint32_t W = framebuffer.w;
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        std::uint32_t* row = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
         const float fy = (static_cast<float>(y) - half_h) * inv_h;
 #ifdef USE_SIMD
         const __m128 inv255 = _mm_set1_ps(1.f / 255.f);
@@ -521,629 +2262,1837 @@ void optimized_renderer_core::post_process_slice(int y0, int y1) const noexcept
             __m128 g = _mm_mul_ps(_mm_cvtepi32_ps(g_i), inv255);
             __m128 b = _mm_mul_ps(_mm_cvtepi32_ps(b_i), inv255);
 
-            if (settings.exposure_enabled)
+            if (settings.exposure_enabled)
+            {
+                r = _mm_mul_ps(r, exposure_v);
+                g = _mm_mul_ps(g, exposure_v);
+                b = _mm_mul_ps(b, exposure_v);
+            }
+
+            if (settings.contrast_enabled)
+            {
+                r = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(r, half_v), contrast_v), half_v);
+                g = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(g, half_v), contrast_v), half_v);
+                b = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(b, half_v), contrast_v), half_v);
+            }
+
+            if (settings.saturation_enabled)
+            {
+                const __m128 lum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, lum_r), _mm_mul_ps(g, lum_g)), _mm_mul_ps(b, lum_b));
+                r = _mm_add_ps(lum, _mm_mul_ps(_mm_sub_ps(r, lum), saturation_v));
+                g = _mm_add_ps(lum, _mm_mul_ps(_mm_sub_ps(g, lum), saturation_v));
+                b = _mm_add_ps(lum, _mm_mul_ps(_mm_sub_ps(b, lum), saturation_v));
+            }
+
+            if (settings.vignette_enabled)
+            {
+                const __m128 x_v = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), step);
+                const __m128 fx = _mm_mul_ps(_mm_sub_ps(x_v, half_w_v), inv_w_v);
+                const __m128 dist2 = _mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy_v, fy_v));
+                alignas(16) float dist_vals[4];
+                _mm_store_ps(dist_vals, dist2);
+                float vignette_vals[4];
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    const float vignette = 1.f - settings.vignette_strength * std::pow(dist_vals[lane], settings.vignette_power);
+                    vignette_vals[lane] = vignette;
+                }
+                const __m128 vignette_v = _mm_loadu_ps(vignette_vals);
+                r = _mm_mul_ps(r, vignette_v);
+                g = _mm_mul_ps(g, vignette_v);
+                b = _mm_mul_ps(b, vignette_v);
+            }
+
+            r = _mm_min_ps(_mm_max_ps(r, zero), one);
+            g = _mm_min_ps(_mm_max_ps(g, zero), one);
+            b = _mm_min_ps(_mm_max_ps(b, zero), one);
+
+            const __m128i r_out = _mm_cvtps_epi32(_mm_mul_ps(r, _mm_set1_ps(255.f)));
+            const __m128i g_out = _mm_cvtps_epi32(_mm_mul_ps(g, _mm_set1_ps(255.f)));
+            const __m128i b_out = _mm_cvtps_epi32(_mm_mul_ps(b, _mm_set1_ps(255.f)));
+
+            const __m128i packed = _mm_or_si128(
+                _mm_or_si128(_mm_slli_epi32(b_out, 16), _mm_slli_epi32(g_out, 8)),
+                _mm_or_si128(r_out, _mm_set1_epi32(0xFF000000u))
+            );
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), packed);
+        }
+
+        for (; x < W; ++x)
+#else
+        for (std::uint32_t x = 0; x < W; ++x)
+#endif
+        {
+            float r, g, b;
+            unpack_rgba8(row[x], r, g, b);
+
+            if (settings.exposure_enabled)
+            {
+                r *= settings.exposure;
+                g *= settings.exposure;
+                b *= settings.exposure;
+            }
+
+            if (settings.contrast_enabled)
+            {
+                r = (r - 0.5f) * settings.contrast + 0.5f;
+                g = (g - 0.5f) * settings.contrast + 0.5f;
+                b = (b - 0.5f) * settings.contrast + 0.5f;
+            }
+
+            if (settings.saturation_enabled)
+            {
+                const float lum = r * 0.2126f + g * 0.7152f + b * 0.0722f;
+                r = lum + (r - lum) * settings.saturation;
+                g = lum + (g - lum) * settings.saturation;
+                b = lum + (b - lum) * settings.saturation;
+            }
+
+            if (settings.vignette_enabled)
+            {
+                const float fx = (static_cast<float>(x) - half_w) * inv_w;
+                const float dist2 = fx * fx + fy * fy;
+                const float vignette = 1.f - settings.vignette_strength * std::pow(dist2, settings.vignette_power);
+                r *= vignette;
+                g *= vignette;
+                b *= vignette;
+            }
+
+            row[x] = pack_rgba8_from_rgb(r, g, b);
+        }
+    }
+}
+
+void optimized_renderer_core::prepare_rain_columns(const rainy_effect_settings& settings, float time_s) noexcept
+{
+    const std::uint32_t W = framebuffer.w;
+    m_rain_phase.resize(W);
+    m_rain_jitter.resize(W);
+
+    const float probability = clamp01(settings.streak_probability);
+    const float shift = (settings.wind - settings.streak_speed) * time_s;
+    for (std::uint32_t x = 0; x < W; ++x)
+    {
+        const float column_seed = hash_unit(x * 0x9E3779B9u);
+        m_rain_phase[x] = column_seed * 10.f + shift;
+        m_rain_jitter[x] = (column_seed <= probability) ? 0.75f + 0.25f * std::sin((float)x * 0.15f + time_s) : 0.f;
+    }
+}
+
+void optimized_renderer_core::rainy_effect_slice(int y0, int y1) const noexcept
+{
+    if (!framebuffer.data || framebuffer.w == 0 || framebuffer.h == 0) return;
+    if (!zbuffer.valid()) return;
+
+    const rainy_effect_settings settings = m_job.rain_settings;
+    if (!settings.enabled || settings.intensity <= 0.f) return;
+
+    const std::uint32_t W = framebuffer.w;
+    if (m_rain_phase.size() < W) return;
+
+    const float drop_density = settings.streak_density;
+    const float inv_length = 1.f / ((settings.streak_length > 0.001f) ? settings.streak_length : 0.001f);
+    const float depth_weight = settings.depth_weight;
+    const float depth_bias = settings.depth_bias;
+    const float tint_r = settings.tint.r;
+    const float tint_g = settings.tint.g;
+    const float tint_b = settings.tint.b;
+    const float* phase_x = m_rain_phase.data();
+    const float* jitter_x = m_rain_jitter.data();
+
+    fox::scratch_scope scratch(m_frame_arenas);
+    float* depth_row = zbuffer.data16 ? scratch.allocate<float>(W) : nullptr;
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        std::uint32_t* row = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
+        const float fy = static_cast<float>(framebuffer.h - 1u - static_cast<std::uint32_t>(y));
+        const float row_phase = fy * drop_density;
+
+        const float* zrow = zbuffer.data + (std::size_t)y * (std::size_t)zbuffer.pitch;
+        if (zbuffer.data16)
+        {
+            const std::uint16_t* qrow = zbuffer.data16 + (std::size_t)y * (std::size_t)zbuffer.pitch;
+            for (std::uint32_t x = 0; x < W; ++x)
+                depth_row[x] = depth16_decode(qrow[x]);
+            zrow = depth_row;
+        }
+
+        std::uint32_t x = 0;
+#ifdef USE_SIMD
+        if (m_job.isa == raster_isa::avx2)
+            x = rain_row_avx2(settings, row, zrow, row_phase, inv_length, W);
+#endif
+        for (; x < W; ++x)
+        {
+            const float jitter = jitter_x[x];
+            if (jitter <= 0.f)
+                continue;
+
+            const float phase = fract(row_phase + phase_x[x]);
+            const float streak = 1.f - phase * inv_length;
+            if (streak <= 0.f)
+                continue;
+
+            const float depth_factor = clamp01(depth_bias + (1.f - zrow[x]) * depth_weight);
+            const float drop = streak * settings.intensity * depth_factor * jitter;
+            if (drop <= 0.f)
+                continue;
+
+            float r, g, b;
+            unpack_rgba8(row[x], r, g, b);
+
+            const float darken = 1.f - drop * settings.darken;
+            r = r * darken + tint_r * drop;
+            g = g * darken + tint_g * drop;
+            b = b * darken + tint_b * drop;
+
+            row[x] = pack_rgba8_from_rgb(r, g, b);
+        }
+    }
+}
+
+void optimized_renderer_core::build_blur_chain(const advanced_effects_settings& settings) noexcept
+{
+    const std::uint32_t W = framebuffer.w;
+    const std::uint32_t H = framebuffer.h;
+    blur_chain& c = m_blur_chain;
+
+    c.half.resize((W + 1u) / 2u, (H + 1u) / 2u, W, H);
+    c.quarter.resize((c.half.w + 1u) / 2u, (c.half.h + 1u) / 2u, W, H);
+    for_each_row_block(c.half.h, [&](int y0, int y1)
+    {
+        downsample2(c.half.rgba.data(), c.half.w, framebuffer.data, framebuffer.pitch_pixels, W, H, y0, y1);
+    });
+    for_each_row_block(c.quarter.h, [&](int y0, int y1)
+    {
+        downsample2(c.quarter.rgba.data(), c.quarter.w, c.half.rgba.data(), c.half.w, c.half.w, c.half.h, y0, y1);
+    });
+
+    const std::size_t quarter_count = c.quarter.rgba.size();
+    c.scratch.resize(quarter_count);
+
+    if (settings.bloom_enabled)
+    {
+        // Only what lies above the threshold glows, scaled down so its luminance is the excess
+        c.bloom.resize(quarter_count);
+        const float threshold = settings.bloom_threshold;
+        for_each_row_block(c.quarter.h, [&](int y0, int y1)
+        {
+            const std::size_t b = (std::size_t)y0 * c.quarter.w;
+            const std::size_t e = (std::size_t)(y1 + 1) * c.quarter.w;
+            for (std::size_t i = b; i < e; ++i)
+            {
+                float r, g, bl;
+                unpack_rgba8(c.quarter.rgba[i], r, g, bl);
+                const float lum = r * 0.2126f + g * 0.7152f + bl * 0.0722f;
+                const float k = (lum > threshold) ? (lum - threshold) / lum : 0.f;
+                c.bloom[i] = pack_rgba8_from_rgb(r * k, g * k, bl * k);
+            }
+        });
+
+        // Twice over for a wider glow, still a fixed cost
+        blur_quarter(c.bloom);
+        blur_quarter(c.bloom);
+    }
+    else
+    {
+        c.bloom.clear();
+    }
+
+    if (settings.depth_of_field_enabled)
+    {
+        c.dof.assign(c.quarter.rgba.begin(), c.quarter.rgba.end());
+        blur_quarter(c.dof);
+    }
+    else
+    {
+        c.dof.clear();
+    }
+}
+
+void optimized_renderer_core::blur_quarter(std::vector<std::uint32_t>& img) noexcept
+{
+    blur_chain& c = m_blur_chain;
+    for_each_row_block(c.quarter.h, [&](int y0, int y1)
+    {
+        blur5_rows(c.scratch.data(), img.data(), c.quarter.w, y0, y1);
+    });
+    for_each_row_block(c.quarter.h, [&](int y0, int y1)
+    {
+        blur5_cols(img.data(), c.scratch.data(), c.quarter.w, c.quarter.h, y0, y1);
+    });
+}
+
+void optimized_renderer_core::advanced_effects_slice(int y0, int y1) const noexcept
+{
+    if (!framebuffer.data || framebuffer.w == 0 || framebuffer.h == 0) return;
+
+    const advanced_effects_settings settings = m_job.advanced_settings;
+    if (!settings.enabled)
+        return;
+
+    const std::uint32_t W = framebuffer.w;
+    const std::uint32_t H = framebuffer.h;
+    const bool use_depth = (settings.fog_enabled || settings.depth_of_field_enabled || settings.ssr_enabled);
+    const std::uint32_t grain_seed = (std::uint32_t)(m_job.time_s * settings.film_grain_speed * 60.f);
+
+    // Built by apply_advanced_effects right before this sweep; the fused sweep never has them on
+    const blur_chain& chain = m_blur_chain;
+    const bool bloom_on = settings.bloom_enabled && !chain.bloom.empty();
+    const bool dof_on = settings.depth_of_field_enabled && !chain.dof.empty();
+
+    const float fog_inv_range = 1.f / (std::max)(0.001f, settings.fog_end - settings.fog_start);
+    const float dof_inv_range = 1.f / (std::max)(0.001f, settings.dof_range);
+    const float mb = clamp01(settings.motion_blur_strength);
+    const float fx_scale = 1.f / (std::max)(1.f, static_cast<float>(W - 1u));
+    const float fy_scale = 1.f / (std::max)(1.f, static_cast<float>(H - 1u));
+
+    // Per row: the unmodified row with a clamped pixel either side, the depth row when it is 16 bit,
+    // and the blur chain upsampled to it, so both the vector and scalar loops only read rows
+    fox::scratch_scope scratch(m_frame_arenas);
+    std::uint32_t* row_copy = scratch.allocate<std::uint32_t>(W + 2u) + 1;
+    float* depth_row = (use_depth && zbuffer.data16) ? scratch.allocate<float>(W) : nullptr;
+    std::uint32_t* bloom_row = bloom_on ? scratch.allocate<std::uint32_t>(W) : nullptr;
+    std::uint32_t* half_row = dof_on ? scratch.allocate<std::uint32_t>(W) : nullptr;
+    std::uint32_t* quarter_row = dof_on ? scratch.allocate<std::uint32_t>(W) : nullptr;
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        std::uint32_t* row = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
+        const float* zrow = nullptr;
+        if (use_depth && zbuffer.data16)
+        {
+            // Decode the row once, the effects below index it freely
+            const std::uint16_t* qrow = zbuffer.data16 + (std::size_t)y * (std::size_t)zbuffer.pitch;
+            for (std::uint32_t x = 0; x < W; ++x)
+                depth_row[x] = depth16_decode(qrow[x]);
+            zrow = depth_row;
+        }
+        else if (use_depth && zbuffer.data)
+        {
+            zrow = zbuffer.data + (std::size_t)y * (std::size_t)zbuffer.pitch;
+        }
+        const bool depth_on = zrow != nullptr;
+
+        std::copy_n(row, W, row_copy);
+        row_copy[-1] = row_copy[0];
+        row_copy[W] = row_copy[W - 1u];
+
+        const std::uint32_t quarter_y = (bloom_on || dof_on) ? chain.quarter.taps_y[y] : 0u;
+        if (bloom_on)
+        {
+            for (std::uint32_t x = 0; x < W; ++x)
+                bloom_row[x] = sample_rgba8(chain.bloom.data(), chain.quarter.w, chain.quarter.taps_x[x], quarter_y);
+        }
+        if (dof_on)
+        {
+            const std::uint32_t half_y = chain.half.taps_y[y];
+            for (std::uint32_t x = 0; x < W; ++x)
+            {
+                half_row[x] = sample_rgba8(chain.half.rgba.data(), chain.half.w, chain.half.taps_x[x], half_y);
+                quarter_row[x] = sample_rgba8(chain.dof.data(), chain.quarter.w, chain.quarter.taps_x[x], quarter_y);
+            }
+        }
+
+        const std::uint32_t* mirror_row = framebuffer.data + (std::size_t)((H - 1u) - static_cast<std::uint32_t>(y)) * (std::size_t)framebuffer.pitch_pixels;
+        const float god_dy = static_cast<float>(y) * fy_scale - settings.god_rays_screen_pos.y;
+        const std::uint32_t grain_row = grain_seed ^ ((std::uint32_t)y * 0x85EBCA77u);
+
+        std::uint32_t x = 0;
+#ifdef USE_SIMD
+        if (m_job.isa == raster_isa::avx2)
+        {
+            const effects_row er{ settings, row, row_copy, zrow, bloom_row, half_row, quarter_row, mirror_row,
+                                  fog_inv_range, dof_inv_range, mb, fx_scale, god_dy, grain_row, W, bloom_on, dof_on };
+            x = advanced_effects_row_avx2(er);
+        }
+#endif
+        for (; x < W; ++x)
+        {
+            float r, g, b;
+            unpack_rgba8(row_copy[x], r, g, b);
+
+            if (bloom_on)
+            {
+                float br, bg, bb;
+                unpack_rgba8(bloom_row[x], br, bg, bb);
+                r += br * settings.bloom_intensity;
+                g += bg * settings.bloom_intensity;
+                b += bb * settings.bloom_intensity;
+            }
+
+            const float depth = depth_on ? clamp01(zrow[x]) : 0.f;
+
+            if (settings.fog_enabled)
+            {
+                const float fog_t = clamp01((depth - settings.fog_start) * fog_inv_range);
+                r = r + (settings.fog_colour.r - r) * fog_t;
+                g = g + (settings.fog_colour.g - g) * fog_t;
+                b = b + (settings.fog_colour.b - b) * fog_t;
+            }
+
+            if (settings.ssr_enabled)
+            {
+                float rr, rg, rb;
+                unpack_rgba8(mirror_row[x], rr, rg, rb);
+                const float reflect = settings.ssr_strength * (1.f - depth);
+                r = r + (rr - r) * reflect;
+                g = g + (rg - g) * reflect;
+                b = b + (rb - b) * reflect;
+            }
+
+            if (dof_on)
             {
-                r = _mm_mul_ps(r, exposure_v);
-                g = _mm_mul_ps(g, exposure_v);
-                b = _mm_mul_ps(b, exposure_v);
+                // Sharp to the half size frame over the first half of the range, then on to the
+                // blurred quarter, so the circle of confusion grows without taking more taps
+                const float blur_t = clamp01(std::fabs(depth - settings.dof_focus) * dof_inv_range);
+                float hr, hg, hb, qr, qg, qb;
+                unpack_rgba8(half_row[x], hr, hg, hb);
+                unpack_rgba8(quarter_row[x], qr, qg, qb);
+                const float q = clamp01((blur_t - 0.5f) * 2.f);
+                const float k = (std::min)(blur_t * 2.f, 1.f);
+                r = r + (hr + (qr - hr) * q - r) * k;
+                g = g + (hg + (qg - hg) * q - g) * k;
+                b = b + (hb + (qb - hb) * q - b) * k;
             }
 
-            if (settings.contrast_enabled)
+            if (settings.god_rays_enabled)
             {
-                r = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(r, half_v), contrast_v), half_v);
-                g = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(g, half_v), contrast_v), half_v);
-                b = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(b, half_v), contrast_v), half_v);
+                const float dx = static_cast<float>(x) * fx_scale - settings.god_rays_screen_pos.x;
+                const float dist = std::sqrt(dx * dx + god_dy * god_dy);
+                const float shaft = clamp01(1.f - dist * 1.5f) * settings.god_rays_strength;
+                r += shaft;
+                g += shaft;
+                b += shaft;
             }
 
-            if (settings.saturation_enabled)
+            if (settings.motion_blur_enabled)
             {
-                const __m128 lum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, lum_r), _mm_mul_ps(g, lum_g)), _mm_mul_ps(b, lum_b));
-                r = _mm_add_ps(lum, _mm_mul_ps(_mm_sub_ps(r, lum), saturation_v));
-                g = _mm_add_ps(lum, _mm_mul_ps(_mm_sub_ps(g, lum), saturation_v));
-                b = _mm_add_ps(lum, _mm_mul_ps(_mm_sub_ps(b, lum), saturation_v));
+                float mr0, mg0, mb0;
+                float mr1, mg1, mb1;
+                unpack_rgba8(row_copy[(int)x - 1], mr0, mg0, mb0);
+                unpack_rgba8(row_copy[x + 1u], mr1, mg1, mb1);
+                r = r + ((mr0 + mr1) * 0.5f - r) * mb;
+                g = g + ((mg0 + mg1) * 0.5f - g) * mb;
+                b = b + ((mb0 + mb1) * 0.5f - b) * mb;
             }
 
-            if (settings.vignette_enabled)
+            if (settings.film_grain_enabled)
             {
-                const __m128 x_v = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), step);
-                const __m128 fx = _mm_mul_ps(_mm_sub_ps(x_v, half_w_v), inv_w_v);
-                const __m128 dist2 = _mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy_v, fy_v));
-                alignas(16) float dist_vals[4];
-                _mm_store_ps(dist_vals, dist2);
-                float vignette_vals[4];
-                for (int lane = 0; lane < 4; ++lane)
-                {
-                    const float vignette = 1.f - settings.vignette_strength * std::pow(dist_vals[lane], settings.vignette_power);
-                    vignette_vals[lane] = vignette;
-                }
-                const __m128 vignette_v = _mm_loadu_ps(vignette_vals);
-                r = _mm_mul_ps(r, vignette_v);
-                g = _mm_mul_ps(g, vignette_v);
-                b = _mm_mul_ps(b, vignette_v);
+                const float grain = (hash_unit((x * 0x9E3779B1u) ^ grain_row) - 0.5f) * settings.film_grain_strength;
+                r += grain;
+                g += grain;
+                b += grain;
             }
 
-            r = _mm_min_ps(_mm_max_ps(r, zero), one);
-            g = _mm_min_ps(_mm_max_ps(g, zero), one);
-            b = _mm_min_ps(_mm_max_ps(b, zero), one);
+            row[x] = pack_rgba8_from_rgb(r, g, b);
+        }
+    }
+}
 
-            const __m128i r_out = _mm_cvtps_epi32(_mm_mul_ps(r, _mm_set1_ps(255.f)));
-            const __m128i g_out = _mm_cvtps_epi32(_mm_mul_ps(g, _mm_set1_ps(255.f)));
-            const __m128i b_out = _mm_cvtps_epi32(_mm_mul_ps(b, _mm_set1_ps(255.f)));
+void optimized_renderer_core::extract_frustum_planes() noexcept
+{
+    // Clip space keeps -w <= x, y <= w and 0 <= z <= w, so each plane is a row combination of vp
+    const matrix& m = m_job.vp;
+    for (int k = 0; k < 4; ++k)
+    {
+        const float r0 = m(0, k), r1 = m(1, k), r2 = m(2, k), r3 = m(3, k);
+        float* lane = m_job.planes[k];
+        lane[0] = r3 + r0;
+        lane[1] = r3 - r0;
+        lane[2] = r3 + r1;
+        lane[3] = r3 - r1;
+        lane[4] = r2;
+        lane[5] = r3 - r2;
+        lane[6] = lane[5];
+        lane[7] = lane[5];
+    }
 
-            const __m128i packed = _mm_or_si128(
-                _mm_or_si128(_mm_slli_epi32(b_out, 16), _mm_slli_epi32(g_out, 8)),
-                _mm_or_si128(r_out, _mm_set1_epi32(0xFF000000u))
-            );
-            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), packed);
-        }
+    const auto& pl = m_job.planes;
+    for (int i = 0; i < 8; ++i)
+    {
+        const float len = std::sqrt(pl[0][i] * pl[0][i] + pl[1][i] * pl[1][i] + pl[2][i] * pl[2][i]);
+        m_job.plane_inv_len[i] = len > 0.f ? 1.f / len : 0.f;
+    }
+}
 
-        for (; x < W; ++x)
+bool optimized_renderer_core::sphere_outside_frustum(const vec4& centre, float radius) const noexcept
+{
+    const auto& pl = m_job.planes;
+    for (int k = 0; k < 6; ++k)
+    {
+        const float dist = pl[0][k] * centre[0] + pl[1][k] * centre[1] + pl[2][k] * centre[2] + pl[3][k];
+        if (dist * m_job.plane_inv_len[k] < -radius) return true;
+    }
+    return false;
+}
+
+bool optimized_renderer_core::entity_outside_frustum(const draw_job_shared& job, const Bounds& b, const matrix& world) const noexcept
+{
+    const float lc[3] = {
+        (b.local_min[0] + b.local_max[0]) * 0.5f,
+        (b.local_min[1] + b.local_max[1]) * 0.5f,
+        (b.local_min[2] + b.local_max[2]) * 0.5f };
+    const float le[3] = {
+        (b.local_max[0] - b.local_min[0]) * 0.5f,
+        (b.local_max[1] - b.local_min[1]) * 0.5f,
+        (b.local_max[2] - b.local_min[2]) * 0.5f };
+
+    // World AABB around the transformed box: centre moves, extent takes the absolute rotation
+    float c[3], e[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        c[i] = world(i, 0) * lc[0] + world(i, 1) * lc[1] + world(i, 2) * lc[2] + world(i, 3);
+        e[i] = std::fabs(world(i, 0)) * le[0] + std::fabs(world(i, 1)) * le[1] + std::fabs(world(i, 2)) * le[2];
+    }
+
+    const auto& pl = job.planes;
+#ifdef USE_SIMD
+    const __m128 sign_mask = _mm_set1_ps(-0.f);
+    const __m128 cx = _mm_set1_ps(c[0]), cy = _mm_set1_ps(c[1]), cz = _mm_set1_ps(c[2]);
+    const __m128 ex = _mm_set1_ps(e[0]), ey = _mm_set1_ps(e[1]), ez = _mm_set1_ps(e[2]);
+    for (int g = 0; g < 8; g += 4)
+    {
+        const __m128 a  = _mm_load_ps(pl[0] + g);
+        const __m128 bb = _mm_load_ps(pl[1] + g);
+        const __m128 cc = _mm_load_ps(pl[2] + g);
+        const __m128 d  = _mm_load_ps(pl[3] + g);
+
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, cx), _mm_mul_ps(bb, cy)), _mm_add_ps(_mm_mul_ps(cc, cz), d));
+        __m128 rad  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, a), ex),
+                                            _mm_mul_ps(_mm_andnot_ps(sign_mask, bb), ey)),
+                                 _mm_mul_ps(_mm_andnot_ps(sign_mask, cc), ez));
+        if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, rad), _mm_setzero_ps())))
+            return true;
+    }
+    return false;
 #else
-        for (std::uint32_t x = 0; x < W; ++x)
+    for (int k = 0; k < 6; ++k)
+    {
+        const float dist = pl[0][k] * c[0] + pl[1][k] * c[1] + pl[2][k] * c[2] + pl[3][k];
+        const float rad  = std::fabs(pl[0][k]) * e[0] + std::fabs(pl[1][k]) * e[1] + std::fabs(pl[2][k]) * e[2];
+        if (dist + rad < 0.f) return true;
+    }
+    return false;
 #endif
+}
+
+float optimized_renderer_core::view_depth_of(const draw_job_shared& job, const Bounds& b, const matrix& world) const noexcept
+{
+    const vec4 centre(
+        (b.local_min[0] + b.local_max[0]) * 0.5f,
+        (b.local_min[1] + b.local_max[1]) * 0.5f,
+        (b.local_min[2] + b.local_max[2]) * 0.5f,
+        1.f);
+    const vec4 wc = world * centre;
+    const matrix& vp = job.vp;
+    return vp(3, 0) * wc[0] + vp(3, 1) * wc[1] + vp(3, 2) * wc[2] + vp(3, 3);
+}
+
+float optimized_renderer_core::screen_radius_px(const draw_job_shared& job, const Bounds& b, const matrix& world) const noexcept
+{
+    // Camera at or inside the bounds centre: treat it as covering the screen
+    const float w = view_depth_of(job, b, world);
+    if (w <= 0.f) return std::numeric_limits<float>::infinity();
+
+    float scale2 = 0.f;
+    for (int c = 0; c < 3; ++c)
+        scale2 = (std::max)(scale2, world(0, c) * world(0, c) + world(1, c) * world(1, c) + world(2, c) * world(2, c));
+
+    const float dx = b.local_max[0] - b.local_min[0];
+    const float dy = b.local_max[1] - b.local_min[1];
+    const float dz = b.local_max[2] - b.local_min[2];
+    const float radius = 0.5f * std::sqrt((dx * dx + dy * dy + dz * dz) * scale2);
+    return radius * job.lod_px_scale / w;
+}
+
+const MeshRefPN& optimized_renderer_core::select_lod(const draw_job_shared& job, const MeshRefPN& mesh, const Bounds& b, const matrix& world) const noexcept
+{
+    if (!job.lod_on || mesh.lod_count == 0) return mesh;
+
+    const float radius_px = screen_radius_px(job, b, world);
+    const MeshRefPN* pick = &mesh;
+    for (std::uint8_t i = 0; i < mesh.lod_count && radius_px < mesh.lods[i].lod_radius_px; ++i)
+        pick = &mesh.lods[i];
+    return *pick;
+}
+
+const MeshRefPN* optimized_renderer_core::place_entity(const MeshRefPN& mesh, const Bounds& b, const matrix& world) const noexcept
+{
+    if (m_geo_views.empty())
+        return (m_job.cull_on && entity_outside_frustum(b, world)) ? nullptr : &select_lod(mesh, b, world);
+
+    // Shared by views: kept while any view sees it, at the finest level any of them picks
+    const MeshRefPN* pick = nullptr;
+    for (const draw_job_shared& job : m_geo_views)
+    {
+        if (job.cull_on && entity_outside_frustum(job, b, world)) continue;
+        const MeshRefPN& lod = select_lod(job, mesh, b, world);
+        if (!pick || lod.tri_count > pick->tri_count)
+            pick = &lod;
+    }
+    return pick;
+}
+
+std::uint32_t optimized_renderer_core::triangle_density_rgba(const MeshRefPN& mesh, const Bounds& b, const matrix& world) const noexcept
+{
+    // Blue at a triangle per 256 pixels of the bounds' screen disc, red at one per pixel and up
+    const float r = screen_radius_px(b, world);
+    const float area = 3.14159265f * r * r;
+    if (!(area < std::numeric_limits<float>::infinity())) return heat_rgba(0.f);
+
+    const float density = (float)mesh.tri_count / (std::max)(area, 1.f);
+    return heat_rgba((std::log2((std::max)(density, 1e-6f)) + 8.f) * 0.125f);
+}
+
+void optimized_renderer_core::build_geometry_entities() noexcept
+{
+    m_geo_entities.clear();
+    m_geo_tri_total = 0;
+    m_geo_vtx_total = 0;
+    m_draw_stats = {};
+
+    float max_depth = 0.f;
+    for (const auto& block : render_cache_.blocks())
+    {
+        const MeshRefPN*  meshes     = std::get<0>(block.arrays);
+        const Transform*  transforms = std::get<1>(block.arrays);
+        const Material*   materials  = std::get<2>(block.arrays);
+        const TextureRef* textures   = std::get<3>(block.arrays);
+        const Bounds*     bounds     = std::get<4>(block.arrays);
+
+        for (std::size_t ei = 0; ei < block.n; ++ei)
         {
-            float r, g, b;
-            unpack_rgba8(row[x], r, g, b);
+            const MeshRefPN& mesh = meshes[ei];
+            if (!mesh_ref_has_vertices(mesh) || mesh.tri_count == 0) continue;
 
-            if (settings.exposure_enabled)
+            ++m_draw_stats.entities_total;
+            const MeshRefPN* placed = place_entity(mesh, bounds[ei], transforms[ei].world);
+            if (!placed)
             {
-                r *= settings.exposure;
-                g *= settings.exposure;
-                b *= settings.exposure;
+                ++m_draw_stats.entities_culled;
+                m_draw_stats.triangles_culled += mesh.tri_count;
+                continue;
             }
 
-            if (settings.contrast_enabled)
+            const MeshRefPN& lod = *placed;
+
+            geo_entity ge{};
+            ge.mesh      = &lod;
+            ge.transform = &transforms[ei];
+            ge.material  = &materials[ei];
+            ge.texture   = &textures[ei];
+            ge.bounds    = &bounds[ei];
+            ge.hull      = mesh.lod_count ? &mesh.lods[mesh.lod_count - 1] : &mesh;
+            ge.vtx_count = lod.indices ? lod.vertex_count : 0u;
+            if (m_debug_view == debug_view::triangle_density)
+                ge.debug_rgba = triangle_density_rgba(lod, bounds[ei], transforms[ei].world);
+
+            if (m_job.sort_on)
             {
-                r = (r - 0.5f) * settings.contrast + 0.5f;
-                g = (g - 0.5f) * settings.contrast + 0.5f;
-                b = (b - 0.5f) * settings.contrast + 0.5f;
+                ge.view_depth = view_depth_of(bounds[ei], transforms[ei].world);
+                max_depth = (std::max)(max_depth, ge.view_depth);
             }
 
-            if (settings.saturation_enabled)
+            m_geo_entities.push_back(ge);
+        }
+    }
+
+    // Instances of one entity stay adjacent so its vertices and indices remain hot between them.
+    // They are ordered front to back among themselves and share the nearest depth as their sort key;
+    // the radix sort is stable, so the run stays contiguous.
+    for (const auto& block : instanced_cache_.blocks())
+    {
+        const MeshRefPN*          meshes    = std::get<0>(block.arrays);
+        const InstanceTransforms* instances = std::get<1>(block.arrays);
+        const Material*           materials = std::get<2>(block.arrays);
+        const TextureRef*         textures  = std::get<3>(block.arrays);
+        const Bounds*             bounds    = std::get<4>(block.arrays);
+
+        for (std::size_t ei = 0; ei < block.n; ++ei)
+        {
+            const MeshRefPN& mesh = meshes[ei];
+            if (!mesh_ref_has_vertices(mesh) || mesh.tri_count == 0) continue;
+
+            const std::size_t run_begin = m_geo_entities.size();
+            for (const Transform& tr : instances[ei].worlds)
             {
-                const float lum = r * 0.2126f + g * 0.7152f + b * 0.0722f;
-                r = lum + (r - lum) * settings.saturation;
-                g = lum + (g - lum) * settings.saturation;
-                b = lum + (b - lum) * settings.saturation;
+                ++m_draw_stats.entities_total;
+                const MeshRefPN* placed = place_entity(mesh, bounds[ei], tr.world);
+                if (!placed)
+                {
+                    ++m_draw_stats.entities_culled;
+                    m_draw_stats.triangles_culled += mesh.tri_count;
+                    continue;
+                }
+
+                const MeshRefPN& lod = *placed;
+
+                geo_entity ge{};
+                ge.mesh      = &lod;
+                ge.transform = &tr;
+                ge.material  = &materials[ei];
+                ge.texture   = &textures[ei];
+                ge.bounds    = &bounds[ei];
+                ge.hull      = mesh.lod_count ? &mesh.lods[mesh.lod_count - 1] : &mesh;
+                ge.vtx_count = lod.indices ? lod.vertex_count : 0u;
+                if (m_debug_view == debug_view::triangle_density)
+                    ge.debug_rgba = triangle_density_rgba(lod, bounds[ei], tr.world);
+                if (m_job.sort_on)
+                    ge.view_depth = view_depth_of(bounds[ei], tr.world);
+                m_geo_entities.push_back(ge);
             }
 
-            if (settings.vignette_enabled)
+            if (!m_job.sort_on || m_geo_entities.size() == run_begin) continue;
+
+            const auto run = m_geo_entities.begin() + (std::ptrdiff_t)run_begin;
+            std::sort(run, m_geo_entities.end(), [](const geo_entity& a, const geo_entity& b) { return a.view_depth < b.view_depth; });
+
+            const float nearest = (std::max)(run->view_depth, 0.f);
+            for (auto it = run; it != m_geo_entities.end(); ++it)
             {
-                const float fx = (static_cast<float>(x) - half_w) * inv_w;
-                const float dist2 = fx * fx + fy * fy;
-                const float vignette = 1.f - settings.vignette_strength * std::pow(dist2, settings.vignette_power);
-                r *= vignette;
-                g *= vignette;
-                b *= vignette;
+                max_depth = (std::max)(max_depth, it->view_depth);
+                it->view_depth = nearest;
             }
+        }
+    }
 
-            row[x] = pack_rgba8_from_rgb(r, g, b);
+    // Occluders are rastered for one screen, so a list shared by views keeps what any of them hides
+    if (m_job.occlusion_on && m_geo_views.empty() && m_geo_entities.size() > 1)
+        cull_occluded_entities();
+
+    // Coarse front to back order; the raster keeps submission order, so nearer entities fill depth first
+    if (m_job.sort_on && max_depth > 0.f)
+    {
+        const float scale = 65535.f / max_depth;
+        for (geo_entity& ge : m_geo_entities)
+            ge.depth_key = (ge.view_depth > 0.f) ? (std::uint16_t)(std::min)(ge.view_depth * scale, 65535.f) : 0u;
+
+        radix_sort_u16(m_geo_entities, m_geo_sort_scratch, [](const geo_entity& ge) { return (std::uint32_t)ge.depth_key; });
+    }
+
+    for (geo_entity& ge : m_geo_entities)
+    {
+        ge.tri_begin = m_geo_tri_total;
+        ge.vtx_begin = m_geo_vtx_total;
+        m_geo_tri_total += ge.mesh->tri_count;
+        m_geo_vtx_total += ge.vtx_count;
+    }
+
+    m_draw_stats.triangles_submitted = (std::uint32_t)m_geo_tri_total;
+}
+
+void optimized_renderer_core::cull_occluded_entities() noexcept
+{
+    // Occluders: the largest on screen first, within the count and triangle budgets
+    m_occluders.clear();
+    const float min_radius = m_job.fh * kOccluderMinRadius;
+    for (std::uint32_t i = 0; i < (std::uint32_t)m_geo_entities.size(); ++i)
+    {
+        const geo_entity& ge = m_geo_entities[i];
+        const float r = screen_radius_px(*ge.bounds, ge.transform->world);
+        if (r >= min_radius)
+            m_occluders.push_back({ i, ge.hull, r, 0 });
+    }
+    if (m_occluders.empty()) return;
+
+    std::sort(m_occluders.begin(), m_occluders.end(), [](const occluder_ref& a, const occluder_ref& b) { return a.radius_px > b.radius_px; });
+
+    std::size_t tris = 0;
+    std::size_t kept = 0;
+    for (occluder_ref& occ : m_occluders)
+    {
+        if (kept == kMaxOccluders) break;
+        if (tris + occ.mesh->tri_count > kOccluderTriBudget) continue;
+        occ.tri_begin = tris;
+        tris += occ.mesh->tri_count;
+        m_occluders[kept++] = occ;
+    }
+    m_occluders.resize(kept);
+    if (kept == 0) return;
+
+    m_occluder_tris.resize(tris);
+    run_parallel((std::uint32_t)kept, 1, [this](std::uint32_t b, std::uint32_t e)
+    {
+        for (std::uint32_t i = b; i < e; ++i)
+            setup_occluder(m_occluders[i]);
+    });
+
+    m_occlusion_depth.resize((std::size_t)kOcclusionW * (std::size_t)kOcclusionH);
+    run_parallel((std::uint32_t)kOcclusionBands, 1, [this](std::uint32_t b, std::uint32_t e)
+    {
+        constexpr int rows = kOcclusionH / kOcclusionBands;
+        raster_occluders((int)b * rows, (int)e * rows - 1);
+    });
+
+    // Occluders stay; they may hide each other, but the test is only as fine as their boxes
+    const std::size_t count = m_geo_entities.size();
+    m_geo_hidden.assign(count, 0);
+    for (const occluder_ref& occ : m_occluders)
+        m_geo_hidden[occ.entity] = 2;
+    run_parallel((std::uint32_t)count, kXformsPerTask, [this](std::uint32_t b, std::uint32_t e)
+    {
+        for (std::uint32_t i = b; i < e; ++i)
+        {
+            const geo_entity& ge = m_geo_entities[i];
+            if (m_geo_hidden[i] == 0 && entity_occluded(*ge.bounds, ge.transform->world))
+                m_geo_hidden[i] = 1;
+        }
+    });
+
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (m_geo_hidden[i] == 1)
+        {
+            ++m_draw_stats.entities_occluded;
+            m_draw_stats.triangles_culled += m_geo_entities[i].mesh->tri_count;
+            continue;
         }
+        m_geo_entities[out++] = m_geo_entities[i];
     }
+    m_geo_entities.resize(out);
 }
 
-void optimized_renderer_core::rainy_effect_slice(int y0, int y1) const noexcept
+void optimized_renderer_core::setup_occluder(const occluder_ref& occ) noexcept
 {
-    if (!framebuffer.data || framebuffer.w == 0 || framebuffer.h == 0) return;
-    if (!zbuffer.data || zbuffer.w == 0 || zbuffer.h == 0) return;
+    const MeshRefPN& mesh = *occ.mesh;
+    const matrix world_clip = m_job.vp * m_geo_entities[occ.entity].transform->world;
+    const matrix clip = mesh.quant ? world_clip * quant_position_matrix(*mesh.quant) : world_clip;
+    const float hw = (float)kOcclusionW * 0.5f;
+    const float hh = (float)kOcclusionH * 0.5f;
 
-    const rainy_effect_settings settings = m_job.rain_settings;
-    if (!settings.enabled || settings.intensity <= 0.f) return;
+    for (std::uint32_t t = 0; t < mesh.tri_count; ++t)
+    {
+        occluder_tri& ot = m_occluder_tris[occ.tri_begin + t];
+        ot.minx = 0;
+        ot.maxx = -1;
+
+        // Triangles reaching the near plane are dropped; that only ever hides less
+        float x[3], y[3], z[3];
+        bool in_front = true;
+        for (int k = 0; k < 3; ++k)
+        {
+            const std::uint32_t v = mesh.indices ? mesh.indices[t * 3u + (std::uint32_t)k] : t * 3u + (std::uint32_t)k;
+            const vec4 hp = clip * (mesh.quant ? quant_raw_position(mesh.quant->vertices()[v]) : mesh.positions[v]);
+            if (hp[3] <= 1e-4f) { in_front = false; break; }
+            const float inv_w = 1.f / hp[3];
+            x[k] = (hp[0] * inv_w + 1.f) * hw;
+            y[k] = (1.f - hp[1] * inv_w) * hh;
+            z[k] = 1.f - hp[2] * inv_w;
+        }
+        if (!in_front) continue;
 
-    const std::uint32_t W = framebuffer.w;
-    const float time_s = m_job.time_s;
-    const float drop_speed = settings.streak_speed;
-    const float drop_density = settings.streak_density;
-    const float drop_length = (settings.streak_length > 0.001f) ? settings.streak_length : 0.001f;
-    const float drop_probability = clamp01(settings.streak_probability);
-    const float depth_weight = settings.depth_weight;
-    const float depth_bias = settings.depth_bias;
-    const float tint_r = settings.tint.r;
-    const float tint_g = settings.tint.g;
-    const float tint_b = settings.tint.b;
+        setup_depth_tri(ot, x, y, z, true, kOcclusionW, kOcclusionH);
+    }
+}
 
-    for (int y = y0; y <= y1; ++y)
+void optimized_renderer_core::setup_depth_tri(occluder_tri& ot, const float x[3], const float y[3], const float z[3],
+                                              bool conservative, int w, int h) noexcept
+{
+    ot.minx = 0;
+    ot.maxx = -1;
+
+    // Both windings: a back face is never nearer than the front one over it
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (std::fabs(area) < 1e-6f) return;
+    const float sign = (area > 0.f) ? 1.f : -1.f;
+    area *= sign;
+
+    for (int k = 0; k < 3; ++k)
     {
-        std::uint32_t* row = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
-        const float* zrow = zbuffer.data + (std::size_t)y * (std::size_t)zbuffer.pitch;
-        const float fy = static_cast<float>(framebuffer.h - 1u - static_cast<std::uint32_t>(y));
+        const int i = (k + 1) % 3, j = (k + 2) % 3;
+        ot.ea[k] = (y[i] - y[j]) * sign;
+        ot.eb[k] = (x[j] - x[i]) * sign;
+        ot.ec[k] = (x[i] * y[j] - x[j] * y[i]) * sign;
+        ot.et[k] = conservative ? 0.5f * (std::fabs(ot.ea[k]) + std::fabs(ot.eb[k])) : 0.f;
+    }
 
-        for (std::uint32_t x = 0; x < W; ++x)
+    const float inv_area = 1.f / area;
+    ot.za = (z[0] * ot.ea[0] + z[1] * ot.ea[1] + z[2] * ot.ea[2]) * inv_area;
+    ot.zb = (z[0] * ot.eb[0] + z[1] * ot.eb[1] + z[2] * ot.eb[2]) * inv_area;
+    ot.zc = (z[0] * ot.ec[0] + z[1] * ot.ec[1] + z[2] * ot.ec[2]) * inv_area;
+    ot.zslack = conservative ? 0.5f * (std::fabs(ot.za) + std::fabs(ot.zb)) : 0.f;
+    ot.zmin = (std::min)({ z[0], z[1], z[2] });
+
+    // Pixels whose whole square lies inside the triangle's bounds, or whose centre does
+    const float minx = (std::min)({ x[0], x[1], x[2] }), maxx = (std::max)({ x[0], x[1], x[2] });
+    const float miny = (std::min)({ y[0], y[1], y[2] }), maxy = (std::max)({ y[0], y[1], y[2] });
+    if (conservative)
+    {
+        ot.minx = (std::max)((int)std::ceil(minx), 0);
+        ot.maxx = (std::min)((int)std::floor(maxx) - 1, w - 1);
+        ot.miny = (std::max)((int)std::ceil(miny), 0);
+        ot.maxy = (std::min)((int)std::floor(maxy) - 1, h - 1);
+    }
+    else
+    {
+        ot.minx = (std::max)((int)std::ceil(minx - 0.5f), 0);
+        ot.maxx = (std::min)((int)std::floor(maxx - 0.5f), w - 1);
+        ot.miny = (std::max)((int)std::ceil(miny - 0.5f), 0);
+        ot.maxy = (std::min)((int)std::floor(maxy - 0.5f), h - 1);
+    }
+}
+
+void optimized_renderer_core::raster_occluders(int y0, int y1) noexcept
+{
+    raster_depth_tris(m_occluder_tris, m_occlusion_depth.data(), kOcclusionW, y0, y1, m_job.isa);
+}
+
+void optimized_renderer_core::raster_depth_tris(const std::vector<occluder_tri>& tris, float* depth, int w, int y0, int y1, raster_isa isa) noexcept
+{
+    std::fill(depth + (std::size_t)y0 * (std::size_t)w, depth + (std::size_t)(y1 + 1) * (std::size_t)w, 0.f);
+    (void)isa;
+
+    for (const occluder_tri& ot : tris)
+    {
+        if (ot.minx > ot.maxx || ot.maxy < y0 || ot.miny > y1) continue;
+
+        const int ty0 = (std::max)(ot.miny, y0);
+        const int ty1 = (std::min)(ot.maxy, y1);
+        for (int y = ty0; y <= ty1; ++y)
         {
-            const float column_seed = hash11(static_cast<float>(x) * 0.271f);
-            if (column_seed > drop_probability)
+            float* row = depth + (std::size_t)y * (std::size_t)w;
+            const float cy = (float)y + 0.5f;
+            const float r0 = ot.eb[0] * cy + ot.ec[0] - ot.et[0];
+            const float r1 = ot.eb[1] * cy + ot.ec[1] - ot.et[1];
+            const float r2 = ot.eb[2] * cy + ot.ec[2] - ot.et[2];
+            const float rz = ot.zb * cy + ot.zc - ot.zslack;
+
+#ifdef USE_SIMD
+            if (isa == raster_isa::avx2)
+            {
+                depth_tri_row_avx2(ot, row, r0, r1, r2, rz);
                 continue;
+            }
+#endif
+            for (int x = ot.minx; x <= ot.maxx; ++x)
+            {
+                const float cx = (float)x + 0.5f;
+                if (ot.ea[0] * cx + r0 < 0.f || ot.ea[1] * cx + r1 < 0.f || ot.ea[2] * cx + r2 < 0.f) continue;
+                const float z = (std::max)(ot.za * cx + rz, ot.zmin);
+                row[x] = (std::max)(row[x], z);
+            }
+        }
+    }
+}
+
+bool optimized_renderer_core::entity_occluded(const Bounds& b, const matrix& world) const noexcept
+{
+    // Screen box and nearest depth of the bounds' corners, in occlusion pixels
+    const matrix clip = m_job.vp * world;
+    float minx = (std::numeric_limits<float>::max)(), maxx = (std::numeric_limits<float>::lowest)();
+    float miny = minx, maxy = maxx;
+    float nearest = 0.f;
+    for (int c = 0; c < 8; ++c)
+    {
+        const vec4 corner((c & 1) ? b.local_max[0] : b.local_min[0],
+                          (c & 2) ? b.local_max[1] : b.local_min[1],
+                          (c & 4) ? b.local_max[2] : b.local_min[2], 1.f);
+        const vec4 hp = clip * corner;
+        if (hp[3] <= 1e-4f) return false;
+        const float inv_w = 1.f / hp[3];
+        const float x = (hp[0] * inv_w + 1.f) * (float)kOcclusionW * 0.5f;
+        const float y = (1.f - hp[1] * inv_w) * (float)kOcclusionH * 0.5f;
+        minx = (std::min)(minx, x); maxx = (std::max)(maxx, x);
+        miny = (std::min)(miny, y); maxy = (std::max)(maxy, y);
+        nearest = (std::max)(nearest, 1.f - hp[2] * inv_w);
+    }
+
+    const int x0 = (std::max)((int)std::floor(minx), 0);
+    const int x1 = (std::min)((int)std::floor(maxx), kOcclusionW - 1);
+    const int y0 = (std::max)((int)std::floor(miny), 0);
+    const int y1 = (std::min)((int)std::floor(maxy), kOcclusionH - 1);
+    if (x0 > x1 || y0 > y1) return false;
+
+    // Hidden only if every pixel it touches holds an occluder nearer than its nearest corner
+    for (int y = y0; y <= y1; ++y)
+    {
+        const float* row = m_occlusion_depth.data() + (std::size_t)y * kOcclusionW;
+        int x = x0;
+#ifdef USE_SIMD
+        const __m128 zn = _mm_set1_ps(nearest);
+        for (; x + 4 <= x1 + 1; x += 4)
+            if (_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(row + x), zn)))
+                return false;
+#endif
+        for (; x <= x1; ++x)
+            if (row[x] <= nearest)
+                return false;
+    }
+    return true;
+}
+
+void optimized_renderer_core::build_geometry_xforms(std::size_t begin, std::size_t end) noexcept
+{
+    const matrix vp = m_job.vp;
+    std::size_t i = begin;
+
+#ifdef USE_SIMD
+    if (m_job.isa == raster_isa::avx2)
+        i = clip_matrices_avx2(begin, end);
+#endif
+
+    for (; i < end; ++i)
+        m_geo_xforms.clip[i] = vp * m_geo_entities[i].transform->world;
+
+    for (i = begin; i < end; ++i)
+    {
+        float det = 0.f;
+        const bool renormalize = normal_matrix_of(m_geo_entities[i].transform->world, m_geo_xforms.normal[i], det);
+
+        std::uint8_t flags = 0u;
+        if (det < 0.f)   flags |= geo_xforms::kMirrored;
+        if (renormalize) flags |= geo_xforms::kRenormalize;
+        m_geo_xforms.flags[i] = flags;
+    }
+}
+
+void optimized_renderer_core::transform_vertices(std::size_t v_begin, std::size_t v_end) noexcept
+{
+    const float fw = m_job.fw;
+    const float fh = m_job.fh;
+
+    // Entities that add no vertices share vtx_begin with the next one, so the last match owns v_begin
+    auto it = std::upper_bound(m_geo_entities.begin(), m_geo_entities.end(), v_begin,
+        [](std::size_t v, const geo_entity& ge) { return v < ge.vtx_begin; });
+    --it;
+
+    for (; it != m_geo_entities.end() && it->vtx_begin < v_end; ++it)
+    {
+        if (it->vtx_count == 0) continue;
+
+        const MeshRefPN& mesh = *it->mesh;
+        const std::size_t gi  = (std::size_t)(it - m_geo_entities.begin());
+        const matrix& p       = m_geo_xforms.clip[gi];
+        const matrix& nm      = m_geo_xforms.normal[gi];
+        const bool renormalize = (m_geo_xforms.flags[gi] & geo_xforms::kRenormalize) != 0;
+
+        const std::size_t from = (std::max)(v_begin, it->vtx_begin);
+        const std::size_t to   = (std::min)(v_end, it->vtx_begin + it->vtx_count);
 
-            const float drift = settings.wind * time_s;
-            const float phase = fract((fy * drop_density) - (time_s * drop_speed) + column_seed * 10.f + drift);
-            if (phase >= drop_length)
-                continue;
+        const auto finish = [&](post_vtx& out, const vec4& n) noexcept
+        {
+            const SVtx sv = make_svtx(out.hp, n, fw, fh, colour{});
+            out.n = sv.n;
+            out.x = sv.x;
+            out.y = sv.y;
+            out.z = sv.z;
+        };
+
+        if (!mesh.quant)
+        {
+            for (std::size_t v = from; v < to; ++v)
+            {
+                const std::size_t local = v - it->vtx_begin;
+                post_vtx& out = m_post_vtx[v];
+                out.hp = p * mesh.positions[local];
 
-            const float z = zrow[x];
-            const float depth_factor = clamp01(depth_bias + (1.f - z) * depth_weight);
-            const float streak = 1.f - (phase / drop_length);
-            float drop = streak * settings.intensity * depth_factor;
-            if (drop <= 0.f)
-                continue;
+                vec4 n = nm * mesh.normals[local];
+                if (renormalize) n.normalise();
+                finish(out, n);
+            }
+            continue;
+        }
 
-            const float jitter = 0.75f + 0.25f * std::sin((static_cast<float>(x) * 0.15f) + time_s);
-            drop *= jitter;
+        // The dequantization rides in the clip matrix, so a position is a convert and one multiply
+        const quant_vertex* qv = mesh.quant->vertices() + (from - it->vtx_begin);
+        const matrix pq = p * quant_position_matrix(*mesh.quant);
+        std::size_t v = from;
 
-            float r, g, b;
-            unpack_rgba8(row[x], r, g, b);
+#ifdef USE_SIMD
+        if (m_job.isa == raster_isa::avx2)
+        {
+            v = decode_quant_vertices_avx2(qv, from, to, pq, nm);
+            qv += v - from;
+        }
+#endif
 
-            const float darken = 1.f - drop * settings.darken;
-            r = r * darken + tint_r * drop;
-            g = g * darken + tint_g * drop;
-            b = b * darken + tint_b * drop;
+        for (; v < to; ++v, ++qv)
+        {
+            post_vtx& out = m_post_vtx[v];
+            out.hp = pq * quant_raw_position(*qv);
 
-            row[x] = pack_rgba8_from_rgb(r, g, b);
+            vec4 n = nm * oct_decode(qv->oct);
+            if (renormalize) n.normalise();
+            finish(out, n);
         }
     }
 }
 
-void optimized_renderer_core::advanced_effects_slice(int y0, int y1) const noexcept
+void optimized_renderer_core::geometry_batch(int batch) noexcept
 {
-    if (!framebuffer.data || framebuffer.w == 0 || framebuffer.h == 0) return;
+    std::vector<setup_tri>& out = m_setup_tris[batch];
+    std::vector<std::vector<std::uint32_t>>& bins = m_tile_bins[batch];
+    cluster_counts& clusters_seen = m_batch_clusters[batch];
+    out.clear();
+    for (auto& bin : bins)
+        bin.clear();
+    clusters_seen = {};
 
-    const advanced_effects_settings settings = m_job.advanced_settings;
-    if (!settings.enabled)
-        return;
+    if (m_geo_entities.empty()) return;
 
-    const std::uint32_t W = framebuffer.w;
-    const std::uint32_t H = framebuffer.h;
-    const float time_s = m_job.time_s;
-    const bool use_depth = (settings.fog_enabled || settings.depth_of_field_enabled || settings.ssr_enabled);
+    // Contiguous triangle ranges keep the submission order when batches are rastered 0..N-1
+    const std::size_t total    = m_geo_tri_total;
+    const std::size_t tri_from = total * (std::size_t)batch / (std::size_t)kGeometryBatches;
+    const std::size_t tri_to   = total * (std::size_t)(batch + 1) / (std::size_t)kGeometryBatches;
+    if (tri_from >= tri_to) return;
 
-    std::vector<std::uint32_t> row_copy(W);
-    std::vector<std::uint32_t> blur_copy(W);
+    const int W = (int)m_job.W;
+    const int H = (int)m_job.H;
 
-    for (int y = y0; y <= y1; ++y)
-    {
-        std::uint32_t* row = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
-        const float* zrow = use_depth ? (zbuffer.data + (std::size_t)y * (std::size_t)zbuffer.pitch) : nullptr;
+    const float fw = m_job.fw;
+    const float fh = m_job.fh;
+
+    const vec4 light_dir_in = m_job.light_dir;
+    const bool density_on = m_debug_view == debug_view::triangle_density;
+    const bool tex_on    = m_job.textures_on && !density_on;
+    const bool flip_v_on = m_job.flip_v_on;
 
-        std::copy_n(row, W, row_copy.begin());
+    auto it = std::upper_bound(m_geo_entities.begin(), m_geo_entities.end(), tri_from,
+        [](std::size_t t, const geo_entity& ge) { return t < ge.tri_begin; });
+    --it;
 
-        if (settings.motion_blur_enabled || settings.depth_of_field_enabled)
+    for (; it != m_geo_entities.end() && it->tri_begin < tri_to; ++it)
+    {
+        const MeshRefPN&  mesh = *it->mesh;
+        const Material&   mat  = *it->material;
+        const TextureRef& tex  = *it->texture;
+
+        const bool use_tex = tex_on && tex.valid() && mesh.has_uvs && (mesh.uvs || mesh.quant);
+        const std::uint8_t tex_state = raster_state_for(use_tex ? &tex : nullptr).index();
+
+        const std::size_t  gi    = (std::size_t)(it - m_geo_entities.begin());
+        const matrix&      p     = m_geo_xforms.clip[gi];
+        const matrix&      nm    = m_geo_xforms.normal[gi];
+        const std::uint8_t flags = m_geo_xforms.flags[gi];
+        const auto world_normal = [&](const vec4& n_os) noexcept
+        {
+            vec4 n = nm * n_os;
+            if (flags & geo_xforms::kRenormalize) n.normalise();
+            return n;
+        };
+
+        // Culling keeps triangles whose area sign matches `keep`; a mirrored world matrix flips the winding
+        const bool mirrored = (flags & geo_xforms::kMirrored) != 0;
+        const float keep = (mat.cull == cull_mode::none) ? 0.f
+                         : ((mat.cull == cull_mode::back) != mirrored ? 1.f : -1.f);
+
+        const bool cached = it->vtx_count > 0;
+        const post_vtx* post = cached ? m_post_vtx.data() + it->vtx_begin : nullptr;
+
+        const std::uint32_t ti_begin = (std::uint32_t)((std::max)(tri_from, it->tri_begin) - it->tri_begin);
+        const std::uint32_t ti_end   = (std::uint32_t)((std::min)(tri_to, it->tri_begin + mesh.tri_count) - it->tri_begin);
+
+        // Clusters only cut up the finest level, so a coarser one drawn, or a mesh swapped under
+        // bounds that kept them, goes triangle by triangle. The cone holds under rotation, uniform
+        // scale and mirroring, where the normal matrix is orthonormal.
+        const Bounds& bounds = *it->bounds;
+        const bool clustered = m_job.cluster_on && bounds.clusters && bounds.cluster_count > 0 &&
+                               bounds.cluster_indices == mesh.indices && mesh.indices;
+        const mesh_cluster* cluster = nullptr;
+        std::uint32_t cluster_end = ti_end; // first triangle past the current cluster
+        float cluster_scale = 1.f;
+        float cone_sign = 0.f;              // 1 culls clusters facing away, -1 facing the eye
+        if (clustered)
         {
-            std::copy_n(row_copy.begin(), W, blur_copy.begin());
+            const mesh_cluster* const first = bounds.clusters;
+            cluster = std::upper_bound(first, first + bounds.cluster_count, ti_begin,
+                [](std::uint32_t t, const mesh_cluster& c) { return t < c.tri_begin; }) - 1;
+            cluster_end = ti_begin;
+
+            const matrix& world = it->transform->world;
+            float scale2 = 0.f;
+            for (int c = 0; c < 3; ++c)
+                scale2 = (std::max)(scale2, world(0, c) * world(0, c) + world(1, c) * world(1, c) + world(2, c) * world(2, c));
+            cluster_scale = std::sqrt(scale2);
+            if (!(flags & geo_xforms::kRenormalize) && mat.cull != cull_mode::none)
+                cone_sign = (mat.cull == cull_mode::back) ? 1.f : -1.f;
         }
-
-        for (std::uint32_t x = 0; x < W; ++x)
+        const auto cluster_culled = [&](const mesh_cluster& c) noexcept
         {
-            float r, g, b;
-            unpack_rgba8(row_copy[x], r, g, b);
-
-            const float lum = r * 0.2126f + g * 0.7152f + b * 0.0722f;
-            if (settings.bloom_enabled)
+            const vec4 centre = it->transform->world * vec4(c.centre[0], c.centre[1], c.centre[2], 1.f);
+            const float radius = c.radius * cluster_scale;
+            if (sphere_outside_frustum(centre, radius)) return true;
+            if (cone_sign == 0.f || c.cone_cutoff >= 1.f) return false;
+
+            const vec4 axis = nm * vec4(c.axis[0], c.axis[1], c.axis[2], 0.f);
+            const vec4 to_centre = centre - m_job.eye;
+            const float along = (to_centre[0] * axis[0] + to_centre[1] * axis[1] + to_centre[2] * axis[2]) * cone_sign;
+            const float dist = std::sqrt(to_centre[0] * to_centre[0] + to_centre[1] * to_centre[1] + to_centre[2] * to_centre[2]);
+            return along >= c.cone_cutoff * dist + radius;
+        };
+
+        for (std::uint32_t ti = ti_begin; ti < ti_end; ++ti)
+        {
+            // Entering the next cluster: one test for all of its triangles
+            if (ti == cluster_end)
             {
-                const float boost = (std::max)(0.f, lum - settings.bloom_threshold) * settings.bloom_intensity;
-                r += boost;
-                g += boost;
-                b += boost;
+                if (cluster->tri_begin + cluster->tri_count <= ti) ++cluster;
+                cluster_end = cluster->tri_begin + cluster->tri_count;
+                ++clusters_seen.tested;
+                if (cluster_culled(*cluster))
+                {
+                    ++clusters_seen.culled;
+                    ti = (std::min)(cluster_end, ti_end) - 1u;
+                    continue;
+                }
             }
 
-            float depth = 0.f;
-            if (use_depth && zrow)
-                depth = clamp01(zrow[x]);
+            const std::size_t base = (std::size_t)ti * 3u;
+            std::size_t i0 = base + 0, i1 = base + 1, i2 = base + 2;
+            const post_vtx* c0 = nullptr;
+            const post_vtx* c1 = nullptr;
+            const post_vtx* c2 = nullptr;
 
-            if (settings.fog_enabled)
+            vec4 hp0, hp1, hp2;
+            if (cached)
             {
-                const float fog_range = (std::max)(0.001f, settings.fog_end - settings.fog_start);
-                const float fog_t = clamp01((depth - settings.fog_start) / fog_range);
-                r = r + (settings.fog_colour.r - r) * fog_t;
-                g = g + (settings.fog_colour.g - g) * fog_t;
-                b = b + (settings.fog_colour.b - b) * fog_t;
+                i0 = mesh.indices[base + 0];
+                i1 = mesh.indices[base + 1];
+                i2 = mesh.indices[base + 2];
+                c0 = &post[i0];
+                c1 = &post[i1];
+                c2 = &post[i2];
+                hp0 = c0->hp;
+                hp1 = c1->hp;
+                hp2 = c2->hp;
             }
-
-            if (settings.ssr_enabled)
+            else
             {
-                const std::uint32_t mirror_y = (H - 1u) - static_cast<std::uint32_t>(y);
-                const std::uint32_t* mirror_row = framebuffer.data + (std::size_t)mirror_y * (std::size_t)framebuffer.pitch_pixels;
-                float rr, rg, rb;
-                unpack_rgba8(mirror_row[x], rr, rg, rb);
-                const float reflect = settings.ssr_strength * (1.f - depth);
-                r = r + (rr - r) * reflect;
-                g = g + (rg - g) * reflect;
-                b = b + (rb - b) * reflect;
+                hp0 = p * mesh.positions[i0];
+                hp1 = p * mesh.positions[i1];
+                hp2 = p * mesh.positions[i2];
             }
 
-            if (settings.depth_of_field_enabled)
+            if (hp0[3] <= 0.0001f || hp1[3] <= 0.0001f || hp2[3] <= 0.0001f) continue;
+
+#ifdef USE_SIMD
+            if (tri_outside_frustum_simd(hp0, hp1, hp2)) continue;
+#else
+            if (hp0[0] < -hp0[3] && hp1[0] < -hp1[3] && hp2[0] < -hp2[3]) continue;
+            if (hp0[0] >  hp0[3] && hp1[0] >  hp1[3] && hp2[0] >  hp2[3]) continue;
+            if (hp0[1] < -hp0[3] && hp1[1] < -hp1[3] && hp2[1] < -hp2[3]) continue;
+            if (hp0[1] >  hp0[3] && hp1[1] >  hp1[3] && hp2[1] >  hp2[3]) continue;
+            if (hp0[2] < 0.f && hp1[2] < 0.f && hp2[2] < 0.f) continue;
+            if (hp0[2] > hp0[3] && hp1[2] > hp1[3] && hp2[2] > hp2[3]) continue;
+#endif
+
+            // Read UVs if texturing
+            float tu0 = 0.f, tv0 = 0.f;
+            float tu1 = 0.f, tv1 = 0.f;
+            float tu2 = 0.f, tv2 = 0.f;
+            if (use_tex)
             {
-                const float dof_range = (std::max)(0.001f, settings.dof_range);
-                const float blur_t = clamp01(std::fabs(depth - settings.dof_focus) / dof_range);
-                if (blur_t > 0.f)
+                if (mesh.quant)
                 {
-                    const std::uint32_t x0 = (x > 0) ? x - 1u : x;
-                    const std::uint32_t x1 = (x + 1u < W) ? x + 1u : x;
-                    float br0, bg0, bb0;
-                    float br1, bg1, bb1;
-                    unpack_rgba8(blur_copy[x0], br0, bg0, bb0);
-                    unpack_rgba8(blur_copy[x1], br1, bg1, bb1);
-                    const float blur_r = (br0 + br1) * 0.5f;
-                    const float blur_g = (bg0 + bg1) * 0.5f;
-                    const float blur_b = (bb0 + bb1) * 0.5f;
-                    r = r + (blur_r - r) * blur_t;
-                    g = g + (blur_g - g) * blur_t;
-                    b = b + (blur_b - b) * blur_t;
+                    quant_uv(*mesh.quant, i0, tu0, tv0);
+                    quant_uv(*mesh.quant, i1, tu1, tv1);
+                    quant_uv(*mesh.quant, i2, tu2, tv2);
+                }
+                else
+                {
+                    tu0 = mesh.uvs[i0 * 2u + 0]; tv0 = mesh.uvs[i0 * 2u + 1];
+                    tu1 = mesh.uvs[i1 * 2u + 0]; tv1 = mesh.uvs[i1 * 2u + 1];
+                    tu2 = mesh.uvs[i2 * 2u + 0]; tv2 = mesh.uvs[i2 * 2u + 1];
+                }
+                if (flip_v_on)
+                {
+                    tv0 = 1.f - tv0;
+                    tv1 = 1.f - tv1;
+                    tv2 = 1.f - tv2;
                 }
             }
 
-            if (settings.god_rays_enabled)
+            SVtx v0, v1, v2;
+            if (cached)
             {
-                const float fx = static_cast<float>(x) / (std::max)(1.f, static_cast<float>(W - 1u));
-                const float fy = static_cast<float>(y) / (std::max)(1.f, static_cast<float>(H - 1u));
-                const float dx = fx - settings.god_rays_screen_pos.x;
-                const float dy = fy - settings.god_rays_screen_pos.y;
-                const float dist = std::sqrt(dx * dx + dy * dy);
-                const float shaft = clamp01(1.f - dist * 1.5f) * settings.god_rays_strength;
-                r += shaft;
-                g += shaft;
-                b += shaft;
+                v0 = { c0->x, c0->y, c0->z, hp0[3], c0->n, mat.col, tu0, tv0 };
+                v1 = { c1->x, c1->y, c1->z, hp1[3], c1->n, mat.col, tu1, tv1 };
+                v2 = { c2->x, c2->y, c2->z, hp2[3], c2->n, mat.col, tu2, tv2 };
             }
-
-            if (settings.motion_blur_enabled)
+            else
             {
-                const std::uint32_t x0 = (x > 0) ? x - 1u : x;
-                const std::uint32_t x1 = (x + 1u < W) ? x + 1u : x;
-                float mr0, mg0, mb0;
-                float mr1, mg1, mb1;
-                unpack_rgba8(blur_copy[x0], mr0, mg0, mb0);
-                unpack_rgba8(blur_copy[x1], mr1, mg1, mb1);
-                const float blur_r = (mr0 + mr1) * 0.5f;
-                const float blur_g = (mg0 + mg1) * 0.5f;
-                const float blur_b = (mb0 + mb1) * 0.5f;
-                const float mb = clamp01(settings.motion_blur_strength);
-                r = r + (blur_r - r) * mb;
-                g = g + (blur_g - g) * mb;
-                b = b + (blur_b - b) * mb;
+                v0 = make_svtx(hp0, world_normal(mesh.normals[i0]), fw, fh, mat.col, tu0, tv0);
+                v1 = make_svtx(hp1, world_normal(mesh.normals[i1]), fw, fh, mat.col, tu1, tv1);
+                v2 = make_svtx(hp2, world_normal(mesh.normals[i2]), fw, fh, mat.col, tu2, tv2);
             }
 
-            if (settings.film_grain_enabled)
+            // Snap to the subpixel grid so the float edges and the block classifier see the same triangle
+            std::int64_t fx[3]{}, fy[3]{};
+            const bool fixed_edges = in_fixed_guard_band(v0.x, v0.y) &&
+                                     in_fixed_guard_band(v1.x, v1.y) &&
+                                     in_fixed_guard_band(v2.x, v2.y);
+            if (fixed_edges)
             {
-                const float grain = (hash11(static_cast<float>(x) * 0.17f + static_cast<float>(y) * 0.29f + time_s * settings.film_grain_speed) - 0.5f)
-                    * settings.film_grain_strength;
-                r += grain;
-                g += grain;
-                b += grain;
+                snap_to_subpixel(v0.x, v0.y, fx[0], fy[0]);
+                snap_to_subpixel(v1.x, v1.y, fx[1], fy[1]);
+                snap_to_subpixel(v2.x, v2.y, fx[2], fy[2]);
             }
 
-            row[x] = pack_rgba8_from_rgb(r, g, b);
-        }
-    }
-}
+            float area = edge_fn(v0.x, v0.y, v1.x, v1.y, v2.x, v2.y);
+            if (area == 0.f) continue;
+            if (area * keep < 0.f) continue;
 
-void optimized_renderer_core::draw_world_slice(int y0, int y1) const noexcept
-{
-    const std::uint32_t W = m_job.W;
-    const std::uint32_t H = m_job.H;
-    (void)H;
+            const float sign = (area < 0.f) ? -1.f : 1.f;
+            const float inv_area = 1.f / (area * sign);
 
-    const float fw = m_job.fw;
-    const float fh = m_job.fh;
+            const float minx_f = (std::min)({ v0.x, v1.x, v2.x });
+            const float maxx_f = (std::max)({ v0.x, v1.x, v2.x });
+            const float miny_f = (std::min)({ v0.y, v1.y, v2.y });
+            const float maxy_f = (std::max)({ v0.y, v1.y, v2.y });
 
-    const matrix vp = m_job.vp;
-    const vec4 light_dir_in = m_job.light_dir;
-    const bool tex_on    = m_job.textures_on;
-    const bool flip_v_on = m_job.flip_v_on;
+            int minx = (int)std::floor(minx_f);
+            int maxx = (int)std::ceil (maxx_f);
+            int miny = (int)std::floor(miny_f);
+            int maxy = (int)std::ceil (maxy_f);
 
-    const std::uint32_t pitch_pixels = framebuffer.pitch_pixels;
+            if (maxx < 0 || maxy < 0 || minx >= W || miny >= H) continue;
 
-    for (const auto& block : render_cache_.blocks())
-    {
-        MeshRefPN*  meshes     = std::get<0>(block.arrays);
-        Transform*  transforms = std::get<1>(block.arrays);
-        Material*   materials  = std::get<2>(block.arrays);
-        TextureRef* textures   = std::get<3>(block.arrays);
-        const std::size_t n    = block.n;
+            if (minx < 0) minx = 0;
+            if (maxx >= W) maxx = W - 1;
+            if (miny < 0) miny = 0;
+            if (maxy >= H) maxy = H - 1;
 
-        for (std::size_t ei = 0; ei < n; ++ei)
-        {
-            const MeshRefPN&  mesh = meshes[ei];
-            const Transform&  tr   = transforms[ei];
-            const Material&   mat  = materials[ei];
-            const TextureRef& tex  = textures[ei];
+            if (minx > maxx || miny > maxy) continue;
+
+#ifdef USE_SIMD
+            vec4 nrm{};
+            __m128 n0_v = _mm_load_ps(v0.n.data());
+            __m128 n1_v = _mm_load_ps(v1.n.data());
+            __m128 n2_v = _mm_load_ps(v2.n.data());
+            __m128 nsum = _mm_add_ps(_mm_add_ps(n0_v, n1_v), n2_v);
+            _mm_store_ps(nrm.data(), nsum);
+#else
+            vec4 nrm = v0.n + v1.n + v2.n;
+#endif
+            nrm.normalise();
+
+            float ndotl = vec4::dot(nrm, light_dir_in);
+            if (ndotl < 0.f) ndotl = 0.f;
+
+            setup_tri st{};
+            st.intensity = mat.ka + mat.kd * ndotl;
+
+            // Edge function setup
+            st.e0_a = (v2.y - v1.y) * sign;
+            st.e0_b = (v1.x - v2.x) * sign;
+            st.e0_c = (v2.x * v1.y - v2.y * v1.x) * sign;
+
+            st.e1_a = (v0.y - v2.y) * sign;
+            st.e1_b = (v2.x - v0.x) * sign;
+            st.e1_c = (v0.x * v2.y - v0.y * v2.x) * sign;
+
+            st.e2_a = (v1.y - v0.y) * sign;
+            st.e2_b = (v0.x - v1.x) * sign;
+            st.e2_c = (v1.x * v0.y - v1.y * v0.x) * sign;
 
-            if (!mesh.positions || !mesh.normals || mesh.tri_count == 0) continue;
+            st.inv_area = inv_area;
+            st.fixed_edges = fixed_edges && setup_fixed_edges(st, fx, fy, sign);
 
-            const bool use_tex = tex_on && tex.valid() && mesh.has_uvs && mesh.uvs;
+            st.z0 = v0.z;
+            st.z1 = v1.z;
+            st.z2 = v2.z;
+            st.dzdx = (st.e0_a * v0.z + st.e1_a * v1.z + st.e2_a * v2.z) * inv_area;
+            st.dzdy = (st.e0_b * v0.z + st.e1_b * v1.z + st.e2_b * v2.z) * inv_area;
+            st.zmax = (std::max)({ v0.z, v1.z, v2.z });
 
-            const matrix p = vp * tr.world;
+            st.minx = minx;
+            st.maxx = maxx;
+            st.miny = miny;
+            st.maxy = maxy;
 
-            for (std::uint32_t ti = 0; ti < mesh.tri_count; ++ti)
+            if (use_tex)
             {
-                const std::size_t base = (std::size_t)ti * 3u;
-                const vec4 hp0 = p * mesh.positions[base + 0];
-                const vec4 hp1 = p * mesh.positions[base + 1];
-                const vec4 hp2 = p * mesh.positions[base + 2];
+                // For textured rendering perspective correct UV interpolation
+                st.invw0 = 1.f / v0.w;
+                st.invw1 = 1.f / v1.w;
+                st.invw2 = 1.f / v2.w;
 
-                if (hp0[3] <= 0.0001f || hp1[3] <= 0.0001f || hp2[3] <= 0.0001f) continue;
+                st.uow0 = v0.u * st.invw0;
+                st.vow0 = v0.v * st.invw0;
+                st.uow1 = v1.u * st.invw1;
+                st.vow1 = v1.v * st.invw1;
+                st.uow2 = v2.u * st.invw2;
+                st.vow2 = v2.v * st.invw2;
 
-#ifdef USE_SIMD
-                if (tri_outside_frustum_simd(hp0, hp1, hp2)) continue;
-#else
-                if (hp0[0] < -hp0[3] && hp1[0] < -hp1[3] && hp2[0] < -hp2[3]) continue;
-                if (hp0[0] >  hp0[3] && hp1[0] >  hp1[3] && hp2[0] >  hp2[3]) continue;
-                if (hp0[1] < -hp0[3] && hp1[1] < -hp1[3] && hp2[1] < -hp2[3]) continue;
-                if (hp0[1] >  hp0[3] && hp1[1] >  hp1[3] && hp2[1] >  hp2[3]) continue;
-                if (hp0[2] < 0.f && hp1[2] < 0.f && hp2[2] < 0.f) continue;
-                if (hp0[2] > hp0[3] && hp1[2] > hp1[3] && hp2[2] > hp2[3]) continue;
-#endif
+                st.d_invw_dx = (st.e0_a * st.invw0 + st.e1_a * st.invw1 + st.e2_a * st.invw2) * inv_area;
+                st.d_invw_dy = (st.e0_b * st.invw0 + st.e1_b * st.invw1 + st.e2_b * st.invw2) * inv_area;
 
-                // Read UVs if texturing
-                float tu0 = 0.f, tv0 = 0.f;
-                float tu1 = 0.f, tv1 = 0.f;
-                float tu2 = 0.f, tv2 = 0.f;
-                if (use_tex)
-                {
-                    const std::size_t uv_base = base * 2u;
-                    tu0 = mesh.uvs[uv_base + 0]; tv0 = mesh.uvs[uv_base + 1];
-                    tu1 = mesh.uvs[uv_base + 2]; tv1 = mesh.uvs[uv_base + 3];
-                    tu2 = mesh.uvs[uv_base + 4]; tv2 = mesh.uvs[uv_base + 5];
-                    if (flip_v_on)
-                    {
-                        tv0 = 1.f - tv0;
-                        tv1 = 1.f - tv1;
-                        tv2 = 1.f - tv2;
-                    }
-                }
+                st.d_uow_dx = (st.e0_a * st.uow0 + st.e1_a * st.uow1 + st.e2_a * st.uow2) * inv_area;
+                st.d_uow_dy = (st.e0_b * st.uow0 + st.e1_b * st.uow1 + st.e2_b * st.uow2) * inv_area;
 
-                const SVtx v0 = make_svtx(hp0, tr.world, mesh.normals[base + 0], fw, fh, mat.col, tu0, tv0);
-                const SVtx v1 = make_svtx(hp1, tr.world, mesh.normals[base + 1], fw, fh, mat.col, tu1, tv1);
-                const SVtx v2 = make_svtx(hp2, tr.world, mesh.normals[base + 2], fw, fh, mat.col, tu2, tv2);
+                st.d_vow_dx = (st.e0_a * st.vow0 + st.e1_a * st.vow1 + st.e2_a * st.vow2) * inv_area;
+                st.d_vow_dy = (st.e0_b * st.vow0 + st.e1_b * st.vow1 + st.e2_b * st.vow2) * inv_area;
 
-                float area = edge_fn(v0.x, v0.y, v1.x, v1.y, v2.x, v2.y);
-                if (area == 0.f) continue;
+                st.tex = &tex;
+                st.state = tex_state;
+            }
+            else
+            {
+                // Non-textured: pre compute the flat RGBA
+                colour lit = mat.col;
+                if (density_on)
+                    unpack_rgba8(it->debug_rgba, lit.r, lit.g, lit.b);
+                lit.r *= st.intensity;
+                lit.g *= st.intensity;
+                lit.b *= st.intensity;
+                st.flat_rgba = pack_rgba8_from_colour(lit);
+                st.tex = nullptr;
+                st.state = 0;
+            }
+
+            const std::uint32_t tri_index = (std::uint32_t)out.size();
+            st.id = ((std::uint32_t)batch << kVisBatchShift) | tri_index;
+            out.push_back(st);
+
+            const int tx0 = minx / kTileSize;
+            const int tx1 = maxx / kTileSize;
+            const int ty0 = miny / kTileSize;
+            const int ty1 = maxy / kTileSize;
+
+            if (tx0 == tx1 && ty0 == ty1)
+            {
+                bins[(std::size_t)ty0 * (std::size_t)m_tiles_x + (std::size_t)tx0].push_back(tri_index);
+                continue;
+            }
+
+            for (int ty = ty0; ty <= ty1; ++ty)
+            {
+                for (int tx = tx0; tx <= tx1; ++tx)
+                {
+                    // Reject tiles fully outside one edge by testing the corner pixel that edge favours most
+                    const float px0 = (float)(tx * kTileSize) + 0.5f;
+                    const float py0 = (float)(ty * kTileSize) + 0.5f;
+                    const float px1 = px0 + (float)(kTileSize - 1);
+                    const float py1 = py0 + (float)(kTileSize - 1);
+
+                    const float w0 = st.e0_a * (st.e0_a >= 0.f ? px1 : px0) + st.e0_b * (st.e0_b >= 0.f ? py1 : py0) + st.e0_c;
+                    const float w1 = st.e1_a * (st.e1_a >= 0.f ? px1 : px0) + st.e1_b * (st.e1_b >= 0.f ? py1 : py0) + st.e1_c;
+                    const float w2 = st.e2_a * (st.e2_a >= 0.f ? px1 : px0) + st.e2_b * (st.e2_b >= 0.f ? py1 : py0) + st.e2_c;
+                    if (w0 < 0.f || w1 < 0.f || w2 < 0.f) continue;
+
+                    bins[(std::size_t)ty * (std::size_t)m_tiles_x + (std::size_t)tx].push_back(tri_index);
+                }
+            }
+        }
+    }
+}
 
-                const float sign = (area < 0.f) ? -1.f : 1.f;
-                const float inv_area = 1.f / (area * sign);
+void optimized_renderer_core::draw_world_tile(std::uint32_t tile) const noexcept
+{
+    const bool timed = m_debug_view == debug_view::tile_cost;
+    const auto t0 = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
 
-                const float minx_f = (std::min)({ v0.x, v1.x, v2.x });
-                const float maxx_f = (std::max)({ v0.x, v1.x, v2.x });
-                const float miny_f = (std::min)({ v0.y, v1.y, v2.y });
-                const float maxy_f = (std::max)({ v0.y, v1.y, v2.y });
+    const int tx = (int)tile % m_tiles_x;
+    const int ty = (int)tile / m_tiles_x;
 
-                int minx = (int)std::floor(minx_f);
-                int maxx = (int)std::ceil (maxx_f);
-                int miny = (int)std::floor(miny_f);
-                int maxy = (int)std::ceil (maxy_f);
+    const int x0 = tx * kTileSize;
+    const int y0 = ty * kTileSize;
+    const int x1 = (std::min)(x0 + kTileSize, (int)m_job.W) - 1;
+    const int y1 = (std::min)(y0 + kTileSize, (int)m_job.H) - 1;
 
-                if (maxx < 0 || maxy < y0 || minx >= (int)W || miny > y1) continue;
+    // Same triangles over the kept raster: its pixels and depth are already what they would draw
+    if (m_incremental)
+    {
+        const std::uint64_t sig = tile_signature(tile);
+        m_tile_sig[tile] = sig;
+        if (m_reuse_tiles && m_retained_sig[tile] == sig)
+        {
+            m_tile_cleared[tile] = 1u;
+            return;
+        }
+    }
 
-                if (minx < 0) minx = 0;
-                if (maxx >= (int)W) maxx = (int)W - 1;
+    bool touched = false;
+    for (int s = 0; s < kGeometryBatches && !touched; ++s)
+        touched = !m_tile_bins[s][tile].empty();
 
-                if (miny < y0) miny = y0;
-                if (maxy > y1) maxy = y1;
+    // First touch clears through the cache the raster is about to work in; a tile nothing lands on
+    // is only written once more, so it streams past the cache
+    if (!m_tile_cleared[tile])
+        clear_tile(tile, !touched);
+    if (!touched)
+    {
+        if (timed)
+            m_tile_cost_ns[tile] = (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+        return;
+    }
 
-                if (minx > maxx || miny > maxy) continue;
+    if (m_job.vis_on)
+    {
+        for (int y = y0; y <= y1; ++y)
+        {
+            std::uint32_t* row = m_vis_ids.data() + (std::size_t)y * (std::size_t)m_vis_target.pitch_pixels;
+            std::fill(row + x0, row + x1 + 1, kNoVisId);
+        }
+    }
 
-#ifdef USE_SIMD
-                vec4 nrm{};
-                __m128 n0_v = _mm_load_ps(v0.n.data());
-                __m128 n1_v = _mm_load_ps(v1.n.data());
-                __m128 n2_v = _mm_load_ps(v2.n.data());
-                __m128 nsum = _mm_add_ps(_mm_add_ps(n0_v, n1_v), n2_v);
-                _mm_store_ps(nrm.data(), nsum);
-#else
-                vec4 nrm = v0.n + v1.n + v2.n;
-#endif
-                nrm.normalise();
+    const auto raster_bins = [&](raster_pass pass) noexcept
+    {
+        raster_pixel_counts sum{};
+        for (int s = 0; s < kGeometryBatches; ++s)
+        {
+            const std::vector<setup_tri>& tris = m_setup_tris[s];
+            for (const std::uint32_t idx : m_tile_bins[s][tile])
+                sum += raster_setup_tri(tris[idx], pass, x0, y0, x1, y1);
+        }
+        return sum;
+    };
+
+    // The pre-pass leaves the tile's final depth, so the equal pass after it shades what is visible
+    raster_pixel_counts counts = m_job.prepass_on ? raster_bins(raster_pass::depth) : raster_pixel_counts{};
+    const raster_pass pass = m_job.vis_on ? raster_pass::ids : (m_job.prepass_on ? raster_pass::equal : raster_pass::shade);
+    const raster_pixel_counts drawn = raster_bins(pass);
+    counts.tested += drawn.tested;
+
+    // Visibility ids and the equal pass shade once per visible pixel, forward shading on every depth pass
+    const std::uint32_t shaded = m_job.vis_on ? resolve_visibility_tile(x0, y0, x1, y1) : drawn.passed;
+    if (m_job.shadow_strength > 0.f)
+        shade_tile_shadows(x0, y0, x1, y1);
+    if (!m_tile_lights[tile].empty())
+        shade_tile_lights(tile, x0, y0, x1, y1);
+
+    worker_counters& c = local_counters();
+    c.pixels_tested.fetch_add(counts.tested, std::memory_order_relaxed);
+    c.pixels_shaded.fetch_add(shaded, std::memory_order_relaxed);
+
+    if (m_debug_view == debug_view::overdraw)
+        overdraw_heat_tile(x0, y0, x1, y1);
+    if (timed)
+        m_tile_cost_ns[tile] = (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+}
 
-                float ndotl = vec4::dot(nrm, light_dir_in);
-                if (ndotl < 0.f) ndotl = 0.f;
+std::uint64_t optimized_renderer_core::tile_signature(std::uint32_t tile) const noexcept
+{
+    // In raster order, since equal depths resolve to whichever triangle came first
+    std::uint64_t h = kSignatureSeed;
+    for (int s = 0; s < kGeometryBatches; ++s)
+    {
+        const std::vector<setup_tri>& tris = m_setup_tris[s];
+        for (const std::uint32_t idx : m_tile_bins[s][tile])
+            mix_hash(h, setup_tri_hash(tris[idx]));
+    }
 
-                const float intensity = mat.ka + mat.kd * ndotl;
+    // Then every light binned here, whether or not the tile's depth range keeps it
+    for (const std::uint16_t idx : m_tile_lights[tile])
+    {
+        const view_light& l = m_lights[idx];
+        for (const float v : { l.x, l.y, l.z, l.radius, l.r, l.g, l.b })
+            mix_hash(h, v);
+    }
 
-                // Edge function setup
-                const float e0_a = (v2.y - v1.y) * sign;
-                const float e0_b = (v1.x - v2.x) * sign;
-                const float e0_c = (v2.x * v1.y - v2.y * v1.x) * sign;
+    // Then the shadow maps that may fall here
+    if (m_job.shadow_strength > 0.f)
+    {
+        mix_hash(h, m_shadow_static_version);
+        const int tx = (int)(tile % (std::uint32_t)m_tiles_x);
+        const int ty = (int)(tile / (std::uint32_t)m_tiles_x);
+        for (const int* r : { m_shadow_dynamic_rect, m_shadow_dynamic_rect_prev })
+            if (tx >= r[0] && tx <= r[2] && ty >= r[1] && ty <= r[3])
+                mix_hash(h, m_shadow_dynamic_hash);
+    }
+    return h;
+}
 
-                const float e1_a = (v0.y - v2.y) * sign;
-                const float e1_b = (v2.x - v0.x) * sign;
-                const float e1_c = (v0.x * v2.y - v0.y * v2.x) * sign;
+void optimized_renderer_core::overdraw_heat_tile(int x0, int y0, int x1, int y1) const noexcept
+{
+    // Counts sit in the low bits above the opaque black clear
+    const float scale = 1.f / (float)(kOverdrawHeatMax - 1u);
+    for (int y = y0; y <= y1; ++y)
+    {
+        std::uint32_t* row = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
+        for (int x = x0; x <= x1; ++x)
+        {
+            const std::uint32_t n = row[x] & 0x00FFFFFFu;
+            row[x] = n ? heat_rgba((float)(n - 1u) * scale) : 0xFF000000u;
+        }
+    }
+}
 
-                const float e2_a = (v1.y - v0.y) * sign;
-                const float e2_b = (v0.x - v1.x) * sign;
-                const float e2_c = (v1.x * v0.y - v1.y * v0.x) * sign;
+std::uint32_t optimized_renderer_core::resolve_visibility_tile(int x0, int y0, int x1, int y1) const noexcept
+{
+    std::uint32_t shaded = 0;
+    for (int y = y0; y <= y1; ++y)
+    {
+        const std::uint32_t* ids = m_vis_ids.data() + (std::size_t)y * (std::size_t)m_vis_target.pitch_pixels;
+        std::uint32_t* crow = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
+        const float py = (float)y + 0.5f;
 
-                const float start_x = (float)minx + 0.5f;
-                const float start_y = (float)miny + 0.5f;
+        for (int x = first_shaded_x(x0, y); x <= x1; x += shaded_x_step())
+        {
+            const std::uint32_t id = ids[x];
+            if (id == kNoVisId) continue;
 
-                float w0_row = e0_a * start_x + e0_b * start_y + e0_c;
-                float w1_row = e1_a * start_x + e1_b * start_y + e1_c;
-                float w2_row = e2_a * start_x + e2_b * start_y + e2_c;
+            const setup_tri& st = m_setup_tris[id >> kVisBatchShift][id & kVisIndexMask];
+            crow[x] = shade_setup_pixel(st, (float)x + 0.5f, py);
+            ++shaded;
+        }
+    }
+    return shaded;
+}
 
-                const float dzdx = (e0_a * v0.z + e1_a * v1.z + e2_a * v2.z) * inv_area;
-                const float dzdy = (e0_b * v0.z + e1_b * v1.z + e2_b * v2.z) * inv_area;
-                float z_row = (w0_row * v0.z + w1_row * v1.z + w2_row * v2.z) * inv_area;
+void optimized_renderer_core::shade_tile_shadows(int x0, int y0, int x1, int y1) const noexcept
+{
+    // Stored depth d is 1 - ndc z, so view depth is D / (C + 1 - d), and the view space point is
+    // depth times the ray through the pixel. A map takes it to depth * (M * ray) + t.
+    const float pc = perspective(2, 2) + 1.f;
+    const float pd = perspective(2, 3);
+    const float keep = 1.f - m_job.shadow_strength;
+
+    const shadow_map* maps[2]{};
+    int map_count = 0;
+    for (const shadow_map* map : { &m_shadow_static, &m_shadow_dynamic })
+        if (map->casters)
+            maps[map_count++] = map;
 
-                // For textured rendering perspective correct UV interpolation
-                float d_invw_dx = 0.f, d_invw_dy = 0.f;
-                float d_uow_dx  = 0.f, d_uow_dy  = 0.f;
-                float d_vow_dx  = 0.f, d_vow_dy  = 0.f;
-                float invw_row  = 0.f;
-                float uow_row   = 0.f;
-                float vow_row   = 0.f;
-
-                if (use_tex)
-                {
-                    const float inv_w0 = 1.f / v0.w;
-                    const float inv_w1 = 1.f / v1.w;
-                    const float inv_w2 = 1.f / v2.w;
+    for (int y = y0; y <= y1; ++y)
+    {
+        const float ry = (1.f - ((float)y + 0.5f) * 2.f / m_job.fh) / perspective(1, 1);
+        std::uint32_t* crow = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
+        for (int x = first_shaded_x(x0, y); x <= x1; x += shaded_x_step())
+        {
+            const float d = zbuffer.at((std::uint32_t)x, (std::uint32_t)y);
+            if (d <= 0.f) continue;
+            const float depth = pd / (pc - d);
+            const float rx = (((float)x + 0.5f) * 2.f / m_job.fw - 1.f) / perspective(0, 0);
 
-                    const float u0w = v0.u * inv_w0;
-                    const float v0w_t = v0.v * inv_w0;
-                    const float u1w = v1.u * inv_w1;
-                    const float v1w_t = v1.v * inv_w1;
-                    const float u2w = v2.u * inv_w2;
-                    const float v2w_t = v2.v * inv_w2;
+            float lit = 1.f;
+            for (int i = 0; i < map_count; ++i)
+            {
+                const shadow_map& map = *maps[i];
+                const matrix& m = map.from_view;
+                const float u = depth * (m(0, 0) * rx + m(0, 1) * ry - m(0, 2)) + m(0, 3);
+                const float v = depth * (m(1, 0) * rx + m(1, 1) * ry - m(1, 2)) + m(1, 3);
+                const float z = depth * (m(2, 0) * rx + m(2, 1) * ry - m(2, 2)) + m(2, 3);
+                lit = (std::min)(lit, shadow_pcf4x4(map.depth.data(), map.size, u, v, z + map.bias));
+            }
+            if (lit >= 1.f) continue;
 
-                    d_invw_dx = (e0_a * inv_w0 + e1_a * inv_w1 + e2_a * inv_w2) * inv_area;
-                    d_invw_dy = (e0_b * inv_w0 + e1_b * inv_w1 + e2_b * inv_w2) * inv_area;
+            const float k = keep + (1.f - keep) * lit;
+            float r, g, b;
+            unpack_rgba8(crow[x], r, g, b);
+            crow[x] = pack_rgba8_from_rgb(r * k, g * k, b * k);
+        }
+    }
+}
 
-                    d_uow_dx = (e0_a * u0w + e1_a * u1w + e2_a * u2w) * inv_area;
-                    d_uow_dy = (e0_b * u0w + e1_b * u1w + e2_b * u2w) * inv_area;
+void optimized_renderer_core::shade_tile_lights(std::uint32_t tile, int x0, int y0, int x1, int y1) const noexcept
+{
+    // Stored depth d is 1 - ndc z, so view depth is D / (C + 1 - d) for the projection's z row (C, D).
+    // The clear, 0, lands past the far plane and is never lit.
+    const float pc = perspective(2, 2) + 1.f;
+    const float pd = perspective(2, 3);
 
-                    d_vow_dx = (e0_a * v0w_t + e1_a * v1w_t + e2_a * v2w_t) * inv_area;
-                    d_vow_dy = (e0_b * v0w_t + e1_b * v1w_t + e2_b * v2w_t) * inv_area;
+    float d_lo = 1.f, d_hi = 0.f;
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            const float d = zbuffer.at((std::uint32_t)x, (std::uint32_t)y);
+            if (d <= 0.f) continue;
+            d_lo = (std::min)(d_lo, d);
+            d_hi = (std::max)(d_hi, d);
+        }
+    }
+    if (d_hi <= 0.f) return;
+    const float near_depth = pd / (pc - d_hi);
+    const float far_depth  = pd / (pc - d_lo);
+
+    // Only the lights whose depth range meets what the tile drew
+    view_light lights[kMaxTileLights];
+    std::uint32_t count = 0;
+    for (const std::uint16_t idx : m_tile_lights[tile])
+    {
+        const view_light& l = m_lights[idx];
+        if (-l.z + l.radius < near_depth || -l.z - l.radius > far_depth) continue;
+        lights[count++] = l;
+        if (count == kMaxTileLights) break;
+    }
+    m_tile_light_count[tile] = (std::uint8_t)count;
+    if (count == 0) return;
 
-                    invw_row = (w0_row * inv_w0 + w1_row * inv_w1 + w2_row * inv_w2) * inv_area;
-                    uow_row  = (w0_row * u0w    + w1_row * u1w    + w2_row * u2w)    * inv_area;
-                    vow_row  = (w0_row * v0w_t  + w1_row * v1w_t  + w2_row * v2w_t)  * inv_area;
-                }
+    // View space x / depth and y / depth through each pixel centre
+    float ray_x[kTileSize], ray_y[kTileSize];
+    for (int x = x0; x <= x1; ++x)
+        ray_x[x - x0] = (((float)x + 0.5f) * 2.f / m_job.fw - 1.f) / perspective(0, 0);
+    for (int y = y0; y <= y1; ++y)
+        ray_y[y - y0] = (1.f - ((float)y + 0.5f) * 2.f / m_job.fh) / perspective(1, 1);
 
-                // Non-textured: pre compute the flat RGBA
-                std::uint32_t flat_rgba = 0;
-                if (!use_tex)
-                {
-                    colour lit = mat.col;
-                    lit.r *= intensity;
-                    lit.g *= intensity;
-                    lit.b *= intensity;
-                    flat_rgba = pack_rgba8_from_colour(lit);
-                }
+    const auto position = [&](int x, int y, vec4& p) noexcept
+    {
+        const float d = zbuffer.at((std::uint32_t)x, (std::uint32_t)y);
+        if (d <= 0.f) return false;
+        const float depth = pd / (pc - d);
+        p = vec4(ray_x[x - x0] * depth, ray_y[y - y0] * depth, -depth, 1.f);
+        return true;
+    };
+    // Of the two neighbours along an axis, the one nearer in depth, so silhouettes do not bend the
+    // normal; neighbours stay inside the tile, which other workers may still be writing around
+    const auto tangent = [&](const vec4& p, int xa, int ya, int xb, int yb, bool a_in, bool b_in, vec4& t) noexcept
+    {
+        vec4 pa, pb;
+        const bool has_a = a_in && position(xa, ya, pa);
+        const bool has_b = b_in && position(xb, yb, pb);
+        if (has_a && (!has_b || std::fabs(pa.z - p.z) <= std::fabs(pb.z - p.z)))
+            t = pa - p;
+        else if (has_b)
+            t = p - pb;
+        else
+            return false;
+        return true;
+    };
 
-                for (int y = miny; y <= maxy; ++y)
-                {
-                    float* zptr = zbuffer.data + (std::size_t)y * (std::size_t)zbuffer.pitch + (std::size_t)minx;
-                    std::uint32_t* cptr = framebuffer.data + (std::size_t)y * (std::size_t)pitch_pixels + (std::size_t)minx;
+    for (int y = y0; y <= y1; ++y)
+    {
+        std::uint32_t* crow = framebuffer.data + (std::size_t)y * (std::size_t)framebuffer.pitch_pixels;
+        for (int x = first_shaded_x(x0, y); x <= x1; x += shaded_x_step())
+        {
+            vec4 p;
+            if (!position(x, y, p)) continue;
+
+            vec4 tx, ty;
+            vec4 n = vec4(-p.x, -p.y, -p.z, 0.f);
+            if (tangent(p, x + 1, y, x - 1, y, x < x1, x > x0, tx) &&
+                tangent(p, x, y + 1, x, y - 1, y < y1, y > y0, ty))
+                n = vec4::cross(tx, ty);
+            // Facing the eye, whichever way the tangents wound
+            if (vec4::dot(n, p) > 0.f)
+                n = vec4(-n.x, -n.y, -n.z, 0.f);
+            n[3] = 0.f;
+            n.normalise();
+
+            float lr = 0.f, lg = 0.f, lb = 0.f;
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                const view_light& l = lights[i];
+                const float dx = l.x - p.x;
+                const float dy = l.y - p.y;
+                const float dz = l.z - p.z;
+                const float dist2 = dx * dx + dy * dy + dz * dz;
+                const float fall = 1.f - dist2 * l.inv_radius2;
+                if (fall <= 0.f) continue;
+
+                const float ndotl = (n.x * dx + n.y * dy + n.z * dz) / std::sqrt((std::max)(dist2, 1e-8f));
+                if (ndotl <= 0.f) continue;
+                const float k = fall * fall * ndotl;
+                lr += l.r * k;
+                lg += l.g * k;
+                lb += l.b * k;
+            }
+            if (lr + lg + lb <= 0.f) continue;
 
-                    float w0 = w0_row;
-                    float w1 = w1_row;
-                    float w2 = w2_row;
-                    float z  = z_row;
+            // The frame holds albedo times the sun's shade, so the lights scale what is there
+            float r, g, b;
+            unpack_rgba8(crow[x], r, g, b);
+            crow[x] = pack_rgba8_from_rgb(r * (1.f + lr), g * (1.f + lg), b * (1.f + lb));
+        }
+    }
+}
 
-                    float invw_px = invw_row;
-                    float uow_px  = uow_row;
-                    float vow_px  = vow_row;
+raster_pixel_counts optimized_renderer_core::raster_setup_tri(const setup_tri& st, raster_pass pass, int x0, int y0, int x1, int y1) const noexcept
+{
+    const int minx = (std::max)(st.minx, x0);
+    const int maxx = (std::min)(st.maxx, x1);
+    const int miny = (std::max)(st.miny, y0);
+    const int maxy = (std::min)(st.maxy, y1);
+    if (minx > maxx || miny > maxy) return {};
+
+    // The visibility pass stores triangle ids into m_vis_target instead of colours. Otherwise the
+    // kernels are the permutation for the triangle's state; a mesh's triangles share one and sit
+    // together in the bins, so consecutive calls mostly go through the same pointer.
+    const FramebufferRGBA8& target = (pass == raster_pass::ids) ? m_vis_target : framebuffer;
+    raster_rect_fn partial = m_job.raster.partial[st.state];
+    raster_rect_fn covered = m_job.raster.covered[st.state];
+    switch (pass)
+    {
+    case raster_pass::ids:   partial = m_job.raster.ids_partial;             covered = m_job.raster.ids_covered;             break;
+    case raster_pass::depth: partial = m_job.raster.depth_partial[st.state]; covered = m_job.raster.depth_covered[st.state]; break;
+    case raster_pass::equal: partial = m_job.raster.equal_partial[st.state]; covered = m_job.raster.equal_covered[st.state]; break;
+    case raster_pass::shade: break;
+    }
 
-                    if (!use_tex)
-                    {
-                        // no texture flat color per triangle
-#ifdef USE_SIMD
-                        const __m128 step   = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
-                        const __m128 e0a_v  = _mm_set1_ps(e0_a);
-                        const __m128 e1a_v  = _mm_set1_ps(e1_a);
-                        const __m128 e2a_v  = _mm_set1_ps(e2_a);
-                        const __m128 dzdx_v = _mm_set1_ps(dzdx);
-
-                        int x = minx;
-                        for (; x <= maxx - 3; x += 4)
-                        {
-                            __m128 w0v = _mm_add_ps(_mm_set1_ps(w0), _mm_mul_ps(e0a_v, step));
-                            __m128 w1v = _mm_add_ps(_mm_set1_ps(w1), _mm_mul_ps(e1a_v, step));
-                            __m128 w2v = _mm_add_ps(_mm_set1_ps(w2), _mm_mul_ps(e2a_v, step));
+    // The equal pass writes no depth, and a triangle it shades may reach the block's farthest depth
+    // with its zmax a rounding step short, a whole unorm16 step under depth16
+    const bool equal = pass == raster_pass::equal;
+    constexpr float kEqualHiZSlack = 1.f / 65535.f;
 
-                            __m128 inside = _mm_and_ps(_mm_cmpge_ps(w0v, _mm_setzero_ps()),
-                                                       _mm_and_ps(_mm_cmpge_ps(w1v, _mm_setzero_ps()),
-                                                                  _mm_cmpge_ps(w2v, _mm_setzero_ps())));
+    if (!m_job.hiz_on && !st.fixed_edges)
+        return partial(st, target, zbuffer, minx, miny, maxx, maxy);
 
-                            const int inside_mask = _mm_movemask_ps(inside);
-                            if (inside_mask)
-                            {
-                                __m128 zv   = _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(dzdx_v, step));
-                                __m128 zbuf = _mm_load_ps(zptr);
-
-                                __m128 zpass = _mm_cmpgt_ps(zv, zbuf);
-                                __m128 final_mask = _mm_and_ps(inside, zpass);
-
-                                const int write_mask = _mm_movemask_ps(final_mask);
-                                if (write_mask)
-                                {
-                                    alignas(16) float zvals[4];
-                                    _mm_store_ps(zvals, zv);
-
-                                    for (int lane = 0; lane < 4; ++lane)
-                                    {
-                                        if (write_mask & (1 << lane))
-                                        {
-                                            zptr[lane] = zvals[lane];
-                                            cptr[lane] = flat_rgba;
-                                        }
-                                    }
-                                }
-                            }
+    raster_pixel_counts counts{};
 
-                            w0 += e0_a * 4.f;
-                            w1 += e1_a * 4.f;
-                            w2 += e2_a * 4.f;
-                            z  += dzdx * 4.f;
-                            cptr += 4;
-                            zptr += 4;
-                        }
+    // Walk the 8x8 blocks under the rect. Hi-Z drops blocks whose farthest depth already hides the
+    // triangle, the fixed point edges drop empty blocks and skip per pixel edge tests on covered ones.
+    const int bx0 = minx / kHiZBlock, bx1 = maxx / kHiZBlock;
+    const int by0 = miny / kHiZBlock, by1 = maxy / kHiZBlock;
+    for (int by = by0; by <= by1; ++by)
+    {
+        const int block_y0 = by * kHiZBlock;
+        const int block_y1 = (std::min)(block_y0 + kHiZBlock, (int)m_job.H) - 1;
+        const int ry0 = (std::max)(miny, block_y0);
+        const int ry1 = (std::min)(maxy, block_y1);
 
-                        for (; x <= maxx; ++x)
-#else
-                        for (int x = minx; x <= maxx; ++x)
-#endif
-                        {
-                            if (w0 >= 0.f && w1 >= 0.f && w2 >= 0.f)
-                            {
-                                if (z > *zptr)
-                                {
-                                    *zptr = z;
-                                    *cptr = flat_rgba;
-                                }
-                            }
+        for (int bx = bx0; bx <= bx1; ++bx)
+        {
+            float* block_far = m_job.hiz_on ? &m_hiz_zmin[(std::size_t)by * (std::size_t)m_hiz_bw + (std::size_t)bx] : nullptr;
+            if (block_far && (equal ? st.zmax + kEqualHiZSlack < *block_far : st.zmax <= *block_far)) continue;
 
-                            w0 += e0_a;
-                            w1 += e1_a;
-                            w2 += e2_a;
-                            z  += dzdx;
-                            ++cptr;
-                            ++zptr;
-                        }
-                    }
-                    else
-                    {
-                        // Textured path per pixel perspective correct UV sampling
-                        for (int x = minx; x <= maxx; ++x)
-                        {
-                            if (w0 >= 0.f && w1 >= 0.f && w2 >= 0.f)
-                            {
-                                if (z > *zptr)
-                                {
-                                    const float rcp_invw = (invw_px > 0.0001f) ? (1.f / invw_px) : 1.f;
-                                    const float uu = uow_px * rcp_invw;
-                                    const float vv = vow_px * rcp_invw;
+            const int block_x0 = bx * kHiZBlock;
+            const int block_x1 = (std::min)(block_x0 + kHiZBlock, (int)m_job.W) - 1;
+            const int rx0 = (std::max)(minx, block_x0);
+            const int rx1 = (std::min)(maxx, block_x1);
 
-                                    const std::uint32_t tex_color = tex.sample_nearest(uu, vv);
+            const block_coverage cov = st.fixed_edges ? classify_block(st, rx0, ry0, rx1, ry1) : block_coverage::partial;
+            if (cov == block_coverage::empty) continue;
 
-                                    *zptr = z;
-                                    *cptr = modulate_texture(tex_color, intensity);
-                                }
-                            }
+            if (cov == block_coverage::full)
+                counts += covered(st, target, zbuffer, rx0, ry0, rx1, ry1);
+            else
+                counts += partial(st, target, zbuffer, rx0, ry0, rx1, ry1);
 
-                            w0 += e0_a;
-                            w1 += e1_a;
-                            w2 += e2_a;
-                            z  += dzdx;
-                            invw_px += d_invw_dx;
-                            uow_px  += d_uow_dx;
-                            vow_px  += d_vow_dx;
-                            ++cptr;
-                            ++zptr;
-                        }
-                    }
+            // Partial covers leave the old, lower value in place which is still a valid bound
+            if (block_far && !equal && rx0 == block_x0 && rx1 == block_x1 && ry0 == block_y0 && ry1 == block_y1)
+                *block_far = hiz_block_farthest(block_x0, block_y0, block_x1, block_y1);
+        }
+    }
+    return counts;
+}
 
-                    w0_row += e0_b;
-                    w1_row += e1_b;
-                    w2_row += e2_b;
-                    z_row  += dzdy;
+float optimized_renderer_core::hiz_block_farthest(int x0, int y0, int x1, int y1) const noexcept
+{
+    if (zbuffer.data16)
+    {
+        std::uint16_t farthest = 0xFFFFu;
+        for (int y = y0; y <= y1; ++y)
+        {
+            const std::uint16_t* qrow = zbuffer.data16 + (std::size_t)y * (std::size_t)zbuffer.pitch;
+            for (int x = x0; x <= x1; ++x)
+                farthest = (std::min)(farthest, qrow[x]);
+        }
+        return depth16_decode(farthest);
+    }
 
-                    if (use_tex)
-                    {
-                        invw_row += d_invw_dy;
-                        uow_row  += d_uow_dy;
-                        vow_row  += d_vow_dy;
-                    }
-                }
-            }
+    float farthest = (std::numeric_limits<float>::max)();
+    for (int y = y0; y <= y1; ++y)
+    {
+        const float* zrow = zbuffer.data + (std::size_t)y * (std::size_t)zbuffer.pitch;
+        int x = x0;
+#ifdef USE_SIMD
+        if (x1 - x0 + 1 == kHiZBlock)
+        {
+            const __m128 m = _mm_min_ps(_mm_loadu_ps(zrow + x0), _mm_loadu_ps(zrow + x0 + 4));
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, m);
+            farthest = (std::min)({ farthest, lanes[0], lanes[1], lanes[2], lanes[3] });
+            continue;
         }
+#endif
+        for (; x <= x1; ++x)
+            farthest = (std::min)(farthest, zrow[x]);
     }
+    return farthest;
 }
 
 void optimized_renderer_core::pin_draw_query_once() noexcept
@@ -1154,12 +4103,13 @@ void optimized_renderer_core::pin_draw_query_once() noexcept
     pinned_draw_blocks.reserve(render_cache_.blocks().size());
     for (const auto& b : render_cache_.blocks())
     {
-        auto [m, t, mat, tex] = b.arrays;
+        auto [m, t, mat, tex, bounds] = b.arrays;
         draw_pinned_block out{};
         out.meshes     = m;
         out.transforms = t;
         out.materials  = mat;
         out.textures   = tex;
+        out.bounds     = bounds;
         out.n = b.n;
         pinned_draw_blocks.emplace_back(out);
     }
@@ -1190,6 +4140,7 @@ void optimized_renderer_core::ensure_offline_targets(std::uint32_t w, std::uint3
 
 void optimized_renderer_core::refresh_render_cache() noexcept
 {
+    instanced_cache_.refresh(world);
     render_cache_.refresh(world);
     const std::uint64_t version = render_cache_.version();
     if (!pinned_draw_ready || render_cache_version_ != version)
@@ -0,0 +1,337 @@
+#include "optimized/optimized_renderer.h"
+
+// Built with AVX2 code generation regardless of FOX_SIMD_LEVEL, only reached when m_job.isa is avx2
+#ifdef USE_SIMD
+#include <immintrin.h>
+
+// Eight pixels as float channels in [0, 1], for the effect sweeps
+struct rgb8x
+{
+    __m256 r, g, b;
+};
+
+static inline rgb8x unpack8_rgba8(__m256i px) noexcept
+{
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    const __m256 inv255 = _mm256_set1_ps(1.f / 255.f);
+    return {
+        _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(px, mask)), inv255),
+        _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), mask)), inv255),
+        _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), mask)), inv255),
+    };
+}
+
+static inline __m256 clamp01_8(__m256 v) noexcept
+{
+    return _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+}
+
+// Truncates like pack_rgba8_from_rgb, so the scalar tails match
+static inline __m256i pack8_rgba8(const rgb8x& c) noexcept
+{
+    const __m256 s = _mm256_set1_ps(255.f);
+    const __m256i r = _mm256_cvttps_epi32(_mm256_mul_ps(clamp01_8(c.r), s));
+    const __m256i g = _mm256_cvttps_epi32(_mm256_mul_ps(clamp01_8(c.g), s));
+    const __m256i b = _mm256_cvttps_epi32(_mm256_mul_ps(clamp01_8(c.b), s));
+    return _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 8)),
+                           _mm256_or_si256(_mm256_slli_epi32(b, 16), _mm256_set1_epi32((int)0xFF000000u)));
+}
+
+static inline rgb8x lerp8(const rgb8x& a, const rgb8x& b, __m256 t) noexcept
+{
+    return {
+        _mm256_fmadd_ps(_mm256_sub_ps(b.r, a.r), t, a.r),
+        _mm256_fmadd_ps(_mm256_sub_ps(b.g, a.g), t, a.g),
+        _mm256_fmadd_ps(_mm256_sub_ps(b.b, a.b), t, a.b),
+    };
+}
+
+static inline __m256i hash8_u32(__m256i v) noexcept
+{
+    v = _mm256_xor_si256(v, _mm256_srli_epi32(v, 16));
+    v = _mm256_mullo_epi32(v, _mm256_set1_epi32(0x7FEB352D));
+    v = _mm256_xor_si256(v, _mm256_srli_epi32(v, 15));
+    v = _mm256_mullo_epi32(v, _mm256_set1_epi32((int)0x846CA68Bu));
+    return _mm256_xor_si256(v, _mm256_srli_epi32(v, 16));
+}
+
+std::size_t optimized_renderer_core::clip_matrices_avx2(std::size_t begin, std::size_t end) noexcept
+{
+    const matrix vp = m_job.vp;
+    std::size_t i = begin;
+
+    // Two entities per pass, one in each 128 bit lane: row r of vp * world is the sum over k of
+    // vp(r, k) times row k of world
+    __m256 vpk[4][4];
+    for (int r = 0; r < 4; ++r)
+        for (int k = 0; k < 4; ++k)
+            vpk[r][k] = _mm256_set1_ps(vp(r, k));
+
+    for (; i + 2u <= end; i += 2u)
+    {
+        const matrix& wa = m_geo_entities[i].transform->world;
+        const matrix& wb = m_geo_entities[i + 1u].transform->world;
+
+        __m256 rows[4];
+        for (int k = 0; k < 4; ++k)
+            rows[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(&wa(k, 0))), _mm_load_ps(&wb(k, 0)), 1);
+
+        matrix& ca = m_geo_xforms.clip[i];
+        matrix& cb = m_geo_xforms.clip[i + 1u];
+        for (int r = 0; r < 4; ++r)
+        {
+            __m256 acc = _mm256_mul_ps(vpk[r][0], rows[0]);
+            acc = _mm256_fmadd_ps(vpk[r][1], rows[1], acc);
+            acc = _mm256_fmadd_ps(vpk[r][2], rows[2], acc);
+            acc = _mm256_fmadd_ps(vpk[r][3], rows[3], acc);
+            _mm_store_ps(&ca(r, 0), _mm256_castps256_ps128(acc));
+            _mm_store_ps(&cb(r, 0), _mm256_extractf128_ps(acc, 1));
+        }
+    }
+    return i;
+}
+
+std::size_t optimized_renderer_core::decode_quant_vertices_avx2(const quant_vertex* qv, std::size_t from, std::size_t to,
+                                                                const matrix& pq, const matrix& nm) noexcept
+{
+    const float fw = m_job.fw;
+    const float fh = m_job.fh;
+    const auto finish = [&](post_vtx& out, const vec4& n) noexcept
+    {
+        const SVtx sv = make_svtx(out.hp, n, fw, fh, colour{});
+        out.n = sv.n;
+        out.x = sv.x;
+        out.y = sv.y;
+        out.z = sv.z;
+    };
+    std::size_t v = from;
+
+    // Two vertices per pass, one in each 128 bit lane. Columns of the matrices are broadcast to
+    // both lanes and scaled by the lane's own components.
+    __m256 pc[4], nc[3];
+    for (unsigned int k = 0; k < 4; ++k)
+        pc[k] = _mm256_setr_ps(pq(0, k), pq(1, k), pq(2, k), pq(3, k), pq(0, k), pq(1, k), pq(2, k), pq(3, k));
+    for (unsigned int k = 0; k < 3; ++k)
+        nc[k] = _mm256_setr_ps(nm(0, k), nm(1, k), nm(2, k), 0.f, nm(0, k), nm(1, k), nm(2, k), 0.f);
+
+    // Zero extends pos[0..3] to 32 bits; puts oct[0..1] in the top half of a 32 bit lane for the sign extending shift
+    const __m256i pos_lanes = _mm256_setr_epi8(
+        0, 1, -1, -1, 2, 3, -1, -1, 4, 5, -1, -1, 6, 7, -1, -1,
+        0, 1, -1, -1, 2, 3, -1, -1, 4, 5, -1, -1, 6, 7, -1, -1);
+    const __m256i oct_lanes = _mm256_setr_epi8(
+        -1, -1, 8, 9, -1, -1, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, 8, 9, -1, -1, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256 sign_bit = _mm256_set1_ps(-0.f);
+    const __m256 one      = _mm256_set1_ps(1.f);
+    const __m256 snorm    = _mm256_set1_ps(1.f / 32767.f);
+
+    for (; v + 2u <= to; v += 2u, qv += 2)
+    {
+        const __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(qv));
+
+        // pos[3] is 1, so q already is (x, y, z, 1)
+        const __m256 q = _mm256_cvtepi32_ps(_mm256_shuffle_epi8(raw, pos_lanes));
+        __m256 hp = _mm256_mul_ps(pc[0], _mm256_permute_ps(q, 0x00));
+        hp = _mm256_fmadd_ps(pc[1], _mm256_permute_ps(q, 0x55), hp);
+        hp = _mm256_fmadd_ps(pc[2], _mm256_permute_ps(q, 0xAA), hp);
+        hp = _mm256_fmadd_ps(pc[3], _mm256_permute_ps(q, 0xFF), hp);
+
+        // Octahedral decode as in oct_decode, then the normal matrix and a renormalise that
+        // octahedral normals always need
+        const __m256 o  = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_shuffle_epi8(raw, oct_lanes), 16)), snorm);
+        const __m256 ox = _mm256_permute_ps(o, 0x00);
+        const __m256 oy = _mm256_permute_ps(o, 0x55);
+        const __m256 oz = _mm256_sub_ps(_mm256_sub_ps(one, _mm256_andnot_ps(sign_bit, ox)), _mm256_andnot_ps(sign_bit, oy));
+        const __m256 t  = _mm256_max_ps(_mm256_xor_ps(oz, sign_bit), _mm256_setzero_ps());
+        const __m256 nx = _mm256_sub_ps(ox, _mm256_or_ps(t, _mm256_and_ps(ox, sign_bit)));
+        const __m256 ny = _mm256_sub_ps(oy, _mm256_or_ps(t, _mm256_and_ps(oy, sign_bit)));
+
+        __m256 n = _mm256_mul_ps(nc[0], nx);
+        n = _mm256_fmadd_ps(nc[1], ny, n);
+        n = _mm256_fmadd_ps(nc[2], oz, n);
+        n = _mm256_mul_ps(n, _mm256_rsqrt_ps(_mm256_dp_ps(n, n, 0x7F)));
+
+        alignas(32) vec4 n2[2];
+        _mm256_store_ps(n2[0].data(), n);
+        post_vtx& out0 = m_post_vtx[v];
+        post_vtx& out1 = m_post_vtx[v + 1u];
+        _mm_store_ps(out0.hp.data(), _mm256_castps256_ps128(hp));
+        _mm_store_ps(out1.hp.data(), _mm256_extractf128_ps(hp, 1));
+        finish(out0, n2[0]);
+        finish(out1, n2[1]);
+    }
+    return v;
+}
+
+void optimized_renderer_core::depth_tri_row_avx2(const occluder_tri& ot, float* row, float r0, float r1, float r2, float rz) noexcept
+{
+    int x = ot.minx;
+    const __m256 lane = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256i lane_i = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 zero = _mm256_setzero_ps();
+    for (; x <= ot.maxx; x += 8)
+    {
+        const __m256 cx = _mm256_add_ps(_mm256_set1_ps((float)x), lane);
+        const __m256 e0 = _mm256_fmadd_ps(_mm256_set1_ps(ot.ea[0]), cx, _mm256_set1_ps(r0));
+        const __m256 e1 = _mm256_fmadd_ps(_mm256_set1_ps(ot.ea[1]), cx, _mm256_set1_ps(r1));
+        const __m256 e2 = _mm256_fmadd_ps(_mm256_set1_ps(ot.ea[2]), cx, _mm256_set1_ps(r2));
+        const __m256 inside = _mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ),
+                              _mm256_and_ps(_mm256_cmp_ps(e1, zero, _CMP_GE_OQ), _mm256_cmp_ps(e2, zero, _CMP_GE_OQ)));
+        const __m256i in_row = _mm256_cmpgt_epi32(_mm256_set1_epi32(ot.maxx - x + 1), lane_i);
+        const __m256i mask = _mm256_and_si256(_mm256_castps_si256(inside), in_row);
+        if (_mm256_testz_si256(mask, mask)) continue;
+
+        const __m256 z = _mm256_max_ps(_mm256_fmadd_ps(_mm256_set1_ps(ot.za), cx, _mm256_set1_ps(rz)), _mm256_set1_ps(ot.zmin));
+        const __m256 cur = _mm256_maskload_ps(row + x, mask);
+        _mm256_maskstore_ps(row + x, mask, _mm256_max_ps(cur, z));
+    }
+}
+
+std::uint32_t optimized_renderer_core::rain_row_avx2(const rainy_effect_settings& settings, std::uint32_t* row, const float* zrow,
+                                                     float row_phase, float inv_length, std::uint32_t W) const noexcept
+{
+    const float depth_weight = settings.depth_weight;
+    const float depth_bias = settings.depth_bias;
+    const float tint_r = settings.tint.r;
+    const float tint_g = settings.tint.g;
+    const float tint_b = settings.tint.b;
+    const float* phase_x = m_rain_phase.data();
+    const float* jitter_x = m_rain_jitter.data();
+    std::uint32_t x = 0;
+
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 row_phase_v = _mm256_set1_ps(row_phase);
+    const __m256 inv_length_v = _mm256_set1_ps(inv_length);
+    const __m256 intensity_v = _mm256_set1_ps(settings.intensity);
+    const __m256 darken_v = _mm256_set1_ps(settings.darken);
+    const rgb8x tint{ _mm256_set1_ps(tint_r), _mm256_set1_ps(tint_g), _mm256_set1_ps(tint_b) };
+
+    for (; x + 8 <= W; x += 8)
+    {
+        __m256 phase = _mm256_add_ps(row_phase_v, _mm256_loadu_ps(phase_x + x));
+        phase = _mm256_sub_ps(phase, _mm256_floor_ps(phase));
+        const __m256 streak = _mm256_fnmadd_ps(phase, inv_length_v, one);
+        const __m256 jitter = _mm256_loadu_ps(jitter_x + x);
+        __m256 mask = _mm256_and_ps(_mm256_cmp_ps(streak, zero, _CMP_GT_OQ), _mm256_cmp_ps(jitter, zero, _CMP_GT_OQ));
+        if (!_mm256_movemask_ps(mask)) continue;
+
+        const __m256 z = _mm256_loadu_ps(zrow + x);
+        const __m256 depth_factor = clamp01_8(_mm256_fmadd_ps(_mm256_sub_ps(one, z), _mm256_set1_ps(depth_weight), _mm256_set1_ps(depth_bias)));
+        const __m256 drop = _mm256_mul_ps(_mm256_mul_ps(streak, intensity_v), _mm256_mul_ps(depth_factor, jitter));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(drop, zero, _CMP_GT_OQ));
+        if (!_mm256_movemask_ps(mask)) continue;
+
+        const __m256i px = _mm256_loadu_si256((const __m256i*)(row + x));
+        rgb8x c = unpack8_rgba8(px);
+        const __m256 darken = _mm256_fnmadd_ps(drop, darken_v, one);
+        c.r = _mm256_fmadd_ps(c.r, darken, _mm256_mul_ps(tint.r, drop));
+        c.g = _mm256_fmadd_ps(c.g, darken, _mm256_mul_ps(tint.g, drop));
+        c.b = _mm256_fmadd_ps(c.b, darken, _mm256_mul_ps(tint.b, drop));
+        _mm256_storeu_si256((__m256i*)(row + x), _mm256_blendv_epi8(px, pack8_rgba8(c), _mm256_castps_si256(mask)));
+    }
+    return x;
+}
+
+std::uint32_t optimized_renderer_core::advanced_effects_row_avx2(const effects_row& er) const noexcept
+{
+    const advanced_effects_settings& settings = er.settings;
+    std::uint32_t* row = er.row;
+    const std::uint32_t* row_copy = er.row_copy;
+    const float* zrow = er.zrow;
+    const bool depth_on = zrow != nullptr;
+    const bool bloom_on = er.bloom_on;
+    const bool dof_on = er.dof_on;
+    const std::uint32_t* bloom_row = er.bloom_row;
+    const std::uint32_t* half_row = er.half_row;
+    const std::uint32_t* quarter_row = er.quarter_row;
+    const std::uint32_t* mirror_row = er.mirror_row;
+    const float fog_inv_range = er.fog_inv_range;
+    const float dof_inv_range = er.dof_inv_range;
+    const float mb = er.mb;
+    const float fx_scale = er.fx_scale;
+    const float god_dy = er.god_dy;
+    const std::uint32_t grain_row = er.grain_row;
+    const std::uint32_t W = er.W;
+    std::uint32_t x = 0;
+
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 step = _mm256_set_ps(7.f, 6.f, 5.f, 4.f, 3.f, 2.f, 1.f, 0.f);
+    const __m256i lane = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    const rgb8x fog{ _mm256_set1_ps(settings.fog_colour.r), _mm256_set1_ps(settings.fog_colour.g), _mm256_set1_ps(settings.fog_colour.b) };
+
+    for (; x + 8 <= W; x += 8)
+    {
+        rgb8x c = unpack8_rgba8(_mm256_loadu_si256((const __m256i*)(row_copy + x)));
+
+        if (bloom_on)
+        {
+            const rgb8x bl = unpack8_rgba8(_mm256_loadu_si256((const __m256i*)(bloom_row + x)));
+            const __m256 k = _mm256_set1_ps(settings.bloom_intensity);
+            c.r = _mm256_fmadd_ps(bl.r, k, c.r);
+            c.g = _mm256_fmadd_ps(bl.g, k, c.g);
+            c.b = _mm256_fmadd_ps(bl.b, k, c.b);
+        }
+
+        const __m256 depth = depth_on ? clamp01_8(_mm256_loadu_ps(zrow + x)) : _mm256_setzero_ps();
+
+        if (settings.fog_enabled)
+        {
+            const __m256 t = clamp01_8(_mm256_mul_ps(_mm256_sub_ps(depth, _mm256_set1_ps(settings.fog_start)), _mm256_set1_ps(fog_inv_range)));
+            c = lerp8(c, fog, t);
+        }
+
+        if (settings.ssr_enabled)
+        {
+            const rgb8x m = unpack8_rgba8(_mm256_loadu_si256((const __m256i*)(mirror_row + x)));
+            c = lerp8(c, m, _mm256_mul_ps(_mm256_set1_ps(settings.ssr_strength), _mm256_sub_ps(one, depth)));
+        }
+
+        if (dof_on)
+        {
+            const __m256 blur_t = clamp01_8(_mm256_mul_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.f), _mm256_sub_ps(depth, _mm256_set1_ps(settings.dof_focus))),
+                                                          _mm256_set1_ps(dof_inv_range)));
+            const rgb8x h = unpack8_rgba8(_mm256_loadu_si256((const __m256i*)(half_row + x)));
+            const rgb8x q = unpack8_rgba8(_mm256_loadu_si256((const __m256i*)(quarter_row + x)));
+            const rgb8x blurred = lerp8(h, q, clamp01_8(_mm256_mul_ps(_mm256_sub_ps(blur_t, half), _mm256_set1_ps(2.f))));
+            c = lerp8(c, blurred, _mm256_min_ps(_mm256_add_ps(blur_t, blur_t), one));
+        }
+
+        if (settings.god_rays_enabled)
+        {
+            const __m256 dx = _mm256_fmsub_ps(_mm256_add_ps(_mm256_set1_ps((float)x), step), _mm256_set1_ps(fx_scale), _mm256_set1_ps(settings.god_rays_screen_pos.x));
+            const __m256 dist = _mm256_sqrt_ps(_mm256_fmadd_ps(dx, dx, _mm256_set1_ps(god_dy * god_dy)));
+            const __m256 shaft = _mm256_mul_ps(clamp01_8(_mm256_fnmadd_ps(dist, _mm256_set1_ps(1.5f), one)), _mm256_set1_ps(settings.god_rays_strength));
+            c.r = _mm256_add_ps(c.r, shaft);
+            c.g = _mm256_add_ps(c.g, shaft);
+            c.b = _mm256_add_ps(c.b, shaft);
+        }
+
+        if (settings.motion_blur_enabled)
+        {
+            const rgb8x l = unpack8_rgba8(_mm256_loadu_si256((const __m256i*)(row_copy + x - 1)));
+            const rgb8x r = unpack8_rgba8(_mm256_loadu_si256((const __m256i*)(row_copy + x + 1)));
+            const rgb8x blurred{ _mm256_mul_ps(_mm256_add_ps(l.r, r.r), half),
+                                 _mm256_mul_ps(_mm256_add_ps(l.g, r.g), half),
+                                 _mm256_mul_ps(_mm256_add_ps(l.b, r.b), half) };
+            c = lerp8(c, blurred, _mm256_set1_ps(mb));
+        }
+
+        if (settings.film_grain_enabled)
+        {
+            const __m256i h = hash8_u32(_mm256_xor_si256(_mm256_mullo_epi32(_mm256_add_epi32(_mm256_set1_epi32((int)x), lane), _mm256_set1_epi32((int)0x9E3779B1u)),
+                                                         _mm256_set1_epi32((int)grain_row)));
+            const __m256 noise = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8)), _mm256_set1_ps(1.f / 16777216.f));
+            const __m256 grain = _mm256_mul_ps(_mm256_sub_ps(noise, half), _mm256_set1_ps(settings.film_grain_strength));
+            c.r = _mm256_add_ps(c.r, grain);
+            c.g = _mm256_add_ps(c.g, grain);
+            c.b = _mm256_add_ps(c.b, grain);
+        }
+
+        _mm256_storeu_si256((__m256i*)(row + x), pack8_rgba8(c));
+    }
+    return x;
+}
+
+#endif
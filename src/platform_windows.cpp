@@ -68,6 +68,10 @@ public:
     bool cursor_hidden = false;
     bool cursor_clipped = false;
     bool close_requested = false;
+    bool relative_mouse = false;
+    bool input_held = false;
+    int mouse_dx = 0;
+    int mouse_dy = 0;
 
     HICON icon_small = nullptr;
     HICON icon_big   = nullptr;
@@ -94,7 +98,42 @@ public:
             TranslateMessage(&msg);
             DispatchMessageW(&msg);
         }
+        if (self.input_held) return;
         self.age_buttons_once_per_frame();
+        self.take_cursor_travel();
+    }
+
+    void take_cursor_travel() noexcept
+    {
+        mouse_dx = mouse_dy = 0;
+        if (!relative_mouse || !hwnd) return;
+
+        POINT cursor{};
+        if (!GetCursorPos(&cursor)) return;
+        ScreenToClient(hwnd, &cursor);
+        RECT rect{};
+        GetClientRect(hwnd, &rect);
+        const int cx = (rect.right - rect.left) / 2;
+        const int cy = (rect.bottom - rect.top) / 2;
+        mouse_dx = cursor.x - cx;
+        mouse_dy = cursor.y - cy;
+
+        POINT centre{ cx, cy };
+        ClientToScreen(hwnd, &centre);
+        SetCursorPos(centre.x, centre.y);
+    }
+
+    [[nodiscard]] static bool is_input_message(UINT msg) noexcept
+    {
+        switch (msg)
+        {
+        case WM_KEYDOWN: case WM_KEYUP: case WM_MOUSEMOVE: case WM_MOUSEWHEEL:
+        case WM_LBUTTONDOWN: case WM_LBUTTONUP: case WM_MBUTTONDOWN: case WM_MBUTTONUP:
+        case WM_RBUTTONDOWN: case WM_RBUTTONUP:
+            return true;
+        default:
+            return false;
+        }
     }
 
     static LRESULT CALLBACK WndProc(HWND hwnd_, UINT msg, WPARAM wp, LPARAM lp)
@@ -117,6 +156,7 @@ public:
     LRESULT real_wndproc(HWND hwnd_, UINT msg, WPARAM wp, LPARAM lp)
     {
         if (imgui_hook::instance().message_pump(hwnd_, msg, wp, lp)) return 0;
+        if (input_held && is_input_message(msg)) return 0;
 
         switch (msg)
         {
@@ -407,6 +447,11 @@ namespace fox
         pimpl::pump_messages(*p_);
     }
 
+    void platform_window::wait_messages(std::uint32_t timeout_ms) const noexcept
+    {
+        MsgWaitForMultipleObjectsEx(0, nullptr, (DWORD)timeout_ms, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+    }
+
     void* platform_window::native_hwnd() const noexcept
     {
         return p_ ? (void*)p_->hwnd : nullptr;
@@ -483,4 +528,51 @@ namespace fox
         const auto st = p_->buttons[(int)b];
         return (st == mouse_button_state::down) || (st == mouse_button_state::pressed);
     }
+
+    void platform_window::set_relative_mouse(bool enabled) noexcept
+    {
+        if (!p_) return;
+        p_->relative_mouse = enabled;
+        if (!enabled)
+            p_->mouse_dx = p_->mouse_dy = 0;
+    }
+
+    int platform_window::mouse_dx() const noexcept { return p_ ? p_->mouse_dx : 0; }
+    int platform_window::mouse_dy() const noexcept { return p_ ? p_->mouse_dy : 0; }
+
+    input_state platform_window::input() const noexcept
+    {
+        input_state s{};
+        if (!p_) return s;
+        for (unsigned k = 0; k < 256; ++k)
+            if (p_->keys[k])
+                s.keys[k >> 6] |= 1ull << (k & 63u);
+        s.mouse_x = p_->mx;
+        s.mouse_y = p_->my;
+        s.wheel = p_->wheel;
+        s.mouse_dx = p_->mouse_dx;
+        s.mouse_dy = p_->mouse_dy;
+        for (int i = 0; i < 3; ++i)
+            s.buttons[i] = p_->buttons[i];
+        return s;
+    }
+
+    void platform_window::set_input(const input_state& state) noexcept
+    {
+        if (!p_) return;
+        for (unsigned k = 0; k < 256; ++k)
+            p_->keys[k] = ((state.keys[k >> 6] >> (k & 63u)) & 1u) != 0;
+        p_->mx = state.mouse_x;
+        p_->my = state.mouse_y;
+        p_->wheel = state.wheel;
+        p_->mouse_dx = state.mouse_dx;
+        p_->mouse_dy = state.mouse_dy;
+        for (int i = 0; i < 3; ++i)
+            p_->buttons[i] = state.buttons[i];
+    }
+
+    void platform_window::hold_input(bool held) noexcept
+    {
+        if (p_) p_->input_held = held;
+    }
 }
@@ -0,0 +1,467 @@
+#include "optimized/raster_kernels.h"
+#include "optimized/optimized_renderer.h"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+#ifdef USE_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+static inline std::uint32_t modulate_texture(std::uint32_t tex_rgba, float intensity) noexcept
+{
+    const float r_f = (float)((tex_rgba >>  0) & 0xFFu) * intensity;
+    const float g_f = (float)((tex_rgba >>  8) & 0xFFu) * intensity;
+    const float b_f = (float)((tex_rgba >> 16) & 0xFFu) * intensity;
+
+    const std::uint8_t r = (std::uint8_t)(std::min)(r_f, 255.f);
+    const std::uint8_t g = (std::uint8_t)(std::min)(g_f, 255.f);
+    const std::uint8_t b = (std::uint8_t)(std::min)(b_f, 255.f);
+
+    return (255u << 24) | (std::uint32_t(b) << 16) | (std::uint32_t(g) << 8) | std::uint32_t(r);
+}
+
+// Level for the footprint of one pixel at texture coordinate (uu, vv), a textured triangle's
+// screen derivative of u = uow / invw being (d_uow - u * d_invw) / invw
+static inline std::uint32_t footprint_level(const setup_tri& st, const TextureRef& tex, float uu, float vv, float rcp_invw) noexcept
+{
+    const float tex_wf = (float)tex.tex_w;
+    const float tex_hf = (float)tex.tex_h;
+    const float dudx = (st.d_uow_dx - uu * st.d_invw_dx) * rcp_invw * tex_wf;
+    const float dvdx = (st.d_vow_dx - vv * st.d_invw_dx) * rcp_invw * tex_hf;
+    const float dudy = (st.d_uow_dy - uu * st.d_invw_dy) * rcp_invw * tex_wf;
+    const float dvdy = (st.d_vow_dy - vv * st.d_invw_dy) * rcp_invw * tex_hf;
+    return tex.mip_for_footprint((std::max)(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy));
+}
+
+// Perspective divide, mip selection, sample and light for one pixel of a textured triangle
+template<raster_state kState>
+static inline std::uint32_t shade_textured(const setup_tri& st, const TextureRef& tex, float invw, float uow, float vow) noexcept
+{
+    const float rcp_invw = (invw > 0.0001f) ? (1.f / invw) : 1.f;
+    const float uu = uow * rcp_invw;
+    const float vv = vow * rcp_invw;
+
+    std::uint32_t level = 0;
+    if constexpr (kState.mipped)
+        level = footprint_level(st, tex, uu, vv, rcp_invw);
+
+    return modulate_texture(tex.sample_nearest_as<kState.pow2, kState.bc1>(uu, vv, level), st.intensity);
+}
+
+// Depth plane access, one policy per depth_format
+struct depth_f32
+{
+    using value_type = float;
+    static value_type* plane(const ZBufferF32& zb) noexcept { return zb.data; }
+    static float load(const value_type* p) noexcept { return *p; }
+    static void store(value_type* p, float z) noexcept { *p = z; }
+    static float quantize(float z) noexcept { return z; }
+#ifdef USE_SIMD
+    static __m128 load4(const value_type* p) noexcept { return _mm_loadu_ps(p); }
+    static __m128 quantize4(__m128 z) noexcept { return z; }
+#endif
+};
+
+struct depth_u16
+{
+    using value_type = std::uint16_t;
+    static value_type* plane(const ZBufferF32& zb) noexcept { return zb.data16; }
+    static float load(const value_type* p) noexcept { return depth16_decode(*p); }
+    static void store(value_type* p, float z) noexcept { *p = depth16_encode(z); }
+    static float quantize(float z) noexcept { return depth16_decode(depth16_encode(z)); }
+#ifdef USE_SIMD
+    static __m128 load4(const value_type* p) noexcept
+    {
+        const __m128i q = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)p), _mm_setzero_si128());
+        return _mm_mul_ps(_mm_cvtepi32_ps(q), _mm_set1_ps(1.f / 65535.f));
+    }
+
+    // What load4 gives back once z is stored, same rounding as depth16_encode
+    static __m128 quantize4(__m128 z) noexcept
+    {
+        const __m128 zc = _mm_min_ps(_mm_max_ps(z, _mm_setzero_ps()), _mm_set1_ps(1.f));
+        const __m128i q = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(zc, _mm_set1_ps(65535.f)), _mm_set1_ps(0.5f)));
+        return _mm_mul_ps(_mm_cvtepi32_ps(q), _mm_set1_ps(1.f / 65535.f));
+    }
+#endif
+};
+
+// Depth test of one pixel. The equal pass keeps the pre-pass depth, every other pass stores z on a pass.
+template<raster_pass kPass, class Depth>
+static inline bool depth_test(typename Depth::value_type* p, float z) noexcept
+{
+    if constexpr (kPass == raster_pass::equal)
+    {
+        return Depth::quantize(z) == Depth::load(p);
+    }
+    else
+    {
+        if (!(z > Depth::load(p)))
+            return false;
+        Depth::store(p, z);
+        return true;
+    }
+}
+
+// kEdgeTest = false is for rects the block classifier proved fully covered. A textured state walks
+// its pixels one at a time and a flat one four at a time; the depth pass follows its state's walk
+// so it lands on the depth the equal pass recomputes bit for bit.
+template<bool kEdgeTest, raster_pass kPass, class Depth, raster_state kState>
+static raster_pixel_counts raster_rect_baseline_impl(const setup_tri& st, const FramebufferRGBA8& fb, const ZBufferF32& zb,
+                                      int minx, int miny, int maxx, int maxy) noexcept
+{
+    const std::uint32_t pitch_pixels = fb.pitch_pixels;
+
+    const float e0_a = st.e0_a, e0_b = st.e0_b;
+    const float e1_a = st.e1_a, e1_b = st.e1_b;
+    const float e2_a = st.e2_a, e2_b = st.e2_b;
+    const float inv_area = st.inv_area;
+    const float dzdx = st.dzdx;
+    const float dzdy = st.dzdy;
+    constexpr bool kIds      = kPass == raster_pass::ids;
+    constexpr bool kColour   = kPass != raster_pass::depth;
+    constexpr bool kTextured = kColour && !kIds && kState.textured;
+    constexpr bool kPerPixel = !kIds && kState.textured;
+
+    const float start_x = (float)minx + 0.5f;
+    const float start_y = (float)miny + 0.5f;
+
+    float w0_row = e0_a * start_x + e0_b * start_y + st.e0_c;
+    float w1_row = e1_a * start_x + e1_b * start_y + st.e1_c;
+    float w2_row = e2_a * start_x + e2_b * start_y + st.e2_c;
+
+    float z_row = (w0_row * st.z0 + w1_row * st.z1 + w2_row * st.z2) * inv_area;
+
+    float invw_row = 0.f;
+    float uow_row  = 0.f;
+    float vow_row  = 0.f;
+    if constexpr (kTextured)
+    {
+        invw_row = (w0_row * st.invw0 + w1_row * st.invw1 + w2_row * st.invw2) * inv_area;
+        uow_row  = (w0_row * st.uow0  + w1_row * st.uow1  + w2_row * st.uow2)  * inv_area;
+        vow_row  = (w0_row * st.vow0  + w1_row * st.vow1  + w2_row * st.vow2)  * inv_area;
+    }
+
+    const std::uint32_t flat_rgba = kIds ? st.id : st.flat_rgba;
+    raster_pixel_counts counts{};
+
+    for (int y = miny; y <= maxy; ++y)
+    {
+        typename Depth::value_type* zptr = Depth::plane(zb) + (std::size_t)y * (std::size_t)zb.pitch + (std::size_t)minx;
+        std::uint32_t* cptr = fb.data + (std::size_t)y * (std::size_t)pitch_pixels + (std::size_t)minx;
+
+        float w0 = w0_row;
+        float w1 = w1_row;
+        float w2 = w2_row;
+        float z  = z_row;
+
+        float invw_px = invw_row;
+        float uow_px  = uow_row;
+        float vow_px  = vow_row;
+
+        if constexpr (!kPerPixel)
+        {
+            // no texture flat color per triangle
+#ifdef USE_SIMD
+            const __m128 step   = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+            const __m128 e0a_v  = _mm_set1_ps(e0_a);
+            const __m128 e1a_v  = _mm_set1_ps(e1_a);
+            const __m128 e2a_v  = _mm_set1_ps(e2_a);
+            const __m128 dzdx_v = _mm_set1_ps(dzdx);
+
+            int x = minx;
+            for (; x <= maxx - 3; x += 4)
+            {
+                __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                if constexpr (kEdgeTest)
+                {
+                    const __m128 w0v = _mm_add_ps(_mm_set1_ps(w0), _mm_mul_ps(e0a_v, step));
+                    const __m128 w1v = _mm_add_ps(_mm_set1_ps(w1), _mm_mul_ps(e1a_v, step));
+                    const __m128 w2v = _mm_add_ps(_mm_set1_ps(w2), _mm_mul_ps(e2a_v, step));
+
+                    inside = _mm_and_ps(_mm_cmpge_ps(w0v, _mm_setzero_ps()),
+                                        _mm_and_ps(_mm_cmpge_ps(w1v, _mm_setzero_ps()),
+                                                   _mm_cmpge_ps(w2v, _mm_setzero_ps())));
+                }
+
+                const int inside_mask = _mm_movemask_ps(inside);
+                if (inside_mask)
+                {
+                    counts.tested += (std::uint32_t)std::popcount((unsigned)inside_mask);
+                    __m128 zv   = _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(dzdx_v, step));
+                    __m128 zbuf = Depth::load4(zptr);
+
+                    __m128 zpass = (kPass == raster_pass::equal) ? _mm_cmpeq_ps(Depth::quantize4(zv), zbuf) : _mm_cmpgt_ps(zv, zbuf);
+                    __m128 final_mask = _mm_and_ps(inside, zpass);
+
+                    const int write_mask = _mm_movemask_ps(final_mask);
+                    if (write_mask)
+                    {
+                        counts.passed += (std::uint32_t)std::popcount((unsigned)write_mask);
+                        alignas(16) float zvals[4];
+                        _mm_store_ps(zvals, zv);
+
+                        for (int lane = 0; lane < 4; ++lane)
+                        {
+                            if (write_mask & (1 << lane))
+                            {
+                                if constexpr (kPass != raster_pass::equal)
+                                    Depth::store(zptr + lane, zvals[lane]);
+                                if constexpr (kColour)
+                                    cptr[lane] = flat_rgba;
+                            }
+                        }
+                    }
+                }
+
+                w0 += e0_a * 4.f;
+                w1 += e1_a * 4.f;
+                w2 += e2_a * 4.f;
+                z  += dzdx * 4.f;
+                cptr += 4;
+                zptr += 4;
+            }
+
+            for (; x <= maxx; ++x)
+#else
+            for (int x = minx; x <= maxx; ++x)
+#endif
+            {
+                if (!kEdgeTest || (w0 >= 0.f && w1 >= 0.f && w2 >= 0.f))
+                {
+                    ++counts.tested;
+                    if (depth_test<kPass, Depth>(zptr, z))
+                    {
+                        ++counts.passed;
+                        if constexpr (kColour)
+                            *cptr = flat_rgba;
+                    }
+                }
+
+                w0 += e0_a;
+                w1 += e1_a;
+                w2 += e2_a;
+                z  += dzdx;
+                ++cptr;
+                ++zptr;
+            }
+        }
+        else
+        {
+            // Textured path per pixel perspective correct UV sampling, depth alone for the pre-pass
+            for (int x = minx; x <= maxx; ++x)
+            {
+                if (!kEdgeTest || (w0 >= 0.f && w1 >= 0.f && w2 >= 0.f))
+                {
+                    ++counts.tested;
+                    if (depth_test<kPass, Depth>(zptr, z))
+                    {
+                        ++counts.passed;
+                        if constexpr (kTextured)
+                            *cptr = shade_textured<kState>(st, *st.tex, invw_px, uow_px, vow_px);
+                    }
+                }
+
+                w0 += e0_a;
+                w1 += e1_a;
+                w2 += e2_a;
+                z  += dzdx;
+                if constexpr (kTextured)
+                {
+                    invw_px += st.d_invw_dx;
+                    uow_px  += st.d_uow_dx;
+                    vow_px  += st.d_vow_dx;
+                }
+                ++cptr;
+                ++zptr;
+            }
+        }
+
+        w0_row += e0_b;
+        w1_row += e1_b;
+        w2_row += e2_b;
+        z_row  += dzdy;
+
+        if constexpr (kTextured)
+        {
+            invw_row += st.d_invw_dy;
+            uow_row  += st.d_uow_dy;
+            vow_row  += st.d_vow_dy;
+        }
+    }
+
+    return counts;
+}
+
+template<class Depth, std::uint32_t... kIndex>
+static void fill_baseline_states(raster_kernel_set& set, std::integer_sequence<std::uint32_t, kIndex...>) noexcept
+{
+    ((set.partial[kIndex] = &raster_rect_baseline_impl<true,  raster_pass::shade, Depth, raster_state::from_index(kIndex)>), ...);
+    ((set.covered[kIndex] = &raster_rect_baseline_impl<false, raster_pass::shade, Depth, raster_state::from_index(kIndex)>), ...);
+    set.ids_partial = &raster_rect_baseline_impl<true,  raster_pass::ids, Depth, raster_state{}>;
+    set.ids_covered = &raster_rect_baseline_impl<false, raster_pass::ids, Depth, raster_state{}>;
+    // Only the textured bit changes how the depth pass walks, so two kernels serve every state
+    ((set.depth_partial[kIndex] = &raster_rect_baseline_impl<true,  raster_pass::depth, Depth, raster_state::from_index(kIndex & 1u)>), ...);
+    ((set.depth_covered[kIndex] = &raster_rect_baseline_impl<false, raster_pass::depth, Depth, raster_state::from_index(kIndex & 1u)>), ...);
+    ((set.equal_partial[kIndex] = &raster_rect_baseline_impl<true,  raster_pass::equal, Depth, raster_state::from_index(kIndex)>), ...);
+    ((set.equal_covered[kIndex] = &raster_rect_baseline_impl<false, raster_pass::equal, Depth, raster_state::from_index(kIndex)>), ...);
+}
+
+void fill_raster_kernels_baseline(raster_kernel_set& set, depth_format depth) noexcept
+{
+    if (depth == depth_format::unorm16)
+        fill_baseline_states<depth_u16>(set, std::make_integer_sequence<std::uint32_t, kRasterStates>{});
+    else
+        fill_baseline_states<depth_f32>(set, std::make_integer_sequence<std::uint32_t, kRasterStates>{});
+}
+
+// Scalar on purpose: the counts drive a debug view, and keeping it apart leaves the hot kernels alone
+template<bool kEdgeTest, class Depth>
+static raster_pixel_counts raster_overdraw_impl(const setup_tri& st, const FramebufferRGBA8& fb, const ZBufferF32& zb,
+                                                int minx, int miny, int maxx, int maxy) noexcept
+{
+    const float start_x = (float)minx + 0.5f;
+    const float start_y = (float)miny + 0.5f;
+
+    float w0_row = st.e0_a * start_x + st.e0_b * start_y + st.e0_c;
+    float w1_row = st.e1_a * start_x + st.e1_b * start_y + st.e1_c;
+    float w2_row = st.e2_a * start_x + st.e2_b * start_y + st.e2_c;
+    float z_row  = (w0_row * st.z0 + w1_row * st.z1 + w2_row * st.z2) * st.inv_area;
+
+    raster_pixel_counts counts{};
+    for (int y = miny; y <= maxy; ++y)
+    {
+        typename Depth::value_type* zptr = Depth::plane(zb) + (std::size_t)y * (std::size_t)zb.pitch + (std::size_t)minx;
+        std::uint32_t* cptr = fb.data + (std::size_t)y * (std::size_t)fb.pitch_pixels + (std::size_t)minx;
+
+        float w0 = w0_row, w1 = w1_row, w2 = w2_row, z = z_row;
+        for (int x = minx; x <= maxx; ++x, ++cptr, ++zptr)
+        {
+            if (!kEdgeTest || (w0 >= 0.f && w1 >= 0.f && w2 >= 0.f))
+            {
+                ++counts.tested;
+                ++*cptr;
+                if (z > Depth::load(zptr))
+                {
+                    ++counts.passed;
+                    Depth::store(zptr, z);
+                }
+            }
+
+            w0 += st.e0_a;
+            w1 += st.e1_a;
+            w2 += st.e2_a;
+            z  += st.dzdx;
+        }
+
+        w0_row += st.e0_b;
+        w1_row += st.e1_b;
+        w2_row += st.e2_b;
+        z_row  += st.dzdy;
+    }
+    return counts;
+}
+
+raster_pixel_counts raster_rect_overdraw(const setup_tri& st, const FramebufferRGBA8& fb, const ZBufferF32& zb,
+                          int minx, int miny, int maxx, int maxy) noexcept
+{
+    if (zb.format == depth_format::unorm16)
+        return raster_overdraw_impl<true, depth_u16>(st, fb, zb, minx, miny, maxx, maxy);
+    return raster_overdraw_impl<true, depth_f32>(st, fb, zb, minx, miny, maxx, maxy);
+}
+
+raster_pixel_counts raster_covered_overdraw(const setup_tri& st, const FramebufferRGBA8& fb, const ZBufferF32& zb,
+                             int minx, int miny, int maxx, int maxy) noexcept
+{
+    if (zb.format == depth_format::unorm16)
+        return raster_overdraw_impl<false, depth_u16>(st, fb, zb, minx, miny, maxx, maxy);
+    return raster_overdraw_impl<false, depth_f32>(st, fb, zb, minx, miny, maxx, maxy);
+}
+
+std::uint32_t shade_setup_pixel(const setup_tri& st, float px, float py) noexcept
+{
+    if (!st.tex) return st.flat_rgba;
+
+    const float w0 = st.e0_a * px + st.e0_b * py + st.e0_c;
+    const float w1 = st.e1_a * px + st.e1_b * py + st.e1_c;
+    const float w2 = st.e2_a * px + st.e2_b * py + st.e2_c;
+
+    const float invw = (w0 * st.invw0 + w1 * st.invw1 + w2 * st.invw2) * st.inv_area;
+    const float uow  = (w0 * st.uow0  + w1 * st.uow1  + w2 * st.uow2)  * st.inv_area;
+    const float vow  = (w0 * st.vow0  + w1 * st.vow1  + w2 * st.vow2)  * st.inv_area;
+
+    // One pixel per call, so the texture's layout is not worth a permutation here
+    const TextureRef& tex = *st.tex;
+    const float rcp_invw = (invw > 0.0001f) ? (1.f / invw) : 1.f;
+    const float uu = uow * rcp_invw;
+    const float vv = vow * rcp_invw;
+    return modulate_texture(tex.sample_nearest(uu, vv, footprint_level(st, tex, uu, vv, rcp_invw)), st.intensity);
+}
+
+raster_state raster_state_for(const TextureRef* tex) noexcept
+{
+    if (!tex) return {};
+    return { true, tex->mip_count > 1, tex->pow2, tex->format == texture_format::bc1 };
+}
+
+raster_isa detect_raster_isa() noexcept
+{
+#ifdef USE_SIMD
+#ifdef _MSC_VER
+    int regs[4]{};
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return raster_isa::baseline;
+
+    // AVX needs OSXSAVE plus the OS saving YMM state, AVX2 and FMA come from leaf 7 / leaf 1
+    __cpuid(regs, 1);
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx     = (regs[2] & (1 << 28)) != 0;
+    const bool fma     = (regs[2] & (1 << 12)) != 0;
+    if (!osxsave || !avx || !fma) return raster_isa::baseline;
+    if ((_xgetbv(0) & 0x6) != 0x6) return raster_isa::baseline;
+
+    __cpuidex(regs, 7, 0);
+    const bool avx2 = (regs[1] & (1 << 5)) != 0;
+    return avx2 ? raster_isa::avx2 : raster_isa::baseline;
+#else
+    __builtin_cpu_init();
+    return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? raster_isa::avx2 : raster_isa::baseline;
+#endif
+#else
+    return raster_isa::baseline;
+#endif
+}
+
+raster_kernel_set raster_kernels_for(raster_isa isa, depth_format depth) noexcept
+{
+    raster_kernel_set set{};
+#ifdef USE_SIMD
+    if (isa == raster_isa::avx2)
+    {
+        fill_raster_kernels_avx2(set, depth);
+        return set;
+    }
+#endif
+    (void)isa;
+    fill_raster_kernels_baseline(set, depth);
+    return set;
+}
+
+const char* raster_isa_name(raster_isa isa) noexcept
+{
+    switch (isa)
+    {
+    case raster_isa::avx2: return "AVX2";
+    default: break;
+    }
+#ifdef USE_SIMD
+    return "SSE";
+#else
+    return "Scalar";
+#endif
+}
@@ -0,0 +1,383 @@
+#include "optimized/raster_kernels.h"
+#include "optimized/optimized_renderer.h"
+
+// Built with AVX2 code generation regardless of FOX_SIMD_LEVEL, only reached when CPUID reports AVX2
+#ifdef USE_SIMD
+#include <bit>
+#include <immintrin.h>
+#include <utility>
+
+// Depth plane access for 8 lanes, one policy per depth_format. Loads may only touch the first
+// `count` pixels and stores only the lanes in `pass`, the rest belong to neighbouring rects.
+struct depth_f32_avx2
+{
+    using value_type = float;
+    static value_type* plane(const ZBufferF32& zb) noexcept { return zb.data; }
+
+    static __m256 load8(const value_type* p, __m256i in_range, int) noexcept
+    {
+        return _mm256_maskload_ps(p, in_range);
+    }
+
+    static void store8(value_type* p, __m256 z, __m256i pass, int) noexcept
+    {
+        _mm256_maskstore_ps(p, pass, z);
+    }
+
+    static __m256 quantize8(__m256 z) noexcept { return z; }
+};
+
+struct depth_u16_avx2
+{
+    using value_type = std::uint16_t;
+    static value_type* plane(const ZBufferF32& zb) noexcept { return zb.data16; }
+
+    static __m256 load8(const value_type* p, __m256i, int count) noexcept
+    {
+        __m128i q;
+        if (count >= 8)
+        {
+            q = _mm_loadu_si128((const __m128i*)p);
+        }
+        else
+        {
+            alignas(16) std::uint16_t tmp[8]{};
+            for (int i = 0; i < count; ++i) tmp[i] = p[i];
+            q = _mm_load_si128((const __m128i*)tmp);
+        }
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(q)), _mm256_set1_ps(1.f / 65535.f));
+    }
+
+    // Same rounding as depth16_encode
+    static __m256i encode8(__m256 z) noexcept
+    {
+        const __m256 zc = _mm256_min_ps(_mm256_max_ps(z, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+        return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(zc, _mm256_set1_ps(65535.f)), _mm256_set1_ps(0.5f)));
+    }
+
+    // What load8 gives back once z is stored
+    static __m256 quantize8(__m256 z) noexcept
+    {
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(encode8(z)), _mm256_set1_ps(1.f / 65535.f));
+    }
+
+    static void store8(value_type* p, __m256 z, __m256i, int pass_bits) noexcept
+    {
+        const __m256i q32 = encode8(z);
+        const __m128i q = _mm_packus_epi32(_mm256_castsi256_si128(q32), _mm256_extracti128_si256(q32, 1));
+        if (pass_bits == 0xFF)
+        {
+            _mm_storeu_si128((__m128i*)p, q);
+            return;
+        }
+
+        alignas(16) std::uint16_t tmp[8];
+        _mm_store_si128((__m128i*)tmp, q);
+        for (int i = 0; i < 8; ++i)
+        {
+            if (pass_bits & (1 << i))
+                p[i] = tmp[i];
+        }
+    }
+};
+
+// Eight texels of bc1 tiles as bc1_decode_texel gives them: each palette entry is
+// (c0 * w + c1 * (3 - w)) / 3 with w = 3, 0, 2, 1 for indices 0..3, the divide a multiply by 21846
+// and shift that is exact over this range, so all four entries take the same path
+static inline __m256i bc1_decode8(__m256i ends, __m256i bits, __m256i in_tile) noexcept
+{
+    const __m256i sel = _mm256_and_si256(_mm256_srlv_epi32(bits, _mm256_slli_epi32(in_tile, 1)), _mm256_set1_epi32(3));
+    const __m256i w0  = _mm256_permutevar8x32_epi32(_mm256_setr_epi32(3, 0, 2, 1, 3, 0, 2, 1), sel);
+    const __m256i w1  = _mm256_sub_epi32(_mm256_set1_epi32(3), w0);
+    const __m256i c0  = _mm256_and_si256(ends, _mm256_set1_epi32(0xFFFF));
+    const __m256i c1  = _mm256_srli_epi32(ends, 16);
+    const __m256i third = _mm256_set1_epi32(21846);
+
+    // One channel of both endpoints, widened from `width` bits by repeating its top bits
+    const auto channel = [&](int shift, int width) noexcept
+    {
+        const __m256i mask = _mm256_set1_epi32((1 << width) - 1);
+        const __m256i a = _mm256_and_si256(_mm256_srli_epi32(c0, shift), mask);
+        const __m256i b = _mm256_and_si256(_mm256_srli_epi32(c1, shift), mask);
+        const __m128i up = _mm_cvtsi32_si128(8 - width);
+        const __m128i down = _mm_cvtsi32_si128(2 * width - 8);
+        const __m256i a8 = _mm256_or_si256(_mm256_sll_epi32(a, up), _mm256_srl_epi32(a, down));
+        const __m256i b8 = _mm256_or_si256(_mm256_sll_epi32(b, up), _mm256_srl_epi32(b, down));
+        const __m256i sum = _mm256_add_epi32(_mm256_mullo_epi32(a8, w0), _mm256_mullo_epi32(b8, w1));
+        return _mm256_srli_epi32(_mm256_mullo_epi32(sum, third), 16);
+    };
+
+    __m256i rgba = _mm256_set1_epi32((int)0xFF000000u);
+    rgba = _mm256_or_si256(rgba, channel(11, 5));
+    rgba = _mm256_or_si256(rgba, _mm256_slli_epi32(channel(5, 6), 8));
+    rgba = _mm256_or_si256(rgba, _mm256_slli_epi32(channel(0, 5), 16));
+    return rgba;
+}
+
+// Every pass walks depth the same way, so the depth pre-pass needs no state of its own here
+template<bool kEdgeTest, raster_pass kPass, class Depth, raster_state kState>
+static raster_pixel_counts raster_rect_avx2_impl(const setup_tri& st, const FramebufferRGBA8& fb, const ZBufferF32& zb,
+                                  int minx, int miny, int maxx, int maxy) noexcept
+{
+    const float inv_area = st.inv_area;
+    constexpr bool kIds      = kPass == raster_pass::ids;
+    constexpr bool kColour   = kPass != raster_pass::depth;
+    constexpr bool kTextured = kColour && !kIds && kState.textured;
+
+    const float start_x = (float)minx + 0.5f;
+    const float start_y = (float)miny + 0.5f;
+
+    float w0_row = st.e0_a * start_x + st.e0_b * start_y + st.e0_c;
+    float w1_row = st.e1_a * start_x + st.e1_b * start_y + st.e1_c;
+    float w2_row = st.e2_a * start_x + st.e2_b * start_y + st.e2_c;
+    float z_row  = (w0_row * st.z0 + w1_row * st.z1 + w2_row * st.z2) * inv_area;
+
+    float invw_row = 0.f;
+    float uow_row  = 0.f;
+    float vow_row  = 0.f;
+    if constexpr (kTextured)
+    {
+        invw_row = (w0_row * st.invw0 + w1_row * st.invw1 + w2_row * st.invw2) * inv_area;
+        uow_row  = (w0_row * st.uow0  + w1_row * st.uow1  + w2_row * st.uow2)  * inv_area;
+        vow_row  = (w0_row * st.vow0  + w1_row * st.vow1  + w2_row * st.vow2)  * inv_area;
+    }
+
+    const __m256  step     = _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+    const __m256i lane_idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256  zero     = _mm256_setzero_ps();
+
+    // Per lane offsets and the 8 pixel stride of every interpolant
+    const __m256 e0_lane = _mm256_mul_ps(_mm256_set1_ps(st.e0_a), step);
+    const __m256 e1_lane = _mm256_mul_ps(_mm256_set1_ps(st.e1_a), step);
+    const __m256 e2_lane = _mm256_mul_ps(_mm256_set1_ps(st.e2_a), step);
+    const __m256 z_lane  = _mm256_mul_ps(_mm256_set1_ps(st.dzdx), step);
+    const __m256 e0_8 = _mm256_set1_ps(st.e0_a * 8.f);
+    const __m256 e1_8 = _mm256_set1_ps(st.e1_a * 8.f);
+    const __m256 e2_8 = _mm256_set1_ps(st.e2_a * 8.f);
+    const __m256 z_8  = _mm256_set1_ps(st.dzdx * 8.f);
+
+    const __m256 invw_lane = _mm256_mul_ps(_mm256_set1_ps(st.d_invw_dx), step);
+    const __m256 uow_lane  = _mm256_mul_ps(_mm256_set1_ps(st.d_uow_dx), step);
+    const __m256 vow_lane  = _mm256_mul_ps(_mm256_set1_ps(st.d_vow_dx), step);
+    const __m256 invw_8 = _mm256_set1_ps(st.d_invw_dx * 8.f);
+    const __m256 uow_8  = _mm256_set1_ps(st.d_uow_dx * 8.f);
+    const __m256 vow_8  = _mm256_set1_ps(st.d_vow_dx * 8.f);
+
+    const __m256i flat_rgba = _mm256_set1_epi32((int)(kIds ? st.id : st.flat_rgba));
+
+    const int* texels = nullptr;
+    const int* mip_offsets = nullptr;
+    __m256  tex_w0f{}, tex_h0f{};
+    __m256i tex_w0{}, tex_h0{}, max_level{}, log2_w0{};
+    if constexpr (kTextured)
+    {
+        const TextureRef& tex = *st.tex;
+        texels      = (const int*)tex.pixels;
+        mip_offsets = (const int*)tex.mip_offsets;
+        log2_w0     = _mm256_set1_epi32((int)tex.log2_w);
+        tex_w0f   = _mm256_set1_ps((float)tex.tex_w);
+        tex_h0f   = _mm256_set1_ps((float)tex.tex_h);
+        tex_w0    = _mm256_set1_epi32((int)tex.tex_w);
+        tex_h0    = _mm256_set1_epi32((int)tex.tex_h);
+        max_level = _mm256_set1_epi32((int)tex.mip_count - 1);
+    }
+    const __m256i one_i = _mm256_set1_epi32(1);
+    const __m256i three_i = _mm256_set1_epi32(3);
+    const __m256  d_invw_dx = _mm256_set1_ps(st.d_invw_dx);
+    const __m256  d_invw_dy = _mm256_set1_ps(st.d_invw_dy);
+    const __m256  d_uow_dx  = _mm256_set1_ps(st.d_uow_dx);
+    const __m256  d_uow_dy  = _mm256_set1_ps(st.d_uow_dy);
+    const __m256  d_vow_dx  = _mm256_set1_ps(st.d_vow_dx);
+    const __m256  d_vow_dy  = _mm256_set1_ps(st.d_vow_dy);
+    const __m256  intensity = _mm256_set1_ps(st.intensity);
+    const __m256  max_channel = _mm256_set1_ps(255.f);
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+    raster_pixel_counts counts{};
+
+    for (int y = miny; y <= maxy; ++y)
+    {
+        typename Depth::value_type* zrow = Depth::plane(zb) + (std::size_t)y * (std::size_t)zb.pitch;
+        std::uint32_t* crow = fb.data + (std::size_t)y * (std::size_t)fb.pitch_pixels;
+
+        __m256 w0 = _mm256_add_ps(_mm256_set1_ps(w0_row), e0_lane);
+        __m256 w1 = _mm256_add_ps(_mm256_set1_ps(w1_row), e1_lane);
+        __m256 w2 = _mm256_add_ps(_mm256_set1_ps(w2_row), e2_lane);
+        __m256 z  = _mm256_add_ps(_mm256_set1_ps(z_row), z_lane);
+
+        __m256 invw = _mm256_add_ps(_mm256_set1_ps(invw_row), invw_lane);
+        __m256 uow  = _mm256_add_ps(_mm256_set1_ps(uow_row), uow_lane);
+        __m256 vow  = _mm256_add_ps(_mm256_set1_ps(vow_row), vow_lane);
+
+        for (int x = minx; x <= maxx; x += 8)
+        {
+            // Lanes past maxx are masked off, so loads and stores never leave the rect
+            const __m256i in_range = _mm256_cmpgt_epi32(_mm256_set1_epi32(maxx - x + 1), lane_idx);
+
+            __m256 inside = _mm256_castsi256_ps(in_range);
+            if constexpr (kEdgeTest)
+            {
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(w0, zero, _CMP_GE_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(w1, zero, _CMP_GE_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(w2, zero, _CMP_GE_OQ));
+            }
+
+            const int inside_bits = _mm256_movemask_ps(inside);
+            if (inside_bits)
+            {
+                counts.tested += (std::uint32_t)std::popcount((unsigned)inside_bits);
+                const __m256 zbuf = Depth::load8(zrow + x, _mm256_castps_si256(inside), maxx - x + 1);
+                const __m256 zpass = (kPass == raster_pass::equal) ? _mm256_cmp_ps(Depth::quantize8(z), zbuf, _CMP_EQ_OQ)
+                                                                   : _mm256_cmp_ps(z, zbuf, _CMP_GT_OQ);
+                const __m256 pass = _mm256_and_ps(inside, zpass);
+
+                const int pass_bits = _mm256_movemask_ps(pass);
+                if (pass_bits)
+                {
+                    counts.passed += (std::uint32_t)std::popcount((unsigned)pass_bits);
+                    const __m256i pass_i = _mm256_castps_si256(pass);
+                    if constexpr (kPass != raster_pass::equal)
+                        Depth::store8(zrow + x, z, pass_i, pass_bits);
+                    if constexpr (kColour)
+                    {
+                        __m256i rgba = flat_rgba;
+                        if constexpr (kTextured)
+                        {
+                            const __m256 rcp = _mm256_blendv_ps(_mm256_set1_ps(1.f),
+                                                                _mm256_div_ps(_mm256_set1_ps(1.f), invw),
+                                                                _mm256_cmp_ps(invw, _mm256_set1_ps(0.0001f), _CMP_GT_OQ));
+                            __m256 u = _mm256_mul_ps(uow, rcp);
+                            __m256 v = _mm256_mul_ps(vow, rcp);
+
+                            // Per lane level from the screen derivatives, as TextureRef::mip_for_footprint
+                            __m256i level = _mm256_setzero_si256();
+                            __m256i base  = _mm256_setzero_si256();
+                            __m256i lw = tex_w0, lh = tex_h0;
+                            if constexpr (kState.mipped)
+                            {
+                                const __m256 dudx = _mm256_mul_ps(_mm256_mul_ps(_mm256_fnmadd_ps(u, d_invw_dx, d_uow_dx), rcp), tex_w0f);
+                                const __m256 dvdx = _mm256_mul_ps(_mm256_mul_ps(_mm256_fnmadd_ps(v, d_invw_dx, d_vow_dx), rcp), tex_h0f);
+                                const __m256 dudy = _mm256_mul_ps(_mm256_mul_ps(_mm256_fnmadd_ps(u, d_invw_dy, d_uow_dy), rcp), tex_w0f);
+                                const __m256 dvdy = _mm256_mul_ps(_mm256_mul_ps(_mm256_fnmadd_ps(v, d_invw_dy, d_vow_dy), rcp), tex_h0f);
+                                const __m256 rho2 = _mm256_max_ps(_mm256_fmadd_ps(dudx, dudx, _mm256_mul_ps(dvdx, dvdx)),
+                                                                  _mm256_fmadd_ps(dudy, dudy, _mm256_mul_ps(dvdy, dvdy)));
+
+                                // floor(log2(rho2)) from the exponent bits, halved; rho2 <= 1 and NaN land on level 0
+                                const __m256i exponent = _mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(rho2), 23), _mm256_set1_epi32(127));
+                                level = _mm256_srai_epi32(exponent, 1);
+                                level = _mm256_and_si256(level, _mm256_castps_si256(_mm256_cmp_ps(rho2, _mm256_set1_ps(1.f), _CMP_GT_OQ)));
+                                level = _mm256_min_epi32(_mm256_max_epi32(level, _mm256_setzero_si256()), max_level);
+
+                                base = _mm256_i32gather_epi32(mip_offsets, level, 4);
+                                lw = _mm256_max_epi32(_mm256_srlv_epi32(tex_w0, level), one_i);
+                                lh = _mm256_max_epi32(_mm256_srlv_epi32(tex_h0, level), one_i);
+                            }
+
+                            __m256i tx, ty, tile;
+                            if constexpr (kState.pow2)
+                            {
+                                // Mask and shift, matching the pow2 branch of TextureRef::sample_nearest
+                                tx = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(u, _mm256_cvtepi32_ps(lw)))), _mm256_sub_epi32(lw, one_i));
+                                ty = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(v, _mm256_cvtepi32_ps(lh)))), _mm256_sub_epi32(lh, one_i));
+
+                                const __m256i lw_log2 = _mm256_max_epi32(_mm256_sub_epi32(log2_w0, level), _mm256_setzero_si256());
+                                const __m256i row_shift = _mm256_max_epi32(_mm256_sub_epi32(lw_log2, _mm256_set1_epi32(2)), _mm256_setzero_si256());
+                                tile = _mm256_add_epi32(_mm256_sllv_epi32(_mm256_srli_epi32(ty, 2), row_shift), _mm256_srli_epi32(tx, 2));
+                            }
+                            else
+                            {
+                                u = _mm256_sub_ps(u, _mm256_floor_ps(u));
+                                v = _mm256_sub_ps(v, _mm256_floor_ps(v));
+
+                                // Same wrap as TextureRef::sample_nearest, u * w can round up to w
+                                tx = _mm256_cvttps_epi32(_mm256_mul_ps(u, _mm256_cvtepi32_ps(lw)));
+                                ty = _mm256_cvttps_epi32(_mm256_mul_ps(v, _mm256_cvtepi32_ps(lh)));
+                                tx = _mm256_sub_epi32(tx, _mm256_andnot_si256(_mm256_cmpgt_epi32(lw, tx), lw));
+                                ty = _mm256_sub_epi32(ty, _mm256_andnot_si256(_mm256_cmpgt_epi32(lh, ty), lh));
+
+                                const __m256i tiles_x = _mm256_srli_epi32(_mm256_add_epi32(lw, three_i), 2);
+                                tile = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(ty, 2), tiles_x), _mm256_srli_epi32(tx, 2));
+                            }
+
+                            const __m256i in_tile = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(ty, three_i), 2), _mm256_and_si256(tx, three_i));
+                            const __m256i idx = _mm256_add_epi32(base, _mm256_add_epi32(_mm256_slli_epi32(tile, 4), in_tile));
+                            __m256i texel;
+                            if constexpr (kState.bc1)
+                            {
+                                // Both words of each lane's tile share its cache line; the index picks the palette entry
+                                const __m256i word = _mm256_slli_epi32(_mm256_srli_epi32(idx, 4), 1);
+                                const __m256i ends = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), texels, word, pass_i, 4);
+                                const __m256i bits = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), texels + 1, word, pass_i, 4);
+                                texel = bc1_decode8(ends, bits, _mm256_and_si256(idx, _mm256_set1_epi32(15)));
+                            }
+                            else
+                            {
+                                texel = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), texels, idx, pass_i, 4);
+                            }
+
+                            const __m256 r = _mm256_min_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(texel, byte_mask)), intensity), max_channel);
+                            const __m256 g = _mm256_min_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texel, 8), byte_mask)), intensity), max_channel);
+                            const __m256 b = _mm256_min_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texel, 16), byte_mask)), intensity), max_channel);
+
+                            rgba = _mm256_or_si256(alpha, _mm256_cvttps_epi32(r));
+                            rgba = _mm256_or_si256(rgba, _mm256_slli_epi32(_mm256_cvttps_epi32(g), 8));
+                            rgba = _mm256_or_si256(rgba, _mm256_slli_epi32(_mm256_cvttps_epi32(b), 16));
+                        }
+
+                        _mm256_maskstore_epi32((int*)(crow + x), pass_i, rgba);
+                    }
+                }
+            }
+
+            if constexpr (kEdgeTest)
+            {
+                w0 = _mm256_add_ps(w0, e0_8);
+                w1 = _mm256_add_ps(w1, e1_8);
+                w2 = _mm256_add_ps(w2, e2_8);
+            }
+            z  = _mm256_add_ps(z, z_8);
+            if constexpr (kTextured)
+            {
+                invw = _mm256_add_ps(invw, invw_8);
+                uow  = _mm256_add_ps(uow, uow_8);
+                vow  = _mm256_add_ps(vow, vow_8);
+            }
+        }
+
+        w0_row += st.e0_b;
+        w1_row += st.e1_b;
+        w2_row += st.e2_b;
+        z_row  += st.dzdy;
+
+        if constexpr (kTextured)
+        {
+            invw_row += st.d_invw_dy;
+            uow_row  += st.d_uow_dy;
+            vow_row  += st.d_vow_dy;
+        }
+    }
+
+    return counts;
+}
+
+template<class Depth, std::uint32_t... kIndex>
+static void fill_avx2_states(raster_kernel_set& set, std::integer_sequence<std::uint32_t, kIndex...>) noexcept
+{
+    ((set.partial[kIndex] = &raster_rect_avx2_impl<true,  raster_pass::shade, Depth, raster_state::from_index(kIndex)>), ...);
+    ((set.covered[kIndex] = &raster_rect_avx2_impl<false, raster_pass::shade, Depth, raster_state::from_index(kIndex)>), ...);
+    set.ids_partial = &raster_rect_avx2_impl<true,  raster_pass::ids, Depth, raster_state{}>;
+    set.ids_covered = &raster_rect_avx2_impl<false, raster_pass::ids, Depth, raster_state{}>;
+    ((set.depth_partial[kIndex] = &raster_rect_avx2_impl<true,  raster_pass::depth, Depth, raster_state{}>), ...);
+    ((set.depth_covered[kIndex] = &raster_rect_avx2_impl<false, raster_pass::depth, Depth, raster_state{}>), ...);
+    ((set.equal_partial[kIndex] = &raster_rect_avx2_impl<true,  raster_pass::equal, Depth, raster_state::from_index(kIndex)>), ...);
+    ((set.equal_covered[kIndex] = &raster_rect_avx2_impl<false, raster_pass::equal, Depth, raster_state::from_index(kIndex)>), ...);
+}
+
+void fill_raster_kernels_avx2(raster_kernel_set& set, depth_format depth) noexcept
+{
+    if (depth == depth_format::unorm16)
+        fill_avx2_states<depth_u16_avx2>(set, std::make_integer_sequence<std::uint32_t, kRasterStates>{});
+    else
+        fill_avx2_states<depth_f32_avx2>(set, std::make_integer_sequence<std::uint32_t, kRasterStates>{});
+}
+#endif
@@ -1,10 +1,80 @@
 #include "game/render_queue.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <filesystem>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <unordered_set>
 
 namespace fox
 {
+    namespace
+    {
+        constexpr float kFallbackPickRadius = 0.75f;
+        constexpr std::size_t kInlinePickRebuild = 512;
+        constexpr std::size_t kNoClip = (std::numeric_limits<std::size_t>::max)();
+
+        // Clip the object's animation instance plays, kNoClip when there is nothing to skin
+        std::size_t playing_clip(const editor_object_component& obj, const dynamic_mesh_component& dyn,
+                                 const animation_instance_component& inst) noexcept
+        {
+            if (!obj.is_dynamic || obj.object_id == 0 || obj.model.empty())
+                return kNoClip;
+            if (!obj.anim_enabled || !inst.instance)
+                return kNoClip;
+
+            const dynamic_mesh* mesh = dyn.mesh;
+            if (!mesh || !mesh->has_animation() || mesh->animation_count() == 0)
+                return kNoClip;
+            return (std::min)(obj.anim_index, mesh->animation_count() - 1);
+        }
+
+        double skin_time(const editor_object_component& obj) noexcept
+        {
+            return static_cast<double>((obj.anim_time + obj.time_offset) * obj.playback_speed);
+        }
+
+        // Skin times are snapped to this grid, which is how close two poses must be to be shared
+        constexpr double kPoseQuantumSeconds = 1.0 / 120.0;
+        // Bounding radius over eye distance from which an instance updates every quantum; each
+        // halving below it doubles the interval, up to kAnimMaxStep quanta
+        constexpr float kAnimFullRateSize = 0.08f;
+        constexpr std::uint32_t kAnimMaxStep = 8;
+
+        std::uint32_t anim_lod_step(const Transform& tr, const Bounds& b, const vec4& eye) noexcept
+        {
+            vec4 center = (b.local_min + b.local_max) * 0.5f;
+            center.w = 1.f;
+            vec4 half = (b.local_max - b.local_min) * 0.5f;
+            half.w = 0.f;
+
+            float scale = 0.f;
+            for (int c = 0; c < 3; ++c)
+                scale = (std::max)(scale, std::sqrt(tr.world(0, c) * tr.world(0, c) + tr.world(1, c) * tr.world(1, c) + tr.world(2, c) * tr.world(2, c)));
+
+            vec4 to_eye = tr.world * center - eye;
+            to_eye.w = 0.f;
+            const float dist = to_eye.length();
+            const float size = (dist > 0.f) ? half.length() * scale / dist : kAnimFullRateSize;
+
+            std::uint32_t step = 1;
+            while (step < kAnimMaxStep && size < kAnimFullRateSize / (float)step)
+                step *= 2;
+            return step;
+        }
+
+        // Steps are multiples of the LOD step, so a slower instance lands on the grid a faster one uses
+        std::int64_t pose_step(double t, std::uint32_t lod) noexcept
+        {
+            return (std::int64_t)std::floor(t / (kPoseQuantumSeconds * lod)) * (std::int64_t)lod;
+        }
+    }
+
     void render_queue::register_components(fecs::world& world)
     {
         world.register_component<animation_controller_component>();
@@ -14,9 +84,9 @@ namespace fox
         world.register_component<level_object_tag>();
         world.register_component<editor_tag>();
         world.register_component<editor_object_component>();
-        world.register_component<editor_local_component>();
         world.register_component<static_mesh_component>();
         world.register_component<dynamic_mesh_component>();
+        transform_hierarchy::register_components(world);
     }
 
     render_queue::render_queue(
@@ -31,6 +101,8 @@ namespace fox
         , tex_cache_(tex_cache)
         , normalize_size_(normalize_size)
     {
+        placeholder_asset_ = build_asset_from_indexed_mesh(Mesh::makeCube(1.f));
+        placeholder_bounds_ = compute_local_bounds(placeholder_asset_);
     }
 
     float render_queue::clamp_scale_min(float v) noexcept { return (v < 0.01f) ? 0.01f : v; }
@@ -67,17 +139,28 @@ namespace fox
         return t * r * s * c;
     }
 
+    static_mesh* render_queue::find_static_mesh(const std::string& path) const
+    {
+        const auto it = static_cache_.find(path);
+        return (it != static_cache_.end()) ? it->second.get() : nullptr;
+    }
+
+    dynamic_mesh* render_queue::find_dynamic_mesh(const std::string& path) const
+    {
+        const auto it = dynamic_cache_.find(path);
+        return (it != dynamic_cache_.end()) ? it->second.get() : nullptr;
+    }
+
     static_mesh* render_queue::get_static_mesh(const std::string& path)
     {
         if (path.empty())
             return nullptr;
 
-        const auto it = static_cache_.find(path);
-        if (it != static_cache_.end())
-            return it->second.get();
+        if (static_mesh* cached = find_static_mesh(path))
+            return cached;
 
         auto mesh = std::make_unique<static_mesh>();
-        if (!mesh->load(path.c_str(), tex_cache_))
+        if (!mesh->load(path.c_str(), tex_cache_, quantized_meshes_))
             return nullptr;
 
         static_mesh* ptr = mesh.get();
@@ -90,9 +173,8 @@ namespace fox
         if (path.empty())
             return nullptr;
 
-        const auto it = dynamic_cache_.find(path);
-        if (it != dynamic_cache_.end())
-            return it->second.get();
+        if (dynamic_mesh* cached = find_dynamic_mesh(path))
+            return cached;
 
         auto mesh = std::make_unique<dynamic_mesh>();
         if (!mesh->load(path.c_str(), tex_cache_))
@@ -103,6 +185,155 @@ namespace fox
         return ptr;
     }
 
+    bool render_queue::request_static_mesh(const std::string& path)
+    {
+        if (path.empty())
+            return false;
+        if (find_static_mesh(path) || pending_static_.count(path))
+            return true;
+
+        texture_cache* tex_cache = tex_cache_;
+        const bool quantize = quantized_meshes_;
+        pending_static_.emplace(path, streamer_.submit([path, tex_cache, quantize]()
+        {
+            auto mesh = std::make_unique<static_mesh>();
+            if (!mesh->load(path.c_str(), tex_cache, quantize))
+                mesh.reset();
+            return mesh;
+        }));
+        return true;
+    }
+
+    bool render_queue::request_dynamic_mesh(const std::string& path)
+    {
+        if (path.empty())
+            return false;
+        if (find_dynamic_mesh(path) || pending_dynamic_.count(path))
+            return true;
+
+        texture_cache* tex_cache = tex_cache_;
+        pending_dynamic_.emplace(path, streamer_.submit([path, tex_cache]()
+        {
+            auto mesh = std::make_unique<dynamic_mesh>();
+            if (!mesh->load(path.c_str(), tex_cache))
+                mesh.reset();
+            return mesh;
+        }));
+        return true;
+    }
+
+    template<class Desc>
+    render_queue::object_id render_queue::add_placeholder(const Desc& desc, bool is_dynamic)
+    {
+        const object_id object_id = resolve_id(desc.forced_id);
+
+        // Same normalization the asset gets, so the cube covers roughly where it will appear
+        const matrix base_world = build_normalized_world(desc.position, desc.rotation, desc.scale,
+                                                         placeholder_bounds_.local_min, placeholder_bounds_.local_max);
+        const fecs::entity root = add_root(base_world);
+        const fecs::entity e = spawn_instance(world_, placeholder_asset_, placeholder_bounds_, base_world,
+                                              desc.colour_tint, desc.ka, desc.kd);
+        if (Material* mat = world_.try_get_component<Material>(e))
+            mat->cull = desc.cull;
+        world_.add_component<local_transform>(e, local_transform{ matrix::makeIdentity() });
+        world_.add_component<transform_parent>(e, transform_parent{ root });
+
+        editor_object_component obj{};
+        obj.object_id = object_id;
+        obj.name = desc.name.empty() ? make_default_name(desc.path, object_id) : desc.name;
+        obj.model = desc.path;
+        obj.position = desc.position;
+        obj.rotation = desc.rotation;
+        obj.scale = desc.scale;
+        obj.is_dynamic = is_dynamic;
+        world_.add_component<editor_object_component>(e, obj);
+        index_object(object_id, { e }, { object_id, obj.name, is_dynamic, desc.visible, desc.path });
+
+        pending_object p{};
+        p.id = object_id;
+        p.is_dynamic = is_dynamic;
+        if constexpr (std::is_same_v<Desc, dynamic_mesh_desc>)
+            p.dynamic_desc = desc;
+        else
+            p.static_desc = desc;
+        pending_objects_.push_back(std::move(p));
+        return object_id;
+    }
+
+    void render_queue::poll_streaming()
+    {
+        if (pending_objects_.empty() && pending_static_.empty() && pending_dynamic_.empty())
+            return;
+
+        const auto take_ready = [](auto& pending, auto& cache)
+        {
+            for (auto it = pending.begin(); it != pending.end();)
+            {
+                if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                {
+                    ++it;
+                    continue;
+                }
+
+                auto mesh = it->second.get();
+                if (mesh && mesh->loaded())
+                    cache.emplace(it->first, std::move(mesh));
+                else
+                    std::printf("render_queue: failed to stream %s\n", it->first.c_str());
+                it = pending.erase(it);
+            }
+        };
+        take_ready(pending_static_, static_cache_);
+        take_ready(pending_dynamic_, dynamic_cache_);
+
+        std::vector<pending_object> waiting;
+        for (pending_object& p : pending_objects_)
+        {
+            const std::string& path = p.is_dynamic ? p.dynamic_desc.path : p.static_desc.path;
+            if (p.is_dynamic ? pending_dynamic_.count(path) != 0 : pending_static_.count(path) != 0)
+            {
+                waiting.push_back(std::move(p));
+                continue;
+            }
+
+            // Removed while loading
+            const std::vector<fecs::entity> placeholder = entities(p.id);
+            if (placeholder.empty())
+                continue;
+
+            // Keep what the editor changed on the placeholder
+            bool tagged = false;
+            if (const editor_object_component* obj = world_.try_get_component<editor_object_component>(placeholder.front()))
+            {
+                const auto apply = [&](auto& desc)
+                {
+                    desc.name = obj->name;
+                    desc.position = obj->position;
+                    desc.rotation = obj->rotation;
+                    desc.scale = obj->scale;
+                    desc.forced_id = p.id;
+                    if (const Material* mat = world_.try_get_component<Material>(placeholder.front()))
+                        desc.cull = mat->cull;
+                };
+                if (p.is_dynamic) apply(p.dynamic_desc);
+                else              apply(p.static_desc);
+            }
+            for (const fecs::entity e : placeholder)
+                tagged = tagged || world_.try_get_component<editor_tag>(e) != nullptr;
+            remove(p.id);
+
+            // A failed import leaves nothing behind; otherwise the asset is cached and builds at once
+            if (p.is_dynamic ? !find_dynamic_mesh(path) : !find_static_mesh(path))
+                continue;
+
+            const object_id spawned = p.is_dynamic ? add_dynamic_mesh(p.dynamic_desc) : add_static_mesh(p.static_desc);
+            if (spawned != 0 && tagged)
+                for (const fecs::entity e : entities(spawned))
+                    world_.add_component<editor_tag>(e);
+        }
+        pending_objects_ = std::move(waiting);
+    }
+
     render_queue::object_id render_queue::resolve_id(object_id forced_id)
     {
         const object_id object_id = (forced_id != 0) ? forced_id : next_object_id_++;
@@ -122,45 +353,123 @@ namespace fox
 
     render_queue::object_id render_queue::add_static_mesh(const static_mesh_desc& desc)
     {
-        static_mesh* mesh = get_static_mesh(desc.path);
-        if (!mesh || !mesh->loaded())
-            return 0;
+        std::vector<object_id> ids;
+        add_static_meshes(std::span<const static_mesh_desc>(&desc, 1), false, ids);
+        return ids.front();
+    }
 
-        const object_id object_id = resolve_id(desc.forced_id);
-        const std::string name = desc.name.empty() ? make_default_name(desc.path, object_id) : desc.name;
+    void render_queue::add_static_meshes(std::span<const static_mesh_desc> descs, const bool editor_tagged, std::vector<object_id>& out_ids)
+    {
+        struct spawn_object
+        {
+            static_mesh* mesh = nullptr;
+            const static_mesh_desc* desc = nullptr;
+            object_id id = 0;
+            std::string name{};
+            std::size_t first_row = 0;
+            matrix base_world{};
+        };
+
+        out_ids.assign(descs.size(), 0);
+        std::vector<spawn_object> objects;
+        std::vector<static_mesh::instance_row> rows;
+        objects.reserve(descs.size());
+
+        for (std::size_t i = 0; i < descs.size(); ++i)
+        {
+            const static_mesh_desc& desc = descs[i];
+            if (async_loading_ && !find_static_mesh(desc.path))
+            {
+                out_ids[i] = request_static_mesh(desc.path) ? add_placeholder(desc, false) : 0;
+                if (out_ids[i] != 0 && editor_tagged)
+                    for (const fecs::entity e : entities(out_ids[i]))
+                        world_.add_component<editor_tag>(e);
+                continue;
+            }
 
-        std::vector<fecs::entity> ents;
-        std::vector<matrix> locals;
-        const matrix base_world = build_normalized_world(desc.position, desc.rotation, desc.scale, mesh->bounds_min(), mesh->bounds_max());
-        mesh->build_instances(world_, base_world, desc.colour_tint, desc.ka, desc.kd, ents, locals);
+            static_mesh* mesh = get_static_mesh(desc.path);
+            if (!mesh || !mesh->loaded())
+                continue;
 
-        for (std::size_t i = 0; i < ents.size(); ++i)
-        {
-            const fecs::entity e = ents[i];
-            world_.add_component<editor_local_component>(e, editor_local_component{ locals[i] });
+            spawn_object obj{};
+            obj.mesh = mesh;
+            obj.desc = &desc;
+            obj.id = resolve_id(desc.forced_id);
+            obj.name = desc.name.empty() ? make_default_name(desc.path, obj.id) : desc.name;
+            obj.first_row = rows.size();
 
-            editor_object_component obj{};
-            obj.object_id = object_id;
-            obj.name = name;
+            obj.base_world = build_normalized_world(desc.position, desc.rotation, desc.scale, mesh->bounds_min(), mesh->bounds_max());
+            mesh->gather_instance_rows(obj.base_world, rows);
+
+            out_ids[i] = obj.id;
+            objects.push_back(std::move(obj));
+        }
+
+        if (rows.empty())
+            return;
+
+        std::vector<fecs::entity> roots;
+        world_.create_entities<local_transform, transform_group>(objects.size(), roots,
+            [&](std::size_t i, fecs::entity, local_transform& local, transform_group&) { local.local = objects[i].base_world; });
+
+        // Rows are grouped by object in order, so the owner only ever moves forward
+        std::size_t owner = 0;
+        const auto fill = [&](std::size_t i, fecs::entity, MeshRefPN& ref, Transform& tr, Material& mat, TextureRef& tex, Bounds& bounds,
+                              local_transform& local, transform_parent& parent, editor_object_component& obj, static_mesh_component& mesh_comp, auto&...)
+        {
+            while (owner + 1 < objects.size() && objects[owner + 1].first_row <= i)
+                ++owner;
+            const spawn_object& o = objects[owner];
+            const static_mesh_desc& desc = *o.desc;
+            const static_mesh::instance_row& row = rows[i];
+
+            ref = row.ref;
+            tr = Transform{ row.world };
+            mat.col = desc.colour_tint;
+            mat.ka = desc.ka;
+            mat.kd = desc.kd;
+            mat.cull = desc.cull;
+            tex = row.tex;
+            bounds = row.bounds;
+            local = local_transform{ row.local };
+            parent = transform_parent{ roots[owner] };
+
+            obj.object_id = o.id;
+            obj.name = o.name;
             obj.model = desc.path;
             obj.position = desc.position;
             obj.rotation = desc.rotation;
             obj.scale = desc.scale;
             obj.is_dynamic = false;
-            world_.add_component<editor_object_component>(e, obj);
 
-            static_mesh_component c{};
-            c.mesh = mesh;
-            c.path = desc.path;
-            c.visible = desc.visible;
-            world_.add_component<static_mesh_component>(e, c);
-        }
+            mesh_comp.mesh = o.mesh;
+            mesh_comp.path = desc.path;
+            mesh_comp.visible = desc.visible;
+        };
 
-        return object_id;
+        std::vector<fecs::entity> ents;
+        if (editor_tagged)
+            world_.create_entities<MeshRefPN, Transform, Material, TextureRef, Bounds,
+                                   local_transform, transform_parent, editor_object_component, static_mesh_component, editor_tag>(rows.size(), ents, fill);
+        else
+            world_.create_entities<MeshRefPN, Transform, Material, TextureRef, Bounds,
+                                   local_transform, transform_parent, editor_object_component, static_mesh_component>(rows.size(), ents, fill);
+
+        for (std::size_t k = 0; k < objects.size(); ++k)
+        {
+            const spawn_object& o = objects[k];
+            const std::size_t end = (k + 1 < objects.size()) ? objects[k + 1].first_row : ents.size();
+            if (end > o.first_row)
+                index_object(o.id, std::vector<fecs::entity>(ents.begin() + (std::ptrdiff_t)o.first_row, ents.begin() + (std::ptrdiff_t)end),
+                             { o.id, o.name, false, o.desc->visible, o.desc->path });
+        }
     }
 
     render_queue::object_id render_queue::add_dynamic_mesh(const dynamic_mesh_desc& desc)
     {
+        if (async_loading_ && !find_dynamic_mesh(desc.path))
+            return request_dynamic_mesh(desc.path) ? add_placeholder(desc, true) : 0;
+
         dynamic_mesh* mesh = get_dynamic_mesh(desc.path);
         if (!mesh || !mesh->loaded())
             return 0;
@@ -172,6 +481,7 @@ namespace fox
         std::vector<matrix> locals;
         const matrix base_world = build_normalized_world(desc.position, desc.rotation, desc.scale, mesh->bounds_min(), mesh->bounds_max());
         mesh->build_instances(world_, base_world, desc.colour_tint, desc.ka, desc.kd, ents, locals);
+        const fecs::entity root = add_root(base_world);
 
         const std::size_t clip_count = mesh->animation_count();
         const bool anim_enabled = desc.anim_enabled && clip_count > 0;
@@ -180,7 +490,8 @@ namespace fox
         for (std::size_t i = 0; i < ents.size(); ++i)
         {
             const fecs::entity e = ents[i];
-            world_.add_component<editor_local_component>(e, editor_local_component{ locals[i] });
+            world_.add_component<local_transform>(e, local_transform{ locals[i] });
+            world_.add_component<transform_parent>(e, transform_parent{ root });
 
             editor_object_component obj{};
             obj.object_id = object_id;
@@ -198,6 +509,9 @@ namespace fox
             obj.anim_time = desc.anim_time;
             world_.add_component<editor_object_component>(e, obj);
 
+            if (Material* mat = world_.try_get_component<Material>(e))
+                mat->cull = desc.cull;
+
             dynamic_mesh_component dc{};
             dc.mesh = mesh;
             dc.path = desc.path;
@@ -209,6 +523,8 @@ namespace fox
             dc.anim.time_offset = desc.time_offset;
             dc.anim.anim_time = desc.anim_time;
             world_.add_component<dynamic_mesh_component>(e, dc);
+            // Skinned and moved every frame, so kept out of the cached shadow map
+            world_.add_component<DynamicCaster>(e);
 
             animation_controller_component anim{};
             anim.mesh = mesh;
@@ -230,180 +546,249 @@ namespace fox
 
                 if (MeshRefPN* mesh_ref = world_.try_get_component<MeshRefPN>(e))
                 {
-                    for (std::size_t mi = 0; mi < inst->mesh_data.size(); ++mi)
-                    {
-                        const auto& inst_mesh = inst->mesh_data[mi];
-                        mesh_ref->positions = inst_mesh.asset.positions;
-                        mesh_ref->normals = inst_mesh.asset.normals;
-                        mesh_ref->uvs = inst_mesh.asset.uvs;
-                        mesh_ref->tri_count = inst_mesh.asset.tri_count;
-                        mesh_ref->has_uvs = inst_mesh.asset.has_uvs;
-                        break;
-                    }
+                    if (!inst->mesh_data.empty())
+                        *mesh_ref = mesh->instance_mesh_ref(*inst, 0);
+                }
+                if (Bounds* bounds = world_.try_get_component<Bounds>(e))
+                {
+                    if (!inst->mesh_data.empty())
+                        *bounds = mesh->instance_bounds(*inst, 0);
                 }
             }
         }
 
+        if (!ents.empty())
+            index_object(object_id, ents, { object_id, name, true, desc.visible, desc.path });
         return object_id;
     }
 
-    std::vector<fecs::entity> render_queue::entities(object_id id) const
+    void render_queue::index_object(object_id id, std::vector<fecs::entity> ents, object_info info)
     {
-        std::vector<fecs::entity> out;
-        world_.query<editor_object_component>().each_entity([&](fecs::entity e, editor_object_component& obj)
-        {
-            if (obj.object_id == id)
-                out.push_back(e);
-        });
-        return out;
+        info.id = id;
+        object_entities_[id] = std::move(ents);
+        const auto it = std::lower_bound(object_list_.begin(), object_list_.end(), id,
+            [](const object_info& o, object_id v) { return o.id < v; });
+        if (it != object_list_.end() && it->id == id)
+            *it = std::move(info);
+        else
+            object_list_.insert(it, std::move(info));
     }
 
-    void render_queue::remove(object_id id)
+    void render_queue::unindex_object(object_id id)
     {
-        for (const auto e : entities(id))
-            world_.destroy_entity(e);
+        object_entities_.erase(id);
+        const auto it = std::lower_bound(object_list_.begin(), object_list_.end(), id,
+            [](const object_info& o, object_id v) { return o.id < v; });
+        if (it != object_list_.end() && it->id == id)
+            object_list_.erase(it);
     }
 
-    bool render_queue::exists(object_id id) const
+    bool render_queue::all_alive(const std::vector<fecs::entity>& ents) const noexcept
     {
-        bool found = false;
-        world_.query<editor_object_component>().each_entity([&](fecs::entity, editor_object_component& obj)
-        {
-            if (obj.object_id == id)
-                found = true;
-        });
-        return found;
+        if (ents.empty())
+            return false;
+        for (const fecs::entity e : ents)
+            if (!world_.alive(e))
+                return false;
+        return true;
     }
 
-    void render_queue::apply_world_to_entities(object_id id, const matrix& base_world) const
+    const std::vector<fecs::entity>& render_queue::object_entities(object_id id) const
     {
-        world_.query<editor_object_component, editor_local_component, Transform>().each_entity(
-            [&](fecs::entity, editor_object_component& obj, editor_local_component& local, Transform& tr)
-            {
-                if (obj.object_id != id)
-                    return;
-                tr.world = base_world * local.local;
-            });
+        static const std::vector<fecs::entity> kNone{};
+        const auto it = object_entities_.find(id);
+        if (it == object_entities_.end() || !all_alive(it->second))
+            return kNone;
+        return it->second;
     }
 
-    Transform render_queue::get_transform(object_id id) const
+    template<class Component>
+    const Component* render_queue::first_component(object_id id) const
     {
-        Transform out{};
-        world_.query<editor_object_component, Transform>().each_entity(
-            [&](fecs::entity, editor_object_component& obj, Transform& tr)
-            {
-                if (obj.object_id == id)
-                    out = tr;
-            });
-        return out;
+        const fecs::world& world = std::as_const(world_);
+        for (const fecs::entity e : object_entities(id))
+            if (const Component* c = world.try_get_component<Component>(e))
+                return c;
+        return nullptr;
     }
 
-    bool render_queue::try_get_transform(object_id id, Transform*& out)
+    template<class Component>
+    Component* render_queue::first_component(object_id id)
     {
-        out = nullptr;
-        for (const auto e : entities(id))
-        {
-            out = world_.try_get_component<Transform>(e);
-            if (out)
-                return true;
-        }
-        return false;
+        for (const fecs::entity e : object_entities(id))
+            if (Component* c = world_.try_get_component<Component>(e))
+                return c;
+        return nullptr;
     }
 
-    bool render_queue::try_get_static(object_id id, static_mesh_component*& out)
+    const std::vector<render_queue::object_info>& render_queue::objects()
     {
-        out = nullptr;
-        for (const auto e : entities(id))
+        if (world_.version() == object_list_version_)
+            return object_list_;
+
+        bool swept = false;
+        for (auto it = object_entities_.begin(); it != object_entities_.end();)
         {
-            out = world_.try_get_component<static_mesh_component>(e);
-            if (out)
-                return true;
+            if (all_alive(it->second))
+            {
+                ++it;
+                continue;
+            }
+            it = object_entities_.erase(it);
+            swept = true;
         }
-        return false;
+        if (swept)
+            std::erase_if(object_list_, [&](const object_info& o) { return object_entities_.count(o.id) == 0; });
+        object_list_version_ = world_.version();
+        return object_list_;
     }
 
-    bool render_queue::try_get_dynamic(object_id id, dynamic_mesh_component*& out)
+    std::vector<fecs::entity> render_queue::entities(object_id id) const
     {
-        out = nullptr;
-        for (const auto e : entities(id))
-        {
-            out = world_.try_get_component<dynamic_mesh_component>(e);
-            if (out)
-                return true;
-        }
-        return false;
+        return object_entities(id);
     }
 
-    bool render_queue::try_get_editor_object(object_id id, editor_object_component*& out)
+    void render_queue::remove(object_id id)
+    {
+        // Straight from the index: whatever survives of a partly destroyed object goes too
+        if (const auto it = object_entities_.find(id); it != object_entities_.end())
+            world_.destroy_entities(it->second);
+        unindex_object(id);
+    }
+
+    void render_queue::remove(std::span<const object_id> ids)
     {
-        out = nullptr;
-        for (const auto e : entities(id))
+        std::vector<fecs::entity> doomed;
+        for (const object_id id : ids)
         {
-            out = world_.try_get_component<editor_object_component>(e);
-            if (out)
-                return true;
+            if (const auto it = object_entities_.find(id); it != object_entities_.end())
+                doomed.insert(doomed.end(), it->second.begin(), it->second.end());
         }
-        return false;
+        world_.destroy_entities(doomed);
+        for (const object_id id : ids)
+            unindex_object(id);
     }
 
-    void render_queue::enumerate_objects(std::vector<object_info>& out)
+    std::size_t render_queue::mesh_bytes() const
     {
-        out.clear();
-        std::unordered_map<object_id, object_info> uniq;
-        world_.query<editor_object_component>().each_entity([&](fecs::entity, editor_object_component& obj)
+        std::size_t bytes = placeholder_asset_.resident_bytes();
+        for (const auto& [path, mesh] : static_cache_)
+            bytes += mesh ? mesh->resident_bytes() : 0u;
+        for (const auto& [path, mesh] : dynamic_cache_)
+            bytes += mesh ? mesh->resident_bytes() : 0u;
+
+        world_.query<const animation_instance_component>().each_entity([&](fecs::entity, const animation_instance_component& a)
         {
-            if (obj.object_id == 0)
-                return;
+            if (a.instance)
+                bytes += a.instance->resident_bytes();
+        });
+        for (const auto& p : shared_poses_)
+            bytes += p->instance.resident_bytes();
+        return bytes;
+    }
 
-            auto [it, inserted] = uniq.emplace(obj.object_id, object_info{});
-            if (!inserted)
-                return;
+    std::size_t render_queue::release_unused_meshes()
+    {
+        std::unordered_set<const void*> used;
+        world_.query<const static_mesh_component>().each_entity([&](fecs::entity, const static_mesh_component& c) { used.insert(c.mesh); });
+        world_.query<const dynamic_mesh_component>().each_entity([&](fecs::entity, const dynamic_mesh_component& c) { used.insert(c.mesh); });
+        world_.query<const animation_controller_component>().each_entity([&](fecs::entity, const animation_controller_component& a) { used.insert(a.mesh); });
 
-            object_info& info = it->second;
-            info.id = obj.object_id;
-            info.name = obj.name;
-            info.is_dynamic = obj.is_dynamic;
-            info.asset_path = obj.model;
-            info.visible = true;
-        });
+        std::size_t freed = 0;
+        for (auto it = static_cache_.begin(); it != static_cache_.end();)
+        {
+            if (it->second && used.count(it->second.get()))
+            {
+                ++it;
+                continue;
+            }
+            freed += it->second ? it->second->resident_bytes() : 0u;
+            it = static_cache_.erase(it);
+        }
 
-        out.reserve(uniq.size());
-        for (auto& kv : uniq)
+        for (auto it = dynamic_cache_.begin(); it != dynamic_cache_.end();)
         {
-            object_info info = kv.second;
-            if (info.is_dynamic)
+            const dynamic_mesh* mesh = it->second.get();
+            if (mesh && used.count(mesh))
             {
-                dynamic_mesh_component* dynamic = nullptr;
-                if (try_get_dynamic(info.id, dynamic) && dynamic)
-                    info.visible = dynamic->visible;
+                ++it;
+                continue;
             }
-            else
+            for (auto p = shared_poses_.begin(); p != shared_poses_.end();)
             {
-                static_mesh_component* st = nullptr;
-                if (try_get_static(info.id, st) && st)
-                    info.visible = st->visible;
+                if ((*p)->key.mesh != mesh)
+                {
+                    ++p;
+                    continue;
+                }
+                freed += (*p)->instance.resident_bytes();
+                p = shared_poses_.erase(p);
             }
-            out.push_back(std::move(info));
+            freed += mesh ? mesh->resident_bytes() : 0u;
+            it = dynamic_cache_.erase(it);
         }
+        return freed;
+    }
 
-        std::sort(out.begin(), out.end(), [](const object_info& a, const object_info& b)
-        {
-            return a.id < b.id;
-        });
+    bool render_queue::exists(object_id id) const
+    {
+        return !object_entities(id).empty();
     }
 
-    bool render_queue::try_get_pick_radius(object_id id, float& out_radius) const
+    fecs::entity render_queue::add_root(const matrix& base_world)
     {
-        out_radius = 0.0f;
+        return world_.create_entity_with<local_transform, transform_group>(local_transform{ base_world }, transform_group{});
+    }
 
-        editor_object_component* base = nullptr;
-        for (const auto e : entities(id))
+    void render_queue::apply_world_to_entities(object_id id, const matrix& base_world)
+    {
+        // Every entity of an object hangs off the same root, moving it carries them all along
+        for (const fecs::entity e : entities(id))
         {
-            base = world_.try_get_component<editor_object_component>(e);
-            if (base)
+            if (const transform_parent* parent = world_.try_get_component<transform_parent>(e))
+            {
+                hierarchy_.set_local(world_, parent->parent, base_world);
                 break;
+            }
         }
+        hierarchy_.update(world_);
+    }
+
+    Transform render_queue::get_transform(object_id id) const
+    {
+        const Transform* tr = first_component<Transform>(id);
+        return tr ? *tr : Transform{};
+    }
+
+    bool render_queue::try_get_transform(object_id id, Transform*& out)
+    {
+        out = first_component<Transform>(id);
+        return out != nullptr;
+    }
+
+    bool render_queue::try_get_static(object_id id, static_mesh_component*& out)
+    {
+        out = first_component<static_mesh_component>(id);
+        return out != nullptr;
+    }
+
+    bool render_queue::try_get_dynamic(object_id id, dynamic_mesh_component*& out)
+    {
+        out = first_component<dynamic_mesh_component>(id);
+        return out != nullptr;
+    }
+
+    bool render_queue::try_get_editor_object(object_id id, editor_object_component*& out)
+    {
+        out = first_component<editor_object_component>(id);
+        return out != nullptr;
+    }
 
+    bool render_queue::try_get_pick_radius(object_id id, float& out_radius) const
+    {
+        out_radius = 0.0f;
+
+        const editor_object_component* base = first_component<editor_object_component>(id);
         if (!base)
             return false;
 
@@ -411,13 +796,7 @@ namespace fox
         vec4 bmax{};
         if (base->is_dynamic)
         {
-            dynamic_mesh_component* dyn = nullptr;
-            for (const auto e : entities(id))
-            {
-                dyn = world_.try_get_component<dynamic_mesh_component>(e);
-                if (dyn)
-                    break;
-            }
+            const dynamic_mesh_component* dyn = first_component<dynamic_mesh_component>(id);
             if (!dyn || !dyn->mesh)
                 return false;
             bmin = dyn->mesh->bounds_min();
@@ -425,19 +804,18 @@ namespace fox
         }
         else
         {
-            static_mesh_component* st = nullptr;
-            for (const auto e : entities(id))
-            {
-                st = world_.try_get_component<static_mesh_component>(e);
-                if (st)
-                    break;
-            }
+            const static_mesh_component* st = first_component<static_mesh_component>(id);
             if (!st || !st->mesh)
                 return false;
             bmin = st->mesh->bounds_min();
             bmax = st->mesh->bounds_max();
         }
 
+        return normalized_pick_radius(bmin, bmax, base->scale, out_radius);
+    }
+
+    bool render_queue::normalized_pick_radius(const vec4& bmin, const vec4& bmax, const vec4& scale, float& out_radius) const noexcept
+    {
         const float sx = bmax.x - bmin.x;
         const float sy = bmax.y - bmin.y;
         const float sz = bmax.z - bmin.z;
@@ -449,68 +827,206 @@ namespace fox
         const float ny = sy / max_extent;
         const float nz = sz / max_extent;
         const float base_radius = 0.5f * normalize_size_ * std::sqrt(nx * nx + ny * ny + nz * nz);
-        const float scale = (std::max)({ std::fabs(base->scale.x), std::fabs(base->scale.y), std::fabs(base->scale.z), 0.01f });
-        out_radius = base_radius * scale;
+        const float max_scale = (std::max)({ std::fabs(scale.x), std::fabs(scale.y), std::fabs(scale.z), 0.01f });
+        out_radius = base_radius * max_scale;
         return out_radius > 0.0001f;
     }
 
+    spatial_index::sphere render_queue::make_pick_sphere(const vec4& pos, const vec4& scale, const vec4* bmin, const vec4* bmax) const noexcept
+    {
+        spatial_index::sphere s{};
+        s.center = pos;
+        s.center.w = 1.f;
+        if (!bmin || !bmax || !normalized_pick_radius(*bmin, *bmax, scale, s.radius))
+        {
+            // Still streaming or degenerate: a small sphere that follows the scale
+            const float max_scale = (std::max)({ std::fabs(scale.x), std::fabs(scale.y), std::fabs(scale.z), 0.1f });
+            s.radius = kFallbackPickRadius * max_scale;
+        }
+        return s;
+    }
+
+    void render_queue::sync_pick_index()
+    {
+        // Spawns, removals and visibility changes: rebuild the item set from the editor objects
+        if (world_.version() != pick_version_)
+        {
+            struct pick_source
+            {
+                vec4 position{};
+                vec4 scale{};
+                vec4 bmin{};
+                vec4 bmax{};
+                bool has_bounds = false;
+                bool visible = true;
+            };
+
+            std::unordered_map<object_id, pick_source> sources;
+            world_.query<const editor_object_component>().each_entity([&](fecs::entity, const editor_object_component& obj)
+            {
+                if (obj.object_id == 0)
+                    return;
+                pick_source& src = sources[obj.object_id];
+                src.position = obj.position;
+                src.scale = obj.scale;
+            });
+            const auto take_mesh = [&](const editor_object_component& obj, const auto& c)
+            {
+                const auto it = sources.find(obj.object_id);
+                if (it == sources.end())
+                    return;
+                it->second.visible = c.visible;
+                if (c.mesh && !it->second.has_bounds)
+                {
+                    it->second.bmin = c.mesh->bounds_min();
+                    it->second.bmax = c.mesh->bounds_max();
+                    it->second.has_bounds = true;
+                }
+            };
+            world_.query<const editor_object_component, const static_mesh_component>().each_entity(
+                [&](fecs::entity, const editor_object_component& obj, const static_mesh_component& c) { take_mesh(obj, c); });
+            world_.query<const editor_object_component, const dynamic_mesh_component>().each_entity(
+                [&](fecs::entity, const editor_object_component& obj, const dynamic_mesh_component& c) { take_mesh(obj, c); });
+
+            std::vector<spatial_index::key_type> keys;
+            pick_index_.keys(keys);
+            for (const spatial_index::key_type key : keys)
+            {
+                const auto it = sources.find(key);
+                if (it == sources.end() || !it->second.visible)
+                    pick_index_.erase(key);
+            }
+            for (const auto& [id, src] : sources)
+            {
+                if (!src.visible)
+                    continue;
+                pick_index_.set(id, make_pick_sphere(src.position, src.scale,
+                                                     src.has_bounds ? &src.bmin : nullptr, src.has_bounds ? &src.bmax : nullptr));
+            }
+            pick_version_ = world_.version();
+        }
+
+        if (pick_rebuild_.valid() && pick_rebuild_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            pick_index_.adopt(pick_rebuild_.get());
+
+        // Small sets rebuild on the spot; large ones on the streamer while the loose list covers
+        if (!pick_rebuild_.valid() && pick_index_.wants_rebuild())
+        {
+            if (pick_index_.size() <= kInlinePickRebuild)
+                pick_index_.rebuild();
+            else
+                pick_rebuild_ = streamer_.submit([snap = pick_index_.take_snapshot()]() mutable
+                {
+                    return spatial_index::build(std::move(snap));
+                });
+        }
+    }
+
     void render_queue::set_transform(object_id id, const vec4& pos, const vec4& rot, const vec4& scale)
     {
         editor_object_component base{};
         bool found = false;
-        world_.query<editor_object_component>().each_entity([&](fecs::entity, editor_object_component& obj)
+        for (const fecs::entity e : object_entities(id))
         {
-            if (!found && obj.object_id == id)
+            editor_object_component* obj = world_.try_get_component<editor_object_component>(e);
+            if (!obj)
+                continue;
+            if (!found)
             {
-                base = obj;
+                base = *obj;
                 found = true;
             }
-            if (obj.object_id == id)
-            {
-                obj.position = pos;
-                obj.rotation = rot;
-                obj.scale = scale;
-            }
-        });
+            obj->position = pos;
+            obj->rotation = rot;
+            obj->scale = scale;
+        }
 
         if (!found)
             return;
 
-        matrix base_world = matrix::makeIdentity();
+        // Objects still streaming are their placeholder cube
+        vec4 bmin = placeholder_bounds_.local_min;
+        vec4 bmax = placeholder_bounds_.local_max;
+        bool has_bounds = false;
         if (base.is_dynamic)
         {
-            if (dynamic_mesh* mesh = get_dynamic_mesh(base.model))
-                base_world = build_normalized_world(pos, rot, scale, mesh->bounds_min(), mesh->bounds_max());
+            if (dynamic_mesh* mesh = find_dynamic_mesh(base.model))
+            {
+                bmin = mesh->bounds_min();
+                bmax = mesh->bounds_max();
+                has_bounds = true;
+            }
         }
         else
         {
-            if (static_mesh* mesh = get_static_mesh(base.model))
-                base_world = build_normalized_world(pos, rot, scale, mesh->bounds_min(), mesh->bounds_max());
+            if (static_mesh* mesh = find_static_mesh(base.model))
+            {
+                bmin = mesh->bounds_min();
+                bmax = mesh->bounds_max();
+                has_bounds = true;
+            }
         }
+        const matrix base_world = build_normalized_world(pos, rot, scale, bmin, bmax);
 
         apply_world_to_entities(id, base_world);
+
+        if (pick_index_.contains(id))
+            pick_index_.set(id, make_pick_sphere(pos, scale, has_bounds ? &bmin : nullptr, has_bounds ? &bmax : nullptr));
     }
 
     void render_queue::set_visible(object_id id, bool visible)
     {
-        world_.query<editor_object_component, static_mesh_component>().each_entity([&](fecs::entity, editor_object_component& obj, static_mesh_component& c)
+        pick_version_ = kStalePickVersion;
+        bool changed = false;
+        for (const fecs::entity e : object_entities(id))
         {
-            if (obj.object_id == id)
-                c.visible = visible;
-        });
-        world_.query<editor_object_component, dynamic_mesh_component>().each_entity([&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c)
+            if (static_mesh_component* c = world_.try_get_component<static_mesh_component>(e))
+            {
+                c->visible = visible;
+                changed = true;
+            }
+            if (dynamic_mesh_component* c = world_.try_get_component<dynamic_mesh_component>(e))
+            {
+                c->visible = visible;
+                changed = true;
+            }
+        }
+
+        const auto it = std::lower_bound(object_list_.begin(), object_list_.end(), id,
+            [](const object_info& o, object_id v) { return o.id < v; });
+        if (changed && it != object_list_.end() && it->id == id)
+            it->visible = visible;
+    }
+
+    cull_mode render_queue::get_cull(object_id id) const
+    {
+        const Material* mat = first_component<Material>(id);
+        return mat ? mat->cull : cull_mode::none;
+    }
+
+    void render_queue::set_cull(object_id id, cull_mode cull)
+    {
+        for (const fecs::entity e : object_entities(id))
+            if (Material* mat = world_.try_get_component<Material>(e))
+                mat->cull = cull;
+    }
+
+    template<class Fn>
+    void render_queue::each_dynamic_entity(object_id id, Fn&& fn)
+    {
+        for (const fecs::entity e : object_entities(id))
         {
-            if (obj.object_id == id)
-                c.visible = visible;
-        });
+            editor_object_component* obj = world_.try_get_component<editor_object_component>(e);
+            dynamic_mesh_component* c = world_.try_get_component<dynamic_mesh_component>(e);
+            if (obj && c)
+                fn(e, *obj, *c);
+        }
     }
 
     void render_queue::set_animation_enabled(object_id id, bool enabled)
     {
-        world_.query<editor_object_component, dynamic_mesh_component>().each_entity([&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c)
+        each_dynamic_entity(id, [&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c)
         {
-            if (obj.object_id != id)
-                return;
             obj.anim_enabled = enabled;
             c.anim.enabled = enabled;
         });
@@ -518,10 +1034,8 @@ namespace fox
 
     void render_queue::set_animation_paused(object_id id, bool paused)
     {
-        world_.query<editor_object_component, dynamic_mesh_component>().each_entity([&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c)
+        each_dynamic_entity(id, [&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c)
         {
-            if (obj.object_id != id)
-                return;
             obj.anim_paused = paused;
             c.anim.paused = paused;
         });
@@ -529,48 +1043,49 @@ namespace fox
 
     void render_queue::set_animation_index(object_id id, std::size_t index)
     {
-        world_.query<editor_object_component, dynamic_mesh_component, animation_controller_component>().each_entity([&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c, animation_controller_component& anim)
+        each_dynamic_entity(id, [&](fecs::entity e, editor_object_component& obj, dynamic_mesh_component& c)
         {
-            if (obj.object_id != id)
+            animation_controller_component* anim = world_.try_get_component<animation_controller_component>(e);
+            if (!anim)
                 return;
             const std::size_t clip_count = c.mesh ? c.mesh->animation_count() : 0;
             const std::size_t safe = (clip_count > 0) ? (std::min)(index, clip_count - 1) : 0;
             obj.anim_index = safe;
             c.anim.index = safe;
-            anim.current_anim = safe;
+            anim->current_anim = safe;
         });
     }
 
     void render_queue::set_playback_speed(object_id id, float speed)
     {
-        world_.query<editor_object_component, dynamic_mesh_component, animation_controller_component>().each_entity([&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c, animation_controller_component& anim)
+        each_dynamic_entity(id, [&](fecs::entity e, editor_object_component& obj, dynamic_mesh_component& c)
         {
-            if (obj.object_id != id)
+            animation_controller_component* anim = world_.try_get_component<animation_controller_component>(e);
+            if (!anim)
                 return;
             obj.playback_speed = speed;
             c.anim.playback_speed = speed;
-            anim.playback_speed = speed;
+            anim->playback_speed = speed;
         });
     }
 
     void render_queue::set_time_offset(object_id id, float offset)
     {
-        world_.query<editor_object_component, dynamic_mesh_component, animation_controller_component>().each_entity([&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c, animation_controller_component& anim)
+        each_dynamic_entity(id, [&](fecs::entity e, editor_object_component& obj, dynamic_mesh_component& c)
         {
-            if (obj.object_id != id)
+            animation_controller_component* anim = world_.try_get_component<animation_controller_component>(e);
+            if (!anim)
                 return;
             obj.time_offset = offset;
             c.anim.time_offset = offset;
-            anim.time_offset = offset;
+            anim->time_offset = offset;
         });
     }
 
     void render_queue::set_anim_time(object_id id, float anim_time)
     {
-        world_.query<editor_object_component, dynamic_mesh_component>().each_entity([&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c)
+        each_dynamic_entity(id, [&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c)
         {
-            if (obj.object_id != id)
-                return;
             obj.anim_time = anim_time;
             c.anim.anim_time = anim_time;
         });
@@ -578,68 +1093,154 @@ namespace fox
 
     void render_queue::reset_anim_time(object_id id)
     {
-        world_.query<editor_object_component, dynamic_mesh_component>().each_entity([&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c)
-        {
-            if (obj.object_id != id)
-                return;
-            obj.anim_time = 0.0f;
-            c.anim.anim_time = 0.0f;
-        });
+        set_anim_time(id, 0.0f);
     }
 
     dynamic_anim_state render_queue::get_anim_state(object_id id) const
     {
-        dynamic_anim_state s{};
-        world_.query<editor_object_component, dynamic_mesh_component>().each_entity([&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& c)
-        {
-            if (obj.object_id == id)
-                s = c.anim;
-        });
-        return s;
+        const dynamic_mesh_component* c = first_component<dynamic_mesh_component>(id);
+        return c ? c->anim : dynamic_anim_state{};
     }
 
-    void render_queue::tick_dynamic_animations(float dt) noexcept
+    void render_queue::tick_dynamic_animations(float dt, const vec4& eye) noexcept
     {
-        world_.query<editor_object_component, dynamic_mesh_component, animation_instance_component, MeshRefPN>().each_entity(
-            [&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& dyn, animation_instance_component& inst_comp, MeshRefPN& mesh_ref)
+        // Read only first: the skinning pass writes MeshRefPN and Bounds, which stamps those columns
+        // of every table it visits whether a pose changed or not
+        bool pending = false;
+        world_.query<const editor_object_component, const dynamic_mesh_component, const animation_instance_component, const Transform, const Bounds>().each_entity(
+            [&](fecs::entity, const editor_object_component& obj, const dynamic_mesh_component& dyn, const animation_instance_component& inst,
+                const Transform& tr, const Bounds& b)
             {
-                if (!obj.is_dynamic || obj.object_id == 0 || obj.model.empty())
-                    return;
-                if (!obj.anim_enabled || !inst_comp.instance)
-                    return;
-
-                dynamic_mesh* mesh = dyn.mesh;
-                if (!mesh || !mesh->has_animation())
+                const std::size_t clip = playing_clip(obj, dyn, inst);
+                if (pending || clip == kNoClip)
                     return;
+                pending = !obj.anim_paused || inst.shown_clip != clip || inst.shown_step != pose_step(skin_time(obj), anim_lod_step(tr, b, eye));
+            });
+        if (!pending)
+            return;
 
-                const std::size_t clip_count = mesh->animation_count();
-                if (clip_count == 0)
+        pose_jobs_.clear();
+        world_.query<editor_object_component, dynamic_mesh_component, animation_instance_component, MeshRefPN, Bounds, const Transform>().each_entity(
+            [&](fecs::entity, editor_object_component& obj, dynamic_mesh_component& dyn, animation_instance_component& inst,
+                MeshRefPN& mesh_ref, Bounds& bounds, const Transform& tr)
+            {
+                const std::size_t clip = playing_clip(obj, dyn, inst);
+                if (clip == kNoClip)
                     return;
 
-                const std::size_t safe_index = (std::min)(obj.anim_index, clip_count - 1);
                 if (!obj.anim_paused)
                     obj.anim_time += dt;
                 dyn.anim.anim_time = obj.anim_time;
-                dyn.anim.index = safe_index;
+                dyn.anim.index = clip;
                 dyn.anim.enabled = obj.anim_enabled;
                 dyn.anim.paused = obj.anim_paused;
                 dyn.anim.playback_speed = obj.playback_speed;
                 dyn.anim.time_offset = obj.time_offset;
 
-                dynamic_mesh_instance* inst = inst_comp.instance;
-                inst->anim_index = safe_index;
-                mesh->tick_skinning(*inst, static_cast<double>((obj.anim_time + obj.time_offset) * obj.playback_speed));
+                const pose_key key{ dyn.mesh, clip, pose_step(skin_time(obj), anim_lod_step(tr, bounds, eye)) };
+                inst.shown_clip = key.clip;
+                inst.shown_step = key.step;
+                pose_jobs_.push_back({ key, inst.instance, nullptr, &mesh_ref, &bounds });
+            });
 
-                for (std::size_t mi = 0; mi < inst->mesh_data.size(); ++mi)
+        // Runs of equal keys share one pose
+        std::sort(pose_jobs_.begin(), pose_jobs_.end(), [](const pose_job& a, const pose_job& b)
+        {
+            if (a.key.mesh != b.key.mesh) return std::less<const dynamic_mesh*>{}(a.key.mesh, b.key.mesh);
+            if (a.key.clip != b.key.clip) return a.key.clip < b.key.clip;
+            return a.key.step < b.key.step;
+        });
+        const auto run_end = [this](std::size_t begin) noexcept
+        {
+            std::size_t end = begin + 1;
+            while (end < pose_jobs_.size() && pose_jobs_[end].key == pose_jobs_[begin].key)
+                ++end;
+            return end;
+        };
+        const auto show = [this](std::size_t begin, std::size_t end, const dynamic_mesh_instance* pose) noexcept
+        {
+            for (std::size_t i = begin; i < end; ++i)
+                pose_jobs_[i].shown = pose;
+        };
+
+        // A shared pose still on its key is kept as is; the rest are free for the new keys below
+        skin_tasks_.clear();
+        for (const auto& p : shared_poses_)
+            p->claimed = false;
+        for (std::size_t begin = 0, end = 0; begin < pose_jobs_.size(); begin = end)
+        {
+            end = run_end(begin);
+            const pose_job& job = pose_jobs_[begin];
+            if (end - begin == 1)
+            {
+                dynamic_mesh_instance* own = job.own;
+                if (own->skinned_index != job.key.clip || own->skinned_time != (double)job.key.step * kPoseQuantumSeconds)
+                    skin_tasks_.push_back({ job.key, own });
+                show(begin, end, own);
+                continue;
+            }
+            for (const auto& p : shared_poses_)
+            {
+                if (!p->claimed && p->key == job.key)
                 {
-                    const auto& inst_mesh = inst->mesh_data[mi];
-                    mesh_ref.positions = inst_mesh.asset.positions;
-                    mesh_ref.normals = inst_mesh.asset.normals;
-                    mesh_ref.uvs = inst_mesh.asset.uvs;
-                    mesh_ref.tri_count = inst_mesh.asset.tri_count;
-                    mesh_ref.has_uvs = inst_mesh.asset.has_uvs;
+                    p->claimed = true;
+                    show(begin, end, &p->instance);
                     break;
                 }
+            }
+        }
+        for (std::size_t begin = 0, end = 0; begin < pose_jobs_.size(); begin = end)
+        {
+            end = run_end(begin);
+            const pose_job& job = pose_jobs_[begin];
+            if (job.shown)
+                continue;
+
+            shared_pose* pose = nullptr;
+            for (const auto& p : shared_poses_)
+            {
+                if (!p->claimed && p->key.mesh == job.key.mesh)
+                {
+                    pose = p.get();
+                    break;
+                }
+            }
+            if (!pose)
+            {
+                shared_poses_.push_back(std::make_unique<shared_pose>());
+                pose = shared_poses_.back().get();
+                pose->instance = job.key.mesh->create_instance();
+            }
+            pose->key = job.key;
+            pose->claimed = true;
+            skin_tasks_.push_back({ job.key, &pose->instance });
+            show(begin, end, &pose->instance);
+        }
+        // Every instance is pointed at its pose again below, so nothing still shows a dropped one
+        std::erase_if(shared_poses_, [](const std::unique_ptr<shared_pose>& p) { return !p->claimed; });
+
+        // Every target owns its buffers, so tasks skin independently; one per range because a single
+        // skin is already split across the pool by tick_skinning
+        job_system::instance().parallel_for((std::uint32_t)skin_tasks_.size(), 1,
+            [this](std::uint32_t begin, std::uint32_t end)
+            {
+                for (std::uint32_t i = begin; i < end; ++i)
+                {
+                    const skin_task& task = skin_tasks_[i];
+                    const double t = (double)task.key.step * kPoseQuantumSeconds;
+                    task.target->anim_index = task.key.clip;
+                    task.key.mesh->tick_skinning(*task.target, t);
+                    task.target->skinned_index = task.key.clip;
+                    task.target->skinned_time = t;
+                }
             });
+
+        for (const pose_job& job : pose_jobs_)
+        {
+            if (job.shown->mesh_data.empty())
+                continue;
+            *job.mesh_ref = job.key.mesh->instance_mesh_ref(*job.shown, 0);
+            *job.bounds = job.key.mesh->instance_bounds(*job.shown, 0);
+        }
     }
 }
@@ -0,0 +1,263 @@
+#include "game/spatial_index.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace fox
+{
+    namespace
+    {
+        struct box
+        {
+            float min[3] = {  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max() };
+            float max[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+            void grow(const spatial_index::sphere& s) noexcept
+            {
+                const float c[3] = { s.center.x, s.center.y, s.center.z };
+                for (int a = 0; a < 3; ++a)
+                {
+                    min[a] = (std::min)(min[a], c[a] - s.radius);
+                    max[a] = (std::max)(max[a], c[a] + s.radius);
+                }
+            }
+
+            void grow(const spatial_index::tree::node& n) noexcept
+            {
+                for (int a = 0; a < 3; ++a)
+                {
+                    min[a] = (std::min)(min[a], n.min[a]);
+                    max[a] = (std::max)(max[a], n.max[a]);
+                }
+            }
+
+            void store(spatial_index::tree::node& n) const noexcept
+            {
+                for (int a = 0; a < 3; ++a)
+                {
+                    n.min[a] = min[a];
+                    n.max[a] = max[a];
+                }
+            }
+        };
+
+        // Splits [first, last) of order at the median centroid on the widest axis, children
+        // allocated side by side so an inner node only stores the first
+        void build_node(spatial_index::tree& t, const spatial_index::snapshot& snap, std::vector<std::uint32_t>& order,
+                        const std::uint32_t node, const std::uint32_t first, const std::uint32_t last, const std::uint32_t leaf_items)
+        {
+            box bounds{};
+            box centroids{};
+            for (std::uint32_t i = first; i < last; ++i)
+            {
+                const spatial_index::sphere& s = snap.spheres[order[i]];
+                bounds.grow(s);
+                centroids.grow(spatial_index::sphere{ s.center, 0.f });
+            }
+            bounds.store(t.nodes[node]);
+
+            const std::uint32_t count = last - first;
+            if (count <= leaf_items)
+            {
+                t.nodes[node].first = first;
+                t.nodes[node].count = count;
+                return;
+            }
+
+            int axis = 0;
+            float widest = centroids.max[0] - centroids.min[0];
+            for (int a = 1; a < 3; ++a)
+            {
+                if (centroids.max[a] - centroids.min[a] > widest)
+                {
+                    widest = centroids.max[a] - centroids.min[a];
+                    axis = a;
+                }
+            }
+
+            const std::uint32_t mid = first + count / 2u;
+            std::nth_element(order.begin() + first, order.begin() + mid, order.begin() + last,
+                [&](std::uint32_t a, std::uint32_t b) { return snap.spheres[a].center[axis] < snap.spheres[b].center[axis]; });
+
+            const std::uint32_t children = static_cast<std::uint32_t>(t.nodes.size());
+            t.nodes.emplace_back();
+            t.nodes.emplace_back();
+            t.nodes[node].first = children;
+            t.nodes[node].count = 0;
+
+            build_node(t, snap, order, children, first, mid, leaf_items);
+            build_node(t, snap, order, children + 1u, mid, last, leaf_items);
+        }
+    }
+
+    std::uint32_t spatial_index::new_slot()
+    {
+        if (!free_.empty())
+        {
+            const std::uint32_t slot = free_.back();
+            free_.pop_back();
+            return slot;
+        }
+        items_.emplace_back();
+        return static_cast<std::uint32_t>(items_.size() - 1u);
+    }
+
+    void spatial_index::set(const key_type key, const sphere& s)
+    {
+        if (const auto it = slot_of_.find(key); it != slot_of_.end())
+        {
+            item& existing = items_[it->second];
+            existing.s = s;
+            refit_pending_ = refit_pending_ || existing.in_tree;
+            return;
+        }
+
+        const std::uint32_t slot = new_slot();
+        const bool in_tree = items_[slot].in_tree; // reused slot the current tree still covers
+        items_[slot] = item{ key, s, true, in_tree };
+        slot_of_.emplace(key, slot);
+        if (in_tree)
+            refit_pending_ = true;
+        else
+            loose_.push_back(slot);
+        ++structure_;
+    }
+
+    void spatial_index::erase(const key_type key)
+    {
+        const auto it = slot_of_.find(key);
+        if (it == slot_of_.end())
+            return;
+
+        const std::uint32_t slot = it->second;
+        slot_of_.erase(it);
+        item& gone = items_[slot];
+        gone.live = false;
+        if (gone.in_tree)
+        {
+            pending_free_.push_back(slot);
+            refit_pending_ = true;
+        }
+        else
+        {
+            loose_.erase(std::find(loose_.begin(), loose_.end(), slot));
+            free_.push_back(slot);
+        }
+        ++structure_;
+    }
+
+    void spatial_index::clear() noexcept
+    {
+        items_.clear();
+        slot_of_.clear();
+        free_.clear();
+        pending_free_.clear();
+        loose_.clear();
+        tree_ = {};
+        structure_ = 0;
+        refit_pending_ = false;
+    }
+
+    void spatial_index::keys(std::vector<key_type>& out) const
+    {
+        out.clear();
+        out.reserve(slot_of_.size());
+        for (const auto& entry : slot_of_)
+            out.push_back(entry.first);
+    }
+
+    spatial_index::snapshot spatial_index::take_snapshot() const
+    {
+        snapshot snap{};
+        snap.structure = structure_;
+        snap.slots.reserve(slot_of_.size());
+        snap.spheres.reserve(slot_of_.size());
+        for (std::uint32_t slot = 0; slot < items_.size(); ++slot)
+        {
+            if (!items_[slot].live)
+                continue;
+            snap.slots.push_back(slot);
+            snap.spheres.push_back(items_[slot].s);
+        }
+        return snap;
+    }
+
+    spatial_index::tree spatial_index::build(snapshot snap)
+    {
+        tree t{};
+        t.structure = snap.structure;
+        if (snap.slots.empty())
+            return t;
+
+        const std::uint32_t n = static_cast<std::uint32_t>(snap.slots.size());
+        std::vector<std::uint32_t> order(n);
+        std::iota(order.begin(), order.end(), 0u);
+
+        t.nodes.reserve(2u * (n / kLeafItems + 1u));
+        t.nodes.emplace_back();
+        build_node(t, snap, order, 0u, 0u, n, kLeafItems);
+
+        t.slots.resize(n);
+        for (std::uint32_t i = 0; i < n; ++i)
+            t.slots[i] = snap.slots[order[i]];
+        return t;
+    }
+
+    void spatial_index::adopt(tree t)
+    {
+        tree_ = std::move(t);
+
+        for (item& it : items_)
+            it.in_tree = false;
+        for (const std::uint32_t slot : tree_.slots)
+            items_[slot].in_tree = true;
+
+        // Added since the snapshot stays loose; erased and no longer covered can be reused
+        loose_.clear();
+        for (std::uint32_t slot = 0; slot < items_.size(); ++slot)
+        {
+            if (items_[slot].live && !items_[slot].in_tree)
+                loose_.push_back(slot);
+        }
+
+        std::vector<std::uint32_t> still_covered;
+        for (const std::uint32_t slot : pending_free_)
+        {
+            if (items_[slot].in_tree)
+                still_covered.push_back(slot);
+            else
+                free_.push_back(slot);
+        }
+        pending_free_ = std::move(still_covered);
+
+        refit();
+    }
+
+    void spatial_index::refit()
+    {
+        refit_pending_ = false;
+
+        // Children always come after their parent, so one backward pass settles every box
+        for (std::size_t i = tree_.nodes.size(); i-- > 0;)
+        {
+            tree::node& n = tree_.nodes[i];
+            box b{};
+            if (n.count > 0)
+            {
+                for (std::uint32_t k = 0; k < n.count; ++k)
+                {
+                    const item& it = items_[tree_.slots[n.first + k]];
+                    if (it.live)
+                        b.grow(it.s);
+                }
+            }
+            else
+            {
+                b.grow(tree_.nodes[n.first]);
+                b.grow(tree_.nodes[n.first + 1u]);
+            }
+            b.store(n);
+        }
+    }
+}
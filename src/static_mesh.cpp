@@ -1,11 +1,111 @@
 #include "game/static_mesh.h"
+#include "optimized/mesh_optimizer.h"
 
 #include <assimp/material.h>
 #include <assimp/postprocess.h>
 
 #include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
 #include <limits>
+#include <system_error>
+
+namespace
+{
+    struct lod_level
+    {
+        float tri_fraction;   // of the full mesh
+        float max_error;      // relative to the bounding radius
+    };
+
+    constexpr lod_level kLodLevels[] = {
+        { 0.50f, 0.01f },
+        { 0.25f, 0.025f },
+        { 0.10f, 0.06f },
+    };
+
+    // Meshes below this are cheaper to draw than to switch
+    constexpr std::uint32_t kLodMinTriangles = 256;
+    // A level must drop at least this share of its parent's triangles to be kept
+    constexpr float kLodMinReduction = 0.8f;
+    // Projected bounding sphere radius at which the full mesh hands over; a level with fraction f
+    // takes over below kLodFullDetailRadiusPx * sqrt(f), keeping triangles per pixel roughly constant
+    constexpr float kLodFullDetailRadiusPx = 256.f;
+
+    // Triangles per cluster of the full mesh; a mesh with fewer than two clusters' worth has none,
+    // its entity test already being as fine
+    constexpr std::uint32_t kClusterTriangles = 96;
+
+    // .foxmesh: header, mesh table, instance table, then every array at an absolute, 64 byte aligned
+    // offset. A bake is only used while the source's size and write time match the ones it recorded.
+    constexpr const char* kBakedExtension = ".foxmesh";
+    constexpr std::uint32_t kBakedMagic = 0x48534D46u; // "FMSH"
+    constexpr std::uint32_t kBakedVersion = 3;
+    constexpr std::uint64_t kBakedAlign = MeshAssetPN::ALIGN_BYTES;
+    constexpr std::uint32_t kBakedMaxLevels = 1 + (std::uint32_t)std::size(kLodLevels);
+
+    struct baked_header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t mesh_count;
+        std::uint32_t instance_count;
+        std::uint64_t node_count;
+        std::uint64_t source_size;
+        std::int64_t  source_time;
+        float bounds_min[4];
+        float bounds_max[4];
+    };
+
+    struct baked_level
+    {
+        std::uint32_t tri_count;
+        std::uint32_t vertex_count;
+        float lod_radius_px;
+        std::uint32_t pad;
+        std::uint64_t positions;
+        std::uint64_t normals;
+        std::uint64_t uvs;       // 0 without UVs
+        std::uint64_t indices;
+        std::uint64_t quant;     // quant_stream in place of positions, normals and uvs, 0 for floats
+    };
+
+    struct baked_mesh
+    {
+        baked_level levels[kBakedMaxLevels]; // full mesh, then its LODs
+        std::uint32_t level_count;
+        std::uint32_t has_uvs;
+        std::uint32_t tex_source;
+        std::uint32_t tex_key_size;
+        std::uint64_t tex_key;
+        std::uint64_t tex_data;  // compressed embedded image, 0 otherwise
+        std::uint64_t tex_size;
+        float local_min[4];
+        float local_max[4];
+        std::uint64_t clusters;  // mesh_cluster per cluster of the full mesh, 0 without
+        std::uint32_t cluster_count;
+        std::uint32_t pad;
+    };
+
+    struct baked_instance
+    {
+        std::uint64_t mesh_index;
+        float node_world[16];    // row-major
+    };
+
+    bool source_stamp(const char* path, std::uint64_t& size, std::int64_t& time)
+    {
+        std::error_code ec;
+        size = (std::uint64_t)std::filesystem::file_size(path, ec);
+        if (ec)
+            return false;
+        time = (std::int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+        return !ec;
+    }
+}
 
 matrix static_mesh::to_matrix(const aiMatrix4x4& m)
 {
@@ -27,35 +127,142 @@ void static_mesh::update_bounds(vec4& min_v, vec4& max_v, const vec4& p)
     max_v[2] = (std::max)(max_v[2], p[2]);
 }
 
-void static_mesh::build_asset_from_buffers(mesh_data& data)
+void static_mesh::build_asset_from_buffers(mesh_data& data, bool quantize)
 {
     const std::uint32_t tri_count = static_cast<std::uint32_t>(data.triangles.size());
+    const std::uint32_t vertex_count = static_cast<std::uint32_t>(data.positions.size());
     const bool has_uvs = !data.uvs.empty();
-    data.asset.allocate(tri_count, has_uvs);
+    data.asset.allocate_indexed(tri_count, vertex_count, has_uvs);
 
     for (std::uint32_t t = 0; t < tri_count; ++t)
     {
         const triIndices& tri = data.triangles[t];
-        const std::size_t base = static_cast<std::size_t>(t) * 3u;
-
-        data.asset.positions[base + 0] = data.positions[tri.v0];
-        data.asset.positions[base + 1] = data.positions[tri.v1];
-        data.asset.positions[base + 2] = data.positions[tri.v2];
+        data.asset.indices[t * 3u + 0] = tri.v0;
+        data.asset.indices[t * 3u + 1] = tri.v1;
+        data.asset.indices[t * 3u + 2] = tri.v2;
+    }
 
-        data.asset.normals[base + 0] = data.normals[tri.v0];
-        data.asset.normals[base + 1] = data.normals[tri.v1];
-        data.asset.normals[base + 2] = data.normals[tri.v2];
+    optimize_vertex_cache(data.asset.indices, tri_count, vertex_count);
+    data.clusters.clear();
+    if (tri_count >= kClusterTriangles * 2u)
+        data.clusters = build_mesh_clusters(data.asset.indices, tri_count, &data.positions[0].x, 4u, vertex_count, kClusterTriangles);
+    const std::vector<std::uint32_t> remap = optimize_vertex_fetch(data.asset.indices, tri_count, vertex_count);
 
+    for (std::uint32_t v = 0; v < vertex_count; ++v)
+    {
+        const std::uint32_t dst = remap[v];
+        data.asset.positions[dst] = data.positions[v];
+        data.asset.normals[dst] = data.normals[v];
         if (has_uvs)
         {
-            data.asset.uvs[(base + 0) * 2 + 0] = data.uvs[tri.v0 * 2 + 0];
-            data.asset.uvs[(base + 0) * 2 + 1] = data.uvs[tri.v0 * 2 + 1];
-            data.asset.uvs[(base + 1) * 2 + 0] = data.uvs[tri.v1 * 2 + 0];
-            data.asset.uvs[(base + 1) * 2 + 1] = data.uvs[tri.v1 * 2 + 1];
-            data.asset.uvs[(base + 2) * 2 + 0] = data.uvs[tri.v2 * 2 + 0];
-            data.asset.uvs[(base + 2) * 2 + 1] = data.uvs[tri.v2 * 2 + 1];
+            data.asset.uvs[dst * 2u + 0] = data.uvs[v * 2u + 0];
+            data.asset.uvs[dst * 2u + 1] = data.uvs[v * 2u + 1];
         }
     }
+
+    data.bounds = compute_local_bounds(data.asset);
+    build_lods(data);
+    if (quantize)
+        quantize_levels(data);
+    bind_clusters(data, data.clusters.data(), (std::uint32_t)data.clusters.size());
+
+    // The asset is the only copy needed past load
+    data.positions = {};
+    data.normals = {};
+    data.uvs = {};
+    data.triangles = {};
+}
+
+void static_mesh::bind_clusters(mesh_data& data, const mesh_cluster* clusters, std::uint32_t count) noexcept
+{
+    data.bounds.clusters = count > 0 ? clusters : nullptr;
+    data.bounds.cluster_indices = count > 0 ? data.ref.indices : nullptr;
+    data.bounds.cluster_count = count > 0 ? count : 0u;
+}
+
+void static_mesh::build_lods(mesh_data& data)
+{
+    const MeshAssetPN& base = data.asset;
+    data.lod_assets.clear();
+    data.lod_refs.clear();
+    data.ref = make_mesh_ref(base);
+    if (base.tri_count < kLodMinTriangles || !base.indices)
+        return;
+
+    const vec4 extent = data.bounds.local_max - data.bounds.local_min;
+    const float radius = 0.5f * std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z);
+
+    // Each level simplifies the previous one, all of them indexing the base vertex arrays
+    std::vector<std::uint32_t> prev(base.indices, base.indices + (std::size_t)base.tri_count * 3u);
+    std::uint32_t prev_tris = base.tri_count;
+    std::vector<std::uint32_t> lod_indices{};
+
+    data.lod_assets.reserve(std::size(kLodLevels));
+    for (const lod_level& level : kLodLevels)
+    {
+        const std::uint32_t target = (std::uint32_t)((float)base.tri_count * level.tri_fraction);
+        const std::uint32_t tris = simplify_mesh(lod_indices, prev.data(), prev_tris,
+            &base.positions[0].x, 4u, base.vertex_count, target, level.max_error * radius);
+        if (tris == 0 || (float)tris > (float)prev_tris * kLodMinReduction)
+            break;
+
+        optimize_vertex_cache(lod_indices.data(), tris, base.vertex_count);
+        std::vector<std::uint32_t> fetch_order(lod_indices);
+        const std::vector<std::uint32_t> remap = optimize_vertex_fetch(fetch_order.data(), tris, base.vertex_count);
+
+        std::uint32_t used = 0;
+        for (const std::uint32_t i : fetch_order)
+            used = (std::max)(used, i + 1u);
+
+        MeshAssetPN lod{};
+        lod.allocate_indexed(tris, used, base.has_uvs);
+        std::copy(fetch_order.begin(), fetch_order.end(), lod.indices);
+        for (std::uint32_t v = 0; v < base.vertex_count; ++v)
+        {
+            const std::uint32_t dst = remap[v];
+            if (dst >= used) continue;
+            lod.positions[dst] = base.positions[v];
+            lod.normals[dst] = base.normals[v];
+            if (base.has_uvs)
+            {
+                lod.uvs[dst * 2u + 0] = base.uvs[v * 2u + 0];
+                lod.uvs[dst * 2u + 1] = base.uvs[v * 2u + 1];
+            }
+        }
+        data.lod_assets.push_back(std::move(lod));
+
+        prev.swap(lod_indices);
+        prev_tris = tris;
+    }
+
+    data.lod_refs.reserve(data.lod_assets.size());
+    for (const MeshAssetPN& lod : data.lod_assets)
+    {
+        MeshRefPN r = make_mesh_ref(lod);
+        r.lod_radius_px = kLodFullDetailRadiusPx * std::sqrt((float)lod.tri_count / (float)base.tri_count);
+        data.lod_refs.push_back(r);
+    }
+    data.ref.lod_count = (std::uint8_t)data.lod_refs.size();
+    data.ref.lods = data.lod_refs.empty() ? nullptr : data.lod_refs.data();
+}
+
+void static_mesh::quantize_levels(mesh_data& data)
+{
+    // Every LOD holds its own copy of the vertices it uses, so each is quantized over its own bounds
+    for (std::size_t li = 0; li < data.lod_assets.size(); ++li)
+    {
+        data.lod_assets[li].quantize();
+        const float lod_radius_px = data.lod_refs[li].lod_radius_px;
+        data.lod_refs[li] = make_mesh_ref(data.lod_assets[li]);
+        data.lod_refs[li].lod_radius_px = lod_radius_px;
+    }
+
+    data.asset.quantize();
+    const std::uint8_t lod_count = data.ref.lod_count;
+    const MeshRefPN* lods = data.ref.lods;
+    data.ref = make_mesh_ref(data.asset);
+    data.ref.lod_count = lod_count;
+    data.ref.lods = lods;
 }
 
 void static_mesh::gather_instances(
@@ -83,13 +290,338 @@ void static_mesh::gather_instances(
         gather_instances(node->mChildren[i], global, instances, node_count);
 }
 
-bool static_mesh::load(const char* path, texture_cache* tex_cache)
+void static_mesh::resolve_textures(texture_cache* tex_cache)
+{
+    if (!tex_cache)
+        return;
+
+    // Every sub-mesh's texture is decoded at once, spread over the job system
+    std::vector<texture_request> requests{};
+    std::vector<std::size_t> owners{};
+    for (std::size_t mi = 0; mi < meshes_.size(); ++mi)
+    {
+        const mesh_data& data = meshes_[mi];
+        if (data.tex_source == texture_source::none)
+            continue;
+        texture_request r{};
+        r.key = data.tex_key;
+        if (data.tex_source == texture_source::embedded)
+        {
+            r.data = data.tex_data;
+            r.size = data.tex_size;
+        }
+        requests.push_back(std::move(r));
+        owners.push_back(mi);
+    }
+    tex_cache->load_batch(requests.data(), requests.size());
+
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+        if (requests[i].result && requests[i].result->valid())
+            meshes_[owners[i]].texture = requests[i].result;
+    }
+
+    // checkerboard for meshes with UVs but no loaded texture
+    for (mesh_data& data : meshes_)
+    {
+        if (!data.texture && data.ref.has_uvs)
+            data.texture = tex_cache->checkerboard();
+    }
+}
+
+TextureRef static_mesh::texture_ref(const mesh_data& data) noexcept
+{
+    return data.texture ? make_texture_ref(*data.texture) : TextureRef{};
+}
+
+void static_mesh::compute_bounds()
+{
+    bounds_min_ = vec4(
+        (std::numeric_limits<float>::max)(),
+        (std::numeric_limits<float>::max)(),
+        (std::numeric_limits<float>::max)(),
+        1.f
+    );
+    bounds_max_ = vec4(
+        (std::numeric_limits<float>::lowest)(),
+        (std::numeric_limits<float>::lowest)(),
+        (std::numeric_limits<float>::lowest)(),
+        1.f
+    );
+
+    for (const auto& inst : instances_)
+    {
+        if (inst.mesh_index >= meshes_.size())
+            continue;
+        const MeshRefPN& ref = meshes_[inst.mesh_index].ref;
+        for (std::uint32_t vi = 0; vi < ref.vertex_count; ++vi)
+        {
+            const vec4 wp = inst.node_world * mesh_ref_position(ref, vi);
+            update_bounds(bounds_min_, bounds_max_, wp);
+        }
+    }
+}
+
+bool static_mesh::write_baked(const std::string& baked_path, const char* source_path) const
+{
+    baked_header header{};
+    if (!source_stamp(source_path, header.source_size, header.source_time))
+        return false;
+
+    header.magic = kBakedMagic;
+    header.version = kBakedVersion;
+    header.mesh_count = (std::uint32_t)meshes_.size();
+    header.instance_count = (std::uint32_t)instances_.size();
+    header.node_count = node_count_;
+    for (int i = 0; i < 4; ++i)
+    {
+        header.bounds_min[i] = bounds_min_[i];
+        header.bounds_max[i] = bounds_max_[i];
+    }
+
+    // Tables first, then every array on its own cache line so the mapping can be used as is
+    std::vector<std::uint8_t> out(sizeof(baked_header)
+        + meshes_.size() * sizeof(baked_mesh)
+        + instances_.size() * sizeof(baked_instance));
+    const auto append = [&out](const void* src, std::size_t bytes) -> std::uint64_t
+    {
+        if (!src || bytes == 0)
+            return 0;
+        const std::size_t at = (out.size() + kBakedAlign - 1) & ~(kBakedAlign - 1);
+        out.resize(at + bytes);
+        std::memcpy(out.data() + at, src, bytes);
+        return at;
+    };
+
+    std::vector<baked_mesh> table(meshes_.size());
+    for (std::size_t mi = 0; mi < meshes_.size(); ++mi)
+    {
+        const mesh_data& data = meshes_[mi];
+        baked_mesh& bm = table[mi];
+
+        const std::size_t level_count = (std::min)(1 + data.lod_refs.size(), (std::size_t)kBakedMaxLevels);
+        for (std::size_t li = 0; li < level_count; ++li)
+        {
+            const MeshRefPN& ref = li == 0 ? data.ref : data.lod_refs[li - 1];
+            baked_level& bl = bm.levels[li];
+            bl.tri_count = ref.tri_count;
+            bl.vertex_count = ref.vertex_count;
+            bl.lod_radius_px = ref.lod_radius_px;
+            if (ref.quant)
+            {
+                bl.quant = append(ref.quant, quant_stream_bytes(ref.vertex_count));
+            }
+            else
+            {
+                bl.positions = append(ref.positions, (std::size_t)ref.vertex_count * sizeof(vec4));
+                bl.normals = append(ref.normals, (std::size_t)ref.vertex_count * sizeof(vec4));
+                if (ref.has_uvs)
+                    bl.uvs = append(ref.uvs, (std::size_t)ref.vertex_count * 2u * sizeof(float));
+            }
+            bl.indices = append(ref.indices, (std::size_t)ref.tri_count * 3u * sizeof(std::uint32_t));
+        }
+        bm.level_count = (std::uint32_t)level_count;
+        bm.has_uvs = data.ref.has_uvs ? 1u : 0u;
+
+        bm.tex_source = (std::uint32_t)data.tex_source;
+        bm.tex_key_size = (std::uint32_t)data.tex_key.size();
+        bm.tex_key = append(data.tex_key.data(), data.tex_key.size());
+        bm.tex_size = data.tex_size;
+        bm.tex_data = append(data.tex_data, data.tex_size);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            bm.local_min[i] = data.bounds.local_min[i];
+            bm.local_max[i] = data.bounds.local_max[i];
+        }
+        bm.cluster_count = data.bounds.cluster_count;
+        bm.clusters = append(data.bounds.clusters, (std::size_t)data.bounds.cluster_count * sizeof(mesh_cluster));
+    }
+
+    std::uint8_t* head = out.data();
+    std::memcpy(head, &header, sizeof(header));
+    head += sizeof(header);
+    if (!table.empty())
+        std::memcpy(head, table.data(), table.size() * sizeof(baked_mesh));
+    head += table.size() * sizeof(baked_mesh);
+    for (const mesh_instance& inst : instances_)
+    {
+        baked_instance bi{};
+        bi.mesh_index = inst.mesh_index;
+        for (unsigned int r = 0; r < 4; ++r)
+            for (unsigned int c = 0; c < 4; ++c)
+                bi.node_world[r * 4u + c] = inst.node_world(r, c);
+        std::memcpy(head, &bi, sizeof(bi));
+        head += sizeof(bi);
+    }
+
+    FileSystem file{};
+    return file.OpenForWrite(baked_path) && file.WriteBytes(out.data(), out.size());
+}
+
+bool static_mesh::load_baked(const std::string& baked_path, const char* source_path, texture_cache* tex_cache, bool quantize)
+{
+    std::uint64_t source_size = 0;
+    std::int64_t source_time = 0;
+    if (!source_stamp(source_path, source_size, source_time) || !baked_file_.MapForRead(baked_path))
+        return false;
+
+    const std::uint8_t* base = baked_file_.GetMappedData();
+    const std::uint64_t file_size = baked_file_.GetFileSize();
+    const auto in_file = [file_size](std::uint64_t offset, std::uint64_t bytes)
+    {
+        return offset <= file_size && bytes <= file_size - offset;
+    };
+    const auto fail = [this]()
+    {
+        meshes_.clear();
+        instances_.clear();
+        baked_file_.Close();
+        return false;
+    };
+
+    if (!in_file(0, sizeof(baked_header)))
+        return fail();
+    baked_header header{};
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != kBakedMagic || header.version != kBakedVersion ||
+        header.source_size != source_size || header.source_time != source_time)
+        return fail();
+
+    const std::uint64_t tables = sizeof(baked_header)
+        + (std::uint64_t)header.mesh_count * sizeof(baked_mesh)
+        + (std::uint64_t)header.instance_count * sizeof(baked_instance);
+    if (!in_file(0, tables))
+        return fail();
+
+    // Arrays are checked against the file and the alignment the renderer expects before anything points at them
+    const auto array_at = [&](std::uint64_t offset, std::uint64_t bytes) -> const void*
+    {
+        if (bytes == 0 || offset % kBakedAlign != 0 || !in_file(offset, bytes))
+            return nullptr;
+        return base + offset;
+    };
+
+    const baked_mesh* table = reinterpret_cast<const baked_mesh*>(base + sizeof(baked_header));
+    meshes_.resize(header.mesh_count);
+    for (std::uint32_t mi = 0; mi < header.mesh_count; ++mi)
+    {
+        baked_mesh bm{};
+        std::memcpy(&bm, table + mi, sizeof(bm));
+        if (bm.level_count == 0 || bm.level_count > kBakedMaxLevels)
+            return fail();
+
+        mesh_data& data = meshes_[mi];
+        const bool has_uvs = bm.has_uvs != 0;
+        MeshRefPN levels[kBakedMaxLevels]{};
+        for (std::uint32_t li = 0; li < bm.level_count; ++li)
+        {
+            const baked_level& bl = bm.levels[li];
+            MeshRefPN& r = levels[li];
+            r.tri_count = bl.tri_count;
+            r.vertex_count = bl.vertex_count;
+            r.has_uvs = has_uvs;
+            r.lod_radius_px = bl.lod_radius_px;
+            r.indices = (const std::uint32_t*)array_at(bl.indices, (std::uint64_t)bl.tri_count * 3u * sizeof(std::uint32_t));
+            if (bl.tri_count > 0 && !r.indices)
+                return fail();
+
+            // A bake in the other vertex layout is stale, the import writes one in the wanted layout
+            const bool has_vertices = bl.vertex_count > 0;
+            if (has_vertices && (bl.quant != 0) != quantize)
+                return fail();
+            if (bl.quant != 0)
+            {
+                r.quant = (const quant_stream*)array_at(bl.quant, quant_stream_bytes(bl.vertex_count));
+                if (!r.quant || r.quant->vertex_count != bl.vertex_count)
+                    return fail();
+                continue;
+            }
+
+            r.positions = (const vec4*)array_at(bl.positions, (std::uint64_t)bl.vertex_count * sizeof(vec4));
+            r.normals = (const vec4*)array_at(bl.normals, (std::uint64_t)bl.vertex_count * sizeof(vec4));
+            if (has_uvs)
+                r.uvs = (const float*)array_at(bl.uvs, (std::uint64_t)bl.vertex_count * 2u * sizeof(float));
+            if (has_vertices && (!r.positions || !r.normals || (has_uvs && !r.uvs)))
+                return fail();
+        }
+
+        data.ref = levels[0];
+        data.lod_refs.assign(levels + 1, levels + bm.level_count);
+        data.ref.lod_count = (std::uint8_t)data.lod_refs.size();
+        data.ref.lods = data.lod_refs.empty() ? nullptr : data.lod_refs.data();
+        data.bounds.local_min = vec4(bm.local_min[0], bm.local_min[1], bm.local_min[2], bm.local_min[3]);
+        data.bounds.local_max = vec4(bm.local_max[0], bm.local_max[1], bm.local_max[2], bm.local_max[3]);
+
+        // Clusters must cover the full mesh exactly, in order, for the renderer to walk them
+        const mesh_cluster* clusters = nullptr;
+        if (bm.cluster_count > 0)
+        {
+            clusters = (const mesh_cluster*)array_at(bm.clusters, (std::uint64_t)bm.cluster_count * sizeof(mesh_cluster));
+            if (!clusters)
+                return fail();
+            std::uint32_t next = 0;
+            for (std::uint32_t ci = 0; ci < bm.cluster_count; ++ci)
+            {
+                if (clusters[ci].tri_begin != next || clusters[ci].tri_count == 0)
+                    return fail();
+                next += clusters[ci].tri_count;
+            }
+            if (next != data.ref.tri_count)
+                return fail();
+        }
+        bind_clusters(data, clusters, bm.cluster_count);
+
+        data.tex_source = (texture_source)bm.tex_source;
+        if (bm.tex_key_size > 0)
+        {
+            if (!in_file(bm.tex_key, bm.tex_key_size))
+                return fail();
+            data.tex_key.assign((const char*)base + bm.tex_key, bm.tex_key_size);
+        }
+        if (bm.tex_size > 0)
+        {
+            if (!in_file(bm.tex_data, bm.tex_size))
+                return fail();
+            data.tex_data = base + bm.tex_data;
+            data.tex_size = (std::size_t)bm.tex_size;
+        }
+    }
+    resolve_textures(tex_cache);
+
+    const baked_instance* insts = reinterpret_cast<const baked_instance*>(table + header.mesh_count);
+    instances_.resize(header.instance_count);
+    for (std::uint32_t ii = 0; ii < header.instance_count; ++ii)
+    {
+        baked_instance bi{};
+        std::memcpy(&bi, insts + ii, sizeof(bi));
+        instances_[ii].mesh_index = (std::size_t)bi.mesh_index;
+        for (unsigned int r = 0; r < 4; ++r)
+            for (unsigned int c = 0; c < 4; ++c)
+                instances_[ii].node_world(r, c) = bi.node_world[r * 4u + c];
+    }
+
+    node_count_ = (std::size_t)header.node_count;
+    bounds_min_ = vec4(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2], header.bounds_min[3]);
+    bounds_max_ = vec4(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2], header.bounds_max[3]);
+    loaded_ = !instances_.empty();
+    return true;
+}
+
+bool static_mesh::load(const char* path, texture_cache* tex_cache, bool quantize)
 {
     meshes_.clear();
     instances_.clear();
+    baked_file_.Close();
+    importer_.FreeScene();
+    scene_ = nullptr;
     node_count_ = 0;
     loaded_ = false;
 
+    const std::string baked_path = std::string(path) + kBakedExtension;
+    if (load_baked(baked_path, path, tex_cache, quantize))
+        return loaded_;
+
     scene_ = importer_.ReadFile(
         path,
         aiProcess_Triangulate |
@@ -151,23 +683,23 @@ bool static_mesh::load(const char* path, texture_cache* tex_cache)
             );
         }
 
-        // Load texture from material
-        if (tex_cache && mesh_src->mMaterialIndex < scene_->mNumMaterials)
+        // Texture from material, recorded whether or not there is a cache to load it into yet
+        if (mesh_src->mMaterialIndex < scene_->mNumMaterials)
         {
             const aiMaterial* mat = scene_->mMaterials[mesh_src->mMaterialIndex];
             aiString tex_path;
             if (mat->GetTexture(aiTextureType_DIFFUSE, 0, &tex_path) == AI_SUCCESS)
             {
                 const aiTexture* embedded = scene_->GetEmbeddedTexture(tex_path.C_Str());
-                const TextureRGBA8* loaded = nullptr;
-
                 if (embedded)
                 {
                     if (embedded->mHeight == 0)
                     {
                         // Compressed embedded texture
-                        std::string key = std::string(path) + "::" + tex_path.C_Str();
-                        loaded = tex_cache->load_memory(key, embedded->pcData, embedded->mWidth);
+                        data.tex_source = texture_source::embedded;
+                        data.tex_key = std::string(path) + "::" + tex_path.C_Str();
+                        data.tex_data = reinterpret_cast<const std::uint8_t*>(embedded->pcData);
+                        data.tex_size = embedded->mWidth;
                     }
                 }
                 else
@@ -179,59 +711,24 @@ bool static_mesh::load(const char* path, texture_cache* tex_cache)
                         dir = dir.substr(0, slash + 1);
                     else
                         dir.clear();
-                    loaded = tex_cache->load_file(dir + tex_path.C_Str());
-                }
-
-                if (loaded && loaded->valid())
-                {
-                    data.tex_ref.pixels = loaded->pixels;
-                    data.tex_ref.tex_w = loaded->width;
-                    data.tex_ref.tex_h = loaded->height;
+                    data.tex_source = texture_source::file;
+                    data.tex_key = dir + tex_path.C_Str();
                 }
             }
-
-            // checkerboard for meshes with UVs but no loaded texture
-            if (!data.tex_ref.valid() && has_uvs)
-            {
-                const TextureRGBA8* checker = tex_cache->checkerboard();
-                data.tex_ref.pixels = checker->pixels;
-                data.tex_ref.tex_w = checker->width;
-                data.tex_ref.tex_h = checker->height;
-            }
         }
 
-        build_asset_from_buffers(data);
+        build_asset_from_buffers(data, quantize);
     }
+    resolve_textures(tex_cache);
 
     if (scene_->mRootNode)
         gather_instances(scene_->mRootNode, aiMatrix4x4(), instances_, node_count_);
 
-    bounds_min_ = vec4(
-        (std::numeric_limits<float>::max)(),
-        (std::numeric_limits<float>::max)(),
-        (std::numeric_limits<float>::max)(),
-        1.f
-    );
-    bounds_max_ = vec4(
-        (std::numeric_limits<float>::lowest)(),
-        (std::numeric_limits<float>::lowest)(),
-        (std::numeric_limits<float>::lowest)(),
-        1.f
-    );
-
-    for (const auto& inst : instances_)
-    {
-        if (inst.mesh_index >= meshes_.size())
-            continue;
-        const auto& data = meshes_[inst.mesh_index];
-        for (const auto& p : data.positions)
-        {
-            const vec4 wp = inst.node_world * p;
-            update_bounds(bounds_min_, bounds_max_, wp);
-        }
-    }
+    compute_bounds();
 
     loaded_ = !instances_.empty();
+    if (loaded_ && !write_baked(baked_path, path))
+        std::printf("static_mesh: could not write %s\n", baked_path.c_str());
     return loaded_;
 }
 
@@ -267,29 +764,74 @@ void static_mesh::build_instances(
     if (!loaded_)
         return;
 
+    std::vector<MeshRefPN>  refs;
+    std::vector<Bounds>     bounds;
+    std::vector<matrix>     worlds;
+    std::vector<TextureRef> texs;
+    refs.reserve(instances_.size());
+    bounds.reserve(instances_.size());
+    worlds.reserve(instances_.size());
+    texs.reserve(instances_.size());
+
+    out_locals.reserve(out_locals.size() + instances_.size());
+    for (const auto& inst : instances_)
+    {
+        if (inst.mesh_index >= meshes_.size())
+            continue;
+        const mesh_data& m = meshes_[inst.mesh_index];
+        refs.push_back(m.ref);
+        bounds.push_back(m.bounds);
+        worlds.push_back(base_world * inst.node_world);
+        texs.push_back(texture_ref(m));
+        out_locals.push_back(inst.node_world);
+    }
+
+    spawn_instances(w, refs, bounds, worlds, texs, col, ka, kd, out_entities);
+}
+
+void static_mesh::gather_instance_rows(const matrix& base_world, std::vector<instance_row>& out) const
+{
+    if (!loaded_)
+        return;
+
+    out.reserve(out.size() + instances_.size());
+    for (const auto& inst : instances_)
     {
-        std::vector<fecs::component_id> ids{
-            w.registry().get_id<MeshRefPN>(),
-            w.registry().get_id<Transform>(),
-            w.registry().get_id<Material>(),
-            w.registry().get_id<TextureRef>()
-        };
-        const fecs::table_id tid = w.storage().get_or_create_table(fecs::make_archetype_key(std::move(ids)));
-        fecs::table& table = w.storage().get_table(tid);
-        table.reserve(table.size() + instances_.size());
+        if (inst.mesh_index >= meshes_.size())
+            continue;
+        const mesh_data& m = meshes_[inst.mesh_index];
+        instance_row row{};
+        row.ref = m.ref;
+        row.bounds = m.bounds;
+        row.tex = texture_ref(m);
+        row.world = base_world * inst.node_world;
+        row.local = inst.node_world;
+        out.push_back(row);
     }
+}
+
+void static_mesh::build_instanced(
+    fecs::world& w,
+    const std::vector<matrix>& base_worlds,
+    const colour& col,
+    float ka,
+    float kd,
+    std::vector<fecs::entity>& out_entities)
+{
+    if (!loaded_ || base_worlds.empty())
+        return;
 
+    std::vector<matrix> worlds(base_worlds.size());
     out_entities.reserve(out_entities.size() + instances_.size());
-    out_locals.reserve(out_locals.size() + instances_.size());
     for (const auto& inst : instances_)
     {
         if (inst.mesh_index >= meshes_.size())
             continue;
-        const matrix world = base_world * inst.node_world;
-        const fecs::entity e = spawn_instance(w, meshes_[inst.mesh_index].asset, world, col, ka, kd,
-                                               meshes_[inst.mesh_index].tex_ref);
-        out_entities.push_back(e);
-        out_locals.push_back(inst.node_world);
+        for (std::size_t i = 0; i < base_worlds.size(); ++i)
+            worlds[i] = base_worlds[i] * inst.node_world;
+
+        const auto& m = meshes_[inst.mesh_index];
+        out_entities.push_back(spawn_instanced(w, m.ref, m.bounds, worlds.data(), worlds.size(), col, ka, kd, texture_ref(m)));
     }
 }
 
@@ -300,3 +842,15 @@ bool static_mesh::sample_node_world(matrix& out) const noexcept
     out = instances_[0].node_world;
     return true;
 }
+
+std::size_t static_mesh::resident_bytes() const noexcept
+{
+    std::size_t bytes = 0;
+    for (const mesh_data& data : meshes_)
+    {
+        bytes += mesh_ref_bytes(data.ref);
+        for (const MeshRefPN& lod : data.lod_refs)
+            bytes += mesh_ref_bytes(lod);
+    }
+    return bytes;
+}
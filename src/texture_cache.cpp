@@ -1,8 +1,13 @@
 #include "texture_cache.h"
+#include "file_system.h"
+#include "optimized/job_system.h"
+#include "optimized/memory_stats.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <cmath>
+#include <utility>
 
 #include <windows.h>
 #include <wincodec.h>
@@ -43,27 +48,356 @@ namespace
             return false;
         }
 
-        auto* pixels = new std::uint32_t[(std::size_t)w * (std::size_t)h];
+        std::vector<std::uint32_t> pixels((std::size_t)w * (std::size_t)h);
         hr = converter->CopyPixels(
             nullptr,
             w * 4u,
             w * h * 4u,
-            reinterpret_cast<BYTE*>(pixels));
+            reinterpret_cast<BYTE*>(pixels.data()));
 
         converter->Release();
 
         if (FAILED(hr))
+            return false;
+
+        out.build_mip_chain(pixels.data(), w, h);
+        return out.valid();
+    }
+
+    bool decode_wic_memory(const void* data, std::size_t size, TextureRGBA8& out)
+    {
+        com_init_guard com;
+
+        IWICImagingFactory* factory = nullptr;
+        HRESULT hr = CoCreateInstance(
+            CLSID_WICImagingFactory,
+            nullptr,
+            CLSCTX_INPROC_SERVER,
+            IID_PPV_ARGS(&factory));
+
+        if (FAILED(hr) || !factory) return false;
+
+        IWICStream* stream = nullptr;
+        hr = factory->CreateStream(&stream);
+        if (FAILED(hr) || !stream)
+        {
+            factory->Release();
+            return false;
+        }
+
+        hr = stream->InitializeFromMemory(
+            static_cast<BYTE*>(const_cast<void*>(data)),
+            static_cast<DWORD>(size));
+
+        if (FAILED(hr))
+        {
+            stream->Release();
+            factory->Release();
+            return false;
+        }
+
+        IWICBitmapDecoder* decoder = nullptr;
+        hr = factory->CreateDecoderFromStream(
+            stream,
+            nullptr,
+            WICDecodeMetadataCacheOnDemand,
+            &decoder);
+
+        if (FAILED(hr) || !decoder)
         {
-            delete[] pixels;
+            stream->Release();
+            factory->Release();
             return false;
         }
 
-        out.pixels = pixels;
-        out.width  = w;
-        out.height = h;
-        out.owned  = true;
-        return true;
+        IWICBitmapFrameDecode* frame = nullptr;
+        hr = decoder->GetFrame(0, &frame);
+
+        if (FAILED(hr) || !frame)
+        {
+            decoder->Release();
+            stream->Release();
+            factory->Release();
+            return false;
+        }
+
+        const bool ok = decode_wic(factory, frame, out);
+
+        frame->Release();
+        decoder->Release();
+        stream->Release();
+        factory->Release();
+        return ok;
     }
+
+    // FNV-1a over the compressed bytes; identical images share one disk cache entry whatever their key
+    std::uint64_t content_hash(const void* data, std::size_t size) noexcept
+    {
+        const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+        std::uint64_t h = 14695981039346656037ull;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    constexpr std::uint32_t kDiskCacheMagic   = 0x58455446u; // "FTEX"
+    constexpr std::uint32_t kDiskCacheVersion = 2;
+
+    struct disk_cache_header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint64_t texel_count;
+        std::uint32_t format;   // texture_format
+        std::uint32_t reserved;
+    };
+
+    inline std::uint32_t to_rgb565(int r, int g, int b) noexcept
+    {
+        return ((std::uint32_t)((r * 31 + 127) / 255) << 11) |
+               ((std::uint32_t)((g * 63 + 127) / 255) << 5) |
+                (std::uint32_t)((b * 31 + 127) / 255);
+    }
+
+    // Bounding box endpoints inset by a sixteenth, laid along whichever diagonal of the box the
+    // colours spread on, then the nearest of the four palette entries for each texel
+    void encode_bc1_block(const std::uint32_t (&texels)[16], std::uint32_t* block) noexcept
+    {
+        int lo[3]{ 255, 255, 255 };
+        int hi[3]{ 0, 0, 0 };
+        for (const std::uint32_t t : texels)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                const int v = (int)((t >> (8 * c)) & 0xFFu);
+                lo[c] = (std::min)(lo[c], v);
+                hi[c] = (std::max)(hi[c], v);
+            }
+        }
+
+        int cov_g = 0, cov_b = 0;
+        for (const std::uint32_t t : texels)
+        {
+            const int dr = (int)(t & 0xFFu) * 2 - (lo[0] + hi[0]);
+            cov_g += dr * ((int)((t >> 8) & 0xFFu) * 2 - (lo[1] + hi[1]));
+            cov_b += dr * ((int)((t >> 16) & 0xFFu) * 2 - (lo[2] + hi[2]));
+        }
+        if (cov_g < 0) std::swap(lo[1], hi[1]);
+        if (cov_b < 0) std::swap(lo[2], hi[2]);
+        for (int c = 0; c < 3; ++c)
+        {
+            const int inset = (hi[c] - lo[c]) / 16;
+            hi[c] -= inset;
+            lo[c] += inset;
+        }
+
+        std::uint32_t e0 = to_rgb565(hi[0], hi[1], hi[2]);
+        std::uint32_t e1 = to_rgb565(lo[0], lo[1], lo[2]);
+        if (e0 < e1)
+            std::swap(e0, e1);
+        block[0] = e0 | (e1 << 16);
+        block[1] = 0;
+        if (e0 == e1)
+            return;
+
+        // Indices 0..3 on the first four texels give the palette as the sampler decodes it
+        const std::uint32_t probe[2] = { block[0], 0xE4u };
+        std::uint32_t palette[4];
+        for (std::uint32_t i = 0; i < 4; ++i)
+            palette[i] = bc1_decode_texel(probe, i);
+
+        for (std::uint32_t i = 0; i < 16; ++i)
+        {
+            std::uint32_t best = 0;
+            int best_d = 0x7FFFFFFF;
+            for (std::uint32_t p = 0; p < 4; ++p)
+            {
+                int d = 0;
+                for (int c = 0; c < 3; ++c)
+                {
+                    const int delta = (int)((texels[i] >> (8 * c)) & 0xFFu) - (int)((palette[p] >> (8 * c)) & 0xFFu);
+                    d += delta * delta;
+                }
+                if (d < best_d)
+                {
+                    best_d = d;
+                    best = p;
+                }
+            }
+            block[1] |= best << (i * 2u);
+        }
+    }
+
+    inline std::uint32_t average_rgba8(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d) noexcept
+    {
+        std::uint32_t out = 0;
+        for (std::uint32_t shift = 0; shift < 32; shift += 8)
+        {
+            const std::uint32_t sum = ((a >> shift) & 0xFFu) + ((b >> shift) & 0xFFu) +
+                                      ((c >> shift) & 0xFFu) + ((d >> shift) & 0xFFu);
+            out |= ((sum + 2u) >> 2) << shift;
+        }
+        return out;
+    }
+}
+
+void TextureRGBA8::build_mip_chain(const std::uint32_t* rgba, std::uint32_t w, std::uint32_t h)
+{
+    destroy();
+    if (!rgba || w == 0 || h == 0)
+        return;
+
+    std::uint32_t levels = 0;
+    const std::size_t total = mip_layout(w, h, mip_offsets, levels);
+
+    pixels = new std::uint32_t[total]{};
+    width = w;
+    height = h;
+    owned = true;
+    mip_count = levels;
+    pow2 = is_pow2(w) && is_pow2(h);
+    texel_count = total;
+
+    std::vector<std::uint32_t> src(rgba, rgba + (std::size_t)w * (std::size_t)h);
+    std::vector<std::uint32_t> dst{};
+    for (std::uint32_t l = 0; l < levels; ++l)
+    {
+        const std::uint32_t lw = mip_extent(w, l);
+        const std::uint32_t lh = mip_extent(h, l);
+        const std::uint32_t tiles_x = (lw + kTextureTile - 1) / kTextureTile;
+
+        std::uint32_t* level = pixels + mip_offsets[l];
+        for (std::uint32_t y = 0; y < lh; ++y)
+            for (std::uint32_t x = 0; x < lw; ++x)
+                level[tiled_texel_index(x, y, tiles_x)] = src[(std::size_t)y * lw + x];
+
+        if (l + 1 == levels)
+            break;
+
+        // Odd extents clamp the second tap onto the edge texel
+        const std::uint32_t nw = mip_extent(w, l + 1);
+        const std::uint32_t nh = mip_extent(h, l + 1);
+        dst.resize((std::size_t)nw * nh);
+        for (std::uint32_t y = 0; y < nh; ++y)
+        {
+            const std::size_t r0 = (std::size_t)(std::min)(y * 2u, lh - 1u) * lw;
+            const std::size_t r1 = (std::size_t)(std::min)(y * 2u + 1u, lh - 1u) * lw;
+            for (std::uint32_t x = 0; x < nw; ++x)
+            {
+                const std::uint32_t x0 = (std::min)(x * 2u, lw - 1u);
+                const std::uint32_t x1 = (std::min)(x * 2u + 1u, lw - 1u);
+                dst[(std::size_t)y * nw + x] = average_rgba8(src[r0 + x0], src[r0 + x1], src[r1 + x0], src[r1 + x1]);
+            }
+        }
+        src.swap(dst);
+    }
+}
+
+std::size_t TextureRGBA8::mip_layout(std::uint32_t w, std::uint32_t h,
+                                     std::uint32_t (&offsets)[kMaxMipLevels], std::uint32_t& levels) noexcept
+{
+    levels = 1;
+    while (levels < kMaxMipLevels && (mip_extent(w, levels - 1) > 1 || mip_extent(h, levels - 1) > 1))
+        ++levels;
+
+    std::size_t total = 0;
+    for (std::uint32_t l = 0; l < levels; ++l)
+    {
+        const std::size_t tiles_x = (mip_extent(w, l) + kTextureTile - 1) / kTextureTile;
+        const std::size_t tiles_y = (mip_extent(h, l) + kTextureTile - 1) / kTextureTile;
+        offsets[l] = (std::uint32_t)total;
+        total += tiles_x * tiles_y * kTextureTile * kTextureTile;
+    }
+    return total;
+}
+
+void TextureRGBA8::adopt_mip_chain(std::uint32_t* chain, std::uint32_t w, std::uint32_t h,
+                                   texture_format chain_format) noexcept
+{
+    destroy();
+    if (!chain || w == 0 || h == 0)
+        return;
+
+    texel_count = mip_layout(w, h, mip_offsets, mip_count);
+    pixels = chain;
+    width = w;
+    height = h;
+    owned = true;
+    pow2 = is_pow2(w) && is_pow2(h);
+    format = chain_format;
+}
+
+bool TextureRGBA8::compress_bc1()
+{
+    if (!owned || !pixels || format != texture_format::rgba8)
+        return false;
+
+    std::uint32_t* blocks = new std::uint32_t[chain_words(texture_format::bc1, texel_count)];
+    for (std::uint32_t l = 0; l < mip_count; ++l)
+    {
+        const std::uint32_t lw = mip_extent(width, l);
+        const std::uint32_t lh = mip_extent(height, l);
+        const std::uint32_t tiles_x = (lw + kTextureTile - 1) / kTextureTile;
+        const std::uint32_t tiles_y = (lh + kTextureTile - 1) / kTextureTile;
+        const std::uint32_t* level = pixels + mip_offsets[l];
+        std::uint32_t* out = blocks + mip_offsets[l] / 8u;
+
+        for (std::uint32_t ty = 0; ty < tiles_y; ++ty)
+        {
+            for (std::uint32_t tx = 0; tx < tiles_x; ++tx)
+            {
+                // Padding past the edge of a small level repeats the edge, so it cannot pull the endpoints
+                const std::uint32_t* tile = level + ((std::size_t)ty * tiles_x + tx) * 16u;
+                std::uint32_t texels[16];
+                for (std::uint32_t y = 0; y < 4; ++y)
+                {
+                    const std::uint32_t sy = (std::min)(ty * 4u + y, lh - 1u) - ty * 4u;
+                    for (std::uint32_t x = 0; x < 4; ++x)
+                    {
+                        const std::uint32_t sx = (std::min)(tx * 4u + x, lw - 1u) - tx * 4u;
+                        texels[(y << 2) + x] = tile[(sy << 2) + sx];
+                    }
+                }
+                encode_bc1_block(texels, out + ((std::size_t)ty * tiles_x + tx) * 2u);
+            }
+        }
+    }
+
+    delete[] pixels;
+    pixels = blocks;
+    format = texture_format::bc1;
+    return true;
+}
+
+std::uint32_t* TextureRGBA8::drop_top_mip()
+{
+    if (!owned || !pixels || mip_count <= 1)
+        return nullptr;
+
+    // Below the top, the chain of a w/2 x h/2 texture is exactly the old one from level 1 on
+    const std::size_t skip = mip_offsets[1];
+    const std::size_t total = texel_count - skip;
+    const std::size_t words = chain_words(format, total);
+    std::uint32_t* chain = new std::uint32_t[words];
+    std::memcpy(chain, pixels + chain_words(format, skip), words * sizeof(std::uint32_t));
+
+    std::uint32_t* old = pixels;
+    for (std::uint32_t l = 1; l < mip_count; ++l)
+        mip_offsets[l - 1] = mip_offsets[l] - (std::uint32_t)skip;
+    mip_offsets[mip_count - 1] = 0;
+
+    pixels = chain;
+    width = mip_extent(width, 1);
+    height = mip_extent(height, 1);
+    mip_count -= 1;
+    pow2 = is_pow2(width) && is_pow2(height);
+    texel_count = total;
+    return old;
 }
 
 texture_cache::texture_cache()
@@ -71,7 +405,10 @@ texture_cache::texture_cache()
     generate_checkerboard();
 }
 
-texture_cache::~texture_cache() = default;
+texture_cache::~texture_cache()
+{
+    fox::mem_track_free(fox::mem_tag::textures, resident_bytes_);
+}
 
 void texture_cache::generate_checkerboard() noexcept
 {
@@ -79,7 +416,7 @@ void texture_cache::generate_checkerboard() noexcept
     constexpr std::uint32_t H = 64;
     constexpr std::uint32_t CHECK = 8;
 
-    auto* pixels = new std::uint32_t[W * H];
+    std::vector<std::uint32_t> pixels(W * H);
 
     constexpr std::uint32_t C0 = 0xFF00FF00 | 0xFF;
     constexpr std::uint32_t MAGENTA = (255u << 24) | (255u << 16) | (0u << 8) | 255u; // A=FF B=FF G=00 R=FF
@@ -94,84 +431,32 @@ void texture_cache::generate_checkerboard() noexcept
         }
     }
 
-    checkerboard_.pixels = pixels;
-    checkerboard_.width  = W;
-    checkerboard_.height = H;
-    checkerboard_.owned  = true;
+    checkerboard_.build_mip_chain(pixels.data(), W, H);
 }
 
 const TextureRGBA8* texture_cache::load_file(const std::string& path)
 {
     if (path.empty()) return nullptr;
 
-    auto it = cache_.find(path);
-    if (it != cache_.end())
-        return it->second.get();
-
-    com_init_guard com;
+    if (const TextureRGBA8* cached = get(path))
+        return cached;
 
-    IWICImagingFactory* factory = nullptr;
-    HRESULT hr = CoCreateInstance(
-        CLSID_WICImagingFactory,
-        nullptr,
-        CLSCTX_INPROC_SERVER,
-        IID_PPV_ARGS(&factory));
-
-    if (FAILED(hr) || !factory)
-    {
-        std::printf("texture_cache: failed to create WIC factory\n");
-        return nullptr;
-    }
-
-    // Convert path to wide string
-    const int wlen = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
-    std::wstring wpath(wlen, L'\0');
-    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wpath.data(), wlen);
-
-    IWICBitmapDecoder* decoder = nullptr;
-    hr = factory->CreateDecoderFromFilename(
-        wpath.c_str(),
-        nullptr,
-        GENERIC_READ,
-        WICDecodeMetadataCacheOnDemand,
-        &decoder);
-
-    if (FAILED(hr) || !decoder)
+    FileSystem file{};
+    if (!file.OpenForRead(path))
     {
-        factory->Release();
-        std::printf("texture_cache: failed to decode file %s\n", path.c_str());
+        std::printf("texture_cache: failed to open file %s\n", path.c_str());
         return nullptr;
     }
 
-    IWICBitmapFrameDecode* frame = nullptr;
-    hr = decoder->GetFrame(0, &frame);
-
-    if (FAILED(hr) || !frame)
+    std::vector<std::uint8_t> bytes(file.GetFileSize());
+    if (bytes.empty() || !file.ReadBytes(bytes.data(), bytes.size()))
     {
-        decoder->Release();
-        factory->Release();
+        std::printf("texture_cache: failed to read file %s\n", path.c_str());
         return nullptr;
     }
+    file.Close();
 
-    auto tex = std::make_unique<TextureRGBA8>();
-    const bool ok = decode_wic(factory, frame, *tex);
-
-    frame->Release();
-    decoder->Release();
-    factory->Release();
-
-    if (!ok)
-    {
-        std::printf("texture_cache: failed to convert %s\n", path.c_str());
-        return nullptr;
-    }
-
-    std::printf("texture_cache: loaded %s (%ux%u)\n",
-                path.c_str(), tex->width, tex->height);
-
-    const TextureRGBA8* ptr = tex.get();
-    cache_.emplace(path, std::move(tex));
-    return ptr;
+    return decode(path, bytes.data(), bytes.size());
 }
 
 const TextureRGBA8* texture_cache::load_memory(
@@ -181,85 +466,236 @@ const TextureRGBA8* texture_cache::load_memory(
 {
     if (!data || size == 0) return nullptr;
 
-    auto it = cache_.find(key);
-    if (it != cache_.end())
-        return it->second.get();
+    if (const TextureRGBA8* cached = get(key))
+        return cached;
+
+    return decode(key, data, size);
+}
 
-    com_init_guard com;
+void texture_cache::load_batch(texture_request* requests, std::size_t count)
+{
+    fox::job_system::instance().parallel_for((std::uint32_t)count, 1, [this, requests](std::uint32_t b, std::uint32_t e)
+    {
+        for (std::uint32_t i = b; i < e; ++i)
+        {
+            texture_request& r = requests[i];
+            r.result = r.data ? load_memory(r.key, r.data, r.size) : load_file(r.key);
+        }
+    });
+}
 
-    IWICImagingFactory* factory = nullptr;
-    HRESULT hr = CoCreateInstance(
-        CLSID_WICImagingFactory,
-        nullptr,
-        CLSCTX_INPROC_SERVER,
-        IID_PPV_ARGS(&factory));
+const TextureRGBA8* texture_cache::decode(const std::string& key, const void* data, std::size_t size)
+{
+    const std::uint64_t hash = content_hash(data, size);
 
-    if (FAILED(hr) || !factory) return nullptr;
+    const texture_format format = residency_format();
 
-    IWICStream* stream = nullptr;
-    hr = factory->CreateStream(&stream);
-    if (FAILED(hr) || !stream)
+    auto tex = std::make_unique<TextureRGBA8>();
+    if (read_disk_cache(hash, format, *tex))
     {
-        factory->Release();
-        return nullptr;
+        std::printf("texture_cache: loaded %s from disk cache (%ux%u)\n",
+                    key.c_str(), tex->width, tex->height);
+        return insert(key, std::move(tex));
     }
 
-    hr = stream->InitializeFromMemory(
-        static_cast<BYTE*>(const_cast<void*>(data)),
-        static_cast<DWORD>(size));
-
-    if (FAILED(hr))
+    if (!decode_wic_memory(data, size, *tex))
     {
-        stream->Release();
-        factory->Release();
+        std::printf("texture_cache: failed to decode %s\n", key.c_str());
         return nullptr;
     }
 
-    IWICBitmapDecoder* decoder = nullptr;
-    hr = factory->CreateDecoderFromStream(
-        stream,
-        nullptr,
-        WICDecodeMetadataCacheOnDemand,
-        &decoder);
+    if (format == texture_format::bc1)
+        tex->compress_bc1();
 
-    if (FAILED(hr) || !decoder)
-    {
-        stream->Release();
-        factory->Release();
-        return nullptr;
-    }
+    std::printf("texture_cache: loaded %s (%ux%u)\n",
+                key.c_str(), tex->width, tex->height);
 
-    IWICBitmapFrameDecode* frame = nullptr;
-    hr = decoder->GetFrame(0, &frame);
+    write_disk_cache(hash, *tex);
+    return insert(key, std::move(tex));
+}
 
-    if (FAILED(hr) || !frame)
+const TextureRGBA8* texture_cache::insert(const std::string& key, std::unique_ptr<TextureRGBA8> tex)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto [it, inserted] = cache_.try_emplace(key);
+    if (inserted)
     {
-        decoder->Release();
-        stream->Release();
-        factory->Release();
-        return nullptr;
+        resident_bytes_ += tex->resident_bytes();
+        fox::mem_track_alloc(fox::mem_tag::textures, tex->resident_bytes());
+        it->second.tex = std::move(tex);
     }
+    it->second.last_use = ++use_clock_;
+    return it->second.tex.get();
+}
 
-    auto tex = std::make_unique<TextureRGBA8>();
-    const bool ok = decode_wic(factory, frame, *tex);
+const TextureRGBA8* texture_cache::get(const std::string& key) const
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = cache_.find(key);
+    if (it == cache_.end())
+        return nullptr;
+    it->second.last_use = ++use_clock_;
+    return it->second.tex.get();
+}
 
-    frame->Release();
-    decoder->Release();
-    stream->Release();
-    factory->Release();
+std::string texture_cache::disk_cache_path(std::uint64_t hash) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.foxtex", (unsigned long long)hash);
+    return disk_dir_ + name;
+}
 
-    if (!ok) return nullptr;
+bool texture_cache::read_disk_cache(std::uint64_t hash, texture_format format, TextureRGBA8& out) const
+{
+    if (disk_dir_.empty())
+        return false;
+
+    FileSystem file{};
+    if (!file.OpenForRead(disk_cache_path(hash)))
+        return false;
+
+    disk_cache_header header{};
+    if (!file.ReadBytes(&header, sizeof(header)) ||
+        header.magic != kDiskCacheMagic || header.version != kDiskCacheVersion ||
+        header.width == 0 || header.height == 0)
+        return false;
+
+    // An rgba8 entry compresses on the way in; a bc1 one cannot give the texels back, so it is
+    // decoded again and the entry rewritten
+    const texture_format stored = (texture_format)header.format;
+    if ((stored != texture_format::rgba8 && stored != texture_format::bc1) ||
+        (stored == texture_format::bc1 && format != texture_format::bc1))
+        return false;
+
+    // A short or mismatched file, e.g. from an interrupted write, is decoded again
+    std::uint32_t offsets[kMaxMipLevels]{};
+    std::uint32_t levels = 0;
+    const std::size_t total = TextureRGBA8::mip_layout(header.width, header.height, offsets, levels);
+    const std::size_t words = chain_words(stored, total);
+    if (header.texel_count != total ||
+        file.GetFileSize() != sizeof(header) + words * sizeof(std::uint32_t))
+        return false;
+
+    std::unique_ptr<std::uint32_t[]> chain(new std::uint32_t[words]);
+    if (!file.ReadBytes(chain.get(), words * sizeof(std::uint32_t)))
+        return false;
+
+    out.adopt_mip_chain(chain.release(), header.width, header.height, stored);
+    if (format == texture_format::bc1)
+        out.compress_bc1();
+    return out.valid();
+}
 
-    std::printf("texture_cache: loaded from memory key=%s (%ux%u)\n",
-                key.c_str(), tex->width, tex->height);
+void texture_cache::write_disk_cache(std::uint64_t hash, const TextureRGBA8& tex) const
+{
+    if (disk_dir_.empty() || !tex.valid())
+        return;
+
+    FileSystem file{};
+    if (!file.OpenForWrite(disk_cache_path(hash)))
+        return;
+
+    const disk_cache_header header{ kDiskCacheMagic, kDiskCacheVersion, tex.width, tex.height, tex.texel_count,
+                                    (std::uint32_t)tex.format, 0u };
+    if (!file.WriteBytes(&header, sizeof(header)) ||
+        !file.WriteBytes(tex.pixels, tex.resident_bytes()))
+        std::printf("texture_cache: failed to write disk cache entry %016llx\n", (unsigned long long)hash);
+}
 
-    const TextureRGBA8* ptr = tex.get();
-    cache_.emplace(key, std::move(tex));
-    return ptr;
+void texture_cache::set_disk_cache_dir(const std::string& dir)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    disk_dir_ = dir;
+    if (!disk_dir_.empty() && disk_dir_.back() != '/' && disk_dir_.back() != '\\')
+        disk_dir_ += '/';
 }
 
-const TextureRGBA8* texture_cache::get(const std::string& key) const
+void texture_cache::set_residency_format(texture_format format) noexcept
 {
-    auto it = cache_.find(key);
-    return (it != cache_.end()) ? it->second.get() : nullptr;
+    std::lock_guard<std::mutex> lk(mtx_);
+    format_ = format;
+}
+
+texture_format texture_cache::residency_format() const noexcept
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    return format_;
+}
+
+void texture_cache::set_memory_budget(std::size_t bytes) noexcept
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    budget_bytes_ = bytes;
+}
+
+std::size_t texture_cache::memory_budget() const noexcept
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    return budget_bytes_;
+}
+
+std::size_t texture_cache::resident_bytes() const noexcept
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    return resident_bytes_;
+}
+
+bool texture_cache::over_budget() const noexcept
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    return budget_bytes_ != 0 && resident_bytes_ > budget_bytes_;
+}
+
+std::size_t texture_cache::trim_to_budget(std::vector<texture_trim>& out)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (budget_bytes_ == 0 || resident_bytes_ <= budget_bytes_)
+        return 0;
+
+    std::vector<const entry*> order{};
+    order.reserve(cache_.size());
+    for (const auto& [key, e] : cache_)
+        order.push_back(&e);
+    std::sort(order.begin(), order.end(), [](const entry* a, const entry* b)
+    {
+        return a->last_use < b->last_use;
+    });
+
+    // One level at a time across the LRU order, so recently used textures keep the most detail
+    const std::size_t first = out.size();
+    bool progress = true;
+    while (resident_bytes_ > budget_bytes_ && progress)
+    {
+        progress = false;
+        for (const entry* e : order)
+        {
+            TextureRGBA8& tex = *e->tex;
+            if (tex.width <= kMinTrimExtent && tex.height <= kMinTrimExtent)
+                continue;
+
+            const std::size_t before = tex.resident_bytes();
+            std::uint32_t* old = tex.drop_top_mip();
+            if (!old)
+                continue;
+
+            const bool seen = std::any_of(out.begin() + (std::ptrdiff_t)first, out.end(),
+                [&tex](const texture_trim& t) { return t.texture == &tex; });
+            if (!seen)
+                out.push_back({ old, &tex });
+            retired_.emplace_back(old);
+
+            resident_bytes_ -= before - tex.resident_bytes();
+            fox::mem_track_free(fox::mem_tag::textures, before - tex.resident_bytes());
+            progress = true;
+            if (resident_bytes_ <= budget_bytes_)
+                break;
+        }
+    }
+    return out.size() - first;
+}
+
+void texture_cache::release_retired() noexcept
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    retired_.clear();
 }
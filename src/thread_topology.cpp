@@ -0,0 +1,147 @@
+#include "optimized/thread_topology.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+    static inline int native_priority(fox::thread_priority p) noexcept
+    {
+        switch (p)
+        {
+            case fox::thread_priority::above_normal:  return THREAD_PRIORITY_ABOVE_NORMAL;
+            case fox::thread_priority::highest:       return THREAD_PRIORITY_HIGHEST;
+            case fox::thread_priority::time_critical: return THREAD_PRIORITY_TIME_CRITICAL;
+            default:                                  return THREAD_PRIORITY_NORMAL;
+        }
+    }
+
+    // First logical processor of every physical core, then the second of each, and so on; within a
+    // rank the faster efficiency class comes first
+    static inline std::vector<std::uint32_t> cores_first(const std::vector<fox::cpu_core>& cores) noexcept
+    {
+        std::vector<std::uint32_t> rank(cores.size(), 0);
+        for (std::size_t i = 0; i < cores.size(); ++i)
+            for (std::size_t j = 0; j < i; ++j)
+                if (cores[j].group == cores[i].group && cores[j].core_index == cores[i].core_index)
+                    ++rank[i];
+
+        std::vector<std::size_t> order(cores.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+        {
+            if (rank[a] != rank[b])
+                return rank[a] < rank[b];
+            return cores[a].efficiency_class > cores[b].efficiency_class;
+        });
+
+        std::vector<std::uint32_t> ids;
+        ids.reserve(cores.size());
+        for (const std::size_t i : order)
+            ids.push_back(cores[i].cpu_set_id);
+        return ids;
+    }
+}
+
+namespace fox
+{
+    thread_topology& thread_topology::instance() noexcept
+    {
+        static thread_topology t;
+        return t;
+    }
+
+    thread_topology::thread_topology() noexcept
+    {
+        ULONG bytes = 0;
+        GetSystemCpuSetInformation(nullptr, 0, &bytes, GetCurrentProcess(), 0);
+        if (bytes == 0) return;
+
+        std::unique_ptr<std::uint8_t[]> buf(new (std::nothrow) std::uint8_t[bytes]);
+        if (!buf) return;
+        if (!GetSystemCpuSetInformation(reinterpret_cast<PSYSTEM_CPU_SET_INFORMATION>(buf.get()), bytes, &bytes, GetCurrentProcess(), 0))
+            return;
+
+        for (ULONG off = 0; off < bytes;)
+        {
+            const auto* info = reinterpret_cast<const SYSTEM_CPU_SET_INFORMATION*>(buf.get() + off);
+            if (info->Size == 0) break;
+            off += info->Size;
+
+            if (info->Type != CpuSetInformation || info->CpuSet.Parked) continue;
+
+            cpu_core c{};
+            c.cpu_set_id       = info->CpuSet.Id;
+            c.group            = info->CpuSet.Group;
+            c.logical_index    = info->CpuSet.LogicalProcessorIndex;
+            c.core_index       = info->CpuSet.CoreIndex;
+            c.efficiency_class = info->CpuSet.EfficiencyClass;
+            m_cores.push_back(c);
+        }
+        if (m_cores.empty()) return;
+
+        const auto [lo, hi] = std::minmax_element(m_cores.begin(), m_cores.end(),
+            [](const cpu_core& a, const cpu_core& b) { return a.efficiency_class < b.efficiency_class; });
+        const std::uint8_t top = hi->efficiency_class;
+        m_hybrid = lo->efficiency_class != top;
+
+        std::vector<cpu_core> fast;
+        for (const cpu_core& c : m_cores)
+            if (c.efficiency_class == top)
+                fast.push_back(c);
+
+        m_all = cores_first(m_cores);
+        m_performance = cores_first(fast);
+    }
+
+    void thread_topology::apply(std::thread& t, thread_role role, std::uint32_t index) const noexcept
+    {
+        if (t.joinable())
+            apply_native((void*)t.native_handle(), role, index);
+    }
+
+    void thread_topology::apply_current(thread_role role, std::uint32_t index) const noexcept
+    {
+        apply_native(GetCurrentThread(), role, index);
+    }
+
+    void thread_topology::apply_native(void* handle, thread_role role, std::uint32_t index) const noexcept
+    {
+        const HANDLE h = static_cast<HANDLE>(handle);
+        const thread_layout& l = m_layout;
+
+        const std::uint32_t* ids = nullptr;
+        std::size_t count = 0;
+        thread_priority prio = thread_priority::normal;
+
+        switch (role)
+        {
+            case thread_role::worker:
+            {
+                // Workers number one fewer than the logical processors, the rest is the submitting
+                // thread's, so worker i takes the (i + 1)-th and the first core stays with the caller
+                const std::vector<std::uint32_t>& pool = (l.workers_on_performance && m_hybrid) ? m_performance : m_all;
+                if (!pool.empty())
+                {
+                    if (l.workers_one_per_core) { ids = &pool[(index + 1) % pool.size()]; count = 1; }
+                    else                        { ids = pool.data(); count = pool.size(); }
+                }
+                prio = l.worker_priority;
+                break;
+            }
+            case thread_role::present:
+                // Preemption here shows up as a missed vblank, so it stays off the slow cores
+                ids = m_performance.data();
+                count = m_performance.size();
+                prio = l.present_priority;
+                break;
+        }
+
+        if (!m_cores.empty())
+            SetThreadSelectedCpuSets(h, reinterpret_cast<const ULONG*>(ids), (ULONG)count);
+        SetThreadPriority(h, native_priority(prio));
+    }
+}
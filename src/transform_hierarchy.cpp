@@ -0,0 +1,195 @@
+#include "game/transform_hierarchy.h"
+#include "optimized/optimized_renderer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace fox
+{
+    void transform_hierarchy::register_components(fecs::world& world)
+    {
+        world.register_component<local_transform>();
+        world.register_component<transform_parent>();
+        world.register_component<transform_group>();
+    }
+
+    void transform_hierarchy::set_local(fecs::world& world, fecs::entity e, const matrix& local)
+    {
+        if (local_transform* node = world.try_get_component<local_transform>(e))
+            node->local = local;
+        mark_dirty(e);
+    }
+
+    void transform_hierarchy::mark_dirty(fecs::entity e)
+    {
+        marked_.push_back(e);
+    }
+
+    std::uint32_t transform_hierarchy::slot_of(fecs::entity e) const noexcept
+    {
+        const std::size_t index = e.index();
+        if (index >= slot_by_index_.size())
+            return NO_PARENT;
+        const std::uint32_t slot = slot_by_index_[index];
+        return (slot != NO_PARENT && entity_[slot].value == e.value) ? slot : NO_PARENT;
+    }
+
+    void transform_hierarchy::rebuild(fecs::world& world)
+    {
+        struct node
+        {
+            fecs::entity e{};
+            fecs::entity parent{};
+            matrix local{};
+            bool group = false;
+        };
+
+        std::vector<node> nodes;
+        std::vector<std::uint32_t> at; // entity index -> nodes
+        world.query<const local_transform>().each_entity([&](fecs::entity e, const local_transform& l)
+        {
+            if (e.index() >= at.size())
+                at.resize(e.index() + 1u, NO_PARENT);
+            at[e.index()] = static_cast<std::uint32_t>(nodes.size());
+            nodes.push_back({ e, {}, l.local, false });
+        });
+        world.query<const local_transform, const transform_parent>().each_entity(
+            [&](fecs::entity e, const local_transform&, const transform_parent& p) { nodes[at[e.index()]].parent = p.parent; });
+        world.query<const local_transform, const transform_group>().each_entity(
+            [&](fecs::entity e, const local_transform&, const transform_group&) { nodes[at[e.index()]].group = true; });
+
+        const std::uint32_t n = static_cast<std::uint32_t>(nodes.size());
+        const auto node_of = [&](fecs::entity e) -> std::uint32_t
+        {
+            if (!e.valid() || e.index() >= at.size())
+                return NO_PARENT;
+            const std::uint32_t i = at[e.index()];
+            return (i != NO_PARENT && nodes[i].e.value == e.value) ? i : NO_PARENT;
+        };
+
+        std::vector<std::uint32_t> parent_at(n, NO_PARENT);
+        std::vector<std::uint32_t> children(n, 0u);
+        for (std::uint32_t i = 0; i < n; ++i)
+        {
+            parent_at[i] = node_of(nodes[i].parent);
+            if (parent_at[i] != NO_PARENT)
+                ++children[parent_at[i]];
+        }
+
+        // Walk up to the first node with a known depth; a cycle is cut where it closes
+        constexpr std::uint32_t unset = NO_PARENT;
+        constexpr std::uint32_t visiting = NO_PARENT - 1u;
+        std::vector<std::uint32_t> depth(n, unset);
+        std::vector<std::uint32_t> path;
+        for (std::uint32_t i = 0; i < n; ++i)
+        {
+            path.clear();
+            std::uint32_t j = i;
+            while (j != NO_PARENT && depth[j] == unset)
+            {
+                depth[j] = visiting;
+                path.push_back(j);
+                j = parent_at[j];
+            }
+
+            std::uint32_t d = 0;
+            if (j != NO_PARENT && depth[j] == visiting)
+                parent_at[path.back()] = NO_PARENT;
+            else if (j != NO_PARENT)
+                d = depth[j] + 1u;
+
+            for (std::size_t k = path.size(); k-- > 0;)
+                depth[path[k]] = d++;
+        }
+
+        std::vector<std::uint32_t> order(n);
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) { return depth[a] < depth[b]; });
+
+        // Groups with nothing left under them go; everything else keeps its world and dirty state
+        std::vector<fecs::entity> empty_groups;
+        std::vector<fecs::entity>  entity;
+        std::vector<std::uint32_t> parent;
+        std::vector<matrix>        local;
+        std::vector<matrix>        world_mtx;
+        std::vector<std::uint8_t>  dirty;
+        std::vector<std::uint32_t> slot_by_node(n, NO_PARENT);
+        entity.reserve(n);
+        parent.reserve(n);
+        local.reserve(n);
+        world_mtx.reserve(n);
+        dirty.reserve(n);
+
+        for (const std::uint32_t i : order)
+        {
+            const node& nd = nodes[i];
+            if (nd.group && children[i] == 0 && parent_at[i] == NO_PARENT)
+            {
+                empty_groups.push_back(nd.e);
+                continue;
+            }
+
+            const std::uint32_t p = (parent_at[i] != NO_PARENT) ? slot_by_node[parent_at[i]] : NO_PARENT;
+            const std::uint32_t prev = slot_of(nd.e);
+            const fecs::entity prev_parent = (prev != NO_PARENT && parent_[prev] != NO_PARENT) ? entity_[parent_[prev]] : fecs::entity{};
+            const fecs::entity new_parent = (p != NO_PARENT) ? entity[p] : fecs::entity{};
+
+            slot_by_node[i] = static_cast<std::uint32_t>(entity.size());
+            entity.push_back(nd.e);
+            parent.push_back(p);
+            local.push_back(nd.local);
+            world_mtx.push_back(prev != NO_PARENT ? world_[prev] : nd.local);
+            dirty.push_back((prev == NO_PARENT || prev_parent.value != new_parent.value) ? 1u : 0u);
+        }
+
+        entity_ = std::move(entity);
+        parent_ = std::move(parent);
+        local_ = std::move(local);
+        world_ = std::move(world_mtx);
+        dirty_ = std::move(dirty);
+
+        slot_by_index_.assign(at.size(), NO_PARENT);
+        for (std::uint32_t s = 0; s < entity_.size(); ++s)
+            slot_by_index_[entity_[s].index()] = s;
+
+        world.destroy_entities(empty_groups);
+        seen_version_ = world.version();
+    }
+
+    void transform_hierarchy::update(fecs::world& world)
+    {
+        if (world.version() != seen_version_)
+            rebuild(world);
+
+        for (const fecs::entity e : marked_)
+        {
+            const std::uint32_t s = slot_of(e);
+            if (s == NO_PARENT)
+                continue;
+            if (const local_transform* node = std::as_const(world).try_get_component<local_transform>(e))
+                local_[s] = node->local;
+            dirty_[s] = 1u;
+        }
+        marked_.clear();
+
+        changed_.clear();
+        if (std::find(dirty_.begin(), dirty_.end(), std::uint8_t{ 1u }) == dirty_.end())
+            return;
+
+        for (std::uint32_t i = 0; i < entity_.size(); ++i)
+        {
+            const std::uint32_t p = parent_[i];
+            if (p != NO_PARENT && dirty_[p])
+                dirty_[i] = 1u;
+            if (!dirty_[i])
+                continue;
+
+            world_[i] = (p != NO_PARENT) ? world_[p] * local_[i] : local_[i];
+            if (Transform* tr = world.try_get_component<Transform>(entity_[i]))
+                tr->world = world_[i];
+            changed_.push_back(entity_[i]);
+        }
+        std::fill(dirty_.begin(), dirty_.end(), std::uint8_t{ 0u });
+    }
+}
@@ -0,0 +1,462 @@
+#include "game/world_streamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <utility>
+
+namespace fox
+{
+    namespace
+    {
+        constexpr float kMinCellSize = 1.f;
+
+        [[nodiscard]] std::uint64_t pack_cell(const std::int32_t ix, const std::int32_t iz) noexcept
+        {
+            return ((std::uint64_t)(std::uint32_t)ix << 32) | (std::uint32_t)iz;
+        }
+    }
+
+    world_streamer::world_streamer(fecs::world& world, render_queue& queue)
+        : world_(world)
+        , queue_(queue)
+    {
+        begin_grid();
+    }
+
+    void world_streamer::set_settings(const world_streaming_settings& settings)
+    {
+        const bool was_enabled = settings_.enabled;
+        if (settings.mesh_budget_bytes != settings_.mesh_budget_bytes || settings.load_radius != settings_.load_radius)
+            budget_radius_ = (std::numeric_limits<float>::max)();
+        settings_ = settings;
+        begin_grid();
+
+        if (settings_.enabled && !was_enabled)
+            adopt_live_objects();
+    }
+
+    void world_streamer::clear()
+    {
+        cells_.clear();
+        budget_radius_ = (std::numeric_limits<float>::max)();
+        cell_loads_ = 0;
+        cell_unloads_ = 0;
+        budget_unloads_ = 0;
+        released_bytes_ = 0;
+        begin_grid();
+    }
+
+    void world_streamer::begin_grid() noexcept
+    {
+        if (cells_.empty())
+            grid_size_ = (std::max)(settings_.cell_size, kMinCellSize);
+    }
+
+    world_streamer::cell_key world_streamer::key_of(const vec4& position) const noexcept
+    {
+        const std::int32_t ix = (std::int32_t)std::floor(position.x / grid_size_);
+        const std::int32_t iz = (std::int32_t)std::floor(position.z / grid_size_);
+        return pack_cell(ix, iz);
+    }
+
+    float world_streamer::distance_to(const cell& c, const vec4& eye) const noexcept
+    {
+        const float x0 = (float)c.ix * grid_size_;
+        const float z0 = (float)c.iz * grid_size_;
+        const float dx = (std::max)({ x0 - eye.x, 0.f, eye.x - (x0 + grid_size_) });
+        const float dz = (std::max)({ z0 - eye.z, 0.f, eye.z - (z0 + grid_size_) });
+        return std::sqrt(dx * dx + dz * dz);
+    }
+
+    world_streamer::cell& world_streamer::cell_at(const cell_key key)
+    {
+        auto [it, inserted] = cells_.try_emplace(key);
+        if (inserted)
+        {
+            it->second.ix = (std::int32_t)(std::uint32_t)(key >> 32);
+            it->second.iz = (std::int32_t)(std::uint32_t)key;
+        }
+        return it->second;
+    }
+
+    render_queue::object_id world_streamer::add(const render_queue::static_mesh_desc& desc)
+    {
+        streamed_object object{};
+        object.static_desc = desc;
+        return add(std::move(object));
+    }
+
+    render_queue::object_id world_streamer::add(const render_queue::dynamic_mesh_desc& desc)
+    {
+        streamed_object object{};
+        object.is_dynamic = true;
+        object.dynamic_desc = desc;
+        return add(std::move(object));
+    }
+
+    render_queue::object_id world_streamer::add(streamed_object&& object)
+    {
+        begin_grid();
+
+        // Ids have to hold across unloads, so an object without one takes it here rather than at spawn
+        render_queue::object_id& forced = object.is_dynamic ? object.dynamic_desc.forced_id : object.static_desc.forced_id;
+        if (forced == 0)
+            forced = queue_.next_object_id();
+        if (forced >= queue_.next_object_id())
+            queue_.set_next_object_id(forced + 1);
+        object.id = forced;
+
+        cell& c = cell_at(key_of(object.position()));
+        if (c.loaded)
+            spawn({ object });
+        c.objects.push_back(std::move(object));
+        return forced;
+    }
+
+    void world_streamer::spawn(const std::vector<streamed_object>& objects)
+    {
+        // As scene_io spawns them: dynamic ones one by one with their tags in one flush, static ones
+        // through the queue's bulk path
+        fecs::command_buffer tags(world_);
+        std::vector<render_queue::static_mesh_desc> static_descs;
+        static_descs.reserve(objects.size());
+        for (const streamed_object& object : objects)
+        {
+            if (!object.is_dynamic)
+            {
+                static_descs.push_back(object.static_desc);
+                continue;
+            }
+
+            const render_queue::object_id spawned = queue_.add_dynamic_mesh(object.dynamic_desc);
+            if (spawned == 0)
+                continue;
+            for (const auto e : queue_.entities(spawned))
+                tags.add_component<editor_tag>(e);
+        }
+        world_.flush(tags);
+
+        std::vector<render_queue::object_id> spawned;
+        queue_.add_static_meshes(static_descs, true, spawned);
+    }
+
+    void world_streamer::load_cell(cell& c)
+    {
+        spawn(c.objects);
+        c.loaded = true;
+        ++cell_loads_;
+    }
+
+    void world_streamer::snapshot(std::unordered_map<render_queue::object_id, streamed_object*>& wanted) const
+    {
+        std::unordered_set<render_queue::object_id> found;
+        found.reserve(wanted.size());
+
+        world_.query<const editor_object_component>().each_entity([&](fecs::entity, const editor_object_component& obj)
+        {
+            const auto it = wanted.find(obj.object_id);
+            if (it == wanted.end() || !found.insert(obj.object_id).second)
+                return;
+
+            streamed_object& object = *it->second;
+            const auto apply = [&](auto& desc)
+            {
+                desc.name = obj.name;
+                desc.position = obj.position;
+                desc.rotation = obj.rotation;
+                desc.scale = obj.scale;
+            };
+            if (!object.is_dynamic)
+            {
+                apply(object.static_desc);
+                return;
+            }
+            apply(object.dynamic_desc);
+            object.dynamic_desc.anim_enabled = obj.anim_enabled;
+            object.dynamic_desc.anim_paused = obj.anim_paused;
+            object.dynamic_desc.anim_index = obj.anim_index;
+            object.dynamic_desc.playback_speed = obj.playback_speed;
+            object.dynamic_desc.time_offset = obj.time_offset;
+            object.dynamic_desc.anim_time = obj.anim_time;
+        });
+
+        // Deleted in the editor since it spawned
+        for (auto it = wanted.begin(); it != wanted.end();)
+            it = found.count(it->first) ? std::next(it) : wanted.erase(it);
+
+        world_.query<const editor_object_component, const static_mesh_component>().each_entity(
+            [&](fecs::entity, const editor_object_component& obj, const static_mesh_component& mesh)
+        {
+            const auto it = wanted.find(obj.object_id);
+            if (it != wanted.end())
+                it->second->static_desc.visible = mesh.visible;
+        });
+
+        world_.query<const editor_object_component, const dynamic_mesh_component>().each_entity(
+            [&](fecs::entity, const editor_object_component& obj, const dynamic_mesh_component& mesh)
+        {
+            const auto it = wanted.find(obj.object_id);
+            if (it == wanted.end())
+                return;
+            render_queue::dynamic_mesh_desc& desc = it->second->dynamic_desc;
+            desc.visible = mesh.visible;
+            desc.anim_enabled = mesh.anim.enabled;
+            desc.anim_paused = mesh.anim.paused;
+            desc.anim_index = mesh.anim.index;
+            desc.playback_speed = mesh.anim.playback_speed;
+            desc.time_offset = mesh.anim.time_offset;
+            desc.anim_time = mesh.anim.anim_time;
+        });
+
+        world_.query<const editor_object_component, const Material>().each_entity(
+            [&](fecs::entity, const editor_object_component& obj, const Material& mat)
+        {
+            const auto it = wanted.find(obj.object_id);
+            if (it == wanted.end())
+                return;
+            if (it->second->is_dynamic) it->second->dynamic_desc.cull = mat.cull;
+            else                        it->second->static_desc.cull = mat.cull;
+        });
+    }
+
+    void world_streamer::unload_cells(const std::vector<cell*>& cells)
+    {
+        std::unordered_map<render_queue::object_id, streamed_object*> wanted;
+        for (cell* c : cells)
+            for (streamed_object& object : c->objects)
+                wanted.emplace(object.id, &object);
+        snapshot(wanted);
+
+        const std::unordered_set<const cell*> leaving(cells.begin(), cells.end());
+        std::unordered_set<render_queue::object_id> doomed_ids;
+        std::vector<streamed_object> moved_live;
+        std::vector<streamed_object> moved_out;
+
+        for (cell* c : cells)
+        {
+            const cell_key own = pack_cell(c->ix, c->iz);
+            std::vector<streamed_object> kept;
+            kept.reserve(c->objects.size());
+            for (streamed_object& object : c->objects)
+            {
+                if (!wanted.count(object.id))
+                    continue;
+
+                const cell_key key = key_of(object.position());
+                if (key == own)
+                {
+                    doomed_ids.insert(object.id);
+                    kept.push_back(std::move(object));
+                    continue;
+                }
+
+                // Dragged into a cell that stays, it stays spawned and changes hands
+                const auto target = cells_.find(key);
+                if (target != cells_.end() && target->second.loaded && !leaving.count(&target->second))
+                {
+                    moved_live.push_back(std::move(object));
+                    continue;
+                }
+                doomed_ids.insert(object.id);
+                moved_out.push_back(std::move(object));
+            }
+            c->objects = std::move(kept);
+            c->loaded = false;
+            ++cell_unloads_;
+        }
+
+        for (streamed_object& object : moved_live)
+            cell_at(key_of(object.position())).objects.push_back(std::move(object));
+        for (streamed_object& object : moved_out)
+            cell_at(key_of(object.position())).objects.push_back(std::move(object));
+
+        const std::vector<render_queue::object_id> doomed(doomed_ids.begin(), doomed_ids.end());
+        queue_.remove(doomed);
+
+        for (auto it = cells_.begin(); it != cells_.end();)
+            it = (!it->second.loaded && it->second.objects.empty()) ? cells_.erase(it) : std::next(it);
+    }
+
+    void world_streamer::release_meshes()
+    {
+        if (release_fence_)
+            release_fence_();
+        released_bytes_ += queue_.release_unused_meshes();
+    }
+
+    void world_streamer::adopt_live_objects()
+    {
+        begin_grid();
+
+        std::unordered_set<render_queue::object_id> known;
+        for (const auto& [key, c] : cells_)
+            for (const streamed_object& object : c.objects)
+                known.insert(object.id);
+
+        // Scene objects only; anything spawned without editor_tag is not the level's to stream
+        std::unordered_map<render_queue::object_id, streamed_object> found;
+        world_.query<const editor_object_component, const editor_tag>().each_entity(
+            [&](fecs::entity, const editor_object_component& obj, const editor_tag&)
+        {
+            if (obj.object_id == 0 || known.count(obj.object_id))
+                return;
+            auto [it, inserted] = found.try_emplace(obj.object_id);
+            if (!inserted)
+                return;
+
+            streamed_object& object = it->second;
+            object.id = obj.object_id;
+            object.is_dynamic = obj.is_dynamic;
+            object.static_desc.path = obj.model;
+            object.static_desc.forced_id = obj.object_id;
+            object.dynamic_desc.path = obj.model;
+            object.dynamic_desc.forced_id = obj.object_id;
+        });
+        if (found.empty())
+            return;
+
+        std::unordered_map<render_queue::object_id, streamed_object*> wanted;
+        for (auto& [id, object] : found)
+            wanted.emplace(id, &object);
+        snapshot(wanted);
+
+        for (auto& [id, object] : found)
+        {
+            cell& c = cell_at(key_of(object.position()));
+            // The rest of a cell left unloaded while streaming was off comes back with it
+            if (!c.loaded)
+            {
+                if (!c.objects.empty())
+                    load_cell(c);
+                c.loaded = true;
+            }
+            c.objects.push_back(std::move(object));
+        }
+    }
+
+    void world_streamer::update(const vec4& eye)
+    {
+        if (cells_.empty())
+            return;
+
+        const std::uint32_t max_loads = (std::max)(settings_.max_cell_loads, 1u);
+        std::vector<std::pair<float, cell*>> candidates;
+
+        // Streaming off: everything still out comes back, a few cells a frame
+        if (!settings_.enabled)
+        {
+            for (auto& [key, c] : cells_)
+                if (!c.loaded)
+                    candidates.emplace_back(0.f, &c);
+            for (std::size_t i = 0; i < candidates.size() && i < max_loads; ++i)
+                load_cell(*candidates[i].second);
+            return;
+        }
+
+        const cell_key eye_cell = key_of(eye);
+        if (eye_cell != budget_eye_cell_)
+        {
+            budget_eye_cell_ = eye_cell;
+            budget_radius_ = (std::numeric_limits<float>::max)();
+        }
+
+        const float unload_radius = (std::max)(settings_.unload_radius, settings_.load_radius);
+        std::vector<cell*> far;
+        for (auto& [key, c] : cells_)
+        {
+            const float d = distance_to(c, eye);
+            if (c.loaded && d > unload_radius)
+                far.push_back(&c);
+            else if (!c.loaded && d <= settings_.load_radius && d < budget_radius_)
+                candidates.emplace_back(d, &c);
+        }
+
+        bool released = false;
+        if (!far.empty())
+        {
+            unload_cells(far);
+            release_meshes();
+            released = true;
+        }
+
+        // Over the budget the farthest cells go, never the one the eye is in, and nothing loads
+        // until the bytes freed bring it back under
+        if (settings_.mesh_budget_bytes > 0)
+        {
+            std::size_t bytes = queue_.mesh_bytes();
+            if (bytes > settings_.mesh_budget_bytes)
+            {
+                std::vector<std::pair<float, cell*>> loaded;
+                for (auto& [key, c] : cells_)
+                    if (c.loaded && key != eye_cell)
+                        loaded.emplace_back(distance_to(c, eye), &c);
+                std::sort(loaded.begin(), loaded.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+                for (const auto& [d, c] : loaded)
+                {
+                    if (bytes <= settings_.mesh_budget_bytes)
+                        break;
+                    unload_cells({ c });
+                    release_meshes();
+                    bytes = queue_.mesh_bytes();
+                    budget_radius_ = (std::min)(budget_radius_, d);
+                    ++budget_unloads_;
+                }
+                candidates.clear();
+                released = true;
+            }
+        }
+
+        // unload_cells may have erased emptied cells the candidates point at
+        if (released)
+        {
+            candidates.clear();
+            for (auto& [key, c] : cells_)
+            {
+                const float d = distance_to(c, eye);
+                if (!c.loaded && d <= settings_.load_radius && d < budget_radius_)
+                    candidates.emplace_back(d, &c);
+            }
+            if (settings_.mesh_budget_bytes > 0 && queue_.mesh_bytes() > settings_.mesh_budget_bytes)
+                candidates.clear();
+        }
+
+        const std::size_t count = (std::min)(candidates.size(), (std::size_t)max_loads);
+        std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                          [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (std::size_t i = 0; i < count; ++i)
+            load_cell(*candidates[i].second);
+    }
+
+    void world_streamer::collect_unloaded(std::vector<render_queue::static_mesh_desc>& static_out,
+                                          std::vector<render_queue::dynamic_mesh_desc>& dynamic_out) const
+    {
+        for (const auto& [key, c] : cells_)
+        {
+            if (c.loaded)
+                continue;
+            for (const streamed_object& object : c.objects)
+            {
+                if (object.is_dynamic) dynamic_out.push_back(object.dynamic_desc);
+                else                   static_out.push_back(object.static_desc);
+            }
+        }
+    }
+
+    world_streaming_stats world_streamer::stats() const noexcept
+    {
+        world_streaming_stats s{};
+        s.cells = (std::uint32_t)cells_.size();
+        for (const auto& [key, c] : cells_)
+        {
+            s.loaded_cells += c.loaded ? 1u : 0u;
+            (c.loaded ? s.resident_objects : s.streamed_out_objects) += c.objects.size();
+        }
+        s.cell_loads = cell_loads_;
+        s.cell_unloads = cell_unloads_;
+        s.budget_unloads = budget_unloads_;
+        s.released_bytes = released_bytes_;
+        return s;
+    }
+}